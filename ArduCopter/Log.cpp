@@ -218,6 +218,7 @@ void Copter::Log_Write_Performance()
         hal.util->available_memory()
     };
     DataFlash.WriteCriticalBlock(&pkt, sizeof(pkt));
+    DataFlash.Log_Write_Bus_Threads();
 }
 
 // Write an attitude packet
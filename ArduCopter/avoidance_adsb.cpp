@@ -20,6 +20,7 @@ MAV_COLLISION_ACTION AP_Avoidance_Copter::handle_avoidance(const AP_Avoidance::O
         failsafe_state_change = true;
         // record flight mode in case it's required for the recovery
         prev_control_mode = copter.control_mode;
+        record_planned_velocity();
     }
 
     // take no action in some flight modes
@@ -186,6 +187,25 @@ bool AP_Avoidance_Copter::handle_avoidance_vertical(const AP_Avoidance::Obstacle
     return true;
 }
 
+// record the velocity we would be flying at without avoidance, heading
+// for the current waypoint at waypoint speed if flying a mission,
+// otherwise carrying on as we are
+void AP_Avoidance_Copter::record_planned_velocity()
+{
+    planned_vel_ned.zero();
+    if (prev_control_mode == AUTO) {
+        const Vector3f to_dest = copter.wp_nav->get_wp_destination() - copter.inertial_nav.get_position();
+        const Vector2f to_dest_xy(to_dest.x, to_dest.y);
+        if (!to_dest_xy.is_zero()) {
+            const Vector2f vel_xy = to_dest_xy.normalized() * (copter.wp_nav->get_speed_xy() * 0.01f);
+            planned_vel_ned.x = vel_xy.x;
+            planned_vel_ned.y = vel_xy.y;
+        }
+    } else if (!_ahrs.get_velocity_NED(planned_vel_ned)) {
+        planned_vel_ned.zero();
+    }
+}
+
 bool AP_Avoidance_Copter::handle_avoidance_horizontal(const AP_Avoidance::Obstacle *obstacle, bool allow_mode_change)
 {
     // ensure copter is in avoid_adsb mode
@@ -193,8 +213,19 @@ bool AP_Avoidance_Copter::handle_avoidance_horizontal(const AP_Avoidance::Obstac
         return false;
     }
 
-    // get best vector away from obstacle
+    // try for a heading change that keeps clear of all obstacles
     Vector3f velocity_neu;
+    if (resolve_enabled()) {
+        const Vector3f planned_vel_xy(planned_vel_ned.x, planned_vel_ned.y, 0.0f);
+        Vector3f velocity_ned;
+        if (get_resolution_velocity(planned_vel_xy, copter.wp_nav->get_speed_xy() * 0.01f, 0.0f, 0.0f, velocity_ned)) {
+            velocity_neu = Vector3f(velocity_ned.x * 100.0f, velocity_ned.y * 100.0f, 0.0f);
+            copter.avoid_adsb_set_velocity(velocity_neu);
+            return true;
+        }
+    }
+
+    // get best vector away from obstacle
     if (get_vector_perpendicular(obstacle, velocity_neu)) {
         // remove vertical component
         velocity_neu.z = 0.0f;
@@ -223,8 +254,23 @@ bool AP_Avoidance_Copter::handle_avoidance_perpendicular(const AP_Avoidance::Obs
         return false;
     }
 
-    // get best vector away from obstacle
+    // try for a heading and altitude change that keeps clear of all obstacles
     Vector3f velocity_neu;
+    if (resolve_enabled()) {
+        // do not descend if below RTL alt
+        float speed_down = copter.wp_nav->get_speed_down() * 0.01f;
+        if (copter.current_loc.alt < copter.g.rtl_altitude) {
+            speed_down = 0.0f;
+        }
+        Vector3f velocity_ned;
+        if (get_resolution_velocity(planned_vel_ned, copter.wp_nav->get_speed_xy() * 0.01f, copter.wp_nav->get_speed_up() * 0.01f, speed_down, velocity_ned)) {
+            velocity_neu = Vector3f(velocity_ned.x * 100.0f, velocity_ned.y * 100.0f, -velocity_ned.z * 100.0f);
+            copter.avoid_adsb_set_velocity(velocity_neu);
+            return true;
+        }
+    }
+
+    // get best vector away from obstacle
     if (get_vector_perpendicular(obstacle, velocity_neu)) {
         // convert horizontal components to velocities
         velocity_neu.x *= copter.wp_nav->get_speed_xy();
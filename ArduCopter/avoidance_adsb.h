@@ -46,6 +46,12 @@ protected:
     // perpendicular (3 dimensional) avoidance handler
     bool handle_avoidance_perpendicular(const AP_Avoidance::Obstacle *obstacle, bool allow_mode_change);
 
+    // record the velocity we would be flying at without avoidance
+    void record_planned_velocity();
+
     // control mode before avoidance began
     control_mode_t prev_control_mode = RTL;
+
+    // velocity (NED m/s) we would be flying at without avoidance
+    Vector3f planned_vel_ned;
 };
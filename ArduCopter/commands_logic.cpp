@@ -350,6 +350,21 @@ void Copter::do_nav_wp(const AP_Mission::Mission_Command& cmd)
     // if no delay set the waypoint as "fast"
     if (loiter_time_max == 0 ) {
         wp_nav->set_fast_waypoint(true);
+
+        // pass on the following waypoint so the vehicle can turn the corner without stopping
+        AP_Mission::Mission_Command next_cmd;
+        if (mission.get_next_nav_cmd(cmd.index+1, next_cmd) && next_cmd.id == MAV_CMD_NAV_WAYPOINT) {
+            Location_Class next_loc(next_cmd.content.location);
+            // default lat, lon and alt to this waypoint's
+            if (next_loc.lat == 0 && next_loc.lng == 0) {
+                next_loc.lat = target_loc.lat;
+                next_loc.lng = target_loc.lng;
+            }
+            if (next_loc.alt == 0) {
+                next_loc.set_alt_cm(target_loc.alt, target_loc.get_alt_frame());
+            }
+            wp_nav->set_wp_destination_next(next_loc);
+        }
     }
 }
 
@@ -291,6 +291,9 @@ void Copter::init_proximity(void)
 void Copter::update_proximity(void)
 {
 #if PROXIMITY_ENABLED == ENABLED
+    // scanning sensors compensate their points for our movement
+    const Vector3f &vel = inertial_nav.get_velocity();
+    g2.proximity.update_motion(ahrs.yaw, Vector2f(vel.x * 0.01f, vel.y * 0.01f));
     g2.proximity.update();
 #endif
 }
@@ -30,6 +30,9 @@ bool Sub::init_arm_motors(bool arming_from_gcs)
     // let dataflash know that we're armed (it may open logs e.g.)
     DataFlash_Class::instance()->set_vehicle_armed(true);
 
+    // don't leave parameter or mission writes pending in flight
+    StorageManager::flush();
+
     // disable cpu failsafe because initialising everything takes a while
     mainloop_failsafe_disable();
 
@@ -100,6 +100,97 @@ class logheader(ctypes.LittleEndianStructure):
         return "<logheader head1=0x{self.head1:x} head2=0x{self.head2:x} msgid=0x{self.msgid:x} ({self.msgid})>".format(self=self)
 
 
+class compressedheader(ctypes.LittleEndianStructure):
+    '''header of a block in a compressed log (see libraries/DataFlash/DataFlash_Compress.h)'''
+    _fields_ = [ \
+        ('magic1', ctypes.c_uint8),
+        ('magic2', ctypes.c_uint8),
+        ('raw_length', ctypes.c_uint16),
+        ('compressed_length', ctypes.c_uint16),
+        ('checksum', ctypes.c_uint16),
+    ]
+    _pack_ = 1
+
+COMPRESSED_HEAD = '\xa3\x5a'
+
+def fletcher16(data):
+    sum1 = 0xff
+    sum2 = 0xff
+    for b in data:
+        sum1 = (sum1 + b) % 255
+        sum2 = (sum2 + sum1) % 255
+    return (sum2 << 8) | sum1
+
+def lz4_block_decompress(src, raw_length):
+    '''decode an LZ4 block'''
+    dst = bytearray()
+    i = 0
+    while i < len(src):
+        token = src[i]
+        i += 1
+        litlen = token >> 4
+        if litlen == 15:
+            while True:
+                litlen += src[i]
+                i += 1
+                if src[i-1] != 255:
+                    break
+        dst += src[i:i+litlen]
+        i += litlen
+        if i >= len(src):
+            break
+        offset = src[i] | (src[i+1] << 8)
+        i += 2
+        mlen = token & 0xf
+        if mlen == 15:
+            while True:
+                mlen += src[i]
+                i += 1
+                if src[i-1] != 255:
+                    break
+        mlen += 4
+        start = len(dst) - offset
+        if offset >= mlen:
+            dst += dst[start:start+mlen]
+        else:
+            for k in range(mlen):
+                dst.append(dst[start+k])
+    if len(dst) != raw_length:
+        raise ValueError("bad compressed block")
+    return dst
+
+def decompress_log(data):
+    '''convert a compressed log to a plain one, skipping truncated or corrupt
+    blocks. Returns the data and whether any blocks were skipped; messages
+    split across the edges of a skipped block are lost with it'''
+    out = bytearray()
+    offset = 0
+    hsize = ctypes.sizeof(compressedheader)
+    damaged = False
+    while len(data) >= offset + hsize:
+        h = compressedheader.from_buffer(data, offset)
+        payload = data[offset+hsize:offset+hsize+h.compressed_length]
+        if (h.magic1 != 0xa3 or h.magic2 != 0x5a or
+            h.compressed_length > h.raw_length or
+            len(payload) != h.compressed_length or
+            fletcher16(payload) != h.checksum):
+            # look for the next block header one byte on
+            next_block = data.find(bytearray(COMPRESSED_HEAD), offset+1)
+            if next_block == -1:
+                next_block = len(data)
+            print("Compressed log truncated or corrupt, skipped %u bytes at offset %u" %
+                  (next_block - offset, offset), file=sys.stderr)
+            damaged = True
+            offset = next_block
+            continue
+        offset += hsize + h.compressed_length
+        if h.compressed_length == h.raw_length:
+            out += payload
+        else:
+            out += lz4_block_decompress(payload, h.raw_length)
+    return out, damaged
+
+
 class BinaryFormat(ctypes.LittleEndianStructure):
     NAME = 'FMT'
     MSG = 128
@@ -498,7 +589,7 @@ class DataflashLog(object):
         else:
             raise ValueError("Unknown log format for {}: {}".format(self.filename, format))
 
-        if head == '\xa3\x95\x80\x80':
+        if head == '\xa3\x95\x80\x80' or head[:2] == COMPRESSED_HEAD:
             numBytes, lineNumber = self.read_binary(f, ignoreBadlines)
             pass
         else:
@@ -701,6 +792,12 @@ class DataflashLog(object):
     def _read_binary(self, f, ignoreBadlines):
         self._formats = {128:BinaryFormat}
         data = bytearray(f.read())
+        damaged = False
+        if data[:2] == bytearray(COMPRESSED_HEAD):
+            data, damaged = decompress_log(data)
+            if damaged:
+                # resync on message headers after the skipped blocks
+                ignoreBadlines = True
         offset = 0
         while len(data) > offset + ctypes.sizeof(logheader):
             h = logheader.from_buffer(data, offset)
@@ -724,6 +821,9 @@ class DataflashLog(object):
                     print("data:{} offset:{} size:{} sizeof:{} sum:{}".format(len(data),offset,typ.SIZE,ctypes.sizeof(typ),offset+typ.SIZE))
                     raise
                 offset += typ.SIZE
+            elif damaged:
+                offset += 1
+                continue
             else:
                 raise ValueError(str(h) + "unknown type")
             yield e
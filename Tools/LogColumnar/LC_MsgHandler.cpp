@@ -0,0 +1,163 @@
+#include "LC_MsgHandler.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+LC_MsgHandler::LC_MsgHandler(const struct log_Format &_f) :
+    MsgHandler(_f),
+    count(0),
+    num_columns(0),
+    time_offset(0),
+    time_type(0)
+{
+    for (uint8_t i=0; i<num_fields(); i++) {
+        if (streq(field_label(i), "TimeUS") && field_type(i) == 'Q') {
+            time_offset = field_offset(i);
+            time_type = 'Q';
+            break;
+        }
+        if (streq(field_label(i), "TimeMS") && field_type(i) == 'I') {
+            time_offset = field_offset(i);
+            time_type = 'I';
+            break;
+        }
+    }
+}
+
+LC_MsgHandler::~LC_MsgHandler()
+{
+    close_columns();
+}
+
+bool LC_MsgHandler::timestamp(const uint8_t *msg, uint64_t &time_us) const
+{
+    switch (time_type) {
+    case 'Q':
+        memcpy(&time_us, &msg[time_offset], sizeof(time_us));
+        return true;
+    case 'I': {
+        uint32_t time_ms;
+        memcpy(&time_ms, &msg[time_offset], sizeof(time_ms));
+        time_us = time_ms * 1000ULL;
+        return true;
+    }
+    }
+    return false;
+}
+
+bool LC_MsgHandler::open_columns(const char *dir, uint64_t _count)
+{
+    char name[5] {};
+    memcpy(name, f.name, 4);
+
+    char path[256];
+    snprintf(path, sizeof(path), "%s/%s.col", dir, name);
+    fd = ::open(path, O_WRONLY|O_CREAT|O_TRUNC|O_CLOEXEC, 0644);
+    if (fd == -1) {
+        perror(path);
+        return false;
+    }
+
+    num_columns = num_fields() + 1;
+
+    struct col_header hdr {};
+    memcpy(hdr.magic, LOGCOLUMNAR_MAGIC, sizeof(hdr.magic));
+    hdr.version = LOGCOLUMNAR_VERSION;
+    hdr.num_columns = num_columns;
+    hdr.fmt = f;
+    hdr.count = _count;
+
+    struct col_field fields[LOGREADER_MAX_FIELDS+1] {};
+    uint64_t ofs = sizeof(hdr) + num_columns * sizeof(struct col_field);
+    for (uint8_t i=0; i<num_columns; i++) {
+        struct column &c = columns[i];
+        if (i < num_fields()) {
+            strncpy(fields[i].label, field_label(i), sizeof(fields[i].label));
+            c.type = field_type(i);
+            c.length = field_length(i);
+            c.msg_offset = field_offset(i);
+        } else {
+            strncpy(fields[i].label, LOGCOLUMNAR_TIMESTAMP_LABEL, sizeof(fields[i].label));
+            c.type = 'Q';
+            c.length = sizeof(uint64_t);
+            c.msg_offset = 0;
+        }
+        ofs = (ofs + LOGCOLUMNAR_ALIGN - 1) & ~(uint64_t)(LOGCOLUMNAR_ALIGN - 1);
+        fields[i].type = c.type;
+        fields[i].length = c.length;
+        fields[i].offset = ofs;
+        c.file_offset = ofs;
+        c.buf_used = 0;
+        c.buf = new uint8_t[column_buf_size];
+        ofs += _count * c.length;
+    }
+
+    if (::write(fd, &hdr, sizeof(hdr)) != sizeof(hdr) ||
+        ::write(fd, fields, num_columns*sizeof(fields[0])) != (ssize_t)(num_columns*sizeof(fields[0]))) {
+        perror(path);
+        return false;
+    }
+
+    // size the file up front so columns can be filled in any order
+    if (::ftruncate(fd, ofs) != 0) {
+        perror(path);
+        return false;
+    }
+
+    return true;
+}
+
+bool LC_MsgHandler::flush_column(struct column &c)
+{
+    if (c.buf_used == 0) {
+        return true;
+    }
+    if (::pwrite(fd, c.buf, c.buf_used, c.file_offset) != (ssize_t)c.buf_used) {
+        perror("pwrite");
+        return false;
+    }
+    c.file_offset += c.buf_used;
+    c.buf_used = 0;
+    return true;
+}
+
+bool LC_MsgHandler::append(const uint8_t *msg, uint64_t time_us)
+{
+    if (fd == -1) {
+        return false;
+    }
+    for (uint8_t i=0; i<num_columns; i++) {
+        struct column &c = columns[i];
+        if (c.buf_used + c.length > column_buf_size && !flush_column(c)) {
+            return false;
+        }
+        if (i < num_fields()) {
+            memcpy(&c.buf[c.buf_used], &msg[c.msg_offset], c.length);
+        } else {
+            memcpy(&c.buf[c.buf_used], &time_us, sizeof(time_us));
+        }
+        c.buf_used += c.length;
+    }
+    return true;
+}
+
+bool LC_MsgHandler::close_columns(void)
+{
+    if (fd == -1) {
+        return true;
+    }
+    bool ret = true;
+    for (uint8_t i=0; i<num_columns; i++) {
+        if (!flush_column(columns[i])) {
+            ret = false;
+        }
+        delete[] columns[i].buf;
+        columns[i].buf = nullptr;
+    }
+    ::close(fd);
+    fd = -1;
+    return ret;
+}
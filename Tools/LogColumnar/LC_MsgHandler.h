@@ -0,0 +1,57 @@
+#pragma once
+
+#include <vector>
+
+#include <MsgHandler.h>
+
+#include "LogColumnar.h"
+
+/*
+  per-message-type state for LogColumnar: extracts timestamps and
+  scatters message fields into the columns of one .col file
+ */
+class LC_MsgHandler : public MsgHandler {
+public:
+    LC_MsgHandler(const struct log_Format &f);
+    ~LC_MsgHandler();
+
+    // fetch this message's own timestamp, if the format has one
+    bool timestamp(const uint8_t *msg, uint64_t &time_us) const;
+
+    // create DIR/NAME.col laid out for count messages
+    bool open_columns(const char *dir, uint64_t count);
+
+    // append one message; time_us is the timestamp index value
+    bool append(const uint8_t *msg, uint64_t time_us);
+
+    // flush buffered column data and close the file
+    bool close_columns(void);
+
+    // number of messages of this type seen so far
+    uint64_t count;
+
+    // seek index entries, one per LOGINDEX_STRIDE messages
+    std::vector<struct log_index_entry> index;
+
+private:
+    struct column {
+        uint8_t type;
+        uint8_t length;
+        uint8_t msg_offset;
+        uint64_t file_offset;
+        uint8_t *buf;
+        uint32_t buf_used;
+    };
+
+    static const uint32_t column_buf_size = 16384;
+
+    bool flush_column(struct column &c);
+
+    int fd = -1;
+    struct column columns[LOGREADER_MAX_FIELDS+1] {};
+    uint8_t num_columns;
+
+    // location of TimeUS or TimeMS in the message
+    uint8_t time_offset;
+    uint8_t time_type;
+};
@@ -0,0 +1,615 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  convert DataFlash logs to columnar files and answer time-range
+  queries using a sidecar seek index
+ */
+
+#include <AP_HAL/AP_HAL.h>
+#include <AP_HAL/utility/getopt_cpp.h>
+
+#include <DataFlashFileReader.h>
+
+#include "LC_MsgHandler.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+// from DataFlashFileReader.cpp
+extern uint64_t now();
+
+/*
+  first pass over the log: count messages, build the seek index
+ */
+class LC_IndexReader : public DataFlashFileReader {
+public:
+    bool handle_log_format_msg(const struct log_Format &f) override;
+    bool handle_msg(const struct log_Format &f, uint8_t *msg) override;
+
+    bool write_index(const char *path, uint64_t log_size);
+
+    LC_MsgHandler *handlers[LOGREADER_MAX_FORMATS] {};
+
+private:
+    uint64_t last_time_us = 0;
+};
+
+bool LC_IndexReader::handle_log_format_msg(const struct log_Format &f)
+{
+    if (handlers[f.type] == nullptr) {
+        handlers[f.type] = new LC_MsgHandler(f);
+    }
+    return true;
+}
+
+bool LC_IndexReader::handle_msg(const struct log_Format &f, uint8_t *msg)
+{
+    LC_MsgHandler *h = handlers[f.type];
+    if (h == nullptr) {
+        return true;
+    }
+    uint64_t time_us;
+    if (h->timestamp(msg, time_us)) {
+        last_time_us = time_us;
+    } else {
+        time_us = last_time_us;
+    }
+    if (h->count % LOGINDEX_STRIDE == 0) {
+        struct log_index_entry e { time_us, last_message_offset() };
+        h->index.push_back(e);
+    }
+    h->count++;
+    return true;
+}
+
+bool LC_IndexReader::write_index(const char *path, uint64_t log_size)
+{
+    FILE *f = fopen(path, "w");
+    if (f == nullptr) {
+        perror(path);
+        return false;
+    }
+
+    struct log_index_header hdr {};
+    memcpy(hdr.magic, LOGINDEX_MAGIC, sizeof(hdr.magic));
+    hdr.version = LOGINDEX_VERSION;
+    hdr.stride = LOGINDEX_STRIDE;
+    hdr.log_size = log_size;
+    for (uint16_t i=0; i<LOGREADER_MAX_FORMATS; i++) {
+        if (handlers[i] != nullptr) {
+            hdr.num_types++;
+        }
+    }
+    bool ok = fwrite(&hdr, sizeof(hdr), 1, f) == 1;
+
+    for (uint16_t i=0; i<LOGREADER_MAX_FORMATS && ok; i++) {
+        const LC_MsgHandler *h = handlers[i];
+        if (h == nullptr) {
+            continue;
+        }
+        struct log_index_type t {};
+        t.fmt = formats[i];
+        t.count = h->count;
+        t.num_entries = h->index.size();
+        ok = fwrite(&t, sizeof(t), 1, f) == 1;
+        if (ok && t.num_entries > 0) {
+            ok = fwrite(&h->index[0], sizeof(h->index[0]), t.num_entries, f) == t.num_entries;
+        }
+    }
+
+    if (fclose(f) != 0 || !ok) {
+        perror(path);
+        return false;
+    }
+    return true;
+}
+
+/*
+  second pass over the log: scatter fields into columns
+ */
+class LC_ColumnReader : public DataFlashFileReader {
+public:
+    LC_ColumnReader(LC_MsgHandler **_handlers) :
+        handlers(_handlers) { }
+
+    bool handle_log_format_msg(const struct log_Format &f) override { return true; }
+    bool handle_msg(const struct log_Format &f, uint8_t *msg) override;
+
+private:
+    LC_MsgHandler **handlers;
+    uint64_t last_time_us = 0;
+};
+
+bool LC_ColumnReader::handle_msg(const struct log_Format &f, uint8_t *msg)
+{
+    LC_MsgHandler *h = handlers[f.type];
+    if (h == nullptr) {
+        return true;
+    }
+    uint64_t time_us;
+    if (h->timestamp(msg, time_us)) {
+        last_time_us = time_us;
+    } else {
+        time_us = last_time_us;
+    }
+    return h->append(msg, time_us);
+}
+
+/*
+  print messages of one type within a time range as CSV
+ */
+class LC_QueryReader : public DataFlashFileReader {
+public:
+    LC_QueryReader(const char *_name, uint64_t _start_us, uint64_t _end_us) :
+        name(_name),
+        start_us(_start_us),
+        end_us(_end_us) { }
+
+    bool handle_log_format_msg(const struct log_Format &f) override;
+    bool handle_msg(const struct log_Format &f, uint8_t *msg) override;
+
+    // position the reader using a seek index; returns false if the
+    // index is unusable
+    bool load_index(const char *path, uint64_t log_size);
+
+    uint32_t rows = 0;
+
+private:
+    const char *name;
+    uint64_t start_us;
+    uint64_t end_us;
+    LC_MsgHandler *handler = nullptr;
+    uint64_t seek_offset = 0;
+
+    void print_header(void);
+    void print_row(const uint8_t *msg);
+    static void print_field(uint8_t type, const uint8_t *p, uint8_t length);
+};
+
+bool LC_QueryReader::handle_log_format_msg(const struct log_Format &f)
+{
+    if (handler == nullptr && strncmp(f.name, name, sizeof(f.name)) == 0) {
+        handler = new LC_MsgHandler(f);
+        print_header();
+    }
+    return true;
+}
+
+bool LC_QueryReader::handle_msg(const struct log_Format &f, uint8_t *msg)
+{
+    if (handler == nullptr || strncmp(f.name, name, sizeof(f.name)) != 0) {
+        return true;
+    }
+    uint64_t time_us;
+    if (!handler->timestamp(msg, time_us)) {
+        // no time information; range does not apply
+        print_row(msg);
+        return true;
+    }
+    if (time_us > end_us) {
+        // timestamps within a message type are monotonic, so we are done
+        return false;
+    }
+    if (time_us >= start_us) {
+        print_row(msg);
+    }
+    return true;
+}
+
+bool LC_QueryReader::load_index(const char *path, uint64_t log_size)
+{
+    FILE *f = fopen(path, "r");
+    if (f == nullptr) {
+        return false;
+    }
+    struct log_index_header hdr;
+    if (fread(&hdr, sizeof(hdr), 1, f) != 1 ||
+        memcmp(hdr.magic, LOGINDEX_MAGIC, sizeof(hdr.magic)) != 0 ||
+        hdr.version != LOGINDEX_VERSION ||
+        hdr.log_size != log_size) {
+        ::fprintf(stderr, "%s: stale or invalid index\n", path);
+        fclose(f);
+        return false;
+    }
+
+    bool found = false;
+    for (uint8_t i=0; i<hdr.num_types; i++) {
+        struct log_index_type t;
+        if (fread(&t, sizeof(t), 1, f) != 1) {
+            fclose(f);
+            return false;
+        }
+        formats[t.fmt.type] = t.fmt;
+        if (found || strncmp(t.fmt.name, name, sizeof(t.fmt.name)) != 0) {
+            fseek(f, t.num_entries * sizeof(struct log_index_entry), SEEK_CUR);
+            continue;
+        }
+        found = true;
+        handle_log_format_msg(t.fmt);
+
+        std::vector<struct log_index_entry> entries(t.num_entries);
+        if (t.num_entries > 0 &&
+            fread(&entries[0], sizeof(entries[0]), t.num_entries, f) != t.num_entries) {
+            fclose(f);
+            return false;
+        }
+
+        // binary search for the last entry at or before start_us
+        uint32_t lo = 0;
+        uint32_t hi = t.num_entries;
+        while (lo < hi) {
+            const uint32_t mid = lo + (hi - lo) / 2;
+            if (entries[mid].time_us <= start_us) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+        if (lo > 0) {
+            seek_offset = entries[lo-1].offset;
+        } else if (t.num_entries > 0) {
+            seek_offset = entries[0].offset;
+        }
+    }
+    fclose(f);
+
+    if (!found) {
+        ::fprintf(stderr, "No %s messages in log\n", name);
+        exit(1);
+    }
+
+    // all formats came from the index, skip straight to the data
+    done_format_msgs = true;
+    return seek(seek_offset);
+}
+
+void LC_QueryReader::print_header(void)
+{
+    char labels[256];
+    handler->string_for_labels(labels, sizeof(labels));
+    ::printf("%s\n", labels);
+}
+
+void LC_QueryReader::print_field(uint8_t type, const uint8_t *p, uint8_t length)
+{
+    switch (type) {
+    case 'b': {
+        int8_t v;
+        memcpy(&v, p, sizeof(v));
+        ::printf("%d", (int)v);
+        break;
+    }
+    case 'B':
+    case 'M':
+        ::printf("%u", (unsigned)p[0]);
+        break;
+    case 'h':
+    case 'c': {
+        int16_t v;
+        memcpy(&v, p, sizeof(v));
+        ::printf("%d", (int)v);
+        break;
+    }
+    case 'H':
+    case 'C': {
+        uint16_t v;
+        memcpy(&v, p, sizeof(v));
+        ::printf("%u", (unsigned)v);
+        break;
+    }
+    case 'i':
+    case 'e':
+    case 'L': {
+        int32_t v;
+        memcpy(&v, p, sizeof(v));
+        ::printf("%ld", (long)v);
+        break;
+    }
+    case 'I':
+    case 'E': {
+        uint32_t v;
+        memcpy(&v, p, sizeof(v));
+        ::printf("%lu", (unsigned long)v);
+        break;
+    }
+    case 'f': {
+        float v;
+        memcpy(&v, p, sizeof(v));
+        ::printf("%.9g", (double)v);
+        break;
+    }
+    case 'd': {
+        double v;
+        memcpy(&v, p, sizeof(v));
+        ::printf("%.17g", v);
+        break;
+    }
+    case 'q': {
+        int64_t v;
+        memcpy(&v, p, sizeof(v));
+        ::printf("%lld", (long long)v);
+        break;
+    }
+    case 'Q': {
+        uint64_t v;
+        memcpy(&v, p, sizeof(v));
+        ::printf("%llu", (unsigned long long)v);
+        break;
+    }
+    case 'n':
+    case 'N':
+    case 'Z':
+        ::printf("%.*s", (int)strnlen((const char *)p, length), (const char *)p);
+        break;
+    default:
+        ::printf("?");
+        break;
+    }
+}
+
+void LC_QueryReader::print_row(const uint8_t *msg)
+{
+    for (uint8_t i=0; i<handler->num_fields(); i++) {
+        if (i != 0) {
+            ::printf(",");
+        }
+        print_field(handler->field_type(i),
+                    &msg[handler->field_offset(i)],
+                    handler->field_length(i));
+    }
+    ::printf("\n");
+    rows++;
+}
+
+class LogColumnar : public AP_HAL::HAL::Callbacks {
+public:
+    // HAL::Callbacks implementation.
+    void setup() override;
+    void loop() override;
+
+private:
+    const char *filename = nullptr;
+    const char *outdir = nullptr;
+    const char *query_type = nullptr;
+    uint64_t query_start_us = 0;
+    uint64_t query_end_us = UINT64_MAX;
+    bool index_only = false;
+    bool query_scan = false;
+
+    void usage(void);
+    void _parse_command_line(uint8_t argc, char * const argv[]);
+    void convert(void);
+    void query(void);
+};
+
+void LogColumnar::usage(void)
+{
+    ::printf("Usage: LogColumnar [options] LOGFILE\n");
+    ::printf("Options:\n");
+    ::printf("\t--outdir DIR       write columnar output to DIR (default LOGFILE.cols)\n");
+    ::printf("\t--index-only       only write the seek index LOGFILE.idx\n");
+    ::printf("\t--query TYPE       print TYPE messages as CSV using the seek index\n");
+    ::printf("\t--start TIME_US    start of --query time range\n");
+    ::printf("\t--end TIME_US      end of --query time range\n");
+    ::printf("\t--scan             answer --query by scanning the whole log\n");
+    ::printf("\t                   (always done for compressed logs)\n");
+}
+
+enum {
+    OPT_OUTDIR = 128,
+    OPT_INDEX_ONLY,
+    OPT_QUERY,
+    OPT_START,
+    OPT_END,
+    OPT_SCAN,
+};
+
+void LogColumnar::_parse_command_line(uint8_t argc, char * const argv[])
+{
+    const struct GetOptLong::option options[] = {
+        // name           has_arg flag   val
+        {"outdir",          true,   0, OPT_OUTDIR},
+        {"index-only",      false,  0, OPT_INDEX_ONLY},
+        {"query",           true,   0, OPT_QUERY},
+        {"start",           true,   0, OPT_START},
+        {"end",             true,   0, OPT_END},
+        {"scan",            false,  0, OPT_SCAN},
+        {"help",            false,  0, 'h'},
+        {0, false, 0, 0}
+    };
+
+    GetOptLong gopt(argc, argv, "h", options);
+
+    int opt;
+    while ((opt = gopt.getoption()) != -1) {
+        switch (opt) {
+        case OPT_OUTDIR:
+            outdir = gopt.optarg;
+            break;
+
+        case OPT_INDEX_ONLY:
+            index_only = true;
+            break;
+
+        case OPT_QUERY:
+            query_type = gopt.optarg;
+            break;
+
+        case OPT_START:
+            query_start_us = strtoull(gopt.optarg, NULL, 0);
+            break;
+
+        case OPT_END:
+            query_end_us = strtoull(gopt.optarg, NULL, 0);
+            break;
+
+        case OPT_SCAN:
+            query_scan = true;
+            break;
+
+        case 'h':
+        default:
+            usage();
+            exit(0);
+        }
+    }
+
+    argv += gopt.optind;
+    argc -= gopt.optind;
+
+    if (argc < 1) {
+        usage();
+        exit(1);
+    }
+    filename = argv[0];
+}
+
+void LogColumnar::convert(void)
+{
+    struct stat st;
+    if (stat(filename, &st) != 0) {
+        perror(filename);
+        exit(1);
+    }
+
+    char path[256];
+
+    // pass 1: counts and seek index
+    uint64_t start = now();
+    LC_IndexReader indexer;
+    if (!indexer.open_log(filename)) {
+        perror(filename);
+        exit(1);
+    }
+    char type[5];
+    while (indexer.update(type)) {
+    }
+    snprintf(path, sizeof(path), "%s.idx", filename);
+    if (indexer.is_compressed()) {
+        // offsets into the decompressed data can't be seeked to
+        ::printf("%s is compressed, no seek index written\n", filename);
+    } else {
+        if (!indexer.write_index(path, st.st_size)) {
+            exit(1);
+        }
+        uint64_t index_us = now() - start;
+        ::printf("Indexed %s in %.3fs (%.1f MB/s)\n", path, index_us*1.0e-6,
+                 st.st_size / (double)index_us);
+    }
+
+    if (index_only) {
+        return;
+    }
+
+    // pass 2: columns
+    char default_outdir[256];
+    if (outdir == nullptr) {
+        snprintf(default_outdir, sizeof(default_outdir), "%s.cols", filename);
+        outdir = default_outdir;
+    }
+    if (::mkdir(outdir, 0755) != 0 && errno != EEXIST) {
+        perror(outdir);
+        exit(1);
+    }
+
+    start = now();
+    for (uint16_t i=0; i<LOGREADER_MAX_FORMATS; i++) {
+        LC_MsgHandler *h = indexer.handlers[i];
+        if (h != nullptr && h->count > 0 && !h->open_columns(outdir, h->count)) {
+            exit(1);
+        }
+    }
+    LC_ColumnReader writer(indexer.handlers);
+    if (!writer.open_log(filename)) {
+        perror(filename);
+        exit(1);
+    }
+    while (writer.update(type)) {
+    }
+    uint16_t num_files = 0;
+    for (uint16_t i=0; i<LOGREADER_MAX_FORMATS; i++) {
+        LC_MsgHandler *h = indexer.handlers[i];
+        if (h != nullptr && h->count > 0) {
+            if (!h->close_columns()) {
+                exit(1);
+            }
+            num_files++;
+        }
+    }
+    uint64_t column_us = now() - start;
+    ::printf("Wrote %u column files to %s in %.3fs (%.1f MB/s)\n",
+             num_files, outdir, column_us*1.0e-6,
+             st.st_size / (double)column_us);
+}
+
+void LogColumnar::query(void)
+{
+    struct stat st;
+    if (stat(filename, &st) != 0) {
+        perror(filename);
+        exit(1);
+    }
+
+    const uint64_t start = now();
+    LC_QueryReader reader(query_type, query_start_us, query_end_us);
+    if (!reader.open_log(filename)) {
+        perror(filename);
+        exit(1);
+    }
+    if (!query_scan && reader.is_compressed()) {
+        ::fprintf(stderr, "%s: compressed logs have no seek index, scanning\n", filename);
+    } else if (!query_scan) {
+        char path[256];
+        snprintf(path, sizeof(path), "%s.idx", filename);
+        if (!reader.load_index(path, st.st_size)) {
+            ::fprintf(stderr, "%s: no usable index, run without --query first\n", path);
+            exit(1);
+        }
+    }
+    char type[5];
+    while (reader.update(type)) {
+    }
+    ::fprintf(stderr, "%u rows in %.3fms\n", reader.rows, (now() - start)*1.0e-3);
+}
+
+void LogColumnar::setup()
+{
+    uint8_t argc;
+    char * const *argv;
+
+    hal.util->commandline_arguments(argc, argv);
+
+    _parse_command_line(argc, argv);
+}
+
+void LogColumnar::loop()
+{
+    if (query_type != nullptr) {
+        query();
+    } else {
+        convert();
+    }
+    exit(0);
+}
+
+LogColumnar logcolumnar;
+
+AP_HAL_MAIN_CALLBACKS(&logcolumnar);
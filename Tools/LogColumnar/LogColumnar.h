@@ -0,0 +1,90 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+/*
+  LogColumnar converts a DataFlash log into a columnar representation
+  and writes a sidecar seek index for the original log.
+
+  Columnar output is a directory holding one NAME.col file per message
+  type present in the log:
+
+    struct col_header
+    struct col_field[num_columns]
+    column data, each column a contiguous little-endian array of
+    count elements of its field type, starting on a
+    LOGCOLUMNAR_ALIGN boundary
+
+  The last column is always the timestamp index: a uint64_t array of
+  microsecond timestamps, non-decreasing, so that a time range maps to
+  a row range by binary search.  Messages without their own TimeUS or
+  TimeMS field are stamped with the most recent timestamp seen in the
+  log.
+
+  The seek index (LOGFILE.idx) holds every message format followed by,
+  per message type, one (timestamp, file offset) entry for every
+  LOGINDEX_STRIDE messages of that type:
+
+    struct log_index_header
+    num_types * {
+        struct log_index_type
+        struct log_index_entry[num_entries]
+    }
+ */
+
+#include <DataFlash/DataFlash.h>
+
+#define LOGCOLUMNAR_MAGIC "APCL"
+#define LOGCOLUMNAR_VERSION 1
+#define LOGCOLUMNAR_ALIGN 64
+#define LOGCOLUMNAR_TIMESTAMP_LABEL "_ts"
+
+#define LOGINDEX_MAGIC "APLI"
+#define LOGINDEX_VERSION 1
+#define LOGINDEX_STRIDE 64
+
+struct PACKED col_header {
+    char magic[4];
+    uint8_t version;
+    uint8_t num_columns;   // including the timestamp column
+    struct log_Format fmt;
+    uint64_t count;
+};
+
+struct PACKED col_field {
+    char label[16];
+    uint8_t type;          // DataFlash format character
+    uint8_t length;        // bytes per element
+    uint64_t offset;       // file offset of the first element
+};
+
+struct PACKED log_index_header {
+    char magic[4];
+    uint8_t version;
+    uint8_t num_types;
+    uint16_t stride;
+    uint64_t log_size;
+};
+
+struct PACKED log_index_type {
+    struct log_Format fmt;
+    uint64_t count;        // total messages of this type in the log
+    uint32_t num_entries;
+};
+
+struct PACKED log_index_entry {
+    uint64_t time_us;
+    uint64_t offset;
+};
@@ -0,0 +1,89 @@
+#!/usr/bin/env python
+'''
+benchmark LogColumnar on a synthetic DataFlash log
+
+Generates a log of the requested size containing IMU, ATT, GPS and
+BARO messages at typical copter rates, then times conversion to
+columns and compares an indexed time-range query against a full scan.
+'''
+
+import optparse, os, struct, sys, time
+
+parser = optparse.OptionParser("benchmark.py")
+parser.add_option("--binary", type='string', default='build/linux/tools/LogColumnar', help='LogColumnar binary')
+parser.add_option("--log", type='string', default='/tmp/LogColumnar-bench.bin', help='log file to generate')
+parser.add_option("--size-mb", type=int, default=200, help='size of generated log in MB')
+parser.add_option("--keep", action='store_true', default=False, help="reuse an existing generated log")
+
+opts, args = parser.parse_args()
+
+HEAD = b'\xa3\x95'
+
+# (type, name, format, labels, struct format, rate Hz)
+formats = [
+    (64, b'IMU', b'QffffffIIfBB', b'TimeUS,GyrX,GyrY,GyrZ,AccX,AccY,AccZ,EG,EA,T,GH,AH', '<QffffffIIfBB', 400),
+    (65, b'ATT', b'QccccCCCC', b'TimeUS,DesRoll,Roll,DesPitch,Pitch,DesYaw,Yaw,ErrRP,ErrYaw', '<QhhhhHHHH', 100),
+    (66, b'GPS', b'QBIHBcLLefffB', b'TimeUS,Status,GMS,GWk,NSats,HDop,Lat,Lng,Alt,Spd,GCrs,VZ,U', '<QBIHBhiiifffB', 10),
+    (67, b'BARO', b'QffcfIf', b'TimeUS,Alt,Press,Temp,CRt,SMS,Offset', '<QffhfIf', 50),
+]
+
+def fmt_msg(mtype, name, fmt, labels, length):
+    return HEAD + struct.pack('<BBB4s16s64s', 128, mtype, length,
+                              name.ljust(4, b'\0'), fmt.ljust(16, b'\0'), labels.ljust(64, b'\0'))
+
+def generate(path, size):
+    '''write a log of approximately size bytes'''
+    out = open(path, 'wb')
+    out.write(fmt_msg(128, b'FMT', b'BBnNZ', b'Type,Length,Name,Format,Columns', 89))
+    for (mtype, name, fmt, labels, sfmt, rate) in formats:
+        out.write(fmt_msg(mtype, name, fmt, labels, 3 + struct.calcsize(sfmt)))
+    written = 0
+    t_us = 0
+    tick = 0
+    while written < size:
+        chunk = []
+        for i in range(400):
+            t_us += 2500
+            tick += 1
+            for (mtype, name, fmt, labels, sfmt, rate) in formats:
+                if tick % (400 // rate) != 0:
+                    continue
+                if name == b'IMU':
+                    body = struct.pack(sfmt, t_us, 0.01, 0.02, 0.03, 0.1, 0.2, -9.8, 0, 0, 25.0, 1, 1)
+                elif name == b'ATT':
+                    body = struct.pack(sfmt, t_us, 10, 11, 20, 21, 300, 301, 5, 6)
+                elif name == b'GPS':
+                    body = struct.pack(sfmt, t_us, 3, t_us // 1000, 1900, 12, 80, -353632610, 1491652300, 58400, 1.0, 90.0, 0.1, 1)
+                else:
+                    body = struct.pack(sfmt, t_us, 10.0, 101325.0, 2500, 0.1, t_us // 1000, 0.0)
+                chunk.append(HEAD + struct.pack('<B', mtype) + body)
+        data = b''.join(chunk)
+        out.write(data)
+        written += len(data)
+    out.close()
+
+def run(cmd):
+    '''run a command, returning elapsed seconds'''
+    t0 = time.time()
+    if os.system(cmd) != 0:
+        print("Failed: %s" % cmd)
+        sys.exit(1)
+    return time.time() - t0
+
+if not opts.keep or not os.path.exists(opts.log):
+    print("Generating %u MB log %s" % (opts.size_mb, opts.log))
+    generate(opts.log, opts.size_mb * 1024 * 1024)
+
+size_mb = os.path.getsize(opts.log) / (1024.0 * 1024.0)
+
+t = run("%s %s" % (opts.binary, opts.log))
+print("convert: %.2fs %.1f MB/s" % (t, size_mb / t))
+
+# query 10 seconds from the middle of the log
+bytes_per_second = sum([f[5] * (3 + struct.calcsize(f[4])) for f in formats])
+duration_us = int(os.path.getsize(opts.log) * 1.0e6 / bytes_per_second)
+t0 = duration_us // 2
+t1 = t0 + 10 * 1000 * 1000
+t_index = run("%s --query IMU --start %u --end %u %s > /dev/null" % (opts.binary, t0, t1, opts.log))
+t_scan = run("%s --query IMU --start %u --end %u --scan %s > /dev/null" % (opts.binary, t0, t1, opts.log))
+print("10s IMU query: indexed %.3fs, full scan %.3fs (%.0fx)" % (t_index, t_scan, t_scan / t_index))
@@ -1,5 +1,7 @@
 #include "DataFlashFileReader.h"
 
+#include <DataFlash/DataFlash_Compress.h>
+
 #include <fcntl.h>
 #include <string.h>
 #include <sys/types.h>
@@ -22,8 +24,8 @@ DataFlashFileReader::~DataFlashFileReader()
 {
     const uint64_t micros = now();
     const uint64_t delta = micros - start_micros;
-    ::printf("Replay counts: %ld bytes  %u entries\n", bytes_read, message_count);
-    ::printf("Replay rates: %ld bytes/second  %ld messages/second\n", bytes_read*1000000/delta, message_count*1000000/delta);
+    ::fprintf(stderr, "Replay counts: %ld bytes  %u entries\n", bytes_read, message_count);
+    ::fprintf(stderr, "Replay rates: %ld bytes/second  %ld messages/second\n", bytes_read*1000000/delta, message_count*1000000/delta);
 }
 
 bool DataFlashFileReader::open_log(const char *logfile)
@@ -32,16 +34,97 @@ bool DataFlashFileReader::open_log(const char *logfile)
     if (fd == -1) {
         return false;
     }
+    uint8_t magic[2];
+    if (::read(fd, magic, sizeof(magic)) == sizeof(magic) &&
+        magic[0] == DF_COMPRESS_MAGIC1 && magic[1] == DF_COMPRESS_MAGIC2) {
+        compressed = true;
+    }
+    ::lseek(fd, 0, SEEK_SET);
     return true;
 }
 
 ssize_t DataFlashFileReader::read_input(void *buffer, const size_t count)
 {
-    uint64_t ret = ::read(fd, buffer, count);
+    uint8_t *dest = (uint8_t *)buffer;
+    size_t ret = 0;
+    while (ret < count) {
+        if (input_buf_ofs == input_buf_len && fill_input_buf() <= 0) {
+            break;
+        }
+        const uint32_t available = input_buf_len - input_buf_ofs;
+        const uint32_t n = (count - ret < available) ? (count - ret) : available;
+        memcpy(&dest[ret], &input_buf[input_buf_ofs], n);
+        input_buf_ofs += n;
+        ret += n;
+    }
     bytes_read += ret;
+    input_offset += ret;
     return ret;
 }
 
+/*
+  refill input_buf, decompressing a block if the log is compressed
+ */
+ssize_t DataFlashFileReader::fill_input_buf(void)
+{
+    input_buf_ofs = 0;
+    input_buf_len = 0;
+    if (!compressed) {
+        const ssize_t n = ::read(fd, input_buf, sizeof(input_buf));
+        if (n > 0) {
+            input_buf_len = n;
+        }
+        return n;
+    }
+
+    /*
+      a bad block is skipped by looking for the next header, one byte
+      on from the start of the bad one, whose payload checks out
+     */
+    uint32_t skipped = 0;
+    while (true) {
+        const off_t block_start = ::lseek(fd, 0, SEEK_CUR);
+        struct df_compress_header hdr;
+        if (::read(fd, &hdr, sizeof(hdr)) != sizeof(hdr)) {
+            break;
+        }
+        if (DataFlash_Compressor::check_header(hdr)) {
+            uint8_t payload[hdr.compressed_length];
+            if (::read(fd, payload, hdr.compressed_length) == hdr.compressed_length) {
+                const int32_t n = DataFlash_Compressor::decompress_block(hdr, payload, input_buf, sizeof(input_buf));
+                if (n > 0) {
+                    if (skipped != 0) {
+                        ::printf("skipped %u bytes of corrupt compressed data\n", (unsigned)skipped);
+                    }
+                    input_buf_len = n;
+                    return n;
+                }
+            }
+        }
+        skipped++;
+        ::lseek(fd, block_start + 1, SEEK_SET);
+    }
+    if (skipped != 0) {
+        // block truncated by a crash, or garbage at the end of the log
+        ::printf("skipped %u bytes of corrupt compressed data at end of log\n", (unsigned)skipped);
+    }
+    return 0;
+}
+
+bool DataFlashFileReader::seek(uint64_t offset)
+{
+    if (compressed) {
+        return false;
+    }
+    if (::lseek(fd, offset, SEEK_SET) != (off_t)offset) {
+        return false;
+    }
+    input_buf_len = 0;
+    input_buf_ofs = 0;
+    input_offset = offset;
+    return true;
+}
+
 void DataFlashFileReader::format_type(uint16_t type, char dest[5])
 {
     const struct log_Format &f = formats[type];
@@ -58,13 +141,31 @@ void DataFlashFileReader::get_packet_counts(uint64_t dest[])
 
 bool DataFlashFileReader::update(char type[5])
 {
+    message_offset = input_offset;
+
     uint8_t hdr[3];
     if (read_input(hdr, 3) != 3) {
         return false;
     }
-    if (hdr[0] != HEAD_BYTE1 || hdr[1] != HEAD_BYTE2) {
-        printf("bad log header\n");
-        return false;
+    uint32_t skipped = 0;
+    while (hdr[0] != HEAD_BYTE1 || hdr[1] != HEAD_BYTE2 ||
+           (compressed && hdr[2] != LOG_FORMAT_MSG && formats[hdr[2]].length == 0)) {
+        if (!compressed) {
+            printf("bad log header\n");
+            return false;
+        }
+        // the tail of a message split by a lost block; move along
+        // to the next thing that looks like a message header
+        hdr[0] = hdr[1];
+        hdr[1] = hdr[2];
+        if (read_input(&hdr[2], 1) != 1) {
+            return false;
+        }
+        skipped++;
+    }
+    if (skipped != 0) {
+        printf("skipped %u bytes to the next message\n", (unsigned)skipped);
+        message_offset = input_offset - 3;
     }
 
     packet_counts[hdr[2]]++;
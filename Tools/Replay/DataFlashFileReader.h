@@ -20,6 +20,19 @@ public:
     void format_type(uint16_t type, char dest[5]);
     void get_packet_counts(uint64_t dest[]);
 
+    // offset within the log of the start of the message most
+    // recently returned by update()
+    uint64_t last_message_offset(void) const { return message_offset; }
+
+    // continue reading from offset, which must be the start of a
+    // message.  Formats already seen are retained.  Not supported
+    // for compressed logs.
+    bool seek(uint64_t offset);
+
+    // true if the log is a sequence of DataFlash_Compressor blocks;
+    // offsets are then into the decompressed data
+    bool is_compressed(void) const { return compressed; }
+
 protected:
     int fd = -1;
     bool done_format_msgs = false;
@@ -29,6 +42,18 @@ protected:
 
 private:
     ssize_t read_input(void *buf, size_t count);
+    ssize_t fill_input_buf(void);
+
+    bool compressed = false;
+
+    // input is read in large chunks to avoid two syscalls per message
+    uint8_t input_buf[65536];
+    uint32_t input_buf_len = 0;
+    uint32_t input_buf_ofs = 0;
+
+    // offset within the log of the next byte to be consumed
+    uint64_t input_offset = 0;
+    uint64_t message_offset = 0;
 
     uint64_t bytes_read = 0;
     uint32_t message_count = 0;
@@ -17,6 +17,14 @@ public:
     // retrieve a comma-separated list of all labels
     void string_for_labels(char *buffer, uint bufferlen);
 
+    // access to the parsed field table, in the order fields appear
+    // in the message
+    uint8_t num_fields(void) const { return next_field; }
+    const char *field_label(uint8_t i) const { return field_info[i].label; }
+    uint8_t field_type(uint8_t i) const { return field_info[i].type; }
+    uint8_t field_offset(uint8_t i) const { return field_info[i].offset; }
+    uint8_t field_length(uint8_t i) const { return field_info[i].length; }
+
     // field_value - retrieve the value of a field from the supplied message
     // these return false if the field was not found
     template<typename R>
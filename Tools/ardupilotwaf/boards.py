@@ -163,6 +163,8 @@ class Board:
             ]
 
         if self.with_uavcan:
+            env.WITH_UAVCAN = True
+
             env.AP_LIBRARIES += [
                 'AP_UAVCAN',
                 'modules/uavcan/libuavcan/src/**/*.cpp'
@@ -241,6 +243,10 @@ class sitl(Board):
 
 class linux(Board):
     def configure_env(self, cfg, env):
+        if cfg.options.enable_uavcan:
+            # SocketCAN, see AP_HAL_Linux/CAN.cpp
+            self.with_uavcan = True
+
         super(linux, self).configure_env(cfg, env)
 
         cfg.find_toolchain_program('pkg-config', var='PKGCONFIG')
@@ -250,6 +256,11 @@ class linux(Board):
             CONFIG_HAL_BOARD_SUBTYPE = 'HAL_BOARD_SUBTYPE_LINUX_NONE',
         )
 
+        if self.with_uavcan:
+            env.DEFINES.update(
+                HAL_WITH_UAVCAN = 1,
+            )
+
         if not cfg.env.DEBUG:
             env.CXXFLAGS += [
                 '-O3',
@@ -265,7 +276,7 @@ class linux(Board):
         cfg.check_libiio(env)
 
         env.LINKFLAGS += ['-pthread',]
-        env.AP_LIBRARIES = [
+        env.AP_LIBRARIES += [
             'AP_HAL_Linux',
         ]
 
@@ -18,7 +18,9 @@ import traceback
 import apmrover2
 import arducopter
 import arduplane
+import mission_upload
 import quadplane
+import spline_mission
 import ardusub
 from pysim import util
 from pymavlink import mavutil
@@ -253,6 +255,12 @@ def run_step(step):
     if step == 'fly.ArduCopter':
         return arducopter.fly_ArduCopter(binary, frame=opts.frame, **fly_opts)
 
+    if step == 'mission.ArduCopter':
+        return mission_upload.test_mission_upload(binary, **fly_opts)
+
+    if step == 'spline.ArduCopter':
+        return spline_mission.test_spline_mission(binary, **fly_opts)
+
     if step == 'fly.CopterAVC':
         return arducopter.fly_CopterAVC(binary, **fly_opts)
 
@@ -510,6 +518,12 @@ if __name__ == "__main__":
     'convertgpx',
     ]
 
+    # steps only run when named on the command line
+    optional_steps = [
+    'mission.ArduCopter',
+    'spline.ArduCopter',
+    ]
+
     skipsteps = opts.skip.split(',')
 
     # ensure we catch timeouts
@@ -517,7 +531,7 @@ if __name__ == "__main__":
     signal.alarm(opts.timeout)
 
     if opts.list:
-        for step in steps:
+        for step in steps + optional_steps:
             print(step)
         sys.exit(0)
 
@@ -537,7 +551,7 @@ if __name__ == "__main__":
         # allow a wildcard list of steps
         matched = []
         for a in args:
-            matches = [step for step in steps if fnmatch.fnmatch(step.lower(), a.lower())]
+            matches = [step for step in steps + optional_steps if fnmatch.fnmatch(step.lower(), a.lower())]
             if not len(matches):
                 print("No steps matched {}".format(a))
                 sys.exit(1)
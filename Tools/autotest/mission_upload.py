@@ -0,0 +1,204 @@
+# measure mission upload time in SITL against telemetry link latency
+#
+# The vehicle is reached through a local TCP relay which delays every
+# byte in each direction, so a round trip costs twice the configured
+# latency. The upload answers whatever MISSION_REQUESTs the vehicle
+# sends, so the vehicle decides how many items are in flight.
+from __future__ import print_function
+import collections
+import socket
+import threading
+import time
+
+from pymavlink import mavutil
+
+from common import *
+from pysim import util
+
+HOME = mavutil.location(-35.362938, 149.165085, 584, 270)
+
+RELAY_PORT = 5770
+
+
+class MissionUploadException(Exception):
+    pass
+
+
+class DelayRelay(object):
+    '''relay a TCP connection to the vehicle, delaying data in both directions'''
+
+    def __init__(self, listen_port, target, latency):
+        self.latency = latency
+        self.running = True
+        self.listen = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+        self.listen.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+        self.listen.bind(('127.0.0.1', listen_port))
+        self.listen.listen(1)
+        self.target = target
+        self.thread = threading.Thread(target=self.run)
+        self.thread.daemon = True
+        self.thread.start()
+
+    def pump(self, src, dst):
+        '''forward data from src to dst after the link latency'''
+        queue = collections.deque()
+        src.setblocking(0)
+        while self.running:
+            try:
+                data = src.recv(4096)
+                if not data:
+                    break
+                queue.append((time.time() + self.latency, data))
+            except socket.error:
+                pass
+            now = time.time()
+            while len(queue) and queue[0][0] <= now:
+                dst.sendall(queue.popleft()[1])
+            time.sleep(0.001)
+
+    def run(self):
+        client, addr = self.listen.accept()
+        vehicle = socket.create_connection(self.target)
+        up = threading.Thread(target=self.pump, args=(client, vehicle))
+        up.daemon = True
+        up.start()
+        self.pump(vehicle, client)
+
+    def close(self):
+        self.running = False
+        self.listen.close()
+
+
+def make_survey(count):
+    '''a lawnmower survey of count waypoints'''
+    items = []
+    for seq in range(count):
+        line = seq // 2
+        lat = int((HOME.lat + line * 0.00002) * 1.0e7)
+        lng = int((HOME.lng + ((line + seq) % 2) * 0.004) * 1.0e7)
+        items.append((seq, lat, lng))
+    return items
+
+
+def upload_mission(mav, items, timeout=600):
+    '''upload items, returning the time taken and number of duplicate requests'''
+    mav.mav.mission_count_send(mav.target_system, mav.target_component, len(items))
+    requested = set()
+    duplicates = 0
+    tstart = time.time()
+    while time.time() < tstart + timeout:
+        m = mav.recv_match(type=['MISSION_REQUEST', 'MISSION_REQUEST_INT', 'MISSION_ACK'],
+                           blocking=True, timeout=5)
+        if m is None:
+            continue
+        if m.get_type() == 'MISSION_ACK':
+            if m.type != mavutil.mavlink.MAV_MISSION_ACCEPTED:
+                raise MissionUploadException("Mission upload failed: %u" % m.type)
+            if len(requested) != len(items):
+                raise MissionUploadException("Mission accepted after %u of %u items" %
+                                             (len(requested), len(items)))
+            return (time.time() - tstart, duplicates)
+        if m.seq in requested:
+            duplicates += 1
+        requested.add(m.seq)
+        (seq, lat, lng) = items[m.seq]
+        mav.mav.mission_item_int_send(mav.target_system, mav.target_component, seq,
+                                      mavutil.mavlink.MAV_FRAME_GLOBAL_RELATIVE_ALT,
+                                      mavutil.mavlink.MAV_CMD_NAV_WAYPOINT,
+                                      0, 1, 0, 0, 0, 0, lat, lng, 50)
+    raise AutoTestTimeoutException("Mission upload timed out")
+
+
+def check_mission(mav, items, step=97):
+    '''check the mission count and a sample of the uploaded items'''
+    mav.mav.mission_request_list_send(mav.target_system, mav.target_component)
+    m = mav.recv_match(type='MISSION_COUNT', blocking=True, timeout=10)
+    if m is None or m.count != len(items):
+        raise MissionUploadException("Bad mission count %s" % m)
+    for (seq, lat, lng) in items[1::step] + items[-1:]:
+        mav.mav.mission_request_int_send(mav.target_system, mav.target_component, seq)
+        m = mav.recv_match(type='MISSION_ITEM_INT', blocking=True, timeout=10)
+        if m is None or m.seq != seq or m.x != lat or m.y != lng:
+            raise MissionUploadException("Mission item %u mismatch: %s" % (seq, m))
+
+
+def set_mis_options(mav, value):
+    '''set MIS_OPTIONS and wait for the vehicle to confirm it'''
+    mav.mav.param_set_send(mav.target_system, mav.target_component, b'MIS_OPTIONS',
+                           value, mavutil.mavlink.MAV_PARAM_TYPE_INT16)
+    m = mav.recv_match(type='PARAM_VALUE', blocking=True, timeout=10,
+                       condition="PARAM_VALUE.param_id=='MIS_OPTIONS'")
+    if m is None or int(m.param_value) != value:
+        raise MissionUploadException("Failed to set MIS_OPTIONS: %s" % m)
+
+
+def test_single_item_upload(binary, home, count=50, latency=0.05):
+    '''with MIS_OPTIONS bit 1 set, items are requested one round trip at a time'''
+    items = make_survey(count)
+    sitl = util.start_SITL(binary, wipe=True, model='+', home=home, speedup=1)
+    relay = DelayRelay(RELAY_PORT, ('127.0.0.1', 5760), latency)
+    try:
+        mav = mavutil.mavlink_connection('tcp:127.0.0.1:%u' % RELAY_PORT,
+                                         robust_parsing=True, source_system=250)
+        mav.wait_heartbeat()
+        wait_seconds(mav, 5)
+        set_mis_options(mav, 2)
+        (elapsed, duplicates) = upload_mission(mav, items)
+        check_mission(mav, items)
+        rtt = 2 * latency
+        print("Uploaded %u items one at a time with %.0fms latency in %.1fs" %
+              (count, latency * 1000, elapsed))
+        if elapsed < 0.9 * count * rtt:
+            print("Upload pipelined with MIS_OPTIONS=2: %.1fs for %u round trips of %.0fms" %
+                  (elapsed, count, rtt * 1000))
+            return False
+    except Exception as e:
+        print("Single item mission upload failed: %s" % e)
+        return False
+    finally:
+        relay.close()
+        util.pexpect_close(sitl)
+    return True
+
+
+def test_mission_upload(binary, count=1000, latencies=[0, 0.05, 0.2, 0.5], **kwargs):
+    '''upload a count item mission through links of each latency'''
+    items = make_survey(count)
+    home = "%f,%f,%u,%u" % (HOME.lat, HOME.lng, HOME.alt, HOME.heading)
+    results = []
+    failed = False
+    for latency in latencies:
+        sitl = util.start_SITL(binary, wipe=True, model='+', home=home, speedup=1)
+        relay = DelayRelay(RELAY_PORT, ('127.0.0.1', 5760), latency)
+        try:
+            mav = mavutil.mavlink_connection('tcp:127.0.0.1:%u' % RELAY_PORT,
+                                             robust_parsing=True, source_system=250)
+            mav.wait_heartbeat()
+            # the vehicle only accepts an upload once it is fully booted
+            wait_seconds(mav, 5)
+            (elapsed, duplicates) = upload_mission(mav, items)
+            check_mission(mav, items)
+            rtt = 2 * latency
+            results.append((latency, elapsed, duplicates))
+            print("Uploaded %u items with %.0fms latency in %.1fs (%.1f items/s, %u re-requested)" %
+                  (count, latency * 1000, elapsed, count / elapsed, duplicates))
+            # a request/response protocol needs count round trips, a
+            # pipelined one much fewer
+            if rtt > 0 and elapsed > 0.5 * count * rtt:
+                print("Upload not pipelined: %.1fs for %u round trips of %.0fms" %
+                      (elapsed, count, rtt * 1000))
+                failed = True
+        except Exception as e:
+            print("Mission upload failed with latency %.0fms: %s" % (latency * 1000, e))
+            failed = True
+        finally:
+            relay.close()
+            util.pexpect_close(sitl)
+
+    if not test_single_item_upload(binary, home):
+        failed = True
+
+    print("Mission upload of %u items:" % count)
+    for (latency, elapsed, duplicates) in results:
+        print("  latency %4.0fms: %6.1fs" % (latency * 1000, elapsed))
+    return not failed
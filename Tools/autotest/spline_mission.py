@@ -0,0 +1,116 @@
+# measure how long ArduCopter takes to fly a spline mission in SITL
+#
+# The mission in copter_spline_mission.txt is flown once for each
+# cornering acceleration (WPNAV_ACCEL_C) given, and the mission
+# completion time in simulated time is reported so changes to the
+# spline controller can be compared.
+from __future__ import print_function
+import os
+import time
+
+from pymavlink import mavutil, mavwp
+
+from common import *
+from pysim import util
+
+AVCHOME = mavutil.location(40.072842, -105.230575, 1586, 0)
+
+testdir = os.path.dirname(os.path.realpath(__file__))
+
+
+class SplineMissionException(Exception):
+    pass
+
+
+def upload_mission(mav, wploader, timeout=60):
+    '''upload the waypoints held by wploader'''
+    mav.mav.mission_count_send(mav.target_system, mav.target_component, wploader.count())
+    tstart = time.time()
+    while time.time() < tstart + timeout:
+        m = mav.recv_match(type=['MISSION_REQUEST', 'MISSION_ACK'], blocking=True, timeout=5)
+        if m is None:
+            continue
+        if m.get_type() == 'MISSION_ACK':
+            if m.type != mavutil.mavlink.MAV_MISSION_ACCEPTED:
+                raise SplineMissionException("Mission upload failed: %u" % m.type)
+            return
+        wp = wploader.wp(m.seq)
+        wp.target_system = mav.target_system
+        wp.target_component = mav.target_component
+        mav.mav.send(wp)
+    raise AutoTestTimeoutException("Mission upload timed out")
+
+
+def set_param(mav, name, value, timeout=10):
+    '''set a parameter and wait for the vehicle to confirm it'''
+    tstart = time.time()
+    while time.time() < tstart + timeout:
+        mav.mav.param_set_send(mav.target_system, mav.target_component, name.encode('ascii'),
+                               value, mavutil.mavlink.MAV_PARAM_TYPE_REAL32)
+        m = mav.recv_match(type='PARAM_VALUE', blocking=True, timeout=1)
+        if m is not None and m.param_id == name and abs(m.param_value - value) < 0.001:
+            return
+    raise SplineMissionException("Failed to set %s" % name)
+
+
+def fly_spline_mission(mav, num_wp, timeout=900):
+    '''fly the loaded mission in AUTO, returning the simulated time taken in seconds'''
+    mav.arducopter_arm()
+    mav.motors_armed_wait()
+    mav.set_mode('AUTO')
+    tstart = None
+    tnow = None
+    wstart = time.time()
+    while time.time() < wstart + timeout:
+        # auto takeoff starts once the throttle is raised
+        mav.mav.rc_channels_override_send(mav.target_system, mav.target_component,
+                                          0, 0, 1500, 0, 0, 0, 0, 0)
+        m = mav.recv_match(type=['GLOBAL_POSITION_INT', 'HEARTBEAT', 'MISSION_ITEM_REACHED'],
+                           blocking=True, timeout=1)
+        if m is None:
+            continue
+        if m.get_type() == 'GLOBAL_POSITION_INT':
+            tnow = m.time_boot_ms * 0.001
+            if tstart is None and mav.flightmode == 'AUTO':
+                tstart = tnow
+        elif m.get_type() == 'MISSION_ITEM_REACHED':
+            print("Reached command #%u" % m.seq)
+            if m.seq == num_wp - 1 and tstart is not None and tnow is not None:
+                return tnow - tstart
+    raise AutoTestTimeoutException("Spline mission timed out")
+
+
+def test_spline_mission(binary, accel_c=[0, 100, 400], speedup=10, **kwargs):
+    '''fly the spline mission once for each WPNAV_ACCEL_C value'''
+    filename = os.path.join(testdir, "copter_spline_mission.txt")
+    wploader = mavwp.MAVWPLoader()
+    wploader.load(filename)
+    home = "%f,%f,%u,%u" % (AVCHOME.lat, AVCHOME.lng, AVCHOME.alt, AVCHOME.heading)
+    defaults = os.path.join(testdir, "default_params/copter.parm")
+    results = []
+    failed = False
+    for accel in accel_c:
+        sitl = util.start_SITL(binary, wipe=True, model='+', home=home, speedup=speedup,
+                               defaults_file=defaults)
+        try:
+            mav = mavutil.mavlink_connection('tcp:127.0.0.1:5760', robust_parsing=True)
+            mav.wait_heartbeat()
+            mav.mav.request_data_stream_send(mav.target_system, mav.target_component,
+                                             mavutil.mavlink.MAV_DATA_STREAM_ALL, 10, 1)
+            wait_ready_to_arm(mav)
+            set_param(mav, 'WPNAV_ACCEL_C', accel)
+            upload_mission(mav, wploader)
+            elapsed = fly_spline_mission(mav, wploader.count())
+            mav.motors_disarmed_wait()
+            results.append((accel, elapsed))
+            print("Spline mission with WPNAV_ACCEL_C=%u took %.1fs" % (accel, elapsed))
+        except Exception as e:
+            print("Spline mission failed with WPNAV_ACCEL_C=%u: %s" % (accel, e))
+            failed = True
+        finally:
+            util.pexpect_close(sitl)
+
+    print("Spline mission completion time:")
+    for (accel, elapsed) in results:
+        print("  WPNAV_ACCEL_C %4u: %6.1fs" % (accel, elapsed))
+    return not failed
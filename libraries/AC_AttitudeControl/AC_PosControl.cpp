@@ -681,7 +681,7 @@ void AC_PosControl::update_xy_controller(xy_mode mode, float ekfNavVelGainScaler
     pos_to_rate_xy(mode, dt, ekfNavVelGainScaler);
 
     // run position controller's velocity to acceleration step
-    rate_to_accel_xy(dt, ekfNavVelGainScaler);
+    rate_to_accel_xy(mode, dt, ekfNavVelGainScaler);
 
     // run position controller's acceleration to lean angle step
     accel_to_lean_angles(dt, ekfNavVelGainScaler, use_althold_lean_angle);
@@ -753,7 +753,7 @@ void AC_PosControl::update_vel_controller_xy(float ekfNavVelGainScaler)
         pos_to_rate_xy(XY_MODE_POS_LIMITED_AND_VEL_FF, dt, ekfNavVelGainScaler);
 
         // run velocity to acceleration step
-        rate_to_accel_xy(dt, ekfNavVelGainScaler);
+        rate_to_accel_xy(XY_MODE_POS_LIMITED_AND_VEL_FF, dt, ekfNavVelGainScaler);
 
         // run acceleration to lean angle step
         accel_to_lean_angles(dt, ekfNavVelGainScaler, false);
@@ -880,6 +880,10 @@ void AC_PosControl::pos_to_rate_xy(xy_mode mode, float dt, float ekfNavVelGainSc
                 // add velocity feed-forward
                 _vel_target.x += _vel_desired.x;
                 _vel_target.y += _vel_desired.y;
+            } else if (mode == XY_MODE_POS_AND_TRAJECTORY_FF) {
+                // add the position target's own velocity
+                _vel_target.x += _vel_trajectory_ff.x;
+                _vel_target.y += _vel_trajectory_ff.y;
             }
 
             // scale velocity within speed limit
@@ -894,7 +898,7 @@ void AC_PosControl::pos_to_rate_xy(xy_mode mode, float dt, float ekfNavVelGainSc
 
 /// rate_to_accel_xy - horizontal desired rate to desired acceleration
 ///    converts desired velocities in lat/lon directions to accelerations in lat/lon frame
-void AC_PosControl::rate_to_accel_xy(float dt, float ekfNavVelGainScaler)
+void AC_PosControl::rate_to_accel_xy(xy_mode mode, float dt, float ekfNavVelGainScaler)
 {
     Vector2f vel_xy_p, vel_xy_i;
 
@@ -914,7 +918,12 @@ void AC_PosControl::rate_to_accel_xy(float dt, float ekfNavVelGainScaler)
     }
 
     // feed forward desired acceleration calculation
-    if (dt > 0.0f) {
+    if (mode == XY_MODE_POS_AND_TRAJECTORY_FF) {
+        // the trajectory provides its acceleration so there is nothing to differentiate
+        _accel_feedforward.x = _accel_trajectory_ff.x;
+        _accel_feedforward.y = _accel_trajectory_ff.y;
+        _flags.freeze_ff_xy = false;
+    } else if (dt > 0.0f) {
     	if (!_flags.freeze_ff_xy) {
     		_accel_feedforward.x = (_vel_target.x - _vel_last.x)/dt;
     		_accel_feedforward.y = (_vel_target.y - _vel_last.y)/dt;
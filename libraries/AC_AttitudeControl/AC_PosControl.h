@@ -57,7 +57,8 @@ public:
     enum xy_mode {
         XY_MODE_POS_ONLY = 0,           // position correction only (i.e. no velocity feed-forward)
         XY_MODE_POS_LIMITED_AND_VEL_FF, // for loiter - rate-limiting the position correction, velocity feed-forward
-        XY_MODE_POS_AND_VEL_FF          // for velocity controller - unlimited position correction, velocity feed-forward
+        XY_MODE_POS_AND_VEL_FF,         // for velocity controller - unlimited position correction, velocity feed-forward
+        XY_MODE_POS_AND_TRAJECTORY_FF   // for waypoint profiles - unlimited position correction, velocity and acceleration feed-forward from set_trajectory_ff_xy()
     };
 
     ///
@@ -233,6 +234,10 @@ public:
     ///     when update_vel_controller_xyz is next called the position target is moved based on the desired velocity
     void set_desired_velocity(const Vector3f &des_vel) { _vel_desired = des_vel; freeze_ff_xy(); }
 
+    /// set_trajectory_ff_xy - sets velocity in cm/s and acceleration in cm/s/s of the position target in lat and lon directions
+    ///     fed forward by update_xy_controller in XY_MODE_POS_AND_TRAJECTORY_FF. The position target is not moved
+    void set_trajectory_ff_xy(const Vector2f& vel_cms, const Vector2f& accel_cmss) { _vel_trajectory_ff = vel_cms; _accel_trajectory_ff = accel_cmss; }
+
     // overrides the velocity process variable for one timestep
     void override_vehicle_velocity_xy(const Vector2f& vel_xy) { _vehicle_horiz_vel = vel_xy; _flags.vehicle_horiz_vel_override = true; }
 
@@ -360,7 +365,7 @@ protected:
 
     /// rate_to_accel_xy - horizontal desired rate to desired acceleration
     ///    converts desired velocities in lat/lon directions to accelerations in lat/lon frame
-    void rate_to_accel_xy(float dt, float ekfNavVelGainScaler);
+    void rate_to_accel_xy(xy_mode mode, float dt, float ekfNavVelGainScaler);
 
     /// accel_to_lean_angles - horizontal desired acceleration to lean angles
     ///    converts desired accelerations provided in lat/lon frame to roll/pitch angles
@@ -421,6 +426,8 @@ protected:
     Vector3f    _accel_target;          // desired acceleration in cm/s/s  // To-Do: are xy actually required?
     Vector3f    _accel_error;           // desired acceleration in cm/s/s  // To-Do: are xy actually required?
     Vector3f    _accel_feedforward;     // feedforward acceleration in cm/s/s
+    Vector2f    _vel_trajectory_ff;     // velocity of the position target in cm/s, used in XY_MODE_POS_AND_TRAJECTORY_FF
+    Vector2f    _accel_trajectory_ff;   // acceleration of the position target in cm/s/s, used in XY_MODE_POS_AND_TRAJECTORY_FF
     Vector2f    _vehicle_horiz_vel;     // velocity to use if _flags.vehicle_horiz_vel_override is set
     float       _distance_to_target;    // distance to position target - for reporting only
     LowPassFilterFloat _vel_error_filter;   // low-pass-filter on z-axis velocity error
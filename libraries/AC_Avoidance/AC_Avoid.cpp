@@ -5,8 +5,8 @@ const AP_Param::GroupInfo AC_Avoid::var_info[] = {
     // @Param: ENABLE
     // @DisplayName: Avoidance control enable/disable
     // @Description: Enabled/disable stopping at fence
-    // @Values: 0:None,1:StopAtFence,2:UseProximitySensor,3:StopAtFence and UseProximitySensor,4:StopAtBeaconFence,7:All
-    // @Bitmask: 0:StopAtFence,1:UseProximitySensor,2:StopAtBeaconFence
+    // @Values: 0:None,1:StopAtFence,2:UseProximitySensor,3:StopAtFence and UseProximitySensor,4:StopAtBeaconFence,7:All,11:StopAtFence and UseProximityGrid
+    // @Bitmask: 0:StopAtFence,1:UseProximitySensor,2:StopAtBeaconFence,3:UseProximityGrid
     // @User: Standard
     AP_GROUPINFO("ENABLE", 1,  AC_Avoid, _enabled, AC_AVOID_DEFAULT),
 
@@ -68,7 +68,11 @@ void AC_Avoid::adjust_velocity(float kP, float accel_cmss, Vector2f &desired_vel
     }
 
     if ((_enabled & AC_AVOID_USE_PROXIMITY_SENSOR) > 0 && _proximity_enabled) {
-        adjust_velocity_proximity(kP, accel_cmss_limited, desired_vel);
+        if ((_enabled & AC_AVOID_USE_PROXIMITY_GRID) > 0) {
+            adjust_velocity_proximity_grid(kP, accel_cmss_limited, desired_vel);
+        } else {
+            adjust_velocity_proximity(kP, accel_cmss_limited, desired_vel);
+        }
     }
 }
 
@@ -307,6 +311,99 @@ void AC_Avoid::adjust_velocity_proximity(float kP, float accel_cmss, Vector2f &d
     adjust_velocity_polygon(kP, accel_cmss, desired_vel, boundary, num_points, false, _margin);
 }
 
+/*
+ * Adds the latest proximity sensor distances to the occupancy grid
+ */
+void AC_Avoid::update_proximity_grid()
+{
+    if (_grid == nullptr) {
+        _grid = new AC_Avoid_OccupancyGrid();
+        if (_grid == nullptr) {
+            return;
+        }
+    }
+
+    const Vector3f position_cm = _inav.get_position();
+    const Vector2f position(position_cm.x * 0.01f, position_cm.y * 0.01f);
+    _grid->set_center(position);
+
+    // sensors report the same distances until they next update, so add them at a fixed rate
+    const uint32_t now = AP_HAL::millis();
+    if (now - _grid_fuse_ms >= AC_AVOID_GRID_FUSE_MS && _proximity.get_status() == AP_Proximity::Proximity_Good) {
+        _grid_fuse_ms = now;
+        const AP_Proximity_Scan *scan = _proximity.get_scan();
+        AP_Proximity::Proximity_Distance_Array dist_array;
+        if (scan != nullptr) {
+            // scanning sensors give much finer directions than the sectors
+            for (uint16_t step=0; step<360; step+=AC_AVOID_GRID_SCAN_STEP_DEG) {
+                float angle_deg, distance;
+                if (scan->get_closest(step, AC_AVOID_GRID_SCAN_STEP_DEG, now, angle_deg, distance)) {
+                    const float angle = _ahrs.yaw + radians(angle_deg);
+                    const Vector2f dir(cosf(angle), sinf(angle));
+                    _grid->push_return(position, dir, distance, _proximity.distance_max());
+                }
+            }
+        } else if (_proximity.get_horizontal_distances(dist_array)) {
+            const float max_distance = _proximity.distance_max();
+            for (uint8_t i=0; i<PROXIMITY_MAX_DIRECTION; i++) {
+                // directions without a reading report the maximum
+                // distance, so only add those where something was seen
+                if (dist_array.distance[i] >= max_distance) {
+                    continue;
+                }
+                // orientations are 45 degree steps clockwise from forward
+                const float angle = _ahrs.yaw + radians(dist_array.orientation[i] * 45.0f);
+                const Vector2f dir(cosf(angle), sinf(angle));
+                _grid->push_return(position, dir, dist_array.distance[i], max_distance);
+            }
+        }
+    }
+
+    _grid->update(now);
+}
+
+/*
+ * Adjusts the desired velocity based on the proximity occupancy grid
+ */
+void AC_Avoid::adjust_velocity_proximity_grid(float kP, float accel_cmss, Vector2f &desired_vel)
+{
+    // keep the grid up to date even when not moving
+    update_proximity_grid();
+    if (_grid == nullptr) {
+        return;
+    }
+
+    // exit immediately if no desired velocity
+    if (desired_vel.is_zero()) {
+        return;
+    }
+
+    const Vector3f position_cm = _inav.get_position();
+    const Vector2f position(position_cm.x * 0.01f, position_cm.y * 0.01f);
+    const float margin_cm = MAX(_margin * 100.0f, 0);
+    const float half_angle = M_PI / AC_AVOID_GRID_SECTORS;
+
+    // limit velocity towards the closest object in each sector around the vehicle
+    for (uint8_t i=0; i<AC_AVOID_GRID_SECTORS; i++) {
+        const float angle = i * 2 * half_angle;
+        const Vector2f dir(cosf(angle), sinf(angle));
+        Vector2f closest;
+        float distance;
+        if (!_grid->cone_distance(position, dir, half_angle, _grid->half_width(), closest, distance)) {
+            continue;
+        }
+        Vector2f limit_direction = closest - position;
+        const float length = limit_direction.length();
+        if (is_zero(length)) {
+            // we are within an occupied cell, stop moving towards it
+            limit_direction = dir;
+        } else {
+            limit_direction /= length;
+        }
+        limit_velocity(kP, accel_cmss, desired_vel, limit_direction, MAX(distance * 100.0f - margin_cm, 0.0f));
+    }
+}
+
 /*
  * Adjusts the desired velocity for the polygon fence.
  */
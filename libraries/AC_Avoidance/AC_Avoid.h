@@ -9,6 +9,7 @@
 #include <AC_Fence/AC_Fence.h>         // Failsafe fence library
 #include <AP_Proximity/AP_Proximity.h>
 #include <AP_Beacon/AP_Beacon.h>
+#include "AC_Avoid_OccupancyGrid.h"
 
 #define AC_AVOID_ACCEL_CMSS_MAX         100.0f  // maximum acceleration/deceleration in cm/s/s used to avoid hitting fence
 
@@ -17,12 +18,18 @@
 #define AC_AVOID_STOP_AT_FENCE          1       // stop at fence
 #define AC_AVOID_USE_PROXIMITY_SENSOR   2       // stop based on proximity sensor output
 #define AC_AVOID_STOP_AT_BEACON_FENCE   4       // stop based on beacon perimeter
+#define AC_AVOID_USE_PROXIMITY_GRID     8       // stop based on proximity sensor output fused over time
 #define AC_AVOID_DEFAULT                (AC_AVOID_STOP_AT_FENCE | AC_AVOID_USE_PROXIMITY_SENSOR)
 
 // definitions for non-GPS avoidance
 #define AC_AVOID_NONGPS_DIST_MAX_DEFAULT    10.0f   // objects over 10m away are ignored (default value for DIST_MAX parameter)
 #define AC_AVOID_ANGLE_MAX_PERCENT          0.75f   // object avoidance max lean angle as a percentage (expressed in 0 ~ 1 range) of total vehicle max lean angle
 
+// definitions for the proximity occupancy grid
+#define AC_AVOID_GRID_FUSE_MS               50      // proximity sensor distances are added to the grid at 20hz
+#define AC_AVOID_GRID_SECTORS               8       // velocity is limited towards the closest object in this many directions
+#define AC_AVOID_GRID_SCAN_STEP_DEG         5       // closest of the proximity scan bins in each step is added to the grid
+
 /*
  * This class prevents the vehicle from leaving a polygon fence in
  * 2 dimensions by limiting velocity (adjust_velocity).
@@ -63,6 +70,11 @@ public:
     void proximity_avoidance_enable(bool on_off) { _proximity_enabled = on_off; }
     bool proximity_avoidance_enabled() { return _proximity_enabled; }
 
+    // occupancy grid built from the proximity sensor, nullptr unless
+    // AC_AVOID_USE_PROXIMITY_GRID is enabled. Positions are in meters
+    // from the EKF origin
+    AC_Avoid_OccupancyGrid *get_proximity_grid() { return _grid; }
+
     static const struct AP_Param::GroupInfo var_info[];
 
 private:
@@ -88,6 +100,16 @@ private:
      */
     void adjust_velocity_proximity(float kP, float accel_cmss, Vector2f &desired_vel);
 
+    /*
+     * Adjusts the desired velocity based on the proximity occupancy grid
+     */
+    void adjust_velocity_proximity_grid(float kP, float accel_cmss, Vector2f &desired_vel);
+
+    /*
+     * Adds the latest proximity sensor distances to the occupancy grid
+     */
+    void update_proximity_grid();
+
     /*
      * Adjusts the desired velocity given an array of boundary points
      *   earth_frame should be true if boundary is in earth-frame, false for body-frame
@@ -145,4 +167,8 @@ private:
     AP_Float _margin;           // vehicle will attempt to stay this distance (in meters) from objects while in GPS modes
 
     bool _proximity_enabled = true; // true if proximity sensor based avoidance is enabled (used to allow pilot to enable/disable)
+
+    // proximity occupancy grid
+    AC_Avoid_OccupancyGrid *_grid = nullptr;    // allocated when first used
+    uint32_t _grid_fuse_ms = 0;                 // system time proximity distances were last added
 };
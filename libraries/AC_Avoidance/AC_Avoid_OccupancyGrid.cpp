@@ -0,0 +1,393 @@
+#include "AC_Avoid_OccupancyGrid.h"
+
+AC_Avoid_OccupancyGrid::AC_Avoid_OccupancyGrid(float cell_size) :
+    _cell_size(cell_size),
+    _inv_cell_size(1.0f / cell_size),
+    _min_x(-AC_AVOID_GRID_SIZE / 2),
+    _min_y(-AC_AVOID_GRID_SIZE / 2),
+    _decay_row(0),
+    _returns(AC_AVOID_GRID_RETURNS_MAX)
+{
+    clear();
+}
+
+// forget all returns
+void AC_Avoid_OccupancyGrid::clear()
+{
+    memset(_confidence, 0, sizeof(_confidence));
+    memset(_occupied, 0, sizeof(_occupied));
+    memset(_decay_ms, 0, sizeof(_decay_ms));
+    _returns.clear();
+}
+
+void AC_Avoid_OccupancyGrid::clear_row(int32_t x)
+{
+    const uint8_t row = wrap(x);
+    memset(_confidence[row], 0, sizeof(_confidence[row]));
+    _occupied[row] = 0;
+}
+
+void AC_Avoid_OccupancyGrid::clear_column(int32_t y)
+{
+    const uint8_t col = wrap(y);
+    const uint64_t mask = ~(1ULL << col);
+    for (uint8_t row=0; row<AC_AVOID_GRID_SIZE; row++) {
+        _confidence[row][col] = 0;
+        _occupied[row] &= mask;
+    }
+}
+
+/*
+  move the grid to be centred on the vehicle, clearing the cells
+  which come into view. These share storage with the cells which have
+  just gone out of view on the other side
+ */
+void AC_Avoid_OccupancyGrid::set_center(const Vector2f &pos)
+{
+    const int32_t min_x = cell_coord(pos.x) - AC_AVOID_GRID_SIZE / 2;
+    const int32_t min_y = cell_coord(pos.y) - AC_AVOID_GRID_SIZE / 2;
+    const int32_t dx = min_x - _min_x;
+    const int32_t dy = min_y - _min_y;
+    if (dx == 0 && dy == 0) {
+        return;
+    }
+
+    if (abs(dx) >= AC_AVOID_GRID_SIZE || abs(dy) >= AC_AVOID_GRID_SIZE) {
+        // moved right off the grid
+        memset(_confidence, 0, sizeof(_confidence));
+        memset(_occupied, 0, sizeof(_occupied));
+    } else {
+        if (dx > 0) {
+            for (int32_t x=_min_x + AC_AVOID_GRID_SIZE; x<min_x + AC_AVOID_GRID_SIZE; x++) {
+                clear_row(x);
+            }
+        } else {
+            for (int32_t x=min_x; x<_min_x; x++) {
+                clear_row(x);
+            }
+        }
+        if (dy > 0) {
+            for (int32_t y=_min_y + AC_AVOID_GRID_SIZE; y<min_y + AC_AVOID_GRID_SIZE; y++) {
+                clear_column(y);
+            }
+        } else {
+            for (int32_t y=min_y; y<_min_y; y++) {
+                clear_column(y);
+            }
+        }
+    }
+    _min_x = min_x;
+    _min_y = min_y;
+}
+
+void AC_Avoid_OccupancyGrid::hit_cell(int32_t x, int32_t y)
+{
+    const uint8_t row = wrap(x);
+    const uint8_t col = wrap(y);
+    uint8_t &conf = _confidence[row][col];
+    conf = MIN(conf + AC_AVOID_GRID_HIT, 255);
+    if (conf >= AC_AVOID_GRID_OCCUPIED) {
+        _occupied[row] |= 1ULL << col;
+    }
+}
+
+void AC_Avoid_OccupancyGrid::miss_cell(int32_t x, int32_t y)
+{
+    const uint8_t row = wrap(x);
+    const uint8_t col = wrap(y);
+    uint8_t &conf = _confidence[row][col];
+    conf = (conf > AC_AVOID_GRID_MISS) ? conf - AC_AVOID_GRID_MISS : 0;
+    if (conf < AC_AVOID_GRID_OCCUPIED) {
+        _occupied[row] &= ~(1ULL << col);
+    }
+}
+
+/*
+  walk the cells along a segment, stepping into whichever of the next
+  row or column the segment reaches first
+ */
+template <typename Fn>
+bool AC_Avoid_OccupancyGrid::for_each_cell(const Vector2f &a, const Vector2f &b, Fn fn) const
+{
+    int32_t x = cell_coord(a.x);
+    int32_t y = cell_coord(a.y);
+    const int32_t end_x = cell_coord(b.x);
+    const int32_t end_y = cell_coord(b.y);
+    const Vector2f d = b - a;
+
+    const int8_t step_x = (d.x > 0) ? 1 : -1;
+    const int8_t step_y = (d.y > 0) ? 1 : -1;
+
+    // fraction of the segment to the next row or column boundary, and between boundaries
+    float t_next_x = FLT_MAX;
+    float t_delta_x = FLT_MAX;
+    if (!is_zero(d.x)) {
+        t_next_x = ((x + (step_x > 0 ? 1 : 0)) * _cell_size - a.x) / d.x;
+        t_delta_x = _cell_size / fabsf(d.x);
+    }
+    float t_next_y = FLT_MAX;
+    float t_delta_y = FLT_MAX;
+    if (!is_zero(d.y)) {
+        t_next_y = ((y + (step_y > 0 ? 1 : 0)) * _cell_size - a.y) / d.y;
+        t_delta_y = _cell_size / fabsf(d.y);
+    }
+
+    // rounding may put the last boundary just beyond the end, so count
+    // the steps rather than waiting to land on the end cell
+    uint32_t steps = abs(end_x - x) + abs(end_y - y);
+    float t = 0;
+    while (true) {
+        if (!fn(x, y, t)) {
+            return false;
+        }
+        if (steps-- == 0) {
+            break;
+        }
+        if (t_next_x < t_next_y) {
+            t = t_next_x;
+            x += step_x;
+            t_next_x += t_delta_x;
+        } else {
+            t = t_next_y;
+            y += step_y;
+            t_next_y += t_delta_y;
+        }
+    }
+    return true;
+}
+
+template <typename Fn>
+void AC_Avoid_OccupancyGrid::for_each_occupied(int32_t x_low, int32_t x_high, int32_t y_low, int32_t y_high, Fn fn) const
+{
+    x_low = MAX(x_low, _min_x);
+    x_high = MIN(x_high, _min_x + AC_AVOID_GRID_SIZE - 1);
+    y_low = MAX(y_low, _min_y);
+    y_high = MIN(y_high, _min_y + AC_AVOID_GRID_SIZE - 1);
+    if (x_low > x_high || y_low > y_high) {
+        return;
+    }
+
+    // the columns wanted as bits of a row, wrapping around the end of the word
+    const uint8_t span = y_high - y_low + 1;
+    uint64_t mask = (span == 64) ? ~0ULL : ((1ULL << span) - 1);
+    const uint8_t shift = wrap(y_low);
+    mask = (mask << shift) | (shift ? (mask >> (64 - shift)) : 0);
+
+    for (int32_t x=x_low; x<=x_high; x++) {
+        uint64_t bits = _occupied[wrap(x)] & mask;
+        while (bits != 0) {
+            const uint8_t col = __builtin_ctzll(bits);
+            bits &= bits - 1;
+            // the cell within the grid stored in this column
+            const int32_t y = _min_y + wrap(col - _min_y);
+            fn(x, y);
+        }
+    }
+}
+
+bool AC_Avoid_OccupancyGrid::push_return(const Vector2f &origin, const Vector2f &dir, float distance, float max_distance)
+{
+    Return r;
+    r.origin = origin;
+    r.hit = distance < max_distance;
+    r.end = origin + dir * MIN(distance, max_distance);
+    return _returns.push(r);
+}
+
+/*
+  lower the confidence of the cells a return passed through, raise it
+  for the cell it ended in
+ */
+void AC_Avoid_OccupancyGrid::fuse_return(const Vector2f &origin, const Vector2f &dir, float distance, float max_distance)
+{
+    const bool hit = distance < max_distance;
+    const Vector2f end = origin + dir * MIN(distance, max_distance);
+    const int32_t end_x = cell_coord(end.x);
+    const int32_t end_y = cell_coord(end.y);
+    for_each_cell(origin, end, [this, hit, end_x, end_y](int32_t x, int32_t y, float t) {
+        if (!in_window(x, y)) {
+            return true;
+        }
+        if (x == end_x && y == end_y) {
+            if (hit) {
+                hit_cell(x, y);
+            } else {
+                miss_cell(x, y);
+            }
+        } else {
+            miss_cell(x, y);
+        }
+        return true;
+    });
+}
+
+/*
+  fade AC_AVOID_GRID_DECAY_ROWS rows by the time since each was last
+  faded, so every row is faded every AC_AVOID_GRID_SIZE /
+  AC_AVOID_GRID_DECAY_ROWS updates
+ */
+void AC_Avoid_OccupancyGrid::decay(uint32_t now_ms)
+{
+    for (uint8_t i=0; i<AC_AVOID_GRID_DECAY_ROWS; i++) {
+        const uint8_t row = _decay_row;
+        _decay_row = (_decay_row + 1) % AC_AVOID_GRID_SIZE;
+
+        const uint32_t elapsed_ms = now_ms - _decay_ms[row];
+        uint32_t amount;
+        if (elapsed_ms >= 255 * 1000 / AC_AVOID_GRID_DECAY_PER_SEC) {
+            // long enough to clear every cell
+            amount = 255;
+            _decay_ms[row] = now_ms;
+        } else {
+            amount = elapsed_ms * AC_AVOID_GRID_DECAY_PER_SEC / 1000;
+            if (amount == 0) {
+                // keep the time so the remainder isn't lost
+                continue;
+            }
+            _decay_ms[row] += amount * 1000 / AC_AVOID_GRID_DECAY_PER_SEC;
+        }
+
+        uint8_t *conf = _confidence[row];
+        uint64_t occupied = 0;
+        for (uint8_t col=0; col<AC_AVOID_GRID_SIZE; col++) {
+            conf[col] = (conf[col] > amount) ? conf[col] - amount : 0;
+            if (conf[col] >= AC_AVOID_GRID_OCCUPIED) {
+                occupied |= 1ULL << col;
+            }
+        }
+        _occupied[row] = occupied;
+    }
+}
+
+void AC_Avoid_OccupancyGrid::update(uint32_t now_ms, uint16_t max_returns)
+{
+    Return r;
+    for (uint16_t i=0; i<max_returns && _returns.pop(r); i++) {
+        const Vector2f delta = r.end - r.origin;
+        const float distance = delta.length();
+        if (is_zero(distance)) {
+            continue;
+        }
+        fuse_return(r.origin, delta / distance, distance, r.hit ? FLT_MAX : distance);
+    }
+    decay(now_ms);
+}
+
+bool AC_Avoid_OccupancyGrid::occupied(const Vector2f &pos) const
+{
+    const int32_t x = cell_coord(pos.x);
+    const int32_t y = cell_coord(pos.y);
+    return in_window(x, y) && (_occupied[wrap(x)] & (1ULL << wrap(y))) != 0;
+}
+
+bool AC_Avoid_OccupancyGrid::ray_distance(const Vector2f &origin, const Vector2f &dir, float max_distance, float &distance) const
+{
+    bool found = false;
+    for_each_cell(origin, origin + dir * max_distance, [this, max_distance, &found, &distance](int32_t x, int32_t y, float t) {
+        if (in_window(x, y) && (_occupied[wrap(x)] & (1ULL << wrap(y)))) {
+            distance = t * max_distance;
+            found = true;
+            return false;
+        }
+        return true;
+    });
+    return found;
+}
+
+/*
+  look at the occupied cells within the bounding box of the cone,
+  taking the distance to each as the distance to its centre less half
+  a cell
+ */
+bool AC_Avoid_OccupancyGrid::cone_distance(const Vector2f &origin, const Vector2f &dir, float half_angle, float max_distance,
+                                           Vector2f &closest, float &distance) const
+{
+    const float cos_half_angle = cosf(half_angle);
+    const float cos_sq = sq(cos_half_angle);
+    const float half_cell = _cell_size * 0.5f;
+    bool found = false;
+    distance = max_distance;
+    float reject_sq = sq(max_distance + half_cell);
+
+    // bounding box of the cone, from its apex, the ends of its sides and
+    // the points of its arc furthest along each axis
+    Vector2f low = origin;
+    Vector2f high = origin;
+    if (half_angle < M_PI_2) {
+        const float s = sinf(half_angle);
+        const Vector2f side1(dir.x * cos_half_angle - dir.y * s, dir.x * s + dir.y * cos_half_angle);
+        const Vector2f side2(dir.x * cos_half_angle + dir.y * s, -dir.x * s + dir.y * cos_half_angle);
+        const Vector2f ends[2] = { origin + side1 * max_distance, origin + side2 * max_distance };
+        for (uint8_t i=0; i<2; i++) {
+            low.x = MIN(low.x, ends[i].x);
+            low.y = MIN(low.y, ends[i].y);
+            high.x = MAX(high.x, ends[i].x);
+            high.y = MAX(high.y, ends[i].y);
+        }
+        // an axis is within the cone if it is within half_angle of dir
+        if (dir.x >= cos_half_angle) {
+            high.x = origin.x + max_distance;
+        }
+        if (-dir.x >= cos_half_angle) {
+            low.x = origin.x - max_distance;
+        }
+        if (dir.y >= cos_half_angle) {
+            high.y = origin.y + max_distance;
+        }
+        if (-dir.y >= cos_half_angle) {
+            low.y = origin.y - max_distance;
+        }
+    } else {
+        low -= Vector2f(max_distance, max_distance);
+        high += Vector2f(max_distance, max_distance);
+    }
+
+    // cells overlapping the box may have their centre half a cell outside it
+    for_each_occupied(cell_coord(low.x - half_cell), cell_coord(high.x + half_cell),
+                      cell_coord(low.y - half_cell), cell_coord(high.y + half_cell),
+                      [&](int32_t x, int32_t y) {
+        const Vector2f center = cell_center(x, y);
+        const Vector2f delta = center - origin;
+        const float length_sq = delta.length_squared();
+        if (length_sq >= reject_sq) {
+            return;
+        }
+        // a cell we are within or touching is in every direction,
+        // otherwise check delta * dir >= length * cos_half_angle
+        if (length_sq > sq(half_cell)) {
+            const float along = delta * dir;
+            const bool inside = (cos_half_angle >= 0) ?
+                (along >= 0 && sq(along) >= length_sq * cos_sq) :
+                (along >= 0 || sq(along) <= length_sq * cos_sq);
+            if (!inside) {
+                return;
+            }
+        }
+        distance = MAX(sqrtf(length_sq) - half_cell, 0.0f);
+        reject_sq = sq(distance + half_cell);
+        closest = center;
+        found = true;
+    });
+    return found;
+}
+
+bool AC_Avoid_OccupancyGrid::path_clear(const Vector2f &start, const Vector2f &end, float radius) const
+{
+    // a cell is in the way if any part of it may be within radius
+    const float reach = radius + _cell_size * M_SQRT1_2;
+    const float reach_sq = sq(reach);
+    bool clear = true;
+
+    for_each_occupied(cell_coord(MIN(start.x, end.x) - reach), cell_coord(MAX(start.x, end.x) + reach),
+                      cell_coord(MIN(start.y, end.y) - reach), cell_coord(MAX(start.y, end.y) + reach),
+                      [&](int32_t x, int32_t y) {
+        if (!clear) {
+            return;
+        }
+        const Vector2f center = cell_center(x, y);
+        if ((Vector2f::closest_point(center, start, end) - center).length_squared() < reach_sq) {
+            clear = false;
+        }
+    });
+    return clear;
+}
@@ -0,0 +1,150 @@
+#pragma once
+
+#include <AP_Common/AP_Common.h>
+#include <AP_Math/AP_Math.h>
+#include <AP_HAL/utility/RingBuffer.h>
+
+#define AC_AVOID_GRID_SIZE              64      // cells along each side, a row of cells is one 64 bit word
+#define AC_AVOID_GRID_CELL_SIZE_DEFAULT 0.5f    // cell size in meters
+#define AC_AVOID_GRID_RETURNS_MAX       256     // returns queued between updates
+#define AC_AVOID_GRID_RETURNS_PER_UPDATE 32     // most returns fused by each update
+#define AC_AVOID_GRID_DECAY_ROWS        4       // rows decayed by each update
+
+// cell confidence, 0 is certainly free and 255 certainly occupied
+#define AC_AVOID_GRID_HIT               64      // added to a cell holding a return
+#define AC_AVOID_GRID_MISS              16      // taken from a cell a return passed through
+#define AC_AVOID_GRID_OCCUPIED          128     // cells at or above this are occupied
+#define AC_AVOID_GRID_DECAY_PER_SEC     32      // taken from every cell each second
+
+/*
+  Occupancy grid of the area around the vehicle, built up over time
+  from proximity sensor and rangefinder returns.
+
+  The grid is aligned with North and East and covers
+  AC_AVOID_GRID_SIZE cells along each side, centred on the vehicle.
+  Cells are addressed by their position modulo the grid size, so as
+  the vehicle moves the grid scrolls with it like a ring buffer: only
+  the rows and columns that come into view are cleared and nothing is
+  copied. Positions are in meters, normally North and East of the EKF
+  origin.
+
+  Each cell holds a confidence that it is occupied. A return raises it
+  for the cell it ends in and lowers it for the cells the beam passed
+  through, and every cell fades towards free over time so obstacles
+  that are no longer seen are forgotten. Cells above the occupied
+  threshold are also kept as one bit each in a word per row, which is
+  all the queries look at.
+
+  Returns are queued by push_return() and fused a few at a time by
+  update(), so a sensor producing thousands of returns a second can't
+  hold up the main loop. The queue may be pushed from another thread.
+ */
+class AC_Avoid_OccupancyGrid {
+public:
+    AC_Avoid_OccupancyGrid(float cell_size = AC_AVOID_GRID_CELL_SIZE_DEFAULT);
+
+    /* Do not allow copies */
+    AC_Avoid_OccupancyGrid(const AC_Avoid_OccupancyGrid &other) = delete;
+    AC_Avoid_OccupancyGrid &operator=(const AC_Avoid_OccupancyGrid&) = delete;
+
+    // forget all returns
+    void clear();
+
+    // move the grid to be centred on the vehicle position
+    void set_center(const Vector2f &pos);
+
+    // queue a return from a sensor at origin, along unit vector dir. If
+    // distance is below max_distance an object was seen at that
+    // distance, otherwise nothing was seen out to max_distance. Returns
+    // false if the queue is full
+    bool push_return(const Vector2f &origin, const Vector2f &dir, float distance, float max_distance);
+
+    // fuse up to max_returns queued returns and fade the cells, now_ms is the system time
+    void update(uint32_t now_ms, uint16_t max_returns = AC_AVOID_GRID_RETURNS_PER_UPDATE);
+
+    // fuse a return immediately rather than queueing it
+    void fuse_return(const Vector2f &origin, const Vector2f &dir, float distance, float max_distance);
+
+    // distance from origin along unit vector dir to the first occupied
+    // cell, returns false if there is none within max_distance
+    bool ray_distance(const Vector2f &origin, const Vector2f &dir, float max_distance, float &distance) const;
+
+    // closest occupied cell within half_angle radians of unit vector dir
+    // from origin. Returns false if there is none within max_distance
+    bool cone_distance(const Vector2f &origin, const Vector2f &dir, float half_angle, float max_distance,
+                       Vector2f &closest, float &distance) const;
+
+    // returns true if no occupied cell is within radius of the path from start to end
+    bool path_clear(const Vector2f &start, const Vector2f &end, float radius) const;
+
+    // true if the cell holding pos is occupied
+    bool occupied(const Vector2f &pos) const;
+
+    // cell size in meters and the distance from the centre to the edge of the grid
+    float cell_size() const { return _cell_size; }
+    float half_width() const { return _cell_size * (AC_AVOID_GRID_SIZE / 2); }
+
+    // number of returns waiting to be fused
+    uint32_t returns_queued() const { return _returns.available(); }
+
+private:
+
+    // a return waiting to be fused
+    struct Return {
+        Vector2f origin;
+        Vector2f end;
+        bool hit;
+    };
+
+    // cell holding a position
+    int32_t cell_coord(float v) const { return (int32_t)floorf(v * _inv_cell_size); }
+
+    // true if the cell is within the grid
+    bool in_window(int32_t x, int32_t y) const {
+        return (uint32_t)(x - _min_x) < AC_AVOID_GRID_SIZE && (uint32_t)(y - _min_y) < AC_AVOID_GRID_SIZE;
+    }
+
+    // row or column of the arrays holding a cell
+    static uint8_t wrap(int32_t v) { return (uint32_t)v & (AC_AVOID_GRID_SIZE - 1); }
+
+    // centre of a cell
+    Vector2f cell_center(int32_t x, int32_t y) const {
+        return Vector2f((x + 0.5f) * _cell_size, (y + 0.5f) * _cell_size);
+    }
+
+    // change the confidence of a cell within the grid
+    void hit_cell(int32_t x, int32_t y);
+    void miss_cell(int32_t x, int32_t y);
+
+    // clear cells scrolling into view
+    void clear_row(int32_t x);
+    void clear_column(int32_t y);
+
+    // fade AC_AVOID_GRID_DECAY_ROWS rows
+    void decay(uint32_t now_ms);
+
+    // call fn(x, y, t) for each cell the segment from a to b passes
+    // through in order, t being the fraction of the way along the
+    // segment where it enters the cell. fn returns false to stop early.
+    // Returns false if stopped
+    template <typename Fn>
+    bool for_each_cell(const Vector2f &a, const Vector2f &b, Fn fn) const;
+
+    // call fn(x, y) for each occupied cell in the rectangle of cells, clipped to the grid
+    template <typename Fn>
+    void for_each_occupied(int32_t x_low, int32_t x_high, int32_t y_low, int32_t y_high, Fn fn) const;
+
+    float       _cell_size;
+    float       _inv_cell_size;
+
+    // lowest cell within the grid
+    int32_t     _min_x;
+    int32_t     _min_y;
+
+    uint8_t     _confidence[AC_AVOID_GRID_SIZE][AC_AVOID_GRID_SIZE];   // by wrapped x then wrapped y
+    uint64_t    _occupied[AC_AVOID_GRID_SIZE];                         // bit wrapped y of word wrapped x
+    uint32_t    _decay_ms[AC_AVOID_GRID_SIZE];                         // system time each row was last faded
+    uint8_t     _decay_row;                                            // next row to fade
+
+    ObjectBuffer<Return> _returns;
+};
@@ -0,0 +1,98 @@
+#include <AP_gbenchmark.h>
+
+#include <AC_Avoidance/AC_Avoid_OccupancyGrid.h>
+
+/*
+  A scanning LIDAR in a room of walls and posts, 10m to 15m away,
+  producing 8000 returns a second. At 400Hz that is 20 returns for
+  each loop, which AC_Avoid fuses before limiting its velocity in
+  each of 8 directions
+ */
+
+#define RETURNS_PER_LOOP    20
+#define RANGE_MAX           40.0f
+
+static float wall_distance(float angle)
+{
+    // square room with a post every 60 degrees
+    const float to_wall = 12.0f / MAX(fabsf(cosf(angle)), fabsf(sinf(angle)));
+    const float post = fmodf(angle + M_2PI, radians(60));
+    return (post < radians(3)) ? to_wall * 0.6f : to_wall;
+}
+
+static void fill_grid(AC_Avoid_OccupancyGrid &grid)
+{
+    for (uint16_t i=0; i<3600; i++) {
+        const float angle = radians(i * 0.1f);
+        grid.fuse_return(Vector2f(), Vector2f(cosf(angle), sinf(angle)), wall_distance(angle), RANGE_MAX);
+    }
+}
+
+static void BM_GridFuse(benchmark::State& state)
+{
+    AC_Avoid_OccupancyGrid grid;
+    fill_grid(grid);
+    float angle = 0;
+    uint32_t now_ms = 0;
+    while (state.KeepRunning()) {
+        for (uint8_t i=0; i<RETURNS_PER_LOOP; i++) {
+            angle = wrap_2PI(angle + radians(0.9f));
+            grid.push_return(Vector2f(), Vector2f(cosf(angle), sinf(angle)), wall_distance(angle), RANGE_MAX);
+        }
+        grid.update(now_ms += 3, RETURNS_PER_LOOP);
+    }
+    state.SetItemsProcessed(state.iterations() * RETURNS_PER_LOOP);
+}
+
+static void BM_GridCone(benchmark::State& state)
+{
+    AC_Avoid_OccupancyGrid grid;
+    fill_grid(grid);
+    const Vector2f origin(1.2f, -0.7f);
+    while (state.KeepRunning()) {
+        for (uint8_t i=0; i<8; i++) {
+            const float angle = radians(i * 45.0f);
+            Vector2f closest;
+            float distance;
+            bool found = grid.cone_distance(origin, Vector2f(cosf(angle), sinf(angle)), radians(22.5f), grid.half_width(), closest, distance);
+            gbenchmark_escape(&found);
+            gbenchmark_escape(&distance);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * 8);
+}
+
+static void BM_GridRay(benchmark::State& state)
+{
+    AC_Avoid_OccupancyGrid grid;
+    fill_grid(grid);
+    float angle = 0;
+    while (state.KeepRunning()) {
+        angle = wrap_2PI(angle + 0.1f);
+        float distance;
+        bool found = grid.ray_distance(Vector2f(), Vector2f(cosf(angle), sinf(angle)), grid.half_width(), distance);
+        gbenchmark_escape(&found);
+        gbenchmark_escape(&distance);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+static void BM_GridPathClear(benchmark::State& state)
+{
+    AC_Avoid_OccupancyGrid grid;
+    fill_grid(grid);
+    float angle = 0;
+    while (state.KeepRunning()) {
+        angle = wrap_2PI(angle + 0.1f);
+        bool clear = grid.path_clear(Vector2f(), Vector2f(cosf(angle), sinf(angle)) * 8.0f, 1.0f);
+        gbenchmark_escape(&clear);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_GridFuse);
+BENCHMARK(BM_GridCone);
+BENCHMARK(BM_GridRay);
+BENCHMARK(BM_GridPathClear);
+
+BENCHMARK_MAIN()
@@ -0,0 +1,143 @@
+#include <AP_gtest.h>
+
+#include <AC_Avoidance/AC_Avoid_OccupancyGrid.h>
+
+// add the same return twice, enough to mark its cell occupied
+static void see(AC_Avoid_OccupancyGrid &grid, const Vector2f &origin, const Vector2f &point)
+{
+    Vector2f dir = point - origin;
+    const float distance = dir.length();
+    dir /= distance;
+    grid.fuse_return(origin, dir, distance, 20.0f);
+    grid.fuse_return(origin, dir, distance, 20.0f);
+}
+
+TEST(OccupancyGridTest, Ray)
+{
+    AC_Avoid_OccupancyGrid grid(0.5f);
+    const Vector2f origin(0.1f, 0.1f);
+    see(grid, origin, Vector2f(5.2f, 0.1f));
+    EXPECT_TRUE(grid.occupied(Vector2f(5.2f, 0.1f)));
+    EXPECT_FALSE(grid.occupied(Vector2f(4.7f, 0.1f)));
+
+    float distance;
+    EXPECT_TRUE(grid.ray_distance(origin, Vector2f(1, 0), 10.0f, distance));
+    // the ray enters the occupied cell at 5.0m
+    EXPECT_NEAR(4.9f, distance, 0.01f);
+    EXPECT_FALSE(grid.ray_distance(origin, Vector2f(0, 1), 10.0f, distance));
+    EXPECT_FALSE(grid.ray_distance(origin, Vector2f(1, 0), 4.0f, distance));
+}
+
+TEST(OccupancyGridTest, MissesClear)
+{
+    AC_Avoid_OccupancyGrid grid(0.5f);
+    const Vector2f origin;
+    see(grid, origin, Vector2f(3.2f, 0.2f));
+    EXPECT_TRUE(grid.occupied(Vector2f(3.2f, 0.2f)));
+
+    // the object has gone, later returns pass through its cell
+    for (uint8_t i=0; i<10; i++) {
+        grid.fuse_return(origin, Vector2f(1, 0), 8.2f, 20.0f);
+    }
+    EXPECT_FALSE(grid.occupied(Vector2f(3.2f, 0.2f)));
+    EXPECT_TRUE(grid.occupied(Vector2f(8.2f, 0.2f)));
+
+    // nothing seen out to the maximum distance
+    for (uint8_t i=0; i<10; i++) {
+        grid.fuse_return(origin, Vector2f(1, 0), 12.0f, 12.0f);
+    }
+    EXPECT_FALSE(grid.occupied(Vector2f(8.2f, 0.2f)));
+}
+
+TEST(OccupancyGridTest, Scroll)
+{
+    AC_Avoid_OccupancyGrid grid(0.5f);
+    const Vector2f object(10.2f, -3.1f);
+    see(grid, Vector2f(), object);
+
+    // objects stay put as the grid moves with the vehicle
+    grid.set_center(Vector2f(5.0f, 2.0f));
+    EXPECT_TRUE(grid.occupied(object));
+    grid.set_center(Vector2f(-5.0f, -7.0f));
+    EXPECT_TRUE(grid.occupied(object));
+
+    // out of view, the cell now stores a different position
+    grid.set_center(Vector2f(-10.0f, 0.0f));
+    EXPECT_FALSE(grid.occupied(object));
+    EXPECT_FALSE(grid.occupied(object - Vector2f(grid.half_width() * 2, 0)));
+    grid.set_center(Vector2f());
+    EXPECT_FALSE(grid.occupied(object));
+
+    // a cell coming into view on the other side starts free
+    see(grid, Vector2f(), Vector2f(-10.2f, 0.2f));
+    grid.set_center(Vector2f(20.0f, 0.0f));
+    EXPECT_FALSE(grid.occupied(Vector2f(-10.2f + grid.half_width() * 2, 0.2f)));
+}
+
+TEST(OccupancyGridTest, Cone)
+{
+    AC_Avoid_OccupancyGrid grid(0.5f);
+    const Vector2f origin;
+    see(grid, origin, Vector2f(4.2f, 1.2f));
+    see(grid, origin, Vector2f(-2.2f, 0.2f));
+
+    Vector2f closest;
+    float distance;
+    ASSERT_TRUE(grid.cone_distance(origin, Vector2f(1, 0), radians(22.5f), 10.0f, closest, distance));
+    EXPECT_NEAR(4.25f, closest.x, 0.01f);
+    EXPECT_NEAR(1.25f, closest.y, 0.01f);
+    EXPECT_NEAR(closest.length() - 0.25f, distance, 0.01f);
+
+    ASSERT_TRUE(grid.cone_distance(origin, Vector2f(-1, 0), radians(22.5f), 10.0f, closest, distance));
+    EXPECT_NEAR(-2.25f, closest.x, 0.01f);
+
+    EXPECT_FALSE(grid.cone_distance(origin, Vector2f(0, 1), radians(22.5f), 10.0f, closest, distance));
+    EXPECT_FALSE(grid.cone_distance(origin, Vector2f(1, 0), radians(5.0f), 10.0f, closest, distance));
+    EXPECT_FALSE(grid.cone_distance(origin, Vector2f(1, 0), radians(22.5f), 3.0f, closest, distance));
+
+    // all round, the closest is behind
+    ASSERT_TRUE(grid.cone_distance(origin, Vector2f(1, 0), M_PI, 10.0f, closest, distance));
+    EXPECT_NEAR(-2.25f, closest.x, 0.01f);
+}
+
+TEST(OccupancyGridTest, PathClear)
+{
+    AC_Avoid_OccupancyGrid grid(0.5f);
+    see(grid, Vector2f(), Vector2f(5.2f, 0.2f));
+
+    EXPECT_FALSE(grid.path_clear(Vector2f(), Vector2f(10, 0), 1.0f));
+    EXPECT_TRUE(grid.path_clear(Vector2f(), Vector2f(4, 0), 0.5f));
+    EXPECT_TRUE(grid.path_clear(Vector2f(0, 3), Vector2f(10, 3), 1.0f));
+    EXPECT_FALSE(grid.path_clear(Vector2f(0, 3), Vector2f(10, 3), 3.0f));
+}
+
+TEST(OccupancyGridTest, QueueAndDecay)
+{
+    AC_Avoid_OccupancyGrid grid(0.5f);
+    const Vector2f object(6.2f, 0.2f);
+    for (uint8_t i=0; i<4; i++) {
+        EXPECT_TRUE(grid.push_return(Vector2f(), Vector2f(1, 0), 6.2f, 20.0f));
+    }
+    EXPECT_EQ(4U, grid.returns_queued());
+
+    // returns are only fused by update, a few at a time
+    EXPECT_FALSE(grid.occupied(object));
+    grid.update(1000, 1);
+    EXPECT_FALSE(grid.occupied(object));
+    grid.update(1000, 3);
+    EXPECT_EQ(0U, grid.returns_queued());
+    EXPECT_TRUE(grid.occupied(object));
+
+    // fades away when no longer seen, once every row has been faded
+    uint32_t now = 1000;
+    for (uint16_t i=0; i<AC_AVOID_GRID_SIZE / AC_AVOID_GRID_DECAY_ROWS; i++) {
+        grid.update(now += 10);
+    }
+    EXPECT_TRUE(grid.occupied(object));
+    for (uint16_t i=0; i<AC_AVOID_GRID_SIZE * 10; i++) {
+        grid.update(now += 10);
+    }
+    EXPECT_FALSE(grid.occupied(object));
+}
+
+AP_GTEST_MAIN()
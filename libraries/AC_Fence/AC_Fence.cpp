@@ -233,7 +233,7 @@ uint8_t AC_Fence::check_fence(float curr_alt)
         } else if (_boundary_valid) {
             // check if vehicle is outside the polygon fence
             const Vector3f& position = _inav.get_position();
-            if (_poly_loader.boundary_breached(Vector2f(position.x, position.y), _boundary_num_points, _boundary, true)) {
+            if (polygon_breached(Vector2f(position.x, position.y))) {
                 // check if this is a new breach
                 if ((_breached_fences & AC_FENCE_TYPE_POLYGON) == 0) {
                     // record that we have breached the polygon
@@ -280,7 +280,7 @@ bool AC_Fence::check_destination_within_fence(const Location_Class& loc)
         if (_inav.get_location(temp_loc)) {
             const struct Location &ekf_origin = _inav.get_origin();
             Vector2f position = location_diff(ekf_origin, loc) * 100.0f;
-            if (_poly_loader.boundary_breached(position, _boundary_num_points, _boundary, true)) {
+            if (polygon_breached(position)) {
                 return false;
             }
         }
@@ -435,7 +435,7 @@ bool AC_Fence::load_polygon_from_eeprom(bool force_reload)
     if (!_inav.get_location(temp_loc)) {
         return false;
     }
-    const struct Location &ekf_origin = _inav.get_origin();
+    const LocalTangentFrame ekf_origin_frame(_inav.get_origin());
 
     // sanity check total
     _total = constrain_int16(_total, 0, _poly_loader.max_points());
@@ -448,7 +448,7 @@ bool AC_Fence::load_polygon_from_eeprom(bool force_reload)
         // move into location structure and convert to offset from ekf origin
         temp_loc.lat = temp_latlon.x;
         temp_loc.lng = temp_latlon.y;
-        _boundary[index] = location_diff(ekf_origin, temp_loc) * 100.0f;
+        _boundary[index] = ekf_origin_frame.ne(temp_loc) * 100.0f;
     }
     _boundary_num_points = _total;
     _boundary_loaded = true;
@@ -456,5 +456,26 @@ bool AC_Fence::load_polygon_from_eeprom(bool force_reload)
     // update validity of polygon
     _boundary_valid = _poly_loader.boundary_valid(_boundary_num_points, _boundary, true);
 
+    // index the polygon, skipping the return point
+    if (_zones == nullptr && _boundary_valid) {
+        _zones = new AC_Fence_Zones(1, 0);
+    }
+    if (_zones != nullptr) {
+        _zones->clear();
+        if (_boundary_valid && _zones->add_polygon(&_boundary[1], _boundary_num_points-1, AC_Fence_Zones::ZONE_INCLUSION)) {
+            _zones->build();
+        }
+    }
+
     return true;
 }
+
+/// returns true if position (offset from ekf origin in cm) is outside the polygon fence
+bool AC_Fence::polygon_breached(const Vector2f &position) const
+{
+    // use the indexed polygon if it is ready
+    if (_zones != nullptr && _zones->ready() && _zones->num_polygons() > 0) {
+        return _zones->breached(position);
+    }
+    return _poly_loader.boundary_breached(position, _boundary_num_points, _boundary, true);
+}
@@ -8,6 +8,7 @@
 #include <AP_AHRS/AP_AHRS.h>
 #include <AP_InertialNav/AP_InertialNav.h>     // Inertial Navigation library
 #include <AC_Fence/AC_PolyFence_loader.h>
+#include <AC_Fence/AC_Fence_Zones.h>
 #include <AP_Common/Location.h>
 
 // bit masks for enabled fence types.  Used for TYPE parameter
@@ -117,6 +118,9 @@ public:
     /// returns true if we've breached the polygon boundary.  simple passthrough to underlying _poly_loader object
     bool boundary_breached(const Vector2f& location, uint16_t num_points, const Vector2f* points) const;
 
+    /// returns the indexed polygon fence, nullptr if it has not been loaded
+    const AC_Fence_Zones* get_polygon_zones() const { return _zones; }
+
     /// handler for polygon fence messages with GCS
     void handle_msg(GCS_MAVLINK &link, mavlink_message_t* msg);
 
@@ -134,6 +138,9 @@ private:
     /// load polygon points stored in eeprom into boundary array and perform validation.  returns true if load successfully completed
     bool load_polygon_from_eeprom(bool force_reload = false);
 
+    /// returns true if position (offset from ekf origin in cm) is outside the polygon fence
+    bool polygon_breached(const Vector2f &position) const;
+
     // pointers to other objects we depend upon
     const AP_AHRS& _ahrs;
     const AP_InertialNav& _inav;
@@ -173,4 +180,5 @@ private:
     bool            _boundary_create_attempted = false; // true if we have attempted to create the boundary array
     bool            _boundary_loaded = false;       // true if boundary array has been loaded from eeprom
     bool            _boundary_valid = false;        // true if boundary forms a closed polygon
+    AC_Fence_Zones  *_zones = nullptr;              // polygon fence indexed for fast checks, created when a valid boundary is loaded
 };
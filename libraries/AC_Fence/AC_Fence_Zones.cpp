@@ -0,0 +1,535 @@
+#include "AC_Fence_Zones.h"
+
+AC_Fence_Zones::AC_Fence_Zones(uint8_t max_polygons, uint8_t max_circles)
+{
+    _max_polygons = MIN(max_polygons, AC_FENCE_ZONES_MAX_POLYGONS);
+    _max_circles = MIN(max_circles, AC_FENCE_ZONES_MAX_CIRCLES);
+    _polygons = _max_polygons > 0 ? new Polygon[_max_polygons] : nullptr;
+    _circles = _max_circles > 0 ? new Circle[_max_circles] : nullptr;
+    if (_polygons == nullptr) {
+        _max_polygons = 0;
+    }
+    if (_circles == nullptr) {
+        _max_circles = 0;
+    }
+}
+
+AC_Fence_Zones::~AC_Fence_Zones()
+{
+    clear();
+    delete[] _polygons;
+    delete[] _circles;
+}
+
+// remove all zones and free the index
+void AC_Fence_Zones::clear()
+{
+    delete[] _points;
+    delete[] _edge_next;
+    delete[] _slab_start;
+    delete[] _slab_edges;
+    delete[] _cell_start;
+    delete[] _cell_edges;
+    _points = nullptr;
+    _edge_next = nullptr;
+    _slab_start = nullptr;
+    _slab_edges = nullptr;
+    _cell_start = nullptr;
+    _cell_edges = nullptr;
+    _num_points = 0;
+    _points_size = 0;
+    _num_polygons = 0;
+    _num_circles = 0;
+    _grid_cols = 0;
+    _grid_rows = 0;
+    _ready = false;
+}
+
+// add a polygon of num_points vertices
+bool AC_Fence_Zones::add_polygon(const Vector2f *points, uint16_t num_points, ZoneType type)
+{
+    // drop the closing point, edges wrap around to the first vertex
+    if (points != nullptr && num_points > 1 && points[num_points-1] == points[0]) {
+        num_points--;
+    }
+    if (points == nullptr || num_points < 3 || _num_polygons >= _max_polygons ||
+        (uint32_t)_num_points + num_points > AC_FENCE_ZONES_MAX_POINTS) {
+        return false;
+    }
+
+    // grow the vertex arrays
+    if (_num_points + num_points > _points_size) {
+        const uint16_t new_size = MIN(MAX(_num_points + num_points, _points_size * 2), AC_FENCE_ZONES_MAX_POINTS);
+        Vector2f *new_points = new Vector2f[new_size];
+        uint16_t *new_edge_next = new uint16_t[new_size];
+        if (new_points == nullptr || new_edge_next == nullptr) {
+            delete[] new_points;
+            delete[] new_edge_next;
+            return false;
+        }
+        if (_num_points > 0) {
+            memcpy(new_points, _points, _num_points * sizeof(Vector2f));
+            memcpy(new_edge_next, _edge_next, _num_points * sizeof(uint16_t));
+        }
+        delete[] _points;
+        delete[] _edge_next;
+        _points = new_points;
+        _edge_next = new_edge_next;
+        _points_size = new_size;
+    }
+
+    Polygon &poly = _polygons[_num_polygons++];
+    poly.first_point = _num_points;
+    poly.num_points = num_points;
+    poly.type = type;
+    poly.min = points[0];
+    poly.max = points[0];
+    for (uint16_t i=0; i<num_points; i++) {
+        _points[_num_points + i] = points[i];
+        _edge_next[_num_points + i] = _num_points + ((i + 1 < num_points) ? i + 1 : 0);
+        poly.min.x = MIN(poly.min.x, points[i].x);
+        poly.min.y = MIN(poly.min.y, points[i].y);
+        poly.max.x = MAX(poly.max.x, points[i].x);
+        poly.max.y = MAX(poly.max.y, points[i].y);
+    }
+    _num_points += num_points;
+
+    _ready = false;
+    return true;
+}
+
+// add a circle
+bool AC_Fence_Zones::add_circle(const Vector2f &center, float radius, ZoneType type)
+{
+    if (_num_circles >= _max_circles || radius <= 0.0f) {
+        return false;
+    }
+    Circle &circle = _circles[_num_circles++];
+    circle.center = center;
+    circle.radius = radius;
+    circle.type = type;
+
+    _ready = false;
+    return true;
+}
+
+// build the index after adding zones
+bool AC_Fence_Zones::build()
+{
+    _ready = build_slabs() && build_grid();
+    return _ready;
+}
+
+// slab of polygon poly holding y
+uint16_t AC_Fence_Zones::slab_index(const Polygon &poly, float y) const
+{
+    const float f = (y - poly.min.y) * poly.slab_scale;
+    if (!(f > 0.0f)) {
+        return 0;
+    }
+    if (f >= poly.num_slabs) {
+        return poly.num_slabs - 1;
+    }
+    return (uint16_t)f;
+}
+
+/*
+  split each polygon into horizontal slabs, with about one slab per
+  vertex, and list the edges overlapping each slab
+ */
+bool AC_Fence_Zones::build_slabs()
+{
+    delete[] _slab_start;
+    delete[] _slab_edges;
+    _slab_edges = nullptr;
+
+    uint32_t num_slabs = 0;
+    for (uint8_t i=0; i<_num_polygons; i++) {
+        Polygon &poly = _polygons[i];
+        const float height = poly.max.y - poly.min.y;
+        poly.first_slab = num_slabs;
+        poly.num_slabs = is_positive(height) ? poly.num_points : 1;
+        poly.slab_scale = is_positive(height) ? poly.num_slabs / height : 0.0f;
+        num_slabs += poly.num_slabs;
+    }
+
+    _slab_start = new uint32_t[num_slabs + 1];
+    if (_slab_start == nullptr) {
+        return false;
+    }
+    memset(_slab_start, 0, (num_slabs + 1) * sizeof(uint32_t));
+
+    // count the edges of each slab, then turn the counts into start offsets
+    for (uint8_t i=0; i<_num_polygons; i++) {
+        const Polygon &poly = _polygons[i];
+        for (uint16_t e=poly.first_point; e<poly.first_point+poly.num_points; e++) {
+            const float y1 = _points[e].y;
+            const float y2 = _points[edge_end(e)].y;
+            const uint16_t s1 = slab_index(poly, MIN(y1, y2));
+            const uint16_t s2 = slab_index(poly, MAX(y1, y2));
+            for (uint16_t s=s1; s<=s2; s++) {
+                _slab_start[poly.first_slab + s + 1]++;
+            }
+        }
+    }
+    for (uint32_t s=0; s<num_slabs; s++) {
+        _slab_start[s+1] += _slab_start[s];
+    }
+
+    _slab_edges = new uint16_t[_slab_start[num_slabs]];
+    if (_slab_edges == nullptr) {
+        return false;
+    }
+
+    // fill the slabs, moving each start along as it is filled then back again
+    for (uint8_t i=0; i<_num_polygons; i++) {
+        const Polygon &poly = _polygons[i];
+        for (uint16_t e=poly.first_point; e<poly.first_point+poly.num_points; e++) {
+            const float y1 = _points[e].y;
+            const float y2 = _points[edge_end(e)].y;
+            const uint16_t s1 = slab_index(poly, MIN(y1, y2));
+            const uint16_t s2 = slab_index(poly, MAX(y1, y2));
+            for (uint16_t s=s1; s<=s2; s++) {
+                _slab_edges[_slab_start[poly.first_slab + s]++] = e;
+            }
+        }
+    }
+    for (uint32_t s=num_slabs; s>0; s--) {
+        _slab_start[s] = _slab_start[s-1];
+    }
+    _slab_start[0] = 0;
+
+    return true;
+}
+
+// grid cell column holding x, clamped to the grid
+uint16_t AC_Fence_Zones::grid_col(float x) const
+{
+    const float f = (x - _grid_min.x) / _grid_cell_size;
+    if (!(f > 0.0f)) {
+        return 0;
+    }
+    if (f >= _grid_cols) {
+        return _grid_cols - 1;
+    }
+    return (uint16_t)f;
+}
+
+// grid cell row holding y, clamped to the grid
+uint16_t AC_Fence_Zones::grid_row(float y) const
+{
+    const float f = (y - _grid_min.y) / _grid_cell_size;
+    if (!(f > 0.0f)) {
+        return 0;
+    }
+    if (f >= _grid_rows) {
+        return _grid_rows - 1;
+    }
+    return (uint16_t)f;
+}
+
+/*
+  call fn(cell) for each grid cell the segment from a to b passes
+  through. The outer rows and columns extend to infinity so a segment
+  leaving the grid is clamped onto its border cells
+ */
+template <typename Fn>
+bool AC_Fence_Zones::for_each_cell(const Vector2f &a, const Vector2f &b, Fn fn) const
+{
+    const float y_low = MIN(a.y, b.y);
+    const float y_high = MAX(a.y, b.y);
+    const float dy = b.y - a.y;
+    // widen each row's span slightly so rounding never misses a cell
+    const float margin = _grid_cell_size * 0.001f;
+
+    const uint16_t row_low = grid_row(y_low);
+    const uint16_t row_high = grid_row(y_high);
+    for (uint16_t row=row_low; row<=row_high; row++) {
+        // part of the segment within this row
+        float x1, x2;
+        if (is_zero(dy)) {
+            x1 = a.x;
+            x2 = b.x;
+        } else {
+            const float band_low = (row == row_low) ? y_low : _grid_min.y + row * _grid_cell_size;
+            const float band_high = (row == row_high) ? y_high : _grid_min.y + (row + 1) * _grid_cell_size;
+            x1 = a.x + (band_low - a.y) * (b.x - a.x) / dy;
+            x2 = a.x + (band_high - a.y) * (b.x - a.x) / dy;
+        }
+        const uint16_t col_low = grid_col(MIN(x1, x2) - margin);
+        const uint16_t col_high = grid_col(MAX(x1, x2) + margin);
+        for (uint16_t col=col_low; col<=col_high; col++) {
+            if (!fn(row * _grid_cols + col)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/*
+  put the edges of all polygons into a uniform grid with about one
+  cell per edge
+ */
+bool AC_Fence_Zones::build_grid()
+{
+    delete[] _cell_start;
+    delete[] _cell_edges;
+    _cell_start = nullptr;
+    _cell_edges = nullptr;
+    _grid_cols = 0;
+    _grid_rows = 0;
+
+    if (_num_points == 0) {
+        return true;
+    }
+
+    Vector2f grid_max = _points[0];
+    _grid_min = _points[0];
+    for (uint16_t i=1; i<_num_points; i++) {
+        _grid_min.x = MIN(_grid_min.x, _points[i].x);
+        _grid_min.y = MIN(_grid_min.y, _points[i].y);
+        grid_max.x = MAX(grid_max.x, _points[i].x);
+        grid_max.y = MAX(grid_max.y, _points[i].y);
+    }
+    const float width = grid_max.x - _grid_min.x;
+    const float height = grid_max.y - _grid_min.y;
+
+    // square cells, no more than AC_FENCE_ZONES_GRID_MAX along a side
+    _grid_cell_size = MAX(sqrtf(width * height / _num_points), MAX(width, height) / AC_FENCE_ZONES_GRID_MAX);
+    if (!is_positive(_grid_cell_size)) {
+        _grid_cell_size = 1.0f;
+    }
+    _grid_cols = MIN((uint16_t)(width / _grid_cell_size) + 1, AC_FENCE_ZONES_GRID_MAX);
+    _grid_rows = MIN((uint16_t)(height / _grid_cell_size) + 1, AC_FENCE_ZONES_GRID_MAX);
+    const uint32_t num_cells = _grid_cols * _grid_rows;
+
+    _cell_start = new uint32_t[num_cells + 1];
+    if (_cell_start == nullptr) {
+        return false;
+    }
+    memset(_cell_start, 0, (num_cells + 1) * sizeof(uint32_t));
+
+    // count the edges of each cell, then turn the counts into start offsets
+    for (uint16_t e=0; e<_num_points; e++) {
+        for_each_cell(_points[e], _points[edge_end(e)], [this](uint32_t cell) {
+            _cell_start[cell + 1]++;
+            return true;
+        });
+    }
+    for (uint32_t c=0; c<num_cells; c++) {
+        _cell_start[c+1] += _cell_start[c];
+    }
+
+    _cell_edges = new uint16_t[_cell_start[num_cells]];
+    if (_cell_edges == nullptr) {
+        return false;
+    }
+
+    // fill the cells, moving each start along as it is filled then back again
+    for (uint16_t e=0; e<_num_points; e++) {
+        for_each_cell(_points[e], _points[edge_end(e)], [this, e](uint32_t cell) {
+            _cell_edges[_cell_start[cell]++] = e;
+            return true;
+        });
+    }
+    for (uint32_t c=num_cells; c>0; c--) {
+        _cell_start[c] = _cell_start[c-1];
+    }
+    _cell_start[0] = 0;
+
+    return true;
+}
+
+// returns true if pos is outside polygon idx
+bool AC_Fence_Zones::polygon_outside(uint8_t idx, const Vector2f &pos) const
+{
+    if (idx >= _num_polygons) {
+        return true;
+    }
+    const Polygon &poly = _polygons[idx];
+
+    // no edge can be crossed from outside the bounding box
+    if (pos.x < poly.min.x || pos.x > poly.max.x || pos.y < poly.min.y || pos.y >= poly.max.y) {
+        return true;
+    }
+
+    // only edges spanning pos.y can be crossed, they are all in its slab
+    const uint32_t slab = poly.first_slab + slab_index(poly, pos.y);
+    bool outside = true;
+    for (uint32_t i=_slab_start[slab]; i<_slab_start[slab+1]; i++) {
+        const uint16_t e = _slab_edges[i];
+        // same vertex order as Polygon_outside()
+        if (Polygon_edge_crosses(pos, _points[edge_end(e)], _points[e])) {
+            outside = !outside;
+        }
+    }
+    return outside;
+}
+
+// returns true if pos is outside any inclusion zone or inside any exclusion zone
+bool AC_Fence_Zones::breached(const Vector2f &pos) const
+{
+    if (!_ready) {
+        return false;
+    }
+    for (uint8_t i=0; i<_num_circles; i++) {
+        const Circle &circle = _circles[i];
+        const bool inside = (pos - circle.center).length_squared() < sq(circle.radius);
+        if (inside == (circle.type == ZONE_EXCLUSION)) {
+            return true;
+        }
+    }
+    for (uint8_t i=0; i<_num_polygons; i++) {
+        const bool outside = polygon_outside(i, pos);
+        if (outside == (_polygons[i].type == ZONE_INCLUSION)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/*
+  find the closest point on any zone boundary to pos. Polygon edges are
+  searched one ring of grid cells at a time outwards from pos, stopping
+  once no unsearched cell can be closer than the best edge so far
+ */
+bool AC_Fence_Zones::closest_boundary(const Vector2f &pos, Vector2f &closest, float &distance) const
+{
+    if (!_ready || (_num_circles == 0 && _num_points == 0)) {
+        return false;
+    }
+
+    float best_dist_sq = FLT_MAX;
+
+    for (uint8_t i=0; i<_num_circles; i++) {
+        const Circle &circle = _circles[i];
+        const Vector2f ofs = pos - circle.center;
+        const float len = ofs.length();
+        const float dist = fabsf(len - circle.radius);
+        if (sq(dist) < best_dist_sq) {
+            best_dist_sq = sq(dist);
+            if (is_positive(len)) {
+                closest = circle.center + ofs * (circle.radius / len);
+            } else {
+                closest = circle.center + Vector2f(circle.radius, 0.0f);
+            }
+        }
+    }
+
+    if (_num_points > 0) {
+        const int16_t col0 = grid_col(pos.x);
+        const int16_t row0 = grid_row(pos.y);
+        const int16_t max_ring = MAX(_grid_cols, _grid_rows);
+        for (int16_t ring=0; ring<=max_ring; ring++) {
+            for (int16_t row=row0-ring; row<=row0+ring; row++) {
+                if (row < 0 || row >= _grid_rows) {
+                    continue;
+                }
+                // the first and last rows of the ring are full, the others just their ends
+                const int16_t col_step = (row == row0-ring || row == row0+ring) ? 1 : MAX(2*ring, 1);
+                for (int16_t col=col0-ring; col<=col0+ring; col+=col_step) {
+                    if (col < 0 || col >= _grid_cols) {
+                        continue;
+                    }
+                    const uint32_t cell = row * _grid_cols + col;
+                    for (uint32_t i=_cell_start[cell]; i<_cell_start[cell+1]; i++) {
+                        const uint16_t e = _cell_edges[i];
+                        const Vector2f point = Vector2f::closest_point(pos, _points[e], _points[edge_end(e)]);
+                        const float dist_sq = (point - pos).length_squared();
+                        if (dist_sq < best_dist_sq) {
+                            best_dist_sq = dist_sq;
+                            closest = point;
+                        }
+                    }
+                }
+            }
+            // cells outside this ring are at least ring cells away
+            if (best_dist_sq <= sq(ring * _grid_cell_size)) {
+                break;
+            }
+        }
+    }
+
+    distance = sqrtf(best_dist_sq);
+    return true;
+}
+
+/*
+  returns true if the segments a1-a2 and b1-b2 intersect. Touching and
+  collinear segments count as intersecting
+ */
+bool AC_Fence_Zones::segments_intersect(const Vector2f &a1, const Vector2f &a2, const Vector2f &b1, const Vector2f &b2)
+{
+    const Vector2f a = a2 - a1;
+    const Vector2f b = b2 - b1;
+    const float d1 = b % (a1 - b1);
+    const float d2 = b % (a2 - b1);
+    if ((d1 > 0.0f && d2 > 0.0f) || (d1 < 0.0f && d2 < 0.0f)) {
+        return false;
+    }
+    const float d3 = a % (b1 - a1);
+    const float d4 = a % (b2 - a1);
+    if ((d3 > 0.0f && d4 > 0.0f) || (d3 < 0.0f && d4 < 0.0f)) {
+        return false;
+    }
+    return true;
+}
+
+// returns true if the segment from start to end crosses a zone boundary
+bool AC_Fence_Zones::segment_crosses_boundary(const Vector2f &start, const Vector2f &end) const
+{
+    // with both ends allowed only passing through an exclusion circle can breach a circle
+    for (uint8_t i=0; i<_num_circles; i++) {
+        const Circle &circle = _circles[i];
+        if (circle.type == ZONE_EXCLUSION &&
+            (Vector2f::closest_point(circle.center, start, end) - circle.center).length_squared() < sq(circle.radius)) {
+            return true;
+        }
+    }
+
+    if (_num_points == 0) {
+        return false;
+    }
+    return !for_each_cell(start, end, [this, &start, &end](uint32_t cell) {
+        for (uint32_t i=_cell_start[cell]; i<_cell_start[cell+1]; i++) {
+            const uint16_t e = _cell_edges[i];
+            if (segments_intersect(start, end, _points[e], _points[edge_end(e)])) {
+                return false;
+            }
+        }
+        return true;
+    });
+}
+
+// returns true if a straight path from start to end never breaches a zone
+bool AC_Fence_Zones::segment_clear(const Vector2f &start, const Vector2f &end) const
+{
+    if (!_ready) {
+        return true;
+    }
+    return !breached(start) && !breached(end) && !segment_crosses_boundary(start, end);
+}
+
+// check each segment of a path, returns true if every segment is clear
+bool AC_Fence_Zones::path_clear(const Vector2f *path, uint16_t num_points, bool *clear) const
+{
+    bool all_clear = true;
+    if (num_points < 2) {
+        return all_clear;
+    }
+    if (!_ready) {
+        memset(clear, 1, (num_points - 1) * sizeof(bool));
+        return all_clear;
+    }
+
+    // each point ends one segment and starts the next, so is only checked once
+    bool start_breached = breached(path[0]);
+    for (uint16_t i=0; i<num_points-1; i++) {
+        const bool end_breached = breached(path[i+1]);
+        clear[i] = !start_breached && !end_breached && !segment_crosses_boundary(path[i], path[i+1]);
+        all_clear &= clear[i];
+        start_breached = end_breached;
+    }
+    return all_clear;
+}
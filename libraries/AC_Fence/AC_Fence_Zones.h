@@ -0,0 +1,163 @@
+#pragma once
+
+#include <AP_Common/AP_Common.h>
+#include <AP_Math/AP_Math.h>
+
+// limits on the number of zones
+#define AC_FENCE_ZONES_MAX_POLYGONS     100     // most inclusion and exclusion polygons
+#define AC_FENCE_ZONES_MAX_CIRCLES      32      // most inclusion and exclusion circles
+#define AC_FENCE_ZONES_MAX_POINTS       16384   // most vertices over all polygons
+
+// size of the edge grid used for closest edge and path checks
+#define AC_FENCE_ZONES_GRID_MAX         128     // most cells along each side of the grid
+
+/*
+  Holds many inclusion and exclusion zones, polygons or circles, and
+  indexes their edges so a check doesn't have to walk every vertex.
+
+  A position is breached when it is outside any inclusion zone or
+  inside any exclusion zone. All positions use the same North/East
+  units, normally cm from the EKF origin as used by AC_Fence.
+
+  Each polygon splits its vertical extent into horizontal slabs, each
+  holding the edges that overlap it. The crossing test only needs the
+  edges spanning the point's y, so containment looks at one slab and
+  gives the same answer as Polygon_outside(). A uniform grid over all
+  polygon edges answers closest edge and path segment queries, looking
+  only at the cells around the point or along the segment.
+
+  Zones are added with add_polygon() and add_circle(), then build()
+  must be called before any query. Adding a zone invalidates the index.
+  Room for the zones is allocated at construction, so a single polygon
+  fence costs a single polygon. Vertices and the index are allocated
+  as zones are added and built, sized to the zones loaded.
+ */
+class AC_Fence_Zones
+{
+public:
+
+    enum ZoneType {
+        ZONE_INCLUSION = 0,     // vehicle must stay inside
+        ZONE_EXCLUSION = 1,     // vehicle must stay outside
+    };
+
+    // room for max_polygons polygons and max_circles circles, no more
+    // than AC_FENCE_ZONES_MAX_POLYGONS and AC_FENCE_ZONES_MAX_CIRCLES
+    AC_Fence_Zones(uint8_t max_polygons, uint8_t max_circles);
+    ~AC_Fence_Zones();
+
+    /* Do not allow copies */
+    AC_Fence_Zones(const AC_Fence_Zones &other) = delete;
+    AC_Fence_Zones &operator=(const AC_Fence_Zones&) = delete;
+
+    // remove all zones and free the index
+    void clear();
+
+    // add a polygon of num_points vertices. The polygon may be closed
+    // (last point equal to the first) or not. Returns false if it has
+    // fewer than 3 vertices or the limits are reached
+    bool add_polygon(const Vector2f *points, uint16_t num_points, ZoneType type);
+
+    // add a circle, returns false if the limit is reached
+    bool add_circle(const Vector2f &center, float radius, ZoneType type);
+
+    // build the index after adding zones, returns false if memory could not be allocated
+    bool build();
+
+    // true if the index has been built and no zone added since
+    bool ready() const { return _ready; }
+
+    uint8_t num_polygons() const { return _num_polygons; }
+    uint8_t num_circles() const { return _num_circles; }
+    uint16_t num_points() const { return _num_points; }
+
+    // returns true if pos is outside any inclusion zone or inside any exclusion zone
+    bool breached(const Vector2f &pos) const;
+
+    // returns true if pos is outside polygon idx
+    bool polygon_outside(uint8_t idx, const Vector2f &pos) const;
+
+    // find the closest point on any zone boundary to pos
+    // returns false if there are no zones
+    bool closest_boundary(const Vector2f &pos, Vector2f &closest, float &distance) const;
+
+    // returns true if a straight path from start to end never breaches a zone
+    bool segment_clear(const Vector2f &start, const Vector2f &end) const;
+
+    // check each segment of a path of num_points points, clear[i] is
+    // set for the segment from path[i] to path[i+1]. Returns true if
+    // every segment is clear
+    bool path_clear(const Vector2f *path, uint16_t num_points, bool *clear) const;
+
+private:
+
+    struct Polygon {
+        uint16_t first_point;       // index of first vertex in _points
+        uint16_t num_points;        // number of vertices, not closed
+        ZoneType type;
+        Vector2f min;               // bounding box
+        Vector2f max;
+        uint32_t first_slab;        // index of first slab in _slab_start
+        uint16_t num_slabs;
+        float slab_scale;           // slabs per unit of y
+    };
+
+    struct Circle {
+        Vector2f center;
+        float radius;
+        ZoneType type;
+    };
+
+    // edge e runs from _points[e] to the next vertex of its polygon
+    uint16_t edge_end(uint16_t e) const { return _edge_next[e]; }
+
+    // slab of polygon poly holding y
+    uint16_t slab_index(const Polygon &poly, float y) const;
+
+    // grid cell column and row holding a position, clamped to the grid
+    uint16_t grid_col(float x) const;
+    uint16_t grid_row(float y) const;
+
+    // call fn(cell) for each grid cell the segment from a to b passes through,
+    // fn returns false to stop early. Returns false if stopped
+    template <typename Fn>
+    bool for_each_cell(const Vector2f &a, const Vector2f &b, Fn fn) const;
+
+    // build the slabs of each polygon and the edge grid
+    bool build_slabs();
+    bool build_grid();
+
+    // returns true if the segment from start to end crosses a zone boundary
+    bool segment_crosses_boundary(const Vector2f &start, const Vector2f &end) const;
+
+    // returns true if the segments a1-a2 and b1-b2 intersect
+    static bool segments_intersect(const Vector2f &a1, const Vector2f &a2, const Vector2f &b1, const Vector2f &b2);
+
+    // zones
+    Polygon     *_polygons = nullptr;
+    uint8_t     _max_polygons = 0;
+    uint8_t     _num_polygons = 0;
+    Circle      *_circles = nullptr;
+    uint8_t     _max_circles = 0;
+    uint8_t     _num_circles = 0;
+
+    // vertices of all polygons and the vertex following each one
+    Vector2f    *_points = nullptr;
+    uint16_t    *_edge_next = nullptr;
+    uint16_t    _num_points = 0;
+    uint16_t    _points_size = 0;
+
+    // slabs of all polygons, the edges of slab s are _slab_edges[_slab_start[s]] up to _slab_edges[_slab_start[s+1]]
+    uint32_t    *_slab_start = nullptr;
+    uint16_t    *_slab_edges = nullptr;
+
+    // edge grid, the edges of cell c are _cell_edges[_cell_start[c]] up to _cell_edges[_cell_start[c+1]]
+    uint32_t    *_cell_start = nullptr;
+    uint16_t    *_cell_edges = nullptr;
+    Vector2f    _grid_min;
+    float       _grid_cell_size = 1.0f;
+    uint16_t    _grid_cols = 0;
+    uint16_t    _grid_rows = 0;
+
+    bool        _ready = false;
+};
@@ -0,0 +1,167 @@
+#include <AP_gbenchmark.h>
+
+#include <AC_Fence/AC_Fence_Zones.h>
+
+/*
+  an inclusion polygon of 2000 vertices holding 80 exclusion polygons of
+  100 vertices each, 10000 vertices in all. Positions are in cm as used
+  by AC_Fence. Each check is timed with the zone index and by walking
+  every polygon as the single polygon fence does
+ */
+
+#define NUM_EXCLUSIONS      80
+#define INCLUSION_POINTS    2000
+#define EXCLUSION_POINTS    100
+#define NUM_QUERIES         1024
+#define PATH_POINTS         20
+
+static Vector2f inclusion[INCLUSION_POINTS];
+static Vector2f exclusions[NUM_EXCLUSIONS][EXCLUSION_POINTS];
+static Vector2f queries[NUM_QUERIES];
+static AC_Fence_Zones zones(NUM_EXCLUSIONS + 1, 0);
+
+// wavy ring of num_points vertices
+static void make_polygon(Vector2f *points, uint16_t num_points, const Vector2f &center, float radius, uint8_t waves)
+{
+    for (uint16_t i=0; i<num_points; i++) {
+        const float angle = i * M_2PI / num_points;
+        const float r = radius * (1.0f + 0.2f * sinf(waves * angle));
+        points[i] = center + Vector2f(cosf(angle), sinf(angle)) * r;
+    }
+}
+
+static void setup_zones()
+{
+    if (zones.ready()) {
+        return;
+    }
+    make_polygon(inclusion, INCLUSION_POINTS, Vector2f(0, 0), 500000, 7);
+    zones.add_polygon(inclusion, INCLUSION_POINTS, AC_Fence_Zones::ZONE_INCLUSION);
+    for (uint8_t i=0; i<NUM_EXCLUSIONS; i++) {
+        const Vector2f center((i % 9) * 80000.0f - 320000, (i / 9) * 80000.0f - 320000);
+        make_polygon(exclusions[i], EXCLUSION_POINTS, center, 15000, 5);
+        zones.add_polygon(exclusions[i], EXCLUSION_POINTS, AC_Fence_Zones::ZONE_EXCLUSION);
+    }
+    zones.build();
+
+    // points spread over the inclusion polygon and a little beyond
+    for (uint16_t i=0; i<NUM_QUERIES; i++) {
+        queries[i] = Vector2f(cosf(i * 0.37f), sinf(i * 0.61f)) * (i * 600.0f);
+    }
+}
+
+// breach check walking every polygon
+static bool breached_linear(const Vector2f &pos)
+{
+    if (Polygon_outside(pos, inclusion, INCLUSION_POINTS)) {
+        return true;
+    }
+    for (uint8_t i=0; i<NUM_EXCLUSIONS; i++) {
+        if (!Polygon_outside(pos, exclusions[i], EXCLUSION_POINTS)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// closest edge walking every polygon
+static float closest_distance(const Vector2f &pos, const Vector2f *points, uint16_t num_points, float best)
+{
+    for (uint16_t i=0; i<num_points; i++) {
+        const Vector2f &next = points[(i + 1 < num_points) ? i + 1 : 0];
+        best = MIN(best, (Vector2f::closest_point(pos, points[i], next) - pos).length());
+    }
+    return best;
+}
+
+static float closest_linear(const Vector2f &pos)
+{
+    float best = closest_distance(pos, inclusion, INCLUSION_POINTS, FLT_MAX);
+    for (uint8_t i=0; i<NUM_EXCLUSIONS; i++) {
+        best = closest_distance(pos, exclusions[i], EXCLUSION_POINTS, best);
+    }
+    return best;
+}
+
+static void BM_BreachedLinear(benchmark::State& state)
+{
+    setup_zones();
+    uint16_t i = 0;
+    while (state.KeepRunning()) {
+        bool breached = breached_linear(queries[i++ % NUM_QUERIES]);
+        gbenchmark_escape(&breached);
+    }
+}
+
+static void BM_BreachedZones(benchmark::State& state)
+{
+    setup_zones();
+    uint16_t i = 0;
+    while (state.KeepRunning()) {
+        bool breached = zones.breached(queries[i++ % NUM_QUERIES]);
+        gbenchmark_escape(&breached);
+    }
+}
+
+static void BM_ClosestLinear(benchmark::State& state)
+{
+    setup_zones();
+    uint16_t i = 0;
+    while (state.KeepRunning()) {
+        float distance = closest_linear(queries[i++ % NUM_QUERIES]);
+        gbenchmark_escape(&distance);
+    }
+}
+
+static void BM_ClosestZones(benchmark::State& state)
+{
+    setup_zones();
+    uint16_t i = 0;
+    while (state.KeepRunning()) {
+        Vector2f closest;
+        float distance;
+        zones.closest_boundary(queries[i++ % NUM_QUERIES], closest, distance);
+        gbenchmark_escape(&distance);
+    }
+}
+
+// a path of PATH_POINTS points, each segment about 150m long
+static void BM_PathZones(benchmark::State& state)
+{
+    setup_zones();
+    Vector2f path[PATH_POINTS];
+    bool clear[PATH_POINTS];
+    uint16_t i = 0;
+    while (state.KeepRunning()) {
+        for (uint8_t p=0; p<PATH_POINTS; p++) {
+            path[p] = queries[i % NUM_QUERIES] + Vector2f(p * 15000.0f, (p & 1) * 5000.0f);
+        }
+        i++;
+        zones.path_clear(path, PATH_POINTS, clear);
+        gbenchmark_escape(clear);
+    }
+    state.SetItemsProcessed(state.iterations() * (PATH_POINTS - 1));
+}
+
+static void BM_Build(benchmark::State& state)
+{
+    setup_zones();
+    AC_Fence_Zones z(NUM_EXCLUSIONS + 1, 0);
+    while (state.KeepRunning()) {
+        z.clear();
+        z.add_polygon(inclusion, INCLUSION_POINTS, AC_Fence_Zones::ZONE_INCLUSION);
+        for (uint8_t i=0; i<NUM_EXCLUSIONS; i++) {
+            z.add_polygon(exclusions[i], EXCLUSION_POINTS, AC_Fence_Zones::ZONE_EXCLUSION);
+        }
+        z.build();
+    }
+}
+
+BENCHMARK(BM_BreachedLinear);
+BENCHMARK(BM_BreachedZones);
+BENCHMARK(BM_ClosestLinear);
+BENCHMARK(BM_ClosestZones);
+BENCHMARK(BM_PathZones);
+BENCHMARK(BM_Build);
+
+BENCHMARK_MAIN()
@@ -0,0 +1,138 @@
+#include <AP_gtest.h>
+
+#include <AC_Fence/AC_Fence_Zones.h>
+
+/*
+  the zone index must give the same containment answer as walking the
+  polygon with Polygon_outside(), for any polygon and point
+ */
+
+#define NUM_POLYGONS    40
+#define MAX_POINTS      300
+#define NUM_QUERIES     2000
+
+static uint32_t seed = 1;
+
+static float rand_float(float lo, float hi)
+{
+    seed = seed * 1103515245 + 12345;
+    return lo + (hi - lo) * ((seed >> 8) & 0xFFFF) / 65535.0f;
+}
+
+// star shaped polygon, or random vertices which may cross each other
+static uint16_t make_polygon(Vector2f *points, const Vector2f &center, float radius, bool star)
+{
+    const uint16_t num_points = 3 + (uint16_t)rand_float(0, MAX_POINTS - 3);
+    for (uint16_t i=0; i<num_points; i++) {
+        if (star) {
+            const float angle = i * M_2PI / num_points;
+            points[i] = center + Vector2f(cosf(angle), sinf(angle)) * rand_float(0.2f, 1.0f) * radius;
+        } else {
+            points[i] = center + Vector2f(rand_float(-radius, radius), rand_float(-radius, radius));
+        }
+    }
+    return num_points;
+}
+
+// random points around the polygon, with some on its vertices or level with them
+static Vector2f make_query(const Vector2f *points, uint16_t num_points, const Vector2f &center, float radius)
+{
+    const uint16_t v = (uint16_t)rand_float(0, num_points - 1);
+    switch ((uint8_t)rand_float(0, 3.99f)) {
+    case 0:
+        return points[v];
+    case 1:
+        return Vector2f(rand_float(-1.2f, 1.2f) * radius + center.x, points[v].y);
+    default:
+        return center + Vector2f(rand_float(-1.2f, 1.2f), rand_float(-1.2f, 1.2f)) * radius;
+    }
+}
+
+TEST(AC_Fence_Zones, PolygonOutsideMatches)
+{
+    static Vector2f points[MAX_POINTS];
+    uint32_t mismatches = 0;
+    for (uint8_t p=0; p<NUM_POLYGONS; p++) {
+        const Vector2f center(rand_float(-1e6f, 1e6f), rand_float(-1e6f, 1e6f));
+        const float radius = rand_float(100, 50000);
+        const uint16_t num_points = make_polygon(points, center, radius, p % 2 == 0);
+
+        AC_Fence_Zones zones(1, 0);
+        ASSERT_TRUE(zones.add_polygon(points, num_points, AC_Fence_Zones::ZONE_INCLUSION));
+        ASSERT_TRUE(zones.build());
+        for (uint16_t q=0; q<NUM_QUERIES; q++) {
+            const Vector2f pos = make_query(points, num_points, center, radius);
+            const bool outside = Polygon_outside(pos, points, num_points);
+            mismatches += zones.polygon_outside(0, pos) != outside;
+            mismatches += zones.breached(pos) != outside;
+        }
+    }
+    EXPECT_EQ(0U, mismatches);
+}
+
+// the closing point is dropped without changing the answer
+TEST(AC_Fence_Zones, ClosedPolygonMatches)
+{
+    static Vector2f points[MAX_POINTS + 1];
+    const Vector2f center(0, 0);
+    const uint16_t num_points = make_polygon(points, center, 1000, true);
+    points[num_points] = points[0];
+
+    AC_Fence_Zones zones(1, 0);
+    ASSERT_TRUE(zones.add_polygon(points, num_points + 1, AC_Fence_Zones::ZONE_INCLUSION));
+    ASSERT_TRUE(zones.build());
+    EXPECT_EQ(num_points, zones.num_points());
+    for (uint16_t q=0; q<NUM_QUERIES; q++) {
+        const Vector2f pos = make_query(points, num_points, center, 1000);
+        EXPECT_EQ(Polygon_outside(pos, points, num_points + 1), zones.polygon_outside(0, pos));
+    }
+}
+
+// an inclusion polygon holding exclusion polygons against walking each one
+TEST(AC_Fence_Zones, BreachedMatches)
+{
+    static Vector2f inclusion[MAX_POINTS];
+    static Vector2f exclusions[NUM_POLYGONS][MAX_POINTS];
+    uint16_t exclusion_points[NUM_POLYGONS];
+
+    AC_Fence_Zones zones(NUM_POLYGONS + 1, 0);
+    const uint16_t inclusion_points = make_polygon(inclusion, Vector2f(0, 0), 100000, true);
+    ASSERT_TRUE(zones.add_polygon(inclusion, inclusion_points, AC_Fence_Zones::ZONE_INCLUSION));
+    for (uint8_t i=0; i<NUM_POLYGONS; i++) {
+        const Vector2f center(rand_float(-60000, 60000), rand_float(-60000, 60000));
+        exclusion_points[i] = make_polygon(exclusions[i], center, 8000, i % 2 == 0);
+        ASSERT_TRUE(zones.add_polygon(exclusions[i], exclusion_points[i], AC_Fence_Zones::ZONE_EXCLUSION));
+    }
+    ASSERT_TRUE(zones.build());
+
+    uint32_t mismatches = 0;
+    for (uint16_t q=0; q<NUM_QUERIES * 10; q++) {
+        const uint8_t i = (uint8_t)rand_float(0, NUM_POLYGONS - 1);
+        const Vector2f pos = q % 2 ? make_query(exclusions[i], exclusion_points[i], exclusions[i][0], 8000) :
+                                     make_query(inclusion, inclusion_points, Vector2f(0, 0), 100000);
+        bool breached = Polygon_outside(pos, inclusion, inclusion_points);
+        for (uint8_t e=0; e<NUM_POLYGONS && !breached; e++) {
+            breached = !Polygon_outside(pos, exclusions[e], exclusion_points[e]);
+        }
+        mismatches += zones.breached(pos) != breached;
+    }
+    EXPECT_EQ(0U, mismatches);
+}
+
+// zones beyond the room given at construction are refused
+TEST(AC_Fence_Zones, Capacity)
+{
+    const Vector2f square[4] = { Vector2f(0, 0), Vector2f(10, 0), Vector2f(10, 10), Vector2f(0, 10) };
+
+    AC_Fence_Zones zones(1, 0);
+    EXPECT_TRUE(zones.add_polygon(square, 4, AC_Fence_Zones::ZONE_INCLUSION));
+    EXPECT_FALSE(zones.add_polygon(square, 4, AC_Fence_Zones::ZONE_EXCLUSION));
+    EXPECT_FALSE(zones.add_circle(Vector2f(5, 5), 1, AC_Fence_Zones::ZONE_EXCLUSION));
+
+    // clearing keeps the room
+    zones.clear();
+    EXPECT_TRUE(zones.add_polygon(square, 4, AC_Fence_Zones::ZONE_INCLUSION));
+    EXPECT_EQ(1U, zones.num_polygons());
+}
+
+AP_GTEST_MAIN()
@@ -0,0 +1,141 @@
+#include "AC_SCurve.h"
+
+// iterations used to find the peak speed of short tracks
+#define AC_SCURVE_SEARCH_STEPS  20
+
+/// init - plan a move of length_cm starting at speed_start_cms and ending at rest
+void AC_SCurve::init(float length_cm, float speed_start_cms, float speed_cms, float accel_cmss, float jerk_cmsss)
+{
+    clear();
+    _length = MAX(length_cm, 0.0f);
+
+    // there is nowhere to go
+    if (!is_positive(_length)) {
+        return;
+    }
+
+    // without valid limits the target can not move, hold it at the start of the track until
+    // the profile is planned again rather than letting it jump to the end
+    if (!is_positive(speed_cms) || !is_positive(accel_cmss) || !is_positive(jerk_cmsss)) {
+        for (uint8_t i=0; i<NUM_PHASES; i++) {
+            _time_end[i] = FLT_MAX;
+        }
+        return;
+    }
+
+    // reduce the starting speed if we could not otherwise stop by the end of the track
+    float speed_start = MAX(speed_start_cms, 0.0f);
+    if (speed_change_dist(speed_start, 0.0f, accel_cmss, jerk_cmsss) > _length) {
+        float low = 0.0f;
+        float high = speed_start;
+        for (uint8_t i=0; i<AC_SCURVE_SEARCH_STEPS; i++) {
+            const float mid = 0.5f * (low + high);
+            if (speed_change_dist(mid, 0.0f, accel_cmss, jerk_cmsss) > _length) {
+                high = mid;
+            } else {
+                low = mid;
+            }
+        }
+        speed_start = low;
+    }
+
+    // find the highest speed we can reach and still stop by the end of the track
+    float speed_peak = speed_cms;
+    if (speed_start < speed_cms &&
+        speed_change_dist(speed_start, speed_cms, accel_cmss, jerk_cmsss) + speed_change_dist(speed_cms, 0.0f, accel_cmss, jerk_cmsss) > _length) {
+        float low = speed_start;
+        float high = speed_cms;
+        for (uint8_t i=0; i<AC_SCURVE_SEARCH_STEPS; i++) {
+            const float mid = 0.5f * (low + high);
+            if (speed_change_dist(speed_start, mid, accel_cmss, jerk_cmsss) + speed_change_dist(mid, 0.0f, accel_cmss, jerk_cmsss) > _length) {
+                high = mid;
+            } else {
+                low = mid;
+            }
+        }
+        speed_peak = low;
+    }
+
+    float time_jerk_start, time_accel_start, time_jerk_stop, time_accel_stop;
+    speed_change_times(fabsf(speed_peak - speed_start), accel_cmss, jerk_cmsss, time_jerk_start, time_accel_start);
+    speed_change_times(speed_peak, accel_cmss, jerk_cmsss, time_jerk_stop, time_accel_stop);
+    const float dist_change = speed_change_dist(speed_start, speed_peak, accel_cmss, jerk_cmsss) + speed_change_dist(speed_peak, 0.0f, accel_cmss, jerk_cmsss);
+    const float time_cruise = is_positive(speed_peak) ? MAX(_length - dist_change, 0.0f) / speed_peak : 0.0f;
+    const float jerk_start = (speed_peak >= speed_start) ? jerk_cmsss : -jerk_cmsss;
+
+    const float duration[NUM_PHASES] = { time_jerk_start, time_accel_start, time_jerk_start, time_cruise, time_jerk_stop, time_accel_stop, time_jerk_stop };
+    const float jerk[NUM_PHASES] = { jerk_start, 0.0f, -jerk_start, 0.0f, -jerk_cmsss, 0.0f, jerk_cmsss };
+
+    // integrate the state at the start of each phase
+    float time = 0.0f;
+    float pos = 0.0f;
+    float vel = speed_start;
+    float accel = 0.0f;
+    for (uint8_t i=0; i<NUM_PHASES; i++) {
+        const float dt = duration[i];
+        _jerk[i] = jerk[i];
+        _pos[i] = pos;
+        _vel[i] = vel;
+        _accel[i] = accel;
+        pos += (vel + (0.5f * accel + jerk[i] * dt / 6.0f) * dt) * dt;
+        vel += (accel + 0.5f * jerk[i] * dt) * dt;
+        accel += jerk[i] * dt;
+        time += dt;
+        _time_end[i] = time;
+    }
+}
+
+/// clear - remove any planned motion
+void AC_SCurve::clear()
+{
+    _length = 0.0f;
+    for (uint8_t i=0; i<NUM_PHASES; i++) {
+        _time_end[i] = 0.0f;
+        _jerk[i] = 0.0f;
+        _pos[i] = 0.0f;
+        _vel[i] = 0.0f;
+        _accel[i] = 0.0f;
+    }
+}
+
+/// eval - position, velocity and acceleration along the track at time_s seconds from the start
+void AC_SCurve::eval(float time_s, float &pos, float &vel, float &accel) const
+{
+    if (time_s >= time_total()) {
+        pos = _length;
+        vel = 0.0f;
+        accel = 0.0f;
+        return;
+    }
+    time_s = MAX(time_s, 0.0f);
+    uint8_t i = 0;
+    while (time_s >= _time_end[i]) {
+        i++;
+    }
+    const float dt = time_s - ((i > 0) ? _time_end[i-1] : 0.0f);
+    pos = _pos[i] + (_vel[i] + (0.5f * _accel[i] + _jerk[i] * dt / 6.0f) * dt) * dt;
+    vel = _vel[i] + (_accel[i] + 0.5f * _jerk[i] * dt) * dt;
+    accel = _accel[i] + _jerk[i] * dt;
+}
+
+// durations of the jerk ramps and constant acceleration needed to change speed by speed_change
+void AC_SCurve::speed_change_times(float speed_change, float accel, float jerk, float &time_jerk, float &time_accel)
+{
+    if (speed_change * jerk >= accel * accel) {
+        // acceleration reaches its limit
+        time_jerk = accel / jerk;
+        time_accel = speed_change / accel - time_jerk;
+    } else {
+        time_jerk = safe_sqrt(speed_change / jerk);
+        time_accel = 0.0f;
+    }
+}
+
+// distance travelled while changing speed from speed_from to speed_to
+float AC_SCurve::speed_change_dist(float speed_from, float speed_to, float accel, float jerk)
+{
+    float time_jerk, time_accel;
+    speed_change_times(fabsf(speed_to - speed_from), accel, jerk, time_jerk, time_accel);
+    // the acceleration profile is symmetric so the average speed is midway between the two
+    return 0.5f * (speed_from + speed_to) * (2.0f * time_jerk + time_accel);
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <AP_Math/AP_Math.h>
+
+/*
+  jerk limited (S-curve) motion profile along a straight track
+
+  The profile moves from a starting speed to rest at the end of the
+  track in the shortest time allowed by the speed, acceleration and jerk
+  limits. It has seven phases: the acceleration ramps up, holds and ramps
+  down to reach the peak speed, the peak speed is held, then the
+  deceleration ramps up, holds and ramps down to stop at the end of the
+  track. Phases a profile does not need have zero duration.
+
+  The profile is planned once, when the track is set, and evaluated at
+  any time along it.
+ */
+class AC_SCurve
+{
+public:
+
+    /// init - plan a move of length_cm starting at speed_start_cms and ending at rest
+    ///     a starting speed too high to stop within the track is reduced to one which can
+    ///     without positive speed, acceleration and jerk limits the profile stays at the start of the track and never finishes
+    void init(float length_cm, float speed_start_cms, float speed_cms, float accel_cmss, float jerk_cmsss);
+
+    /// clear - remove any planned motion
+    void clear();
+
+    /// eval - position in cm, velocity in cm/s and acceleration in cm/s/s along the track at time_s seconds from the start
+    void eval(float time_s, float &pos, float &vel, float &accel) const;
+
+    /// length - length in cm of the track
+    float length() const { return _length; }
+
+    /// time_total - duration in seconds of the profile
+    float time_total() const { return _time_end[NUM_PHASES-1]; }
+
+    /// time_accel_end - time in seconds at which the profile reaches its peak speed
+    float time_accel_end() const { return _time_end[2]; }
+
+    /// time_braking - duration in seconds of the final deceleration
+    float time_braking() const { return time_total() - _time_end[3]; }
+
+    /// finished - true once time_s is at or beyond the end of the profile
+    bool finished(float time_s) const { return time_s >= time_total(); }
+
+private:
+
+    static const uint8_t NUM_PHASES = 7;
+
+    // durations of the jerk ramps and constant acceleration needed to change speed by speed_change
+    static void speed_change_times(float speed_change, float accel, float jerk, float &time_jerk, float &time_accel);
+
+    // distance travelled while changing speed from speed_from to speed_to
+    static float speed_change_dist(float speed_from, float speed_to, float accel, float jerk);
+
+    float   _length = 0.0f;                 // track length in cm
+    float   _time_end[NUM_PHASES] {};       // time in seconds at the end of each phase
+    float   _jerk[NUM_PHASES] {};           // jerk in cm/s/s/s during each phase
+    float   _pos[NUM_PHASES] {};            // position in cm at the start of each phase
+    float   _vel[NUM_PHASES] {};            // velocity in cm/s at the start of each phase
+    float   _accel[NUM_PHASES] {};          // acceleration in cm/s/s at the start of each phase
+};
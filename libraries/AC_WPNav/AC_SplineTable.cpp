@@ -0,0 +1,107 @@
+#include "AC_SplineTable.h"
+
+// position on the spline at spline time t
+static Vector3f spline_pos(const Vector3f coeff[4], float t)
+{
+    return coeff[0] + (coeff[1] + (coeff[2] + coeff[3] * t) * t) * t;
+}
+
+/// build - sample the spline at equal distances along its length
+void AC_SplineTable::build(const Vector3f coeff[4], float accel_corner_cmss, float accel_cmss)
+{
+    const float dt = 1.0f / AC_SPLINE_TABLE_STEPS;
+
+    // measure the length of the segment
+    _length = 0.0f;
+    Vector3f prev_pos = coeff[0];
+    for (uint16_t i=1; i<=AC_SPLINE_TABLE_STEPS; i++) {
+        const Vector3f pos = spline_pos(coeff, i * dt);
+        _length += (pos - prev_pos).length();
+        prev_pos = pos;
+    }
+    _sample_dist = _length / (AC_SPLINE_TABLE_SIZE-1);
+
+    // walk the curve again recording the spline time as each sample's distance is passed
+    _time[0] = 0.0f;
+    uint8_t sample = 1;
+    float dist = 0.0f;
+    prev_pos = coeff[0];
+    for (uint16_t i=1; i<=AC_SPLINE_TABLE_STEPS && sample < AC_SPLINE_TABLE_SIZE-1; i++) {
+        const Vector3f pos = spline_pos(coeff, i * dt);
+        const float step = (pos - prev_pos).length();
+        while (sample < AC_SPLINE_TABLE_SIZE-1 && dist + step >= sample * _sample_dist) {
+            // interpolate within this step
+            const float frac = is_positive(step) ? (sample * _sample_dist - dist) / step : 1.0f;
+            _time[sample] = (i - 1 + frac) * dt;
+            sample++;
+        }
+        dist += step;
+        prev_pos = pos;
+    }
+    while (sample < AC_SPLINE_TABLE_SIZE) {
+        _time[sample++] = 1.0f;
+    }
+
+    // curvature speed limit at each sample
+    for (uint8_t i=0; i<AC_SPLINE_TABLE_SIZE; i++) {
+        const float t = _time[i];
+        const Vector3f vel = coeff[1] + (coeff[2] * 2.0f + coeff[3] * (3.0f * t)) * t;
+        const Vector3f accel = coeff[2] * 2.0f + coeff[3] * (6.0f * t);
+        const float vel_length = vel.length();
+        _speed[i] = AC_SPLINE_TABLE_SPEED_MAX;
+        if (is_positive(vel_length) && is_positive(accel_corner_cmss)) {
+            // curvature is |v x a| / |v|^3, lateral acceleration is speed^2 * curvature
+            const float curvature = (vel % accel).length() / (vel_length * vel_length * vel_length);
+            if (curvature * AC_SPLINE_TABLE_SPEED_MAX * AC_SPLINE_TABLE_SPEED_MAX > accel_corner_cmss) {
+                _speed[i] = safe_sqrt(accel_corner_cmss / curvature);
+            }
+        }
+    }
+
+    // limit each sample's speed so the target can slow down for the samples after it
+    if (is_positive(accel_cmss)) {
+        const float dv_sq = 2.0f * accel_cmss * _sample_dist;
+        for (int8_t i=AC_SPLINE_TABLE_SIZE-2; i>=0; i--) {
+            const float next = _speed[i+1];
+            if (next < AC_SPLINE_TABLE_SPEED_MAX) {
+                _speed[i] = MIN(_speed[i], safe_sqrt(next * next + dv_sq));
+            }
+        }
+    }
+}
+
+// find the sample at or before dist_cm, returning the fraction of the way to the next sample
+uint8_t AC_SplineTable::sample_index(float dist_cm, float &frac) const
+{
+    if (!is_positive(dist_cm) || !is_positive(_sample_dist)) {
+        frac = 0.0f;
+        return 0;
+    }
+    const float pos = dist_cm / _sample_dist;
+    if (pos >= AC_SPLINE_TABLE_SIZE-1) {
+        frac = 1.0f;
+        return AC_SPLINE_TABLE_SIZE-2;
+    }
+    const uint8_t index = (uint8_t)pos;
+    frac = pos - index;
+    return index;
+}
+
+/// time_at - spline time at distance dist_cm along the segment
+float AC_SplineTable::time_at(float dist_cm) const
+{
+    if (dist_cm >= _length) {
+        return 1.0f;
+    }
+    float frac;
+    const uint8_t i = sample_index(dist_cm, frac);
+    return _time[i] + (_time[i+1] - _time[i]) * frac;
+}
+
+/// speed_limit - maximum target speed in cm/s at distance dist_cm along the segment
+float AC_SplineTable::speed_limit(float dist_cm) const
+{
+    float frac;
+    const uint8_t i = sample_index(dist_cm, frac);
+    return _speed[i] + (_speed[i+1] - _speed[i]) * frac;
+}
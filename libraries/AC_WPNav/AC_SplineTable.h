@@ -0,0 +1,51 @@
+#pragma once
+
+#include <AP_Math/AP_Math.h>
+
+// number of arc length samples per spline segment, including both ends
+#define AC_SPLINE_TABLE_SIZE        33
+
+// spline time steps used to measure the segment's length
+#define AC_SPLINE_TABLE_STEPS       (4*(AC_SPLINE_TABLE_SIZE-1))
+
+// speed limit used where the segment is (nearly) straight
+#define AC_SPLINE_TABLE_SPEED_MAX   1.0e5f
+
+/*
+  arc length parameterisation of a hermite spline segment
+
+  The segment is sampled once, when it is set, at equally spaced
+  distances along the curve. Each sample holds the spline time at that
+  distance and the highest speed at which the curve can be followed
+  without exceeding the cornering acceleration, reduced where needed so
+  that the target can slow down for the next corner without exceeding
+  the waypoint acceleration. Lookups are then a single interpolation.
+ */
+class AC_SplineTable
+{
+public:
+
+    /// build - sample the spline position = c[0] + c[1]*t + c[2]*t^2 + c[3]*t^3 for t in 0 to 1
+    ///     accel_corner_cmss is the maximum lateral acceleration when following the curve
+    ///     accel_cmss is the maximum acceleration along the curve
+    void build(const Vector3f coeff[4], float accel_corner_cmss, float accel_cmss);
+
+    /// length - length in cm of the segment
+    float length() const { return _length; }
+
+    /// time_at - spline time at distance dist_cm along the segment
+    float time_at(float dist_cm) const;
+
+    /// speed_limit - maximum target speed in cm/s at distance dist_cm along the segment
+    float speed_limit(float dist_cm) const;
+
+private:
+
+    // find the sample at or before dist_cm, returning the fraction of the way to the next sample
+    uint8_t sample_index(float dist_cm, float &frac) const;
+
+    float   _length = 0.0f;                     // segment length in cm
+    float   _sample_dist = 0.0f;                // distance between samples in cm
+    float   _time[AC_SPLINE_TABLE_SIZE] {};     // spline time at each sample
+    float   _speed[AC_SPLINE_TABLE_SIZE] {};    // speed limit in cm/s at each sample
+};
@@ -102,6 +102,24 @@ const AP_Param::GroupInfo AC_WPNav::var_info[] = {
     // @Values: 0:Disable,1:Enable
     // @User: Advanced
     AP_GROUPINFO("RFND_USE",   10, AC_WPNav, _rangefinder_use, 1),
+
+    // @Param: ACCEL_C
+    // @DisplayName: Waypoint Cornering Acceleration
+    // @Description: Defines the maximum lateral acceleration in cm/s/s used to limit speed through the corners of spline segments. 0 uses twice WPNAV_ACCEL
+    // @Units: cm/s/s
+    // @Range: 0 1000
+    // @Increment: 10
+    // @User: Advanced
+    AP_GROUPINFO("ACCEL_C",    11, AC_WPNav, _wp_accel_c_cmss, 0.0f),
+
+    // @Param: JERK
+    // @DisplayName: Waypoint Jerk
+    // @Description: Defines the horizontal jerk in cm/s/s/s used during missions. Lower values give smoother but slower changes in speed. Set to zero to move the target with constant acceleration up to the leash limit instead of following jerk limited profiles, without blending the corners between waypoints
+    // @Units: cm/s/s/s
+    // @Range: 0 5000
+    // @Increment: 10
+    // @User: Advanced
+    AP_GROUPINFO("JERK",       12, AC_WPNav, _wp_jerk_cmsss, WPNAV_WP_JERK),
     
     AP_GROUPEND
 };
@@ -127,8 +145,13 @@ AC_WPNav::AC_WPNav(const AP_InertialNav& inav, const AP_AHRS_View& ahrs, AC_PosC
     _track_speed(0.0f),
     _track_leash_length(0.0f),
     _slow_down_dist(0.0f),
-    _spline_time(0.0f),
-    _spline_time_scale(0.0f),
+    _scurve_prev_time(0.0f),
+    _scurve_this_time(0.0f),
+    _scurve_next_time(0.0f),
+    _scurve_this_offset(0.0f),
+    _track_scaler(1.0f),
+    _corner_dist(0.0f),
+    _spline_dist(0.0f),
     _spline_vel_scaler(0.0f),
     _yaw(0.0f)
 {
@@ -137,7 +160,10 @@ AC_WPNav::AC_WPNav(const AP_InertialNav& inav, const AP_AHRS_View& ahrs, AC_PosC
     // init flags
     _flags.reached_destination = false;
     _flags.fast_waypoint = false;
+    _flags.scurve = false;
     _flags.slowing_down = false;
+    _flags.next_leg_set = false;
+    _flags.next_leg_started = false;
     _flags.recalc_wp_leash = false;
     _flags.new_wp_destination = false;
     _flags.segment_type = SEGMENT_STRAIGHT;
@@ -482,8 +508,17 @@ bool AC_WPNav::set_wp_destination_NED(const Vector3f& destination_NED)
 ///     returns false on failure (likely caused by missing terrain data)
 bool AC_WPNav::set_wp_origin_and_destination(const Vector3f& origin, const Vector3f& destination, bool terrain_alt)
 {
+    // if the target has already started along the leg to this destination carry on along it
+    const bool continue_next_leg = _flags.segment_type == SEGMENT_STRAIGHT && _flags.next_leg_started &&
+                                   terrain_alt == _terrain_alt && (destination - _next_destination).length() < 1.0f;
+    const Vector3f prev_delta_unit = _pos_delta_unit;
+
     // store origin and destination locations
-    _origin = origin;
+    if (continue_next_leg) {
+        _origin = _destination;
+    } else {
+        _origin = origin;
+    }
     _destination = destination;
     _terrain_alt = terrain_alt;
     Vector3f pos_delta = _destination - _origin;
@@ -512,21 +547,101 @@ bool AC_WPNav::set_wp_origin_and_destination(const Vector3f& origin, const Vecto
         }
     }
 
-    // initialise intermediate point to the origin
-    _pos_control.set_pos_target(origin + Vector3f(0,0,origin_terr_offset));
+    if (continue_next_leg) {
+        // the leg we were leaving becomes the previous leg and finishes while the target moves along this one
+        _scurve_prev_leg = _scurve_this_leg;
+        _scurve_prev_time = _scurve_this_time;
+        _prev_delta_unit = prev_delta_unit;
+        _scurve_this_leg = _scurve_next_leg;
+        _scurve_this_time = _scurve_next_time;
+    } else {
+        // initialise intermediate point to the origin
+        _pos_control.set_pos_target(origin + Vector3f(0,0,origin_terr_offset));
+        _scurve_prev_leg.clear();
+        _scurve_prev_time = 0.0f;
+
+        // start from the current speed along the track
+        const Vector3f &curr_vel = _inav.get_velocity();
+        // get speed along track (note: we convert vertical speed into horizontal speed equivalent)
+        float speed_along_track = curr_vel.x * _pos_delta_unit.x + curr_vel.y * _pos_delta_unit.y + curr_vel.z * _pos_delta_unit.z;
+        speed_along_track = constrain_float(speed_along_track, 0, _track_speed);
+
+        // a jerk limit of zero disables the s-curve profiles
+        _flags.scurve = is_positive(_wp_jerk_cmsss);
+        if (_flags.scurve) {
+            // a zero speed or acceleration leaves the target at the origin until they are changed
+            _scurve_this_leg.init(_track_length, speed_along_track, _track_speed, _track_accel, get_track_jerk(_track_accel));
+        } else {
+            _scurve_this_leg.clear();
+        }
+        _scurve_this_time = 0.0f;
+        _limited_speed_xy_cms = speed_along_track;
+        _track_scaler = 1.0f;
+        _flags.new_wp_destination = true;   // flag new waypoint so we can freeze the pos controller's feed forward and smooth the transition
+    }
+    _scurve_this_offset = 0.0f;
+    _scurve_next_leg.clear();
+    _scurve_next_time = 0.0f;
+
     _track_desired = 0;             // target is at beginning of track
     _flags.reached_destination = false;
     _flags.fast_waypoint = false;   // default waypoint back to slow
     _flags.slowing_down = false;    // target is not slowing down yet
+    _flags.next_leg_set = false;
+    _flags.next_leg_started = false;
     _flags.segment_type = SEGMENT_STRAIGHT;
-    _flags.new_wp_destination = true;   // flag new waypoint so we can freeze the pos controller's feed forward and smooth the transition
     _flags.wp_yaw_set = false;
 
-    // initialise the limited speed to current speed along the track
-    const Vector3f &curr_vel = _inav.get_velocity();
-    // get speed along track (note: we convert vertical speed into horizontal speed equivalent)
-    float speed_along_track = curr_vel.x * _pos_delta_unit.x + curr_vel.y * _pos_delta_unit.y + curr_vel.z * _pos_delta_unit.z;
-    _limited_speed_xy_cms = constrain_float(speed_along_track,0,_wp_speed_cms);
+    return true;
+}
+
+/// set_wp_destination_next - set the waypoint which will follow the current destination
+///     returns false if conversion from location to vector from ekf origin cannot be calculated
+bool AC_WPNav::set_wp_destination_next(const Location_Class& destination)
+{
+    bool terr_alt;
+    Vector3f dest_neu;
+
+    // convert destination location to vector
+    if (!get_vector_NEU(destination, dest_neu, terr_alt)) {
+        return false;
+    }
+
+    return set_wp_destination_next(dest_neu, terr_alt);
+}
+
+/// set_wp_destination_next - set the waypoint which will follow the current destination using position vector (distance from ekf origin in cm)
+bool AC_WPNav::set_wp_destination_next(const Vector3f& destination, bool terrain_alt)
+{
+    // the next leg can only be blended with a straight s-curve leg using the same altitude frame
+    if (_flags.segment_type != SEGMENT_STRAIGHT || !_flags.scurve || terrain_alt != _terrain_alt || _flags.next_leg_started) {
+        return true;
+    }
+
+    const Vector3f pos_delta = destination - _destination;
+    const float length = pos_delta.length();
+    if (is_zero(length)) {
+        _flags.next_leg_set = false;
+        return true;
+    }
+    _next_destination = destination;
+    _next_delta_unit = pos_delta / length;
+
+    // plan the next leg from rest, the end of this leg's deceleration provides the speed through the corner
+    float speed, accel, leash;
+    get_track_limits(_next_delta_unit, speed, accel, leash);
+    _scurve_next_leg.init(length, 0.0f, speed, accel, get_track_jerk(accel));
+    _scurve_next_time = 0.0f;
+
+    // start along the next leg early enough that the path through the corner passes within the waypoint radius
+    // of the destination.  The closest approach of the blended path is about the blend distance times sin(turn angle/2)
+    const float sin_half_turn = safe_sqrt(0.5f * (1.0f - _pos_delta_unit * _next_delta_unit));
+    if (sin_half_turn > 0.01f) {
+        _corner_dist = _wp_radius_cm / sin_half_turn;
+    } else {
+        _corner_dist = _track_length;
+    }
+    _flags.next_leg_set = true;
 
     return true;
 }
@@ -578,7 +693,6 @@ bool AC_WPNav::advance_wp_target_along_track(float dt)
     Vector3f track_error;       // distance error (in cm) from the track_covered position (i.e. closest point on the line to the vehicle) and the vehicle
     float track_desired_max;    // the farthest distance (in cm) along the track that the leash will allow
     float track_leash_slack;    // additional distance (in cm) along the track from our track_covered position that our leash will allow
-    bool reached_leash_limit = false;   // true when track has reached leash limit and we need to slow down the target point
 
     // get current location
     Vector3f curr_pos = _inav.get_position();
@@ -619,11 +733,116 @@ bool AC_WPNav::advance_wp_target_along_track(float dt)
     track_leash_slack = (track_leash_length_abs > track_error_max_abs) ? safe_sqrt(sq(_track_leash_length) - sq(track_error_max_abs)) : 0;
     track_desired_max = track_covered + track_leash_slack;
 
-    // check if target is already beyond the leash
-    if (_track_desired > track_desired_max) {
-        reached_leash_limit = true;
+    // move the target along the track
+    Vector3f final_target;
+    if (_flags.scurve) {
+        final_target = advance_wp_target_scurve(dt, track_desired_max);
+    } else {
+        final_target = advance_wp_target_leash(dt, track_desired_max);
+    }
+
+    // convert final_target.z to altitude above the ekf origin
+    final_target.z += terr_offset;
+    _pos_control.set_pos_target(final_target);
+
+    // check if we've reached the waypoint
+    if (!_flags.reached_destination) {
+        if (_flags.fast_waypoint) {
+            if (_flags.scurve) {
+                // "fast" waypoints are complete once the target starts along the next leg or, if there is no
+                // next leg, once it starts to slow down for the destination
+                if (_flags.next_leg_started ||
+                    (!_flags.next_leg_set && _scurve_this_leg.time_total() - _scurve_this_time <= _scurve_this_leg.time_braking()) ||
+                    _scurve_this_leg.finished(_scurve_this_time)) {
+                    _flags.reached_destination = true;
+                }
+            } else if (_track_desired >= _track_length) {
+                // without s-curves "fast" waypoints are complete once the intermediate point reaches the destination
+                _flags.reached_destination = true;
+            }
+        } else if (_flags.scurve ? _scurve_this_leg.finished(_scurve_this_time) : _track_desired >= _track_length) {
+            // regular waypoints also require the copter to be within the waypoint radius
+            Vector3f dist_to_dest = (curr_pos - Vector3f(0,0,terr_offset)) - _destination;
+            if( dist_to_dest.length() <= _wp_radius_cm ) {
+                _flags.reached_destination = true;
+            }
+        }
     }
 
+    // update the target yaw if origin and destination are at least 2m apart horizontally
+    if (_track_length_xy >= WPNAV_YAW_DIST_MIN) {
+        if (_pos_control.get_leash_xy() < WPNAV_YAW_DIST_MIN) {
+            // if the leash is short (i.e. moving slowly) and destination is at least 2m horizontally, point along the segment from origin to destination
+            set_yaw_cd(get_bearing_cd(_origin, _destination));
+        } else {
+            Vector3f horiz_leash_xy = final_target - curr_pos;
+            horiz_leash_xy.z = 0;
+            if (horiz_leash_xy.length() > MIN(WPNAV_YAW_DIST_MIN, _pos_control.get_leash_xy()*WPNAV_YAW_LEASH_PCT_MIN)) {
+                set_yaw_cd(RadiansToCentiDegrees(atan2f(horiz_leash_xy.y,horiz_leash_xy.x)));
+            }
+        }
+    }
+
+    // successfully advanced along track
+    return true;
+}
+
+/// advance_wp_target_scurve - moves the target along the s-curve profiles of the straight leg, returns the target's position
+Vector3f AC_WPNav::advance_wp_target_scurve(float dt, float track_desired_max)
+{
+    // slow the profile down while the target is beyond the leash, and resume once the vehicle catches up
+    const float scaler_target = (_track_desired > track_desired_max) ? 0.0f : 1.0f;
+    _track_scaler += constrain_float(scaler_target - _track_scaler, -WPNAV_TRACK_SCALER_RATE * dt, WPNAV_TRACK_SCALER_RATE * dt);
+    const float profile_dt = _track_scaler * dt;
+
+    // start along the next leg once this leg is braking for the destination and the corner is close enough
+    if (_flags.fast_waypoint && _flags.next_leg_set && !_flags.next_leg_started) {
+        const float time_left = _scurve_this_leg.time_total() - _scurve_this_time;
+        if (time_left <= MIN(_scurve_next_leg.time_accel_end(), _scurve_this_leg.time_braking()) &&
+            _track_length - _track_desired <= _corner_dist) {
+            _flags.next_leg_started = true;
+        }
+    }
+
+    // advance along the profiles
+    _scurve_this_time += profile_dt;
+    _scurve_prev_time += profile_dt;
+    if (_flags.next_leg_started) {
+        _scurve_next_time += profile_dt;
+    }
+
+    // the target is the sum of the motion along each leg
+    float pos, vel, accel;
+    _scurve_this_leg.eval(_scurve_this_time, pos, vel, accel);
+    _track_desired = _scurve_this_offset + pos;
+    Vector3f final_target = _origin + _pos_delta_unit * _track_desired;
+    Vector3f target_vel = _pos_delta_unit * vel;
+    Vector3f target_accel = _pos_delta_unit * accel;
+    if (!_scurve_prev_leg.finished(_scurve_prev_time)) {
+        _scurve_prev_leg.eval(_scurve_prev_time, pos, vel, accel);
+        final_target += _prev_delta_unit * (pos - _scurve_prev_leg.length());
+        target_vel += _prev_delta_unit * vel;
+        target_accel += _prev_delta_unit * accel;
+    }
+    if (_flags.next_leg_started) {
+        _scurve_next_leg.eval(_scurve_next_time, pos, vel, accel);
+        final_target += _next_delta_unit * pos;
+        target_vel += _next_delta_unit * vel;
+        target_accel += _next_delta_unit * accel;
+    }
+    target_vel *= _track_scaler;
+    target_accel *= sq(_track_scaler);
+    _pos_control.set_trajectory_ff_xy(Vector2f(target_vel.x, target_vel.y), Vector2f(target_accel.x, target_accel.y));
+
+    return final_target;
+}
+
+/// advance_wp_target_leash - moves the target along the straight leg as fast as the leash allows, returns the target's position
+Vector3f AC_WPNav::advance_wp_target_leash(float dt, float track_desired_max)
+{
+    // check if target is already beyond the leash
+    bool reached_leash_limit = _track_desired > track_desired_max;
+
     // get current velocity
     const Vector3f &curr_vel = _inav.get_velocity();
     // get speed along track
@@ -687,43 +906,7 @@ bool AC_WPNav::advance_wp_target_along_track(float dt)
     }
 
     // recalculate the desired position
-    Vector3f final_target = _origin + _pos_delta_unit * _track_desired;
-    // convert final_target.z to altitude above the ekf origin
-    final_target.z += terr_offset;
-    _pos_control.set_pos_target(final_target);
-
-    // check if we've reached the waypoint
-    if( !_flags.reached_destination ) {
-        if( _track_desired >= _track_length ) {
-            // "fast" waypoints are complete once the intermediate point reaches the destination
-            if (_flags.fast_waypoint) {
-                _flags.reached_destination = true;
-            }else{
-                // regular waypoints also require the copter to be within the waypoint radius
-                Vector3f dist_to_dest = (curr_pos - Vector3f(0,0,terr_offset)) - _destination;
-                if( dist_to_dest.length() <= _wp_radius_cm ) {
-                    _flags.reached_destination = true;
-                }
-            }
-        }
-    }
-
-    // update the target yaw if origin and destination are at least 2m apart horizontally
-    if (_track_length_xy >= WPNAV_YAW_DIST_MIN) {
-        if (_pos_control.get_leash_xy() < WPNAV_YAW_DIST_MIN) {
-            // if the leash is short (i.e. moving slowly) and destination is at least 2m horizontally, point along the segment from origin to destination
-            set_yaw_cd(get_bearing_cd(_origin, _destination));
-        } else {
-            Vector3f horiz_leash_xy = final_target - curr_pos;
-            horiz_leash_xy.z = 0;
-            if (horiz_leash_xy.length() > MIN(WPNAV_YAW_DIST_MIN, _pos_control.get_leash_xy()*WPNAV_YAW_LEASH_PCT_MIN)) {
-                set_yaw_cd(RadiansToCentiDegrees(atan2f(horiz_leash_xy.y,horiz_leash_xy.x)));
-            }
-        }
-    }
-
-    // successfully advanced along track
-    return true;
+    return _origin + _pos_delta_unit * _track_desired;
 }
 
 /// get_wp_distance_to_destination - get horizontal distance to destination in cm
@@ -774,7 +957,7 @@ bool AC_WPNav::update_wpnav()
         }
         _pos_control.freeze_ff_z();
 
-        _pos_control.update_xy_controller(AC_PosControl::XY_MODE_POS_ONLY, 1.0f, false);
+        _pos_control.update_xy_controller(_flags.scurve ? AC_PosControl::XY_MODE_POS_AND_TRAJECTORY_FF : AC_PosControl::XY_MODE_POS_ONLY, 1.0f, false);
         check_wp_leash_length();
 
         _wp_last_update = AP_HAL::millis();
@@ -790,19 +973,35 @@ void AC_WPNav::check_wp_leash_length()
     // exit immediately if recalc is not required
     if (_flags.recalc_wp_leash) {
         calculate_wp_leash_length();
+        if (_flags.segment_type == SEGMENT_STRAIGHT && _flags.scurve) {
+            replan_wp_profile();
+        }
     }
 }
 
 /// calculate_wp_leash_length - calculates horizontal and vertical leash lengths for waypoint controller
 void AC_WPNav::calculate_wp_leash_length()
+{
+    // calculate the maximum acceleration, maximum velocity, and leash length in the direction of travel
+    get_track_limits(_pos_delta_unit, _track_speed, _track_accel, _track_leash_length);
+
+    // calculate slow down distance (the distance from the destination when the target point should begin to slow down)
+    calc_slow_down_distance(_track_speed, _track_accel);
+
+    // set recalc leash flag to false
+    _flags.recalc_wp_leash = false;
+}
+
+/// get_track_limits - calculates maximum speed, acceleration and leash length along a track with direction pos_delta_unit
+void AC_WPNav::get_track_limits(const Vector3f& pos_delta_unit, float& speed_cms, float& accel_cmss, float& leash_cm) const
 {
     // length of the unit direction vector in the horizontal
-    float pos_delta_unit_xy = norm(_pos_delta_unit.x, _pos_delta_unit.y);
-    float pos_delta_unit_z = fabsf(_pos_delta_unit.z);
+    float pos_delta_unit_xy = norm(pos_delta_unit.x, pos_delta_unit.y);
+    float pos_delta_unit_z = fabsf(pos_delta_unit.z);
 
     float speed_z;
     float leash_z;
-    if (_pos_delta_unit.z >= 0.0f) {
+    if (pos_delta_unit.z >= 0.0f) {
         speed_z = _wp_speed_up_cms;
         leash_z = _pos_control.get_leash_up_z();
     }else{
@@ -812,28 +1011,47 @@ void AC_WPNav::calculate_wp_leash_length()
 
     // calculate the maximum acceleration, maximum velocity, and leash length in the direction of travel
     if(is_zero(pos_delta_unit_z) && is_zero(pos_delta_unit_xy)){
-        _track_accel = 0;
-        _track_speed = 0;
-        _track_leash_length = WPNAV_LEASH_LENGTH_MIN;
-    }else if(is_zero(_pos_delta_unit.z)){
-        _track_accel = _wp_accel_cms/pos_delta_unit_xy;
-        _track_speed = _wp_speed_cms/pos_delta_unit_xy;
-        _track_leash_length = _pos_control.get_leash_xy()/pos_delta_unit_xy;
+        accel_cmss = 0;
+        speed_cms = 0;
+        leash_cm = WPNAV_LEASH_LENGTH_MIN;
+    }else if(is_zero(pos_delta_unit.z)){
+        accel_cmss = _wp_accel_cms/pos_delta_unit_xy;
+        speed_cms = _wp_speed_cms/pos_delta_unit_xy;
+        leash_cm = _pos_control.get_leash_xy()/pos_delta_unit_xy;
     }else if(is_zero(pos_delta_unit_xy)){
-        _track_accel = _wp_accel_z_cms/pos_delta_unit_z;
-        _track_speed = speed_z/pos_delta_unit_z;
-        _track_leash_length = leash_z/pos_delta_unit_z;
+        accel_cmss = _wp_accel_z_cms/pos_delta_unit_z;
+        speed_cms = speed_z/pos_delta_unit_z;
+        leash_cm = leash_z/pos_delta_unit_z;
     }else{
-        _track_accel = MIN(_wp_accel_z_cms/pos_delta_unit_z, _wp_accel_cms/pos_delta_unit_xy);
-        _track_speed = MIN(speed_z/pos_delta_unit_z, _wp_speed_cms/pos_delta_unit_xy);
-        _track_leash_length = MIN(leash_z/pos_delta_unit_z, _pos_control.get_leash_xy()/pos_delta_unit_xy);
+        accel_cmss = MIN(_wp_accel_z_cms/pos_delta_unit_z, _wp_accel_cms/pos_delta_unit_xy);
+        speed_cms = MIN(speed_z/pos_delta_unit_z, _wp_speed_cms/pos_delta_unit_xy);
+        leash_cm = MIN(leash_z/pos_delta_unit_z, _pos_control.get_leash_xy()/pos_delta_unit_xy);
     }
+}
 
-    // calculate slow down distance (the distance from the destination when the target point should begin to slow down)
-    calc_slow_down_distance(_track_speed, _track_accel);
+/// get_track_jerk - returns maximum jerk in cm/s/s/s along a track with the given maximum acceleration
+///     jerk is scaled with the track's acceleration so the time taken to reach full acceleration does not depend on the track's direction
+float AC_WPNav::get_track_jerk(float accel_cmss) const
+{
+    if (!is_positive(_wp_jerk_cmsss) || !is_positive(_wp_accel_cms)) {
+        return WPNAV_WP_JERK;
+    }
+    return accel_cmss * _wp_jerk_cmsss / _wp_accel_cms;
+}
 
-    // set recalc leash flag to false
-    _flags.recalc_wp_leash = false;
+/// replan_wp_profile - plans the rest of the current straight leg again from the target's current position and speed
+///     used when the speed or acceleration is changed part way along the leg
+void AC_WPNav::replan_wp_profile()
+{
+    // leave the corner to finish as planned
+    if (_flags.next_leg_started) {
+        return;
+    }
+    float pos, vel, accel;
+    _scurve_this_leg.eval(_scurve_this_time, pos, vel, accel);
+    _scurve_this_offset += pos;
+    _scurve_this_leg.init(_track_length - _scurve_this_offset, vel, _track_speed, _track_accel, get_track_jerk(_track_accel));
+    _scurve_this_time = 0.0f;
 }
 
 // returns target yaw in centi-degrees (used for wp and spline navigation)
@@ -944,7 +1162,7 @@ bool AC_WPNav::set_spline_origin_and_destination(const Vector3f& origin, const V
     if (stopped_at_start || !prev_segment_exists) {
     	// if vehicle is stopped at the origin, set origin velocity to 0.02 * distance vector from origin to destination
     	_spline_origin_vel = (destination - origin) * dt;
-    	_spline_time = 0.0f;
+    	_spline_dist = 0.0f;
     	_spline_vel_scaler = 0.0f;
     }else{
     	// look at previous segment to determine velocity at origin
@@ -952,7 +1170,7 @@ bool AC_WPNav::set_spline_origin_and_destination(const Vector3f& origin, const V
             // previous segment is straight, vehicle is moving so vehicle should fly straight through the origin
             // before beginning it's spline path to the next waypoint. Note: we are using the previous segment's origin and destination
             _spline_origin_vel = (_destination - _origin);
-            _spline_time = 0.0f;	// To-Do: this should be set based on how much overrun there was from straight segment?
+            _spline_dist = 0.0f;	// To-Do: this should be set based on how much overrun there was from straight segment?
             _spline_vel_scaler = _pos_control.get_vel_target().length();    // start velocity target from current target velocity
         }else{
             // previous segment is splined, vehicle will fly through origin
@@ -960,11 +1178,8 @@ bool AC_WPNav::set_spline_origin_and_destination(const Vector3f& origin, const V
             // Note: previous segment will leave destination velocity parallel to position difference vector
             //       from previous segment's origin to this segment's destination)
             _spline_origin_vel = _spline_destination_vel;
-            if (_spline_time > 1.0f && _spline_time < 1.1f) {    // To-Do: remove hard coded 1.1f
-                _spline_time -= 1.0f;
-            }else{
-                _spline_time = 0.0f;
-            }
+            // carry the distance the target overran the previous destination into this segment
+            _spline_dist = MAX(_spline_dist - _spline_table.length(), 0.0f);
             // Note: we leave _spline_vel_scaler as it was from end of previous segment
         }
     }
@@ -1005,6 +1220,13 @@ bool AC_WPNav::set_spline_origin_and_destination(const Vector3f& origin, const V
         update_spline_solution(origin, destination, _spline_origin_vel, _spline_destination_vel);
     }
 
+    // sample the segment against distance along it
+    float accel_corner_cmss = _wp_accel_c_cmss;
+    if (!is_positive(accel_corner_cmss)) {
+        accel_corner_cmss = 2.0f * _wp_accel_cms;
+    }
+    _spline_table.build(_hermite_spline_solution, accel_corner_cmss, _wp_accel_cms);
+
     // store origin and destination locations
     _origin = origin;
     _destination = destination;
@@ -1091,7 +1313,7 @@ bool AC_WPNav::advance_spline_target_along_track(float dt)
         Vector3f target_pos, target_vel;
 
         // update target position and velocity from spline calculator
-        calc_spline_pos_vel(_spline_time, target_pos, target_vel);
+        calc_spline_pos_vel(_spline_table.time_at(_spline_dist), target_pos, target_vel);
 
         _pos_delta_unit = target_vel/target_vel.length();
         calculate_wp_leash_length();
@@ -1130,9 +1352,9 @@ bool AC_WPNav::advance_spline_target_along_track(float dt)
             track_leash_slack = 0.0f;
         }
 
-        // update velocity
-        float spline_dist_to_wp = (_destination - target_pos).length();
-        float vel_limit = _wp_speed_cms;
+        // update velocity, slowing for corners ahead
+        float spline_dist_to_wp = MAX(_spline_table.length() - _spline_dist, 0.0f);
+        float vel_limit = MIN(_wp_speed_cms, _spline_table.speed_limit(_spline_dist));
         if (!is_zero(dt)) {
             vel_limit = MIN(vel_limit, track_leash_slack/dt);
         }
@@ -1148,12 +1370,6 @@ bool AC_WPNav::advance_spline_target_along_track(float dt)
         // constrain target velocity
         _spline_vel_scaler = constrain_float(_spline_vel_scaler, 0.0f, vel_limit);
 
-        // scale the spline_time by the velocity we've calculated vs the velocity that came out of the spline calculator
-        float target_vel_length = target_vel.length();
-        if (!is_zero(target_vel_length)) {
-            _spline_time_scale = _spline_vel_scaler/target_vel_length;
-        }
-
         // update target position
         target_pos.z += terr_offset;
         _pos_control.set_pos_target(target_pos);
@@ -1175,12 +1391,12 @@ bool AC_WPNav::advance_spline_target_along_track(float dt)
             }
         }
 
-        // advance spline time to next step
-        _spline_time += _spline_time_scale*dt;
+        // advance target along the spline
+        _spline_dist += _spline_vel_scaler*dt;
 
         // we will reach the next waypoint in the next step so set reached_destination flag
         // To-Do: is this one step too early?
-        if (_spline_time >= 1.0f) {
+        if (_spline_dist >= _spline_table.length()) {
             _flags.reached_destination = true;
         }
     }
@@ -9,6 +9,8 @@
 #include <AC_AttitudeControl/AC_AttitudeControl.h> // Attitude control library
 #include <AP_Terrain/AP_Terrain.h>
 #include <AC_Avoidance/AC_Avoid.h>                 // Stop at fence library
+#include "AC_SplineTable.h"
+#include "AC_SCurve.h"
 
 // loiter maximum velocities and accelerations
 #define WPNAV_ACCELERATION              100.0f      // defines the default velocity vs distant curve.  maximum acceleration in cm/s/s that position controller asks for from acceleration controller
@@ -30,10 +32,13 @@
 #define WPNAV_WP_SPEED_DOWN             150.0f      // default maximum descent velocity
 
 #define WPNAV_WP_ACCEL_Z_DEFAULT        100.0f      // default vertical acceleration between waypoints in cm/s/s
+#define WPNAV_WP_JERK                   500.0f      // default horizontal jerk between waypoints in cm/s/s/s
 
 #define WPNAV_LEASH_LENGTH_MIN          100.0f      // minimum leash lengths in cm
 
-#define WPNAV_WP_FAST_OVERSHOOT_MAX     200.0f      // 2m overshoot is allowed during fast waypoints to allow for smooth transitions to next waypoint
+#define WPNAV_WP_FAST_OVERSHOOT_MAX     200.0f      // 2m overshoot is allowed during fast waypoints without jerk limited profiles to allow for smooth transitions to next waypoint
+
+#define WPNAV_TRACK_SCALER_RATE           2.0f      // rate per second at which the profile slows or resumes when the vehicle falls behind or catches up with the target
 
 #define WPNAV_LOITER_UPDATE_TIME        0.020f      // 50hz update rate for loiter
 
@@ -187,6 +192,16 @@ public:
     /// set_fast_waypoint - set to true to ignore the waypoint radius and consider the waypoint 'reached' the moment the intermediate point reaches it
     void set_fast_waypoint(bool fast) { _flags.fast_waypoint = fast; }
 
+    /// set_wp_destination_next - set the waypoint which will follow the current destination
+    ///     for fast waypoints the vehicle then blends into the next leg within the waypoint radius instead of stopping
+    ///     the next leg is used if the following set_wp_destination call is for the same point
+    ///     returns false if conversion from location to vector from ekf origin cannot be calculated
+    bool set_wp_destination_next(const Location_Class& destination);
+
+    /// set_wp_destination_next - set the waypoint which will follow the current destination using position vector (distance from ekf origin in cm)
+    ///     terrain_alt should be true if destination.z is a desired altitude above terrain
+    bool set_wp_destination_next(const Vector3f& destination, bool terrain_alt = false);
+
     /// update_wpnav - run the wp controller - should be called at 100hz or higher
     bool update_wpnav();
 
@@ -279,7 +294,10 @@ protected:
     struct wpnav_flags {
         uint8_t reached_destination     : 1;    // true if we have reached the destination
         uint8_t fast_waypoint           : 1;    // true if we should ignore the waypoint radius and consider the waypoint complete once the intermediate target has reached the waypoint
-        uint8_t slowing_down            : 1;    // true when target point is slowing down before reaching the destination
+        uint8_t scurve                  : 1;    // true if the straight leg follows _scurve_this_leg, false if the target is advanced up to the leash limit
+        uint8_t slowing_down            : 1;    // true when target point is slowing down before reaching the destination (without s-curves only)
+        uint8_t next_leg_set            : 1;    // true if _scurve_next_leg holds the leg from the destination to _next_destination
+        uint8_t next_leg_started        : 1;    // true once the target has started along the next leg
         uint8_t recalc_wp_leash         : 1;    // true if we need to recalculate the leash lengths because of changes in speed or acceleration
         uint8_t new_wp_destination      : 1;    // true if we have just received a new destination.  allows us to freeze the position controller's xy feed forward
         SegmentType segment_type        : 1;    // active segment is either straight or spline
@@ -296,6 +314,21 @@ protected:
     /// get_slow_down_speed - returns target speed of target point based on distance from the destination (in cm)
     float get_slow_down_speed(float dist_from_dest_cm, float accel_cmss);
 
+    /// advance_wp_target_scurve - moves the target along the s-curve profiles of the straight leg, returns the target's position
+    Vector3f advance_wp_target_scurve(float dt, float track_desired_max);
+
+    /// advance_wp_target_leash - moves the target along the straight leg as fast as the leash allows, returns the target's position
+    Vector3f advance_wp_target_leash(float dt, float track_desired_max);
+
+    /// get_track_limits - calculates maximum speed, acceleration and leash length along a track with direction pos_delta_unit
+    void get_track_limits(const Vector3f& pos_delta_unit, float& speed_cms, float& accel_cmss, float& leash_cm) const;
+
+    /// get_track_jerk - returns maximum jerk in cm/s/s/s along a track with the given maximum acceleration
+    float get_track_jerk(float accel_cmss) const;
+
+    /// replan_wp_profile - plans the rest of the current straight leg again from the target's current position and speed
+    void replan_wp_profile();
+
     /// spline protected functions
 
     /// update_spline_solution - recalculates hermite_spline_solution grid
@@ -338,6 +371,8 @@ protected:
     AP_Float    _wp_radius_cm;          // distance from a waypoint in cm that, when crossed, indicates the wp has been reached
     AP_Float    _wp_accel_cms;          // horizontal acceleration in cm/s/s during missions
     AP_Float    _wp_accel_z_cms;        // vertical acceleration in cm/s/s during missions
+    AP_Float    _wp_accel_c_cmss;       // maximum lateral acceleration in cm/s/s when cornering on spline segments
+    AP_Float    _wp_jerk_cmsss;         // horizontal jerk in cm/s/s/s during missions
 
     // loiter controller internal variables
     int16_t     _pilot_accel_fwd_cms; 	// pilot's desired acceleration forward (body-frame)
@@ -353,15 +388,29 @@ protected:
     float       _track_length;          // distance in cm between origin and destination
     float       _track_length_xy;       // horizontal distance in cm between origin and destination
     float       _track_desired;         // our desired distance along the track in cm
-    float       _limited_speed_xy_cms;  // horizontal speed in cm/s used to advance the intermediate target towards the destination.  used to limit extreme acceleration after passing a waypoint
+    float       _limited_speed_xy_cms;  // horizontal speed in cm/s used to advance the intermediate target towards the destination without s-curves.  used to limit extreme acceleration after passing a waypoint
     float       _track_accel;           // acceleration along track
     float       _track_speed;           // speed in cm/s along track
     float       _track_leash_length;    // leash length along track
     float       _slow_down_dist;        // vehicle should begin to slow down once it is within this distance from the destination
 
+    // straight line profile variables
+    AC_SCurve   _scurve_prev_leg;       // the end of the previous leg, finishing while the target starts along this one
+    AC_SCurve   _scurve_this_leg;       // profile from origin to destination
+    AC_SCurve   _scurve_next_leg;       // profile from destination to _next_destination
+    float       _scurve_prev_time;      // time in seconds along _scurve_prev_leg
+    float       _scurve_this_time;      // time in seconds along _scurve_this_leg
+    float       _scurve_next_time;      // time in seconds along _scurve_next_leg
+    float       _scurve_this_offset;    // distance in cm along the track at which _scurve_this_leg starts
+    float       _track_scaler;          // profile time advanced per second, reduced below 1 while the vehicle is behind the target
+    Vector3f    _prev_delta_unit;       // direction of the previous leg
+    Vector3f    _next_destination;      // destination after this one in cm from ekf origin
+    Vector3f    _next_delta_unit;       // direction of the next leg
+    float       _corner_dist;           // distance in cm before the destination within which the target may start along the next leg
+
     // spline variables
-    float       _spline_time;           // current spline time between origin and destination
-    float       _spline_time_scale;     // current spline time between origin and destination
+    float       _spline_dist;           // distance in cm the target has travelled along the spline from the origin
+    AC_SplineTable _spline_table;       // spline time and speed limit against distance along the current segment
     Vector3f    _spline_origin_vel;     // the target velocity vector at the origin of the spline segment
     Vector3f    _spline_destination_vel;// the target velocity vector at the destination point of the spline segment
     Vector3f    _hermite_spline_solution[4]; // array describing spline path between origin and destination
@@ -0,0 +1,87 @@
+#include <AP_gbenchmark.h>
+
+#include <AC_WPNav/AC_SplineTable.h>
+
+// a 10m by 10m corner entered and left at 20m/s, as set up by AC_WPNav
+static void make_corner(Vector3f coeff[4])
+{
+    const Vector3f origin(0, 0, 0);
+    const Vector3f dest(1000, 1000, 200);
+    const Vector3f origin_vel(2000, 0, 0);
+    const Vector3f dest_vel(0, 2000, 0);
+    coeff[0] = origin;
+    coeff[1] = origin_vel;
+    coeff[2] = -origin*3.0f - origin_vel*2.0f + dest*3.0f - dest_vel;
+    coeff[3] = origin*2.0f + origin_vel - dest*2.0f + dest_vel;
+}
+
+static void spline_pos_vel(const Vector3f coeff[4], float t, Vector3f &pos, Vector3f &vel)
+{
+    const float t2 = t * t;
+    pos = coeff[0] + coeff[1] * t + coeff[2] * t2 + coeff[3] * (t2 * t);
+    vel = coeff[1] + coeff[2] * 2.0f * t + coeff[3] * 3.0f * t2;
+}
+
+static void BM_SplineTableBuild(benchmark::State& state)
+{
+    Vector3f coeff[4];
+    make_corner(coeff);
+    AC_SplineTable table;
+
+    while (state.KeepRunning()) {
+        table.build(coeff, 200.0f, 100.0f);
+        gbenchmark_escape(&table);
+    }
+}
+
+// follow the segment in 400Hz steps at 5m/s scaling spline time by the
+// velocity from the spline, as AC_WPNav did before using the tables
+static void BM_SplineFollowTimeScaled(benchmark::State& state)
+{
+    Vector3f coeff[4];
+    make_corner(coeff);
+    const float dt = 0.0025f;
+    const float speed = 500.0f;
+
+    while (state.KeepRunning()) {
+        float t = 0.0f;
+        float t_scale = 0.0f;
+        Vector3f pos, vel;
+        while (t < 1.0f) {
+            spline_pos_vel(coeff, t, pos, vel);
+            const float vel_length = vel.length();
+            if (!is_zero(vel_length)) {
+                t_scale = speed / vel_length;
+            }
+            t += t_scale * dt;
+            gbenchmark_escape(&pos);
+        }
+    }
+}
+
+// follow the same segment by distance, looking up spline time and the speed limit
+static void BM_SplineFollowTable(benchmark::State& state)
+{
+    Vector3f coeff[4];
+    make_corner(coeff);
+    AC_SplineTable table;
+    table.build(coeff, 200.0f, 100.0f);
+    const float dt = 0.0025f;
+    const float speed = 500.0f;
+
+    while (state.KeepRunning()) {
+        float dist = 0.0f;
+        Vector3f pos, vel;
+        while (dist < table.length()) {
+            spline_pos_vel(coeff, table.time_at(dist), pos, vel);
+            dist += MIN(speed, table.speed_limit(dist)) * dt;
+            gbenchmark_escape(&pos);
+        }
+    }
+}
+
+BENCHMARK(BM_SplineTableBuild);
+BENCHMARK(BM_SplineFollowTimeScaled);
+BENCHMARK(BM_SplineFollowTable);
+
+BENCHMARK_MAIN()
@@ -0,0 +1,121 @@
+#include <AP_gtest.h>
+
+#include <AC_WPNav/AC_SCurve.h>
+
+#define DT 0.0025f
+
+// step through a profile checking it never exceeds its limits
+static void check_profile(const AC_SCurve &scurve, float speed, float accel, float jerk)
+{
+    float pos_last, vel_last, accel_last;
+    scurve.eval(0.0f, pos_last, vel_last, accel_last);
+    for (float t = DT; t < scurve.time_total() + DT; t += DT) {
+        float p, v, a;
+        scurve.eval(t, p, v, a);
+        EXPECT_GE(p, pos_last - 0.001f);
+        EXPECT_LE(v, speed + 0.1f);
+        EXPECT_GE(v, -0.1f);
+        EXPECT_LE(fabsf(a), accel + 0.1f);
+        EXPECT_LE(fabsf(a - accel_last), jerk * DT + 0.1f);
+        pos_last = p;
+        accel_last = a;
+    }
+}
+
+TEST(SCurveTest, LongTrack)
+{
+    AC_SCurve scurve;
+    scurve.init(10000.0f, 0.0f, 500.0f, 100.0f, 500.0f);
+    check_profile(scurve, 500.0f, 100.0f, 500.0f);
+
+    float p, v, a;
+    scurve.eval(scurve.time_accel_end(), p, v, a);
+    EXPECT_NEAR(500.0f, v, 0.1f);
+    scurve.eval(scurve.time_total() - 0.0001f, p, v, a);
+    EXPECT_NEAR(10000.0f, p, 0.5f);
+    EXPECT_NEAR(0.0f, v, 0.5f);
+    EXPECT_TRUE(scurve.finished(scurve.time_total()));
+
+    // 5.2s to reach full speed, 14.8s at full speed and 5.2s to stop
+    EXPECT_NEAR(25.2f, scurve.time_total(), 0.01f);
+    EXPECT_NEAR(5.2f, scurve.time_braking(), 0.01f);
+}
+
+TEST(SCurveTest, ShortTrack)
+{
+    AC_SCurve scurve;
+    scurve.init(300.0f, 0.0f, 500.0f, 100.0f, 500.0f);
+    check_profile(scurve, 500.0f, 100.0f, 500.0f);
+
+    // too short to reach full speed
+    float p, v, a;
+    scurve.eval(scurve.time_accel_end(), p, v, a);
+    EXPECT_LT(v, 500.0f);
+    EXPECT_NEAR(150.0f, p, 1.0f);
+    scurve.eval(scurve.time_total(), p, v, a);
+    EXPECT_FLOAT_EQ(300.0f, p);
+    EXPECT_FLOAT_EQ(0.0f, v);
+}
+
+TEST(SCurveTest, MovingStart)
+{
+    AC_SCurve scurve;
+
+    // faster than the speed limit slows down to it
+    scurve.init(10000.0f, 800.0f, 500.0f, 100.0f, 500.0f);
+    check_profile(scurve, 800.0f, 100.0f, 500.0f);
+    float p, v, a;
+    scurve.eval(0.0f, p, v, a);
+    EXPECT_FLOAT_EQ(800.0f, v);
+    scurve.eval(scurve.time_accel_end(), p, v, a);
+    EXPECT_NEAR(500.0f, v, 0.1f);
+
+    // too fast to stop in the track is slowed to a speed which can
+    scurve.init(100.0f, 500.0f, 500.0f, 100.0f, 500.0f);
+    scurve.eval(0.0f, p, v, a);
+    EXPECT_LT(v, 500.0f);
+    scurve.eval(scurve.time_total() - 0.0001f, p, v, a);
+    EXPECT_NEAR(100.0f, p, 0.5f);
+}
+
+TEST(SCurveTest, Empty)
+{
+    AC_SCurve scurve;
+    scurve.init(0.0f, 0.0f, 500.0f, 100.0f, 500.0f);
+    EXPECT_TRUE(scurve.finished(0.0f));
+}
+
+/*
+  without a speed or acceleration to move with the profile must hold at
+  the start of the track, not jump to the end of it
+ */
+TEST(SCurveTest, ZeroLimitsHold)
+{
+    AC_SCurve scurve;
+    const float limits[3][3] = {
+        { 0.0f, 100.0f, 500.0f },
+        { 500.0f, 0.0f, 500.0f },
+        { 500.0f, 100.0f, 0.0f },
+    };
+    for (uint8_t i = 0; i < 3; i++) {
+        scurve.init(1000.0f, 0.0f, limits[i][0], limits[i][1], limits[i][2]);
+        EXPECT_FALSE(scurve.finished(0.0f));
+        EXPECT_FALSE(scurve.finished(1000.0f));
+        float p, v, a;
+        scurve.eval(10.0f, p, v, a);
+        EXPECT_FLOAT_EQ(0.0f, p);
+        EXPECT_FLOAT_EQ(0.0f, v);
+        EXPECT_FLOAT_EQ(0.0f, a);
+        // nothing to brake for, so a fast waypoint is not reached
+        EXPECT_GT(scurve.time_total() - 10.0f, scurve.time_braking());
+    }
+
+    // planned again once the limits are valid
+    scurve.init(1000.0f, 0.0f, 500.0f, 100.0f, 500.0f);
+    EXPECT_TRUE(scurve.finished(scurve.time_total()));
+    float p, v, a;
+    scurve.eval(scurve.time_total(), p, v, a);
+    EXPECT_FLOAT_EQ(1000.0f, p);
+}
+
+AP_GTEST_MAIN()
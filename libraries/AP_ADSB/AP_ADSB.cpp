@@ -30,7 +30,7 @@
 
 #define VEHICLE_TIMEOUT_MS              5000   // if no updates in this time, drop it from the list
 #define ADSB_VEHICLE_LIST_SIZE_DEFAULT  25
-#define ADSB_VEHICLE_LIST_SIZE_MAX      100
+#define ADSB_VEHICLE_LIST_SIZE_MAX      500
 #define ADSB_CHAN_TIMEOUT_MS            15000
 
 #if APM_BUILD_TYPE(APM_BUILD_ArduPlane)
@@ -55,7 +55,7 @@ const AP_Param::GroupInfo AP_ADSB::var_info[] = {
     // @Param: LIST_MAX
     // @DisplayName: ADSB vehicle list size
     // @Description: ADSB list size of nearest vehicles. Longer lists take longer to refresh with lower SRx_ADSB values.
-    // @Range: 1 100
+    // @Range: 1 500
     // @User: Advanced
     AP_GROUPINFO("LIST_MAX",   2, AP_ADSB, in_state.list_size_param, ADSB_VEHICLE_LIST_SIZE_DEFAULT),
 
@@ -121,6 +121,7 @@ void AP_ADSB::init(void)
 {
     // in_state
     in_state.vehicle_count = 0;
+    in_state.icao_index.clear();
     if (in_state.vehicle_list == nullptr) {
         if (in_state.list_size_param != constrain_int16(in_state.list_size_param, 1, ADSB_VEHICLE_LIST_SIZE_MAX)) {
             in_state.list_size_param.set_and_notify(ADSB_VEHICLE_LIST_SIZE_DEFAULT);
@@ -129,6 +130,11 @@ void AP_ADSB::init(void)
         in_state.list_size = in_state.list_size_param;
         in_state.vehicle_list = new adsb_vehicle_t[in_state.list_size];
 
+        if (in_state.vehicle_list != nullptr && !in_state.icao_index.init(in_state.list_size)) {
+            delete [] in_state.vehicle_list;
+            in_state.vehicle_list = nullptr;
+        }
+
         if (in_state.vehicle_list == nullptr) {
             // dynamic RAM allocation of _vehicle_list[] failed, disable gracefully
             hal.console->printf("Unable to initialize ADS-B vehicle list\n");
@@ -153,6 +159,7 @@ void AP_ADSB::deinit(void)
         delete [] in_state.vehicle_list;
         in_state.vehicle_list = nullptr;
     }
+    in_state.icao_index.deinit();
 }
 
 /*
@@ -295,8 +302,10 @@ void AP_ADSB::delete_vehicle(const uint16_t index)
             furthest_vehicle_distance = 0;
             furthest_vehicle_index = 0;
         }
+        in_state.icao_index.remove(in_state.vehicle_list[index].info.ICAO_address);
         if (index != (in_state.vehicle_count-1)) {
             in_state.vehicle_list[index] = in_state.vehicle_list[in_state.vehicle_count-1];
+            in_state.icao_index.insert(in_state.vehicle_list[index].info.ICAO_address, index);
         }
         // TODO: is memset needed? When we decrement the index we essentially forget about it
         memset(&in_state.vehicle_list[in_state.vehicle_count-1], 0, sizeof(adsb_vehicle_t));
@@ -311,13 +320,7 @@ void AP_ADSB::delete_vehicle(const uint16_t index)
  */
 bool AP_ADSB::find_index(const adsb_vehicle_t &vehicle, uint16_t *index) const
 {
-    for (uint16_t i = 0; i < in_state.vehicle_count; i++) {
-        if (in_state.vehicle_list[i].info.ICAO_address == vehicle.info.ICAO_address) {
-            *index = i;
-            return true;
-        }
-    }
-    return false;
+    return in_state.icao_index.find(vehicle.info.ICAO_address, *index);
 }
 
 /*
@@ -414,7 +417,13 @@ void AP_ADSB::handle_vehicle(const mavlink_message_t* packet)
 void AP_ADSB::set_vehicle(const uint16_t index, const adsb_vehicle_t &vehicle)
 {
     if (index < in_state.list_size) {
+        // a different vehicle is being replaced, forget its address
+        const uint32_t old_icao = in_state.vehicle_list[index].info.ICAO_address;
+        if (index < in_state.vehicle_count && old_icao != vehicle.info.ICAO_address) {
+            in_state.icao_index.remove(old_icao);
+        }
         in_state.vehicle_list[index] = vehicle;
+        in_state.icao_index.insert(vehicle.info.ICAO_address, index);
     }
 }
 
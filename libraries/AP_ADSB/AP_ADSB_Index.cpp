@@ -0,0 +1,145 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  ICAO address to vehicle list index lookup for AP_ADSB
+*/
+
+#include "AP_ADSB_Index.h"
+
+/*
+ * allocate a table of at least twice max_entries slots
+ */
+bool AP_ADSB_Index::init(uint16_t max_entries)
+{
+    deinit();
+
+    uint8_t bits = 2;
+    while ((1U << bits) < 2U * max_entries && bits < 16) {
+        bits++;
+    }
+    const uint32_t num_slots = 1U << bits;
+
+    _icao = new uint32_t[num_slots];
+    _index = new uint16_t[num_slots];
+    if (_icao == nullptr || _index == nullptr) {
+        deinit();
+        return false;
+    }
+    _mask = num_slots - 1;
+    _shift = 32 - bits;
+    clear();
+    return true;
+}
+
+/*
+ * free the table
+ */
+void AP_ADSB_Index::deinit()
+{
+    delete [] _icao;
+    delete [] _index;
+    _icao = nullptr;
+    _index = nullptr;
+    _mask = 0;
+    _count = 0;
+}
+
+/*
+ * remove all entries
+ */
+void AP_ADSB_Index::clear()
+{
+    if (_icao == nullptr) {
+        return;
+    }
+    for (uint32_t i = 0; i <= _mask; i++) {
+        _icao[i] = EMPTY;
+    }
+    _count = 0;
+}
+
+/*
+ * slot holding an address, or the empty slot ending its probe. The
+ * table is never allowed to fill so the probe always ends
+ */
+uint16_t AP_ADSB_Index::find_slot(uint32_t icao) const
+{
+    uint16_t slot = home_slot(icao);
+    while (_icao[slot] != EMPTY && _icao[slot] != icao) {
+        slot = (slot + 1) & _mask;
+    }
+    return slot;
+}
+
+bool AP_ADSB_Index::find(uint32_t icao, uint16_t &index) const
+{
+    if (_icao == nullptr) {
+        return false;
+    }
+    const uint16_t slot = find_slot(icao);
+    if (_icao[slot] == EMPTY) {
+        return false;
+    }
+    index = _index[slot];
+    return true;
+}
+
+bool AP_ADSB_Index::insert(uint32_t icao, uint16_t index)
+{
+    if (_icao == nullptr || icao == EMPTY) {
+        return false;
+    }
+    const uint16_t slot = find_slot(icao);
+    if (_icao[slot] == EMPTY) {
+        // keep at least one slot empty
+        if (_count >= _mask) {
+            return false;
+        }
+        _icao[slot] = icao;
+        _count++;
+    }
+    _index[slot] = index;
+    return true;
+}
+
+/*
+ * remove an address, moving back any following entries that would
+ * otherwise be cut off from their home slot
+ */
+bool AP_ADSB_Index::remove(uint32_t icao)
+{
+    if (_icao == nullptr) {
+        return false;
+    }
+    uint16_t hole = find_slot(icao);
+    if (_icao[hole] == EMPTY) {
+        return false;
+    }
+
+    uint16_t slot = (hole + 1) & _mask;
+    while (_icao[slot] != EMPTY) {
+        // an entry can fill the hole if its home is not between the hole and its slot
+        const uint16_t home = home_slot(_icao[slot]);
+        if (((slot - home) & _mask) >= ((slot - hole) & _mask)) {
+            _icao[hole] = _icao[slot];
+            _index[hole] = _index[slot];
+            hole = slot;
+        }
+        slot = (slot + 1) & _mask;
+    }
+    _icao[hole] = EMPTY;
+    _count--;
+    return true;
+}
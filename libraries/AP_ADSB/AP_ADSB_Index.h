@@ -0,0 +1,65 @@
+#pragma once
+
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  ICAO address to vehicle list index lookup for AP_ADSB
+
+  Open addressing hash table with linear probing, sized to at least
+  twice the number of entries so probes stay short. Removal shifts the
+  following entries back rather than leaving tombstones, so lookups
+  never slow down as vehicles come and go. Like the vehicle list the
+  table is freed by deinit(), not on destruction.
+*/
+
+#include <AP_Common/AP_Common.h>
+
+class AP_ADSB_Index {
+public:
+    // allocate a table for up to max_entries addresses, returns false on failure
+    bool init(uint16_t max_entries);
+
+    // free the table
+    void deinit();
+
+    // remove all entries
+    void clear();
+
+    // find the index stored for an address, returns false if not found
+    bool find(uint32_t icao, uint16_t &index) const;
+
+    // store the index for an address, replacing any stored index
+    // returns false if the table is full or not allocated
+    bool insert(uint32_t icao, uint16_t index);
+
+    // remove an address, returns false if not found
+    bool remove(uint32_t icao);
+
+private:
+    // ICAO addresses are 24 bit so this never matches a real address
+    static const uint32_t EMPTY = 0xFFFFFFFF;
+
+    // first slot to try for an address
+    uint16_t home_slot(uint32_t icao) const { return (icao * 2654435761U) >> _shift; }
+
+    // slot holding an address, or the empty slot ending its probe
+    uint16_t find_slot(uint32_t icao) const;
+
+    uint32_t    *_icao = nullptr;       // address in each slot, EMPTY if unused
+    uint16_t    *_index = nullptr;      // vehicle list index of each slot
+    uint16_t    _mask = 0;              // number of slots - 1
+    uint8_t     _shift = 0;             // 32 - log2(number of slots)
+    uint16_t    _count = 0;             // number of used slots
+};
@@ -0,0 +1,201 @@
+#include <AP_gbenchmark.h>
+
+#include <AP_ADSB/AP_ADSB_Index.h>
+#include <AP_Avoidance/AP_Avoidance.h>
+
+/*
+  500 aircraft spread around the vehicle the way SITL's ADSB simulator
+  places them: normally distributed within 10km, faster further out.
+  Reports arrive in a shuffled order and 1 in 20 is a new aircraft
+  replacing one that timed out, as AP_ADSB::handle_vehicle sees them
+ */
+
+#define NUM_AIRCRAFT    500
+#define NUM_REPORTS     4096
+#define RADIUS_M        10000
+#define TIME_HORIZON    30
+
+struct aircraft {
+    uint32_t icao;
+    Location loc;
+    Vector3f vel;
+};
+
+static aircraft aircraft_list[NUM_AIRCRAFT];
+static uint32_t reports[NUM_REPORTS];
+static Location my_loc;
+static const Vector3f my_vel(10, 5, 0);
+
+static float rand_normal(float mean, float stddev)
+{
+    const float u1 = (rand() + 1.0f) / (RAND_MAX + 2.0f);
+    const float u2 = rand() / (float)RAND_MAX;
+    return mean + stddev * sqrtf(-2 * logf(u1)) * cosf(M_2PI * u2);
+}
+
+static void setup_aircraft()
+{
+    static bool done;
+    if (done) {
+        return;
+    }
+    srand(1);
+    my_loc.lat = -353632610;
+    my_loc.lng = 1491652300;
+    my_loc.alt = 58400;
+    for (uint16_t i=0; i<NUM_AIRCRAFT; i++) {
+        aircraft &a = aircraft_list[i];
+        a.icao = (rand() & 0x00FFFFFF) | 1;
+        a.loc = my_loc;
+        const Vector2f ofs(rand_normal(0, RADIUS_M), rand_normal(0, RADIUS_M));
+        location_offset(a.loc, ofs.x, ofs.y);
+        a.loc.alt += rand_normal(0, 30000);
+        const float speed_scale = (ofs.length() > 500) ? 3 : 1;
+        a.vel = Vector3f(rand_normal(5, 20) * speed_scale, rand_normal(5, 20) * speed_scale, rand_normal(0, 3));
+    }
+    for (uint16_t i=0; i<NUM_REPORTS; i++) {
+        if (i % 20 == 19) {
+            // an aircraft we haven't seen
+            reports[i] = (rand() & 0x00FFFFFF) | 1;
+        } else {
+            reports[i] = aircraft_list[rand() % NUM_AIRCRAFT].icao;
+        }
+    }
+    done = true;
+}
+
+/*
+  vehicle list kept as AP_ADSB does, optionally with the ICAO index
+ */
+class VehicleList {
+public:
+    VehicleList(bool use_index) : _use_index(use_index) {
+        _index.init(NUM_AIRCRAFT);
+        for (uint16_t i=0; i<NUM_AIRCRAFT; i++) {
+            add(aircraft_list[i].icao);
+        }
+    }
+    ~VehicleList() { _index.deinit(); }
+
+    bool find(uint32_t icao, uint16_t &index) const {
+        if (_use_index) {
+            return _index.find(icao, index);
+        }
+        for (uint16_t i=0; i<_count; i++) {
+            if (_icao[i] == icao) {
+                index = i;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void add(uint32_t icao) {
+        _icao[_count] = icao;
+        _index.insert(icao, _count);
+        _count++;
+    }
+
+    // delete by moving the last vehicle down
+    void remove(uint16_t index) {
+        _index.remove(_icao[index]);
+        _icao[index] = _icao[--_count];
+        if (index != _count) {
+            _index.insert(_icao[index], index);
+        }
+    }
+
+    uint16_t count() const { return _count; }
+
+private:
+    bool _use_index;
+    AP_ADSB_Index _index;
+    uint32_t _icao[NUM_AIRCRAFT];
+    uint16_t _count = 0;
+};
+
+// update the list from a batch of reports, a full list evicts the oldest slot
+static void handle_reports(benchmark::State& state, bool use_index)
+{
+    setup_aircraft();
+    VehicleList list(use_index);
+    uint16_t evict = 0;
+    while (state.KeepRunning()) {
+        for (uint16_t i=0; i<NUM_REPORTS; i++) {
+            uint16_t index;
+            if (!list.find(reports[i], index)) {
+                list.remove(evict);
+                evict = (evict + 7) % list.count();
+                list.add(reports[i]);
+            }
+            gbenchmark_escape(&index);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * NUM_REPORTS);
+}
+
+static void BM_ADSBUpdateLinear(benchmark::State& state)
+{
+    handle_reports(state, false);
+}
+
+static void BM_ADSBUpdateIndex(benchmark::State& state)
+{
+    handle_reports(state, true);
+}
+
+/*
+  the closest approach calculations of AP_Avoidance::update_threat_level,
+  for each aircraft, optionally ruling out distant ones first
+ */
+static void check_threats(benchmark::State& state, bool prefilter)
+{
+    setup_aircraft();
+    const float threat_distance_xy = 300;
+    uint16_t threats = 0;
+    while (state.KeepRunning()) {
+        const LocalTangentFrame my_frame(my_loc);
+        threats = 0;
+        for (uint16_t i=0; i<NUM_AIRCRAFT; i++) {
+            const aircraft &a = aircraft_list[i];
+            if (prefilter &&
+                closest_approach_xy_bound(my_frame, my_vel, a.loc, a.vel, TIME_HORIZON) >= threat_distance_xy) {
+                continue;
+            }
+            float closest_xy = closest_approach_xy(my_loc, my_vel, a.loc, a.vel, TIME_HORIZON);
+            if (closest_xy >= threat_distance_xy) {
+                closest_xy = closest_approach_xy(my_loc, my_vel, a.loc, a.vel, TIME_HORIZON);
+            }
+            float closest_z = closest_approach_z(my_loc, my_vel, a.loc, a.vel, TIME_HORIZON);
+            float distance = get_distance(my_loc, a.loc);
+            gbenchmark_escape(&closest_z);
+            gbenchmark_escape(&distance);
+            if (closest_xy < threat_distance_xy) {
+                threats++;
+            }
+        }
+        gbenchmark_escape(&threats);
+    }
+    state.SetItemsProcessed(state.iterations() * NUM_AIRCRAFT);
+
+    char label[32];
+    snprintf(label, sizeof(label), "%u threats", (unsigned)threats);
+    state.SetLabel(label);
+}
+
+static void BM_ThreatsFull(benchmark::State& state)
+{
+    check_threats(state, false);
+}
+
+static void BM_ThreatsPrefiltered(benchmark::State& state)
+{
+    check_threats(state, true);
+}
+
+BENCHMARK(BM_ADSBUpdateLinear);
+BENCHMARK(BM_ADSBUpdateIndex);
+BENCHMARK(BM_ThreatsFull);
+BENCHMARK(BM_ThreatsPrefiltered);
+
+BENCHMARK_MAIN()
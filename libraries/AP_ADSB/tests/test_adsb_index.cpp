@@ -0,0 +1,164 @@
+#include <AP_gtest.h>
+
+#include <map>
+
+#include <AP_ADSB/AP_ADSB_Index.h>
+
+/*
+  AP_ADSB_Index must behave as a map from ICAO address to vehicle list
+  index however the addresses collide and in whatever order they are
+  added and removed
+ */
+
+static uint32_t seed = 1;
+
+static uint32_t rand_u32(void)
+{
+    seed = seed * 1103515245 + 12345;
+    return seed >> 8;
+}
+
+// check every address in pool against the map
+static void check_all(const AP_ADSB_Index &index, const std::map<uint32_t, uint16_t> &map,
+                      const uint32_t *pool, uint16_t pool_size)
+{
+    for (uint16_t i = 0; i < pool_size; i++) {
+        uint16_t found = 0xFFFF;
+        const auto it = map.find(pool[i]);
+        if (it == map.end()) {
+            EXPECT_FALSE(index.find(pool[i], found)) << "icao " << pool[i];
+        } else {
+            EXPECT_TRUE(index.find(pool[i], found)) << "icao " << pool[i];
+            EXPECT_EQ(it->second, found) << "icao " << pool[i];
+        }
+    }
+}
+
+TEST(AP_ADSB_Index, NotAllocated)
+{
+    AP_ADSB_Index index;
+    uint16_t found;
+    EXPECT_FALSE(index.insert(0x123456, 1));
+    EXPECT_FALSE(index.find(0x123456, found));
+    EXPECT_FALSE(index.remove(0x123456));
+    index.clear();
+}
+
+TEST(AP_ADSB_Index, InsertReplacesIndex)
+{
+    AP_ADSB_Index index;
+    uint16_t found;
+    ASSERT_TRUE(index.init(4));
+    EXPECT_TRUE(index.insert(0x123456, 1));
+    EXPECT_TRUE(index.insert(0x123456, 2));
+    EXPECT_TRUE(index.find(0x123456, found));
+    EXPECT_EQ(2, found);
+    EXPECT_TRUE(index.remove(0x123456));
+    EXPECT_FALSE(index.find(0x123456, found));
+    EXPECT_FALSE(index.remove(0x123456));
+    index.deinit();
+}
+
+// 0xFFFFFFFF marks empty slots so can't be stored
+TEST(AP_ADSB_Index, RejectsEmptyMarker)
+{
+    AP_ADSB_Index index;
+    uint16_t found;
+    ASSERT_TRUE(index.init(4));
+    EXPECT_FALSE(index.insert(0xFFFFFFFF, 1));
+    EXPECT_FALSE(index.find(0xFFFFFFFF, found));
+    index.deinit();
+}
+
+// 8 entries get 16 slots, one of which is always left empty
+TEST(AP_ADSB_Index, Full)
+{
+    AP_ADSB_Index index;
+    uint16_t found;
+    ASSERT_TRUE(index.init(8));
+    for (uint16_t i = 0; i < 15; i++) {
+        EXPECT_TRUE(index.insert(0x100000 + i, i));
+    }
+    EXPECT_FALSE(index.insert(0x200000, 15));
+    EXPECT_FALSE(index.find(0x200000, found));
+
+    // a stored address can still be updated
+    EXPECT_TRUE(index.insert(0x100003, 100));
+    EXPECT_TRUE(index.find(0x100003, found));
+    EXPECT_EQ(100, found);
+
+    index.clear();
+    EXPECT_FALSE(index.find(0x100003, found));
+    EXPECT_TRUE(index.insert(0x200000, 15));
+    index.deinit();
+}
+
+/*
+  a nearly full table has long probe runs which wrap around the end,
+  so removals have to move entries back across colliding home slots
+ */
+TEST(AP_ADSB_Index, RemoveFromFullTable)
+{
+    const uint16_t count = 15;
+    uint32_t pool[count];
+    for (uint16_t pass = 0; pass < 200; pass++) {
+        AP_ADSB_Index index;
+        std::map<uint32_t, uint16_t> map;
+        ASSERT_TRUE(index.init(8));
+        for (uint16_t i = 0; i < count; i++) {
+            pool[i] = rand_u32() & 0xFFFFFF;
+            if (map.count(pool[i]) == 0) {
+                EXPECT_TRUE(index.insert(pool[i], i));
+                map[pool[i]] = i;
+            }
+        }
+        check_all(index, map, pool, count);
+
+        // remove in random order
+        for (uint16_t i = count; i > 0; i--) {
+            const uint16_t j = rand_u32() % i;
+            const uint32_t icao = pool[j];
+            pool[j] = pool[i-1];
+            pool[i-1] = icao;
+            EXPECT_EQ(map.erase(icao) == 1, index.remove(icao));
+            check_all(index, map, pool, count);
+        }
+        index.deinit();
+    }
+}
+
+// random inserts, updates and removals over a small set of addresses
+TEST(AP_ADSB_Index, MatchesMap)
+{
+    const uint16_t pool_size = 48;
+    uint32_t pool[pool_size];
+    for (uint16_t i = 0; i < pool_size; i++) {
+        pool[i] = rand_u32() & 0xFFFFFF;
+    }
+
+    AP_ADSB_Index index;
+    std::map<uint32_t, uint16_t> map;
+    ASSERT_TRUE(index.init(pool_size));
+
+    for (uint32_t op = 0; op < 100000; op++) {
+        const uint32_t icao = pool[rand_u32() % pool_size];
+        const uint16_t value = rand_u32() & 0xFFFF;
+        switch (rand_u32() % 3) {
+        case 0:
+        case 1:
+            EXPECT_TRUE(index.insert(icao, value));
+            map[icao] = value;
+            break;
+        case 2:
+            EXPECT_EQ(map.erase(icao) == 1, index.remove(icao));
+            break;
+        }
+        if (op % 97 == 0) {
+            check_all(index, map, pool, pool_size);
+        }
+    }
+    check_all(index, map, pool, pool_size);
+    index.deinit();
+}
+
+AP_GTEST_MAIN()
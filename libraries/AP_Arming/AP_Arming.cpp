@@ -16,6 +16,7 @@
 #include "AP_Arming.h"
 #include <AP_Notify/AP_Notify.h>
 #include <GCS_MAVLink/GCS.h>
+#include <StorageManager/StorageManager.h>
 
 #define AP_ARMING_COMPASS_MAGFIELD_EXPECTED 530
 #define AP_ARMING_COMPASS_MAGFIELD_MIN  185     // 0.35 * 530 milligauss
@@ -538,6 +539,7 @@ bool AP_Arming::arm(uint8_t method)
     if (checks_to_perform == ARMING_CHECK_NONE) {
         armed = true;
         arming_method = NONE;
+        StorageManager::flush();
         gcs().send_text(MAV_SEVERITY_INFO, "Throttle armed");
         return true;
     }
@@ -546,6 +548,9 @@ bool AP_Arming::arm(uint8_t method)
         armed = true;
         arming_method = method;
 
+        // don't leave parameter or mission writes pending in flight
+        StorageManager::flush();
+
         gcs().send_text(MAV_SEVERITY_INFO, "Throttle armed");
 
         //TODO: Log motor arming to the dataflash
@@ -115,6 +115,13 @@ const AP_Param::GroupInfo AP_Avoidance::var_info[] = {
     // @User: Advanced
     AP_GROUPINFO("F_DIST_Z",    11, AP_Avoidance, _fail_distance_z, AP_AVOIDANCE_FAIL_DISTANCE_Z_DEFAULT),
 
+    // @Param: F_RESOLVE
+    // @DisplayName: Resolve against all obstacles
+    // @Description: When moving horizontally or perpendicularly to avoid a threat, search for the heading and altitude change with the least deviation that keeps clear of all obstacles over F_TIME rather than only moving away from the most serious threat
+    // @Values: 0:Disabled,1:Enabled
+    // @User: Advanced
+    AP_GROUPINFO("F_RESOLVE",   12, AP_Avoidance, _resolve_enabled, 0),
+
     AP_GROUPEND
 };
 
@@ -143,6 +150,14 @@ void AP_Avoidance::init(void)
         }
         _obstacles_allocated = _obstacles_max;
     }
+    if (_intruders == nullptr) {
+        _intruders = new AP_Avoidance_Resolver::Intruder[_obstacles_allocated];
+        // without this we can still avoid the most serious threat
+        if (_intruders == nullptr) {
+            hal.console->printf("Unable to initialize Avoidance resolver\n");
+        }
+    }
+    _resolver.reset();
     _obstacle_count = 0;
     _last_state_change_ms = 0;
     _threat_level = MAV_COLLISION_THREAT_LEVEL_NONE;
@@ -159,6 +174,8 @@ void AP_Avoidance::deinit(void)
         delete [] _obstacles;
         _obstacles = nullptr;
         _obstacles_allocated = 0;
+        delete [] _intruders;
+        _intruders = nullptr;
         handle_recovery(AP_AVOIDANCE_RECOVERY_RTL);
     }
     _obstacle_count = 0;
@@ -290,6 +307,37 @@ float closest_approach_xy(const Location &my_loc,
     return ret;
 }
 
+/*
+  lower bound on closest_approach_xy() for any time horizon up to
+  time_horizon: the obstacles can't close faster than their relative
+  speed.  closest_approach_xy() scales longitude at the obstacle while
+  my_frame scales it at our own latitude, so the east distance is
+  shrunk by the most the longitude scale can fall over the north
+  distance between us
+ */
+float closest_approach_xy_bound(const LocalTangentFrame &my_frame,
+                                const Vector3f &my_vel,
+                                const Location &obstacle_loc,
+                                const Vector3f &obstacle_vel,
+                                const float time_horizon)
+{
+    const Vector2f ofs_ne = my_frame.ne(obstacle_loc);
+
+    // cos(lat + d) >= cos(lat) - |sin(lat)| * |d| - d^2 / 2
+    float lng_scale_ratio = 0.0f;
+    const float cos_lat = my_frame.lng_scale();
+    if (cos_lat > 0.01f) {
+        const float d = fabsf(ofs_ne.x) / RADIUS_OF_EARTH;
+        const float tan_lat = safe_sqrt(1.0f - sq(cos_lat)) / cos_lat;
+        lng_scale_ratio = MAX(1.0f - tan_lat * d - 0.5f * sq(d) / cos_lat, 0.0f);
+    }
+
+    // shaded by 0.1% for rounding
+    const float distance = norm(ofs_ne.x, ofs_ne.y * lng_scale_ratio) * 0.999f;
+    const float closing_speed = norm(obstacle_vel[0] - my_vel[0], obstacle_vel[1] - my_vel[1]);
+    return distance - closing_speed * time_horizon;
+}
+
 // returns the closest these objects will get in the body z axis (in metres)
 float closest_approach_z(const Location &my_loc,
                          const Vector3f &my_vel,
@@ -372,6 +420,34 @@ void AP_Avoidance::update_threat_level(const Location &my_loc,
     }
 }
 
+/*
+  rule out obstacles that can't come within the warn or fail distances
+  in either time horizon, without the full update_threat_level()
+  calculation.  A ruled out obstacle gets the longest possible time to
+  closest approach so any obstacle given the full calculation is
+  considered more serious. Its closest approach is only a bound, so
+  check_for_threats() gives it the full calculation if it is still the
+  most serious threat
+ */
+bool AP_Avoidance::rule_out_threat(const LocalTangentFrame &my_frame,
+                                   const Vector3f &my_vel,
+                                   AP_Avoidance::Obstacle &obstacle) const
+{
+    const uint32_t obstacle_age = AP_HAL::millis() - obstacle.timestamp_ms;
+    const float time_horizon = MAX(_fail_time_horizon, _warn_time_horizon) + obstacle_age/1000;
+    const float closest_xy = closest_approach_xy_bound(my_frame, my_vel, obstacle._location, obstacle._velocity, time_horizon);
+    if (closest_xy < MAX((float)_fail_distance_xy, _warn_distance_xy.get())) {
+        return false;
+    }
+
+    obstacle.threat_level = MAV_COLLISION_THREAT_LEVEL_NONE;
+    obstacle.closest_approach_xy = closest_xy;
+    obstacle.closest_approach_z = closest_approach_z(my_frame.origin(), my_vel, obstacle._location, obstacle._velocity, _warn_time_horizon + obstacle_age/1000);
+    obstacle.distance_to_closest_approach = 0.0f;
+    obstacle.time_to_closest_approach = FLT_MAX;
+    return true;
+}
+
 MAV_COLLISION_THREAT_LEVEL AP_Avoidance::current_threat_level() const {
     if (_obstacles == nullptr) {
         return MAV_COLLISION_THREAT_LEVEL_NONE;
@@ -444,14 +520,19 @@ void AP_Avoidance::check_for_threats()
     // we always check all obstacles to see if they are threats since it
     // is most likely our own position and/or velocity have changed
     // determine the current most-serious-threat
+    const LocalTangentFrame my_frame(my_loc);
     _current_most_serious_threat = -1;
+    bool most_serious_ruled_out = false;
     for (uint8_t i=0; i<_obstacle_count; i++) {
 
         AP_Avoidance::Obstacle &obstacle = _obstacles[i];
         const uint32_t obstacle_age = AP_HAL::millis() - obstacle.timestamp_ms;
         debug("i=%d src_id=%d timestamp=%u age=%d", i, obstacle.src_id, obstacle.timestamp_ms, obstacle_age);
 
-        update_threat_level(my_loc, my_vel, obstacle);
+        const bool ruled_out = rule_out_threat(my_frame, my_vel, obstacle);
+        if (!ruled_out) {
+            update_threat_level(my_loc, my_vel, obstacle);
+        }
         debug("   threat-level=%d", obstacle.threat_level);
 
         // ignore any really old data:
@@ -465,8 +546,16 @@ void AP_Avoidance::check_for_threats()
 
         if (obstacle_is_more_serious_threat(obstacle)) {
             _current_most_serious_threat = i;
+            most_serious_ruled_out = ruled_out;
         }
     }
+
+    // a ruled out obstacle only holds a bound on its closest approach,
+    // work out the real one before it is reported to the GCS. Its threat
+    // level stays at none
+    if (most_serious_ruled_out) {
+        update_threat_level(my_loc, my_vel, _obstacles[_current_most_serious_threat]);
+    }
     if (_current_most_serious_threat != -1) {
         debug("Current most serious threat: %d level=%d", _current_most_serious_threat, _obstacles[_current_most_serious_threat].threat_level);
     }
@@ -523,6 +612,7 @@ void AP_Avoidance::handle_avoidance_local(AP_Avoidance::Obstacle *threat)
             if (_threat_level == MAV_COLLISION_THREAT_LEVEL_HIGH) {
                 handle_recovery(_fail_recovery);
                 _latest_action = MAV_COLLISION_ACTION_NONE;
+                _resolver.reset();
             }
 
             // update state
@@ -613,6 +703,51 @@ bool AP_Avoidance::get_vector_perpendicular(const AP_Avoidance::Obstacle *obstac
     }
 }
 
+// get velocity closest to planned_vel_ned that keeps clear of all obstacles
+bool AP_Avoidance::get_resolution_velocity(const Vector3f &planned_vel_ned, float speed_xy, float speed_up, float speed_down, Vector3f &vel_ned)
+{
+    if (!_resolve_enabled || _intruders == nullptr) {
+        return false;
+    }
+
+    Location my_loc;
+    if (!_ahrs.get_position(my_loc)) {
+        return false;
+    }
+
+    // obstacles relative to us, projected to now
+    const LocalTangentFrame my_frame(my_loc);
+    const uint32_t now = AP_HAL::millis();
+    uint16_t count = 0;
+    for (uint8_t i=0; i<_obstacle_count; i++) {
+        const AP_Avoidance::Obstacle &obstacle = _obstacles[i];
+        const uint32_t obstacle_age = now - obstacle.timestamp_ms;
+        if (obstacle_age > MAX_OBSTACLE_AGE_MS) {
+            continue;
+        }
+        AP_Avoidance_Resolver::Intruder &intruder = _intruders[count++];
+        intruder.vel = obstacle._velocity;
+        intruder.pos = my_frame.ned(obstacle._location) + obstacle._velocity * (obstacle_age * 0.001f);
+    }
+
+    AP_Avoidance_Resolver::Config config;
+    config.separation_xy = _fail_distance_xy;
+    config.separation_z = _fail_distance_z;
+    config.time_horizon = _fail_time_horizon;
+    config.speed_xy = speed_xy;
+    config.speed_up = speed_up;
+    config.speed_down = speed_down;
+    config.vertical = is_positive(speed_up) || is_positive(speed_down);
+
+    AP_Avoidance_Resolver::Result result;
+    if (!_resolver.resolve(config, planned_vel_ned, _intruders, count, AP_AVOIDANCE_RESOLVE_TIME_BUDGET_US, result)) {
+        return false;
+    }
+    debug("resolved heading %d vertical %d after %u candidates", result.heading_change, result.vertical, result.candidates_checked);
+    vel_ned = result.velocity;
+    return true;
+}
+
 // helper functions to calculate 3D destination to get us away from obstacle
 // v1 is NED
 Vector3f AP_Avoidance::perpendicular_xyz(const Location &p1, const Vector3f &v1, const Location &p2)
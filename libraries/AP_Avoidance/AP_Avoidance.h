@@ -27,6 +27,7 @@
 
 #include <AP_AHRS/AP_AHRS.h>
 #include <AP_ADSB/AP_ADSB.h>
+#include "AP_Avoidance_Resolver.h"
 
 // F_RCVRY possible parameter values
 #define AP_AVOIDANCE_RECOVERY_REMAIN_IN_AVOID_ADSB                  0
@@ -38,7 +39,11 @@
 
 #define AP_AVOIDANCE_ESCAPE_TIME_SEC                        2       // vehicle runs from thread for 2 seconds
 
+#define AP_AVOIDANCE_RESOLVE_TIME_BUDGET_US                 1000    // longest search for a manoeuvre clear of all obstacles
+
 class AP_Avoidance {
+    friend class AP_Avoidance_Test;
+
 public:
     // obstacle class to hold latest information for a known obstacles
     class Obstacle {
@@ -128,6 +133,17 @@ protected:
     // get unit vector away from the nearest obstacle
     bool get_vector_perpendicular(const AP_Avoidance::Obstacle *obstacle, Vector3f &vec_neu);
 
+    // get velocity (NED m/s) closest to planned_vel_ned that keeps clear
+    // of all obstacles over the fail time horizon, searching heading
+    // changes at the planned speed (or speed_xy if hovering) combined
+    // with climbing at speed_up or descending at speed_down, both zero
+    // to only change heading.  Returns false if F_RESOLVE is disabled or
+    // no manoeuvre is clear
+    bool get_resolution_velocity(const Vector3f &planned_vel_ned, float speed_xy, float speed_up, float speed_down, Vector3f &vel_ned);
+
+    // true if get_resolution_velocity() should be used
+    bool resolve_enabled() const { return _resolve_enabled != 0; }
+
     // helper functions to calculate destination to get us away from obstacle
     // Note: v1 is NED
     static Vector3f perpendicular_xyz(const Location &p1, const Vector3f &v1, const Location &p2);
@@ -163,6 +179,12 @@ private:
                              const Vector3f &my_vel,
                              AP_Avoidance::Obstacle &obstacle);
 
+    // returns true if the obstacle can't come within the warn or fail
+    // distances, in which case its threat level is set to none
+    bool rule_out_threat(const LocalTangentFrame &my_frame,
+                         const Vector3f &my_vel,
+                         AP_Avoidance::Obstacle &obstacle) const;
+
     // calls into the AP_ADSB library to retrieve vehicle data
     void get_adsb_samples();
 
@@ -175,6 +197,8 @@ private:
     uint8_t _obstacles_allocated;
     uint8_t _obstacle_count;
     int8_t _current_most_serious_threat;
+    AP_Avoidance_Resolver::Intruder *_intruders = nullptr;  // obstacles relative to us, one per entry of _obstacles
+    AP_Avoidance_Resolver _resolver;
     MAV_COLLISION_ACTION _latest_action = MAV_COLLISION_ACTION_NONE;
 
     // external references
@@ -194,6 +218,8 @@ private:
     AP_Int8     _warn_time_horizon;
     AP_Float    _warn_distance_xy;
     AP_Float    _warn_distance_z;
+
+    AP_Int8     _resolve_enabled;
 };
 
 float closest_distance_between_radial_and_point(const Vector2f &w,
@@ -204,6 +230,14 @@ float closest_approach_xy(const Location &my_loc,
                           const Vector3f &obstacle_vel,
                           uint8_t time_horizon);
 
+// returns a lower bound on closest_approach_xy() for any time horizon up
+// to time_horizon.  Much cheaper, so used to rule out distant obstacles
+float closest_approach_xy_bound(const LocalTangentFrame &my_frame,
+                                const Vector3f &my_vel,
+                                const Location &obstacle_loc,
+                                const Vector3f &obstacle_vel,
+                                float time_horizon);
+
 float closest_approach_z(const Location &my_loc,
                          const Vector3f &my_vel,
                          const Location &obstacle_loc,
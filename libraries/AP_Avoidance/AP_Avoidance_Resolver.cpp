@@ -0,0 +1,294 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "AP_Avoidance_Resolver.h"
+
+#include <AP_HAL/AP_HAL.h>
+
+// heading changes searched, in degrees
+static const int16_t resolver_headings[AP_AVOIDANCE_RESOLVER_NUM_HEADINGS] = {
+    0, 15, -15, 30, -30, 45, -45, 60, -60, 90, -90, 120, -120, 150, -150
+};
+
+// deviation costs, a climb costs about the same as a 45 degree turn
+#define RESOLVER_COST_PER_DEGREE    (1.0f / 30.0f)
+#define RESOLVER_COST_CLIMB         1.5f
+#define RESOLVER_COST_DESCEND       2.0f
+
+// cost taken off the previous manoeuvre so we don't swap between two of similar cost
+#define RESOLVER_COST_HOLD          0.5f
+
+// planned horizontal speed below which we are treated as hovering, m/s
+#define RESOLVER_HOVER_SPEED        0.5f
+
+AP_Avoidance_Resolver::AP_Avoidance_Resolver()
+{
+    // build the candidates then sort them by cost. A heading change
+    // with the planned vertical velocity comes before a climb or
+    // descent of the same cost
+    uint8_t n = 0;
+    for (uint8_t v=VERTICAL_PLANNED; v<=VERTICAL_DESCEND; v++) {
+        for (uint8_t h=0; h<AP_AVOIDANCE_RESOLVER_NUM_HEADINGS; h++) {
+            Candidate &c = _candidates[n++];
+            c.heading_change = resolver_headings[h];
+            c.vertical = (Vertical)v;
+            c.cost = abs(c.heading_change) * RESOLVER_COST_PER_DEGREE;
+            if (v == VERTICAL_CLIMB) {
+                c.cost += RESOLVER_COST_CLIMB;
+            } else if (v == VERTICAL_DESCEND) {
+                c.cost += RESOLVER_COST_DESCEND;
+            }
+        }
+    }
+    // insertion sort, stable so equal costs keep the order above
+    for (uint8_t i=1; i<n; i++) {
+        const Candidate c = _candidates[i];
+        uint8_t j = i;
+        while (j > 0 && _candidates[j-1].cost > c.cost) {
+            _candidates[j] = _candidates[j-1];
+            j--;
+        }
+        _candidates[j] = c;
+    }
+    memset(_relevant, 0, sizeof(_relevant));
+}
+
+/*
+  time until our path first enters the volume swept by an intruder.
+
+  Relative to us the intruder moves in a straight line. It is in
+  conflict while both its horizontal distance is below separation_xy
+  and its vertical distance is below separation_z, so find the time
+  range each holds over and check they overlap within the horizon
+ */
+bool AP_Avoidance_Resolver::first_conflict(const Intruder &intruder,
+                                           const Vector3f &my_vel,
+                                           float separation_xy,
+                                           float separation_z,
+                                           float horizon,
+                                           float &conflict_time)
+{
+    const Vector3f rel_vel = intruder.vel - my_vel;
+    const Vector3f &p = intruder.pos;
+
+    // vertical, |p.z + rel_vel.z * t| < separation_z
+    float start = 0;
+    float end = horizon;
+    if (is_zero(rel_vel.z)) {
+        if (fabsf(p.z) >= separation_z) {
+            return false;
+        }
+    } else {
+        float t1 = (-separation_z - p.z) / rel_vel.z;
+        float t2 = (separation_z - p.z) / rel_vel.z;
+        if (t1 > t2) {
+            const float tmp = t1;
+            t1 = t2;
+            t2 = tmp;
+        }
+        start = MAX(start, t1);
+        end = MIN(end, t2);
+        if (start >= end) {
+            return false;
+        }
+    }
+
+    // horizontal, |p.xy + rel_vel.xy * t|^2 < separation_xy^2
+    const float a = sq(rel_vel.x) + sq(rel_vel.y);
+    const float b = 2 * (p.x * rel_vel.x + p.y * rel_vel.y);
+    const float c = sq(p.x) + sq(p.y) - sq(separation_xy);
+    if (is_zero(a)) {
+        if (c >= 0) {
+            return false;
+        }
+    } else {
+        const float disc = sq(b) - 4 * a * c;
+        if (disc <= 0) {
+            return false;
+        }
+        const float root = sqrtf(disc);
+        start = MAX(start, (-b - root) / (2 * a));
+        end = MIN(end, (-b + root) / (2 * a));
+        if (start >= end) {
+            return false;
+        }
+    }
+
+    conflict_time = start;
+    return true;
+}
+
+Vector3f AP_Avoidance_Resolver::candidate_velocity(const Candidate &candidate,
+                                                   const Config &config,
+                                                   const Vector3f &planned_vel)
+{
+    Vector3f vel;
+
+    const Vector2f planned_xy(planned_vel.x, planned_vel.y);
+    const float planned_speed = planned_xy.length();
+    if (candidate.heading_change == 0) {
+        vel.x = planned_vel.x;
+        vel.y = planned_vel.y;
+    } else {
+        // turn away from the planned heading, or from north when hovering
+        float heading;
+        float speed;
+        if (planned_speed < RESOLVER_HOVER_SPEED) {
+            heading = 0;
+            speed = config.speed_xy;
+        } else {
+            heading = atan2f(planned_vel.y, planned_vel.x);
+            speed = planned_speed;
+        }
+        heading += radians(candidate.heading_change);
+        vel.x = cosf(heading) * speed;
+        vel.y = sinf(heading) * speed;
+    }
+
+    switch (candidate.vertical) {
+    case VERTICAL_PLANNED:
+        vel.z = planned_vel.z;
+        break;
+    case VERTICAL_CLIMB:
+        vel.z = -config.speed_up;
+        break;
+    case VERTICAL_DESCEND:
+        vel.z = config.speed_down;
+        break;
+    }
+    return vel;
+}
+
+float AP_Avoidance_Resolver::candidate_conflict_time(const Config &config,
+                                                     const Vector3f &my_vel,
+                                                     const Intruder *intruders,
+                                                     uint16_t num_intruders,
+                                                     float stop_time)
+{
+    float first = config.time_horizon;
+    float t;
+
+    // the intruder in conflict with the last candidate is likely to be
+    // in conflict with this one too, and finding that ends the check early
+    if (_last_conflict < num_intruders &&
+        (_relevant[_last_conflict/32] & (1U << (_last_conflict%32))) &&
+        first_conflict(intruders[_last_conflict], my_vel, config.separation_xy, config.separation_z, config.time_horizon, t)) {
+        first = t;
+        if (first <= stop_time) {
+            return first;
+        }
+    }
+
+    for (uint16_t w=0; w*32<num_intruders; w++) {
+        uint32_t bits = _relevant[w];
+        while (bits != 0) {
+            const uint8_t bit = __builtin_ctz(bits);
+            bits &= bits - 1;
+            const uint16_t i = w*32 + bit;
+            if (first_conflict(intruders[i], my_vel, config.separation_xy, config.separation_z, first, t)) {
+                first = t;
+                _last_conflict = i;
+                if (first <= stop_time) {
+                    return first;
+                }
+            }
+        }
+    }
+    return first;
+}
+
+bool AP_Avoidance_Resolver::resolve(const Config &config,
+                                    const Vector3f &planned_vel,
+                                    const Intruder *intruders,
+                                    uint16_t num_intruders,
+                                    uint32_t time_budget_us,
+                                    Result &result)
+{
+    const uint32_t start_us = AP_HAL::micros();
+
+    num_intruders = MIN(num_intruders, AP_AVOIDANCE_RESOLVER_MAX_INTRUDERS);
+
+    // fastest we can close on an intruder with any manoeuvre
+    const float planned_speed_xy = norm(planned_vel.x, planned_vel.y);
+    const float my_speed_xy = (planned_speed_xy < RESOLVER_HOVER_SPEED) ? MAX(planned_speed_xy, config.speed_xy) : planned_speed_xy;
+    const float my_speed_z = config.vertical ? MAX(fabsf(planned_vel.z), MAX(config.speed_up, config.speed_down)) : fabsf(planned_vel.z);
+
+    // drop intruders which can't come within the separation distances
+    memset(_relevant, 0, sizeof(_relevant));
+    uint16_t num_relevant = 0;
+    for (uint16_t i=0; i<num_intruders; i++) {
+        const Intruder &in = intruders[i];
+        const float reach_xy = (norm(in.vel.x, in.vel.y) + my_speed_xy) * config.time_horizon;
+        const float reach_z = (fabsf(in.vel.z) + my_speed_z) * config.time_horizon;
+        if (norm(in.pos.x, in.pos.y) - reach_xy < config.separation_xy &&
+            fabsf(in.pos.z) - reach_z < config.separation_z) {
+            _relevant[i/32] |= 1U << (i%32);
+            num_relevant++;
+        }
+    }
+
+    // the previous manoeuvre is searched as if it cost a little less
+    const int8_t held = _last_candidate;
+    const float held_cost = (held >= 0) ? _candidates[held].cost - RESOLVER_COST_HOLD : 0;
+    bool held_checked = (held < 0);
+
+    int8_t best = -1;
+    float best_time = -1;
+    uint8_t checked = 0;
+    uint8_t next = 0;
+
+    while (next < AP_AVOIDANCE_RESOLVER_NUM_CANDIDATES) {
+        int8_t idx;
+        if (!held_checked && held_cost <= _candidates[next].cost) {
+            idx = held;
+            held_checked = true;
+        } else {
+            idx = next++;
+            if (idx == held) {
+                continue;
+            }
+        }
+        if (!config.vertical && _candidates[idx].vertical != VERTICAL_PLANNED) {
+            continue;
+        }
+
+        const Vector3f vel = candidate_velocity(_candidates[idx], config, planned_vel);
+        const float t = (num_relevant == 0) ? config.time_horizon :
+            candidate_conflict_time(config, vel, intruders, num_intruders, best_time);
+        checked++;
+        if (t > best_time) {
+            best = idx;
+            best_time = t;
+            result.velocity = vel;
+            if (t >= config.time_horizon) {
+                // conflict free, and nothing after this deviates less
+                break;
+            }
+        }
+
+        if (AP_HAL::micros() - start_us >= time_budget_us) {
+            break;
+        }
+    }
+
+    _last_candidate = best;
+    result.heading_change = _candidates[best].heading_change;
+    result.vertical = _candidates[best].vertical;
+    result.conflict_free = (best_time >= config.time_horizon);
+    result.conflict_time = best_time;
+    result.candidates_checked = checked;
+
+    return result.conflict_free;
+}
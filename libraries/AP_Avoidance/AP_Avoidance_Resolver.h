@@ -0,0 +1,134 @@
+#pragma once
+
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  Conflict resolution against many obstacles for AP_Avoidance
+
+  Our own planned path and each obstacle's path are projected forward
+  in straight lines over the time horizon. Each obstacle sweeps a
+  volume the shape of a stretched cylinder, a capsule in the horizontal
+  plane with the fail distances as its radius and half height, and a
+  manoeuvre is in conflict if our path enters that volume at the same
+  time the obstacle is there.
+
+  A small fixed set of manoeuvres, heading changes combined with
+  climbing or descending, is searched in order of increasing deviation
+  from the planned path and the first one clear of every obstacle is
+  chosen. Obstacles that can't reach us within the horizon whatever we
+  do are dropped before the search. The search stops when the time
+  budget runs out, returning the best manoeuvre found so far.
+*/
+
+#include <AP_Common/AP_Common.h>
+#include <AP_Math/AP_Math.h>
+
+#define AP_AVOIDANCE_RESOLVER_MAX_INTRUDERS     256     // most obstacles considered by one search
+#define AP_AVOIDANCE_RESOLVER_NUM_HEADINGS      15      // heading changes searched, including no change
+#define AP_AVOIDANCE_RESOLVER_NUM_CANDIDATES    (AP_AVOIDANCE_RESOLVER_NUM_HEADINGS * 3)
+
+class AP_Avoidance_Resolver {
+public:
+    AP_Avoidance_Resolver();
+
+    // an obstacle relative to us
+    struct Intruder {
+        Vector3f pos;   // NED metres from our position
+        Vector3f vel;   // NED m/s
+    };
+
+    // limits on the manoeuvres and the separation required
+    struct Config {
+        float separation_xy;    // metres
+        float separation_z;     // metres
+        float time_horizon;     // seconds
+        float speed_xy;         // horizontal speed when no planned velocity, m/s
+        float speed_up;         // climb rate, m/s
+        float speed_down;       // descent rate, m/s
+        bool vertical;          // true to search climbs and descents as well as heading changes
+    };
+
+    enum Vertical {
+        VERTICAL_PLANNED = 0,   // keep the planned vertical velocity
+        VERTICAL_CLIMB   = 1,
+        VERTICAL_DESCEND = 2,
+    };
+
+    // the manoeuvre chosen by resolve()
+    struct Result {
+        Vector3f velocity;          // NED m/s
+        int16_t heading_change;     // degrees from the planned heading
+        Vertical vertical;
+        bool conflict_free;         // false if every manoeuvre searched was in conflict
+        float conflict_time;        // seconds until the first conflict if not conflict free
+        uint8_t candidates_checked;
+    };
+
+    // choose the manoeuvre with the least deviation from planned_vel
+    // (NED m/s) that stays clear of all num_intruders intruders over
+    // the time horizon, searching for at most time_budget_us
+    // microseconds. Returns true if a conflict free manoeuvre was found,
+    // otherwise result holds the manoeuvre putting off conflict longest
+    bool resolve(const Config &config,
+                 const Vector3f &planned_vel,
+                 const Intruder *intruders,
+                 uint16_t num_intruders,
+                 uint32_t time_budget_us,
+                 Result &result);
+
+    // forget the previous manoeuvre, so the next search doesn't favour it
+    void reset() { _last_candidate = -1; }
+
+    // time until our path at velocity my_vel first enters the volume
+    // swept by an intruder, returns false if it never does within horizon
+    static bool first_conflict(const Intruder &intruder,
+                               const Vector3f &my_vel,
+                               float separation_xy,
+                               float separation_z,
+                               float horizon,
+                               float &conflict_time);
+
+private:
+    struct Candidate {
+        int16_t heading_change; // degrees
+        Vertical vertical;
+        float cost;             // deviation from the planned path
+    };
+
+    // velocity of a candidate manoeuvre
+    static Vector3f candidate_velocity(const Candidate &candidate,
+                                       const Config &config,
+                                       const Vector3f &planned_vel);
+
+    // time until the first conflict with any relevant intruder, or
+    // horizon if none. Stops early once below stop_time
+    float candidate_conflict_time(const Config &config,
+                                  const Vector3f &my_vel,
+                                  const Intruder *intruders,
+                                  uint16_t num_intruders,
+                                  float stop_time);
+
+    // candidates sorted by increasing cost
+    Candidate _candidates[AP_AVOIDANCE_RESOLVER_NUM_CANDIDATES];
+
+    // intruders which may come within the separation distances, one bit each
+    uint32_t _relevant[(AP_AVOIDANCE_RESOLVER_MAX_INTRUDERS+31)/32];
+
+    // intruder which last caused a conflict, checked first
+    uint16_t _last_conflict = 0;
+
+    // index of the last manoeuvre chosen, or -1
+    int8_t _last_candidate = -1;
+};
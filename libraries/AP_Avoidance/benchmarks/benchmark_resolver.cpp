@@ -0,0 +1,120 @@
+#include <AP_gbenchmark.h>
+
+#include <AP_Avoidance/AP_Avoidance_Resolver.h>
+
+/*
+  Busy airspace around a copter flying north at 10m/s. Intruders are
+  spread within 5km and the first few of them are put on courses
+  passing within the separation distances of our planned path some time
+  in the horizon, so every decision has to search past the planned path.
+  Each iteration makes one decision for the next of a set of scenes
+ */
+
+#define NUM_SCENES          64
+#define MAX_INTRUDERS       200
+#define RADIUS_M            5000
+#define TIME_HORIZON        30
+#define TIME_BUDGET_US      1000
+#define NUM_CONVERGING      4
+
+static AP_Avoidance_Resolver::Intruder scenes[NUM_SCENES][MAX_INTRUDERS];
+static const Vector3f planned_vel(10, 0, 0);
+static AP_Avoidance_Resolver::Config config;
+
+static float rand_float(float min, float max)
+{
+    return min + (max - min) * (rand() / (float)RAND_MAX);
+}
+
+static void setup_scenes()
+{
+    static bool done;
+    if (done) {
+        return;
+    }
+    srand(1);
+    config.separation_xy = 100;
+    config.separation_z = 100;
+    config.time_horizon = TIME_HORIZON;
+    config.speed_xy = 10;
+    config.speed_up = 2.5;
+    config.speed_down = 1.5;
+    config.vertical = true;
+
+    for (uint8_t s=0; s<NUM_SCENES; s++) {
+        for (uint16_t i=0; i<MAX_INTRUDERS; i++) {
+            AP_Avoidance_Resolver::Intruder &in = scenes[s][i];
+            const float speed = rand_float(5, 60);
+            const float course = rand_float(0, M_2PI);
+            in.vel = Vector3f(cosf(course) * speed, sinf(course) * speed, rand_float(-2, 2));
+            if (i < NUM_CONVERGING) {
+                // work back from a point on our path
+                const float t = rand_float(5, TIME_HORIZON);
+                const Vector3f meet = planned_vel * t + Vector3f(rand_float(-50, 50), rand_float(-50, 50), rand_float(-50, 50));
+                in.pos = meet - in.vel * t;
+            } else {
+                const float range = rand_float(200, RADIUS_M);
+                const float bearing = rand_float(0, M_2PI);
+                in.pos = Vector3f(cosf(bearing) * range, sinf(bearing) * range, rand_float(-300, 300));
+            }
+        }
+    }
+    done = true;
+}
+
+static void BM_Resolve(benchmark::State& state)
+{
+    setup_scenes();
+    const uint16_t num_intruders = state.range_x();
+    AP_Avoidance_Resolver resolver;
+    AP_Avoidance_Resolver::Result result;
+    uint8_t scene = 0;
+    uint32_t decisions = 0;
+    uint32_t conflict_free = 0;
+    uint32_t candidates = 0;
+    while (state.KeepRunning()) {
+        // each scene is a new encounter
+        resolver.reset();
+        if (resolver.resolve(config, planned_vel, scenes[scene], num_intruders, TIME_BUDGET_US, result)) {
+            conflict_free++;
+        }
+        gbenchmark_escape(&result);
+        decisions++;
+        candidates += result.candidates_checked;
+        scene = (scene + 1) % NUM_SCENES;
+    }
+    state.SetItemsProcessed(state.iterations());
+
+    char label[64];
+    snprintf(label, sizeof(label), "%u%% resolved, %.1f candidates",
+             (unsigned)(100 * conflict_free / decisions), candidates / (float)decisions);
+    state.SetLabel(label);
+}
+
+// every intruder against every 15 degrees of heading, the cost of a search without ordering or pruning
+static void BM_ResolveExhaustive(benchmark::State& state)
+{
+    setup_scenes();
+    const uint16_t num_intruders = state.range_x();
+    uint8_t scene = 0;
+    while (state.KeepRunning()) {
+        for (int16_t h=-150; h<=180; h+=15) {
+            const float heading = radians(h);
+            for (uint8_t v=0; v<3; v++) {
+                const Vector3f vel(cosf(heading) * 10, sinf(heading) * 10, v == 0 ? 0 : (v == 1 ? -config.speed_up : config.speed_down));
+                for (uint16_t i=0; i<num_intruders; i++) {
+                    float t;
+                    bool conflict = AP_Avoidance_Resolver::first_conflict(scenes[scene][i], vel, config.separation_xy, config.separation_z, config.time_horizon, t);
+                    gbenchmark_escape(&conflict);
+                }
+            }
+        }
+        scene = (scene + 1) % NUM_SCENES;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_Resolve)->Arg(50)->Arg(200);
+BENCHMARK(BM_ResolveExhaustive)->Arg(50)->Arg(200);
+
+BENCHMARK_MAIN()
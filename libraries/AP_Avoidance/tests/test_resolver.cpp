@@ -0,0 +1,212 @@
+#include <AP_gtest.h>
+
+#include <AP_Avoidance/AP_Avoidance.h>
+
+const AP_HAL::HAL &hal = AP_HAL::get_HAL();
+
+typedef AP_Avoidance_Resolver::Intruder Intruder;
+
+static AP_Avoidance_Resolver::Config make_config(bool vertical)
+{
+    AP_Avoidance_Resolver::Config config;
+    config.separation_xy = 150;
+    config.separation_z = 100;
+    config.time_horizon = 60;
+    config.speed_xy = 10;
+    config.speed_up = 2.5f;
+    config.speed_down = 1.5f;
+    config.vertical = vertical;
+    return config;
+}
+
+static bool conflicts(const AP_Avoidance_Resolver::Config &config, const Intruder &intruder, const Vector3f &my_vel)
+{
+    float t;
+    return AP_Avoidance_Resolver::first_conflict(intruder, my_vel, config.separation_xy,
+                                                 config.separation_z, config.time_horizon, t);
+}
+
+// planned_vel turned by heading_change degrees
+static Vector3f turned(const Vector3f &planned_vel, int16_t heading_change)
+{
+    const float heading = atan2f(planned_vel.y, planned_vel.x) + radians(heading_change);
+    const float speed = norm(planned_vel.x, planned_vel.y);
+    return Vector3f(cosf(heading) * speed, sinf(heading) * speed, planned_vel.z);
+}
+
+TEST(AP_Avoidance_Resolver, NoIntruders)
+{
+    AP_Avoidance_Resolver resolver;
+    const AP_Avoidance_Resolver::Config config = make_config(true);
+    const Vector3f planned_vel(10, 0, 0);
+    AP_Avoidance_Resolver::Result result;
+
+    EXPECT_TRUE(resolver.resolve(config, planned_vel, nullptr, 0, 1000000, result));
+    EXPECT_EQ(0, result.heading_change);
+    EXPECT_EQ(AP_Avoidance_Resolver::VERTICAL_PLANNED, result.vertical);
+    EXPECT_EQ(1, result.candidates_checked);
+    EXPECT_TRUE((result.velocity - planned_vel).is_zero());
+}
+
+/*
+  an intruder 1km ahead flying straight at us at 20m/s. Turning 15
+  degrees still passes within 150m, 30 degrees is clear
+ */
+TEST(AP_Avoidance_Resolver, HeadOn)
+{
+    AP_Avoidance_Resolver resolver;
+    const AP_Avoidance_Resolver::Config config = make_config(false);
+    const Vector3f planned_vel(10, 0, 0);
+    Intruder intruder;
+    intruder.pos = Vector3f(1000, 0, 0);
+    intruder.vel = Vector3f(-20, 0, 0);
+
+    float t;
+    ASSERT_TRUE(AP_Avoidance_Resolver::first_conflict(intruder, planned_vel, config.separation_xy,
+                                                      config.separation_z, config.time_horizon, t));
+    EXPECT_NEAR((1000 - 150) / 30.0f, t, 0.01f);
+
+    AP_Avoidance_Resolver::Result result;
+    EXPECT_TRUE(resolver.resolve(config, planned_vel, &intruder, 1, 1000000, result));
+    EXPECT_TRUE(result.conflict_free);
+    EXPECT_EQ(30, abs(result.heading_change));
+    EXPECT_EQ(AP_Avoidance_Resolver::VERTICAL_PLANNED, result.vertical);
+    EXPECT_NEAR(10.0f, norm(result.velocity.x, result.velocity.y), 0.01f);
+    EXPECT_FALSE(conflicts(config, intruder, result.velocity));
+    EXPECT_TRUE(conflicts(config, intruder, turned(planned_vel, 15)));
+    EXPECT_TRUE(conflicts(config, intruder, turned(planned_vel, -15)));
+}
+
+/*
+  an intruder from the east crossing our path so that we both reach
+  the crossing point after 25 seconds. The smallest heading change
+  clear of it is chosen
+ */
+TEST(AP_Avoidance_Resolver, Crossing)
+{
+    AP_Avoidance_Resolver resolver;
+    const AP_Avoidance_Resolver::Config config = make_config(false);
+    const Vector3f planned_vel(20, 0, 0);
+    Intruder intruder;
+    intruder.pos = Vector3f(500, 500, 0);
+    intruder.vel = Vector3f(0, -20, 0);
+
+    ASSERT_TRUE(conflicts(config, intruder, planned_vel));
+
+    AP_Avoidance_Resolver::Result result;
+    EXPECT_TRUE(resolver.resolve(config, planned_vel, &intruder, 1, 1000000, result));
+    EXPECT_NE(0, result.heading_change);
+    EXPECT_FALSE(conflicts(config, intruder, result.velocity));
+    for (int16_t h = -150; h <= 150; h += 15) {
+        if (abs(h) < abs(result.heading_change)) {
+            EXPECT_TRUE(conflicts(config, intruder, turned(planned_vel, h))) << "heading change " << h;
+        }
+    }
+}
+
+// an intruder too far away to reach us within the horizon is ignored
+TEST(AP_Avoidance_Resolver, DistantIntruder)
+{
+    AP_Avoidance_Resolver resolver;
+    const AP_Avoidance_Resolver::Config config = make_config(true);
+    const Vector3f planned_vel(10, 0, 0);
+    Intruder intruder;
+    intruder.pos = Vector3f(10000, 0, 0);
+    intruder.vel = Vector3f(-20, 0, 0);
+
+    AP_Avoidance_Resolver::Result result;
+    EXPECT_TRUE(resolver.resolve(config, planned_vel, &intruder, 1, 1000000, result));
+    EXPECT_EQ(0, result.heading_change);
+    EXPECT_TRUE((result.velocity - planned_vel).is_zero());
+}
+
+/*
+  the sensor libraries only allow one instance, so the AHRS and ADSB
+  the avoidance library needs are shared by the tests below
+ */
+class AP_AHRS_Fixed : public AP_AHRS_DCM {
+public:
+    AP_AHRS_Fixed(AP_InertialSensor &ins, AP_Baro &baro, AP_GPS &gps) :
+        AP_AHRS_DCM(ins, baro, gps) {}
+
+    bool get_position(struct Location &loc) const override {
+        loc = position;
+        return true;
+    }
+
+    Location position {};
+};
+
+class AP_Avoidance_Test : public AP_Avoidance {
+public:
+    AP_Avoidance_Test(AP_AHRS &ahrs, AP_ADSB &adsb) :
+        AP_Avoidance(ahrs, adsb)
+    {
+        _enabled.set(1);
+        _fail_distance_xy.set(150);
+        _fail_distance_z.set(100);
+        _fail_time_horizon.set(60);
+    }
+
+    // what the vehicle handlers use to choose an escape
+    using AP_Avoidance::resolve_enabled;
+    using AP_Avoidance::get_resolution_velocity;
+    using AP_Avoidance::get_vector_perpendicular;
+
+    void set_resolve(bool enabled) { _resolve_enabled.set(enabled); }
+
+    const Obstacle *obstacle(uint8_t i) const { return (i < _obstacle_count) ? &_obstacles[i] : nullptr; }
+
+protected:
+    MAV_COLLISION_ACTION handle_avoidance(const Obstacle *obstacle, MAV_COLLISION_ACTION requested_action) override {
+        return requested_action;
+    }
+    void handle_recovery(uint8_t recovery_action) override {}
+};
+
+static AP_InertialSensor ins = AP_InertialSensor::create();
+static AP_Baro baro = AP_Baro::create();
+static AP_GPS gps = AP_GPS::create();
+static AP_AHRS_Fixed ahrs(ins, baro, gps);
+static AP_ADSB adsb = AP_ADSB::create(ahrs);
+
+/*
+  a head-on intruder 1km north and 100m east of us. With F_RESOLVE
+  off no resolution is offered, so the vehicle falls back on flying
+  perpendicular to the intruder's velocity, here due west
+ */
+TEST(AP_Avoidance, ResolveDisabledKeepsPerpendicular)
+{
+    AP_Avoidance_Test avoidance(ahrs, adsb);
+    ahrs.position.lat = -353632610;
+    ahrs.position.lng = 1491652300;
+    ahrs.position.alt = 10000;
+
+    Location loc = ahrs.position;
+    location_offset(loc, 1000, 100);
+    avoidance.add_obstacle(AP_HAL::millis(), MAV_COLLISION_SRC_ADSB, 1, loc, Vector3f(-20, 0, 0));
+    const AP_Avoidance::Obstacle *obstacle = avoidance.obstacle(0);
+    ASSERT_NE(nullptr, obstacle);
+
+    const Vector3f planned_vel(10, 0, 0);
+    Vector3f vel;
+
+    avoidance.set_resolve(false);
+    EXPECT_FALSE(avoidance.resolve_enabled());
+    EXPECT_FALSE(avoidance.get_resolution_velocity(planned_vel, 10, 0, 0, vel));
+
+    Vector3f vec_neu;
+    ASSERT_TRUE(avoidance.get_vector_perpendicular(obstacle, vec_neu));
+    EXPECT_NEAR(0.0f, vec_neu.x, 0.01f);
+    EXPECT_NEAR(-1.0f, vec_neu.y, 0.01f);
+    EXPECT_NEAR(0.0f, vec_neu.z, 0.01f);
+
+    // with it on, a heading change clear of the intruder is found
+    avoidance.set_resolve(true);
+    EXPECT_TRUE(avoidance.resolve_enabled());
+    ASSERT_TRUE(avoidance.get_resolution_velocity(planned_vel, 10, 0, 0, vel));
+    EXPECT_NEAR(10.0f, norm(vel.x, vel.y), 0.01f);
+    EXPECT_GT(fabsf(vel.y), 1.0f);
+}
+
+AP_GTEST_MAIN()
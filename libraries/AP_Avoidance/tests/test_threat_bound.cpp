@@ -0,0 +1,73 @@
+#include <AP_gtest.h>
+
+#include <AP_Avoidance/AP_Avoidance.h>
+
+/*
+  AP_Avoidance rules out an obstacle when closest_approach_xy_bound() is
+  beyond the warn and fail distances, so the bound must never be more
+  than closest_approach_xy() for any horizon up to the one it was given
+ */
+
+#define NUM_CASES       20000
+#define MAX_HORIZON     60
+
+static uint32_t seed = 1;
+
+static float rand_float(float lo, float hi)
+{
+    seed = seed * 1103515245 + 12345;
+    return lo + (hi - lo) * ((seed >> 8) & 0xFFFF) / 65535.0f;
+}
+
+static Location make_location(float lat, float lng)
+{
+    Location loc {};
+    loc.lat = lat * 1.0e7f;
+    loc.lng = lng * 1.0e7f;
+    return loc;
+}
+
+// obstacles from a few metres to ADS-B range, at any latitude
+TEST(AP_Avoidance, BoundBelowClosestApproach)
+{
+    uint32_t failures = 0;
+    for (uint32_t i=0; i<NUM_CASES; i++) {
+        const Location my_loc = make_location(rand_float(-89, 89), rand_float(-179, 179));
+        const LocalTangentFrame my_frame(my_loc);
+        const float range = i % 4 == 0 ? rand_float(0, 500) : rand_float(0, 50000);
+        const float bearing = rand_float(0, M_2PI);
+        Location obstacle_loc = my_loc;
+        location_offset(obstacle_loc, cosf(bearing) * range, sinf(bearing) * range);
+        const Vector3f my_vel(rand_float(-50, 50), rand_float(-50, 50), rand_float(-5, 5));
+        const Vector3f obstacle_vel(rand_float(-150, 150), rand_float(-150, 150), rand_float(-5, 5));
+
+        const uint8_t horizon = (uint8_t)rand_float(0, MAX_HORIZON);
+        const float bound = closest_approach_xy_bound(my_frame, my_vel, obstacle_loc, obstacle_vel, horizon);
+        for (uint8_t h=0; h<=horizon; h++) {
+            const float closest = closest_approach_xy(my_loc, my_vel, obstacle_loc, obstacle_vel, h);
+            if (bound > closest) {
+                failures++;
+                ::printf("lat=%d lng=%d range=%.1f horizon=%u h=%u bound=%f closest=%f\n",
+                         my_loc.lat, my_loc.lng, range, horizon, h, bound, closest);
+                break;
+            }
+        }
+    }
+    EXPECT_EQ(0U, failures);
+}
+
+// an obstacle flying straight at us can't be ruled out
+TEST(AP_Avoidance, BoundHeadOn)
+{
+    const Location my_loc = make_location(-35.36f, 149.16f);
+    const LocalTangentFrame my_frame(my_loc);
+    Location obstacle_loc = my_loc;
+    location_offset(obstacle_loc, 1000, 0);
+    const Vector3f my_vel(10, 0, 0);
+    const Vector3f obstacle_vel(-40, 0, 0);
+
+    EXPECT_LT(closest_approach_xy_bound(my_frame, my_vel, obstacle_loc, obstacle_vel, 30), 0.0f);
+    EXPECT_NEAR(closest_approach_xy(my_loc, my_vel, obstacle_loc, obstacle_vel, 30), 0.0f, 1.0f);
+}
+
+AP_GTEST_MAIN()
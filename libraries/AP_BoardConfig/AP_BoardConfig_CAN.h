@@ -95,9 +95,9 @@ public:
 
     static int8_t _st_driver_number[MAX_NUMBER_OF_CAN_INTERFACES];
     static int8_t _st_can_debug[MAX_NUMBER_OF_CAN_INTERFACES];
-#if CONFIG_HAL_BOARD == HAL_BOARD_PX4 || CONFIG_HAL_BOARD == HAL_BOARD_VRBRAIN
-    void px4_setup_canbus(void);
-#endif // HAL_BOARD_PX4 || HAL_BOARD_VRBRAIN
+#if CONFIG_HAL_BOARD == HAL_BOARD_PX4 || CONFIG_HAL_BOARD == HAL_BOARD_VRBRAIN || CONFIG_HAL_BOARD == HAL_BOARD_LINUX
+    void setup_canbus(void);
+#endif // HAL_BOARD_PX4 || HAL_BOARD_VRBRAIN || HAL_BOARD_LINUX
 
 private:
     AP_BoardConfig_CAN() {
@@ -257,6 +257,20 @@ const AP_Param::GroupInfo AP_GPS::var_info[] = {
     // @User: Advanced
     AP_GROUPINFO("BLEND_TC", 21, AP_GPS, _blend_tc, 10.0f),
 
+    // @Param: DETECT
+    // @DisplayName: First GPS last detection
+    // @Description: Receiver type and baud rate found by the last auto-detection on the first GPS port, and whether the receiver has saved its configuration. Detection starts at this baud rate. Maintained automatically, set to 0 to forget it
+    // @ReadOnly: True
+    // @User: Advanced
+    AP_GROUPINFO("DETECT", 22, AP_GPS, _detected[0], 0),
+
+    // @Param: DETECT2
+    // @DisplayName: Second GPS last detection
+    // @Description: Receiver type and baud rate found by the last auto-detection on the second GPS port, and whether the receiver has saved its configuration. Detection starts at this baud rate. Maintained automatically, set to 0 to forget it
+    // @ReadOnly: True
+    // @User: Advanced
+    AP_GROUPINFO("DETECT2", 23, AP_GPS, _detected[1], 0),
+
     AP_GROUPEND
 };
 
@@ -488,75 +502,74 @@ void AP_GPS::detect_instance(uint8_t instance)
         break;
     }
 
+    if (!dstate->detecting) {
+        // start with the baud rate that worked last time. A u-blox
+        // which has saved our configuration needs no init blob
+        dstate->detecting = true;
+        dstate->detect_start_ms = now;
+        const uint32_t last_baud = (uint32_t)_detected[instance] >> GPS_DETECTED_BAUD_SHIFT;
+        for (uint8_t i = 0; i < ARRAY_SIZE(_baudrates); i++) {
+            if (_baudrates[i] == last_baud) {
+                const bool configured = (_detected[instance] & GPS_DETECTED_TYPE_MASK) == GPS_TYPE_UBLOX &&
+                                        config_saved(instance);
+                detect_set_baud(instance, i, !configured);
+                break;
+            }
+        }
+    }
+
     if (now - dstate->last_baud_change_ms > GPS_BAUD_TIME_MS) {
         // try the next baud rate
         // incrementing like this will skip the first element in array of bauds
         // this is okay, and relied upon
-        dstate->current_baud++;
-        if (dstate->current_baud == ARRAY_SIZE(_baudrates)) {
-            dstate->current_baud = 0;
-        }
-        uint32_t baudrate = _baudrates[dstate->current_baud];
-        _port[instance]->begin(baudrate);
-        _port[instance]->set_flow_control(AP_HAL::UARTDriver::FLOW_CONTROL_DISABLE);
-        dstate->last_baud_change_ms = now;
-
-        if (_auto_config == GPS_AUTO_CONFIG_ENABLE) {
-            send_blob_start(instance, _initialisation_blob, sizeof(_initialisation_blob));
+        uint8_t next_baud = dstate->current_baud + 1;
+        if (next_baud == ARRAY_SIZE(_baudrates)) {
+            next_baud = 0;
         }
+        detect_set_baud(instance, next_baud, true);
     }
 
     if (_auto_config == GPS_AUTO_CONFIG_ENABLE) {
         send_blob_update(instance);
     }
 
-    while (initblob_state[instance].remaining == 0 && _port[instance]->available() > 0
-           && new_gps == nullptr) {
-        uint8_t data = _port[instance]->read();
-        /*
-          running a uBlox at less than 38400 will lead to packet
-          corruption, as we can't receive the packets in the 200ms
-          window for 5Hz fixes. The NMEA startup message should force
-          the uBlox into 115200 no matter what rate it is configured
-          for.
-        */
-        if ((_type[instance] == GPS_TYPE_AUTO || _type[instance] == GPS_TYPE_UBLOX) &&
-            ((!_auto_config && _baudrates[dstate->current_baud] >= 38400) ||
-             _baudrates[dstate->current_baud] == 115200) &&
-            AP_GPS_UBLOX::_detect(dstate->ublox_detect_state, data)) {
-            new_gps = new AP_GPS_UBLOX(*this, state[instance], _port[instance]);
-        }
-#if !HAL_MINIMIZE_FEATURES
-        // we drop the MTK drivers when building a small build as they are so rarely used
-        // and are surprisingly large
-        else if ((_type[instance] == GPS_TYPE_AUTO || _type[instance] == GPS_TYPE_MTK19) &&
-                 AP_GPS_MTK19::_detect(dstate->mtk19_detect_state, data)) {
-            new_gps = new AP_GPS_MTK19(*this, state[instance], _port[instance]);
-        } else if ((_type[instance] == GPS_TYPE_AUTO || _type[instance] == GPS_TYPE_MTK) &&
-                   AP_GPS_MTK::_detect(dstate->mtk_detect_state, data)) {
-            new_gps = new AP_GPS_MTK(*this, state[instance], _port[instance]);
-        }
-#endif
-        else if ((_type[instance] == GPS_TYPE_AUTO || _type[instance] == GPS_TYPE_SBP) &&
-                 AP_GPS_SBP2::_detect(dstate->sbp2_detect_state, data)) {
-            new_gps = new AP_GPS_SBP2(*this, state[instance], _port[instance]);
-        }
-        else if ((_type[instance] == GPS_TYPE_AUTO || _type[instance] == GPS_TYPE_SBP) &&
-                 AP_GPS_SBP::_detect(dstate->sbp_detect_state, data)) {
-            new_gps = new AP_GPS_SBP(*this, state[instance], _port[instance]);
-        }
-#if !HAL_MINIMIZE_FEATURES
-        else if ((_type[instance] == GPS_TYPE_AUTO || _type[instance] == GPS_TYPE_SIRF) &&
-                 AP_GPS_SIRF::_detect(dstate->sirf_detect_state, data)) {
-            new_gps = new AP_GPS_SIRF(*this, state[instance], _port[instance]);
-        }
-#endif
-        else if ((_type[instance] == GPS_TYPE_AUTO || _type[instance] == GPS_TYPE_ERB) &&
-                 AP_GPS_ERB::_detect(dstate->erb_detect_state, data)) {
-            new_gps = new AP_GPS_ERB(*this, state[instance], _port[instance]);
-        } else if (_type[instance] == GPS_TYPE_NMEA &&
-                   AP_GPS_NMEA::_detect(dstate->nmea_detect_state, data)) {
-            new_gps = new AP_GPS_NMEA(*this, state[instance], _port[instance]);
+    /*
+      run every enabled detector over each chunk of received data. The
+      first to recognise its protocol wins, with ties going to the
+      detector earliest in enum detect_protocol
+     */
+    if (new_gps == nullptr && initblob_state[instance].remaining == 0) {
+        const uint16_t protocols = detect_protocol_mask(instance);
+        uint8_t buf[GPS_DETECT_CHUNK];
+        int16_t available = _port[instance]->available();
+        while (available > 0 && new_gps == nullptr) {
+            const uint16_t n = MIN(available, (int16_t)sizeof(buf));
+            for (uint16_t i = 0; i < n; i++) {
+                buf[i] = _port[instance]->read();
+            }
+            available -= n;
+
+            uint16_t found_at = n;
+            uint8_t found = DETECT_NUM;
+            for (uint8_t p = 0; p < DETECT_NUM; p++) {
+                if (!(protocols & (1U<<p))) {
+                    continue;
+                }
+                // later detectors only need to look at the bytes
+                // before an earlier detection
+                const int16_t at = run_detector((enum detect_protocol)p, *dstate, buf, found_at);
+                if (at >= 0) {
+                    found = p;
+                    found_at = at;
+                }
+            }
+            if (found != DETECT_NUM) {
+                new_gps = create_detected((enum detect_protocol)found, instance);
+                if (new_gps != nullptr) {
+                    // the rest of the chunk belongs to the driver
+                    new_gps->set_detect_bytes(&buf[found_at+1], n - (found_at+1));
+                }
+            }
         }
     }
 
@@ -566,10 +579,187 @@ found_gps:
         drivers[instance] = new_gps;
         timing[instance].last_message_time_ms = now;
         timing[instance].delta_time_ms = GPS_TIMEOUT_MS;
+        dstate->detect_time_ms = now - dstate->detect_start_ms;
+        dstate->detecting = false;
         new_gps->broadcast_gps_type();
     }
 }
 
+/*
+  switch the port to a new baud rate for detection, optionally sending
+  the init blob to get receivers into binary mode
+ */
+void AP_GPS::detect_set_baud(uint8_t instance, uint8_t baud_index, bool send_config)
+{
+    struct detect_state *dstate = &detect_state[instance];
+
+    dstate->current_baud = baud_index;
+    _port[instance]->begin(_baudrates[baud_index]);
+    _port[instance]->set_flow_control(AP_HAL::UARTDriver::FLOW_CONTROL_DISABLE);
+    dstate->last_baud_change_ms = AP_HAL::millis();
+
+    if (_auto_config == GPS_AUTO_CONFIG_ENABLE && send_config) {
+        send_blob_start(instance, _initialisation_blob, sizeof(_initialisation_blob));
+    }
+}
+
+/*
+  return a bitmask of the detectors to run for an instance at the
+  current baud rate
+ */
+uint16_t AP_GPS::detect_protocol_mask(uint8_t instance) const
+{
+    const uint8_t type = _type[instance];
+    const uint32_t baudrate = _baudrates[detect_state[instance].current_baud];
+    uint16_t mask = 0;
+
+    /*
+      running a uBlox at less than 38400 will lead to packet
+      corruption, as we can't receive the packets in the 200ms
+      window for 5Hz fixes. The NMEA startup message should force
+      the uBlox into 115200 no matter what rate it is configured
+      for.
+    */
+    if ((type == GPS_TYPE_AUTO || type == GPS_TYPE_UBLOX) &&
+        ((!_auto_config && baudrate >= 38400) || baudrate == 115200)) {
+        mask |= 1U<<DETECT_UBLOX;
+    }
+#if !HAL_MINIMIZE_FEATURES
+    // we drop the MTK drivers when building a small build as they are so rarely used
+    // and are surprisingly large
+    if (type == GPS_TYPE_AUTO || type == GPS_TYPE_MTK19) {
+        mask |= 1U<<DETECT_MTK19;
+    }
+    if (type == GPS_TYPE_AUTO || type == GPS_TYPE_MTK) {
+        mask |= 1U<<DETECT_MTK;
+    }
+    if (type == GPS_TYPE_AUTO || type == GPS_TYPE_SIRF) {
+        mask |= 1U<<DETECT_SIRF;
+    }
+#endif
+    if (type == GPS_TYPE_AUTO || type == GPS_TYPE_SBP) {
+        mask |= (1U<<DETECT_SBP2) | (1U<<DETECT_SBP);
+    }
+    if (type == GPS_TYPE_AUTO || type == GPS_TYPE_ERB) {
+        mask |= 1U<<DETECT_ERB;
+    }
+    if (type == GPS_TYPE_NMEA) {
+        mask |= 1U<<DETECT_NMEA;
+    }
+    return mask;
+}
+
+/*
+  feed n bytes to a detector, returning the index of the byte at which
+  it recognised its protocol, or -1
+ */
+template <typename T>
+static int16_t detect_scan(bool (*detect)(T &state, uint8_t data), T &state, const uint8_t *buf, uint16_t n)
+{
+    for (uint16_t i = 0; i < n; i++) {
+        if (detect(state, buf[i])) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+int16_t AP_GPS::run_detector(enum detect_protocol protocol, struct detect_state &dstate, const uint8_t *buf, uint16_t n)
+{
+    switch (protocol) {
+    case DETECT_UBLOX:
+        return detect_scan(AP_GPS_UBLOX::_detect, dstate.ublox_detect_state, buf, n);
+#if !HAL_MINIMIZE_FEATURES
+    case DETECT_MTK19:
+        return detect_scan(AP_GPS_MTK19::_detect, dstate.mtk19_detect_state, buf, n);
+    case DETECT_MTK:
+        return detect_scan(AP_GPS_MTK::_detect, dstate.mtk_detect_state, buf, n);
+    case DETECT_SIRF:
+        return detect_scan(AP_GPS_SIRF::_detect, dstate.sirf_detect_state, buf, n);
+#endif
+    case DETECT_SBP2:
+        return detect_scan(AP_GPS_SBP2::_detect, dstate.sbp2_detect_state, buf, n);
+    case DETECT_SBP:
+        return detect_scan(AP_GPS_SBP::_detect, dstate.sbp_detect_state, buf, n);
+    case DETECT_ERB:
+        return detect_scan(AP_GPS_ERB::_detect, dstate.erb_detect_state, buf, n);
+    case DETECT_NMEA:
+        return detect_scan(AP_GPS_NMEA::_detect, dstate.nmea_detect_state, buf, n);
+    case DETECT_NUM:
+        break;
+    }
+    return -1;
+}
+
+/*
+  create the driver for a detected protocol and remember the protocol
+  and baud rate for the next detection
+ */
+AP_GPS_Backend *AP_GPS::create_detected(enum detect_protocol protocol, uint8_t instance)
+{
+    AP_GPS_Backend *backend = nullptr;
+    GPS_Type type = GPS_TYPE_NONE;
+
+    switch (protocol) {
+    case DETECT_UBLOX:
+        backend = new AP_GPS_UBLOX(*this, state[instance], _port[instance]);
+        type = GPS_TYPE_UBLOX;
+        break;
+#if !HAL_MINIMIZE_FEATURES
+    case DETECT_MTK19:
+        backend = new AP_GPS_MTK19(*this, state[instance], _port[instance]);
+        type = GPS_TYPE_MTK19;
+        break;
+    case DETECT_MTK:
+        backend = new AP_GPS_MTK(*this, state[instance], _port[instance]);
+        type = GPS_TYPE_MTK;
+        break;
+    case DETECT_SIRF:
+        backend = new AP_GPS_SIRF(*this, state[instance], _port[instance]);
+        type = GPS_TYPE_SIRF;
+        break;
+#endif
+    case DETECT_SBP2:
+        backend = new AP_GPS_SBP2(*this, state[instance], _port[instance]);
+        type = GPS_TYPE_SBP;
+        break;
+    case DETECT_SBP:
+        backend = new AP_GPS_SBP(*this, state[instance], _port[instance]);
+        type = GPS_TYPE_SBP;
+        break;
+    case DETECT_ERB:
+        backend = new AP_GPS_ERB(*this, state[instance], _port[instance]);
+        type = GPS_TYPE_ERB;
+        break;
+    case DETECT_NMEA:
+        backend = new AP_GPS_NMEA(*this, state[instance], _port[instance]);
+        type = GPS_TYPE_NMEA;
+        break;
+    case DETECT_NUM:
+        break;
+    }
+
+    if (backend != nullptr) {
+        uint32_t detected = type | (_baudrates[detect_state[instance].current_baud] << GPS_DETECTED_BAUD_SHIFT);
+        if ((detected | GPS_DETECTED_CONFIG_SAVED) == (uint32_t)_detected[instance]) {
+            // same receiver as last time, it still has its configuration
+            detected |= GPS_DETECTED_CONFIG_SAVED;
+        }
+        _detected[instance].set_and_save_ifchanged(detected);
+    }
+    return backend;
+}
+
+void AP_GPS::set_config_saved(uint8_t instance)
+{
+    _detected[instance].set_and_save_ifchanged(_detected[instance] | GPS_DETECTED_CONFIG_SAVED);
+}
+
+bool AP_GPS::config_saved(uint8_t instance) const
+{
+    return (_detected[instance] & GPS_DETECTED_CONFIG_SAVED) != 0;
+}
+
 AP_GPS::GPS_Status AP_GPS::highest_supported_status(uint8_t instance) const
 {
     if (instance < GPS_MAX_RECEIVERS && drivers[instance] != nullptr) {
@@ -35,6 +35,12 @@
 #define GPS_UNKNOWN_DOP UINT16_MAX // set unknown DOP's to maximum value, which is also correct for MAVLink
 #define GPS_WORST_LAG_SEC 0.22f // worst lag value any GPS driver is expected to return, expressed in seconds
 #define GPS_MAX_DELTA_MS 245 // 200 ms (5Hz) + 45 ms buffer
+#define GPS_DETECT_CHUNK 64 // bytes read from the port per pass of the detectors
+
+// packing of the GPS_DETECT parameters
+#define GPS_DETECTED_TYPE_MASK    0xFFU
+#define GPS_DETECTED_CONFIG_SAVED (1U<<8)
+#define GPS_DETECTED_BAUD_SHIFT   9
 
 // the number of GPS leap seconds
 #define GPS_LEAPSECONDS_MILLIS 18000ULL
@@ -62,6 +68,7 @@ class AP_GPS
     friend class AP_GPS_SIRF;
     friend class AP_GPS_UBLOX;
     friend class AP_GPS_Backend;
+    friend class AP_GPS_Detect_Test;
 
 public:
     static AP_GPS create() { return AP_GPS{}; }
@@ -426,6 +433,7 @@ protected:
     AP_Int16 _delay_ms[GPS_MAX_RECEIVERS];
     AP_Int8 _blend_mask;
     AP_Float _blend_tc;
+    AP_Int32 _detected[GPS_MAX_RECEIVERS];
 
     uint32_t _log_gps_bit = -1;
 
@@ -468,6 +476,10 @@ private:
         uint32_t last_baud_change_ms;
         uint8_t current_baud;
         bool auto_detected_baud;
+        bool detecting;
+        uint32_t detect_start_ms;
+        // time taken by the last detection
+        uint32_t detect_time_ms;
         struct UBLOX_detect_state ublox_detect_state;
         struct MTK_detect_state mtk_detect_state;
         struct MTK19_detect_state mtk19_detect_state;
@@ -487,9 +499,35 @@ private:
     static const char _initialisation_blob[];
     static const char _initialisation_raw_blob[];
 
+    // protocol detectors, in order of precedence when two recognise
+    // their protocol at the same byte
+    enum detect_protocol {
+        DETECT_UBLOX = 0,
+#if !HAL_MINIMIZE_FEATURES
+        DETECT_MTK19,
+        DETECT_MTK,
+#endif
+        DETECT_SBP2,
+        DETECT_SBP,
+#if !HAL_MINIMIZE_FEATURES
+        DETECT_SIRF,
+#endif
+        DETECT_ERB,
+        DETECT_NMEA,
+        DETECT_NUM
+    };
+
     void detect_instance(uint8_t instance);
+    void detect_set_baud(uint8_t instance, uint8_t baud_index, bool send_config);
+    uint16_t detect_protocol_mask(uint8_t instance) const;
+    int16_t run_detector(enum detect_protocol protocol, struct detect_state &dstate, const uint8_t *buf, uint16_t n);
+    AP_GPS_Backend *create_detected(enum detect_protocol protocol, uint8_t instance);
     void update_instance(uint8_t instance);
 
+    // called by a driver once the receiver has stored its configuration
+    void set_config_saved(uint8_t instance);
+    bool config_saved(uint8_t instance) const;
+
     /*
       buffer for re-assembling RTCM data for GPS injection.
       The 8 bit flags field in GPS_RTCM_DATA is interpreted as:
@@ -61,11 +61,11 @@ AP_GPS_ERB::read(void)
     int16_t numc;
     bool parsed = false;
 
-    numc = port->available();
+    numc = port_available();
     for (int16_t i = 0; i < numc; i++) {        // Process bytes received
 
         // read the next byte
-        data = port->read();
+        data = port_read();
 
         reset:
         switch(_step) {
@@ -68,9 +68,9 @@ bool AP_GPS_NMEA::read(void)
     int16_t numc;
     bool parsed = false;
 
-    numc = port->available();
+    numc = port_available();
     while (numc--) {
-        char c = port->read();
+        char c = port_read();
 #ifdef NMEA_LOG_PATH
         static FILE *logf = nullptr;
         if (logf == nullptr) {
@@ -101,8 +101,8 @@ void
 AP_GPS_SBP::_sbp_process()
 {
 
-    while (port->available() > 0) {
-        uint8_t temp = port->read();
+    while (port_available() > 0) {
+        uint8_t temp = port_read();
         uint16_t crc;
 
 
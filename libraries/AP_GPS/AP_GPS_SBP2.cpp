@@ -96,10 +96,10 @@ AP_GPS_SBP2::inject_data(const uint8_t *data, uint16_t len)
 void
 AP_GPS_SBP2::_sbp_process()
 {
-    uint32_t nleft = port->available(); 
+    uint32_t nleft = port_available(); 
     while (nleft > 0) {
         nleft--;
-        uint8_t temp = port->read();
+        uint8_t temp = port_read();
         uint16_t crc;
 
         //This switch reads one character at a time,
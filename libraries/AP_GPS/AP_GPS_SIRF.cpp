@@ -60,11 +60,11 @@ AP_GPS_SIRF::read(void)
     int16_t numc;
     bool parsed = false;
 
-    numc = port->available();
+    numc = port_available();
     while(numc--) {
 
         // read the next byte
-        data = port->read();
+        data = port_read();
 
         switch(_step) {
 
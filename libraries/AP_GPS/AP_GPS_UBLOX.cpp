@@ -45,10 +45,9 @@ extern const AP_HAL::HAL& hal;
 
 AP_GPS_UBLOX::AP_GPS_UBLOX(AP_GPS &_gps, AP_GPS::GPS_State &_state, AP_HAL::UARTDriver *_port) :
     AP_GPS_Backend(_gps, _state, _port),
-    _step(0),
+    _framer((uint8_t *)&_buffer, sizeof(_buffer)),
     _msg_id(0),
     _payload_length(0),
-    _payload_counter(0),
     _class(0),
     _cfg_saved(false),
     _last_cfg_sent_time(0),
@@ -343,8 +342,6 @@ AP_GPS_UBLOX::_request_port(void)
 bool
 AP_GPS_UBLOX::read(void)
 {
-    uint8_t data;
-    int16_t numc;
     bool parsed = false;
     uint32_t millis_now = AP_HAL::millis();
 
@@ -366,115 +363,34 @@ AP_GPS_UBLOX::read(void)
     if(!_unconfigured_messages && gps._save_config && !_cfg_saved &&
        _num_cfg_save_tries < 5 && (millis_now - _last_cfg_sent_time) > 5000 &&
        !hal.util->get_soft_armed()) {
-        //save the configuration sent until now
-        if (gps._save_config == 1 ||
+        //save the configuration sent until now. A receiver which
+        //saved it on an earlier boot only needs saving after a change
+        if ((gps._save_config == 1 && (_cfg_needs_save || !gps.config_saved(state.instance))) ||
             (gps._save_config == 2 && _cfg_needs_save)) {
             _save_cfg();
         }
     }
 
-    numc = port->available();
-    for (int16_t i = 0; i < numc; i++) {        // Process bytes received
-
-        // read the next byte
-        data = port->read();
-
-	reset:
-        switch(_step) {
-
-        // Message preamble detection
-        //
-        // If we fail to match any of the expected bytes, we reset
-        // the state machine and re-consider the failed byte as
-        // the first byte of the preamble.  This improves our
-        // chances of recovering from a mismatch and makes it less
-        // likely that we will be fooled by the preamble appearing
-        // as data in some other message.
-        //
-        case 1:
-            if (PREAMBLE2 == data) {
-                _step++;
-                break;
-            }
-            _step = 0;
-            Debug("reset %u", __LINE__);
-            FALLTHROUGH;
-        case 0:
-            if(PREAMBLE1 == data)
-                _step++;
-            break;
-
-        // Message header processing
-        //
-        // We sniff the class and message ID to decide whether we
-        // are going to gather the message bytes or just discard
-        // them.
-        //
-        // We always collect the length so that we can avoid being
-        // fooled by preamble bytes in messages.
-        //
-        case 2:
-            _step++;
-            _class = data;
-            _ck_b = _ck_a = data;                               // reset the checksum accumulators
-            break;
-        case 3:
-            _step++;
-            _ck_b += (_ck_a += data);                   // checksum byte
-            _msg_id = data;
-            break;
-        case 4:
-            _step++;
-            _ck_b += (_ck_a += data);                   // checksum byte
-            _payload_length = data;                             // payload length low byte
-            break;
-        case 5:
-            _step++;
-            _ck_b += (_ck_a += data);                   // checksum byte
-
-            _payload_length += (uint16_t)(data<<8);
-            if (_payload_length > sizeof(_buffer)) {
-                Debug("large payload %u", (unsigned)_payload_length);
-                // assume any payload bigger then what we know about is noise
-                _payload_length = 0;
-                _step = 0;
-				goto reset;
-            }
-            _payload_counter = 0;                               // prepare to receive payload
-            break;
-
-        // Receive message data
-        //
-        case 6:
-            _ck_b += (_ck_a += data);                   // checksum byte
-            if (_payload_counter < sizeof(_buffer)) {
-                _buffer[_payload_counter] = data;
-            }
-            if (++_payload_counter == _payload_length)
-                _step++;
-            break;
-
-        // Checksum and message processing
-        //
-        case 7:
-            _step++;
-            if (_ck_a != data) {
-                Debug("bad cka %x should be %x", data, _ck_a);
-                _step = 0;
-				goto reset;
-            }
-            break;
-        case 8:
-            _step = 0;
-            if (_ck_b != data) {
-                Debug("bad ckb %x should be %x", data, _ck_b);
-                break;                                                  // bad checksum
-            }
-
+    // bytes are taken from the port in blocks and handed to the framer,
+    // which copies each payload straight into _buffer
+    uint8_t buf[UBLOX_READ_BLOCK];
+    int16_t numc = port_available();
+    while (numc > 0) {
+        const uint16_t n = MIN(numc, (int16_t)sizeof(buf));
+        for (uint16_t i = 0; i < n; i++) {
+            buf[i] = port_read();
+        }
+        numc -= n;
+
+        const uint8_t *data = buf;
+        uint16_t len = n;
+        while (_framer.parse(data, len)) {
+            _class = _framer.msg_class();
+            _msg_id = _framer.msg_id();
+            _payload_length = _framer.payload_length();
             if (_parse_gps()) {
                 parsed = true;
             }
-            break;
         }
     }
     return parsed;
@@ -603,499 +519,561 @@ void AP_GPS_UBLOX::unexpected_message(void)
     }
 }
 
+/*
+  message handlers, looked up by class and id. The receive buffer holds
+  the payload and handlers read their fields from it in place. Messages
+  not listed here are passed to unexpected_message(). Most frequent
+  messages first
+ */
+const AP_GPS_UBLOX::ubx_msg_handler AP_GPS_UBLOX::_msg_handlers[] = {
+    { CLASS_NAV, MSG_PVT,              &AP_GPS_UBLOX::_handle_nav_pvt },
+    { CLASS_NAV, MSG_DOP,              &AP_GPS_UBLOX::_handle_nav_dop },
+    { CLASS_NAV, MSG_SOL,              &AP_GPS_UBLOX::_handle_nav_sol },
+    { CLASS_NAV, MSG_POSLLH,           &AP_GPS_UBLOX::_handle_nav_posllh },
+    { CLASS_NAV, MSG_STATUS,           &AP_GPS_UBLOX::_handle_nav_status },
+    { CLASS_NAV, MSG_VELNED,           &AP_GPS_UBLOX::_handle_nav_velned },
+#if UBLOX_RXM_RAW_LOGGING
+    { CLASS_RXM, MSG_RXM_RAWX,         &AP_GPS_UBLOX::_handle_rxm_rawx },
+    { CLASS_RXM, MSG_RXM_RAW,          &AP_GPS_UBLOX::_handle_rxm_raw },
+#endif
+    { CLASS_MON, MSG_MON_HW,           &AP_GPS_UBLOX::_handle_mon_hw },
+    { CLASS_MON, MSG_MON_HW2,          &AP_GPS_UBLOX::_handle_mon_hw2 },
+    { CLASS_ACK, MSG_ACK_ACK,          &AP_GPS_UBLOX::_handle_ack_ack },
+    { CLASS_ACK, MSG_ACK_NACK,         nullptr },
+    { CLASS_CFG, MSG_CFG_MSG,          &AP_GPS_UBLOX::_handle_cfg_msg },
+    { CLASS_CFG, MSG_CFG_RATE,         &AP_GPS_UBLOX::_handle_cfg_rate },
+    { CLASS_CFG, MSG_CFG_NAV_SETTINGS, &AP_GPS_UBLOX::_handle_cfg_nav_settings },
+#if UBLOX_GNSS_SETTINGS
+    { CLASS_CFG, MSG_CFG_GNSS,         &AP_GPS_UBLOX::_handle_cfg_gnss },
+#endif
+    { CLASS_CFG, MSG_CFG_SBAS,         &AP_GPS_UBLOX::_handle_cfg_sbas },
+    { CLASS_CFG, MSG_CFG_PRT,          &AP_GPS_UBLOX::_handle_cfg_prt },
+    { CLASS_MON, MSG_MON_VER,          &AP_GPS_UBLOX::_handle_mon_ver },
+    { CLASS_NAV, MSG_NAV_SVINFO,       &AP_GPS_UBLOX::_handle_nav_svinfo },
+};
+
 bool
 AP_GPS_UBLOX::_parse_gps(void)
 {
-    if (_class == CLASS_ACK) {
-        Debug("ACK %u", (unsigned)_msg_id);
-
-        if(_msg_id == MSG_ACK_ACK) {
-            switch(_buffer.ack.clsID) {
-            case CLASS_CFG:
-                switch(_buffer.ack.msgID) {
-                case MSG_CFG_CFG:
-                    _cfg_saved = true;
-                    _cfg_needs_save = false;
-                    break;
-                case MSG_CFG_GNSS:
-                    _unconfigured_messages &= ~CONFIG_GNSS;
-                    break;
-                case MSG_CFG_MSG:
-                    // There is no way to know what MSG config was ack'ed, assume it was the last
-                    // one requested. To verify it rerequest the last config we sent. If we miss
-                    // the actual ack we will catch it next time through the poll loop, but that
-                    // will be a good chunk of time later.
-                    break;
-                case MSG_CFG_NAV_SETTINGS:
-                    _unconfigured_messages &= ~CONFIG_NAV_SETTINGS;
-                    break;
-                case MSG_CFG_RATE:
-                    // The GPS will ACK a update rate that is invalid. in order to detect this
-                    // only accept the rate as configured by reading the settings back and
-                   //  validating that they all match the target values
-                    break;
-                case MSG_CFG_SBAS:
-                    _unconfigured_messages &= ~CONFIG_SBAS;
-                    break;
-                }
-                break;
-            case CLASS_MON:
-                switch(_buffer.ack.msgID) {
-                case MSG_MON_HW:
-                    _unconfigured_messages &= ~CONFIG_RATE_MON_HW;
-                    break;
-                case MSG_MON_HW2:
-                    _unconfigured_messages &= ~CONFIG_RATE_MON_HW2;
-                    break;
-                }
-            }
+    const struct ubx_msg_handler *h = nullptr;
+    for (uint8_t i=0; i<ARRAY_SIZE(_msg_handlers); i++) {
+        if (_msg_handlers[i].msg_id == _msg_id &&
+            _msg_handlers[i].msg_class == _class) {
+            h = &_msg_handlers[i];
+            break;
         }
+    }
+    if (h == nullptr) {
+        unexpected_message();
         return false;
     }
+    if (h->handler != nullptr) {
+        (this->*h->handler)();
+    }
 
-    if (_class == CLASS_CFG) {
-        switch(_msg_id) {
-        case  MSG_CFG_NAV_SETTINGS:
-	    Debug("Got settings %u min_elev %d drLimit %u\n", 
-                  (unsigned)_buffer.nav_settings.dynModel,
-                  (int)_buffer.nav_settings.minElev,
-                  (unsigned)_buffer.nav_settings.drLimit);
-            _buffer.nav_settings.mask = 0;
-            if (gps._navfilter != AP_GPS::GPS_ENGINE_NONE &&
-                _buffer.nav_settings.dynModel != gps._navfilter) {
-                // we've received the current nav settings, change the engine
-                // settings and send them back
-                Debug("Changing engine setting from %u to %u\n",
-                      (unsigned)_buffer.nav_settings.dynModel, (unsigned)gps._navfilter);
-                _buffer.nav_settings.dynModel = gps._navfilter;
-                _buffer.nav_settings.mask |= 1;
-            }
-            if (gps._min_elevation != -100 &&
-                _buffer.nav_settings.minElev != gps._min_elevation) {
-                Debug("Changing min elevation to %d\n", (int)gps._min_elevation);
-                _buffer.nav_settings.minElev = gps._min_elevation;
-                _buffer.nav_settings.mask |= 2;
-            }
-            if (_buffer.nav_settings.mask != 0) {
-                _send_message(CLASS_CFG, MSG_CFG_NAV_SETTINGS,
-                              &_buffer.nav_settings,
-                              sizeof(_buffer.nav_settings));
-                _unconfigured_messages |= CONFIG_NAV_SETTINGS;
-                _cfg_needs_save = true;
-            } else {
-                _unconfigured_messages &= ~CONFIG_NAV_SETTINGS;
-            }
-            return false;
+    if (_class != CLASS_NAV) {
+        return false;
+    }
 
-#if UBLOX_GNSS_SETTINGS
+    // we only return true when we get new position and speed data
+    // this ensures we don't use stale data
+    if (_new_position && _new_speed && _last_vel_time == _last_pos_time) {
+        _new_speed = _new_position = false;
+        return true;
+    }
+    return false;
+}
+
+void AP_GPS_UBLOX::_handle_ack_ack(void)
+{
+    Debug("ACK %u", (unsigned)_msg_id);
+
+    switch(_buffer.ack.clsID) {
+    case CLASS_CFG:
+        switch(_buffer.ack.msgID) {
+        case MSG_CFG_CFG:
+            _cfg_saved = true;
+            _cfg_needs_save = false;
+            gps.set_config_saved(state.instance);
+            break;
         case MSG_CFG_GNSS:
-            if (gps._gnss_mode[state.instance] != 0) {
-                struct ubx_cfg_gnss start_gnss = _buffer.gnss;
-                uint8_t gnssCount = 0;
-                Debug("Got GNSS Settings %u %u %u %u:\n",
-                    (unsigned)_buffer.gnss.msgVer,
-                    (unsigned)_buffer.gnss.numTrkChHw,
-                    (unsigned)_buffer.gnss.numTrkChUse,
-                    (unsigned)_buffer.gnss.numConfigBlocks);
+            _unconfigured_messages &= ~CONFIG_GNSS;
+            break;
+        case MSG_CFG_MSG:
+            // There is no way to know what MSG config was ack'ed, assume it was the last
+            // one requested. To verify it rerequest the last config we sent. If we miss
+            // the actual ack we will catch it next time through the poll loop, but that
+            // will be a good chunk of time later.
+            break;
+        case MSG_CFG_NAV_SETTINGS:
+            _unconfigured_messages &= ~CONFIG_NAV_SETTINGS;
+            break;
+        case MSG_CFG_RATE:
+            // The GPS will ACK a update rate that is invalid. in order to detect this
+            // only accept the rate as configured by reading the settings back and
+           //  validating that they all match the target values
+            break;
+        case MSG_CFG_SBAS:
+            _unconfigured_messages &= ~CONFIG_SBAS;
+            break;
+        }
+        break;
+    case CLASS_MON:
+        switch(_buffer.ack.msgID) {
+        case MSG_MON_HW:
+            _unconfigured_messages &= ~CONFIG_RATE_MON_HW;
+            break;
+        case MSG_MON_HW2:
+            _unconfigured_messages &= ~CONFIG_RATE_MON_HW2;
+            break;
+        }
+    }
+}
+
+void AP_GPS_UBLOX::_handle_cfg_nav_settings(void)
+{
+    Debug("Got settings %u min_elev %d drLimit %u\n",
+          (unsigned)_buffer.nav_settings.dynModel,
+          (int)_buffer.nav_settings.minElev,
+          (unsigned)_buffer.nav_settings.drLimit);
+    _buffer.nav_settings.mask = 0;
+    if (gps._navfilter != AP_GPS::GPS_ENGINE_NONE &&
+        _buffer.nav_settings.dynModel != gps._navfilter) {
+        // we've received the current nav settings, change the engine
+        // settings and send them back
+        Debug("Changing engine setting from %u to %u\n",
+              (unsigned)_buffer.nav_settings.dynModel, (unsigned)gps._navfilter);
+        _buffer.nav_settings.dynModel = gps._navfilter;
+        _buffer.nav_settings.mask |= 1;
+    }
+    if (gps._min_elevation != -100 &&
+        _buffer.nav_settings.minElev != gps._min_elevation) {
+        Debug("Changing min elevation to %d\n", (int)gps._min_elevation);
+        _buffer.nav_settings.minElev = gps._min_elevation;
+        _buffer.nav_settings.mask |= 2;
+    }
+    if (_buffer.nav_settings.mask != 0) {
+        _send_message(CLASS_CFG, MSG_CFG_NAV_SETTINGS,
+                      &_buffer.nav_settings,
+                      sizeof(_buffer.nav_settings));
+        _unconfigured_messages |= CONFIG_NAV_SETTINGS;
+        _cfg_needs_save = true;
+    } else {
+        _unconfigured_messages &= ~CONFIG_NAV_SETTINGS;
+    }
+}
+
+#if UBLOX_GNSS_SETTINGS
+void AP_GPS_UBLOX::_handle_cfg_gnss(void)
+{
+    if (gps._gnss_mode[state.instance] == 0) {
+        _unconfigured_messages &= ~CONFIG_GNSS;
+        return;
+    }
+
+    struct ubx_cfg_gnss start_gnss = _buffer.gnss;
+    uint8_t gnssCount = 0;
+    Debug("Got GNSS Settings %u %u %u %u:\n",
+        (unsigned)_buffer.gnss.msgVer,
+        (unsigned)_buffer.gnss.numTrkChHw,
+        (unsigned)_buffer.gnss.numTrkChUse,
+        (unsigned)_buffer.gnss.numConfigBlocks);
 #if UBLOX_DEBUGGING
-                for(int i = 0; i < _buffer.gnss.numConfigBlocks; i++) {
-                    Debug("  %u %u %u 0x%08x\n",
-                    (unsigned)_buffer.gnss.configBlock[i].gnssId,
-                    (unsigned)_buffer.gnss.configBlock[i].resTrkCh,
-                    (unsigned)_buffer.gnss.configBlock[i].maxTrkCh,
-                    (unsigned)_buffer.gnss.configBlock[i].flags);
-                }
+    for(int i = 0; i < _buffer.gnss.numConfigBlocks; i++) {
+        Debug("  %u %u %u 0x%08x\n",
+        (unsigned)_buffer.gnss.configBlock[i].gnssId,
+        (unsigned)_buffer.gnss.configBlock[i].resTrkCh,
+        (unsigned)_buffer.gnss.configBlock[i].maxTrkCh,
+        (unsigned)_buffer.gnss.configBlock[i].flags);
+    }
 #endif
 
-                for(int i = 0; i < UBLOX_MAX_GNSS_CONFIG_BLOCKS; i++) {
-                    if((gps._gnss_mode[state.instance] & (1 << i)) && i != GNSS_SBAS) {
-                        gnssCount++;
-                    }
-                }
-
-                for(int i = 0; i < _buffer.gnss.numConfigBlocks; i++) {
-                    // Reserve an equal portion of channels for all enabled systems
-                    if(gps._gnss_mode[state.instance] & (1 << _buffer.gnss.configBlock[i].gnssId)) {
-                        if(GNSS_SBAS !=_buffer.gnss.configBlock[i].gnssId) {
-                            _buffer.gnss.configBlock[i].resTrkCh = (_buffer.gnss.numTrkChHw - 3) / (gnssCount * 2);
-                            _buffer.gnss.configBlock[i].maxTrkCh = _buffer.gnss.numTrkChHw;
-                        } else {
-                            _buffer.gnss.configBlock[i].resTrkCh = 1;
-                            _buffer.gnss.configBlock[i].maxTrkCh = 3;
-                        }
-                        _buffer.gnss.configBlock[i].flags = _buffer.gnss.configBlock[i].flags | 0x00000001;
-                    } else {
-                        _buffer.gnss.configBlock[i].resTrkCh = 0;
-                        _buffer.gnss.configBlock[i].maxTrkCh = 0;
-                        _buffer.gnss.configBlock[i].flags = _buffer.gnss.configBlock[i].flags & 0xFFFFFFFE;
-                    }
-                }
-                if (!memcmp(&start_gnss, &_buffer.gnss, sizeof(start_gnss))) {
-                    _send_message(CLASS_CFG, MSG_CFG_GNSS, &_buffer.gnss, 4 + (8 * _buffer.gnss.numConfigBlocks));
-                    _unconfigured_messages |= CONFIG_GNSS;
-                    _cfg_needs_save = true;
-                } else {
-                    _unconfigured_messages &= ~CONFIG_GNSS;
-                }
-            } else {
-                _unconfigured_messages &= ~CONFIG_GNSS;
-            }
-            return false;
-#endif
+    for(int i = 0; i < UBLOX_MAX_GNSS_CONFIG_BLOCKS; i++) {
+        if((gps._gnss_mode[state.instance] & (1 << i)) && i != GNSS_SBAS) {
+            gnssCount++;
+        }
+    }
 
-        case MSG_CFG_SBAS:
-            if (gps._sbas_mode != 2) {
-	        Debug("Got SBAS settings %u %u %u 0x%x 0x%x\n", 
-                      (unsigned)_buffer.sbas.mode,
-                      (unsigned)_buffer.sbas.usage,
-                      (unsigned)_buffer.sbas.maxSBAS,
-                      (unsigned)_buffer.sbas.scanmode2,
-                      (unsigned)_buffer.sbas.scanmode1);
-                if (_buffer.sbas.mode != gps._sbas_mode) {
-                    _buffer.sbas.mode = gps._sbas_mode;
-                    _send_message(CLASS_CFG, MSG_CFG_SBAS,
-                                  &_buffer.sbas,
-                                  sizeof(_buffer.sbas));
-                    _unconfigured_messages |= CONFIG_SBAS;
-                    _cfg_needs_save = true;
-                } else {
-                    _unconfigured_messages &= ~CONFIG_SBAS;
-                }
-            } else {
-                    _unconfigured_messages &= ~CONFIG_SBAS;
-            }
-            return false;
-        case MSG_CFG_MSG:
-            if(_payload_length == sizeof(ubx_cfg_msg_rate_6)) {
-                // can't verify the setting without knowing the port
-                // request the port again
-                if(_ublox_port >= UBLOX_MAX_PORTS) {
-                    _request_port();
-                    return false;
-                }
-                _verify_rate(_buffer.msg_rate_6.msg_class, _buffer.msg_rate_6.msg_id,
-                             _buffer.msg_rate_6.rates[_ublox_port]);
-            } else {
-                _verify_rate(_buffer.msg_rate.msg_class, _buffer.msg_rate.msg_id,
-                             _buffer.msg_rate.rate);
-            }
-            return false;
-        case MSG_CFG_PRT:
-           _ublox_port = _buffer.prt.portID;
-           return false;
-        case MSG_CFG_RATE:
-            if(_buffer.nav_rate.measure_rate_ms != gps._rate_ms[state.instance] ||
-               _buffer.nav_rate.nav_rate != 1 ||
-               _buffer.nav_rate.timeref != 0) {
-               _configure_rate();
-                _unconfigured_messages |= CONFIG_RATE_NAV;
-                _cfg_needs_save = true;
+    for(int i = 0; i < _buffer.gnss.numConfigBlocks; i++) {
+        // Reserve an equal portion of channels for all enabled systems
+        if(gps._gnss_mode[state.instance] & (1 << _buffer.gnss.configBlock[i].gnssId)) {
+            if(GNSS_SBAS !=_buffer.gnss.configBlock[i].gnssId) {
+                _buffer.gnss.configBlock[i].resTrkCh = (_buffer.gnss.numTrkChHw - 3) / (gnssCount * 2);
+                _buffer.gnss.configBlock[i].maxTrkCh = _buffer.gnss.numTrkChHw;
             } else {
-                _unconfigured_messages &= ~CONFIG_RATE_NAV;
+                _buffer.gnss.configBlock[i].resTrkCh = 1;
+                _buffer.gnss.configBlock[i].maxTrkCh = 3;
             }
-            return false;
+            _buffer.gnss.configBlock[i].flags = _buffer.gnss.configBlock[i].flags | 0x00000001;
+        } else {
+            _buffer.gnss.configBlock[i].resTrkCh = 0;
+            _buffer.gnss.configBlock[i].maxTrkCh = 0;
+            _buffer.gnss.configBlock[i].flags = _buffer.gnss.configBlock[i].flags & 0xFFFFFFFE;
         }
-           
     }
+    if (!memcmp(&start_gnss, &_buffer.gnss, sizeof(start_gnss))) {
+        _send_message(CLASS_CFG, MSG_CFG_GNSS, &_buffer.gnss, 4 + (8 * _buffer.gnss.numConfigBlocks));
+        _unconfigured_messages |= CONFIG_GNSS;
+        _cfg_needs_save = true;
+    } else {
+        _unconfigured_messages &= ~CONFIG_GNSS;
+    }
+}
+#endif
 
-    if (_class == CLASS_MON) {
-        switch(_msg_id) {
-        case MSG_MON_HW:
-            if (_payload_length == 60 || _payload_length == 68) {
-                log_mon_hw();
-            }
-            break;
-        case MSG_MON_HW2:
-            if (_payload_length == 28) {
-                log_mon_hw2();  
-            }
-            break;
-        case MSG_MON_VER:
-            _have_version = true;
-            strncpy(_version.hwVersion, _buffer.mon_ver.hwVersion, sizeof(_version.hwVersion));
-            strncpy(_version.swVersion, _buffer.mon_ver.swVersion, sizeof(_version.swVersion));
-            gcs().send_text(MAV_SEVERITY_INFO, 
-                                             "u-blox %d HW: %s SW: %s",
-                                             state.instance + 1,
-                                             _version.hwVersion,
-                                             _version.swVersion);
-            break;
-        default:
-            unexpected_message();
+void AP_GPS_UBLOX::_handle_cfg_sbas(void)
+{
+    if (gps._sbas_mode == 2) {
+        _unconfigured_messages &= ~CONFIG_SBAS;
+        return;
+    }
+    Debug("Got SBAS settings %u %u %u 0x%x 0x%x\n",
+          (unsigned)_buffer.sbas.mode,
+          (unsigned)_buffer.sbas.usage,
+          (unsigned)_buffer.sbas.maxSBAS,
+          (unsigned)_buffer.sbas.scanmode2,
+          (unsigned)_buffer.sbas.scanmode1);
+    if (_buffer.sbas.mode != gps._sbas_mode) {
+        _buffer.sbas.mode = gps._sbas_mode;
+        _send_message(CLASS_CFG, MSG_CFG_SBAS,
+                      &_buffer.sbas,
+                      sizeof(_buffer.sbas));
+        _unconfigured_messages |= CONFIG_SBAS;
+        _cfg_needs_save = true;
+    } else {
+        _unconfigured_messages &= ~CONFIG_SBAS;
+    }
+}
+
+void AP_GPS_UBLOX::_handle_cfg_msg(void)
+{
+    if(_payload_length == sizeof(ubx_cfg_msg_rate_6)) {
+        // can't verify the setting without knowing the port
+        // request the port again
+        if(_ublox_port >= UBLOX_MAX_PORTS) {
+            _request_port();
+            return;
         }
-        return false;
+        _verify_rate(_buffer.msg_rate_6.msg_class, _buffer.msg_rate_6.msg_id,
+                     _buffer.msg_rate_6.rates[_ublox_port]);
+    } else {
+        _verify_rate(_buffer.msg_rate.msg_class, _buffer.msg_rate.msg_id,
+                     _buffer.msg_rate.rate);
+    }
+}
+
+void AP_GPS_UBLOX::_handle_cfg_prt(void)
+{
+    _ublox_port = _buffer.prt.portID;
+}
+
+void AP_GPS_UBLOX::_handle_cfg_rate(void)
+{
+    if(_buffer.nav_rate.measure_rate_ms != gps._rate_ms[state.instance] ||
+       _buffer.nav_rate.nav_rate != 1 ||
+       _buffer.nav_rate.timeref != 0) {
+        _configure_rate();
+        _unconfigured_messages |= CONFIG_RATE_NAV;
+        _cfg_needs_save = true;
+    } else {
+        _unconfigured_messages &= ~CONFIG_RATE_NAV;
+    }
+}
+
+void AP_GPS_UBLOX::_handle_mon_hw(void)
+{
+    if (_payload_length == 60 || _payload_length == 68) {
+        log_mon_hw();
     }
+}
+
+void AP_GPS_UBLOX::_handle_mon_hw2(void)
+{
+    if (_payload_length == 28) {
+        log_mon_hw2();
+    }
+}
+
+void AP_GPS_UBLOX::_handle_mon_ver(void)
+{
+    _have_version = true;
+    strncpy(_version.hwVersion, _buffer.mon_ver.hwVersion, sizeof(_version.hwVersion));
+    strncpy(_version.swVersion, _buffer.mon_ver.swVersion, sizeof(_version.swVersion));
+    gcs().send_text(MAV_SEVERITY_INFO,
+                                     "u-blox %d HW: %s SW: %s",
+                                     state.instance + 1,
+                                     _version.hwVersion,
+                                     _version.swVersion);
+}
 
 #if UBLOX_RXM_RAW_LOGGING
-    if (_class == CLASS_RXM && _msg_id == MSG_RXM_RAW && gps._raw_data != 0) {
-        log_rxm_raw(_buffer.rxm_raw);
-        return false;
-    } else if (_class == CLASS_RXM && _msg_id == MSG_RXM_RAWX && gps._raw_data != 0) {
-        log_rxm_rawx(_buffer.rxm_rawx);
-        return false;
+void AP_GPS_UBLOX::_handle_rxm_raw(void)
+{
+    if (gps._raw_data == 0) {
+        unexpected_message();
+        return;
     }
-#endif // UBLOX_RXM_RAW_LOGGING
+    log_rxm_raw(_buffer.rxm_raw);
+}
 
-    if (_class != CLASS_NAV) {
+void AP_GPS_UBLOX::_handle_rxm_rawx(void)
+{
+    if (gps._raw_data == 0) {
         unexpected_message();
-        return false;
+        return;
     }
+    log_rxm_rawx(_buffer.rxm_rawx);
+}
+#endif // UBLOX_RXM_RAW_LOGGING
 
-    switch (_msg_id) {
-    case MSG_POSLLH:
-        Debug("MSG_POSLLH next_fix=%u", next_fix);
-        if (havePvtMsg) {
-            _unconfigured_messages |= CONFIG_RATE_POSLLH;
-            break;
-        }
-        _last_pos_time        = _buffer.posllh.time;
-        state.location.lng    = _buffer.posllh.longitude;
-        state.location.lat    = _buffer.posllh.latitude;
-        state.location.alt    = _buffer.posllh.altitude_msl / 10;
-        state.status          = next_fix;
-        _new_position = true;
-        state.horizontal_accuracy = _buffer.posllh.horizontal_accuracy*1.0e-3f;
-        state.vertical_accuracy = _buffer.posllh.vertical_accuracy*1.0e-3f;
-        state.have_horizontal_accuracy = true;
-        state.have_vertical_accuracy = true;
+void AP_GPS_UBLOX::_handle_nav_posllh(void)
+{
+    Debug("MSG_POSLLH next_fix=%u", next_fix);
+    if (havePvtMsg) {
+        _unconfigured_messages |= CONFIG_RATE_POSLLH;
+        return;
+    }
+    _last_pos_time        = _buffer.posllh.time;
+    state.location.lng    = _buffer.posllh.longitude;
+    state.location.lat    = _buffer.posllh.latitude;
+    state.location.alt    = _buffer.posllh.altitude_msl / 10;
+    state.status          = next_fix;
+    _new_position = true;
+    state.horizontal_accuracy = _buffer.posllh.horizontal_accuracy*1.0e-3f;
+    state.vertical_accuracy = _buffer.posllh.vertical_accuracy*1.0e-3f;
+    state.have_horizontal_accuracy = true;
+    state.have_vertical_accuracy = true;
 #if UBLOX_FAKE_3DLOCK
-        state.location.lng = 1491652300L;
-        state.location.lat = -353632610L;
-        state.location.alt = 58400;
-        state.vertical_accuracy = 0;
-        state.horizontal_accuracy = 0;
+    state.location.lng = 1491652300L;
+    state.location.lat = -353632610L;
+    state.location.alt = 58400;
+    state.vertical_accuracy = 0;
+    state.horizontal_accuracy = 0;
 #endif
-        break;
-    case MSG_STATUS:
-        Debug("MSG_STATUS fix_status=%u fix_type=%u",
-              _buffer.status.fix_status,
-              _buffer.status.fix_type);
-        if (havePvtMsg) {
-            _unconfigured_messages |= CONFIG_RATE_STATUS;
-            break;
-        }
-        if (_buffer.status.fix_status & NAV_STATUS_FIX_VALID) {
-            if( (_buffer.status.fix_type == AP_GPS_UBLOX::FIX_3D) &&
-                (_buffer.status.fix_status & AP_GPS_UBLOX::NAV_STATUS_DGPS_USED)) {
-                next_fix = AP_GPS::GPS_OK_FIX_3D_DGPS;
-            }else if( _buffer.status.fix_type == AP_GPS_UBLOX::FIX_3D) {
-                next_fix = AP_GPS::GPS_OK_FIX_3D;
-            }else if (_buffer.status.fix_type == AP_GPS_UBLOX::FIX_2D) {
-                next_fix = AP_GPS::GPS_OK_FIX_2D;
-            }else{
-                next_fix = AP_GPS::NO_FIX;
-                state.status = AP_GPS::NO_FIX;
-            }
+}
+
+void AP_GPS_UBLOX::_handle_nav_status(void)
+{
+    Debug("MSG_STATUS fix_status=%u fix_type=%u",
+          _buffer.status.fix_status,
+          _buffer.status.fix_type);
+    if (havePvtMsg) {
+        _unconfigured_messages |= CONFIG_RATE_STATUS;
+        return;
+    }
+    if (_buffer.status.fix_status & NAV_STATUS_FIX_VALID) {
+        if( (_buffer.status.fix_type == AP_GPS_UBLOX::FIX_3D) &&
+            (_buffer.status.fix_status & AP_GPS_UBLOX::NAV_STATUS_DGPS_USED)) {
+            next_fix = AP_GPS::GPS_OK_FIX_3D_DGPS;
+        }else if( _buffer.status.fix_type == AP_GPS_UBLOX::FIX_3D) {
+            next_fix = AP_GPS::GPS_OK_FIX_3D;
+        }else if (_buffer.status.fix_type == AP_GPS_UBLOX::FIX_2D) {
+            next_fix = AP_GPS::GPS_OK_FIX_2D;
         }else{
             next_fix = AP_GPS::NO_FIX;
             state.status = AP_GPS::NO_FIX;
         }
+    }else{
+        next_fix = AP_GPS::NO_FIX;
+        state.status = AP_GPS::NO_FIX;
+    }
 #if UBLOX_FAKE_3DLOCK
-        state.status = AP_GPS::GPS_OK_FIX_3D;
-        next_fix = state.status;
+    state.status = AP_GPS::GPS_OK_FIX_3D;
+    next_fix = state.status;
 #endif
-        break;
-    case MSG_DOP:
-        Debug("MSG_DOP");
-        noReceivedHdop = false;
-        state.hdop        = _buffer.dop.hDOP;
-        state.vdop        = _buffer.dop.vDOP;
+}
+
+void AP_GPS_UBLOX::_handle_nav_dop(void)
+{
+    Debug("MSG_DOP");
+    noReceivedHdop = false;
+    state.hdop        = _buffer.dop.hDOP;
+    state.vdop        = _buffer.dop.vDOP;
 #if UBLOX_FAKE_3DLOCK
-        state.hdop = 130;
-        state.hdop = 170;
+    state.hdop = 130;
+    state.hdop = 170;
 #endif
-        break;
-    case MSG_SOL:
-        Debug("MSG_SOL fix_status=%u fix_type=%u",
-              _buffer.solution.fix_status,
-              _buffer.solution.fix_type);
-        if (havePvtMsg) {
-            state.time_week = _buffer.solution.week;
-            break;
-        }
-        if (_buffer.solution.fix_status & NAV_STATUS_FIX_VALID) {
-            if( (_buffer.solution.fix_type == AP_GPS_UBLOX::FIX_3D) &&
-                (_buffer.solution.fix_status & AP_GPS_UBLOX::NAV_STATUS_DGPS_USED)) {
-                next_fix = AP_GPS::GPS_OK_FIX_3D_DGPS;
-            }else if( _buffer.solution.fix_type == AP_GPS_UBLOX::FIX_3D) {
-                next_fix = AP_GPS::GPS_OK_FIX_3D;
-            }else if (_buffer.solution.fix_type == AP_GPS_UBLOX::FIX_2D) {
-                next_fix = AP_GPS::GPS_OK_FIX_2D;
-            }else{
-                next_fix = AP_GPS::NO_FIX;
-                state.status = AP_GPS::NO_FIX;
-            }
+}
+
+void AP_GPS_UBLOX::_handle_nav_sol(void)
+{
+    Debug("MSG_SOL fix_status=%u fix_type=%u",
+          _buffer.solution.fix_status,
+          _buffer.solution.fix_type);
+    if (havePvtMsg) {
+        state.time_week = _buffer.solution.week;
+        return;
+    }
+    if (_buffer.solution.fix_status & NAV_STATUS_FIX_VALID) {
+        if( (_buffer.solution.fix_type == AP_GPS_UBLOX::FIX_3D) &&
+            (_buffer.solution.fix_status & AP_GPS_UBLOX::NAV_STATUS_DGPS_USED)) {
+            next_fix = AP_GPS::GPS_OK_FIX_3D_DGPS;
+        }else if( _buffer.solution.fix_type == AP_GPS_UBLOX::FIX_3D) {
+            next_fix = AP_GPS::GPS_OK_FIX_3D;
+        }else if (_buffer.solution.fix_type == AP_GPS_UBLOX::FIX_2D) {
+            next_fix = AP_GPS::GPS_OK_FIX_2D;
         }else{
             next_fix = AP_GPS::NO_FIX;
             state.status = AP_GPS::NO_FIX;
         }
-        if(noReceivedHdop) {
-            state.hdop = _buffer.solution.position_DOP;
-        }
-        state.num_sats    = _buffer.solution.satellites;
-        if (next_fix >= AP_GPS::GPS_OK_FIX_2D) {
-            state.last_gps_time_ms = AP_HAL::millis();
-            state.time_week_ms    = _buffer.solution.time;
-            state.time_week       = _buffer.solution.week;
-        }
-#if UBLOX_FAKE_3DLOCK
-        next_fix = state.status;
-        state.num_sats = 10;
-        state.time_week = 1721;
-        state.time_week_ms = AP_HAL::millis() + 3*60*60*1000 + 37000;
-        state.last_gps_time_ms = AP_HAL::millis();
-        state.hdop = 130;
-#endif
-        break;
-    case MSG_PVT:
-        Debug("MSG_PVT");
-        havePvtMsg = true;
-        // position
-        _last_pos_time        = _buffer.pvt.itow;
-        state.location.lng    = _buffer.pvt.lon;
-        state.location.lat    = _buffer.pvt.lat;
-        state.location.alt    = _buffer.pvt.h_msl / 10;
-        switch (_buffer.pvt.fix_type) 
-        {
-            case 0:
-                state.status = AP_GPS::NO_FIX;
-                break;
-            case 1:
-                state.status = AP_GPS::NO_FIX;
-                break;
-            case 2:
-                state.status = AP_GPS::GPS_OK_FIX_2D;
-                break;
-            case 3:
-                state.status = AP_GPS::GPS_OK_FIX_3D;
-                if (_buffer.pvt.flags & 0b00000010)  // diffsoln
-                    state.status = AP_GPS::GPS_OK_FIX_3D_DGPS;
-                if (_buffer.pvt.flags & 0b01000000)  // carrsoln - float
-                    state.status = AP_GPS::GPS_OK_FIX_3D_RTK_FLOAT;
-                if (_buffer.pvt.flags & 0b10000000)  // carrsoln - fixed
-                    state.status = AP_GPS::GPS_OK_FIX_3D_RTK_FIXED;
-                break;
-            case 4:
-                gcs().send_text(MAV_SEVERITY_INFO,
-                                "Unexpected state %d", _buffer.pvt.flags);
-                state.status = AP_GPS::GPS_OK_FIX_3D;
-                break;
-            case 5:
-                state.status = AP_GPS::NO_FIX;
-                break;
-            default:
-                state.status = AP_GPS::NO_FIX;
-                break;
-        }
-        next_fix = state.status;
-        _new_position = true;
-        state.horizontal_accuracy = _buffer.pvt.h_acc*1.0e-3f;
-        state.vertical_accuracy = _buffer.pvt.v_acc*1.0e-3f;
-        state.have_horizontal_accuracy = true;
-        state.have_vertical_accuracy = true;
-        // SVs
-        state.num_sats    = _buffer.pvt.num_sv;
-        // velocity     
-        _last_vel_time         = _buffer.pvt.itow;
-        state.ground_speed     = _buffer.pvt.gspeed*0.001f;          // m/s
-        state.ground_course    = wrap_360(_buffer.pvt.head_mot * 1.0e-5f);       // Heading 2D deg * 100000
-        state.have_vertical_velocity = true;
-        state.velocity.x = _buffer.pvt.velN * 0.001f;
-        state.velocity.y = _buffer.pvt.velE * 0.001f;
-        state.velocity.z = _buffer.pvt.velD * 0.001f;
-        state.have_speed_accuracy = true;
-        state.speed_accuracy = _buffer.pvt.s_acc*0.001f;
-        _new_speed = true;
-        // dop
-        if(noReceivedHdop) {
-            state.hdop        = _buffer.pvt.p_dop;
-            state.vdop        = _buffer.pvt.p_dop;
-        }
-                    
+    }else{
+        next_fix = AP_GPS::NO_FIX;
+        state.status = AP_GPS::NO_FIX;
+    }
+    if(noReceivedHdop) {
+        state.hdop = _buffer.solution.position_DOP;
+    }
+    state.num_sats    = _buffer.solution.satellites;
+    if (next_fix >= AP_GPS::GPS_OK_FIX_2D) {
         state.last_gps_time_ms = AP_HAL::millis();
-        
-        // time
-        state.time_week_ms    = _buffer.pvt.itow;
+        state.time_week_ms    = _buffer.solution.time;
+        state.time_week       = _buffer.solution.week;
+    }
 #if UBLOX_FAKE_3DLOCK
-        state.location.lng = 1491652300L;
-        state.location.lat = -353632610L;
-        state.location.alt = 58400;
-        state.vertical_accuracy = 0;
-        state.horizontal_accuracy = 0;
-        state.status = AP_GPS::GPS_OK_FIX_3D;
-        state.num_sats = 10;
-        state.time_week = 1721;
-        state.time_week_ms = AP_HAL::millis() + 3*60*60*1000 + 37000;
-        state.last_gps_time_ms = AP_HAL::millis();
-        state.hdop = 130;
-        next_fix = state.status;
+    next_fix = state.status;
+    state.num_sats = 10;
+    state.time_week = 1721;
+    state.time_week_ms = AP_HAL::millis() + 3*60*60*1000 + 37000;
+    state.last_gps_time_ms = AP_HAL::millis();
+    state.hdop = 130;
 #endif
-        break;
-    case MSG_VELNED:
-        Debug("MSG_VELNED");
-        if (havePvtMsg) {
-            _unconfigured_messages |= CONFIG_RATE_VELNED;
+}
+
+void AP_GPS_UBLOX::_handle_nav_pvt(void)
+{
+    Debug("MSG_PVT");
+    havePvtMsg = true;
+    // position
+    _last_pos_time        = _buffer.pvt.itow;
+    state.location.lng    = _buffer.pvt.lon;
+    state.location.lat    = _buffer.pvt.lat;
+    state.location.alt    = _buffer.pvt.h_msl / 10;
+    switch (_buffer.pvt.fix_type) 
+    {
+        case 0:
+            state.status = AP_GPS::NO_FIX;
             break;
-        }
-        _last_vel_time         = _buffer.velned.time;
-        state.ground_speed     = _buffer.velned.speed_2d*0.01f;          // m/s
-        state.ground_course    = wrap_360(_buffer.velned.heading_2d * 1.0e-5f);       // Heading 2D deg * 100000
-        state.have_vertical_velocity = true;
-        state.velocity.x = _buffer.velned.ned_north * 0.01f;
-        state.velocity.y = _buffer.velned.ned_east * 0.01f;
-        state.velocity.z = _buffer.velned.ned_down * 0.01f;
-        state.ground_course = wrap_360(degrees(atan2f(state.velocity.y, state.velocity.x)));
-        state.ground_speed = norm(state.velocity.y, state.velocity.x);
-        state.have_speed_accuracy = true;
-        state.speed_accuracy = _buffer.velned.speed_accuracy*0.01f;
+        case 1:
+            state.status = AP_GPS::NO_FIX;
+            break;
+        case 2:
+            state.status = AP_GPS::GPS_OK_FIX_2D;
+            break;
+        case 3:
+            state.status = AP_GPS::GPS_OK_FIX_3D;
+            if (_buffer.pvt.flags & 0b00000010)  // diffsoln
+                state.status = AP_GPS::GPS_OK_FIX_3D_DGPS;
+            if (_buffer.pvt.flags & 0b01000000)  // carrsoln - float
+                state.status = AP_GPS::GPS_OK_FIX_3D_RTK_FLOAT;
+            if (_buffer.pvt.flags & 0b10000000)  // carrsoln - fixed
+                state.status = AP_GPS::GPS_OK_FIX_3D_RTK_FIXED;
+            break;
+        case 4:
+            gcs().send_text(MAV_SEVERITY_INFO,
+                            "Unexpected state %d", _buffer.pvt.flags);
+            state.status = AP_GPS::GPS_OK_FIX_3D;
+            break;
+        case 5:
+            state.status = AP_GPS::NO_FIX;
+            break;
+        default:
+            state.status = AP_GPS::NO_FIX;
+            break;
+    }
+    next_fix = state.status;
+    _new_position = true;
+    state.horizontal_accuracy = _buffer.pvt.h_acc*1.0e-3f;
+    state.vertical_accuracy = _buffer.pvt.v_acc*1.0e-3f;
+    state.have_horizontal_accuracy = true;
+    state.have_vertical_accuracy = true;
+    // SVs
+    state.num_sats    = _buffer.pvt.num_sv;
+    // velocity     
+    _last_vel_time         = _buffer.pvt.itow;
+    state.ground_speed     = _buffer.pvt.gspeed*0.001f;          // m/s
+    state.ground_course    = wrap_360(_buffer.pvt.head_mot * 1.0e-5f);       // Heading 2D deg * 100000
+    state.have_vertical_velocity = true;
+    state.velocity.x = _buffer.pvt.velN * 0.001f;
+    state.velocity.y = _buffer.pvt.velE * 0.001f;
+    state.velocity.z = _buffer.pvt.velD * 0.001f;
+    state.have_speed_accuracy = true;
+    state.speed_accuracy = _buffer.pvt.s_acc*0.001f;
+    _new_speed = true;
+    // dop
+    if(noReceivedHdop) {
+        state.hdop        = _buffer.pvt.p_dop;
+        state.vdop        = _buffer.pvt.p_dop;
+    }
+                
+    state.last_gps_time_ms = AP_HAL::millis();
+    
+    // time
+    state.time_week_ms    = _buffer.pvt.itow;
 #if UBLOX_FAKE_3DLOCK
-        state.speed_accuracy = 0;
+    state.location.lng = 1491652300L;
+    state.location.lat = -353632610L;
+    state.location.alt = 58400;
+    state.vertical_accuracy = 0;
+    state.horizontal_accuracy = 0;
+    state.status = AP_GPS::GPS_OK_FIX_3D;
+    state.num_sats = 10;
+    state.time_week = 1721;
+    state.time_week_ms = AP_HAL::millis() + 3*60*60*1000 + 37000;
+    state.last_gps_time_ms = AP_HAL::millis();
+    state.hdop = 130;
+    next_fix = state.status;
 #endif
-        _new_speed = true;
-        break;
-    case MSG_NAV_SVINFO:
-        {
-        Debug("MSG_NAV_SVINFO\n");
-        static const uint8_t HardwareGenerationMask = 0x07;
-        _hardware_generation = _buffer.svinfo_header.globalFlags & HardwareGenerationMask;
-        switch (_hardware_generation) {
-            case UBLOX_5:
-            case UBLOX_6:
-                // only 7 and newer support CONFIG_GNSS
-                _unconfigured_messages &= ~CONFIG_GNSS;
-                break;
-            case UBLOX_7:
-            case UBLOX_M8:
-#if UBLOX_SPEED_CHANGE
-                port->begin(4000000U);
-                Debug("Changed speed to 4Mhz for SPI-driven UBlox\n");
-#endif
-                break;
-            default:
-                hal.console->printf("Wrong Ublox Hardware Version%u\n", _hardware_generation);
-                break;
-        };
-        _unconfigured_messages &= ~CONFIG_VERSION;
-        /* We don't need that anymore */
-        _configure_message_rate(CLASS_NAV, MSG_NAV_SVINFO, 0);
-        break;
-        }
-    default:
-        Debug("Unexpected NAV message 0x%02x", (unsigned)_msg_id);
-        if (++_disable_counter == 0) {
-            Debug("Disabling NAV message 0x%02x", (unsigned)_msg_id);
-            _configure_message_rate(CLASS_NAV, _msg_id, 0);
-        }
-        return false;
-    }
+}
 
-    // we only return true when we get new position and speed data
-    // this ensures we don't use stale data
-    if (_new_position && _new_speed && _last_vel_time == _last_pos_time) {
-        _new_speed = _new_position = false;
-        return true;
+void AP_GPS_UBLOX::_handle_nav_velned(void)
+{
+    Debug("MSG_VELNED");
+    if (havePvtMsg) {
+        _unconfigured_messages |= CONFIG_RATE_VELNED;
+        return;
     }
-    return false;
+    _last_vel_time         = _buffer.velned.time;
+    state.ground_speed     = _buffer.velned.speed_2d*0.01f;          // m/s
+    state.ground_course    = wrap_360(_buffer.velned.heading_2d * 1.0e-5f);       // Heading 2D deg * 100000
+    state.have_vertical_velocity = true;
+    state.velocity.x = _buffer.velned.ned_north * 0.01f;
+    state.velocity.y = _buffer.velned.ned_east * 0.01f;
+    state.velocity.z = _buffer.velned.ned_down * 0.01f;
+    state.ground_course = wrap_360(degrees(atan2f(state.velocity.y, state.velocity.x)));
+    state.ground_speed = norm(state.velocity.y, state.velocity.x);
+    state.have_speed_accuracy = true;
+    state.speed_accuracy = _buffer.velned.speed_accuracy*0.01f;
+#if UBLOX_FAKE_3DLOCK
+    state.speed_accuracy = 0;
+#endif
+    _new_speed = true;
+}
+
+void AP_GPS_UBLOX::_handle_nav_svinfo(void)
+{
+    Debug("MSG_NAV_SVINFO\n");
+    static const uint8_t HardwareGenerationMask = 0x07;
+    _hardware_generation = _buffer.svinfo_header.globalFlags & HardwareGenerationMask;
+    switch (_hardware_generation) {
+        case UBLOX_5:
+        case UBLOX_6:
+            // only 7 and newer support CONFIG_GNSS
+            _unconfigured_messages &= ~CONFIG_GNSS;
+            break;
+        case UBLOX_7:
+        case UBLOX_M8:
+#if UBLOX_SPEED_CHANGE
+            port->begin(4000000U);
+            Debug("Changed speed to 4Mhz for SPI-driven UBlox\n");
+#endif
+            break;
+        default:
+            hal.console->printf("Wrong Ublox Hardware Version%u\n", _hardware_generation);
+            break;
+    };
+    _unconfigured_messages &= ~CONFIG_VERSION;
+    /* We don't need that anymore */
+    _configure_message_rate(CLASS_NAV, MSG_NAV_SVINFO, 0);
 }
 
 
@@ -1107,11 +1085,7 @@ AP_GPS_UBLOX::_parse_gps(void)
 void
 AP_GPS_UBLOX::_update_checksum(uint8_t *data, uint16_t len, uint8_t &ck_a, uint8_t &ck_b)
 {
-    while (len--) {
-        ck_a += *data;
-        ck_b += ck_a;
-        data++;
-    }
+    UBX_Framer::update_checksum(data, len, ck_a, ck_b);
 }
 
 
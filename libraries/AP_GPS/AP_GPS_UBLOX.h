@@ -24,6 +24,7 @@
 
 #include "AP_GPS.h"
 #include "GPS_Backend.h"
+#include "UBX_Framer.h"
 
 /*
  *  try to put a UBlox into binary mode. This is in two parts. 
@@ -49,6 +50,9 @@
 
 #define UBLOX_MAX_PORTS 6
 
+// bytes taken from the port per framer call
+#define UBLOX_READ_BLOCK 64
+
 #define RATE_POSLLH 1
 #define RATE_STATUS 1
 #define RATE_SOL 1
@@ -503,15 +507,12 @@ private:
         STEP_LAST
     };
 
-    // Packet checksum accumulators
-    uint8_t         _ck_a;
-    uint8_t         _ck_b;
+    // assembles frames into _buffer
+    UBX_Framer      _framer;
 
-    // State machine state
-    uint8_t         _step;
+    // last frame received
     uint8_t         _msg_id;
     uint16_t        _payload_length;
-    uint16_t        _payload_counter;
 
     uint8_t         _class;
     bool            _cfg_saved;
@@ -540,6 +541,37 @@ private:
     // Buffer parse & GPS state update
     bool        _parse_gps();
 
+    struct ubx_msg_handler {
+        uint8_t msg_class;
+        uint8_t msg_id;
+        void (AP_GPS_UBLOX::*handler)(void);
+    };
+    static const struct ubx_msg_handler _msg_handlers[];
+
+    void _handle_ack_ack(void);
+    void _handle_cfg_nav_settings(void);
+#if UBLOX_GNSS_SETTINGS
+    void _handle_cfg_gnss(void);
+#endif
+    void _handle_cfg_sbas(void);
+    void _handle_cfg_msg(void);
+    void _handle_cfg_prt(void);
+    void _handle_cfg_rate(void);
+    void _handle_mon_hw(void);
+    void _handle_mon_hw2(void);
+    void _handle_mon_ver(void);
+#if UBLOX_RXM_RAW_LOGGING
+    void _handle_rxm_raw(void);
+    void _handle_rxm_rawx(void);
+#endif
+    void _handle_nav_posllh(void);
+    void _handle_nav_status(void);
+    void _handle_nav_dop(void);
+    void _handle_nav_sol(void);
+    void _handle_nav_pvt(void);
+    void _handle_nav_velned(void);
+    void _handle_nav_svinfo(void);
+
     // used to update fix between status and position packets
     AP_GPS::GPS_Status next_fix;
 
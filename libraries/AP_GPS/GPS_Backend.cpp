@@ -31,13 +31,35 @@ extern const AP_HAL::HAL& hal;
 AP_GPS_Backend::AP_GPS_Backend(AP_GPS &_gps, AP_GPS::GPS_State &_state, AP_HAL::UARTDriver *_port) :
     port(_port),
     gps(_gps),
-    state(_state)
+    state(_state),
+    _detect_len(0),
+    _detect_ofs(0)
 {
     state.have_speed_accuracy = false;
     state.have_horizontal_accuracy = false;
     state.have_vertical_accuracy = false;
 }
 
+void AP_GPS_Backend::set_detect_bytes(const uint8_t *buf, uint8_t n)
+{
+    _detect_len = MIN(n, (uint8_t)sizeof(_detect_buf));
+    _detect_ofs = 0;
+    memcpy(_detect_buf, buf, _detect_len);
+}
+
+int16_t AP_GPS_Backend::port_available(void)
+{
+    return (_detect_len - _detect_ofs) + port->available();
+}
+
+int16_t AP_GPS_Backend::port_read(void)
+{
+    if (_detect_ofs < _detect_len) {
+        return _detect_buf[_detect_ofs++];
+    }
+    return port->read();
+}
+
 int32_t AP_GPS_Backend::swap_int32(int32_t v) const
 {
     const uint8_t *b = (const uint8_t *)&v;
@@ -143,10 +165,12 @@ void AP_GPS_Backend::_detection_message(char *buffer, const uint8_t buflen) cons
 
     if (dstate.auto_detected_baud) {
         hal.util->snprintf(buffer, buflen,
-                 "GPS %d: detected as %s at %d baud",
+                 "GPS %d: detected as %s at %d baud in %u.%us",
                  instance + 1,
                  name(),
-                 gps._baudrates[dstate.current_baud]);
+                 gps._baudrates[dstate.current_baud],
+                 (unsigned)(dstate.detect_time_ms / 1000),
+                 (unsigned)(dstate.detect_time_ms % 1000) / 100);
     } else {
         hal.util->snprintf(buffer, buflen,
                  "GPS %d: specified as %s",
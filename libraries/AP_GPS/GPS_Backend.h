@@ -61,6 +61,10 @@ public:
     void broadcast_gps_type() const;
     virtual void Write_DataFlash_Log_Startup_messages() const;
 
+    // pass on the bytes read from the port after those which detected
+    // the protocol
+    void set_detect_bytes(const uint8_t *buf, uint8_t n);
+
 protected:
     AP_HAL::UARTDriver *port;           ///< UART we are attached to
     AP_GPS &gps;                        ///< access to frontend (for parameters)
@@ -84,4 +88,14 @@ protected:
     void _detection_message(char *buffer, uint8_t buflen) const;
 
     bool should_df_log() const;
+
+    // read from the port, starting with any bytes left over from
+    // detection. Drivers found by detection use these to read
+    int16_t port_available(void);
+    int16_t port_read(void);
+
+private:
+    uint8_t _detect_buf[GPS_DETECT_CHUNK-1];
+    uint8_t _detect_len;
+    uint8_t _detect_ofs;
 };
@@ -0,0 +1,157 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "UBX_Framer.h"
+
+#include <string.h>
+
+#include <AP_Math/AP_Math.h>
+
+UBX_Framer::UBX_Framer(uint8_t *payload, uint16_t payload_size) :
+    _payload(payload),
+    _payload_size(payload_size),
+    _header{},
+    _length(0),
+    _count(0),
+    _step(STEP_SYNC1),
+    _ck_a(0),
+    _ck_b(0),
+    _errors(0)
+{
+}
+
+/*
+  Fletcher-8 over a block. Each byte d[i] adds (len - i) times to ck_b,
+  so four bytes are folded in at once to shorten the dependency chain
+  through the accumulators. Only the low 8 bits of the sums matter and
+  32 bit wrap-around preserves them
+ */
+void UBX_Framer::update_checksum(const uint8_t *data, uint16_t len, uint8_t &ck_a, uint8_t &ck_b)
+{
+    uint32_t a = ck_a;
+    uint32_t b = ck_b;
+    while (len >= 4) {
+        b += 4*a + 4*data[0] + 3*data[1] + 2*data[2] + data[3];
+        a += data[0] + data[1] + data[2] + data[3];
+        data += 4;
+        len -= 4;
+    }
+    while (len--) {
+        a += *data++;
+        b += a;
+    }
+    ck_a = a;
+    ck_b = b;
+}
+
+bool UBX_Framer::parse(const uint8_t *&data, uint16_t &len)
+{
+    while (len > 0) {
+        switch (_step) {
+        case STEP_SYNC1: {
+            const uint8_t *p = (const uint8_t *)memchr(data, PREAMBLE1, len);
+            if (p == nullptr) {
+                data += len;
+                len = 0;
+                return false;
+            }
+            len -= (p + 1) - data;
+            data = p + 1;
+            _step = STEP_SYNC2;
+            break;
+        }
+
+        case STEP_SYNC2:
+            // on a mismatch the byte is looked at again as the start
+            // of a preamble, so "\xb5\xb5\x62" still syncs
+            if (*data == PREAMBLE1) {
+                data++;
+                len--;
+            } else if (*data == PREAMBLE2) {
+                data++;
+                len--;
+                _count = 0;
+                _step = STEP_HEADER;
+            } else {
+                _step = STEP_SYNC1;
+            }
+            break;
+
+        case STEP_HEADER: {
+            const uint16_t n = MIN(len, (uint16_t)(sizeof(_header) - _count));
+            memcpy(&_header[_count], data, n);
+            data += n;
+            len -= n;
+            _count += n;
+            if (_count < sizeof(_header)) {
+                break;
+            }
+            _length = _header[2] | (_header[3] << 8);
+            if (_length > _payload_size) {
+                // assume any payload bigger then what we know about
+                // is noise, and look at the length byte again
+                _errors++;
+                data--;
+                len++;
+                _step = STEP_SYNC1;
+                break;
+            }
+            _count = 0;
+            _step = STEP_PAYLOAD;
+            break;
+        }
+
+        case STEP_PAYLOAD: {
+            const uint16_t n = MIN(len, (uint16_t)(_length - _count));
+            memcpy(&_payload[_count], data, n);
+            data += n;
+            len -= n;
+            _count += n;
+            if (_count < _length) {
+                break;
+            }
+            _ck_a = _ck_b = 0;
+            update_checksum(_header, sizeof(_header), _ck_a, _ck_b);
+            update_checksum(_payload, _length, _ck_a, _ck_b);
+            _step = STEP_CK_A;
+            break;
+        }
+
+        case STEP_CK_A:
+            if (*data != _ck_a) {
+                // leave the byte to be looked at as a preamble
+                _errors++;
+                _step = STEP_SYNC1;
+                break;
+            }
+            data++;
+            len--;
+            _step = STEP_CK_B;
+            break;
+
+        case STEP_CK_B: {
+            const uint8_t ck_b = *data;
+            data++;
+            len--;
+            _step = STEP_SYNC1;
+            if (ck_b != _ck_b) {
+                _errors++;
+                break;
+            }
+            return true;
+        }
+        }
+    }
+    return false;
+}
@@ -0,0 +1,81 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  UBX message framer
+
+  Takes spans of received bytes and assembles them into UBX frames. The
+  preamble is found with memchr(), header and payload bytes are copied
+  in blocks straight into the caller's payload buffer and the Fletcher
+  checksum is computed once over the whole frame, so the per-byte cost
+  is a memcpy rather than a pass through a state machine.
+ */
+#pragma once
+
+#include <stdint.h>
+
+class UBX_Framer {
+public:
+    enum {
+        PREAMBLE1 = 0xb5,
+        PREAMBLE2 = 0x62,
+    };
+
+    // payload bytes of each frame are stored in payload, which must
+    // hold payload_size bytes. Longer frames are treated as noise
+    UBX_Framer(uint8_t *payload, uint16_t payload_size);
+
+    /*
+      consume bytes from data until a complete frame with a valid
+      checksum has been received. Returns true with data and len
+      advanced past the frame, or false once all of len is used.
+      The frame stays valid until the next call
+     */
+    bool parse(const uint8_t *&data, uint16_t &len);
+
+    uint8_t msg_class() const { return _header[0]; }
+    uint8_t msg_id() const { return _header[1]; }
+    uint16_t payload_length() const { return _length; }
+    const uint8_t *payload() const { return _payload; }
+
+    // frames dropped for a bad checksum or length
+    uint32_t error_count() const { return _errors; }
+
+    // add len bytes to a running UBX Fletcher checksum
+    static void update_checksum(const uint8_t *data, uint16_t len, uint8_t &ck_a, uint8_t &ck_b);
+
+private:
+    enum step {
+        STEP_SYNC1 = 0,
+        STEP_SYNC2,
+        STEP_HEADER,
+        STEP_PAYLOAD,
+        STEP_CK_A,
+        STEP_CK_B,
+    };
+
+    uint8_t *_payload;
+    const uint16_t _payload_size;
+
+    // class, id and little-endian payload length
+    uint8_t _header[4];
+    uint16_t _length;
+    uint16_t _count;
+    uint8_t _step;
+
+    uint8_t _ck_a;
+    uint8_t _ck_b;
+
+    uint32_t _errors;
+};
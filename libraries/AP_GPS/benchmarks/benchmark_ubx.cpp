@@ -0,0 +1,97 @@
+#include <AP_gbenchmark.h>
+
+#include <AP_GPS/UBX_Framer.h>
+
+#include <string.h>
+
+// one second of output from an M8P at 10Hz with RAWX logging enabled
+#define UBX_RATE_HZ 10
+#define UBX_RAWX_SATS 24
+#define UBX_MAX_PAYLOAD 1044
+
+static uint8_t stream[20000];
+static uint16_t stream_len;
+
+static uint16_t add_frame(uint8_t msg_class, uint8_t msg_id, uint16_t length)
+{
+    uint8_t *buf = &stream[stream_len];
+    buf[0] = UBX_Framer::PREAMBLE1;
+    buf[1] = UBX_Framer::PREAMBLE2;
+    buf[2] = msg_class;
+    buf[3] = msg_id;
+    buf[4] = length & 0xFF;
+    buf[5] = length >> 8;
+    for (uint16_t i = 0; i < length; i++) {
+        // include the preamble byte in payloads, as real data does
+        buf[6 + i] = (i % 29 == 0) ? UBX_Framer::PREAMBLE1 : (uint8_t)(i * 7 + msg_id);
+    }
+    uint8_t ck_a = 0, ck_b = 0;
+    UBX_Framer::update_checksum(&buf[2], length + 4, ck_a, ck_b);
+    buf[6 + length] = ck_a;
+    buf[7 + length] = ck_b;
+    stream_len += length + 8;
+    return length + 8;
+}
+
+static void make_stream(void)
+{
+    stream_len = 0;
+    for (uint8_t i = 0; i < UBX_RATE_HZ; i++) {
+        add_frame(0x01, 0x07, 92);                         // NAV-PVT
+        add_frame(0x01, 0x04, 18);                         // NAV-DOP
+        add_frame(0x02, 0x15, 16 + 32 * UBX_RAWX_SATS);    // RXM-RAWX
+        if (i % 5 == 0) {
+            add_frame(0x0A, 0x09, 68);                     // MON-HW
+            add_frame(0x0A, 0x0B, 28);                     // MON-HW2
+        }
+    }
+}
+
+/*
+  replay the stream in blocks of range_x bytes, as read() takes them
+  from the UART. A block of 1 is the old byte at a time cost
+ */
+static void BM_UBXReplay(benchmark::State& state)
+{
+    static uint8_t payload[UBX_MAX_PAYLOAD];
+    UBX_Framer framer(payload, sizeof(payload));
+    const uint16_t block = state.range_x();
+    uint32_t frames = 0;
+
+    make_stream();
+    while (state.KeepRunning()) {
+        for (uint16_t ofs = 0; ofs < stream_len; ofs += block) {
+            const uint8_t *data = &stream[ofs];
+            uint16_t len = stream_len - ofs < block ? stream_len - ofs : block;
+            while (framer.parse(data, len)) {
+                frames++;
+            }
+        }
+    }
+    gbenchmark_escape(&frames);
+    state.SetBytesProcessed(state.iterations() * stream_len);
+}
+
+BENCHMARK(BM_UBXReplay)->Arg(1)->Arg(16)->Arg(64)->Arg(256);
+
+/*
+  time to frame a single message with a payload of range_x bytes
+ */
+static void BM_UBXMessage(benchmark::State& state)
+{
+    static uint8_t payload[UBX_MAX_PAYLOAD];
+    UBX_Framer framer(payload, sizeof(payload));
+
+    stream_len = 0;
+    const uint16_t n = add_frame(0x01, 0x07, state.range_x());
+    while (state.KeepRunning()) {
+        const uint8_t *data = stream;
+        uint16_t len = n;
+        framer.parse(data, len);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_UBXMessage)->Arg(18)->Arg(92)->Arg(16 + 32 * UBX_RAWX_SATS);
+
+BENCHMARK_MAIN()
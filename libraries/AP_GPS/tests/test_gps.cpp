@@ -17,6 +17,7 @@
 #include <AP_gtest.h>
 
 #include <AP_GPS/AP_GPS_NMEA.h>
+#include <AP_GPS/UBX_Framer.h>
 
 const AP_HAL::HAL &hal = AP_HAL::get_HAL();
 
@@ -62,4 +63,122 @@ TEST(AP_GPS_NMEA, parse_decimal_100)
     ASSERT_EQ(-100, test.parse_decimal_100("-1"));
 }
 
+/*
+  append a UBX frame with the given payload to buf, returning its length
+ */
+static uint16_t ubx_frame(uint8_t *buf, uint8_t msg_class, uint8_t msg_id,
+                          const uint8_t *payload, uint16_t length)
+{
+    buf[0] = UBX_Framer::PREAMBLE1;
+    buf[1] = UBX_Framer::PREAMBLE2;
+    buf[2] = msg_class;
+    buf[3] = msg_id;
+    buf[4] = length & 0xFF;
+    buf[5] = length >> 8;
+    memcpy(&buf[6], payload, length);
+    uint8_t ck_a = 0, ck_b = 0;
+    for (uint16_t i = 2; i < 6 + length; i++) {
+        ck_a += buf[i];
+        ck_b += ck_a;
+    }
+    buf[6 + length] = ck_a;
+    buf[7 + length] = ck_b;
+    return length + 8;
+}
+
+TEST(UBX_Framer, checksum)
+{
+    uint8_t data[257];
+    for (uint16_t i = 0; i < sizeof(data); i++) {
+        data[i] = i * 37 + 11;
+    }
+    for (uint16_t len = 0; len <= sizeof(data); len++) {
+        uint8_t ref_a = 3, ref_b = 5;
+        for (uint16_t i = 0; i < len; i++) {
+            ref_a += data[i];
+            ref_b += ref_a;
+        }
+        uint8_t ck_a = 3, ck_b = 5;
+        UBX_Framer::update_checksum(data, len, ck_a, ck_b);
+        EXPECT_EQ(ref_a, ck_a);
+        EXPECT_EQ(ref_b, ck_b);
+    }
+}
+
+TEST(UBX_Framer, split_frames)
+{
+    uint8_t payload[100];
+    for (uint8_t i = 0; i < sizeof(payload); i++) {
+        payload[i] = i;
+    }
+
+    // two frames, with noise and a stray preamble between them
+    uint8_t stream[300];
+    uint16_t n = ubx_frame(stream, 0x01, 0x07, payload, 92);
+    const uint8_t noise[] = { 0x00, 0xb5, 0xb5, 0x13, 0x24, 0xb5 };
+    memcpy(&stream[n], noise, sizeof(noise));
+    n += sizeof(noise);
+    n += ubx_frame(&stream[n], 0x02, 0x15, payload, 0);
+    n += ubx_frame(&stream[n], 0x0A, 0x09, payload, 60);
+
+    for (uint16_t block = 1; block <= n; block++) {
+        uint8_t rx[100];
+        UBX_Framer framer(rx, sizeof(rx));
+        uint8_t frames = 0;
+        for (uint16_t ofs = 0; ofs < n; ofs += block) {
+            const uint8_t *data = &stream[ofs];
+            uint16_t len = MIN(block, (uint16_t)(n - ofs));
+            while (framer.parse(data, len)) {
+                switch (frames++) {
+                case 0:
+                    EXPECT_EQ(0x07, framer.msg_id());
+                    EXPECT_EQ(92, framer.payload_length());
+                    EXPECT_EQ(0, memcmp(rx, payload, 92));
+                    break;
+                case 1:
+                    EXPECT_EQ(0x02, framer.msg_class());
+                    EXPECT_EQ(0, framer.payload_length());
+                    break;
+                case 2:
+                    EXPECT_EQ(0x0A, framer.msg_class());
+                    EXPECT_EQ(60, framer.payload_length());
+                    break;
+                }
+            }
+            EXPECT_EQ(0, len);
+        }
+        EXPECT_EQ(3, frames);
+        EXPECT_EQ(0U, framer.error_count());
+    }
+}
+
+TEST(UBX_Framer, reject_bad_frames)
+{
+    uint8_t payload[64] {};
+    uint8_t stream[300];
+    uint16_t n = 0;
+
+    // corrupted checksum
+    n += ubx_frame(&stream[n], 0x01, 0x07, payload, 20);
+    stream[n - 1] ^= 0x01;
+
+    // longer than the payload buffer
+    n += ubx_frame(&stream[n], 0x02, 0x15, payload, 40);
+
+    // corrupted payload byte
+    n += ubx_frame(&stream[n], 0x01, 0x07, payload, 20);
+    stream[n - 5] ^= 0x80;
+
+    n += ubx_frame(&stream[n], 0x01, 0x04, payload, 18);
+
+    uint8_t rx[32];
+    UBX_Framer framer(rx, sizeof(rx));
+    const uint8_t *data = stream;
+    uint16_t len = n;
+    EXPECT_TRUE(framer.parse(data, len));
+    EXPECT_EQ(0x04, framer.msg_id());
+    EXPECT_EQ(0, len);
+    EXPECT_EQ(3U, framer.error_count());
+}
+
 AP_GTEST_MAIN()
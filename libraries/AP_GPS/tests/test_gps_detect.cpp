@@ -0,0 +1,235 @@
+#include <AP_gtest.h>
+
+#include <AP_GPS/AP_GPS.h>
+#include <AP_GPS/GPS_Backend.h>
+#include <AP_GPS/UBX_Framer.h>
+#include <GCS_MAVLink/GCS_Dummy.h>
+
+const AP_HAL::HAL &hal = AP_HAL::get_HAL();
+
+const struct AP_Param::GroupInfo GCS_MAVLINK::var_info[] = {
+    AP_GROUPEND
+};
+
+// the detection message goes to the GCS, drop it
+class GCS_Detect_Test : public GCS_Dummy
+{
+    void send_statustext(MAV_SEVERITY severity, uint8_t dest_bitmask, const char *text) override {}
+};
+static GCS_Detect_Test _gcs;
+
+/*
+  a port fed from a buffer, recording the baud rate and how much was
+  sent to the receiver
+ */
+class DetectUART : public AP_HAL::UARTDriver
+{
+public:
+    void begin(uint32_t b) override { baud = b; }
+    void begin(uint32_t b, uint16_t rxSpace, uint16_t txSpace) override { baud = b; }
+    void end() override {}
+    void flush() override {}
+    bool is_initialized() override { return true; }
+    void set_blocking_writes(bool blocking) override {}
+    bool tx_pending() override { return false; }
+    uint32_t available() override { return rx_len - rx_ofs; }
+    uint32_t txspace() override { return 1024; }
+    int16_t read() override { return rx_ofs < rx_len ? rx[rx_ofs++] : -1; }
+    size_t write(uint8_t c) override { tx_count++; return 1; }
+    size_t write(const uint8_t *buffer, size_t size) override { tx_count += size; return size; }
+
+    void add(const uint8_t *data, uint16_t len) {
+        memcpy(&rx[rx_len], data, len);
+        rx_len += len;
+    }
+
+    uint32_t baud = 0;
+    uint32_t tx_count = 0;
+    uint8_t rx[512];
+    uint16_t rx_len = 0;
+    uint16_t rx_ofs = 0;
+};
+
+class AP_GPS_Detect_Test
+{
+public:
+    AP_GPS_Detect_Test(uint8_t type, uint32_t detected) :
+        gps(AP_GPS::create())
+    {
+        gps._type[0].set(type);
+        gps._auto_config.set(AP_GPS::GPS_AUTO_CONFIG_ENABLE);
+        gps._detected[0].set(detected);
+        gps._port[0] = &uart;
+        gps.drivers[0] = nullptr;
+        memset(&gps.state[0], 0, sizeof(gps.state[0]));
+        memset(&gps.detect_state[0], 0, sizeof(gps.detect_state[0]));
+        memset(&gps.initblob_state[0], 0, sizeof(gps.initblob_state[0]));
+    }
+
+    ~AP_GPS_Detect_Test() {
+        delete gps.drivers[0];
+    }
+
+    void detect() { gps.detect_instance(0); }
+    AP_GPS_Backend *driver() { return gps.drivers[0]; }
+    uint32_t detected() const { return (uint32_t)gps._detected[0].get(); }
+    uint32_t baud() const { return AP_GPS::_baudrates[gps.detect_state[0].current_baud]; }
+    bool blob_pending() const { return gps.initblob_state[0].remaining != 0; }
+    void set_config_saved() { gps.set_config_saved(0); }
+    const AP_GPS::GPS_State &state() const { return gps.state[0]; }
+
+    DetectUART uart;
+
+private:
+    AP_GPS gps;
+};
+
+/*
+  append an NMEA sentence with its checksum
+ */
+static uint16_t nmea_sentence(uint8_t *buf, const char *body)
+{
+    uint8_t ck = 0;
+    for (const char *p = body; *p; p++) {
+        ck ^= *p;
+    }
+    return snprintf((char *)buf, 100, "$%s*%02X\r\n", body, ck);
+}
+
+static uint16_t ubx_frame(uint8_t *buf, uint8_t msg_class, uint8_t msg_id, uint8_t length)
+{
+    buf[0] = UBX_Framer::PREAMBLE1;
+    buf[1] = UBX_Framer::PREAMBLE2;
+    buf[2] = msg_class;
+    buf[3] = msg_id;
+    buf[4] = length;
+    buf[5] = 0;
+    memset(&buf[6], 0, length);
+    uint8_t ck_a = 0, ck_b = 0;
+    for (uint16_t i = 2; i < 6 + length; i++) {
+        ck_b += (ck_a += buf[i]);
+    }
+    buf[6 + length] = ck_a;
+    buf[7 + length] = ck_b;
+    return 8 + length;
+}
+
+/*
+  the bytes after the detecting sentence are in the same chunk as it.
+  The driver has to get them, or the fix in the next sentence is lost
+ */
+TEST(AP_GPS_Detect, rest_of_chunk_goes_to_driver)
+{
+    AP_GPS_Detect_Test test(AP_GPS::GPS_TYPE_NMEA, 0);
+    uint8_t buf[200];
+    uint16_t len = nmea_sentence(buf, "GPTXT,01");
+    const uint16_t detect_len = len;
+    len += nmea_sentence(&buf[len], "GPGGA,123519,4807.038,N,01131.000,E,1,09,0.9,545.4,M,46.9,M,,");
+    ASSERT_LT(detect_len, GPS_DETECT_CHUNK);
+    ASSERT_GT(len, GPS_DETECT_CHUNK);
+    test.uart.add(buf, len);
+
+    test.detect();
+    ASSERT_NE(nullptr, test.driver());
+    EXPECT_STREQ("NMEA", test.driver()->name());
+    // only one chunk was taken from the port
+    EXPECT_EQ(len - GPS_DETECT_CHUNK, (uint16_t)test.uart.available());
+
+    test.driver()->read();
+    EXPECT_EQ(9, test.state().num_sats);
+    EXPECT_EQ(AP_GPS::GPS_OK_FIX_3D, test.state().status);
+}
+
+/*
+  detection is spread over calls, with the detector state carried
+  between chunks
+ */
+TEST(AP_GPS_Detect, detect_across_calls)
+{
+    AP_GPS_Detect_Test test(AP_GPS::GPS_TYPE_NMEA, 0);
+    uint8_t buf[100];
+    const uint16_t len = nmea_sentence(buf, "GPTXT,01,01,02,ANTSTATUS=OK");
+
+    test.uart.add(buf, 10);
+    test.detect();
+    EXPECT_EQ(nullptr, test.driver());
+
+    test.uart.add(&buf[10], len - 10);
+    test.detect();
+    ASSERT_NE(nullptr, test.driver());
+    EXPECT_EQ(0U, test.uart.available());
+}
+
+TEST(AP_GPS_Detect, saves_type_and_baud)
+{
+    AP_GPS_Detect_Test test(AP_GPS::GPS_TYPE_NMEA, 0);
+    uint8_t buf[100];
+    test.uart.add(buf, nmea_sentence(buf, "GPTXT,01"));
+
+    test.detect();
+    ASSERT_NE(nullptr, test.driver());
+    EXPECT_EQ(AP_GPS::GPS_TYPE_NMEA | (test.baud() << GPS_DETECTED_BAUD_SHIFT), test.detected());
+
+    test.set_config_saved();
+    EXPECT_EQ(AP_GPS::GPS_TYPE_NMEA | GPS_DETECTED_CONFIG_SAVED | (test.baud() << GPS_DETECTED_BAUD_SHIFT),
+              test.detected());
+}
+
+/*
+  a u-blox which saved our configuration is listened to at its baud
+  rate without the init blob, and keeps the saved flag
+ */
+TEST(AP_GPS_Detect, remembered_configured_ublox)
+{
+    const uint32_t saved = AP_GPS::GPS_TYPE_UBLOX | GPS_DETECTED_CONFIG_SAVED | (115200U << GPS_DETECTED_BAUD_SHIFT);
+    AP_GPS_Detect_Test test(AP_GPS::GPS_TYPE_AUTO, saved);
+
+    test.detect();
+    EXPECT_EQ(115200U, test.uart.baud);
+    EXPECT_EQ(115200U, test.baud());
+    EXPECT_FALSE(test.blob_pending());
+    EXPECT_EQ(0U, test.uart.tx_count);
+    EXPECT_EQ(nullptr, test.driver());
+
+    uint8_t buf[64];
+    test.uart.add(buf, ubx_frame(buf, 0x01, 0x07, 20));
+    test.detect();
+    ASSERT_NE(nullptr, test.driver());
+    EXPECT_STREQ("u-blox", test.driver()->name());
+    EXPECT_EQ(saved, test.detected());
+}
+
+TEST(AP_GPS_Detect, remembered_unconfigured_ublox)
+{
+    const uint32_t saved = AP_GPS::GPS_TYPE_UBLOX | (115200U << GPS_DETECTED_BAUD_SHIFT);
+    AP_GPS_Detect_Test test(AP_GPS::GPS_TYPE_AUTO, saved);
+
+    // the receiver still needs the init blob
+    test.detect();
+    EXPECT_EQ(115200U, test.uart.baud);
+    EXPECT_TRUE(test.blob_pending() || test.uart.tx_count != 0);
+}
+
+/*
+  a different receiver or baud rate from last time has not saved our
+  configuration
+ */
+TEST(AP_GPS_Detect, different_receiver_clears_saved)
+{
+    const uint32_t saved = AP_GPS::GPS_TYPE_UBLOX | GPS_DETECTED_CONFIG_SAVED | (57600U << GPS_DETECTED_BAUD_SHIFT);
+    AP_GPS_Detect_Test test(AP_GPS::GPS_TYPE_NMEA, saved);
+
+    test.detect();
+    EXPECT_EQ(57600U, test.uart.baud);
+
+    uint8_t buf[100];
+    test.uart.add(buf, nmea_sentence(buf, "GPTXT,01"));
+    // let the init blob go out before listening
+    for (uint8_t i = 0; i < 10 && test.driver() == nullptr; i++) {
+        test.detect();
+    }
+    ASSERT_NE(nullptr, test.driver());
+    EXPECT_EQ(AP_GPS::GPS_TYPE_NMEA | (57600U << GPS_DETECTED_BAUD_SHIFT), test.detected());
+}
+
+AP_GTEST_MAIN()
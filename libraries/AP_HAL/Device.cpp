@@ -108,3 +108,38 @@ bool AP_HAL::Device::check_next_register(void)
     _checked.next = (_checked.next+1) % _checked.n_set;
     return true;
 }
+
+/*
+  default for buses which can't queue transfers: one transfer() per
+  segment
+ */
+bool AP_HAL::Device::transfer_segments(const Segment *segments, uint8_t count)
+{
+    if (count > MAX_SEGMENTS) {
+        return false;
+    }
+    for (uint8_t i = 0; i < count; i++) {
+        const Segment &s = segments[i];
+        if (!transfer(s.send, s.send_len, s.recv, s.recv_len)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/*
+  write a sequence of registers, as a single bus request where the bus
+  supports it
+ */
+bool AP_HAL::Device::write_registers(const uint8_t regs[][2], uint8_t count)
+{
+    Segment segments[MAX_SEGMENTS];
+
+    if (count > MAX_SEGMENTS) {
+        return false;
+    }
+    for (uint8_t i = 0; i < count; i++) {
+        segments[i] = { regs[i], 2, nullptr, 0 };
+    }
+    return transfer_segments(segments, count);
+}
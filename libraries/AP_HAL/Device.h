@@ -41,6 +41,20 @@ public:
     FUNCTOR_TYPEDEF(PeriodicCb, void);
     typedef void* PeriodicHandle;
 
+    /*
+     * One transaction of #transfer_segments(). The fields have the same
+     * meaning as the arguments of #transfer().
+     */
+    struct Segment {
+        const uint8_t *send;
+        uint32_t send_len;
+        uint8_t *recv;
+        uint32_t recv_len;
+    };
+
+    /* Maximum number of segments in a single #transfer_segments() call */
+    static const uint8_t MAX_SEGMENTS = 8;
+
     Device(enum BusType type)
     {
         _bus_id.devid_s.bus_type = type;
@@ -96,6 +110,23 @@ public:
     virtual bool transfer(const uint8_t *send, uint32_t send_len,
                           uint8_t *recv, uint32_t recv_len) = 0;
 
+    /*
+     * Do count transactions back to back, with the same result as calling
+     * #transfer() for each segment in order. Buses which can queue them
+     * (see #has_batched_transfers()) hand all of them to the driver in one
+     * request, the default is one #transfer() per segment. At most
+     * MAX_SEGMENTS segments can be given.
+     *
+     * Return: true if all transfers succeeded, false on the first failure.
+     */
+    virtual bool transfer_segments(const Segment *segments, uint8_t count);
+
+    /*
+     * Return: true if #transfer_segments() is done as a single request to
+     * the bus driver rather than one request per segment.
+     */
+    virtual bool has_batched_transfers() const { return false; }
+
     /**
      * Wrapper function over #transfer() to read recv_len registers, starting
      * by first_reg, into the array pointed by recv. The read flag passed to
@@ -125,6 +156,15 @@ public:
         return transfer(buf, sizeof(buf), nullptr, 0);
     }
 
+    /**
+     * Wrapper function over #transfer_segments() to write a sequence of
+     * registers in the order given, each one as if by #write_register().
+     * Checked registers need to be marked with #set_checked_register().
+     *
+     * Return: true on a successful transfer, false on failure.
+     */
+    bool write_registers(const uint8_t regs[][2], uint8_t count);
+
     /**
      * set a value for a checked register
      */
@@ -290,5 +330,5 @@ private:
         uint8_t frequency;
         uint8_t counter;
         struct checkreg *regs;
-    } _checked;
+    } _checked {};
 };
@@ -7,6 +7,7 @@
 #include "AP_HAL_Boards.h"
 #include "AP_HAL_Namespace.h"
 
+#define AP_HAL_SCHEDULER_MAX_SHUTDOWN_PROCS 4
 
 class AP_HAL::Scheduler {
 public:
@@ -49,6 +50,17 @@ public:
 
     virtual void     reboot(bool hold_in_bootloader) = 0;
 
+    /*
+      register a function to be called at the start of reboot() and
+      when the HAL shuts down, used to write out cached data. These
+      are called from whichever thread is rebooting
+     */
+    void register_shutdown_process(AP_HAL::MemberProc proc) {
+        if (_num_shutdown_procs < AP_HAL_SCHEDULER_MAX_SHUTDOWN_PROCS) {
+            _shutdown_proc[_num_shutdown_procs++] = proc;
+        }
+    }
+
     /**
        optional function to stop clock at a given time, used by log replay
      */
@@ -58,4 +70,15 @@ public:
 
     virtual void create_uavcan_thread() {};
 
+protected:
+    // called by the HAL before rebooting or shutting down
+    void run_shutdown_procs() {
+        for (uint8_t i = 0; i < _num_shutdown_procs; i++) {
+            _shutdown_proc[i]();
+        }
+    }
+
+private:
+    AP_HAL::MemberProc _shutdown_proc[AP_HAL_SCHEDULER_MAX_SHUTDOWN_PROCS];
+    uint8_t _num_shutdown_procs = 0;
 };
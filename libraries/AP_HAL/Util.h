@@ -108,6 +108,27 @@ public:
     virtual void perf_end(perf_counter_t h) {}
     virtual void perf_count(perf_counter_t h) {}
 
+    /*
+      timing of a thread making periodic device callbacks. The
+      histogram counts callbacks by how far they ran from their
+      requested time: under 10, 20, 50, 100, 200, 500 and 1000
+      microseconds, then everything later
+     */
+    static const uint8_t BUS_JITTER_BINS = 8;
+    struct BusThreadStats {
+        char name[16];
+        uint32_t callbacks;
+        uint32_t overruns;     // periods missed entirely
+        uint32_t max_jitter_us;
+        uint32_t histogram[BUS_JITTER_BINS];
+    };
+
+    /*
+      get the timing of bus thread idx since it started. Returns false
+      once idx is past the last bus thread
+     */
+    virtual bool get_bus_thread_stats(uint8_t idx, BusThreadStats &stats) { return false; }
+
     // create a new semaphore
     virtual Semaphore *new_semaphore(void) { return nullptr; }
 
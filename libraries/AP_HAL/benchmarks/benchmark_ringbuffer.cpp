@@ -0,0 +1,145 @@
+#include <AP_gbenchmark.h>
+
+#include <pthread.h>
+#include <string.h>
+
+#include <AP_HAL/utility/RingBuffer.h>
+
+/*
+  The lock free rings against the ByteBuffer based ones with a mutex
+  around each access, the way drivers share them between threads. The
+  threaded benchmarks have the first thread reading and the others
+  writing as fast as they can, so only the successful operations are
+  counted as items.
+ */
+
+#define NUM_OBJECTS 256
+#define MESSAGE_SIZE 64
+
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+
+// one push and one pop on a single thread
+static void BM_ObjectBufferLocked(benchmark::State& state)
+{
+    ObjectBuffer<uint32_t> buf(NUM_OBJECTS);
+    uint32_t v = 0;
+    while (state.KeepRunning()) {
+        pthread_mutex_lock(&lock);
+        buf.push(v);
+        pthread_mutex_unlock(&lock);
+        pthread_mutex_lock(&lock);
+        buf.pop(v);
+        pthread_mutex_unlock(&lock);
+        gbenchmark_escape(&v);
+    }
+}
+
+static void BM_SPSCBuffer(benchmark::State& state)
+{
+    SPSCBuffer<uint32_t> buf(NUM_OBJECTS);
+    uint32_t v = 0;
+    while (state.KeepRunning()) {
+        buf.push(v);
+        buf.pop(v);
+        gbenchmark_escape(&v);
+    }
+}
+
+// a block of objects in and out, as from a sensor FIFO
+static void BM_SPSCBufferBatch(benchmark::State& state)
+{
+    SPSCBuffer<uint32_t> buf(NUM_OBJECTS);
+    const uint32_t n = state.range_x();
+    uint32_t block[NUM_OBJECTS] {};
+    while (state.KeepRunning()) {
+        buf.push(block, n);
+        buf.pop(block, n);
+        gbenchmark_escape(block);
+    }
+    state.SetItemsProcessed(state.iterations() * n);
+}
+
+static ObjectBuffer<uint32_t> contended_locked(NUM_OBJECTS);
+
+static void BM_ObjectBufferLockedContended(benchmark::State& state)
+{
+    uint32_t v = 0;
+    uint64_t items = 0;
+    while (state.KeepRunning()) {
+        pthread_mutex_lock(&lock);
+        const bool ok = state.thread_index == 0 ? contended_locked.pop(v) : contended_locked.push(v);
+        pthread_mutex_unlock(&lock);
+        items += ok;
+        gbenchmark_escape(&v);
+    }
+    state.SetItemsProcessed(items);
+}
+
+static SPSCBuffer<uint32_t> contended_spsc(NUM_OBJECTS);
+
+static void BM_SPSCBufferContended(benchmark::State& state)
+{
+    uint32_t v = 0;
+    uint64_t items = 0;
+    while (state.KeepRunning()) {
+        items += state.thread_index == 0 ? contended_spsc.pop(v) : contended_spsc.push(v);
+        gbenchmark_escape(&v);
+    }
+    state.SetItemsProcessed(items);
+}
+
+/*
+  log messages written from several threads and read by one, as
+  DataFlash_File did with a semaphore around its ByteBuffer
+ */
+static ByteBuffer contended_bytes(NUM_OBJECTS * MESSAGE_SIZE);
+
+static void BM_ByteBufferLockedMessages(benchmark::State& state)
+{
+    uint8_t msg[MESSAGE_SIZE] {};
+    uint64_t items = 0;
+    while (state.KeepRunning()) {
+        pthread_mutex_lock(&lock);
+        if (state.thread_index == 0) {
+            items += contended_bytes.read(msg, sizeof(msg)) == sizeof(msg);
+        } else if (contended_bytes.space() >= sizeof(msg)) {
+            items += contended_bytes.write(msg, sizeof(msg)) == sizeof(msg);
+        }
+        pthread_mutex_unlock(&lock);
+        gbenchmark_escape(msg);
+    }
+    state.SetItemsProcessed(items);
+}
+
+static MPSCByteBuffer contended_mpsc(NUM_OBJECTS * MESSAGE_SIZE);
+
+static void BM_MPSCByteBufferMessages(benchmark::State& state)
+{
+    uint8_t msg[MESSAGE_SIZE] {};
+    uint64_t items = 0;
+    while (state.KeepRunning()) {
+        if (state.thread_index == 0) {
+            uint32_t n;
+            const uint8_t *p = contended_mpsc.readptr(n);
+            if (n >= sizeof(msg)) {
+                memcpy(msg, p, sizeof(msg));
+                contended_mpsc.advance(sizeof(msg));
+                items++;
+            }
+        } else {
+            items += contended_mpsc.write(msg, sizeof(msg));
+        }
+        gbenchmark_escape(msg);
+    }
+    state.SetItemsProcessed(items);
+}
+
+BENCHMARK(BM_ObjectBufferLocked);
+BENCHMARK(BM_SPSCBuffer);
+BENCHMARK(BM_SPSCBufferBatch)->Arg(1)->Arg(16);
+BENCHMARK(BM_ObjectBufferLockedContended)->Threads(2);
+BENCHMARK(BM_SPSCBufferContended)->Threads(2);
+BENCHMARK(BM_ByteBufferLockedMessages)->Threads(2)->Threads(4);
+BENCHMARK(BM_MPSCByteBufferMessages)->Threads(2)->Threads(4);
+
+BENCHMARK_MAIN()
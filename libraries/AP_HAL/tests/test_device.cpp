@@ -0,0 +1,137 @@
+#include <AP_gtest.h>
+
+#include <string.h>
+
+#include <AP_Common/AP_Common.h>
+#include <AP_HAL/AP_HAL.h>
+
+/*
+  a register mapped device recording each transfer. A read from
+  FIFO_REG takes bytes off the front of the FIFO, a read from COUNT_REG
+  gives the bytes left in it, big endian
+ */
+#define FIFO_REG    0x74
+#define COUNT_REG   0x72
+
+class RecordingDevice : public AP_HAL::Device {
+public:
+    RecordingDevice() : AP_HAL::Device(BUS_TYPE_SPI) {}
+
+    bool set_speed(Speed speed) override { return true; }
+    AP_HAL::Semaphore *get_semaphore() override { return nullptr; }
+    PeriodicHandle register_periodic_callback(uint32_t period_usec, PeriodicCb) override { return nullptr; }
+    bool adjust_periodic_callback(PeriodicHandle h, uint32_t period_usec) override { return false; }
+
+    bool transfer(const uint8_t *send, uint32_t send_len,
+                  uint8_t *recv, uint32_t recv_len) override {
+        if (num_transfers == fail_at) {
+            return false;
+        }
+        struct transfer &t = transfers[num_transfers++];
+        t.send_len = send_len;
+        t.recv_len = recv_len;
+        memcpy(t.send, send, send_len < sizeof(t.send) ? send_len : sizeof(t.send));
+        if (recv_len == 0) {
+            return true;
+        }
+        if (send_len == 1 && send[0] == (FIFO_REG | 0x80)) {
+            memcpy(recv, fifo, recv_len);
+            memmove(fifo, &fifo[recv_len], fifo_len - recv_len);
+            fifo_len -= recv_len;
+        } else if (send_len == 1 && send[0] == (COUNT_REG | 0x80)) {
+            recv[0] = fifo_len >> 8;
+            recv[1] = fifo_len & 0xFF;
+        }
+        return true;
+    }
+
+    struct transfer {
+        uint8_t send[4];
+        uint32_t send_len;
+        uint32_t recv_len;
+    } transfers[16];
+    uint8_t num_transfers = 0;
+    uint8_t fail_at = 255;
+
+    uint8_t fifo[64];
+    uint16_t fifo_len = 0;
+};
+
+// without batching each segment is a transfer() of its own, in order
+TEST(DeviceTest, SegmentsInOrder)
+{
+    RecordingDevice dev;
+    for (uint8_t i = 0; i < 28; i++) {
+        dev.fifo[i] = i;
+    }
+    dev.fifo_len = 28;
+
+    uint8_t fifo_reg = FIFO_REG | 0x80;
+    uint8_t count_reg = COUNT_REG | 0x80;
+    uint8_t rx[14];
+    uint8_t count_rx[2];
+    const AP_HAL::Device::Segment segments[] = {
+        { &fifo_reg, 1, rx, sizeof(rx) },
+        { &count_reg, 1, count_rx, sizeof(count_rx) },
+    };
+
+    EXPECT_FALSE(dev.has_batched_transfers());
+    ASSERT_TRUE(dev.transfer_segments(segments, ARRAY_SIZE(segments)));
+    ASSERT_EQ(2, dev.num_transfers);
+    EXPECT_EQ(fifo_reg, dev.transfers[0].send[0]);
+    EXPECT_EQ(sizeof(rx), dev.transfers[0].recv_len);
+    EXPECT_EQ(count_reg, dev.transfers[1].send[0]);
+
+    // the count is read after the data it trails
+    EXPECT_EQ(0, rx[0]);
+    EXPECT_EQ(13, rx[13]);
+    EXPECT_EQ(0, count_rx[0]);
+    EXPECT_EQ(14, count_rx[1]);
+}
+
+TEST(DeviceTest, SegmentsStopAtFailure)
+{
+    RecordingDevice dev;
+    const uint8_t regs[3][2] = { { 0x6B, 0x80 }, { 0x6A, 0x04 }, { 0x6A, 0x40 } };
+    AP_HAL::Device::Segment segments[3];
+    for (uint8_t i = 0; i < 3; i++) {
+        segments[i] = { regs[i], 2, nullptr, 0 };
+    }
+
+    dev.fail_at = 1;
+    EXPECT_FALSE(dev.transfer_segments(segments, 3));
+    EXPECT_EQ(1, dev.num_transfers);
+}
+
+TEST(DeviceTest, TooManySegments)
+{
+    RecordingDevice dev;
+    const uint8_t reg[2] = { 0x6B, 0x80 };
+    AP_HAL::Device::Segment segments[AP_HAL::Device::MAX_SEGMENTS + 1];
+    for (uint8_t i = 0; i < ARRAY_SIZE(segments); i++) {
+        segments[i] = { reg, 2, nullptr, 0 };
+    }
+
+    EXPECT_FALSE(dev.transfer_segments(segments, ARRAY_SIZE(segments)));
+    EXPECT_EQ(0, dev.num_transfers);
+    const uint8_t max_segments = AP_HAL::Device::MAX_SEGMENTS;
+    EXPECT_TRUE(dev.transfer_segments(segments, max_segments));
+    EXPECT_EQ(max_segments, dev.num_transfers);
+}
+
+// each register is written as by write_register()
+TEST(DeviceTest, WriteRegisters)
+{
+    RecordingDevice dev;
+    const uint8_t regs[][2] = { { 0x6A, 0x04 }, { 0x6A, 0x40 } };
+
+    ASSERT_TRUE(dev.write_registers(regs, ARRAY_SIZE(regs)));
+    ASSERT_EQ(2, dev.num_transfers);
+    for (uint8_t i = 0; i < ARRAY_SIZE(regs); i++) {
+        EXPECT_EQ(2U, dev.transfers[i].send_len);
+        EXPECT_EQ(0U, dev.transfers[i].recv_len);
+        EXPECT_EQ(0, memcmp(regs[i], dev.transfers[i].send, 2));
+    }
+}
+
+AP_GTEST_MAIN()
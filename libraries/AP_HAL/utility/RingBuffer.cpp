@@ -38,12 +38,13 @@ uint32_t ByteBuffer::available(void) const
 {
     /* use a copy on stack to avoid race conditions of @tail being updated by
      * the writer thread */
-    uint32_t _tail = tail;
+    const uint32_t _head = head.load(std::memory_order_acquire);
+    const uint32_t _tail = tail.load(std::memory_order_acquire);
 
-    if (head > _tail) {
-        return size - head + _tail;
+    if (_head > _tail) {
+        return size - _head + _tail;
     }
-    return _tail - head;
+    return _tail - _head;
 }
 
 void ByteBuffer::clear(void)
@@ -59,21 +60,22 @@ uint32_t ByteBuffer::space(void) const
 
     /* use a copy on stack to avoid race conditions of @head being updated by
      * the reader thread */
-    uint32_t _head = head;
+    const uint32_t _head = head.load(std::memory_order_acquire);
+    const uint32_t _tail = tail.load(std::memory_order_acquire);
     uint32_t ret = 0;
 
-    if (_head <= tail) {
+    if (_head <= _tail) {
         ret = size;
     }
 
-    ret += _head - tail - 1;
+    ret += _head - _tail - 1;
 
     return ret;
 }
 
 bool ByteBuffer::empty(void) const
 {
-    return head == tail;
+    return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);
 }
 
 uint32_t ByteBuffer::write(const uint8_t *data, uint32_t len)
@@ -118,7 +120,9 @@ bool ByteBuffer::advance(uint32_t n)
     if (n > available()) {
         return false;
     }
-    head = (head + n) % size;
+    // release pairs with the acquire in space(), so the writer
+    // doesn't overwrite the bytes until we are done with them
+    head.store((head.load(std::memory_order_relaxed) + n) % size, std::memory_order_release);
     return true;
 }
 
@@ -180,9 +184,10 @@ uint8_t ByteBuffer::reserve(ByteBuffer::IoVec iovec[2], uint32_t len)
         return 0;
     }
 
-    iovec[0].data = &buf[tail];
+    const uint32_t _tail = tail.load(std::memory_order_relaxed);
+    iovec[0].data = &buf[_tail];
 
-    n = size - tail;
+    n = size - _tail;
     if (len <= n) {
         iovec[0].len = len;
         return 1;
@@ -205,7 +210,9 @@ bool ByteBuffer::commit(uint32_t len)
         return false; //Someone broke the agreement
     }
 
-    tail = (tail + len) % size;
+    // release pairs with the acquire in available(), publishing the
+    // bytes written since reserve()
+    tail.store((tail.load(std::memory_order_relaxed) + len) % size, std::memory_order_release);
     return true;
 }
 
@@ -237,10 +244,11 @@ bool ByteBuffer::read_byte(uint8_t *data)
  */
 const uint8_t *ByteBuffer::readptr(uint32_t &available_bytes)
 {
-    uint32_t _tail = tail;
-    available_bytes = (head > _tail) ? size - head : _tail - head;
+    const uint32_t _head = head.load(std::memory_order_relaxed);
+    const uint32_t _tail = tail.load(std::memory_order_acquire);
+    available_bytes = (_head > _tail) ? size - _head : _tail - _head;
 
-    return available_bytes ? &buf[head] : nullptr;
+    return available_bytes ? &buf[_head] : nullptr;
 }
 
 int16_t ByteBuffer::peek(uint32_t ofs) const
@@ -250,3 +258,191 @@ int16_t ByteBuffer::peek(uint32_t ofs) const
     }
     return buf[(head+ofs)%size];
 }
+
+MPSCByteBuffer::MPSCByteBuffer(uint32_t size)
+{
+    _buf = nullptr;
+    _mask = 0xFFFFFFFF;
+    set_size(size);
+}
+
+MPSCByteBuffer::~MPSCByteBuffer(void)
+{
+    free(_buf);
+}
+
+/*
+ * Caller is responsible for locking in set_size(). The size is rounded
+ * down, so the buffer never takes more memory than asked for
+ */
+bool MPSCByteBuffer::set_size(uint32_t size)
+{
+    _head = 0;
+    _readable = 0;
+    _reserved = 0;
+    _committed = 0;
+    _clear_to = 0;
+
+    uint32_t n = 1;
+    while (n <= size / 2) {
+        n <<= 1;
+    }
+    if (size == 0) {
+        free(_buf);
+        _buf = nullptr;
+        _mask = 0xFFFFFFFF;
+        return true;
+    }
+    if (_buf != nullptr && n == get_size()) {
+        return true;
+    }
+    free(_buf);
+    _buf = (uint8_t*)malloc(n);
+    if (!_buf) {
+        _mask = 0xFFFFFFFF;
+        return false;
+    }
+    _mask = n - 1;
+    return true;
+}
+
+uint32_t MPSCByteBuffer::space(void) const
+{
+    const uint32_t head = _head.load(std::memory_order_acquire);
+    return get_size() - (_reserved.load(std::memory_order_relaxed) - head);
+}
+
+uint8_t MPSCByteBuffer::reserve(ByteBuffer::IoVec vec[2], uint32_t len)
+{
+    if (len == 0) {
+        return 0;
+    }
+    uint32_t start = _reserved.load(std::memory_order_relaxed);
+    do {
+        // acquire pairs with the release in advance(), so the reader
+        // is done with the bytes before they are overwritten
+        const uint32_t head = _head.load(std::memory_order_acquire);
+        if (len > get_size() - (start - head)) {
+            return 0;
+        }
+    } while (!_reserved.compare_exchange_weak(start, start + len, std::memory_order_relaxed));
+
+    const uint32_t ofs = start & _mask;
+    const uint32_t n = get_size() - ofs;
+    vec[0].data = &_buf[ofs];
+    if (len <= n) {
+        vec[0].len = len;
+        return 1;
+    }
+    vec[0].len = n;
+    vec[1].data = _buf;
+    vec[1].len = len - n;
+    return 2;
+}
+
+void MPSCByteBuffer::commit(uint32_t len)
+{
+    // release publishes the bytes copied in since reserve()
+    _committed.fetch_add(len, std::memory_order_release);
+}
+
+bool MPSCByteBuffer::write(const uint8_t *data, uint32_t len)
+{
+    ByteBuffer::IoVec vec[2];
+    const uint8_t n_vec = reserve(vec, len);
+    if (n_vec == 0) {
+        return false;
+    }
+    uint32_t ofs = 0;
+    for (uint8_t i = 0; i < n_vec; i++) {
+        memcpy(vec[i].data, data + ofs, vec[i].len);
+        ofs += vec[i].len;
+    }
+    commit(len);
+    return true;
+}
+
+/*
+ * Move the end of the readable data up to the reserve index if every
+ * reservation has been committed. The committed count is loaded first:
+ * if the reserve index still equals it afterwards then all bytes up to
+ * it were committed at that moment.
+ */
+uint32_t MPSCByteBuffer::_update_readable(void)
+{
+    const uint32_t committed = _committed.load(std::memory_order_acquire);
+    const uint32_t reserved = _reserved.load(std::memory_order_relaxed);
+    if (committed == reserved) {
+        _readable = reserved;
+    }
+    return _readable;
+}
+
+/*
+ * Move the read index past bytes discarded by clear(), as far as they
+ * have been committed. Bytes still being copied in by a producer can't
+ * be skipped, or the space would be handed out again while it is
+ * written. Returns the new read index
+ */
+uint32_t MPSCByteBuffer::_apply_clear(uint32_t head)
+{
+    const uint32_t clear_to = _clear_to.load(std::memory_order_acquire);
+    const int32_t pending = (int32_t)(clear_to - head);
+    if (pending <= 0) {
+        if ((uint32_t)-pending > get_size()) {
+            // keep the request close behind the read index, so it
+            // can't look pending again when the indexes wrap
+            uint32_t expected = clear_to;
+            _clear_to.compare_exchange_strong(expected, head, std::memory_order_relaxed);
+        }
+        return head;
+    }
+    const uint32_t readable = _update_readable();
+    const uint32_t new_head = (uint32_t)pending <= readable - head ? clear_to : readable;
+    if (new_head != head) {
+        _head.store(new_head, std::memory_order_release);
+    }
+    return new_head;
+}
+
+uint32_t MPSCByteBuffer::available(void)
+{
+    const uint32_t head = _apply_clear(_head.load(std::memory_order_relaxed));
+    return _update_readable() - head;
+}
+
+const uint8_t *MPSCByteBuffer::readptr(uint32_t &available_bytes)
+{
+    const uint32_t head = _apply_clear(_head.load(std::memory_order_relaxed));
+    const uint32_t n = _update_readable() - head;
+    const uint32_t ofs = head & _mask;
+    available_bytes = n < get_size() - ofs ? n : get_size() - ofs;
+
+    return available_bytes ? &_buf[ofs] : nullptr;
+}
+
+bool MPSCByteBuffer::advance(uint32_t n)
+{
+    const uint32_t head = _head.load(std::memory_order_relaxed);
+    if (n > _readable - head && n > _update_readable() - head) {
+        return false;
+    }
+    _head.store(head + n, std::memory_order_release);
+    _apply_clear(head + n);
+    return true;
+}
+
+/*
+ * Safe from any thread: the request is only recorded here, the consumer
+ * moves its read index when it next looks at the buffer. Of two
+ * concurrent requests the later one in the buffer wins
+ */
+void MPSCByteBuffer::clear(void)
+{
+    const uint32_t target = _reserved.load(std::memory_order_relaxed);
+    uint32_t clear_to = _clear_to.load(std::memory_order_relaxed);
+    while ((int32_t)(target - clear_to) > 0 &&
+           !_clear_to.compare_exchange_weak(clear_to, target, std::memory_order_release,
+                                            std::memory_order_relaxed)) {
+    }
+}
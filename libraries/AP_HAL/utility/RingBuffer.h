@@ -3,6 +3,9 @@
 #include <atomic>
 #include <stdint.h>
 
+// indices written by different threads are kept this far apart
+#define RINGBUFFER_CACHE_LINE_SIZE 64
+
 /*
  * Circular buffer of bytes.
  */
@@ -181,6 +184,328 @@ private:
 
 
 
+/*
+  lock free ring buffer of objects for exactly one producer thread and
+  one consumer thread, with no semaphore needed on either side.
+
+  The size is rounded up to a power of two. The read and write indices
+  run freely and live on separate cache lines, so the two threads only
+  share a line when one of them has to look at the other's index. Each
+  side keeps a copy of the other side's index and only reloads it when
+  the buffer looks full (producer) or empty (consumer).
+
+  Batches of objects can be filled in place with reserve()/commit() and
+  consumed in place with peek()/advance().
+ */
+template <class T>
+class SPSCBuffer {
+public:
+    SPSCBuffer(uint32_t size) {
+        uint32_t n = 1;
+        while (n < size && n < (1U<<31)) {
+            n <<= 1;
+        }
+        _buffer = new T[n];
+        _mask = n - 1;
+    }
+    ~SPSCBuffer(void) {
+        delete[] _buffer;
+    }
+
+    // a contiguous run of objects in the buffer
+    struct Span {
+        T *data;
+        uint32_t len;
+    };
+
+    // return total number of objects the buffer can hold
+    uint32_t get_size(void) const {
+        return _mask + 1;
+    }
+
+    // return number of objects available to be read. May be called
+    // from either side
+    uint32_t available(void) const {
+        // load the read index first so the result can't go negative
+        const uint32_t head = _head.load(std::memory_order_acquire);
+        return _tail.load(std::memory_order_acquire) - head;
+    }
+
+    // return number of objects that could be written
+    uint32_t space(void) const {
+        return get_size() - available();
+    }
+
+    // true if available() == 0
+    bool empty(void) const {
+        return available() == 0;
+    }
+
+    /*
+      producer side
+     */
+
+    // push one object
+    bool push(const T &object) {
+        const uint32_t tail = _tail.load(std::memory_order_relaxed);
+        if (tail - _head_cache > _mask) {
+            _head_cache = _head.load(std::memory_order_acquire);
+            if (tail - _head_cache > _mask) {
+                return false;
+            }
+        }
+        _buffer[tail & _mask] = object;
+        _tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // push up to n objects, returning the number pushed
+    uint32_t push(const T *objects, uint32_t n) {
+        Span vec[2];
+        const uint8_t n_vec = reserve(vec, n);
+        uint32_t ret = 0;
+        for (uint8_t i=0; i<n_vec; i++) {
+            for (uint32_t j=0; j<vec[i].len; j++) {
+                vec[i].data[j] = objects[ret++];
+            }
+        }
+        commit(ret);
+        return ret;
+    }
+
+    /*
+      reserve space for up to n objects, filling in vec with one or two
+      runs (two when the space wraps around). Returns the number of
+      runs. The objects become visible to the consumer on commit()
+     */
+    uint8_t reserve(Span vec[2], uint32_t n) {
+        const uint32_t tail = _tail.load(std::memory_order_relaxed);
+        uint32_t free_space = get_size() - (tail - _head_cache);
+        if (free_space < n) {
+            _head_cache = _head.load(std::memory_order_acquire);
+            free_space = get_size() - (tail - _head_cache);
+        }
+        return _spans(vec, tail, n < free_space ? n : free_space);
+    }
+
+    // publish n objects written after reserve()
+    bool commit(uint32_t n) {
+        const uint32_t tail = _tail.load(std::memory_order_relaxed);
+        if (n > get_size() - (tail - _head_cache)) {
+            return false;
+        }
+        _tail.store(tail + n, std::memory_order_release);
+        return true;
+    }
+
+    /*
+      consumer side
+     */
+
+    // pop earliest object off the queue
+    bool pop(T &object) {
+        const uint32_t head = _head.load(std::memory_order_relaxed);
+        if (head == _tail_cache) {
+            _tail_cache = _tail.load(std::memory_order_acquire);
+            if (head == _tail_cache) {
+                return false;
+            }
+        }
+        object = _buffer[head & _mask];
+        _head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // throw away an object
+    bool pop(void) {
+        return advance(1);
+    }
+
+    // pop up to n objects, returning the number popped
+    uint32_t pop(T *objects, uint32_t n) {
+        Span vec[2];
+        const uint8_t n_vec = peek(vec, n);
+        uint32_t ret = 0;
+        for (uint8_t i=0; i<n_vec; i++) {
+            for (uint32_t j=0; j<vec[i].len; j++) {
+                objects[ret++] = vec[i].data[j];
+            }
+        }
+        advance(ret);
+        return ret;
+    }
+
+    // copy out the earliest object without removing it
+    bool peek(T &object) {
+        Span vec[2];
+        if (peek(vec, 1) == 0) {
+            return false;
+        }
+        object = vec[0].data[0];
+        return true;
+    }
+
+    /*
+      fill in vec with up to n of the earliest objects, in one or two
+      runs. Returns the number of runs. The objects stay in the buffer
+      until advance()
+     */
+    uint8_t peek(Span vec[2], uint32_t n) {
+        const uint32_t head = _head.load(std::memory_order_relaxed);
+        uint32_t avail = _tail_cache - head;
+        if (avail < n) {
+            _tail_cache = _tail.load(std::memory_order_acquire);
+            avail = _tail_cache - head;
+        }
+        return _spans(vec, head, n < avail ? n : avail);
+    }
+
+    // remove n objects, normally after they have been used via peek()
+    bool advance(uint32_t n) {
+        const uint32_t head = _head.load(std::memory_order_relaxed);
+        if (n > _tail_cache - head) {
+            _tail_cache = _tail.load(std::memory_order_acquire);
+            if (n > _tail_cache - head) {
+                return false;
+            }
+        }
+        _head.store(head + n, std::memory_order_release);
+        return true;
+    }
+
+    // Discards the buffer content. Only to be called from the consumer
+    void clear(void) {
+        _tail_cache = _tail.load(std::memory_order_acquire);
+        _head.store(_tail_cache, std::memory_order_release);
+    }
+
+private:
+    uint8_t _spans(Span vec[2], uint32_t index, uint32_t n) {
+        if (n == 0) {
+            return 0;
+        }
+        const uint32_t ofs = index & _mask;
+        const uint32_t n_first = get_size() - ofs;
+        vec[0].data = &_buffer[ofs];
+        if (n <= n_first) {
+            vec[0].len = n;
+            return 1;
+        }
+        vec[0].len = n_first;
+        vec[1].data = _buffer;
+        vec[1].len = n - n_first;
+        return 2;
+    }
+
+    T *_buffer;
+    uint32_t _mask;
+
+    uint8_t _pad0[RINGBUFFER_CACHE_LINE_SIZE];
+
+    // owned by the consumer
+    std::atomic<uint32_t> _head{0};
+    uint32_t _tail_cache = 0;
+
+    uint8_t _pad1[RINGBUFFER_CACHE_LINE_SIZE - 2*sizeof(uint32_t)];
+
+    // owned by the producer
+    std::atomic<uint32_t> _tail{0};
+    uint32_t _head_cache = 0;
+
+    uint8_t _pad2[RINGBUFFER_CACHE_LINE_SIZE - 2*sizeof(uint32_t)];
+};
+
+/*
+  lock free ring buffer of bytes for any number of producer threads
+  and one consumer thread, used for log messages.
+
+  Each write() is all or nothing, so messages are never split or
+  interleaved with those of other threads. A producer claims its part
+  of the buffer by moving the reserve index with a compare-and-swap,
+  copies its data in and then adds its length to the committed count.
+  The consumer can read everything up to the reserve index whenever the
+  committed count has caught up with it, so writers never wait on each
+  other or on the reader. Under a continuous stream of overlapping
+  writes the reader falls back to the last point where they had all
+  finished.
+
+  The size is rounded up to a power of two.
+ */
+class MPSCByteBuffer {
+public:
+    MPSCByteBuffer(uint32_t size);
+    ~MPSCByteBuffer(void);
+
+    // return size of ringbuffer
+    uint32_t get_size(void) const { return _mask + 1; }
+
+    // set size of ringbuffer, rounded down to a power of two. No other
+    // thread may be using it
+    bool set_size(uint32_t size);
+
+    // number of bytes space available to write
+    uint32_t space(void) const;
+
+    /*
+      producer side, may be called from any number of threads
+     */
+
+    // write all len bytes to the ringbuffer or nothing. Returns true
+    // if the bytes were written
+    bool write(const uint8_t *data, uint32_t len);
+
+    // Reserve exactly `len` bytes and fill out `vec` with one or two
+    // parts. Returns the number of parts, or zero if there is not
+    // enough space. Every successful reserve() must be followed by a
+    // commit() of the same length, until then the consumer can't read
+    // past the reserved bytes.
+    uint8_t reserve(ByteBuffer::IoVec vec[2], uint32_t len);
+    void commit(uint32_t len);
+
+    // Discards everything written or reserved so far. The consumer
+    // skips the bytes as they are committed, the space is free once
+    // it has done so
+    void clear(void);
+
+    /*
+      consumer side, only to be called from one thread
+     */
+
+    // number of bytes available to be read
+    uint32_t available(void);
+
+    // true if available() is zero
+    bool empty(void) { return available() == 0; }
+
+    // Returns the pointer and size to a contiguous read of the next available data
+    const uint8_t *readptr(uint32_t &available_bytes);
+
+    // advance the read pointer (discarding bytes)
+    bool advance(uint32_t n);
+
+private:
+    uint32_t _update_readable(void);
+    uint32_t _apply_clear(uint32_t head);
+
+    uint8_t *_buf;
+    uint32_t _mask;
+
+    uint8_t _pad0[RINGBUFFER_CACHE_LINE_SIZE];
+
+    // owned by the consumer
+    std::atomic<uint32_t> _head{0};  // where to read data
+    uint32_t _readable = 0;          // end of the data known to be committed
+
+    uint8_t _pad1[RINGBUFFER_CACHE_LINE_SIZE - 2*sizeof(uint32_t)];
+
+    // shared by the producers
+    std::atomic<uint32_t> _reserved{0};  // total bytes reserved
+    std::atomic<uint32_t> _committed{0}; // total bytes committed
+    std::atomic<uint32_t> _clear_to{0};  // bytes before this are discarded
+
+    uint8_t _pad2[RINGBUFFER_CACHE_LINE_SIZE - 3*sizeof(uint32_t)];
+};
+
 /*
   ring buffer class for objects of fixed size with pointer
   access. Note that this is not thread safe, buf offers efficient
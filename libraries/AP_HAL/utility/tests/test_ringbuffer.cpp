@@ -0,0 +1,474 @@
+#include <AP_gtest.h>
+
+#include <atomic>
+#include <pthread.h>
+#include <sched.h>
+#include <string.h>
+
+#include <AP_HAL/utility/RingBuffer.h>
+
+TEST(SPSCBufferTest, SizeRoundedUp)
+{
+    SPSCBuffer<uint32_t> a(1);
+    SPSCBuffer<uint32_t> b(100);
+    SPSCBuffer<uint32_t> c(128);
+
+    EXPECT_EQ(1U, a.get_size());
+    EXPECT_EQ(128U, b.get_size());
+    EXPECT_EQ(128U, c.get_size());
+}
+
+TEST(SPSCBufferTest, PushPop)
+{
+    SPSCBuffer<uint32_t> buf(4);
+    uint32_t v;
+
+    EXPECT_TRUE(buf.empty());
+    EXPECT_FALSE(buf.pop(v));
+
+    for (uint32_t i = 0; i < 4; i++) {
+        EXPECT_TRUE(buf.push(i));
+    }
+    EXPECT_FALSE(buf.push(4));
+    EXPECT_EQ(4U, buf.available());
+    EXPECT_EQ(0U, buf.space());
+
+    EXPECT_TRUE(buf.peek(v));
+    EXPECT_EQ(0U, v);
+    for (uint32_t i = 0; i < 4; i++) {
+        EXPECT_TRUE(buf.pop(v));
+        EXPECT_EQ(i, v);
+    }
+    EXPECT_FALSE(buf.pop(v));
+    EXPECT_TRUE(buf.empty());
+}
+
+TEST(SPSCBufferTest, ReserveWraps)
+{
+    SPSCBuffer<uint32_t> buf(8);
+    SPSCBuffer<uint32_t>::Span vec[2];
+
+    // move the indices to the middle of the buffer
+    for (uint32_t i = 0; i < 6; i++) {
+        EXPECT_TRUE(buf.push(i));
+    }
+    EXPECT_TRUE(buf.advance(6));
+
+    // more than the free space, we get what is there in two parts
+    EXPECT_EQ(2, buf.reserve(vec, 10));
+    EXPECT_EQ(2U, vec[0].len);
+    EXPECT_EQ(6U, vec[1].len);
+
+    for (uint32_t i = 0; i < 5; i++) {
+        SPSCBuffer<uint32_t>::Span &s = i < vec[0].len ? vec[0] : vec[1];
+        s.data[i < vec[0].len ? i : i - vec[0].len] = 100 + i;
+    }
+    // nothing is visible before the commit
+    EXPECT_TRUE(buf.empty());
+    EXPECT_TRUE(buf.commit(5));
+    EXPECT_FALSE(buf.commit(4));
+    EXPECT_EQ(5U, buf.available());
+
+    EXPECT_EQ(2, buf.peek(vec, 8));
+    EXPECT_EQ(2U, vec[0].len);
+    EXPECT_EQ(3U, vec[1].len);
+    EXPECT_EQ(100U, vec[0].data[0]);
+    EXPECT_EQ(102U, vec[1].data[0]);
+    EXPECT_EQ(5U, buf.available());
+
+    uint32_t out[8];
+    EXPECT_EQ(5U, buf.pop(out, 8));
+    for (uint32_t i = 0; i < 5; i++) {
+        EXPECT_EQ(100 + i, out[i]);
+    }
+    EXPECT_FALSE(buf.advance(1));
+}
+
+TEST(SPSCBufferTest, Clear)
+{
+    SPSCBuffer<uint32_t> buf(8);
+    const uint32_t in[5] = { 1, 2, 3, 4, 5 };
+
+    EXPECT_EQ(5U, buf.push(in, 5));
+    buf.clear();
+    EXPECT_TRUE(buf.empty());
+    EXPECT_EQ(8U, buf.space());
+}
+
+TEST(MPSCByteBufferTest, WriteAllOrNothing)
+{
+    MPSCByteBuffer buf(16);
+    const uint8_t data[16] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15 };
+
+    EXPECT_EQ(16U, buf.get_size());
+    EXPECT_TRUE(buf.write(data, 10));
+    EXPECT_FALSE(buf.write(data, 7));
+    EXPECT_EQ(10U, buf.available());
+    EXPECT_EQ(6U, buf.space());
+
+    // the second write wraps around the end of the buffer
+    EXPECT_TRUE(buf.advance(8));
+    EXPECT_TRUE(buf.write(data + 4, 12));
+
+    uint32_t n;
+    const uint8_t *p = buf.readptr(n);
+    ASSERT_EQ(8U, n);
+    EXPECT_EQ(8, p[0]);
+    EXPECT_EQ(9, p[7]);
+    EXPECT_TRUE(buf.advance(n));
+    p = buf.readptr(n);
+    ASSERT_EQ(6U, n);
+    EXPECT_EQ(10, p[0]);
+    EXPECT_FALSE(buf.advance(7));
+
+    buf.clear();
+    EXPECT_TRUE(buf.empty());
+    EXPECT_EQ(16U, buf.space());
+}
+
+TEST(MPSCByteBufferTest, UncommittedReservationBlocksReader)
+{
+    MPSCByteBuffer buf(64);
+    ByteBuffer::IoVec first[2], second[2];
+
+    EXPECT_EQ(1, buf.reserve(first, 8));
+    EXPECT_EQ(1, buf.reserve(second, 8));
+    memset(second[0].data, 2, 8);
+    buf.commit(8);
+
+    // the later reservation is done, but not the one before it
+    EXPECT_EQ(0U, buf.available());
+
+    memset(first[0].data, 1, 8);
+    buf.commit(8);
+    EXPECT_EQ(16U, buf.available());
+
+    uint32_t n;
+    const uint8_t *p = buf.readptr(n);
+    EXPECT_EQ(16U, n);
+    EXPECT_EQ(1, p[0]);
+    EXPECT_EQ(2, p[8]);
+}
+
+/*
+  a clear from a producer with another producer part way through its
+  message: the reader skips that message too, but only once it is
+  committed
+ */
+TEST(MPSCByteBufferTest, ClearPendingReservation)
+{
+    MPSCByteBuffer buf(64);
+    const uint8_t data[8] = { 1, 2, 3, 4, 5, 6, 7, 8 };
+    ByteBuffer::IoVec vec[2];
+
+    EXPECT_TRUE(buf.write(data, 8));
+    EXPECT_EQ(1, buf.reserve(vec, 8));
+    buf.clear();
+    EXPECT_EQ(0U, buf.available());
+    // nothing is skipped while the reservation is being written
+    EXPECT_EQ(48U, buf.space());
+
+    memset(vec[0].data, 9, 8);
+    buf.commit(8);
+    EXPECT_TRUE(buf.empty());
+    EXPECT_EQ(64U, buf.space());
+
+    EXPECT_TRUE(buf.write(data, 8));
+    uint32_t n;
+    const uint8_t *p = buf.readptr(n);
+    ASSERT_EQ(8U, n);
+    EXPECT_EQ(0, memcmp(p, data, 8));
+}
+
+TEST(MPSCByteBufferTest, ZeroSize)
+{
+    MPSCByteBuffer buf(0);
+    const uint8_t b = 0;
+
+    EXPECT_EQ(0U, buf.get_size());
+    EXPECT_EQ(0U, buf.space());
+    EXPECT_FALSE(buf.write(&b, 1));
+    // rounded down, never more memory than asked for
+    EXPECT_TRUE(buf.set_size(100));
+    EXPECT_EQ(64U, buf.get_size());
+    EXPECT_TRUE(buf.write(&b, 1));
+}
+
+/*
+  stress tests: producers and consumer run flat out on separate threads,
+  with buffers small enough to wrap and fill up all the time. The
+  threads yield when they can't make progress, so the tests also finish
+  quickly on a single core
+ */
+
+#define SPSC_COUNT 1000000U
+
+static void *spsc_producer(void *arg)
+{
+    SPSCBuffer<uint32_t> *buf = (SPSCBuffer<uint32_t> *)arg;
+    uint32_t next = 0;
+    while (next < SPSC_COUNT) {
+        if (next % 3) {
+            if (buf->push(next)) {
+                next++;
+            } else {
+                sched_yield();
+            }
+            continue;
+        }
+        SPSCBuffer<uint32_t>::Span vec[2];
+        const uint8_t n_vec = buf->reserve(vec, 1 + next % 23);
+        uint32_t n = 0;
+        for (uint8_t i = 0; i < n_vec; i++) {
+            for (uint32_t j = 0; j < vec[i].len && next + n < SPSC_COUNT; j++) {
+                vec[i].data[j] = next + n++;
+            }
+        }
+        buf->commit(n);
+        next += n;
+        if (n == 0) {
+            sched_yield();
+        }
+    }
+    return nullptr;
+}
+
+TEST(SPSCBufferTest, Stress)
+{
+    SPSCBuffer<uint32_t> buf(64);
+    pthread_t thread;
+    ASSERT_EQ(0, pthread_create(&thread, nullptr, spsc_producer, &buf));
+
+    uint32_t expected = 0;
+    uint32_t errors = 0;
+    while (expected < SPSC_COUNT) {
+        uint32_t v;
+        if (expected % 2) {
+            if (buf.pop(v)) {
+                errors += v != expected++;
+            } else {
+                sched_yield();
+            }
+            continue;
+        }
+        uint32_t block[17];
+        const uint32_t n = buf.pop(block, sizeof(block) / sizeof(block[0]));
+        for (uint32_t i = 0; i < n; i++) {
+            errors += block[i] != expected++;
+        }
+        if (n == 0) {
+            sched_yield();
+        }
+    }
+
+    pthread_join(thread, nullptr);
+    EXPECT_EQ(0U, errors);
+    EXPECT_TRUE(buf.empty());
+}
+
+/*
+  each producer writes messages of varying length holding its id, a
+  sequence number and a payload derived from both
+ */
+#define MPSC_PRODUCERS 4
+#define MPSC_MESSAGES 200000U
+
+struct mpsc_producer {
+    MPSCByteBuffer *buf;
+    uint8_t id;
+    uint32_t dropped;
+};
+
+static std::atomic<uint8_t> mpsc_finished;
+
+static uint8_t mpsc_message(uint8_t id, uint32_t seq, uint8_t msg[64])
+{
+    const uint8_t len = 6 + (seq * 7 + id) % 50;
+    msg[0] = len;
+    msg[1] = id;
+    memcpy(&msg[2], &seq, sizeof(seq));
+    for (uint8_t i = 6; i < len; i++) {
+        msg[i] = seq + id * i;
+    }
+    return len;
+}
+
+static void *mpsc_producer_run(void *arg)
+{
+    struct mpsc_producer *p = (struct mpsc_producer *)arg;
+    uint8_t msg[64];
+    for (uint32_t seq = 0; seq < MPSC_MESSAGES; seq++) {
+        const uint8_t len = mpsc_message(p->id, seq, msg);
+        // like the logging code, messages are dropped when full
+        if (!p->buf->write(msg, len)) {
+            p->dropped++;
+            sched_yield();
+        }
+    }
+    mpsc_finished++;
+    return nullptr;
+}
+
+TEST(MPSCByteBufferTest, Stress)
+{
+    MPSCByteBuffer buf(4096);
+    mpsc_finished = 0;
+    pthread_t threads[MPSC_PRODUCERS];
+    struct mpsc_producer producers[MPSC_PRODUCERS];
+    for (uint8_t i = 0; i < MPSC_PRODUCERS; i++) {
+        producers[i] = { &buf, i, 0 };
+        ASSERT_EQ(0, pthread_create(&threads[i], nullptr, mpsc_producer_run, &producers[i]));
+    }
+
+    uint32_t next_seq[MPSC_PRODUCERS] {};
+    uint32_t received = 0;
+    uint32_t errors = 0;
+    uint8_t pending[128];
+    uint32_t npending = 0;
+    bool done = false;
+    while (!done) {
+        // finished once all the producers are done and everything
+        // they wrote has been read
+        done = mpsc_finished == MPSC_PRODUCERS && buf.empty() && npending == 0;
+
+        uint32_t n;
+        const uint8_t *p = buf.readptr(n);
+        if (n > sizeof(pending) - npending) {
+            n = sizeof(pending) - npending;
+        }
+        if (n == 0) {
+            sched_yield();
+            continue;
+        }
+        memcpy(&pending[npending], p, n);
+        npending += n;
+        buf.advance(n);
+
+        // take complete messages off the front of the pending bytes
+        while (npending > 0 && npending >= pending[0]) {
+            const uint8_t len = pending[0];
+            const uint8_t id = pending[1];
+            uint32_t seq;
+            memcpy(&seq, &pending[2], sizeof(seq));
+            uint8_t msg[64];
+            if (id >= MPSC_PRODUCERS || seq < next_seq[id] ||
+                mpsc_message(id, seq, msg) != len || memcmp(msg, pending, len) != 0) {
+                errors++;
+                npending = 0;
+                break;
+            }
+            next_seq[id] = seq + 1;
+            received++;
+            memmove(pending, &pending[len], npending - len);
+            npending -= len;
+        }
+    }
+
+    uint32_t dropped = 0;
+    for (uint8_t i = 0; i < MPSC_PRODUCERS; i++) {
+        pthread_join(threads[i], nullptr);
+        dropped += producers[i].dropped;
+    }
+    EXPECT_EQ(0U, errors);
+    EXPECT_EQ(MPSC_PRODUCERS * MPSC_MESSAGES, received + dropped);
+}
+
+/*
+  the log front end clears the buffer when it starts a new log, while
+  other threads write and the io thread reads. Messages are a fixed
+  size dividing the buffer, so a clear has to leave the reader on a
+  message boundary
+ */
+#define CLEAR_MESSAGE_SIZE 16
+
+static std::atomic<bool> clear_stop;
+
+static void *mpsc_clear_run(void *arg)
+{
+    MPSCByteBuffer *buf = (MPSCByteBuffer *)arg;
+    while (!clear_stop) {
+        buf->clear();
+        sched_yield();
+    }
+    return nullptr;
+}
+
+static void *mpsc_fixed_producer_run(void *arg)
+{
+    struct mpsc_producer *p = (struct mpsc_producer *)arg;
+    uint8_t msg[CLEAR_MESSAGE_SIZE];
+    for (uint32_t seq = 0; seq < MPSC_MESSAGES; seq++) {
+        msg[0] = p->id;
+        memcpy(&msg[1], &seq, sizeof(seq));
+        for (uint8_t i = 5; i < sizeof(msg); i++) {
+            msg[i] = seq + p->id * i;
+        }
+        if (!p->buf->write(msg, sizeof(msg))) {
+            p->dropped++;
+            sched_yield();
+        }
+    }
+    mpsc_finished++;
+    return nullptr;
+}
+
+TEST(MPSCByteBufferTest, ClearFromProducer)
+{
+    MPSCByteBuffer buf(4096);
+    mpsc_finished = 0;
+    clear_stop = false;
+    pthread_t clearer;
+    ASSERT_EQ(0, pthread_create(&clearer, nullptr, mpsc_clear_run, &buf));
+    pthread_t threads[MPSC_PRODUCERS];
+    struct mpsc_producer producers[MPSC_PRODUCERS];
+    for (uint8_t i = 0; i < MPSC_PRODUCERS; i++) {
+        producers[i] = { &buf, i, 0 };
+        ASSERT_EQ(0, pthread_create(&threads[i], nullptr, mpsc_fixed_producer_run, &producers[i]));
+    }
+
+    uint32_t next_seq[MPSC_PRODUCERS] {};
+    uint32_t received = 0;
+    uint32_t errors = 0;
+    while (mpsc_finished != MPSC_PRODUCERS || !buf.empty()) {
+        uint32_t n;
+        const uint8_t *p = buf.readptr(n);
+        n -= n % CLEAR_MESSAGE_SIZE;
+        if (n == 0) {
+            sched_yield();
+            continue;
+        }
+        for (uint32_t ofs = 0; ofs < n; ofs += CLEAR_MESSAGE_SIZE) {
+            const uint8_t *msg = &p[ofs];
+            const uint8_t id = msg[0];
+            uint32_t seq;
+            memcpy(&seq, &msg[1], sizeof(seq));
+            bool ok = id < MPSC_PRODUCERS && seq >= next_seq[id];
+            for (uint8_t i = 5; ok && i < CLEAR_MESSAGE_SIZE; i++) {
+                ok = msg[i] == (uint8_t)(seq + id * i);
+            }
+            if (!ok) {
+                errors++;
+                continue;
+            }
+            next_seq[id] = seq + 1;
+            received++;
+        }
+        buf.advance(n);
+    }
+
+    clear_stop = true;
+    pthread_join(clearer, nullptr);
+    for (uint8_t i = 0; i < MPSC_PRODUCERS; i++) {
+        pthread_join(threads[i], nullptr);
+    }
+    EXPECT_EQ(0U, errors);
+    EXPECT_GT(received, 0U);
+
+    // nothing is left reserved, so a clear frees all the space
+    EXPECT_TRUE(buf.write((const uint8_t *)&received, sizeof(received)));
+    buf.clear();
+    EXPECT_TRUE(buf.empty());
+    EXPECT_EQ(4096U, buf.space());
+}
+
+AP_GTEST_MAIN()
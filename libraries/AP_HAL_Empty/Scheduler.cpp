@@ -42,5 +42,6 @@ void Scheduler::system_initialized()
 {}
 
 void Scheduler::reboot(bool hold_in_bootloader) {
+    run_shutdown_procs();
     for(;;);
 }
@@ -0,0 +1,635 @@
+/*
+ * This file is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This file is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <AP_HAL/AP_HAL.h>
+
+#if CONFIG_HAL_BOARD == HAL_BOARD_LINUX && HAL_WITH_UAVCAN
+
+#include "CAN.h"
+
+#include <errno.h>
+#include <linux/can.h>
+#include <linux/can/error.h>
+#include <linux/can/raw.h>
+#include <linux/net_tstamp.h>
+#include <net/if.h>
+#include <poll.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <AP_BoardConfig/AP_BoardConfig_CAN.h>
+#include <AP_Math/AP_Math.h>
+
+extern const AP_HAL::HAL& hal;
+
+using namespace Linux;
+
+// keep the kernel's queue of unsent frames short so the priority
+// queue decides the transmit order
+#define LINUX_CAN_SNDBUF 4096
+
+/*
+ * CANTxQueue
+ */
+
+bool CANTxQueue::higher_priority(const Item &a, const Item &b)
+{
+    if (a.frame.priorityHigherThan(b.frame)) {
+        return true;
+    }
+    if (b.frame.priorityHigherThan(a.frame)) {
+        return false;
+    }
+    // wrap-safe comparison of queue order
+    return int32_t(a.order - b.order) < 0;
+}
+
+bool CANTxQueue::push(const uavcan::CanFrame &frame, uavcan::MonotonicTime deadline, uavcan::CanIOFlags flags)
+{
+    Item item;
+    item.frame = frame;
+    item.deadline = deadline;
+    item.flags = flags;
+    item.order = _next_order++;
+    return push(item);
+}
+
+bool CANTxQueue::push(const Item &item)
+{
+    if (_count >= LINUX_CAN_TX_QUEUE_SIZE) {
+        return false;
+    }
+    // sift up
+    uint16_t i = _count++;
+    while (i > 0) {
+        const uint16_t parent = (i - 1) / 2;
+        if (!higher_priority(item, _heap[parent])) {
+            break;
+        }
+        _heap[i] = _heap[parent];
+        i = parent;
+    }
+    _heap[i] = item;
+    return true;
+}
+
+bool CANTxQueue::pop(Item &item)
+{
+    if (_count == 0) {
+        return false;
+    }
+    item = _heap[0];
+    const Item last = _heap[--_count];
+    // sift down
+    uint16_t i = 0;
+    while (true) {
+        uint16_t child = 2 * i + 1;
+        if (child >= _count) {
+            break;
+        }
+        if (child + 1 < _count && higher_priority(_heap[child + 1], _heap[child])) {
+            child++;
+        }
+        if (!higher_priority(_heap[child], last)) {
+            break;
+        }
+        _heap[i] = _heap[child];
+        i = child;
+    }
+    _heap[i] = last;
+    return true;
+}
+
+/*
+ * CAN
+ */
+
+CAN::CAN(const char *name) :
+    _name(name)
+{
+}
+
+CAN::~CAN()
+{
+    end();
+}
+
+bool CAN::_open()
+{
+    _fd = socket(PF_CAN, SOCK_RAW | SOCK_NONBLOCK | SOCK_CLOEXEC, CAN_RAW);
+    if (_fd < 0) {
+        return false;
+    }
+
+    struct ifreq ifr;
+    memset(&ifr, 0, sizeof(ifr));
+    strncpy(ifr.ifr_name, _name, IFNAMSIZ - 1);
+    if (ioctl(_fd, SIOCGIFINDEX, &ifr) < 0) {
+        goto fail;
+    }
+
+    {
+        struct sockaddr_can addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.can_family = AF_CAN;
+        addr.can_ifindex = ifr.ifr_ifindex;
+        if (bind(_fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+            goto fail;
+        }
+    }
+
+    {
+        // our own frames come back flagged MSG_CONFIRM, which is how
+        // loopback requests are served
+        const int on = 1;
+        if (setsockopt(_fd, SOL_CAN_RAW, CAN_RAW_RECV_OWN_MSGS, &on, sizeof(on)) < 0) {
+            goto fail;
+        }
+
+        const can_err_mask_t err_mask = CAN_ERR_TX_TIMEOUT | CAN_ERR_CRTL | CAN_ERR_BUSOFF | CAN_ERR_BUSERROR;
+        setsockopt(_fd, SOL_CAN_RAW, CAN_RAW_ERR_FILTER, &err_mask, sizeof(err_mask));
+
+        const int sndbuf = LINUX_CAN_SNDBUF;
+        setsockopt(_fd, SOL_SOCKET, SO_SNDBUF, &sndbuf, sizeof(sndbuf));
+
+        // prefer hardware receive timestamps, falling back to the
+        // kernel's software timestamps
+        const int ts_flags = SOF_TIMESTAMPING_RX_HARDWARE | SOF_TIMESTAMPING_RAW_HARDWARE |
+            SOF_TIMESTAMPING_RX_SOFTWARE | SOF_TIMESTAMPING_SOFTWARE;
+        if (setsockopt(_fd, SOL_SOCKET, SO_TIMESTAMPING, &ts_flags, sizeof(ts_flags)) < 0) {
+            setsockopt(_fd, SOL_SOCKET, SO_TIMESTAMP, &on, sizeof(on));
+        }
+    }
+
+    return true;
+
+fail:
+    close(_fd);
+    _fd = -1;
+    return false;
+}
+
+bool CAN::begin(uint32_t bitrate)
+{
+    if (_fd >= 0) {
+        return true;
+    }
+    if (!_open()) {
+        fprintf(stderr, "CAN: failed to open %s: %s\n", _name, strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+void CAN::end()
+{
+    if (_fd >= 0) {
+        close(_fd);
+        _fd = -1;
+    }
+    reset();
+}
+
+void CAN::reset()
+{
+    _rx_queue.clear();
+    _tx_queue.clear();
+    _loopback_count = 0;
+    _tx_in_flight = 0;
+}
+
+int32_t CAN::tx_pending()
+{
+    if (_fd < 0) {
+        return -1;
+    }
+    return _tx_queue.size();
+}
+
+int32_t CAN::available()
+{
+    if (_fd < 0) {
+        return -1;
+    }
+    return _rx_queue.available();
+}
+
+int16_t CAN::send(const uavcan::CanFrame& frame, uavcan::MonotonicTime tx_deadline,
+                  uavcan::CanIOFlags flags)
+{
+    if (_fd < 0) {
+        return -ErrNotOpen;
+    }
+    if (frame.isErrorFrame() || frame.dlc > 8) {
+        return -ErrUnsupportedFrame;
+    }
+    if (!_tx_queue.push(frame, tx_deadline, flags)) {
+        return 0;
+    }
+    // start sending straight away rather than on the next select()
+    poll_tx();
+    return 1;
+}
+
+int16_t CAN::receive(uavcan::CanFrame& out_frame, uavcan::MonotonicTime& out_ts_monotonic,
+                     uavcan::UtcTime& out_ts_utc, uavcan::CanIOFlags& out_flags)
+{
+    if (_fd < 0) {
+        return -ErrNotOpen;
+    }
+    if (_rx_queue.empty()) {
+        poll_rx();
+    }
+    RxItem item;
+    if (!_rx_queue.pop(item)) {
+        return 0;
+    }
+    out_frame = item.frame;
+    out_flags = item.flags;
+    out_ts_monotonic = uavcan::MonotonicTime::fromUSec(item.timestamp_us);
+    out_ts_utc = uavcan::UtcTime::fromUSec(item.timestamp_us);
+    return 1;
+}
+
+int16_t CAN::configureFilters(const uavcan::CanFilterConfig* filter_configs, uint16_t num_configs)
+{
+    if (_fd < 0) {
+        return -ErrNotOpen;
+    }
+    if (num_configs > NumFilters) {
+        return -ErrFilter;
+    }
+
+    // uavcan filters use the same flag bits as SocketCAN
+    struct can_filter filters[NumFilters];
+    for (uint16_t i = 0; i < num_configs; i++) {
+        filters[i].can_id = filter_configs[i].id;
+        filters[i].can_mask = filter_configs[i].mask;
+    }
+    if (num_configs == 0) {
+        // accept everything
+        filters[0].can_id = 0;
+        filters[0].can_mask = 0;
+        num_configs = 1;
+    }
+    if (setsockopt(_fd, SOL_CAN_RAW, CAN_RAW_FILTER, filters, num_configs * sizeof(filters[0])) < 0) {
+        return -ErrFilter;
+    }
+    return 0;
+}
+
+uint64_t CANHWClock::to_sw_us(uint64_t hw_us, uint64_t sw_us)
+{
+    const int64_t offset = int64_t(sw_us - hw_us);
+    if (!_valid || offset <= _offset_us) {
+        _offset_us = offset;
+        _updated_sw_us = sw_us;
+        _valid = true;
+    } else if (sw_us > _updated_sw_us) {
+        const uint64_t creep = (sw_us - _updated_sw_us) / LINUX_CAN_HW_CLOCK_DRIFT_DIV;
+        if (creep > 0) {
+            // never past the offset just seen, that frame can't have
+            // been stamped by the kernel before the hardware
+            _offset_us = MIN(_offset_us + int64_t(creep), offset);
+            _updated_sw_us += creep * LINUX_CAN_HW_CLOCK_DRIFT_DIV;
+        }
+    }
+    return hw_us + _offset_us;
+}
+
+/*
+  convert the receive timestamp of a frame to the AP_HAL::micros64()
+  time base
+ */
+uint64_t CAN::_rx_timestamp(struct msghdr &msg, uint64_t realtime_now_us, uint64_t hal_now_us)
+{
+    uint64_t rx_us = 0;
+
+    for (struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+        if (cmsg->cmsg_level != SOL_SOCKET) {
+            continue;
+        }
+        if (cmsg->cmsg_type == SO_TIMESTAMPING) {
+            // [0] is software, [2] is raw hardware time
+            struct timespec ts[3];
+            memcpy(ts, CMSG_DATA(cmsg), sizeof(ts));
+            const uint64_t sw_us = ts[0].tv_sec * 1000000ULL + ts[0].tv_nsec / 1000;
+            const uint64_t hw_us = ts[2].tv_sec * 1000000ULL + ts[2].tv_nsec / 1000;
+            if (hw_us != 0 && sw_us != 0) {
+                rx_us = _hw_clock.to_sw_us(hw_us, sw_us);
+            } else {
+                rx_us = sw_us;
+            }
+        } else if (cmsg->cmsg_type == SO_TIMESTAMP) {
+            struct timeval tv;
+            memcpy(&tv, CMSG_DATA(cmsg), sizeof(tv));
+            rx_us = tv.tv_sec * 1000000ULL + tv.tv_usec;
+        }
+    }
+
+    if (rx_us == 0 || rx_us > realtime_now_us) {
+        return hal_now_us;
+    }
+    const uint64_t age_us = realtime_now_us - rx_us;
+    if (age_us > hal_now_us) {
+        return 0;
+    }
+    return hal_now_us - age_us;
+}
+
+/*
+  check if a frame we sent ourselves was sent with CanIOFlagLoopback
+ */
+bool CAN::_is_loopback(const uavcan::CanFrame &frame)
+{
+    for (uint8_t i = 0; i < _loopback_count; i++) {
+        if (_loopback[i] == frame) {
+            memmove(&_loopback[i], &_loopback[i+1], (_loopback_count - i - 1) * sizeof(_loopback[0]));
+            _loopback_count--;
+            return true;
+        }
+    }
+    return false;
+}
+
+void CAN::poll_rx()
+{
+    if (_fd < 0) {
+        return;
+    }
+
+    struct can_frame frames[LINUX_CAN_IO_BATCH];
+    struct iovec iov[LINUX_CAN_IO_BATCH];
+    struct mmsghdr msgs[LINUX_CAN_IO_BATCH];
+    uint8_t control[LINUX_CAN_IO_BATCH][CMSG_SPACE(3 * sizeof(struct timespec))];
+
+    while (_rx_queue.space() > 0) {
+        const unsigned batch = MIN((uint32_t)LINUX_CAN_IO_BATCH, _rx_queue.space());
+        memset(msgs, 0, sizeof(msgs[0]) * batch);
+        for (unsigned i = 0; i < batch; i++) {
+            iov[i].iov_base = &frames[i];
+            iov[i].iov_len = sizeof(frames[i]);
+            msgs[i].msg_hdr.msg_iov = &iov[i];
+            msgs[i].msg_hdr.msg_iovlen = 1;
+            msgs[i].msg_hdr.msg_control = control[i];
+            msgs[i].msg_hdr.msg_controllen = sizeof(control[i]);
+        }
+
+        const int n = recvmmsg(_fd, msgs, batch, MSG_DONTWAIT, nullptr);
+        if (n <= 0) {
+            if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                _error_cnt++;
+            }
+            return;
+        }
+
+        struct timespec now;
+        clock_gettime(CLOCK_REALTIME, &now);
+        const uint64_t realtime_now_us = now.tv_sec * 1000000ULL + now.tv_nsec / 1000;
+        const uint64_t hal_now_us = AP_HAL::micros64();
+
+        for (int i = 0; i < n; i++) {
+            const struct can_frame &f = frames[i];
+            if (msgs[i].msg_len < sizeof(f) || f.can_dlc > 8) {
+                continue;
+            }
+            if (f.can_id & CAN_ERR_FLAG) {
+                _error_cnt++;
+                continue;
+            }
+
+            RxItem item;
+            item.frame = uavcan::CanFrame(f.can_id, f.data, f.can_dlc);
+            item.flags = 0;
+            if (msgs[i].msg_hdr.msg_flags & MSG_CONFIRM) {
+                // echo of a frame we sent, so it has left the kernel
+                if (_tx_in_flight > 0) {
+                    _tx_in_flight--;
+                }
+                _tx_echo_us = hal_now_us;
+                if (!_is_loopback(item.frame)) {
+                    continue;
+                }
+                item.flags = uavcan::CanIOFlagLoopback;
+            }
+            item.timestamp_us = _rx_timestamp(msgs[i].msg_hdr, realtime_now_us, hal_now_us);
+            _rx_queue.push(item);
+        }
+
+        if (n < (int)batch) {
+            return;
+        }
+    }
+}
+
+void CAN::poll_tx()
+{
+    if (_fd < 0) {
+        return;
+    }
+
+    struct can_frame frames[LINUX_CAN_IO_BATCH];
+    struct iovec iov[LINUX_CAN_IO_BATCH];
+    struct mmsghdr msgs[LINUX_CAN_IO_BATCH];
+    CANTxQueue::Item items[LINUX_CAN_IO_BATCH];
+
+    const uint64_t now_us = AP_HAL::micros64();
+    const uavcan::MonotonicTime now = uavcan::MonotonicTime::fromUSec(now_us);
+
+    if (_tx_in_flight > 0 && now_us - _tx_echo_us > LINUX_CAN_TX_ECHO_TIMEOUT_US) {
+        _tx_in_flight = 0;
+    }
+
+    // one batch, bounded by the frames in flight; the rest wait in the
+    // priority queue until the kernel echoes what it has sent
+    const unsigned max_batch = MIN(LINUX_CAN_IO_BATCH, LINUX_CAN_TX_IN_FLIGHT - _tx_in_flight);
+    unsigned batch = 0;
+    while (batch < max_batch && _tx_queue.pop(items[batch])) {
+        const CANTxQueue::Item &item = items[batch];
+        if (!item.deadline.isZero() && item.deadline < now) {
+            // too late to be useful
+            _error_cnt++;
+            continue;
+        }
+        struct can_frame &f = frames[batch];
+        memset(&f, 0, sizeof(f));
+        f.can_id = item.frame.id;
+        f.can_dlc = item.frame.dlc;
+        memcpy(f.data, item.frame.data, item.frame.dlc);
+        iov[batch].iov_base = &f;
+        iov[batch].iov_len = sizeof(f);
+        memset(&msgs[batch], 0, sizeof(msgs[batch]));
+        msgs[batch].msg_hdr.msg_iov = &iov[batch];
+        msgs[batch].msg_hdr.msg_iovlen = 1;
+        batch++;
+    }
+    if (batch == 0) {
+        return;
+    }
+
+    int n = sendmmsg(_fd, msgs, batch, MSG_DONTWAIT);
+    bool failed = false;
+    if (n < 0) {
+        if (errno != EAGAIN && errno != EWOULDBLOCK && errno != ENOBUFS && errno != EINTR) {
+            _error_cnt++;
+            failed = true;
+        }
+        n = 0;
+    }
+
+    if (n > 0) {
+        if (_tx_in_flight == 0) {
+            _tx_echo_us = now_us;
+        }
+        _tx_in_flight += n;
+    }
+    for (int i = 0; i < n; i++) {
+        if ((items[i].flags & uavcan::CanIOFlagLoopback) &&
+            _loopback_count < LINUX_CAN_LOOPBACK_QUEUE_SIZE) {
+            _loopback[_loopback_count++] = items[i].frame;
+        }
+    }
+
+    // requeue what the kernel didn't take
+    for (unsigned i = n; i < batch; i++) {
+        if (failed && (items[i].flags & uavcan::CanIOFlagAbortOnError)) {
+            continue;
+        }
+        _tx_queue.push(items[i]);
+    }
+}
+
+/*
+ * CANManager
+ */
+
+const char *CANManager::_iface_names[MAX_NUMBER_OF_CAN_INTERFACES] = {
+    "can0",
+#if MAX_NUMBER_OF_CAN_INTERFACES > 1
+    "can1",
+#endif
+};
+
+void CANManager::set_interface_name(uint8_t can_number, const char *name)
+{
+    if (can_number < MAX_NUMBER_OF_CAN_INTERFACES) {
+        _iface_names[can_number] = name;
+    }
+}
+
+bool CANManager::begin(uint32_t bitrate, uint8_t can_number)
+{
+    if (can_number >= MAX_NUMBER_OF_CAN_INTERFACES || _ifaces_num >= MAX_NUMBER_OF_CAN_INTERFACES) {
+        return false;
+    }
+
+    CAN *iface = new CAN(_iface_names[can_number]);
+    if (iface == nullptr) {
+        return false;
+    }
+    if (!iface->begin(bitrate)) {
+        delete iface;
+        return false;
+    }
+
+    if (AP_BoardConfig_CAN::get_can_debug(can_number) >= 2) {
+        printf("CANManager: CAN%u on %s\n", (unsigned)(can_number + 1), _iface_names[can_number]);
+    }
+
+    _ifaces[_ifaces_num++] = iface;
+    return true;
+}
+
+CAN* CANManager::getIface(uint8_t iface_index)
+{
+    if (iface_index < _ifaces_num) {
+        return _ifaces[iface_index];
+    }
+    return nullptr;
+}
+
+uavcan::CanSelectMasks CANManager::_make_select_masks(const uavcan::CanFrame* (&pending_tx)[uavcan::MaxCanIfaces]) const
+{
+    uavcan::CanSelectMasks msk;
+
+    for (uint8_t i = 0; i < _ifaces_num; i++) {
+        if (_ifaces[i]->has_rx()) {
+            msk.read |= 1 << i;
+        }
+        if (pending_tx[i] != nullptr && _ifaces[i]->can_accept_tx()) {
+            msk.write |= 1 << i;
+        }
+    }
+
+    return msk;
+}
+
+int16_t CANManager::select(uavcan::CanSelectMasks& inout_masks,
+                           const uavcan::CanFrame* (&pending_tx)[uavcan::MaxCanIfaces],
+                           uavcan::MonotonicTime blocking_deadline)
+{
+    const uavcan::CanSelectMasks in_masks = inout_masks;
+
+    for (uint8_t i = 0; i < _ifaces_num; i++) {
+        _ifaces[i]->poll_tx();
+        _ifaces[i]->poll_rx();
+    }
+
+    // check if we already have some of the requested events
+    inout_masks = _make_select_masks(pending_tx);
+    if ((inout_masks.read & in_masks.read) != 0 || (inout_masks.write & in_masks.write) != 0) {
+        return 1;
+    }
+
+    // block until a socket is readable, has room for our queued frames
+    // or the deadline passes
+    struct pollfd fds[MAX_NUMBER_OF_CAN_INTERFACES];
+    for (uint8_t i = 0; i < _ifaces_num; i++) {
+        fds[i].fd = _ifaces[i]->get_fd();
+        fds[i].events = POLLIN;
+        if (_ifaces[i]->has_tx()) {
+            fds[i].events |= POLLOUT;
+        }
+        fds[i].revents = 0;
+    }
+
+    const uint64_t now_us = AP_HAL::micros64();
+    const uint64_t deadline_us = blocking_deadline.toUSec();
+    if (deadline_us > now_us) {
+        const uint64_t wait_us = deadline_us - now_us;
+        struct timespec ts;
+        ts.tv_sec = wait_us / 1000000ULL;
+        ts.tv_nsec = (wait_us % 1000000ULL) * 1000;
+        if (ppoll(fds, _ifaces_num, &ts, nullptr) > 0) {
+            for (uint8_t i = 0; i < _ifaces_num; i++) {
+                if (fds[i].revents & POLLOUT) {
+                    _ifaces[i]->poll_tx();
+                }
+                if (fds[i].revents & POLLIN) {
+                    _ifaces[i]->poll_rx();
+                }
+            }
+        }
+    }
+
+    // return what we got even if none of the requested events are set
+    inout_masks = _make_select_masks(pending_tx);
+    return 1;
+}
+
+#endif
@@ -0,0 +1,219 @@
+/*
+ * This file is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This file is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+ * SocketCAN driver for AP_UAVCAN
+ *
+ * Each interface is a raw CAN socket bound to a network interface
+ * (can0, can1 by default, or a vcan interface for testing). Frames are
+ * moved in batches with recvmmsg()/sendmmsg(). Outgoing frames wait in
+ * a priority queue ordered by CAN ID, and only a few are handed to the
+ * kernel at a time, so a high priority frame (e.g. an ESC command)
+ * never waits behind a long multi-frame transfer.
+ *
+ * The bitrate is not configured here; set it with "ip link" before
+ * starting the vehicle.
+ */
+#pragma once
+
+#include <AP_HAL/CAN.h>
+
+#if HAL_WITH_UAVCAN
+
+#include <sys/socket.h>
+
+#include <AP_HAL/utility/RingBuffer.h>
+
+#define LINUX_CAN_RX_QUEUE_SIZE 128
+#define LINUX_CAN_TX_QUEUE_SIZE 64
+
+// frames moved per recvmmsg()/sendmmsg() call
+#define LINUX_CAN_IO_BATCH 8
+
+// frames handed to the kernel and not yet echoed back as sent. The
+// kernel sends in FIFO order, so keeping this small lets a frame
+// queued later with a higher priority overtake
+#define LINUX_CAN_TX_IN_FLIGHT 2
+
+// forget frames in flight when no echo has come back for this long,
+// e.g. after bus-off or an echo dropped on a full receive buffer
+#define LINUX_CAN_TX_ECHO_TIMEOUT_US 100000
+
+// frames requested with CanIOFlagLoopback awaiting their echo
+#define LINUX_CAN_LOOPBACK_QUEUE_SIZE 4
+
+// fastest drift followed between the hardware and kernel clocks, 100ppm
+#define LINUX_CAN_HW_CLOCK_DRIFT_DIV 10000
+
+namespace Linux {
+
+/*
+ * Transmit queue ordered by CAN arbitration priority. Frames of equal
+ * priority leave in the order they were queued, which keeps the
+ * frames of a multi-frame transfer in sequence.
+ */
+class CANTxQueue {
+public:
+    struct Item {
+        uavcan::CanFrame frame;
+        uavcan::MonotonicTime deadline;
+        uavcan::CanIOFlags flags;
+        uint32_t order;
+    };
+
+    bool push(const uavcan::CanFrame &frame, uavcan::MonotonicTime deadline, uavcan::CanIOFlags flags);
+
+    // put back an item taken with pop(), keeping its place in line
+    bool push(const Item &item);
+
+    const Item *top() const { return _count > 0 ? &_heap[0] : nullptr; }
+    bool pop(Item &item);
+
+    uint16_t size() const { return _count; }
+    uint16_t space() const { return LINUX_CAN_TX_QUEUE_SIZE - _count; }
+    void clear() { _count = 0; }
+
+private:
+    static bool higher_priority(const Item &a, const Item &b);
+
+    Item _heap[LINUX_CAN_TX_QUEUE_SIZE];
+    uint16_t _count = 0;
+    uint32_t _next_order = 0;
+};
+
+/*
+ * Maps hardware receive timestamps onto the kernel software clock.
+ * The software timestamp of a frame always comes some time after the
+ * hardware one, so the smallest offset between them is the closest to
+ * the true one. The minimum is allowed to creep up with time, never
+ * with the number of frames, to follow a hardware clock running slow.
+ */
+class CANHWClock {
+public:
+    uint64_t to_sw_us(uint64_t hw_us, uint64_t sw_us);
+
+private:
+    int64_t _offset_us = 0;
+    uint64_t _updated_sw_us = 0;
+    bool _valid = false;
+};
+
+class CAN: public AP_HAL::CAN {
+public:
+    enum {
+        ErrNotOpen = 1001,
+        ErrUnsupportedFrame = 1004,
+        ErrFilter = 1008,
+    };
+
+    CAN(const char *name);
+    ~CAN();
+
+    bool begin(uint32_t bitrate) override;
+    void end() override;
+    void reset() override;
+    bool is_initialized() override { return _fd >= 0; }
+    int32_t tx_pending() override;
+    int32_t available() override;
+
+    int16_t send(const uavcan::CanFrame& frame, uavcan::MonotonicTime tx_deadline,
+                 uavcan::CanIOFlags flags) override;
+
+    int16_t receive(uavcan::CanFrame& out_frame, uavcan::MonotonicTime& out_ts_monotonic,
+                    uavcan::UtcTime& out_ts_utc, uavcan::CanIOFlags& out_flags) override;
+
+    int16_t configureFilters(const uavcan::CanFilterConfig* filter_configs, uint16_t num_configs) override;
+
+    uint16_t getNumFilters() const override { return NumFilters; }
+
+    uint64_t getErrorCount() const override { return _error_cnt; }
+
+    int get_fd() const { return _fd; }
+
+    // move frames between the socket and the queues without blocking
+    void poll_rx();
+    void poll_tx();
+
+    bool has_rx() const { return !_rx_queue.empty(); }
+    bool has_tx() const { return _tx_queue.size() != 0 && _tx_in_flight < LINUX_CAN_TX_IN_FLIGHT; }
+    bool can_accept_tx() const { return _tx_queue.space() != 0; }
+
+private:
+    enum {
+        NumFilters = 32
+    };
+
+    struct RxItem {
+        uavcan::CanFrame frame;
+        uint64_t timestamp_us;  // AP_HAL::micros64() time base
+        uavcan::CanIOFlags flags;
+    };
+
+    bool _open();
+    uint64_t _rx_timestamp(struct msghdr &msg, uint64_t realtime_now_us, uint64_t hal_now_us);
+    bool _is_loopback(const uavcan::CanFrame &frame);
+
+    const char *_name;
+    int _fd = -1;
+
+    ObjectBuffer<RxItem> _rx_queue{LINUX_CAN_RX_QUEUE_SIZE};
+    CANTxQueue _tx_queue;
+
+    uavcan::CanFrame _loopback[LINUX_CAN_LOOPBACK_QUEUE_SIZE];
+    uint8_t _loopback_count = 0;
+
+    uint8_t _tx_in_flight = 0;
+    uint64_t _tx_echo_us = 0;
+
+    CANHWClock _hw_clock;
+
+    uint64_t _error_cnt = 0;
+};
+
+class CANManager: public AP_HAL::CANManager {
+public:
+    CANManager() { }
+
+    // network interface used for CAN port can_number
+    static void set_interface_name(uint8_t can_number, const char *name);
+
+    bool begin(uint32_t bitrate, uint8_t can_number) override;
+
+    bool is_initialized() override { return _initialized; }
+    void initialized(bool val) override { _initialized = val; }
+
+    AP_UAVCAN *get_UAVCAN(void) override { return _uavcan; }
+    void set_UAVCAN(AP_UAVCAN *uavcan) override { _uavcan = uavcan; }
+
+    CAN* getIface(uint8_t iface_index) override;
+    uint8_t getNumIfaces() const override { return _ifaces_num; }
+
+    int16_t select(uavcan::CanSelectMasks& inout_masks,
+                   const uavcan::CanFrame* (&pending_tx)[uavcan::MaxCanIfaces],
+                   uavcan::MonotonicTime blocking_deadline) override;
+
+private:
+    uavcan::CanSelectMasks _make_select_masks(const uavcan::CanFrame* (&pending_tx)[uavcan::MaxCanIfaces]) const;
+
+    static const char *_iface_names[MAX_NUMBER_OF_CAN_INTERFACES];
+
+    CAN *_ifaces[MAX_NUMBER_OF_CAN_INTERFACES] {};
+    uint8_t _ifaces_num = 0;
+    bool _initialized = false;
+    AP_UAVCAN *_uavcan = nullptr;
+};
+
+}
+
+#endif
@@ -16,9 +16,11 @@
 #include "AnalogIn_ADS1115.h"
 #include "AnalogIn_IIO.h"
 #include "AnalogIn_Navio2.h"
+#include "CAN.h"
 #include "GPIO.h"
 #include "I2CDevice.h"
 #include "OpticalFlow_Onboard.h"
+#include "PollerThread.h"
 #include "RCInput.h"
 #include "RCInput_AioPRU.h"
 #include "RCInput_DSM.h"
@@ -264,6 +266,17 @@ void _usage(void)
     printf("\tmodule support:\n");
     printf("\t                   --module-directory %s\n", AP_MODULE_DEFAULT_DIRECTORY);
     printf("\t                   -M %s\n", AP_MODULE_DEFAULT_DIRECTORY);
+    printf("\tbus thread priority and CPU:\n");
+    printf("\t                   --bus-thread ap-spi-0:30:3\n");
+    printf("\t                   -b ap-i2c-1:20\n");
+    printf("\tkeep other threads off a CPU:\n");
+    printf("\t                   --isolate-cpu 3\n");
+    printf("\t                   -i 3\n");
+#if HAL_WITH_UAVCAN
+    printf("\tCAN interfaces:\n");
+    printf("\t                   --can0 can0\n");
+    printf("\t                   --can1 vcan1\n");
+#endif
 }
 
 void HAL_Linux::run(int argc, char* const argv[], Callbacks* callbacks) const
@@ -287,11 +300,17 @@ void HAL_Linux::run(int argc, char* const argv[], Callbacks* callbacks) const
         {"log-directory",       true,  0, 'l'},
         {"terrain-directory",   true,  0, 't'},
         {"module-directory",    true,  0, 'M'},
+        {"bus-thread",          true,  0, 'b'},
+        {"isolate-cpu",         true,  0, 'i'},
+#if HAL_WITH_UAVCAN
+        {"can0",                true,  0, 'c'},
+        {"can1",                true,  0, 'd'},
+#endif
         {"help",                false,  0, 'h'},
         {0, false, 0, 0}
     };
 
-    GetOptLong gopt(argc, argv, "A:B:C:D:E:F:l:t:he:SM:",
+    GetOptLong gopt(argc, argv, "A:B:C:D:E:F:l:t:he:SM:c:d:b:i:",
                     options);
 
     /*
@@ -334,6 +353,26 @@ void HAL_Linux::run(int argc, char* const argv[], Callbacks* callbacks) const
         case 'M':
             module_path = gopt.optarg;
             break;
+        case 'b':
+            if (!PollerThread::add_bus_thread_config(gopt.optarg)) {
+                printf("Invalid bus thread '%s'\n", gopt.optarg);
+                exit(1);
+            }
+            break;
+        case 'i':
+            if (!PollerThread::isolate_cpu(atoi(gopt.optarg))) {
+                printf("Unable to isolate CPU '%s'\n", gopt.optarg);
+                exit(1);
+            }
+            break;
+#if HAL_WITH_UAVCAN
+        case 'c':
+            CANManager::set_interface_name(0, gopt.optarg);
+            break;
+        case 'd':
+            CANManager::set_interface_name(1, gopt.optarg);
+            break;
+#endif
         case 'h':
             _usage();
             exit(0);
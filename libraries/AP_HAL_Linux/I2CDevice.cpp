@@ -263,8 +263,7 @@ AP_HAL::Device::PeriodicHandle I2CDevice::register_periodic_callback(
         snprintf(name, sizeof(name), "ap-i2c-%u", _bus.bus);
 
         _bus.thread.set_stack_size(AP_LINUX_SENSORS_STACK_SIZE);
-        _bus.thread.start(name, AP_LINUX_SENSORS_SCHED_POLICY,
-                          AP_LINUX_SENSORS_SCHED_PRIO);
+        _bus.thread.start_bus_thread(name);
     }
 
     return static_cast<AP_HAL::Device::PeriodicHandle>(p);
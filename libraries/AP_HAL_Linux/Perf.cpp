@@ -74,7 +74,7 @@ void Perf::_debug_counters()
         if (!c.count) {
             fprintf(stderr, "%-30s\t"
                     "(no events)\n", c.name);
-        } else if (c.type == Util::PC_ELAPSED) {
+        } else if (c.type == Util::PC_ELAPSED || c.type == Util::PC_INTERVAL) {
             fprintf(stderr, "%-30s\t"
                     "count: %" PRIu64 "\t"
                     "min: %" PRIu64 "\t"
@@ -163,14 +163,22 @@ void Perf::end(Util::perf_counter_t pc)
 
     const uint64_t elapsed = now_nsec() - perf.start;
     perf.count++;
-    perf.total += elapsed;
+    _add_sample(perf, elapsed, perf.count);
+    perf.start = 0;
+
+    perf.lttng.end(perf.name);
+}
+
+void Perf::_add_sample(Perf_Counter &perf, uint64_t sample, uint64_t n)
+{
+    perf.total += sample;
 
-    if (perf.min > elapsed) {
-        perf.min = elapsed;
+    if (perf.min > sample) {
+        perf.min = sample;
     }
 
-    if (perf.max < elapsed) {
-        perf.max = elapsed;
+    if (perf.max < sample) {
+        perf.max = sample;
     }
 
     /*
@@ -178,12 +186,9 @@ void Perf::end(Util::perf_counter_t pc)
      * Knuth/Welford recursive avg and variance of update intervals (via Wikipedia)
      * Same implementation of PX4.
      */
-    const double delta_intvl = elapsed - perf.avg;
-    perf.avg += (delta_intvl / perf.count);
-    perf.m2 += (delta_intvl * (elapsed - perf.avg));
-    perf.start = 0;
-
-    perf.lttng.end(perf.name);
+    const double delta_intvl = sample - perf.avg;
+    perf.avg += (delta_intvl / n);
+    perf.m2 += (delta_intvl * (sample - perf.avg));
 }
 
 void Perf::count(Util::perf_counter_t pc)
@@ -195,9 +200,9 @@ void Perf::count(Util::perf_counter_t pc)
     }
 
     Perf_Counter &perf = _perf_counters[idx];
-    if (perf.type != Util::PC_COUNT) {
+    if (perf.type != Util::PC_COUNT && perf.type != Util::PC_INTERVAL) {
         hal.console->printf("perf_begin() called on perf_counter_t(%s) that"
-                            " is not of PC_COUNT type.\n",
+                            " is not of PC_COUNT or PC_INTERVAL type.\n",
                             perf.name);
         return;
     }
@@ -205,12 +210,22 @@ void Perf::count(Util::perf_counter_t pc)
     _update_count++;
     perf.count++;
 
+    if (perf.type == Util::PC_INTERVAL) {
+        /* the interval is from the previous count, stored in start */
+        const uint64_t now = now_nsec();
+        if (perf.start != 0) {
+            _add_sample(perf, now - perf.start, perf.count - 1);
+        }
+        perf.start = now;
+    }
+
     perf.lttng.count(perf.name, perf.count);
 }
 
 Util::perf_counter_t Perf::add(Util::perf_counter_type type, const char *name)
 {
-    if (type != Util::PC_COUNT && type != Util::PC_ELAPSED) {
+    if (type != Util::PC_COUNT && type != Util::PC_ELAPSED &&
+        type != Util::PC_INTERVAL) {
         /*
          * Other perf counters not implemented for now since they are not
          * used anywhere.
@@ -81,6 +81,9 @@ private:
 
     void _debug_counters();
 
+    /* add an elapsed time or interval to the statistics of a counter */
+    void _add_sample(Perf_Counter &perf, uint64_t sample, uint64_t n);
+
     uint64_t _last_debug_msec;
 
     std::vector<Perf_Counter> _perf_counters;
@@ -18,13 +18,41 @@
 
 #include <algorithm>
 #include <poll.h>
+#include <sched.h>
+#include <stdio.h>
+#include <string.h>
 #include <sys/epoll.h>
 #include <sys/timerfd.h>
+#include <unistd.h>
 
+#include <AP_HAL/AP_HAL.h>
 #include <AP_Math/AP_Math.h>
 
+#include "Scheduler.h"
+
+extern const AP_HAL::HAL &hal;
+
+#define MAX_BUS_THREADS 8
+
 namespace Linux {
 
+struct BusThreadConfig {
+    char name[16];
+    int prio;
+    int cpu;
+};
+
+static BusThreadConfig bus_thread_configs[MAX_BUS_THREADS];
+static uint8_t n_bus_thread_configs;
+
+static PollerThread *bus_threads[MAX_BUS_THREADS];
+static uint8_t n_bus_threads;
+
+/* upper bounds of the jitter histogram bins, the last bin has no bound */
+static const uint16_t jitter_bins_usec[AP_HAL::Util::BUS_JITTER_BINS - 1] = {
+    10, 20, 50, 100, 200, 500, 1000
+};
+
 void TimerPollable::on_can_read()
 {
     if (_removeme) {
@@ -37,6 +65,12 @@ void TimerPollable::on_can_read()
         return;
     }
 
+    const uint64_t now_usec = AP_HAL::micros64();
+    if (_last_usec != 0) {
+        _thread->_update_stats(now_usec - _last_usec, _period_usec, nevents);
+    }
+    _last_usec = now_usec;
+
     if (_wrapper) {
         _wrapper->start_cb();
     }
@@ -83,9 +117,143 @@ bool TimerPollable::adjust_timer(uint32_t timeout_usec)
         return false;
     }
 
+    // the timer restarts now, so the next interval isn't a period
+    _period_usec = timeout_usec;
+    _last_usec = 0;
+
     return true;
 }
 
+PollerThread::~PollerThread()
+{
+    for (uint8_t i = 0; i < n_bus_threads; i++) {
+        if (bus_threads[i] == this) {
+            memmove(&bus_threads[i], &bus_threads[i + 1],
+                    (n_bus_threads - i - 1) * sizeof(bus_threads[0]));
+            n_bus_threads--;
+            break;
+        }
+    }
+}
+
+bool PollerThread::add_bus_thread_config(const char *config)
+{
+    BusThreadConfig c { };
+
+    c.cpu = -1;
+    int n = sscanf(config, "%15[^:]:%d:%d", c.name, &c.prio, &c.cpu);
+    if (n < 2 ||
+        c.prio < sched_get_priority_min(AP_LINUX_SENSORS_SCHED_POLICY) ||
+        c.prio > sched_get_priority_max(AP_LINUX_SENSORS_SCHED_POLICY)) {
+        return false;
+    }
+    if (n == 3 && (c.cpu < 0 || c.cpu >= sysconf(_SC_NPROCESSORS_CONF))) {
+        return false;
+    }
+    if (n_bus_thread_configs >= MAX_BUS_THREADS) {
+        return false;
+    }
+
+    bus_thread_configs[n_bus_thread_configs++] = c;
+
+    return true;
+}
+
+bool PollerThread::isolate_cpu(int cpu)
+{
+    cpu_set_t cpus;
+
+    if (cpu < 0 || cpu >= CPU_SETSIZE ||
+        sched_getaffinity(0, sizeof(cpus), &cpus) != 0) {
+        return false;
+    }
+
+    /*
+      threads inherit the affinity of the thread creating them, so
+      taking the CPU away from the main thread before anything else
+      starts keeps it free for the threads pinned there
+     */
+    CPU_CLR(cpu, &cpus);
+    if (CPU_COUNT(&cpus) == 0) {
+        return false;
+    }
+
+    return sched_setaffinity(0, sizeof(cpus), &cpus) == 0;
+}
+
+bool PollerThread::start_bus_thread(const char *name)
+{
+    int prio = AP_LINUX_SENSORS_SCHED_PRIO;
+
+    for (uint8_t i = 0; i < n_bus_thread_configs; i++) {
+        const BusThreadConfig &c = bus_thread_configs[i];
+        if (strcmp(c.name, name) != 0) {
+            continue;
+        }
+        prio = c.prio;
+        if (c.cpu >= 0 && !set_cpu_affinity(c.cpu)) {
+            return false;
+        }
+        break;
+    }
+
+    strncpy(_stats.name, name, sizeof(_stats.name) - 1);
+    _perf_interval = hal.util->perf_alloc(AP_HAL::Util::PC_INTERVAL, _stats.name);
+    _is_bus_thread = true;
+
+    if (!start(name, AP_LINUX_SENSORS_SCHED_POLICY, prio)) {
+        return false;
+    }
+
+    if (n_bus_threads < MAX_BUS_THREADS) {
+        bus_threads[n_bus_threads++] = this;
+    }
+
+    return true;
+}
+
+bool PollerThread::get_bus_thread_stats(uint8_t idx, AP_HAL::Util::BusThreadStats &stats)
+{
+    if (idx >= n_bus_threads) {
+        return false;
+    }
+
+    stats = bus_threads[idx]->_stats;
+
+    return true;
+}
+
+/*
+  account for a callback coming interval_usec after the previous one
+  on a timer with the given period. If the thread fell behind by whole
+  periods the timer expired nevents times since then
+ */
+void PollerThread::_update_stats(uint64_t interval_usec, uint32_t period_usec,
+                                 uint64_t nevents)
+{
+    const uint64_t expected_usec = period_usec * nevents;
+    const uint64_t jitter_usec = interval_usec > expected_usec ?
+        interval_usec - expected_usec : expected_usec - interval_usec;
+
+    uint8_t bin = 0;
+    while (bin < ARRAY_SIZE(jitter_bins_usec) && jitter_usec >= jitter_bins_usec[bin]) {
+        bin++;
+    }
+
+    _stats.histogram[bin]++;
+    _stats.callbacks++;
+    if (nevents > 1) {
+        _stats.overruns += nevents - 1;
+    }
+    if (jitter_usec > _stats.max_jitter_us) {
+        _stats.max_jitter_us = MIN(jitter_usec, UINT32_MAX);
+    }
+
+    if (_is_bus_thread) {
+        hal.util->perf_count(_perf_interval);
+    }
+}
+
 TimerPollable *PollerThread::add_timer(TimerPollable::PeriodicCb cb,
                                        TimerPollable::WrapperCb *wrapper,
                                        uint32_t timeout_usec)
@@ -93,7 +261,7 @@ TimerPollable *PollerThread::add_timer(TimerPollable::PeriodicCb cb,
     if (!_poller) {
         return nullptr;
     }
-    TimerPollable *p = new TimerPollable(cb, wrapper);
+    TimerPollable *p = new TimerPollable(cb, wrapper, this);
     if (!p || !p->setup_timer(timeout_usec) ||
         !_poller.register_pollable(p, POLLIN)) {
         delete p;
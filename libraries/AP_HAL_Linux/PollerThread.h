@@ -19,6 +19,7 @@
 #include <inttypes.h>
 #include <vector>
 
+#include <AP_HAL/AP_HAL.h>
 #include <AP_HAL/Device.h>
 
 #include "Poller.h"
@@ -26,6 +27,8 @@
 
 namespace Linux {
 
+class PollerThread;
+
 class TimerPollable : public Pollable {
     friend class PollerThread;
 
@@ -48,22 +51,52 @@ public:
     bool adjust_timer(uint32_t timeout_usec);
 
 protected:
-    TimerPollable(PeriodicCb cb, WrapperCb *wrapper)
+    TimerPollable(PeriodicCb cb, WrapperCb *wrapper, PollerThread *thread)
         : _cb(cb)
         , _wrapper(wrapper)
+        , _thread(thread)
     {
     }
 
     PeriodicCb _cb;
     WrapperCb *_wrapper;
+    PollerThread *_thread;
     bool _removeme = false;
+
+    /* requested period and time of the last callback, for the jitter */
+    uint32_t _period_usec = 0;
+    uint64_t _last_usec = 0;
 };
 
 
 class PollerThread : public Thread {
+    friend class TimerPollable;
+
 public:
     PollerThread() : Thread{FUNCTOR_BIND_MEMBER(&PollerThread::mainloop, void)} { }
-    virtual ~PollerThread() { }
+    virtual ~PollerThread();
+
+    /*
+     * Start as the thread of a device bus. The priority and CPU are the
+     * ones given for @name with #add_bus_thread_config(), if any, or the
+     * sensor thread priority on any CPU otherwise.
+     */
+    bool start_bus_thread(const char *name);
+
+    /*
+     * Set the scheduling of a bus thread from a string of the form
+     * NAME:PRIO[:CPU], e.g. "ap-spi-0:30:3"
+     */
+    static bool add_bus_thread_config(const char *config);
+
+    /*
+     * Keep the threads of the process off @cpu unless they are explicitly
+     * pinned to it. Must be called before any thread is started.
+     */
+    static bool isolate_cpu(int cpu);
+
+    /* See AP_HAL::Util::get_bus_thread_stats() */
+    static bool get_bus_thread_stats(uint8_t idx, AP_HAL::Util::BusThreadStats &stats);
 
     TimerPollable *add_timer(TimerPollable::PeriodicCb cb,
                              TimerPollable::WrapperCb *wrapper,
@@ -76,9 +109,15 @@ public:
 
 protected:
     void _cleanup_timers();
+    void _update_stats(uint64_t interval_usec, uint32_t period_usec,
+                       uint64_t nevents);
 
     Poller _poller{};
     std::vector<TimerPollable*> _timers{};
+
+    bool _is_bus_thread = false;
+    AP_HAL::Util::BusThreadStats _stats{};
+    AP_HAL::Util::perf_counter_t _perf_interval = nullptr;
 };
 
 }
@@ -242,13 +242,53 @@ bool SPIDevice::set_speed(AP_HAL::Device::Speed speed)
     return true;
 }
 
-bool SPIDevice::transfer(const uint8_t *send, uint32_t send_len,
-                         uint8_t *recv, uint32_t recv_len)
+/*
+  make sure the bus is in the mode of this device. Assumes the bus
+  semaphore is held
+ */
+bool SPIDevice::_set_mode()
 {
-    struct spi_ioc_transfer msgs[2] = { };
-    unsigned nmsgs = 0;
+    if (_bus.last_mode == _desc.mode) {
+        /*
+          the mode in the kernel is not tied to the file descriptor,
+          so there is a chance some other process has changed it since
+          we last used the bus. We want to report when this happens so
+          the user has a chance of figuring out when there is
+          conflicted use of the SPI bus. Unfortunately this costs us
+          an extra syscall per transfer.
+         */
+        uint8_t current_mode;
+        if (ioctl(_bus.fd, SPI_IOC_RD_MODE, &current_mode) < 0) {
+            hal.console->printf("SPIDevice: error on getting mode fd=%d (%s)\n",
+                                _bus.fd, strerror(errno));
+            _bus.last_mode = -1;
+        } else if (current_mode != _bus.last_mode) {
+            hal.console->printf("SPIDevice: bus mode conflict fd=%d mode=%u/%u\n",
+                                _bus.fd, (unsigned)_bus.last_mode, (unsigned)current_mode);
+            _bus.last_mode = -1;
+        }
+    }
+    if (_desc.mode != _bus.last_mode) {
+        int r = ioctl(_bus.fd, SPI_IOC_WR_MODE, &_desc.mode);
+        if (r < 0) {
+            hal.console->printf("SPIDevice: error on setting mode fd=%d (%s)\n",
+                                _bus.fd, strerror(errno));
+            return false;
+        }
+        _bus.last_mode = _desc.mode;
+    }
+    return true;
+}
 
-    assert(_bus.fd >= 0);
+/*
+  add the send and receive messages of one transfer to msgs, returning
+  the number of messages added
+ */
+unsigned SPIDevice::_add_msgs(struct spi_ioc_transfer *msgs,
+                              const uint8_t *send, uint32_t send_len,
+                              uint8_t *recv, uint32_t recv_len)
+{
+    unsigned nmsgs = 0;
 
     if (send && send_len != 0) {
         msgs[nmsgs].tx_buf = (uint64_t) send;
@@ -272,43 +312,28 @@ bool SPIDevice::transfer(const uint8_t *send, uint32_t send_len,
         nmsgs++;
     }
 
+    return nmsgs;
+}
+
+bool SPIDevice::transfer(const uint8_t *send, uint32_t send_len,
+                         uint8_t *recv, uint32_t recv_len)
+{
+    struct spi_ioc_transfer msgs[2] = { };
+    unsigned nmsgs;
+
+    assert(_bus.fd >= 0);
+
+    nmsgs = _add_msgs(msgs, send, send_len, recv, recv_len);
     if (!nmsgs) {
         return false;
     }
 
-    int r;
-    if (_bus.last_mode == _desc.mode) {
-        /*
-          the mode in the kernel is not tied to the file descriptor,
-          so there is a chance some other process has changed it since
-          we last used the bus. We want to report when this happens so
-          the user has a chance of figuring out when there is
-          conflicted use of the SPI bus. Unfortunately this costs us
-          an extra syscall per transfer.
-         */
-        uint8_t current_mode;
-        if (ioctl(_bus.fd, SPI_IOC_RD_MODE, &current_mode) < 0) {
-            hal.console->printf("SPIDevice: error on getting mode fd=%d (%s)\n",
-                                _bus.fd, strerror(errno));
-            _bus.last_mode = -1;
-        } else if (current_mode != _bus.last_mode) {
-            hal.console->printf("SPIDevice: bus mode conflict fd=%d mode=%u/%u\n",
-                                _bus.fd, (unsigned)_bus.last_mode, (unsigned)current_mode);
-            _bus.last_mode = -1;
-        }
-    }
-    if (_desc.mode != _bus.last_mode) {
-        r = ioctl(_bus.fd, SPI_IOC_WR_MODE, &_desc.mode);
-        if (r < 0) {
-            hal.console->printf("SPIDevice: error on setting mode fd=%d (%s)\n",
-                                _bus.fd, strerror(errno));
-            return false;
-        }
-        _bus.last_mode = _desc.mode;
+    if (!_set_mode()) {
+        return false;
     }
 
     _cs_assert();
-    r = ioctl(_bus.fd, SPI_IOC_MESSAGE(nmsgs), &msgs);
+    int r = ioctl(_bus.fd, SPI_IOC_MESSAGE(nmsgs), &msgs);
     _cs_release();
 
     if (r == -1) {
@@ -320,6 +345,61 @@ bool SPIDevice::transfer(const uint8_t *send, uint32_t send_len,
     return true;
 }
 
+bool SPIDevice::has_batched_transfers() const
+{
+    // the kernel can only toggle chip selects it owns between transfers
+    return _desc.cs_pin == SPI_CS_KERNEL;
+}
+
+/*
+  queue all segments in a single SPI_IOC_MESSAGE, asking the kernel to
+  release the chip select at the end of each segment
+ */
+bool SPIDevice::transfer_segments(const Segment *segments, uint8_t count)
+{
+    struct spi_ioc_transfer msgs[2 * MAX_SEGMENTS] = { };
+    unsigned nmsgs = 0;
+
+    if (!has_batched_transfers()) {
+        return AP_HAL::SPIDevice::transfer_segments(segments, count);
+    }
+
+    assert(_bus.fd >= 0);
+
+    if (count > MAX_SEGMENTS) {
+        return false;
+    }
+
+    for (uint8_t i = 0; i < count; i++) {
+        const Segment &s = segments[i];
+        unsigned n = _add_msgs(&msgs[nmsgs], s.send, s.send_len, s.recv, s.recv_len);
+        if (!n) {
+            return false;
+        }
+        nmsgs += n;
+        if (i != count - 1) {
+            msgs[nmsgs - 1].cs_change = 1;
+        }
+    }
+
+    if (!nmsgs) {
+        return false;
+    }
+
+    if (!_set_mode()) {
+        return false;
+    }
+
+    int r = ioctl(_bus.fd, SPI_IOC_MESSAGE(nmsgs), &msgs);
+    if (r == -1) {
+        hal.console->printf("SPIDevice: error transferring segments fd=%d (%s)\n",
+                            _bus.fd, strerror(errno));
+        return false;
+    }
+
+    return true;
+}
+
 bool SPIDevice::transfer_fullduplex(const uint8_t *send, uint8_t *recv,
                                     uint32_t len)
 {
@@ -396,8 +476,7 @@ AP_HAL::Device::PeriodicHandle SPIDevice::register_periodic_callback(
         snprintf(name, sizeof(name), "ap-spi-%u", _bus.bus);
 
         _bus.thread.set_stack_size(AP_LINUX_SENSORS_STACK_SIZE);
-        _bus.thread.start(name, AP_LINUX_SENSORS_SCHED_POLICY,
-                          AP_LINUX_SENSORS_SCHED_PRIO);
+        _bus.thread.start_bus_thread(name);
     }
 
     return static_cast<AP_HAL::Device::PeriodicHandle>(p);
@@ -22,6 +22,8 @@
 #include <AP_HAL/HAL.h>
 #include <AP_HAL/SPIDevice.h>
 
+struct spi_ioc_transfer;
+
 namespace Linux {
 
 class SPIBus;
@@ -42,6 +44,12 @@ public:
     bool transfer(const uint8_t *send, uint32_t send_len,
                   uint8_t *recv, uint32_t recv_len) override;
 
+    /* See AP_HAL::Device::transfer_segments() */
+    bool transfer_segments(const Segment *segments, uint8_t count) override;
+
+    /* See AP_HAL::Device::has_batched_transfers() */
+    bool has_batched_transfers() const override;
+
     /* See AP_HAL::SPIDevice::transfer_fullduplex() */
     bool transfer_fullduplex(const uint8_t *send, uint8_t *recv,
                              uint32_t len) override;
@@ -72,6 +80,18 @@ protected:
      * Deselect device if using userspace CS
      */
     void _cs_release();
+
+    /*
+     * Set the SPI mode of this device on the bus if needed
+     */
+    bool _set_mode();
+
+    /*
+     * Fill in the messages for one transfer, returning how many were used
+     */
+    unsigned _add_msgs(struct spi_ioc_transfer *msgs,
+                       const uint8_t *send, uint32_t send_len,
+                       uint8_t *recv, uint32_t recv_len);
 };
 
 class SPIDeviceManager : public AP_HAL::SPIDeviceManager {
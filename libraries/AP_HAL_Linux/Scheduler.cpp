@@ -18,6 +18,10 @@
 #include "UARTDriver.h"
 #include "Util.h"
 
+#if HAL_WITH_UAVCAN
+#include <AP_UAVCAN/AP_UAVCAN.h>
+#endif
+
 #if CONFIG_HAL_BOARD_SUBTYPE == HAL_BOARD_SUBTYPE_LINUX_QFLIGHT
 #include <rpcmem.h>
 #include <AP_HAL_Linux/qflight/qflight_util.h>
@@ -30,6 +34,7 @@ using namespace Linux;
 extern const AP_HAL::HAL& hal;
 
 #define APM_LINUX_TIMER_PRIORITY        15
+#define APM_LINUX_UAVCAN_PRIORITY       14
 #define APM_LINUX_UART_PRIORITY         14
 #define APM_LINUX_RCIN_PRIORITY         13
 #define APM_LINUX_MAIN_PRIORITY         12
@@ -37,6 +42,7 @@ extern const AP_HAL::HAL& hal;
 #define APM_LINUX_IO_PRIORITY           10
 
 #define APM_LINUX_TIMER_RATE            1000
+#define APM_LINUX_UAVCAN_RATE           1000
 #define APM_LINUX_UART_RATE             100
 #if CONFIG_HAL_BOARD_SUBTYPE == HAL_BOARD_SUBTYPE_LINUX_NAVIO ||    \
     CONFIG_HAL_BOARD_SUBTYPE == HAL_BOARD_SUBTYPE_LINUX_ERLEBRAIN2 || \
@@ -358,6 +364,7 @@ void Scheduler::system_initialized()
 
 void Scheduler::reboot(bool hold_in_bootloader)
 {
+    run_shutdown_procs();
     exit(1);
 }
 
@@ -384,13 +391,49 @@ bool Scheduler::SchedulerThread::_run()
     return PeriodicThread::_run();
 }
 
+#if HAL_WITH_UAVCAN
+void Scheduler::create_uavcan_thread()
+{
+    if (_uavcan_thread.is_started()) {
+        return;
+    }
+    _uavcan_thread.set_rate(APM_LINUX_UAVCAN_RATE);
+    _uavcan_thread.set_stack_size(256 * 1024);
+    _uavcan_thread.start("ap-uavcan", SCHED_FIFO, APM_LINUX_UAVCAN_PRIORITY);
+}
+
+/*
+  do_cyclic() blocks in the CAN driver for up to a millisecond waiting
+  for frames, so this runs back to back
+ */
+void Scheduler::_uavcan_task()
+{
+    for (uint8_t i = 0; i < MAX_NUMBER_OF_CAN_DRIVERS; i++) {
+        AP_HAL::CANManager *mgr = hal.can_mgr[i];
+        if (mgr != nullptr && mgr->is_initialized() && mgr->get_UAVCAN() != nullptr) {
+            mgr->get_UAVCAN()->do_cyclic();
+        }
+    }
+}
+#endif
+
 void Scheduler::teardown()
 {
+    // the IO thread is about to stop, anything it would have written
+    // out has to be written now
+    run_shutdown_procs();
+
     _timer_thread.stop();
     _io_thread.stop();
     _rcin_thread.stop();
     _uart_thread.stop();
     _tonealarm_thread.stop();
+#if HAL_WITH_UAVCAN
+    if (_uavcan_thread.is_started()) {
+        _uavcan_thread.stop();
+        _uavcan_thread.join();
+    }
+#endif
 
     _timer_thread.join();
     _io_thread.join();
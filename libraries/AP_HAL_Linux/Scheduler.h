@@ -51,6 +51,10 @@ public:
 
     void teardown();
 
+#if HAL_WITH_UAVCAN
+    void create_uavcan_thread() override;
+#endif
+
 private:
     class SchedulerThread : public PeriodicThread {
     public:
@@ -89,12 +93,19 @@ private:
     SchedulerThread _rcin_thread{FUNCTOR_BIND_MEMBER(&Scheduler::_rcin_task, void), *this};
     SchedulerThread _uart_thread{FUNCTOR_BIND_MEMBER(&Scheduler::_uart_task, void), *this};
     SchedulerThread _tonealarm_thread{FUNCTOR_BIND_MEMBER(&Scheduler::_tonealarm_task, void), *this};
+#if HAL_WITH_UAVCAN
+    // started on demand, so not a SchedulerThread
+    PeriodicThread _uavcan_thread{FUNCTOR_BIND_MEMBER(&Scheduler::_uavcan_task, void)};
+#endif
 
     void _timer_task();
     void _io_task();
     void _rcin_task();
     void _uart_task();
     void _tonealarm_task();
+#if HAL_WITH_UAVCAN
+    void _uavcan_task();
+#endif
 
     void _run_io();
     void _run_uarts();
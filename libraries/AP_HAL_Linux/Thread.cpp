@@ -17,6 +17,7 @@
 #include "Thread.h"
 
 #include <alloca.h>
+#include <sched.h>
 #include <sys/types.h>
 #include <stdio.h>
 #include <unistd.h>
@@ -184,6 +185,16 @@ bool Thread::start(const char *name, int policy, int prio)
         }
     }
 
+    if (_cpu >= 0) {
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        CPU_SET(_cpu, &cpus);
+        if ((r = pthread_attr_setaffinity_np(&attr, sizeof(cpus), &cpus)) != 0) {
+            AP_HAL::panic("Failed to set CPU %d for thread '%s': %s",
+                          _cpu, name, strerror(r));
+        }
+    }
+
     r = pthread_create(&_ctx, &attr, &Thread::_run_trampoline, this);
     if (r != 0) {
         AP_HAL::panic("Failed to create thread '%s': %s",
@@ -244,6 +255,17 @@ bool Thread::set_stack_size(size_t stack_size)
     return true;
 }
 
+bool Thread::set_cpu_affinity(int cpu)
+{
+    if (_started || cpu >= CPU_SETSIZE) {
+        return false;
+    }
+
+    _cpu = cpu;
+
+    return true;
+}
+
 bool PeriodicThread::_run()
 {
     if (_period_usec == 0) {
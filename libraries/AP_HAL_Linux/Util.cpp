@@ -10,6 +10,7 @@
 #include <AP_HAL/AP_HAL.h>
 
 #include "Heat_Pwm.h"
+#include "PollerThread.h"
 #include "ToneAlarm_Disco.h"
 #include "Util.h"
 
@@ -206,3 +207,8 @@ int Util::get_hw_arm32()
     fclose(f);
     return -ENOENT;
 }
+
+bool Util::get_bus_thread_stats(uint8_t idx, BusThreadStats &stats)
+{
+    return PollerThread::get_bus_thread_stats(idx, stats);
+}
@@ -91,6 +91,8 @@ public:
         return Perf::get_instance()->count(perf);
     }
 
+    bool get_bus_thread_stats(uint8_t idx, BusThreadStats &stats) override;
+
     // create a new semaphore
     AP_HAL::Semaphore *new_semaphore(void) override { return new Semaphore; }
 
@@ -0,0 +1,93 @@
+#include <AP_gbenchmark.h>
+#include <AP_HAL/AP_HAL.h>
+
+#if CONFIG_HAL_BOARD == HAL_BOARD_LINUX && HAL_WITH_UAVCAN
+
+#include <AP_HAL_Linux/CAN.h>
+
+static uavcan::CanFrame make_frame(uint32_t id)
+{
+    const uint8_t data[8] {};
+    return uavcan::CanFrame(id | uavcan::CanFrame::FlagEFF, data, sizeof(data));
+}
+
+static uavcan::MonotonicTime deadline()
+{
+    return uavcan::MonotonicTime::fromUSec(AP_HAL::micros64() + 100000);
+}
+
+/*
+  frames per second through vcan0, sent in bursts of range_x frames
+ */
+static void BM_CANThroughput(benchmark::State& state)
+{
+    Linux::CAN tx("vcan0");
+    Linux::CAN rx("vcan0");
+
+    if (!tx.begin(0) || !rx.begin(0)) {
+        state.SetLabel("vcan0 not available");
+        while (state.KeepRunning()) {
+        }
+        return;
+    }
+
+    const int burst = state.range_x();
+    uavcan::CanFrame frame;
+    uavcan::MonotonicTime ts;
+    uavcan::UtcTime utc;
+    uavcan::CanIOFlags flags;
+
+    while (state.KeepRunning()) {
+        int sent = 0;
+        int received = 0;
+        while (received < burst) {
+            while (sent < burst && tx.can_accept_tx()) {
+                tx.send(make_frame(0x100 + sent), deadline(), 0);
+                sent++;
+            }
+            tx.poll_rx();
+            tx.poll_tx();
+            while (rx.receive(frame, ts, utc, flags) == 1) {
+                received++;
+            }
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * burst);
+}
+
+BENCHMARK(BM_CANThroughput)->Arg(1)->Arg(8)->Arg(64);
+
+/*
+  time from send() until the frame is available to another socket
+ */
+static void BM_CANLatency(benchmark::State& state)
+{
+    Linux::CAN tx("vcan0");
+    Linux::CAN rx("vcan0");
+
+    if (!tx.begin(0) || !rx.begin(0)) {
+        state.SetLabel("vcan0 not available");
+        while (state.KeepRunning()) {
+        }
+        return;
+    }
+
+    uavcan::CanFrame frame;
+    uavcan::MonotonicTime ts;
+    uavcan::UtcTime utc;
+    uavcan::CanIOFlags flags;
+
+    while (state.KeepRunning()) {
+        tx.send(make_frame(0x10), deadline(), 0);
+        while (rx.receive(frame, ts, utc, flags) != 1) {
+        }
+        // collect the echo so the next frame isn't held back
+        tx.poll_rx();
+    }
+}
+
+BENCHMARK(BM_CANLatency);
+
+#endif
+
+BENCHMARK_MAIN()
@@ -0,0 +1,118 @@
+#include <AP_gbenchmark.h>
+
+#include <fcntl.h>
+#include <linux/spi/spidev.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+/*
+  The requests an Invensense IMU on a kernel chip select makes to spidev
+  for each 1kHz poll of its FIFO, with the sample rate in kHz as the
+  argument. Each iteration is one poll, so the time per iteration in
+  microseconds divided by 10 is the CPU percentage used per IMU.
+
+  The ioctls are copies of what SPIDevice::transfer() and
+  transfer_segments() issue, not calls into SPIDevice, which needs a
+  board's device table. By default they go to /dev/null, where they
+  fail with ENOTTY, so the figures only count the syscalls made per
+  poll; none of the spidev driver or the bus is included. Set
+  AP_SPIDEV_BENCHMARK to the spidev node of an Invensense IMU to
+  measure the real transfers.
+ */
+
+#define SAMPLE_SIZE     14
+#define FIFO_BUFFER_LEN 16
+#define REG_FIFO_COUNTH (0x72 | 0x80)
+#define REG_FIFO_R_W    (0x74 | 0x80)
+
+static int spi_fd = -1;
+static uint8_t fifo_buf[FIFO_BUFFER_LEN * SAMPLE_SIZE];
+
+static void open_device()
+{
+    if (spi_fd >= 0) {
+        return;
+    }
+    const char *path = getenv("AP_SPIDEV_BENCHMARK");
+    spi_fd = open(path ? path : "/dev/null", O_RDWR | O_CLOEXEC);
+}
+
+static void add_msg(struct spi_ioc_transfer &msg, const uint8_t *send, uint8_t *recv, uint32_t len)
+{
+    memset(&msg, 0, sizeof(msg));
+    msg.tx_buf = (uint64_t) send;
+    msg.rx_buf = (uint64_t) recv;
+    msg.len = len;
+    msg.speed_hz = 11000000;
+    msg.bits_per_word = 8;
+}
+
+// as done by SPIDevice::transfer(): check the bus mode, then the message
+static void transfer(const uint8_t *send, uint32_t send_len, uint8_t *recv, uint32_t recv_len)
+{
+    struct spi_ioc_transfer msgs[2];
+    uint8_t mode;
+
+    add_msg(msgs[0], send, nullptr, send_len);
+    add_msg(msgs[1], nullptr, recv, recv_len);
+    ioctl(spi_fd, SPI_IOC_RD_MODE, &mode);
+    ioctl(spi_fd, SPI_IOC_MESSAGE(2), msgs);
+}
+
+// the FIFO count, then the samples a buffer at a time
+static void BM_FifoReadSeparate(benchmark::State& state)
+{
+    open_device();
+    const uint8_t per_poll = state.range_x();
+    const uint8_t count_reg = REG_FIFO_COUNTH;
+    const uint8_t fifo_reg = REG_FIFO_R_W;
+    uint8_t count[2];
+
+    while (state.KeepRunning()) {
+        transfer(&count_reg, 1, count, sizeof(count));
+        for (uint8_t remaining = per_poll; remaining > 0; ) {
+            uint8_t n = remaining < FIFO_BUFFER_LEN ? remaining : FIFO_BUFFER_LEN;
+            transfer(&fifo_reg, 1, fifo_buf, n * SAMPLE_SIZE);
+            remaining -= n;
+        }
+        gbenchmark_escape(fifo_buf);
+    }
+    state.SetItemsProcessed(state.iterations() * per_poll);
+}
+
+// the samples with the trailing FIFO count as one request, as done by
+// SPIDevice::transfer_segments()
+static void BM_FifoReadBatched(benchmark::State& state)
+{
+    open_device();
+    const uint8_t per_poll = state.range_x();
+    const uint8_t count_reg = REG_FIFO_COUNTH;
+    const uint8_t fifo_reg = REG_FIFO_R_W;
+    uint8_t count[2];
+
+    while (state.KeepRunning()) {
+        for (uint8_t remaining = per_poll; remaining > 0; ) {
+            struct spi_ioc_transfer msgs[4];
+            uint8_t mode;
+            uint8_t n = remaining < FIFO_BUFFER_LEN ? remaining : FIFO_BUFFER_LEN;
+
+            add_msg(msgs[0], &fifo_reg, nullptr, 1);
+            add_msg(msgs[1], nullptr, fifo_buf, n * SAMPLE_SIZE);
+            msgs[1].cs_change = 1;
+            add_msg(msgs[2], &count_reg, nullptr, 1);
+            add_msg(msgs[3], nullptr, count, sizeof(count));
+            ioctl(spi_fd, SPI_IOC_RD_MODE, &mode);
+            ioctl(spi_fd, SPI_IOC_MESSAGE(4), msgs);
+            remaining -= n;
+        }
+        gbenchmark_escape(fifo_buf);
+    }
+    state.SetItemsProcessed(state.iterations() * per_poll);
+}
+
+BENCHMARK(BM_FifoReadSeparate)->Arg(1)->Arg(2)->Arg(8);
+BENCHMARK(BM_FifoReadBatched)->Arg(1)->Arg(2)->Arg(8);
+
+BENCHMARK_MAIN()
@@ -255,6 +255,8 @@ void PX4Scheduler::resume_timer_procs()
 
 void PX4Scheduler::reboot(bool hold_in_bootloader)
 {
+    run_shutdown_procs();
+
     // disarm motors to ensure they are off during a bootloader upload
     hal.rcout->force_safety_on();
     hal.rcout->force_safety_no_wait();
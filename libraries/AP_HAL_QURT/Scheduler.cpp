@@ -147,6 +147,7 @@ void Scheduler::resume_timer_procs()
 
 void Scheduler::reboot(bool hold_in_bootloader) 
 {
+    run_shutdown_procs();
     HAP_PRINTF("**** REBOOT REQUESTED ****");
     usleep(2000000);
     exit(1);
@@ -139,6 +139,7 @@ void Scheduler::sitl_end_atomic() {
 
 void Scheduler::reboot(bool hold_in_bootloader)
 {
+    run_shutdown_procs();
     hal.uartA->printf("REBOOT NOT IMPLEMENTED\r\n\n");
 }
 
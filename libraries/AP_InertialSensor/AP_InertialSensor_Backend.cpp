@@ -117,6 +117,34 @@ void AP_InertialSensor_Backend::_rotate_and_correct_gyro(uint8_t instance, Vecto
     gyro.rotate(_imu._board_orientation);
 }
 
+void AP_InertialSensor_Backend::_rotate_and_correct_accel_many(uint8_t instance, Vector3f *accel, uint8_t n)
+{
+    Vector3f::rotate_many(accel, n, _imu._accel_orientation[instance]);
+
+    const Vector3f &accel_offset = _imu._accel_offset[instance].get();
+    const Vector3f &accel_scale = _imu._accel_scale[instance].get();
+    for (uint8_t i = 0; i < n; i++) {
+        accel[i] -= accel_offset;
+        accel[i].x *= accel_scale.x;
+        accel[i].y *= accel_scale.y;
+        accel[i].z *= accel_scale.z;
+    }
+
+    Vector3f::rotate_many(accel, n, _imu._board_orientation);
+}
+
+void AP_InertialSensor_Backend::_rotate_and_correct_gyro_many(uint8_t instance, Vector3f *gyro, uint8_t n)
+{
+    Vector3f::rotate_many(gyro, n, _imu._gyro_orientation[instance]);
+
+    const Vector3f &gyro_offset = _imu._gyro_offset[instance].get();
+    for (uint8_t i = 0; i < n; i++) {
+        gyro[i] -= gyro_offset;
+    }
+
+    Vector3f::rotate_many(gyro, n, _imu._board_orientation);
+}
+
 /*
   rotate gyro vector and add the gyro offset
  */
@@ -103,6 +103,10 @@ protected:
     void _rotate_and_correct_accel(uint8_t instance, Vector3f &accel);
     void _rotate_and_correct_gyro(uint8_t instance, Vector3f &gyro);
 
+    // rotate and correct a block of n samples read together from a FIFO
+    void _rotate_and_correct_accel_many(uint8_t instance, Vector3f *accel, uint8_t n);
+    void _rotate_and_correct_gyro_many(uint8_t instance, Vector3f *gyro, uint8_t n);
+
     // rotate gyro vector, offset and publish
     void _publish_gyro(uint8_t instance, const Vector3f &gyro);
 
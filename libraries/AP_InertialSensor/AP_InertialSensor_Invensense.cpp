@@ -48,6 +48,15 @@ extern const AP_HAL::HAL& hal;
 #define INVENSENSE_EXT_SYNC_ENABLE 0
 #endif
 
+/*
+  BATCHED_FIFO_READ reads the FIFO and the count for the next poll as
+  one bus request on buses that can queue transfers. This halves the
+  requests per poll, but samples wait up to one extra poll period
+ */
+#ifndef INVENSENSE_BATCHED_FIFO_READ
+#define INVENSENSE_BATCHED_FIFO_READ 0
+#endif
+
 // common registers
 #define MPUREG_XG_OFFS_TC                       0x00
 #define MPUREG_YG_OFFS_TC                       0x01
@@ -355,16 +364,30 @@ void AP_InertialSensor_Invensense::_fifo_reset()
 {
     uint8_t user_ctrl = _last_stat_user_ctrl;
     user_ctrl &= ~(BIT_USER_CTRL_FIFO_RESET | BIT_USER_CTRL_FIFO_EN);
+    const uint8_t fifo_en = BIT_XG_FIFO_EN | BIT_YG_FIFO_EN |
+        BIT_ZG_FIFO_EN | BIT_ACCEL_FIFO_EN | BIT_TEMP_FIFO_EN;
     _dev->set_speed(AP_HAL::Device::SPEED_LOW);
-    _register_write(MPUREG_FIFO_EN, 0);
-    _register_write(MPUREG_USER_CTRL, user_ctrl);
-    _register_write(MPUREG_USER_CTRL, user_ctrl | BIT_USER_CTRL_FIFO_RESET);
-    _register_write(MPUREG_USER_CTRL, user_ctrl | BIT_USER_CTRL_FIFO_EN);
-    _register_write(MPUREG_FIFO_EN, BIT_XG_FIFO_EN | BIT_YG_FIFO_EN |
-                    BIT_ZG_FIFO_EN | BIT_ACCEL_FIFO_EN | BIT_TEMP_FIFO_EN, true);
+    if (INVENSENSE_BATCHED_FIFO_READ && _dev->has_batched_transfers()) {
+        const uint8_t regs[][2] = {
+            { MPUREG_FIFO_EN, 0 },
+            { MPUREG_USER_CTRL, user_ctrl },
+            { MPUREG_USER_CTRL, (uint8_t)(user_ctrl | BIT_USER_CTRL_FIFO_RESET) },
+            { MPUREG_USER_CTRL, (uint8_t)(user_ctrl | BIT_USER_CTRL_FIFO_EN) },
+            { MPUREG_FIFO_EN, fifo_en },
+        };
+        _dev->set_checked_register(MPUREG_FIFO_EN, fifo_en);
+        _dev->write_registers(regs, ARRAY_SIZE(regs));
+    } else {
+        _register_write(MPUREG_FIFO_EN, 0);
+        _register_write(MPUREG_USER_CTRL, user_ctrl);
+        _register_write(MPUREG_USER_CTRL, user_ctrl | BIT_USER_CTRL_FIFO_RESET);
+        _register_write(MPUREG_USER_CTRL, user_ctrl | BIT_USER_CTRL_FIFO_EN);
+        _register_write(MPUREG_FIFO_EN, fifo_en, true);
+    }
     hal.scheduler->delay_microseconds(1);
     _dev->set_speed(AP_HAL::Device::SPEED_HIGH);
     _last_stat_user_ctrl = user_ctrl | BIT_USER_CTRL_FIFO_EN;
+    _fifo_pending = 0;
 
     notify_accel_fifo_reset(_accel_instance);
     notify_gyro_fifo_reset(_gyro_instance);
@@ -558,42 +581,56 @@ void AP_InertialSensor_Invensense::_poll_data()
 
 bool AP_InertialSensor_Invensense::_accumulate(uint8_t *samples, uint8_t n_samples)
 {
-    for (uint8_t i = 0; i < n_samples; i++) {
-        const uint8_t *data = samples + MPU_SAMPLE_SIZE * i;
-        Vector3f accel, gyro;
-        bool fsync_set = false;
+    // decode the whole block first so it can be rotated in one go
+    Vector3f accel[MPU_FIFO_BUFFER_LEN];
+    Vector3f gyro[MPU_FIFO_BUFFER_LEN];
+    uint16_t fsync_mask = 0;
+    bool ret = true;
+    uint8_t n;
+
+    n_samples = MIN(n_samples, MPU_FIFO_BUFFER_LEN);
+    for (n = 0; n < n_samples; n++) {
+        const uint8_t *data = samples + MPU_SAMPLE_SIZE * n;
 
 #if INVENSENSE_EXT_SYNC_ENABLE
-        fsync_set = (int16_val(data, 2) & 1U) != 0;
+        if ((int16_val(data, 2) & 1U) != 0) {
+            fsync_mask |= 1U << n;
+        }
 #endif
-        
-        accel = Vector3f(int16_val(data, 1),
-                         int16_val(data, 0),
-                         -int16_val(data, 2));
-        accel *= _accel_scale;
 
         int16_t t2 = int16_val(data, 3);
         if (!_check_raw_temp(t2)) {
             debug("temp reset %d %d", _raw_temp, t2);
-            _fifo_reset();
-            return false;
+            ret = false;
+            break;
         }
         float temp = t2 * temp_sensitivity + temp_zero;
-        
-        gyro = Vector3f(int16_val(data, 5),
-                        int16_val(data, 4),
-                        -int16_val(data, 6));
-        gyro *= GYRO_SCALE;
+        _temp_filtered = _temp_filter.apply(temp);
 
-        _rotate_and_correct_accel(_accel_instance, accel);
-        _rotate_and_correct_gyro(_gyro_instance, gyro);
+        accel[n] = Vector3f(int16_val(data, 1),
+                            int16_val(data, 0),
+                            -int16_val(data, 2));
+        accel[n] *= _accel_scale;
 
-        _notify_new_accel_raw_sample(_accel_instance, accel, 0, fsync_set);
-        _notify_new_gyro_raw_sample(_gyro_instance, gyro);
+        gyro[n] = Vector3f(int16_val(data, 5),
+                           int16_val(data, 4),
+                           -int16_val(data, 6));
+        gyro[n] *= GYRO_SCALE;
+    }
 
-        _temp_filtered = _temp_filter.apply(temp);
+    _rotate_and_correct_accel_many(_accel_instance, accel, n);
+    _rotate_and_correct_gyro_many(_gyro_instance, gyro, n);
+
+    for (uint8_t i = 0; i < n; i++) {
+        _notify_new_accel_raw_sample(_accel_instance, accel[i], 0, (fsync_mask & (1U << i)) != 0);
+        _notify_new_gyro_raw_sample(_gyro_instance, gyro[i]);
     }
-    return true;
+
+    if (!ret) {
+        // the samples before the corrupt one are still good
+        _fifo_reset();
+    }
+    return ret;
 }
 
 /*
@@ -682,6 +719,11 @@ void AP_InertialSensor_Invensense::_read_fifo()
     uint8_t *rx = _fifo_buffer;
     bool need_reset = false;
 
+    if (INVENSENSE_BATCHED_FIFO_READ && _dev->has_batched_transfers()) {
+        _read_fifo_batched();
+        goto check_registers;
+    }
+
     if (!_block_read(MPUREG_FIFO_COUNTH, rx, 2)) {
         goto check_registers;
     }
@@ -756,6 +798,55 @@ check_registers:
     _dev->set_speed(AP_HAL::Device::SPEED_HIGH);
 }
 
+/*
+  read the samples the last call found in the FIFO together with the
+  FIFO count for the next call, as a single bus request. The count
+  trails the data so each call only reads samples known to be complete,
+  which delays samples by at most one poll period but halves the number
+  of requests to the bus driver. Only used with
+  INVENSENSE_BATCHED_FIFO_READ
+ */
+void AP_InertialSensor_Invensense::_read_fifo_batched()
+{
+    uint8_t *rx = _fifo_buffer;
+    uint8_t count_rx[2];
+    uint8_t fifo_reg = MPUREG_FIFO_R_W | 0x80;
+    uint8_t count_reg = MPUREG_FIFO_COUNTH | 0x80;
+    // see _read_fifo() for why more than 32 samples means a reset. The
+    // first samples are still good, so take a buffer full first
+    const bool need_reset = _fifo_pending > 32;
+    // anything else that doesn't fit in the buffer is read next time
+    const uint8_t n = MIN(_fifo_pending, MPU_FIFO_BUFFER_LEN);
+
+    const AP_HAL::Device::Segment segments[] = {
+        { &fifo_reg, 1, rx, (uint32_t)n * MPU_SAMPLE_SIZE },
+        { &count_reg, 1, count_rx, sizeof(count_rx) },
+    };
+    const uint8_t first = n > 0 ? 0 : 1;
+    if (!_dev->transfer_segments(&segments[first], ARRAY_SIZE(segments) - first)) {
+        _fifo_pending = 0;
+        return;
+    }
+    _fifo_pending = uint16_val(count_rx, 0) / MPU_SAMPLE_SIZE;
+
+    if (n > 0) {
+        bool ok;
+        if (_fast_sampling) {
+            ok = _accumulate_fast_sampling(rx, n);
+        } else {
+            ok = _accumulate(rx, n);
+        }
+        if (!ok) {
+            // the FIFO has been reset
+            return;
+        }
+    }
+
+    if (need_reset) {
+        _fifo_reset();
+    }
+}
+
 /*
   fetch temperature in order to detect FIFO sync errors
 */
@@ -80,6 +80,7 @@ private:
 
     /* Read samples from FIFO (FIFO enabled) */
     void _read_fifo();
+    void _read_fifo_batched();
 
     /* Check if there's data available by either reading DRDY pin or register */
     bool _data_ready();
@@ -131,6 +132,10 @@ private:
     // buffer for fifo read
     uint8_t *_fifo_buffer;
 
+    // samples known to be in the FIFO from the count read by the last
+    // _read_fifo_batched()
+    uint16_t _fifo_pending;
+
     /*
       accumulators for fast sampling
       See description in _accumulate_fast_sampling()
@@ -0,0 +1,198 @@
+#include <AP_gbenchmark.h>
+
+#include <AP_Math/AP_Math.h>
+
+/*
+  location functions called with an origin and a set of nearby points,
+  as done by waypoint navigation, fences, rally points and avoidance
+ */
+
+#define NUM_POINTS 1024
+
+static Location origin;
+
+static Location points[NUM_POINTS];
+static Vector2f offsets[NUM_POINTS];
+
+static void setup_points()
+{
+    static bool done;
+    if (done) {
+        return;
+    }
+    origin.lat = -353632610;
+    origin.lng = 1491652300;
+    origin.alt = 58400;
+    for (uint16_t i=0; i<NUM_POINTS; i++) {
+        // points spread over a few km around the origin
+        offsets[i] = Vector2f(cosf(i * 0.37f), sinf(i * 0.61f)) * (i * 3.0f);
+        points[i] = origin;
+        location_offset(points[i], offsets[i].x, offsets[i].y);
+    }
+    done = true;
+}
+
+static void BM_LongitudeScale(benchmark::State& state)
+{
+    setup_points();
+    uint16_t i = 0;
+    while (state.KeepRunning()) {
+        float scale = longitude_scale(points[i++ % NUM_POINTS]);
+        gbenchmark_escape(&scale);
+    }
+}
+
+static void BM_GetDistance(benchmark::State& state)
+{
+    setup_points();
+    uint16_t i = 0;
+    while (state.KeepRunning()) {
+        float dist = get_distance(origin, points[i++ % NUM_POINTS]);
+        gbenchmark_escape(&dist);
+    }
+}
+
+static void BM_FrameDistance(benchmark::State& state)
+{
+    setup_points();
+    LocalTangentFrame frame(origin);
+    uint16_t i = 0;
+    while (state.KeepRunning()) {
+        float dist = frame.distance(points[i++ % NUM_POINTS]);
+        gbenchmark_escape(&dist);
+    }
+}
+
+static void BM_GetBearing(benchmark::State& state)
+{
+    setup_points();
+    uint16_t i = 0;
+    while (state.KeepRunning()) {
+        int32_t bearing = get_bearing_cd(origin, points[i++ % NUM_POINTS]);
+        gbenchmark_escape(&bearing);
+    }
+}
+
+static void BM_FrameBearing(benchmark::State& state)
+{
+    setup_points();
+    LocalTangentFrame frame(origin);
+    uint16_t i = 0;
+    while (state.KeepRunning()) {
+        int32_t bearing = frame.bearing_cd(points[i++ % NUM_POINTS]);
+        gbenchmark_escape(&bearing);
+    }
+}
+
+static void BM_LocationDiff(benchmark::State& state)
+{
+    setup_points();
+    uint16_t i = 0;
+    while (state.KeepRunning()) {
+        Vector2f ne = location_diff(origin, points[i++ % NUM_POINTS]);
+        gbenchmark_escape(&ne);
+    }
+}
+
+static void BM_FrameNE(benchmark::State& state)
+{
+    setup_points();
+    LocalTangentFrame frame(origin);
+    uint16_t i = 0;
+    while (state.KeepRunning()) {
+        Vector2f ne = frame.ne(points[i++ % NUM_POINTS]);
+        gbenchmark_escape(&ne);
+    }
+}
+
+static void BM_LocationOffset(benchmark::State& state)
+{
+    setup_points();
+    uint16_t i = 0;
+    while (state.KeepRunning()) {
+        Location loc = origin;
+        location_offset(loc, offsets[i % NUM_POINTS].x, offsets[i % NUM_POINTS].y);
+        i++;
+        gbenchmark_escape(&loc);
+    }
+}
+
+static void BM_FrameOffset(benchmark::State& state)
+{
+    setup_points();
+    LocalTangentFrame frame(origin);
+    uint16_t i = 0;
+    while (state.KeepRunning()) {
+        Location loc;
+        frame.offset(loc, offsets[i % NUM_POINTS].x, offsets[i % NUM_POINTS].y);
+        i++;
+        gbenchmark_escape(&loc);
+    }
+}
+
+static void BM_LocationUpdate(benchmark::State& state)
+{
+    setup_points();
+    uint16_t i = 0;
+    while (state.KeepRunning()) {
+        Location loc = origin;
+        location_update(loc, (i++ % 360), 250.0f);
+        gbenchmark_escape(&loc);
+    }
+}
+
+static void BM_LocationDiffMany(benchmark::State& state)
+{
+    setup_points();
+    const uint16_t count = state.range_x();
+    Vector2f ne[NUM_POINTS];
+    while (state.KeepRunning()) {
+        for (uint16_t i=0; i<count; i++) {
+            ne[i] = location_diff(origin, points[i]);
+        }
+        gbenchmark_escape(ne);
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+}
+
+static void BM_FrameNEMany(benchmark::State& state)
+{
+    setup_points();
+    const uint16_t count = state.range_x();
+    Vector2f ne[NUM_POINTS];
+    while (state.KeepRunning()) {
+        LocalTangentFrame frame(origin);
+        frame.ne(points, ne, count);
+        gbenchmark_escape(ne);
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+}
+
+static void BM_FrameOffsetMany(benchmark::State& state)
+{
+    setup_points();
+    const uint16_t count = state.range_x();
+    Location locs[NUM_POINTS];
+    while (state.KeepRunning()) {
+        LocalTangentFrame frame(origin);
+        frame.offset(offsets, locs, count);
+        gbenchmark_escape(locs);
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+}
+
+BENCHMARK(BM_LongitudeScale);
+BENCHMARK(BM_GetDistance);
+BENCHMARK(BM_FrameDistance);
+BENCHMARK(BM_GetBearing);
+BENCHMARK(BM_FrameBearing);
+BENCHMARK(BM_LocationDiff);
+BENCHMARK(BM_FrameNE);
+BENCHMARK(BM_LocationOffset);
+BENCHMARK(BM_FrameOffset);
+BENCHMARK(BM_LocationUpdate);
+BENCHMARK(BM_LocationDiffMany)->Arg(16)->Arg(1024);
+BENCHMARK(BM_FrameNEMany)->Arg(16)->Arg(1024);
+BENCHMARK(BM_FrameOffsetMany)->Arg(16)->Arg(1024);
+
+BENCHMARK_MAIN()
@@ -2,6 +2,29 @@
 
 #include <AP_Math/AP_Math.h>
 
+#define NUM_VECTORS 256
+
+static Vector3f vectors[NUM_VECTORS];
+
+static void setup_vectors()
+{
+    static bool done;
+    if (done) {
+        return;
+    }
+    for (uint16_t i=0; i<NUM_VECTORS; i++) {
+        vectors[i] = Vector3f(sinf(i * 0.3f), cosf(i * 0.7f), sinf(i * 1.1f)) * 9.8f;
+    }
+    done = true;
+}
+
+static Matrix3f attitude()
+{
+    Matrix3f m;
+    m.from_euler(radians(10), radians(-20), radians(135));
+    return m;
+}
+
 static void BM_MatrixMultiplication(benchmark::State& state)
 {
     Matrix3f m1(Vector3f(1.0f, 2.0f, 3.0f),
@@ -17,6 +40,114 @@ static void BM_MatrixMultiplication(benchmark::State& state)
     }
 }
 
+static void BM_MatrixVectorMultiplication(benchmark::State& state)
+{
+    setup_vectors();
+    const Matrix3f m = attitude();
+    uint16_t i = 0;
+    while (state.KeepRunning()) {
+        Vector3f v = m * vectors[i++ % NUM_VECTORS];
+        gbenchmark_escape(&v);
+    }
+}
+
+static void BM_MatrixMulTranspose(benchmark::State& state)
+{
+    setup_vectors();
+    const Matrix3f m = attitude();
+    uint16_t i = 0;
+    while (state.KeepRunning()) {
+        Vector3f v = m.mul_transpose(vectors[i++ % NUM_VECTORS]);
+        gbenchmark_escape(&v);
+    }
+}
+
+static void BM_MatrixRotate(benchmark::State& state)
+{
+    Matrix3f m = attitude();
+    const Vector3f g(0.0025f, -0.001f, 0.0005f);
+    while (state.KeepRunning()) {
+        m.rotate(g);
+        gbenchmark_escape(&m);
+    }
+}
+
+static void BM_MatrixNormalize(benchmark::State& state)
+{
+    Matrix3f m = attitude();
+    while (state.KeepRunning()) {
+        m.normalize();
+        gbenchmark_escape(&m);
+    }
+}
+
+// the DCM update done for every IMU sample: integrate the gyro and renormalise
+static void BM_MatrixDCMUpdate(benchmark::State& state)
+{
+    Matrix3f m = attitude();
+    const Vector3f g(0.0025f, -0.001f, 0.0005f);
+    while (state.KeepRunning()) {
+        m.rotate(g);
+        m.normalize();
+        gbenchmark_escape(&m);
+    }
+}
+
+static void BM_MatrixFromEuler(benchmark::State& state)
+{
+    float yaw = 0;
+    while (state.KeepRunning()) {
+        Matrix3f m;
+        m.from_euler(radians(10), radians(-20), yaw);
+        gbenchmark_escape(&m);
+        yaw += 0.01f;
+    }
+}
+
+static void BM_MatrixToEuler(benchmark::State& state)
+{
+    const Matrix3f m = attitude();
+    while (state.KeepRunning()) {
+        float roll, pitch, yaw;
+        m.to_euler(&roll, &pitch, &yaw);
+        gbenchmark_escape(&roll);
+        gbenchmark_escape(&pitch);
+        gbenchmark_escape(&yaw);
+    }
+}
+
+static void BM_MatrixFromAxisAngle(benchmark::State& state)
+{
+    const Vector3f axis(0.2f, -0.3f, 0.9f);
+    float theta = 0;
+    while (state.KeepRunning()) {
+        Matrix3f m;
+        m.from_axis_angle(axis, theta);
+        gbenchmark_escape(&m);
+        theta += 0.01f;
+    }
+}
+
+static void BM_MatrixInverse(benchmark::State& state)
+{
+    const Matrix3f m = attitude();
+    while (state.KeepRunning()) {
+        Matrix3f inv;
+        bool ok = m.inverse(inv);
+        gbenchmark_escape(&ok);
+        gbenchmark_escape(&inv);
+    }
+}
+
 BENCHMARK(BM_MatrixMultiplication);
+BENCHMARK(BM_MatrixVectorMultiplication);
+BENCHMARK(BM_MatrixMulTranspose);
+BENCHMARK(BM_MatrixRotate);
+BENCHMARK(BM_MatrixNormalize);
+BENCHMARK(BM_MatrixDCMUpdate);
+BENCHMARK(BM_MatrixFromEuler);
+BENCHMARK(BM_MatrixToEuler);
+BENCHMARK(BM_MatrixFromAxisAngle);
+BENCHMARK(BM_MatrixInverse);
 
 BENCHMARK_MAIN()
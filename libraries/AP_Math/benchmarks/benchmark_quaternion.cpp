@@ -0,0 +1,141 @@
+#include <AP_gbenchmark.h>
+
+#include <AP_Math/AP_Math.h>
+
+static Quaternion attitude()
+{
+    Quaternion q;
+    q.from_euler(radians(10), radians(-20), radians(135));
+    return q;
+}
+
+static void BM_QuaternionMultiplication(benchmark::State& state)
+{
+    const Quaternion q1 = attitude();
+    Quaternion q2;
+    q2.from_euler(radians(1), radians(2), radians(3));
+    while (state.KeepRunning()) {
+        Quaternion q3 = q1 * q2;
+        gbenchmark_escape(&q3);
+    }
+}
+
+static void BM_QuaternionNormalize(benchmark::State& state)
+{
+    Quaternion q = attitude();
+    while (state.KeepRunning()) {
+        q.normalize();
+        gbenchmark_escape(&q);
+    }
+}
+
+static void BM_QuaternionFromEuler(benchmark::State& state)
+{
+    float yaw = 0;
+    while (state.KeepRunning()) {
+        Quaternion q;
+        q.from_euler(radians(10), radians(-20), yaw);
+        gbenchmark_escape(&q);
+        yaw += 0.01f;
+    }
+}
+
+static void BM_QuaternionToEuler(benchmark::State& state)
+{
+    const Quaternion q = attitude();
+    while (state.KeepRunning()) {
+        float roll, pitch, yaw;
+        q.to_euler(roll, pitch, yaw);
+        gbenchmark_escape(&roll);
+        gbenchmark_escape(&pitch);
+        gbenchmark_escape(&yaw);
+    }
+}
+
+static void BM_QuaternionRotationMatrix(benchmark::State& state)
+{
+    const Quaternion q = attitude();
+    while (state.KeepRunning()) {
+        Matrix3f m;
+        q.rotation_matrix(m);
+        gbenchmark_escape(&m);
+    }
+}
+
+static void BM_QuaternionFromRotationMatrix(benchmark::State& state)
+{
+    Matrix3f m;
+    m.from_euler(radians(10), radians(-20), radians(135));
+    while (state.KeepRunning()) {
+        Quaternion q;
+        q.from_rotation_matrix(m);
+        gbenchmark_escape(&q);
+    }
+}
+
+static void BM_QuaternionEarthToBody(benchmark::State& state)
+{
+    const Quaternion q = attitude();
+    Vector3f v(1, 2, 3);
+    while (state.KeepRunning()) {
+        q.earth_to_body(v);
+        gbenchmark_escape(&v);
+    }
+}
+
+static void BM_QuaternionToAxisAngle(benchmark::State& state)
+{
+    Quaternion q = attitude();
+    while (state.KeepRunning()) {
+        Vector3f v;
+        q.to_axis_angle(v);
+        gbenchmark_escape(&v);
+    }
+}
+
+static void BM_QuaternionFromAxisAngle(benchmark::State& state)
+{
+    const Vector3f v(0.0025f, -0.001f, 0.0005f);
+    while (state.KeepRunning()) {
+        Quaternion q;
+        q.from_axis_angle(v);
+        gbenchmark_escape(&q);
+    }
+}
+
+// integrating a gyro delta angle for every IMU sample, as the EKF does
+static void BM_QuaternionIntegrate(benchmark::State& state)
+{
+    Quaternion q = attitude();
+    const Vector3f delta_angle(0.0025f, -0.001f, 0.0005f);
+    while (state.KeepRunning()) {
+        q.rotate(delta_angle);
+        q.normalize();
+        gbenchmark_escape(&q);
+    }
+}
+
+static void BM_QuaternionIntegrateFast(benchmark::State& state)
+{
+    Quaternion q = attitude();
+    const Vector3f delta_angle(0.0025f, -0.001f, 0.0005f);
+    while (state.KeepRunning()) {
+        q.rotate_fast(delta_angle);
+        q.normalize();
+        gbenchmark_escape(&q);
+    }
+}
+
+BENCHMARK(BM_QuaternionMultiplication);
+BENCHMARK(BM_QuaternionNormalize);
+BENCHMARK(BM_QuaternionFromEuler);
+BENCHMARK(BM_QuaternionToEuler);
+BENCHMARK(BM_QuaternionRotationMatrix);
+BENCHMARK(BM_QuaternionFromRotationMatrix);
+BENCHMARK(BM_QuaternionEarthToBody);
+BENCHMARK(BM_QuaternionToAxisAngle);
+BENCHMARK(BM_QuaternionFromAxisAngle);
+BENCHMARK(BM_QuaternionIntegrate);
+BENCHMARK(BM_QuaternionIntegrateFast);
+
+BENCHMARK_MAIN()
@@ -0,0 +1,128 @@
+#include <AP_gbenchmark.h>
+
+#include <AP_Math/AP_Math.h>
+
+#define NUM_VECTORS 256
+
+static Vector3f vectors[NUM_VECTORS];
+
+static void setup_vectors()
+{
+    static bool done;
+    if (done) {
+        return;
+    }
+    for (uint16_t i=0; i<NUM_VECTORS; i++) {
+        vectors[i] = Vector3f(sinf(i * 0.3f), cosf(i * 0.7f), sinf(i * 1.1f)) * 9.8f;
+    }
+    done = true;
+}
+
+// rotation by a board orientation, done for every sample from every IMU and compass
+static void BM_VectorRotate(benchmark::State& state)
+{
+    setup_vectors();
+    const enum Rotation rotation = (enum Rotation)state.range_x();
+    uint16_t i = 0;
+    while (state.KeepRunning()) {
+        Vector3f v = vectors[i++ % NUM_VECTORS];
+        v.rotate(rotation);
+        gbenchmark_escape(&v);
+    }
+}
+
+static void BM_VectorRotateInverse(benchmark::State& state)
+{
+    setup_vectors();
+    const enum Rotation rotation = (enum Rotation)state.range_x();
+    uint16_t i = 0;
+    while (state.KeepRunning()) {
+        Vector3f v = vectors[i++ % NUM_VECTORS];
+        v.rotate_inverse(rotation);
+        gbenchmark_escape(&v);
+    }
+}
+
+// a FIFO block of samples rotated one at a time
+static void BM_VectorRotateLoop(benchmark::State& state)
+{
+    setup_vectors();
+    const enum Rotation rotation = (enum Rotation)state.range_x();
+    Vector3f block[16];
+    while (state.KeepRunning()) {
+        memcpy(block, vectors, sizeof(block));
+        for (uint8_t i=0; i<ARRAY_SIZE(block); i++) {
+            block[i].rotate(rotation);
+        }
+        gbenchmark_escape(block);
+    }
+    state.SetItemsProcessed(state.iterations() * ARRAY_SIZE(block));
+}
+
+static void BM_VectorRotateMany(benchmark::State& state)
+{
+    setup_vectors();
+    const enum Rotation rotation = (enum Rotation)state.range_x();
+    Vector3f block[16];
+    while (state.KeepRunning()) {
+        memcpy(block, vectors, sizeof(block));
+        Vector3f::rotate_many(block, ARRAY_SIZE(block), rotation);
+        gbenchmark_escape(block);
+    }
+    state.SetItemsProcessed(state.iterations() * ARRAY_SIZE(block));
+}
+
+static void BM_VectorNormalize(benchmark::State& state)
+{
+    setup_vectors();
+    uint16_t i = 0;
+    while (state.KeepRunning()) {
+        Vector3f v = vectors[i++ % NUM_VECTORS];
+        v.normalize();
+        gbenchmark_escape(&v);
+    }
+}
+
+static void BM_VectorLength(benchmark::State& state)
+{
+    setup_vectors();
+    uint16_t i = 0;
+    while (state.KeepRunning()) {
+        float length = vectors[i++ % NUM_VECTORS].length();
+        gbenchmark_escape(&length);
+    }
+}
+
+static void BM_VectorCrossProduct(benchmark::State& state)
+{
+    setup_vectors();
+    uint16_t i = 0;
+    while (state.KeepRunning()) {
+        Vector3f v = vectors[i % NUM_VECTORS] % vectors[(i + 1) % NUM_VECTORS];
+        gbenchmark_escape(&v);
+        i++;
+    }
+}
+
+static void BM_VectorAngle(benchmark::State& state)
+{
+    setup_vectors();
+    uint16_t i = 0;
+    while (state.KeepRunning()) {
+        float angle = vectors[i % NUM_VECTORS].angle(vectors[(i + 1) % NUM_VECTORS]);
+        gbenchmark_escape(&angle);
+        i++;
+    }
+}
+
+// no rotation, a permutation of the axes, a 45 degree rotation and an arbitrary rotation
+BENCHMARK(BM_VectorRotate)->Arg(ROTATION_NONE)->Arg(ROTATION_YAW_90)->Arg(ROTATION_YAW_45)->Arg(ROTATION_ROLL_90_PITCH_68_YAW_293);
+BENCHMARK(BM_VectorRotateInverse)->Arg(ROTATION_YAW_90)->Arg(ROTATION_ROLL_90_PITCH_68_YAW_293);
+BENCHMARK(BM_VectorRotateLoop)->Arg(ROTATION_YAW_90)->Arg(ROTATION_YAW_45)->Arg(ROTATION_ROLL_90_PITCH_68_YAW_293);
+BENCHMARK(BM_VectorRotateMany)->Arg(ROTATION_YAW_90)->Arg(ROTATION_YAW_45)->Arg(ROTATION_ROLL_90_PITCH_68_YAW_293);
+BENCHMARK(BM_VectorNormalize);
+BENCHMARK(BM_VectorLength);
+BENCHMARK(BM_VectorCrossProduct);
+BENCHMARK(BM_VectorAngle);
+
+BENCHMARK_MAIN()
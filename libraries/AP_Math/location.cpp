@@ -137,6 +137,63 @@ Vector3f location_3d_diff_NED(const struct Location &loc1, const struct Location
                     (loc1.alt - loc2.alt) * 0.01f);
 }
 
+/*
+  set the origin of a local tangent frame
+ */
+void LocalTangentFrame::set_origin(const struct Location &origin)
+{
+    _origin = origin;
+    _lng_scale = longitude_scale(origin);
+}
+
+// return distance in meters from the origin to loc
+float LocalTangentFrame::distance(const struct Location &loc) const
+{
+    float dlat              = (float)(loc.lat - _origin.lat);
+    float dlong             = ((float)(loc.lng - _origin.lng)) * _lng_scale;
+    return norm(dlat, dlong) * LOCATION_SCALING_FACTOR;
+}
+
+// return bearing in centi-degrees from the origin to loc
+int32_t LocalTangentFrame::bearing_cd(const struct Location &loc) const
+{
+    int32_t off_x = loc.lng - _origin.lng;
+    int32_t off_y = (loc.lat - _origin.lat) / _lng_scale;
+    int32_t bearing = 9000 + atan2f(-off_y, off_x) * 5729.57795f;
+    if (bearing < 0) bearing += 36000;
+    return bearing;
+}
+
+/*
+  set loc to the origin moved by distances north and east
+ */
+void LocalTangentFrame::offset(struct Location &loc, float ofs_north, float ofs_east) const
+{
+    loc = _origin;
+    loc.lat += (int32_t)(ofs_north * LOCATION_SCALING_FACTOR_INV);
+    loc.lng += (int32_t)((ofs_east * LOCATION_SCALING_FACTOR_INV) / _lng_scale);
+}
+
+/*
+  North/East distances from the origin to count locations
+ */
+void LocalTangentFrame::ne(const struct Location *locs, Vector2f *ne_out, uint16_t count) const
+{
+    for (uint16_t i=0; i<count; i++) {
+        ne_out[i] = ne(locs[i]);
+    }
+}
+
+/*
+  count locations at North/East distances from the origin
+ */
+void LocalTangentFrame::offset(const Vector2f *ne_in, struct Location *locs_out, uint16_t count) const
+{
+    for (uint16_t i=0; i<count; i++) {
+        offset(locs_out[i], ne_in[i].x, ne_in[i].y);
+    }
+}
+
 /*
   return true if lat and lng match. Ignores altitude and options
  */
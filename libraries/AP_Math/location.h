@@ -99,3 +99,56 @@ bool        check_latlng(float lat, float lng);
 bool        check_latlng(int32_t lat, int32_t lng);
 bool        check_latlng(Location loc);
 
+
+/*
+  local tangent frame about an origin. The longitude scale of the origin
+  is worked out once, so converting many locations near the same origin
+  costs no trig calls. Offsets and locations match location_diff(),
+  location_3d_diff_NED() and location_offset() called with the origin
+  as the first location.
+ */
+class LocalTangentFrame {
+public:
+    LocalTangentFrame() {}
+    LocalTangentFrame(const struct Location &origin) { set_origin(origin); }
+
+    // set the origin, recalculating its longitude scale
+    void set_origin(const struct Location &origin);
+
+    const struct Location &origin() const { return _origin; }
+
+    // longitude scale of the origin, as returned by longitude_scale()
+    float lng_scale() const { return _lng_scale; }
+
+    // return the distance in meters in North/East plane from the origin to loc
+    Vector2f ne(const struct Location &loc) const {
+        return Vector2f((loc.lat - _origin.lat) * LOCATION_SCALING_FACTOR,
+                        (loc.lng - _origin.lng) * LOCATION_SCALING_FACTOR * _lng_scale);
+    }
+
+    // return the distance in meters in North/East/Down plane from the origin to loc
+    Vector3f ned(const struct Location &loc) const {
+        return Vector3f((loc.lat - _origin.lat) * LOCATION_SCALING_FACTOR,
+                        (loc.lng - _origin.lng) * LOCATION_SCALING_FACTOR * _lng_scale,
+                        (_origin.alt - loc.alt) * 0.01f);
+    }
+
+    // return distance in meters from the origin to loc. Unlike
+    // get_distance() this scales longitude at the origin, not at loc
+    float distance(const struct Location &loc) const;
+
+    // return bearing in centi-degrees from the origin to loc. Unlike
+    // get_bearing_cd() this scales longitude at the origin, not at loc
+    int32_t bearing_cd(const struct Location &loc) const;
+
+    // set loc to the origin moved by distances north and east in meters
+    void offset(struct Location &loc, float ofs_north, float ofs_east) const;
+
+    // batch versions of ne() and offset() for count locations
+    void ne(const struct Location *locs, Vector2f *ne_out, uint16_t count) const;
+    void offset(const Vector2f *ne_in, struct Location *locs_out, uint16_t count) const;
+
+private:
+    struct Location _origin {};
+    float _lng_scale = 1.0f;
+};
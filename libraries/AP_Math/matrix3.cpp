@@ -97,22 +97,14 @@ void Matrix3<T>::from_euler312(float roll, float pitch, float yaw)
 }
 
 // apply an additional rotation from a body frame gyro vector
-// to a rotation matrix.
+// to a rotation matrix. Each row is only changed by itself, so the
+// rows are updated in place rather than through a temporary matrix
 template <typename T>
 void Matrix3<T>::rotate(const Vector3<T> &g)
 {
-    Matrix3<T> temp_matrix;
-    temp_matrix.a.x = a.y * g.z - a.z * g.y;
-    temp_matrix.a.y = a.z * g.x - a.x * g.z;
-    temp_matrix.a.z = a.x * g.y - a.y * g.x;
-    temp_matrix.b.x = b.y * g.z - b.z * g.y;
-    temp_matrix.b.y = b.z * g.x - b.x * g.z;
-    temp_matrix.b.z = b.x * g.y - b.y * g.x;
-    temp_matrix.c.x = c.y * g.z - c.z * g.y;
-    temp_matrix.c.y = c.z * g.x - c.x * g.z;
-    temp_matrix.c.z = c.x * g.y - c.y * g.x;
-
-    (*this) += temp_matrix;
+    a += a % g;
+    b += b % g;
+    c += c % g;
 }
 
 /*
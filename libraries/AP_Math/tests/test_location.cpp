@@ -0,0 +1,98 @@
+#include <AP_gtest.h>
+
+#include <AP_Math/AP_Math.h>
+
+static Location make_location(int32_t lat, int32_t lng, int32_t alt)
+{
+    Location loc {};
+    loc.lat = lat;
+    loc.lng = lng;
+    loc.alt = alt;
+    return loc;
+}
+
+static const Location origins[] = {
+    make_location(-353632610, 1491652300, 58400),
+    make_location(0, 0, 0),
+    make_location(515000000, -1000000, 1000),
+    make_location(-890000000, 1795000000, 0),
+};
+
+TEST(LocationTest, FrameMatchesLocationDiff)
+{
+    for (const Location &origin : origins) {
+        LocalTangentFrame frame(origin);
+        EXPECT_EQ(longitude_scale(origin), frame.lng_scale());
+        for (int16_t i=0; i<200; i++) {
+            Location loc = origin;
+            location_offset(loc, i * 37.5f - 3000, 2500 - i * 21.0f);
+            loc.alt = i * 10;
+
+            const Vector2f ne = location_diff(origin, loc);
+            const Vector2f frame_ne = frame.ne(loc);
+            EXPECT_EQ(ne.x, frame_ne.x);
+            EXPECT_EQ(ne.y, frame_ne.y);
+
+            const Vector3f ned = location_3d_diff_NED(origin, loc);
+            const Vector3f frame_ned = frame.ned(loc);
+            EXPECT_EQ(ned.x, frame_ned.x);
+            EXPECT_EQ(ned.y, frame_ned.y);
+            EXPECT_EQ(ned.z, frame_ned.z);
+
+            // scaled at the origin rather than at loc, so it agrees with the
+            // frame's own offsets rather than get_distance() and get_bearing_cd()
+            EXPECT_NEAR(ne.length(), frame.distance(loc), 0.001f);
+            if (ne.length() > 1) {
+                const float bearing_cd = wrap_360_cd(degrees(atan2f(ne.y, ne.x)) * 100);
+                EXPECT_NEAR(bearing_cd, frame.bearing_cd(loc), 2);
+            }
+        }
+    }
+}
+
+TEST(LocationTest, FrameMatchesLocationOffset)
+{
+    for (const Location &origin : origins) {
+        LocalTangentFrame frame(origin);
+        for (int16_t i=0; i<200; i++) {
+            const float north = i * 13.1f - 1300;
+            const float east = 900 - i * 7.7f;
+            Location loc1 = origin;
+            location_offset(loc1, north, east);
+            Location loc2;
+            frame.offset(loc2, north, east);
+            EXPECT_EQ(loc1.lat, loc2.lat);
+            EXPECT_EQ(loc1.lng, loc2.lng);
+            EXPECT_EQ(loc1.alt, loc2.alt);
+        }
+    }
+}
+
+TEST(LocationTest, FrameBatch)
+{
+    const Location &origin = origins[0];
+    LocalTangentFrame frame(origin);
+
+    Vector2f ne_in[50];
+    for (uint8_t i=0; i<50; i++) {
+        ne_in[i] = Vector2f(i * 11.0f, -i * 5.0f);
+    }
+    Location locs[50];
+    frame.offset(ne_in, locs, 50);
+    Vector2f ne_out[50];
+    frame.ne(locs, ne_out, 50);
+
+    for (uint8_t i=0; i<50; i++) {
+        Location loc;
+        frame.offset(loc, ne_in[i].x, ne_in[i].y);
+        EXPECT_TRUE(locations_are_same(loc, locs[i]));
+        const Vector2f ne = frame.ne(locs[i]);
+        EXPECT_EQ(ne.x, ne_out[i].x);
+        EXPECT_EQ(ne.y, ne_out[i].y);
+        // round trip is good to the 1cm resolution of a Location
+        EXPECT_NEAR(ne_in[i].x, ne_out[i].x, 0.02f);
+        EXPECT_NEAR(ne_in[i].y, ne_out[i].y, 0.02f);
+    }
+}
+
+AP_GTEST_MAIN()
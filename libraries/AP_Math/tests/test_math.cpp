@@ -63,6 +63,33 @@ TEST(VectorTest, Rotations)
     EXPECT_EQ(ROTATION_MAX, rotation_count) << "All rotations are expect to be tested";
 }
 
+TEST(VectorTest, RotateInverseAndMany)
+{
+    const Vector3f in[] = {
+        Vector3f(1, 2, 3),
+        Vector3f(-0.5f, 7, -2),
+        Vector3f(9.8f, -0.1f, 0.3f),
+    };
+    for (uint8_t r=0; r<ROTATION_MAX; r++) {
+        const enum Rotation rotation = (enum Rotation)r;
+        Vector3f many[ARRAY_SIZE(in)];
+        memcpy(many, in, sizeof(in));
+        Vector3f::rotate_many(many, ARRAY_SIZE(in), rotation);
+        for (uint8_t i=0; i<ARRAY_SIZE(in); i++) {
+            Vector3f v = in[i];
+            v.rotate(rotation);
+            EXPECT_FLOAT_EQ(v.x, many[i].x);
+            EXPECT_FLOAT_EQ(v.y, many[i].y);
+            EXPECT_FLOAT_EQ(v.z, many[i].z);
+
+            v.rotate_inverse(rotation);
+            EXPECT_NEAR(in[i].x, v.x, 1e-5f);
+            EXPECT_NEAR(in[i].y, v.y, 1e-5f);
+            EXPECT_NEAR(in[i].z, v.z, 1e-5f);
+        }
+    }
+}
+
 TEST(MathTest, IsZero)
 {
     EXPECT_FALSE(is_zero(0.1));
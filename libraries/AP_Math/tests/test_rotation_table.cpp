@@ -0,0 +1,313 @@
+#include <AP_gtest.h>
+
+#include <AP_Math/AP_Math.h>
+
+#define HALF_SQRT_2 0.70710678118654757f
+
+/*
+  the rotation table must give exactly what the switch statement it
+  replaced did, for every rotation. rotate_old() is that switch
+ */
+template <typename T>
+static void rotate_old(Vector3<T> &v, enum Rotation rotation)
+{
+    T tmp;
+    switch (rotation) {
+    case ROTATION_NONE:
+    case ROTATION_MAX:
+        return;
+    case ROTATION_YAW_45: {
+        tmp = HALF_SQRT_2*(float)(v.x - v.y);
+        v.y   = HALF_SQRT_2*(float)(v.x + v.y);
+        v.x = tmp;
+        return;
+    }
+    case ROTATION_YAW_90: {
+        tmp = v.x; v.x = -v.y; v.y = tmp;
+        return;
+    }
+    case ROTATION_YAW_135: {
+        tmp = -HALF_SQRT_2*(float)(v.x + v.y);
+        v.y   =  HALF_SQRT_2*(float)(v.x - v.y);
+        v.x = tmp;
+        return;
+    }
+    case ROTATION_YAW_180:
+        v.x = -v.x; v.y = -v.y;
+        return;
+    case ROTATION_YAW_225: {
+        tmp = HALF_SQRT_2*(float)(v.y - v.x);
+        v.y   = -HALF_SQRT_2*(float)(v.x + v.y);
+        v.x = tmp;
+        return;
+    }
+    case ROTATION_YAW_270: {
+        tmp = v.x; v.x = v.y; v.y = -tmp;
+        return;
+    }
+    case ROTATION_YAW_315: {
+        tmp = HALF_SQRT_2*(float)(v.x + v.y);
+        v.y   = HALF_SQRT_2*(float)(v.y - v.x);
+        v.x = tmp;
+        return;
+    }
+    case ROTATION_ROLL_180: {
+        v.y = -v.y; v.z = -v.z;
+        return;
+    }
+    case ROTATION_ROLL_180_YAW_45: {
+        tmp = HALF_SQRT_2*(float)(v.x + v.y);
+        v.y   = HALF_SQRT_2*(float)(v.x - v.y);
+        v.x = tmp; v.z = -v.z;
+        return;
+    }
+    case ROTATION_ROLL_180_YAW_90: {
+        tmp = v.x; v.x = v.y; v.y = tmp; v.z = -v.z;
+        return;
+    }
+    case ROTATION_ROLL_180_YAW_135: {
+        tmp = HALF_SQRT_2*(float)(v.y - v.x);
+        v.y   = HALF_SQRT_2*(float)(v.y + v.x);
+        v.x = tmp; v.z = -v.z;
+        return;
+    }
+    case ROTATION_PITCH_180: {
+        v.x = -v.x; v.z = -v.z;
+        return;
+    }
+    case ROTATION_ROLL_180_YAW_225: {
+        tmp = -HALF_SQRT_2*(float)(v.x + v.y);
+        v.y   =  HALF_SQRT_2*(float)(v.y - v.x);
+        v.x = tmp; v.z = -v.z;
+        return;
+    }
+    case ROTATION_ROLL_180_YAW_270: {
+        tmp = v.x; v.x = -v.y; v.y = -tmp; v.z = -v.z;
+        return;
+    }
+    case ROTATION_ROLL_180_YAW_315: {
+        tmp =  HALF_SQRT_2*(float)(v.x - v.y);
+        v.y   = -HALF_SQRT_2*(float)(v.x + v.y);
+        v.x = tmp; v.z = -v.z;
+        return;
+    }
+    case ROTATION_ROLL_90: {
+        tmp = v.z; v.z = v.y; v.y = -tmp;
+        return;
+    }
+    case ROTATION_ROLL_90_YAW_45: {
+        tmp = v.z; v.z = v.y; v.y = -tmp;
+        tmp = HALF_SQRT_2*(float)(v.x - v.y);
+        v.y   = HALF_SQRT_2*(float)(v.x + v.y);
+        v.x = tmp;
+        return;
+    }
+    case ROTATION_ROLL_90_YAW_90: {
+        tmp = v.z; v.z = v.y; v.y = -tmp;
+        tmp = v.x; v.x = -v.y; v.y = tmp;
+        return;
+    }
+    case ROTATION_ROLL_90_YAW_135: {
+        tmp = v.z; v.z = v.y; v.y = -tmp;
+        tmp = -HALF_SQRT_2*(float)(v.x + v.y);
+        v.y   =  HALF_SQRT_2*(float)(v.x - v.y);
+        v.x = tmp;
+        return;
+    }
+    case ROTATION_ROLL_270: {
+        tmp = v.z; v.z = -v.y; v.y = tmp;
+        return;
+    }
+    case ROTATION_ROLL_270_YAW_45: {
+        tmp = v.z; v.z = -v.y; v.y = tmp;
+        tmp = HALF_SQRT_2*(float)(v.x - v.y);
+        v.y   = HALF_SQRT_2*(float)(v.x + v.y);
+        v.x = tmp;
+        return;
+    }
+    case ROTATION_ROLL_270_YAW_90: {
+        tmp = v.z; v.z = -v.y; v.y = tmp;
+        tmp = v.x; v.x = -v.y; v.y = tmp;
+        return;
+    }
+    case ROTATION_ROLL_270_YAW_135: {
+        tmp = v.z; v.z = -v.y; v.y = tmp;
+        tmp = -HALF_SQRT_2*(float)(v.x + v.y);
+        v.y   =  HALF_SQRT_2*(float)(v.x - v.y);
+        v.x = tmp;
+        return;
+    }
+    case ROTATION_PITCH_90: {
+        tmp = v.z; v.z = -v.x; v.x = tmp;
+        return;
+    }
+    case ROTATION_PITCH_270: {
+        tmp = v.z; v.z = v.x; v.x = -tmp;
+        return;
+    }
+    case ROTATION_PITCH_180_YAW_90: {
+        v.z = -v.z;
+        tmp = -v.x; v.x = -v.y; v.y = tmp;
+        return;
+    }
+    case ROTATION_PITCH_180_YAW_270: {
+        v.x = -v.x; v.z = -v.z;
+        tmp = v.x; v.x = v.y; v.y = -tmp;
+        return;
+    }
+    case ROTATION_ROLL_90_PITCH_90: {
+        tmp = v.z; v.z = v.y; v.y = -tmp;
+        tmp = v.z; v.z = -v.x; v.x = tmp;
+        return;
+    }
+    case ROTATION_ROLL_180_PITCH_90: {
+        v.y = -v.y; v.z = -v.z;
+        tmp = v.z; v.z = -v.x; v.x = tmp;
+        return;
+    }
+    case ROTATION_ROLL_270_PITCH_90: {
+        tmp = v.z; v.z = -v.y; v.y = tmp;
+        tmp = v.z; v.z = -v.x; v.x = tmp;
+        return;
+    }
+    case ROTATION_ROLL_90_PITCH_180: {
+        tmp = v.z; v.z = v.y; v.y = -tmp;
+        v.x = -v.x; v.z = -v.z;
+        return;
+    }
+    case ROTATION_ROLL_270_PITCH_180: {
+        tmp = v.z; v.z = -v.y; v.y = tmp;
+        v.x = -v.x; v.z = -v.z;
+        return;
+    }
+    case ROTATION_ROLL_90_PITCH_270: {
+        tmp = v.z; v.z = v.y; v.y = -tmp;
+        tmp = v.z; v.z = v.x; v.x = -tmp;
+        return;
+    }
+    case ROTATION_ROLL_180_PITCH_270: {
+        v.y = -v.y; v.z = -v.z;
+        tmp = v.z; v.z = v.x; v.x = -tmp;
+        return;
+    }
+    case ROTATION_ROLL_270_PITCH_270: {
+        tmp = v.z; v.z = -v.y; v.y = tmp;
+        tmp = v.z; v.z = v.x; v.x = -tmp;
+        return;
+    }
+    case ROTATION_ROLL_90_PITCH_180_YAW_90: {
+        tmp = v.z; v.z = v.y; v.y = -tmp;
+        v.x = -v.x; v.z = -v.z;
+        tmp = v.x; v.x = -v.y; v.y = tmp;
+        return;
+    }
+    case ROTATION_ROLL_90_YAW_270: {
+        tmp = v.z; v.z = v.y; v.y = -tmp;
+        tmp = v.x; v.x = v.y; v.y = -tmp;
+        return;
+    }
+    case ROTATION_ROLL_90_PITCH_68_YAW_293: {
+        float tmpx = v.x;
+        float tmpy = v.y;
+        float tmpz = v.z;
+        v.x =  0.143039f * tmpx +  0.368776f * tmpy + -0.918446f * tmpz;
+        v.y = -0.332133f * tmpx + -0.856289f * tmpy + -0.395546f * tmpz;
+        v.z = -0.932324f * tmpx +  0.361625f * tmpy +  0.000000f * tmpz;
+        return;
+    }
+    }
+}
+
+// the old rotate_inverse(), a matrix of the rotated unit vectors
+template <typename T>
+static void rotate_inverse_old(Vector3<T> &v, enum Rotation rotation)
+{
+    Vector3<T> x_vec(1.0f,0.0f,0.0f);
+    Vector3<T> y_vec(0.0f,1.0f,0.0f);
+    Vector3<T> z_vec(0.0f,0.0f,1.0f);
+
+    rotate_old(x_vec, rotation);
+    rotate_old(y_vec, rotation);
+    rotate_old(z_vec, rotation);
+
+    Matrix3<T> M(
+        x_vec.x, y_vec.x, z_vec.x,
+        x_vec.y, y_vec.y, z_vec.y,
+        x_vec.z, y_vec.z, z_vec.z
+    );
+
+    v = M.mul_transpose(v);
+}
+
+#define NUM_VECTORS 4096
+
+static uint32_t seed = 1;
+
+static float rand_component(void)
+{
+    seed = seed * 1103515245 + 12345;
+    return ((int32_t)(seed >> 8) - 0x400000) * (1.0f / 0x100000);
+}
+
+// sensor sized vectors, with some equal and opposite components where
+// the sums cancel
+template <typename T>
+static void make_vectors(Vector3<T> *v)
+{
+    for (uint16_t i=0; i<NUM_VECTORS; i++) {
+        const T scale = powf(2.0f, (float)(i % 40) - 20);
+        v[i] = Vector3<T>(rand_component(), rand_component(), rand_component()) * scale;
+        switch (i % 8) {
+        case 0:
+            v[i].y = v[i].x;
+            break;
+        case 1:
+            v[i].z = -v[i].x;
+            break;
+        case 2:
+            v[i].y = -v[i].z;
+            break;
+        }
+    }
+}
+
+template <typename T>
+static void check_rotations()
+{
+    static Vector3<T> in[NUM_VECTORS];
+    static Vector3<T> many[NUM_VECTORS];
+    make_vectors(in);
+    for (uint8_t r=0; r<ROTATION_MAX; r++) {
+        const enum Rotation rotation = (enum Rotation)r;
+        memcpy(many, in, sizeof(in));
+        Vector3<T>::rotate_many(many, NUM_VECTORS, rotation);
+        uint32_t mismatches = 0;
+        for (uint16_t i=0; i<NUM_VECTORS; i++) {
+            Vector3<T> expected = in[i];
+            rotate_old(expected, rotation);
+            Vector3<T> v = in[i];
+            v.rotate(rotation);
+            mismatches += !(v.x == expected.x && v.y == expected.y && v.z == expected.z);
+            mismatches += !(many[i].x == expected.x && many[i].y == expected.y && many[i].z == expected.z);
+
+            expected = in[i];
+            rotate_inverse_old(expected, rotation);
+            v = in[i];
+            v.rotate_inverse(rotation);
+            mismatches += !(v.x == expected.x && v.y == expected.y && v.z == expected.z);
+        }
+        EXPECT_EQ(0U, mismatches) << "rotation " << (unsigned)r;
+    }
+}
+
+TEST(RotationTableTest, MatchesSwitchFloat)
+{
+    check_rotations<float>();
+}
+
+TEST(RotationTableTest, MatchesSwitchDouble)
+{
+    check_rotations<double>();
+}
+
+AP_GTEST_MAIN()
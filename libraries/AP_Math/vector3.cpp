@@ -22,236 +22,237 @@
 
 #define HALF_SQRT_2 0.70710678118654757f
 
-// rotate a vector by a standard rotation, attempting
-// to use the minimum number of floating point operations
+/*
+  board orientations as the matrices rotating vectors from the sensor
+  frame. Most are multiples of 90 degrees, which only move and negate
+  axes. Those are kept as the input axis and sign of each output axis,
+  and of the inverse, and applied exactly without any sums. The 45
+  degree family is kept the same way with a second input axis for the
+  two outputs which are HALF_SQRT_2 times a sum, so they are worked out
+  with the same operations as the old switch statement. The others are
+  applied as a matrix
+ */
+struct RotationEntry {
+    enum Kind : uint8_t {
+        PERMUTATION,
+        HALF_SQRT_2_SUMS,
+        MATRIX,
+    };
+
+    // axis permutation, given as the input axis (1 to 3, negative if
+    // negated) each output axis comes from
+    constexpr RotationEntry(int8_t px, int8_t py, int8_t pz) :
+        kind(PERMUTATION),
+        axis{axis_of(px), axis_of(py), axis_of(pz)},
+        sign{sign_of(px), sign_of(py), sign_of(pz)},
+        axis2{0, 0, 0},
+        sign2{0, 0, 0},
+        inv_axis{axis_of(inverse(px, py, pz, 0)), axis_of(inverse(px, py, pz, 1)), axis_of(inverse(px, py, pz, 2))},
+        inv_sign{sign_of(inverse(px, py, pz, 0)), sign_of(inverse(px, py, pz, 1)), sign_of(inverse(px, py, pz, 2))},
+        m{{element(px, 1), element(px, 2), element(px, 3)},
+          {element(py, 1), element(py, 2), element(py, 3)},
+          {element(pz, 1), element(pz, 2), element(pz, 3)}} {}
+
+    // multiple of 45 degrees, each output axis given as one or two
+    // signed input axes. An output with two is HALF_SQRT_2 times their
+    // sum, a second axis of zero means the output is the first one
+    constexpr RotationEntry(int8_t px, int8_t qx, int8_t py, int8_t qy, int8_t pz, int8_t qz) :
+        kind(HALF_SQRT_2_SUMS),
+        axis{axis_of(px), axis_of(py), axis_of(pz)},
+        sign{sign_of(px), sign_of(py), sign_of(pz)},
+        axis2{axis_of(qx), axis_of(qy), axis_of(qz)},
+        sign2{qx == 0 ? 0 : sign_of(qx), qy == 0 ? 0 : sign_of(qy), qz == 0 ? 0 : sign_of(qz)},
+        inv_axis{0, 0, 0},
+        inv_sign{0, 0, 0},
+        m{{element(px, qx, 1), element(px, qx, 2), element(px, qx, 3)},
+          {element(py, qy, 1), element(py, qy, 2), element(py, qy, 3)},
+          {element(pz, qz, 1), element(pz, qz, 2), element(pz, qz, 3)}} {}
+
+    // general rotation
+    constexpr RotationEntry(float ax, float ay, float az,
+                            float bx, float by, float bz,
+                            float cx, float cy, float cz) :
+        kind(MATRIX),
+        axis{0, 0, 0},
+        sign{0, 0, 0},
+        axis2{0, 0, 0},
+        sign2{0, 0, 0},
+        inv_axis{0, 0, 0},
+        inv_sign{0, 0, 0},
+        m{{ax, ay, az}, {bx, by, bz}, {cx, cy, cz}} {}
+
+    static constexpr uint8_t axis_of(int8_t p) { return p == 0 ? 0 : (p > 0 ? p : -p) - 1; }
+    static constexpr float sign_of(int8_t p) { return p > 0 ? 1 : -1; }
+
+    // the permutation row for output axis i of the inverse, the row of
+    // the transpose
+    static constexpr int8_t inverse(int8_t px, int8_t py, int8_t pz, uint8_t i) {
+        return axis_of(px) == i ? (px > 0 ? 1 : -1) :
+               axis_of(py) == i ? (py > 0 ? 2 : -2) :
+               (pz > 0 ? 3 : -3);
+    }
+
+    // matrix element in the column for axis of a permutation row
+    static constexpr float element(int8_t p, int8_t axis) {
+        return p == axis ? 1 : (p == -axis ? -1 : 0);
+    }
+
+    // matrix element in the column for axis of a 45 degree row
+    static constexpr float element(int8_t p, int8_t q, int8_t axis) {
+        return q == 0 ? element(p, axis) : HALF_SQRT_2 * (element(p, axis) + element(q, axis));
+    }
+
+    // output axis i of a 45 degree rotation of v
+    template <typename T>
+    T half_sqrt_2_sum(const T v[3], uint8_t i) const {
+        if (is_zero(sign2[i])) {
+            return v[axis[i]] * sign[i];
+        }
+        return HALF_SQRT_2 * (float)(v[axis[i]] * sign[i] + v[axis2[i]] * sign2[i]);
+    }
+
+    Kind kind;
+    uint8_t axis[3];
+    float sign[3];
+    uint8_t axis2[3];
+    float sign2[3];
+    uint8_t inv_axis[3];
+    float inv_sign[3];
+    float m[3][3];
+};
+
+static constexpr RotationEntry rotation_table[] = {
+    RotationEntry( 1,  2,  3),                  // ROTATION_NONE
+    RotationEntry( 1, -2,  1,  2,  3,  0),      // ROTATION_YAW_45
+    RotationEntry(-2,  1,  3),                  // ROTATION_YAW_90
+    RotationEntry(-1, -2,  1, -2,  3,  0),      // ROTATION_YAW_135
+    RotationEntry(-1, -2,  3),                  // ROTATION_YAW_180
+    RotationEntry(-1,  2, -1, -2,  3,  0),      // ROTATION_YAW_225
+    RotationEntry( 2, -1,  3),                  // ROTATION_YAW_270
+    RotationEntry( 1,  2, -1,  2,  3,  0),      // ROTATION_YAW_315
+    RotationEntry( 1, -2, -3),                  // ROTATION_ROLL_180
+    RotationEntry( 1,  2,  1, -2, -3,  0),      // ROTATION_ROLL_180_YAW_45
+    RotationEntry( 2,  1, -3),                  // ROTATION_ROLL_180_YAW_90
+    RotationEntry(-1,  2,  1,  2, -3,  0),      // ROTATION_ROLL_180_YAW_135
+    RotationEntry(-1,  2, -3),                  // ROTATION_PITCH_180
+    RotationEntry(-1, -2, -1,  2, -3,  0),      // ROTATION_ROLL_180_YAW_225
+    RotationEntry(-2, -1, -3),                  // ROTATION_ROLL_180_YAW_270
+    RotationEntry( 1, -2, -1, -2, -3,  0),      // ROTATION_ROLL_180_YAW_315
+    RotationEntry( 1, -3,  2),                  // ROTATION_ROLL_90
+    RotationEntry( 1,  3,  1, -3,  2,  0),      // ROTATION_ROLL_90_YAW_45
+    RotationEntry( 3,  1,  2),                  // ROTATION_ROLL_90_YAW_90
+    RotationEntry(-1,  3,  1,  3,  2,  0),      // ROTATION_ROLL_90_YAW_135
+    RotationEntry( 1,  3, -2),                  // ROTATION_ROLL_270
+    RotationEntry( 1, -3,  1,  3, -2,  0),      // ROTATION_ROLL_270_YAW_45
+    RotationEntry(-3,  1, -2),                  // ROTATION_ROLL_270_YAW_90
+    RotationEntry(-1, -3,  1, -3, -2,  0),      // ROTATION_ROLL_270_YAW_135
+    RotationEntry( 3,  2, -1),                  // ROTATION_PITCH_90
+    RotationEntry(-3,  2,  1),                  // ROTATION_PITCH_270
+    RotationEntry(-2, -1, -3),                  // ROTATION_PITCH_180_YAW_90
+    RotationEntry( 2,  1, -3),                  // ROTATION_PITCH_180_YAW_270
+    RotationEntry( 2, -3, -1),                  // ROTATION_ROLL_90_PITCH_90
+    RotationEntry(-3, -2, -1),                  // ROTATION_ROLL_180_PITCH_90
+    RotationEntry(-2,  3, -1),                  // ROTATION_ROLL_270_PITCH_90
+    RotationEntry(-1, -3, -2),                  // ROTATION_ROLL_90_PITCH_180
+    RotationEntry(-1,  3,  2),                  // ROTATION_ROLL_270_PITCH_180
+    RotationEntry(-2, -3,  1),                  // ROTATION_ROLL_90_PITCH_270
+    RotationEntry( 3, -2,  1),                  // ROTATION_ROLL_180_PITCH_270
+    RotationEntry( 2,  3,  1),                  // ROTATION_ROLL_270_PITCH_270
+    RotationEntry( 3, -1, -2),                  // ROTATION_ROLL_90_PITCH_180_YAW_90
+    RotationEntry(-3, -1,  2),                  // ROTATION_ROLL_90_YAW_270
+    // ROTATION_ROLL_90_PITCH_68_YAW_293
+    RotationEntry(   0.143039f,    0.368776f,   -0.918446f,
+                    -0.332133f,   -0.856289f,   -0.395546f,
+                    -0.932324f,    0.361625f,            0),
+};
+
+static_assert(ARRAY_SIZE(rotation_table) == ROTATION_MAX, "rotation_table must have an entry for each rotation");
+
+// rotate a vector by a standard rotation
 template <typename T>
 void Vector3<T>::rotate(enum Rotation rotation)
 {
-    T tmp;
-    switch (rotation) {
-    case ROTATION_NONE:
-    case ROTATION_MAX:
-        return;
-    case ROTATION_YAW_45: {
-        tmp = HALF_SQRT_2*(float)(x - y);
-        y   = HALF_SQRT_2*(float)(x + y);
-        x = tmp;
-        return;
-    }
-    case ROTATION_YAW_90: {
-        tmp = x; x = -y; y = tmp;
-        return;
-    }
-    case ROTATION_YAW_135: {
-        tmp = -HALF_SQRT_2*(float)(x + y);
-        y   =  HALF_SQRT_2*(float)(x - y);
-        x = tmp;
-        return;
-    }
-    case ROTATION_YAW_180:
-        x = -x; y = -y;
-        return;
-    case ROTATION_YAW_225: {
-        tmp = HALF_SQRT_2*(float)(y - x);
-        y   = -HALF_SQRT_2*(float)(x + y);
-        x = tmp;
-        return;
-    }
-    case ROTATION_YAW_270: {
-        tmp = x; x = y; y = -tmp;
-        return;
-    }
-    case ROTATION_YAW_315: {
-        tmp = HALF_SQRT_2*(float)(x + y);
-        y   = HALF_SQRT_2*(float)(y - x);
-        x = tmp;
-        return;
-    }
-    case ROTATION_ROLL_180: {
-        y = -y; z = -z;
-        return;
-    }
-    case ROTATION_ROLL_180_YAW_45: {
-        tmp = HALF_SQRT_2*(float)(x + y);
-        y   = HALF_SQRT_2*(float)(x - y);
-        x = tmp; z = -z;
-        return;
-    }
-    case ROTATION_ROLL_180_YAW_90: {
-        tmp = x; x = y; y = tmp; z = -z;
-        return;
-    }
-    case ROTATION_ROLL_180_YAW_135: {
-        tmp = HALF_SQRT_2*(float)(y - x);
-        y   = HALF_SQRT_2*(float)(y + x);
-        x = tmp; z = -z;
-        return;
-    }
-    case ROTATION_PITCH_180: {
-        x = -x; z = -z;
-        return;
-    }
-    case ROTATION_ROLL_180_YAW_225: {
-        tmp = -HALF_SQRT_2*(float)(x + y);
-        y   =  HALF_SQRT_2*(float)(y - x);
-        x = tmp; z = -z;
-        return;
-    }
-    case ROTATION_ROLL_180_YAW_270: {
-        tmp = x; x = -y; y = -tmp; z = -z;
-        return;
-    }
-    case ROTATION_ROLL_180_YAW_315: {
-        tmp =  HALF_SQRT_2*(float)(x - y);
-        y   = -HALF_SQRT_2*(float)(x + y);
-        x = tmp; z = -z;
-        return;
-    }
-    case ROTATION_ROLL_90: {
-        tmp = z; z = y; y = -tmp;
-        return;
-    }
-    case ROTATION_ROLL_90_YAW_45: {
-        tmp = z; z = y; y = -tmp;
-        tmp = HALF_SQRT_2*(float)(x - y);
-        y   = HALF_SQRT_2*(float)(x + y);
-        x = tmp;
-        return;
-    }
-    case ROTATION_ROLL_90_YAW_90: {
-        tmp = z; z = y; y = -tmp;
-        tmp = x; x = -y; y = tmp;
-        return;
-    }
-    case ROTATION_ROLL_90_YAW_135: {
-        tmp = z; z = y; y = -tmp;
-        tmp = -HALF_SQRT_2*(float)(x + y);
-        y   =  HALF_SQRT_2*(float)(x - y);
-        x = tmp;
-        return;
-    }
-    case ROTATION_ROLL_270: {
-        tmp = z; z = -y; y = tmp;
-        return;
-    }
-    case ROTATION_ROLL_270_YAW_45: {
-        tmp = z; z = -y; y = tmp;
-        tmp = HALF_SQRT_2*(float)(x - y);
-        y   = HALF_SQRT_2*(float)(x + y);
-        x = tmp;
-        return;
-    }
-    case ROTATION_ROLL_270_YAW_90: {
-        tmp = z; z = -y; y = tmp;
-        tmp = x; x = -y; y = tmp;
-        return;
-    }
-    case ROTATION_ROLL_270_YAW_135: {
-        tmp = z; z = -y; y = tmp;
-        tmp = -HALF_SQRT_2*(float)(x + y);
-        y   =  HALF_SQRT_2*(float)(x - y);
-        x = tmp;
-        return;
-    }
-    case ROTATION_PITCH_90: {
-        tmp = z; z = -x; x = tmp;
-        return;
-    }
-    case ROTATION_PITCH_270: {
-        tmp = z; z = x; x = -tmp;
-        return;
-    }
-    case ROTATION_PITCH_180_YAW_90: {
-        z = -z;
-        tmp = -x; x = -y; y = tmp;
-        return;
-    }
-    case ROTATION_PITCH_180_YAW_270: {
-        x = -x; z = -z;
-        tmp = x; x = y; y = -tmp;
+    if (rotation == ROTATION_NONE || rotation >= ROTATION_MAX) {
         return;
     }
-    case ROTATION_ROLL_90_PITCH_90: {
-        tmp = z; z = y; y = -tmp;
-        tmp = z; z = -x; x = tmp;
+    const RotationEntry &r = rotation_table[rotation];
+    const T v[3] = { x, y, z };
+    switch (r.kind) {
+    case RotationEntry::PERMUTATION:
+        x = v[r.axis[0]] * r.sign[0];
+        y = v[r.axis[1]] * r.sign[1];
+        z = v[r.axis[2]] * r.sign[2];
         return;
-    }
-    case ROTATION_ROLL_180_PITCH_90: {
-        y = -y; z = -z;
-        tmp = z; z = -x; x = tmp;
+    case RotationEntry::HALF_SQRT_2_SUMS:
+        x = r.half_sqrt_2_sum(v, 0);
+        y = r.half_sqrt_2_sum(v, 1);
+        z = r.half_sqrt_2_sum(v, 2);
         return;
-    }
-    case ROTATION_ROLL_270_PITCH_90: {
-        tmp = z; z = -y; y = tmp;
-        tmp = z; z = -x; x = tmp;
+    case RotationEntry::MATRIX: {
+        // worked out in float, as the old switch statement did
+        const float f[3] = { (float)v[0], (float)v[1], (float)v[2] };
+        x = r.m[0][0] * f[0] + r.m[0][1] * f[1] + r.m[0][2] * f[2];
+        y = r.m[1][0] * f[0] + r.m[1][1] * f[1] + r.m[1][2] * f[2];
+        z = r.m[2][0] * f[0] + r.m[2][1] * f[1] + r.m[2][2] * f[2];
         return;
     }
-    case ROTATION_ROLL_90_PITCH_180: {
-        tmp = z; z = y; y = -tmp;
-        x = -x; z = -z;
-        return;
-    }
-    case ROTATION_ROLL_270_PITCH_180: {
-        tmp = z; z = -y; y = tmp;
-        x = -x; z = -z;
-        return;
     }
-    case ROTATION_ROLL_90_PITCH_270: {
-        tmp = z; z = y; y = -tmp;
-        tmp = z; z = x; x = -tmp;
+}
+
+template <typename T>
+void Vector3<T>::rotate_inverse(enum Rotation rotation)
+{
+    if (rotation == ROTATION_NONE || rotation >= ROTATION_MAX) {
         return;
     }
-    case ROTATION_ROLL_180_PITCH_270: {
-        y = -y; z = -z;
-        tmp = z; z = x; x = -tmp;
+    const RotationEntry &r = rotation_table[rotation];
+    const T v[3] = { x, y, z };
+    if (r.kind == RotationEntry::PERMUTATION) {
+        x = v[r.inv_axis[0]] * r.inv_sign[0];
+        y = v[r.inv_axis[1]] * r.inv_sign[1];
+        z = v[r.inv_axis[2]] * r.inv_sign[2];
         return;
     }
-    case ROTATION_ROLL_270_PITCH_270: {
-        tmp = z; z = -y; y = tmp;
-        tmp = z; z = x; x = -tmp;
+    // the inverse of a rotation is its transpose
+    x = r.m[0][0] * v[0] + r.m[1][0] * v[1] + r.m[2][0] * v[2];
+    y = r.m[0][1] * v[0] + r.m[1][1] * v[1] + r.m[2][1] * v[2];
+    z = r.m[0][2] * v[0] + r.m[1][2] * v[1] + r.m[2][2] * v[2];
+}
+
+// rotate n vectors by a standard rotation, looking up the rotation once
+template <typename T>
+void Vector3<T>::rotate_many(Vector3<T> *v, uint16_t n, enum Rotation rotation)
+{
+    if (rotation == ROTATION_NONE || rotation >= ROTATION_MAX) {
         return;
     }
-    case ROTATION_ROLL_90_PITCH_180_YAW_90: {
-        tmp = z; z = y; y = -tmp;
-        x = -x; z = -z;
-        tmp = x; x = -y; y = tmp;
+    const RotationEntry &r = rotation_table[rotation];
+    switch (r.kind) {
+    case RotationEntry::PERMUTATION: {
+        const uint8_t ax = r.axis[0], ay = r.axis[1], az = r.axis[2];
+        const T sx = r.sign[0], sy = r.sign[1], sz = r.sign[2];
+        for (uint16_t i=0; i<n; i++) {
+            const T in[3] = { v[i].x, v[i].y, v[i].z };
+            v[i].x = in[ax] * sx;
+            v[i].y = in[ay] * sy;
+            v[i].z = in[az] * sz;
+        }
         return;
     }
-    case ROTATION_ROLL_90_YAW_270: {
-        tmp = z; z = y; y = -tmp;
-        tmp = x; x = y; y = -tmp;
+    case RotationEntry::HALF_SQRT_2_SUMS:
+        for (uint16_t i=0; i<n; i++) {
+            const T in[3] = { v[i].x, v[i].y, v[i].z };
+            v[i].x = r.half_sqrt_2_sum(in, 0);
+            v[i].y = r.half_sqrt_2_sum(in, 1);
+            v[i].z = r.half_sqrt_2_sum(in, 2);
+        }
         return;
-    }
-    case ROTATION_ROLL_90_PITCH_68_YAW_293: {
-        float tmpx = x;
-        float tmpy = y;
-        float tmpz = z;
-        x =  0.143039f * tmpx +  0.368776f * tmpy + -0.918446f * tmpz;
-        y = -0.332133f * tmpx + -0.856289f * tmpy + -0.395546f * tmpz;
-        z = -0.932324f * tmpx +  0.361625f * tmpy +  0.000000f * tmpz;
+    case RotationEntry::MATRIX:
+        for (uint16_t i=0; i<n; i++) {
+            v[i].rotate(rotation);
+        }
         return;
     }
-    }
-}
-
-template <typename T>
-void Vector3<T>::rotate_inverse(enum Rotation rotation)
-{
-    Vector3<T> x_vec(1.0f,0.0f,0.0f);
-    Vector3<T> y_vec(0.0f,1.0f,0.0f);
-    Vector3<T> z_vec(0.0f,0.0f,1.0f);
-
-    x_vec.rotate(rotation);
-    y_vec.rotate(rotation);
-    z_vec.rotate(rotation);
-
-    Matrix3<T> M(
-        x_vec.x, y_vec.x, z_vec.x,
-        x_vec.y, y_vec.y, z_vec.y,
-        x_vec.z, y_vec.z, z_vec.z
-    );
-
-    (*this) = M.mul_transpose(*this);
 }
 
 // vector cross product
@@ -419,6 +420,7 @@ float Vector3<T>::distance_to_segment(const Vector3<T> &seg_start, const Vector3
 // define for float
 template void Vector3<float>::rotate(enum Rotation);
 template void Vector3<float>::rotate_inverse(enum Rotation);
+template void Vector3<float>::rotate_many(Vector3<float> *v, uint16_t n, enum Rotation);
 template float Vector3<float>::length(void) const;
 template Vector3<float> Vector3<float>::operator %(const Vector3<float> &v) const;
 template float Vector3<float>::operator *(const Vector3<float> &v) const;
@@ -445,6 +447,7 @@ template Vector3<int32_t> &Vector3<int32_t>::operator +=(const Vector3<int32_t>
 
 template void Vector3<double>::rotate(enum Rotation);
 template void Vector3<double>::rotate_inverse(enum Rotation);
+template void Vector3<double>::rotate_many(Vector3<double> *v, uint16_t n, enum Rotation);
 template float Vector3<double>::length(void) const;
 template Vector3<double> Vector3<double>::operator %(const Vector3<double> &v) const;
 template double Vector3<double>::operator *(const Vector3<double> &v) const;
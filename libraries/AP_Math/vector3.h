@@ -163,6 +163,10 @@ public:
     void rotate(enum Rotation rotation);
     void rotate_inverse(enum Rotation rotation);
 
+    // rotate n vectors by a standard rotation, cheaper than rotating
+    // each on its own for blocks of samples
+    static void rotate_many(Vector3<T> *v, uint16_t n, enum Rotation rotation);
+
     // gets the length of this vector squared
     T  length_squared() const
     {
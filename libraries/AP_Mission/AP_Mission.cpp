@@ -2,6 +2,7 @@
 /// @brief   Handles the MAVLINK command mission stack.  Reads and writes mission to storage.
 
 #include "AP_Mission.h"
+#include "AP_Mission_Codec.h"
 #include <AP_Terrain/AP_Terrain.h>
 #include <GCS_MAVLink/GCS.h>
 
@@ -25,7 +26,7 @@ const AP_Param::GroupInfo AP_Mission::var_info[] = {
     // @Param: OPTIONS
     // @DisplayName: Mission options bitmask
     // @Description: Bitmask of what options to use in missions.
-    // @Bitmask: 0:Clear Mission on reboot
+    // @Bitmask: 0:Clear Mission on reboot, 1:Request uploaded items one at a time
     // @User: Advanced
     AP_GROUPINFO("OPTIONS",  2, AP_Mission, _options, AP_MISSION_OPTIONS_DEFAULT),
 
@@ -181,6 +182,7 @@ bool AP_Mission::clear()
 
     // remove all commands
     _cmd_total.set_and_save(0);
+    invalidate_cache();
 
     // clear index to commands
     _nav_cmd.index = AP_MISSION_CMD_INDEX_NONE;
@@ -198,6 +200,7 @@ void AP_Mission::truncate(uint16_t index)
 {
     if ((unsigned)_cmd_total > index) {        
         _cmd_total.set_and_save(index);
+        invalidate_cache();
     }
 }
 
@@ -463,29 +466,10 @@ bool AP_Mission::read_cmd_from_storage(uint16_t index, Mission_Command& cmd) con
         cmd.id = MAV_CMD_NAV_WAYPOINT;
         cmd.p1 = 0;
         cmd.content.location = _ahrs.get_home();
-    }else{
-        // Find out proper location in memory by using the start_byte position + the index
-        // we can load a command, we don't process it yet
-        // read WP position
-        uint16_t pos_in_storage = 4 + (index * AP_MISSION_EEPROM_COMMAND_SIZE);
-
-        uint8_t b1 = _storage.read_byte(pos_in_storage);
-        if (b1 == 0) {
-            cmd.id = _storage.read_uint16(pos_in_storage+1);
-            cmd.p1 = _storage.read_uint16(pos_in_storage+3);
-            _storage.read_block(cmd.content.bytes, pos_in_storage+5, 10);
-        } else {
-            cmd.id = b1;
-            cmd.p1 = _storage.read_uint16(pos_in_storage+1);
-            _storage.read_block(cmd.content.bytes, pos_in_storage+3, 12);
-        }
-
-        // set command's index to it's position in eeprom
-        cmd.index = index;
+        return true;
     }
 
-    // return success
-    return true;
+    return read_stored_cmd(index, cmd);
 }
 
 /// write_cmd_to_storage - write a command to storage
@@ -493,26 +477,78 @@ bool AP_Mission::read_cmd_from_storage(uint16_t index, Mission_Command& cmd) con
 ///     true is returned if successful
 bool AP_Mission::write_cmd_to_storage(uint16_t index, Mission_Command& cmd)
 {
-    // range check cmd's index
-    if (index >= num_commands_max()) {
+    // commands can only be replaced or appended.  cmd #0 (home) may be
+    // written to an empty mission
+    const uint16_t total = _cmd_total;
+    if (index > total) {
+        return false;
+    }
+
+    // the previous stored command is needed to delta encode this one
+    Mission_Command prev;
+    if (!is_keyframe(index) && !read_stored_cmd(index-1, prev)) {
         return false;
     }
 
-    // calculate where in storage the command should be placed
-    uint16_t pos_in_storage = 4 + (index * AP_MISSION_EEPROM_COMMAND_SIZE);
+    uint8_t buf[2*AP_Mission_Codec::max_record_size];
+    uint8_t len = AP_Mission_Codec::encode(cmd, is_keyframe(index) ? nullptr : &prev, buf);
 
-    if (cmd.id < 256) {
-        _storage.write_byte(pos_in_storage, cmd.id);
-        _storage.write_uint16(pos_in_storage+1, cmd.p1);
-        _storage.write_block(pos_in_storage+3, cmd.content.bytes, 12);
+    if (index == total || total == 0) {
+        // append, opening a new block if needed.  The free space has
+        // to follow the last block
+        if (total > 0 && !move_gap(num_blocks(total) - 1)) {
+            return false;
+        }
+        uint16_t pos_in_storage;
+        if (!cmd_offset(index, pos_in_storage) ||
+            pos_in_storage + len > storage_limit(num_blocks(index+1))) {
+            return false;
+        }
+        _storage.write_block(pos_in_storage, buf, len);
+        if (index % AP_MISSION_EEPROM_BLOCK_SIZE == 0) {
+            set_block_offset(index / AP_MISSION_EEPROM_BLOCK_SIZE, pos_in_storage);
+        }
+        _gap_block = index / AP_MISSION_EEPROM_BLOCK_SIZE;
+        _gap_total = index + 1;
     } else {
-        // if the command ID is above 256 we store a 0 followed by the 16 bit command ID
-        _storage.write_byte(pos_in_storage, 0);
-        _storage.write_uint16(pos_in_storage+1, cmd.id);
-        _storage.write_uint16(pos_in_storage+3, cmd.p1);
-        _storage.write_block(pos_in_storage+5, cmd.content.bytes, 10);
+        // replacing a command changes its record and the delta of the
+        // command after it, so re-encode both
+        const uint16_t block = index / AP_MISSION_EEPROM_BLOCK_SIZE;
+        const bool reencode_next = index+1 < total && !is_keyframe(index+1);
+        if (reencode_next) {
+            Mission_Command next;
+            if (!read_stored_cmd(index+1, next)) {
+                return false;
+            }
+            len += AP_Mission_Codec::encode(next, &cmd, &buf[len]);
+        }
+
+        uint16_t pos_in_storage;
+        if (!cmd_offset(index, pos_in_storage)) {
+            return false;
+        }
+        uint16_t old_end = pos_in_storage + record_length(pos_in_storage);
+        if (reencode_next) {
+            old_end += record_length(old_end);
+        }
+        const int16_t delta = (pos_in_storage + len) - old_end;
+        if (delta != 0) {
+            // shift the rest of the block into or out of the gap
+            if (!move_gap(block) || !cmd_offset(index, pos_in_storage)) {
+                return false;
+            }
+            old_end = pos_in_storage + len - delta;
+            const uint16_t end = block_end(block);
+            if (end == 0 || end + delta > block_limit(block)) {
+                return false;
+            }
+            move_storage(old_end, old_end + delta, end - old_end);
+        }
+        _storage.write_block(pos_in_storage, buf, len);
     }
 
+    invalidate_cache();
+
     // remember when the mission last changed
     _last_change_time_ms = AP_HAL::millis();
 
@@ -1629,7 +1665,283 @@ void AP_Mission::check_eeprom_version()
 uint16_t AP_Mission::num_commands_max(void) const
 {
     // -4 to remove space for eeprom version number
-    return (_storage.size() - 4) / AP_MISSION_EEPROM_COMMAND_SIZE;
+    return MIN((_storage.size() - 4) / AP_MISSION_EEPROM_COMMAND_SIZE, 32766);
+}
+
+/*
+  return the storage offset of the first command in a block
+ */
+uint16_t AP_Mission::block_offset(uint16_t block) const
+{
+    return _storage.read_uint16(_storage.size() - 2*(block+1));
+}
+
+void AP_Mission::set_block_offset(uint16_t block, uint16_t offset)
+{
+    _storage.write_uint16(_storage.size() - 2*(block+1), offset);
+}
+
+/*
+  return the end of the space available to command records when the
+  directory holds nblocks entries
+ */
+uint16_t AP_Mission::storage_limit(uint16_t nblocks) const
+{
+    const uint16_t dir_size = 2*nblocks;
+    if (dir_size > _storage.size()) {
+        return 0;
+    }
+    return _storage.size() - dir_size;
+}
+
+/*
+  return the offset just past the records of a block by skipping
+  them from its start
+ */
+uint16_t AP_Mission::block_end(uint16_t block) const
+{
+    const uint16_t total = _cmd_total;
+    const uint16_t limit = storage_limit(num_blocks(total));
+    const uint16_t first = block * AP_MISSION_EEPROM_BLOCK_SIZE;
+    const uint16_t last = MIN(first + AP_MISSION_EEPROM_BLOCK_SIZE, total);
+    uint16_t offset = block_offset(block);
+    for (uint16_t i = first; i < last; i++) {
+        if (offset < 4 || offset >= limit) {
+            return 0;
+        }
+        offset += record_length(offset);
+    }
+    return offset <= limit ? offset : 0;
+}
+
+/*
+  return the offset a block may grow up to
+ */
+uint16_t AP_Mission::block_limit(uint16_t block) const
+{
+    const uint16_t nblocks = num_blocks(_cmd_total);
+    if (block + 1 < nblocks) {
+        return block_offset(block + 1);
+    }
+    return storage_limit(nblocks);
+}
+
+/*
+  move blocks so that all the free space in storage follows block.
+  If the gap is not known the blocks are first packed together at the
+  start of storage, leaving the gap after the last block
+ */
+bool AP_Mission::move_gap(uint16_t block)
+{
+    const uint16_t total = _cmd_total;
+    const uint16_t nblocks = num_blocks(total);
+    if (block >= nblocks) {
+        return false;
+    }
+
+    if (_gap_total != total || _gap_block >= nblocks) {
+        uint16_t end = block_end(0);
+        if (end == 0) {
+            return false;
+        }
+        for (uint16_t b = 1; b < nblocks; b++) {
+            const uint16_t start = block_offset(b);
+            const uint16_t next_end = block_end(b);
+            if (next_end == 0) {
+                return false;
+            }
+            if (start != end) {
+                move_storage(start, end, next_end - start);
+                set_block_offset(b, end);
+            }
+            end += next_end - start;
+        }
+        _gap_block = nblocks - 1;
+        _gap_total = total;
+    }
+
+    // close the gap by moving the block after it down
+    while (_gap_block < block) {
+        const uint16_t b = _gap_block + 1;
+        const uint16_t start = block_offset(b);
+        const uint16_t end = block_end(b);
+        const uint16_t dst = block_end(_gap_block);
+        if (end == 0 || dst == 0) {
+            return false;
+        }
+        move_storage(start, dst, end - start);
+        set_block_offset(b, dst);
+        _gap_block = b;
+    }
+
+    // or by moving the block before it up
+    while (_gap_block > block) {
+        const uint16_t b = _gap_block;
+        const uint16_t start = block_offset(b);
+        const uint16_t end = block_end(b);
+        if (end == 0) {
+            return false;
+        }
+        const uint16_t dst = block_limit(b) - (end - start);
+        move_storage(start, dst, end - start);
+        set_block_offset(b, dst);
+        _gap_block = b - 1;
+    }
+    return true;
+}
+
+/*
+  decode the command record at offset. prev must be the command before
+  it unless the record is a keyframe
+ */
+uint8_t AP_Mission::read_record(uint16_t offset, const Mission_Command *prev, Mission_Command &cmd) const
+{
+    const uint16_t limit = storage_limit(num_blocks(_cmd_total));
+    if (offset < 4 || offset >= limit) {
+        return 0;
+    }
+    uint8_t buf[AP_Mission_Codec::max_record_size];
+    const uint8_t len = MIN(limit - offset, (uint16_t)sizeof(buf));
+    _storage.read_block(buf, offset, len);
+    return AP_Mission_Codec::decode(buf, len, prev, cmd);
+}
+
+/*
+  return the length of the record at offset without decoding it
+ */
+uint8_t AP_Mission::record_length(uint16_t offset) const
+{
+    uint8_t hdr[2];
+    _storage.read_block(hdr, offset, sizeof(hdr));
+    return AP_Mission_Codec::record_length(hdr);
+}
+
+/*
+  find the storage offset of the command at index by skipping records
+  from the start of its block. index may be one past the last command
+ */
+bool AP_Mission::cmd_offset(uint16_t index, uint16_t &offset) const
+{
+    const uint16_t total = _cmd_total;
+    if (total == 0) {
+        offset = 4;
+        return index == 0;
+    }
+    const uint16_t limit = storage_limit(num_blocks(total));
+    const uint16_t block = MIN(index, total - 1) / AP_MISSION_EEPROM_BLOCK_SIZE;
+    offset = block_offset(block);
+    for (uint16_t i = block * AP_MISSION_EEPROM_BLOCK_SIZE; i < index; i++) {
+        if (offset < 4 || offset >= limit) {
+            return false;
+        }
+        offset += record_length(offset);
+    }
+    return offset >= 4 && offset <= limit;
+}
+
+/*
+  move a region of storage, copying in the direction which is safe for
+  overlapping regions
+ */
+void AP_Mission::move_storage(uint16_t src, uint16_t dst, uint16_t len)
+{
+    uint8_t buf[32];
+    while (len > 0) {
+        const uint16_t n = MIN(len, sizeof(buf));
+        if (dst > src) {
+            // copy backwards from the end
+            _storage.read_block(buf, src + len - n, n);
+            _storage.write_block(dst + len - n, buf, n);
+        } else {
+            _storage.read_block(buf, src, n);
+            _storage.write_block(dst, buf, n);
+            src += n;
+            dst += n;
+        }
+        len -= n;
+    }
+}
+
+/*
+  read a stored command, decoding it into the cache if needed.
+  Unlike read_cmd_from_storage this returns the stored cmd #0
+ */
+bool AP_Mission::read_stored_cmd(uint16_t index, Mission_Command& cmd) const
+{
+    if (index >= (unsigned)_cmd_total) {
+        return false;
+    }
+    if (_cache_total != (unsigned)_cmd_total) {
+        // MIS_TOTAL has been changed behind our back
+        invalidate_cache();
+    }
+    if (index < _cache_start || index >= _cache_start + _cache_count) {
+        if (!fill_cache(index)) {
+            return false;
+        }
+    }
+    cmd = _cache[index - _cache_start];
+    return true;
+}
+
+/*
+  decode commands into the cache so that it starts just before index.
+  Reading the command after the window continues decoding from where
+  the window ended, so walking forward through a mission decodes each
+  command once.  Blocks may have free space between them, so the first
+  command of a block is always found through the directory
+ */
+bool AP_Mission::fill_cache(uint16_t index) const
+{
+    uint16_t offset;
+    if (_cache_count > 0 && index == _cache_start + _cache_count) {
+        // slide the window, keeping the last command for delta decoding
+        _cache[0] = _cache[_cache_count-1];
+        _cache_start = index - 1;
+        _cache_count = 1;
+        offset = _cache_next_offset;
+    } else {
+        invalidate_cache();
+        const uint16_t block = index / AP_MISSION_EEPROM_BLOCK_SIZE;
+        offset = block_offset(block);
+        // decode from the start of the block up to the command before index
+        uint16_t i = block * AP_MISSION_EEPROM_BLOCK_SIZE;
+        Mission_Command &cmd = _cache[0];
+        for (; i < index; i++) {
+            const uint8_t len = read_record(offset, &cmd, cmd);
+            if (len == 0) {
+                return false;
+            }
+            offset += len;
+        }
+        if (index > block * AP_MISSION_EEPROM_BLOCK_SIZE) {
+            cmd.index = index - 1;
+            _cache_start = index - 1;
+            _cache_count = 1;
+        } else {
+            _cache_start = index;
+        }
+    }
+
+    const uint16_t total = _cmd_total;
+    while (_cache_count < AP_MISSION_CACHE_SIZE && _cache_start + _cache_count < total) {
+        const uint16_t i = _cache_start + _cache_count;
+        if (i % AP_MISSION_EEPROM_BLOCK_SIZE == 0) {
+            offset = block_offset(i / AP_MISSION_EEPROM_BLOCK_SIZE);
+        }
+        Mission_Command &cmd = _cache[_cache_count];
+        const uint8_t len = read_record(offset, _cache_count > 0 ? &_cache[_cache_count-1] : nullptr, cmd);
+        if (len == 0) {
+            break;
+        }
+        cmd.index = i;
+        offset += len;
+        _cache_count++;
+    }
+    _cache_next_offset = offset;
+    _cache_total = total;
+
+    return index >= _cache_start && index < _cache_start + _cache_count;
 }
 
 // find the nearest landing sequence starting point (DO_LAND_START) and
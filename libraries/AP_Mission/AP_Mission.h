@@ -22,8 +22,11 @@
 #include <StorageManager/StorageManager.h>
 
 // definitions
-#define AP_MISSION_EEPROM_VERSION           0x65AE  // version number stored in first four bytes of eeprom.  increment this by one when eeprom format is changed
-#define AP_MISSION_EEPROM_COMMAND_SIZE      15      // size in bytes of all mission commands
+#define AP_MISSION_EEPROM_VERSION           0x65AF  // version number stored in first four bytes of eeprom.  increment this by one when eeprom format is changed
+#define AP_MISSION_EEPROM_COMMAND_SIZE      6       // typical size in bytes of a stored survey waypoint, used to estimate capacity
+#define AP_MISSION_EEPROM_BLOCK_SIZE        16      // commands per storage block.  the first command of each block is stored in full
+
+#define AP_MISSION_CACHE_SIZE               8       // number of decoded commands kept in RAM around the last command read
 
 #define AP_MISSION_MAX_NUM_DO_JUMP_COMMANDS 15      // allow up to 15 do-jump commands
 
@@ -39,10 +42,12 @@
 
 #define AP_MISSION_OPTIONS_DEFAULT          0       // Do not clear the mission when rebooting
 #define AP_MISSION_MASK_MISSION_CLEAR       (1<<0)  // If set then Clear the mission on boot
+#define AP_MISSION_MASK_UPLOAD_SINGLE_ITEM  (1<<1)  // If set then request uploaded items one at a time
 
 /// @class    AP_Mission
 /// @brief    Object managing Mission
 class AP_Mission {
+    friend class AP_Mission_Test;
 
 public:
     // jump command structure
@@ -299,9 +304,13 @@ public:
     ///                 this number includes offset 0, the home location
     uint16_t num_commands() const { return _cmd_total; }
 
-    /// num_commands_max - returns maximum number of commands that can be stored
+    /// num_commands_max - returns estimated maximum number of commands that can be stored
+    ///     commands are delta encoded so the real limit depends on the mission; add_cmd fails when storage is full
     uint16_t num_commands_max() const;
 
+    /// upload_pipelined - true if a mission upload may have several item requests outstanding
+    bool upload_pipelined() const { return !(_options & AP_MISSION_MASK_UPLOAD_SINGLE_ITEM); }
+
     /// start - resets current commands to point to the beginning of the mission
     ///     To-Do: should we validate the mission first and return true/false?
     void start();
@@ -395,8 +404,8 @@ public:
     bool read_cmd_from_storage(uint16_t index, Mission_Command& cmd) const;
 
     /// write_cmd_to_storage - write a command to storage
-    ///     cmd.index is used to calculate the storage location
-    ///     true is returned if successful
+    ///     index may be at most num_commands(), in which case the command is appended
+    ///     true is returned if successful, false if out of range or storage is full
     bool write_cmd_to_storage(uint16_t index, Mission_Command& cmd);
 
     /// write_home_to_storage - writes the special purpose cmd 0 (home) to storage
@@ -451,7 +460,13 @@ private:
         _prev_nav_cmd_id(AP_MISSION_CMD_ID_NONE),
         _prev_nav_cmd_index(AP_MISSION_CMD_INDEX_NONE),
         _prev_nav_cmd_wp_index(AP_MISSION_CMD_INDEX_NONE),
-        _last_change_time_ms(0)
+        _last_change_time_ms(0),
+        _cache_start(0),
+        _cache_next_offset(0),
+        _cache_count(0),
+        _cache_total(0),
+        _gap_block(0),
+        _gap_total(UINT16_MAX)
     {
         // load parameter defaults
         AP_Param::setup_object_defaults(this, var_info);
@@ -514,6 +529,70 @@ private:
     /// command list will be cleared if they do not match
     void check_eeprom_version();
 
+    ///
+    /// storage methods
+    ///
+    /// Commands are stored as variable length records (see AP_Mission_Codec.h) after the
+    /// version number.  Records are grouped into blocks of AP_MISSION_EEPROM_BLOCK_SIZE
+    /// commands and the storage offset of each block is held in a directory growing
+    /// down from the end of storage.  Command #1 and the first command of each block
+    /// are stored in full so they can be decoded on their own.
+    ///
+    /// Blocks need not be contiguous.  All free space is kept in a single gap after
+    /// one block, so a command whose record changes length only shifts the rest of
+    /// its own block once the gap has been moved to it.  Moving the gap one block
+    /// moves one block of records, so replacing the commands of a mission in order
+    /// touches each record a bounded number of times.
+
+    /// num_blocks - returns the number of storage blocks used by num_cmds commands
+    static uint16_t num_blocks(uint16_t num_cmds) {
+        return (num_cmds + AP_MISSION_EEPROM_BLOCK_SIZE - 1) / AP_MISSION_EEPROM_BLOCK_SIZE;
+    }
+
+    /// is_keyframe - returns true if the command at index is stored in full
+    static bool is_keyframe(uint16_t index) {
+        return index <= AP_MISSION_FIRST_REAL_COMMAND || (index % AP_MISSION_EEPROM_BLOCK_SIZE) == 0;
+    }
+
+    /// directory access, block offsets are stored as uint16 at the end of storage
+    uint16_t block_offset(uint16_t block) const;
+    void set_block_offset(uint16_t block, uint16_t offset);
+
+    /// storage_limit - returns the first byte used by the directory for a mission with nblocks blocks
+    uint16_t storage_limit(uint16_t nblocks) const;
+
+    /// block_end - returns the storage offset just past the last record of a block, or 0 if storage is corrupt
+    uint16_t block_end(uint16_t block) const;
+
+    /// block_limit - returns the storage offset at which a block must end, the start of the next block
+    uint16_t block_limit(uint16_t block) const;
+
+    /// move_gap - moves the free space in storage so that it follows block
+    ///     returns false if the storage is corrupt
+    bool move_gap(uint16_t block);
+
+    /// record_length - returns the length of the record at offset
+    uint8_t record_length(uint16_t offset) const;
+
+    /// read_record - decodes the record at offset into cmd.  returns record length or 0 on failure
+    uint8_t read_record(uint16_t offset, const Mission_Command *prev, Mission_Command &cmd) const;
+
+    /// cmd_offset - calculates the storage offset of the command at index, which may be num_commands()
+    ///     returns false if the storage is corrupt
+    bool cmd_offset(uint16_t index, uint16_t &offset) const;
+
+    /// move_storage - moves len bytes within storage, source and destination may overlap
+    void move_storage(uint16_t src, uint16_t dst, uint16_t len);
+
+    /// read_stored_cmd - reads the command at index through the decoded command cache
+    bool read_stored_cmd(uint16_t index, Mission_Command& cmd) const;
+
+    /// fill_cache - decodes commands starting from index into the cache
+    bool fill_cache(uint16_t index) const;
+
+    /// invalidate_cache - discards all decoded commands
+    void invalidate_cache() const { _cache_count = 0; }
+
     // references to external libraries
     const AP_AHRS&   _ahrs;      // used only for home position
 
@@ -542,4 +621,17 @@ private:
 
     // last time that mission changed
     uint32_t _last_change_time_ms;
+
+    // window of decoded commands [_cache_start, _cache_start + _cache_count)
+    mutable struct Mission_Command _cache[AP_MISSION_CACHE_SIZE];
+    mutable uint16_t _cache_start;
+    mutable uint16_t _cache_next_offset;    // storage offset of the command after the window
+    mutable uint8_t _cache_count;
+    mutable uint16_t _cache_total;          // number of commands when the window was filled
+
+    // block followed by the free space in storage, valid while
+    // _cmd_total equals _gap_total.  Otherwise, as after a reboot or
+    // a change of MIS_TOTAL, the blocks are packed before the gap is used
+    uint16_t _gap_block;
+    uint16_t _gap_total;
 };
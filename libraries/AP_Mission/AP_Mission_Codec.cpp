@@ -0,0 +1,265 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "AP_Mission_Codec.h"
+
+#include <string.h>
+
+// layout of Content when viewed as a Location
+#define CONTENT_OPT 0
+#define CONTENT_ALT 1
+#define CONTENT_LAT 4
+#define CONTENT_LNG 8
+
+static uint32_t get_u32(const uint8_t *p)
+{
+    return p[0] | (p[1]<<8) | (p[2]<<16) | ((uint32_t)p[3]<<24);
+}
+
+static void put_u32(uint8_t *p, uint32_t v)
+{
+    p[0] = v;
+    p[1] = v >> 8;
+    p[2] = v >> 16;
+    p[3] = v >> 24;
+}
+
+static uint32_t get_u24(const uint8_t *p)
+{
+    return p[0] | (p[1]<<8) | ((uint32_t)p[2]<<16);
+}
+
+// sign extend the bottom n bytes of v
+static int32_t sign_extend(uint32_t v, uint8_t n)
+{
+    const uint8_t shift = 32 - 8*n;
+    return ((int32_t)(v << shift)) >> shift;
+}
+
+// number of bytes needed to hold v, or 4 if it needs more than 3
+static uint8_t delta_width(int32_t v)
+{
+    if (v == 0) {
+        return 0;
+    }
+    if (v >= INT8_MIN && v <= INT8_MAX) {
+        return 1;
+    }
+    if (v >= INT16_MIN && v <= INT16_MAX) {
+        return 2;
+    }
+    if (v >= -0x800000 && v <= 0x7FFFFF) {
+        return 3;
+    }
+    return 4;
+}
+
+static uint8_t *put_delta(uint8_t *p, int32_t v, uint8_t width)
+{
+    for (uint8_t i=0; i<width; i++) {
+        *p++ = (v >> (8*i)) & 0xFF;
+    }
+    return p;
+}
+
+static uint32_t get_delta(const uint8_t *p, uint8_t width)
+{
+    if (width == 0) {
+        return 0;
+    }
+    uint32_t v = 0;
+    for (uint8_t i=0; i<width; i++) {
+        v |= (uint32_t)p[i] << (8*i);
+    }
+    return sign_extend(v, width);
+}
+
+uint8_t AP_Mission_Codec::record_length(const uint8_t *buf)
+{
+    const uint8_t hdr = buf[0];
+    const uint8_t ext = (hdr & HDR_EXT) ? buf[1] : 0;
+    uint8_t len = (hdr & HDR_EXT) ? 2 : 1;
+    if (ext & EXT_FULL) {
+        return len + ((ext & EXT_ID16) ? 2 : 1) + 2 + 12;
+    }
+    if (hdr & HDR_ID) {
+        len += 1;
+    }
+    if (hdr & HDR_P1) {
+        len += 2;
+    }
+    if (ext & EXT_RAW) {
+        return len + 12;
+    }
+    if (ext & EXT_OPT) {
+        len += 1;
+    }
+    if (hdr & HDR_ALT) {
+        len += 2;
+    }
+    return len + ((hdr >> HDR_LAT_SHIFT) & HDR_WIDTH_MASK) + (hdr & HDR_WIDTH_MASK);
+}
+
+uint8_t AP_Mission_Codec::encode(const AP_Mission::Mission_Command &cmd,
+                                 const AP_Mission::Mission_Command *prev,
+                                 uint8_t *buf)
+{
+    const uint8_t *c = cmd.content.bytes;
+    uint8_t *p = buf;
+
+    if (prev == nullptr || (cmd.id != prev->id && cmd.id > 255)) {
+        *p++ = HDR_EXT;
+        *p++ = EXT_FULL | (cmd.id > 255 ? EXT_ID16 : 0);
+        *p++ = cmd.id & 0xFF;
+        if (cmd.id > 255) {
+            *p++ = cmd.id >> 8;
+        }
+        *p++ = cmd.p1 & 0xFF;
+        *p++ = cmd.p1 >> 8;
+        memcpy(p, c, 12);
+        return (p + 12) - buf;
+    }
+
+    const uint8_t *pc = prev->content.bytes;
+
+    // deltas with wraparound, so they always reproduce the raw bytes
+    const int32_t dalt = sign_extend(get_u24(&c[CONTENT_ALT]) - get_u24(&pc[CONTENT_ALT]), 3);
+    const int32_t dlat = get_u32(&c[CONTENT_LAT]) - get_u32(&pc[CONTENT_LAT]);
+    const int32_t dlng = get_u32(&c[CONTENT_LNG]) - get_u32(&pc[CONTENT_LNG]);
+    const uint8_t wlat = delta_width(dlat);
+    const uint8_t wlng = delta_width(dlng);
+    const bool opt_changed = c[CONTENT_OPT] != pc[CONTENT_OPT];
+
+    uint8_t hdr = 0;
+    uint8_t ext = 0;
+    const uint8_t delta_len = wlat + wlng + (dalt != 0 ? 2 : 0) + (opt_changed ? 2 : 0);
+    if (dalt < INT16_MIN || dalt > INT16_MAX || wlat > 3 || wlng > 3 || delta_len > 12) {
+        ext = EXT_RAW;
+    } else {
+        hdr |= (wlat << HDR_LAT_SHIFT) | wlng;
+        if (dalt != 0) {
+            hdr |= HDR_ALT;
+        }
+        if (opt_changed) {
+            ext |= EXT_OPT;
+        }
+    }
+    if (cmd.id != prev->id) {
+        hdr |= HDR_ID;
+    }
+    if (cmd.p1 != prev->p1) {
+        hdr |= HDR_P1;
+    }
+    if (ext != 0) {
+        hdr |= HDR_EXT;
+    }
+
+    *p++ = hdr;
+    if (ext != 0) {
+        *p++ = ext;
+    }
+    if (hdr & HDR_ID) {
+        *p++ = cmd.id;
+    }
+    if (hdr & HDR_P1) {
+        *p++ = cmd.p1 & 0xFF;
+        *p++ = cmd.p1 >> 8;
+    }
+    if (ext & EXT_RAW) {
+        memcpy(p, c, 12);
+        return (p + 12) - buf;
+    }
+    if (ext & EXT_OPT) {
+        *p++ = c[CONTENT_OPT];
+    }
+    if (hdr & HDR_ALT) {
+        p = put_delta(p, dalt, 2);
+    }
+    p = put_delta(p, dlat, wlat);
+    p = put_delta(p, dlng, wlng);
+
+    return p - buf;
+}
+
+uint8_t AP_Mission_Codec::decode(const uint8_t *buf, uint8_t len,
+                                 const AP_Mission::Mission_Command *prev,
+                                 AP_Mission::Mission_Command &cmd)
+{
+    if (len < 2 && (len == 0 || (buf[0] & HDR_EXT))) {
+        return 0;
+    }
+    const uint8_t rlen = record_length(buf);
+    if (rlen > len) {
+        return 0;
+    }
+    const uint8_t hdr = buf[0];
+    const uint8_t ext = (hdr & HDR_EXT) ? buf[1] : 0;
+    const uint8_t *p = (hdr & HDR_EXT) ? &buf[2] : &buf[1];
+    uint8_t *c = cmd.content.bytes;
+
+    if (ext & EXT_FULL) {
+        cmd.id = *p++;
+        if (ext & EXT_ID16) {
+            cmd.id |= (*p++) << 8;
+        }
+        cmd.p1 = p[0] | (p[1] << 8);
+        memcpy(c, &p[2], 12);
+        return rlen;
+    }
+
+    if (prev == nullptr) {
+        return 0;
+    }
+    const uint8_t *pc = prev->content.bytes;
+
+    if (hdr & HDR_ID) {
+        cmd.id = *p++;
+    } else {
+        cmd.id = prev->id;
+    }
+    if (hdr & HDR_P1) {
+        cmd.p1 = p[0] | (p[1] << 8);
+        p += 2;
+    } else {
+        cmd.p1 = prev->p1;
+    }
+
+    if (ext & EXT_RAW) {
+        memcpy(c, p, 12);
+        return rlen;
+    }
+
+    // cmd may alias prev, so finish reading prev before writing
+    const uint8_t opt = (ext & EXT_OPT) ? *p++ : pc[CONTENT_OPT];
+    uint32_t dalt = 0;
+    if (hdr & HDR_ALT) {
+        dalt = get_delta(p, 2);
+        p += 2;
+    }
+    const uint8_t wlat = (hdr >> HDR_LAT_SHIFT) & HDR_WIDTH_MASK;
+    const uint8_t wlng = hdr & HDR_WIDTH_MASK;
+    const uint32_t alt = get_u24(&pc[CONTENT_ALT]) + dalt;
+    const uint32_t lat = get_u32(&pc[CONTENT_LAT]) + get_delta(p, wlat);
+    const uint32_t lng = get_u32(&pc[CONTENT_LNG]) + get_delta(p + wlat, wlng);
+
+    c[CONTENT_OPT] = opt;
+    c[CONTENT_ALT] = alt & 0xFF;
+    c[CONTENT_ALT+1] = (alt >> 8) & 0xFF;
+    c[CONTENT_ALT+2] = (alt >> 16) & 0xFF;
+    put_u32(&c[CONTENT_LAT], lat);
+    put_u32(&c[CONTENT_LNG], lng);
+
+    return rlen;
+}
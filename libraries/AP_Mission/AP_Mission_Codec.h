@@ -0,0 +1,85 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+/*
+  compact storage encoding for mission commands
+
+  A command is stored either as a full record or as a delta against
+  the command before it. Every record starts with a header byte:
+
+     X I A P LL NN
+     X:  an extension byte follows the header
+     I:  id differs from previous command, 1 byte id follows
+     A:  16 bit altitude delta in cm follows
+     P:  p1 differs from previous command, 2 byte p1 follows
+     LL: width of the latitude delta, 0 to 3 bytes
+     NN: width of the longitude delta, 0 to 3 bytes
+
+  The extension byte holds rarely needed flags:
+
+     0 0 0 0 O R W F
+     F:  full record, id (1 or 2 bytes if W is set), p1 and 12 bytes of content follow
+     R:  content stored raw, 12 bytes follow the id and p1 fields
+     O:  location option byte differs, 1 byte follows
+
+  Field order is header, extension, id, p1, option, altitude,
+  latitude, longitude.  Deltas are taken over the raw content bytes
+  interpreted as a Location, so any command content round trips
+  exactly, but only commands near the previous one (survey grids)
+  become small: a typical survey waypoint takes 4 to 6 bytes instead
+  of 15.
+ */
+
+#include "AP_Mission.h"
+
+class AP_Mission_Codec {
+public:
+    // largest record encode() can produce
+    static const uint8_t max_record_size = 18;
+
+    // total length of the record at buf, which must hold at least two bytes
+    static uint8_t record_length(const uint8_t *buf);
+
+    // encode cmd into buf as a full record if prev is nullptr,
+    // otherwise as the smallest record that reproduces cmd given
+    // prev. Returns the record length
+    static uint8_t encode(const AP_Mission::Mission_Command &cmd,
+                          const AP_Mission::Mission_Command *prev,
+                          uint8_t *buf);
+
+    // decode the record at buf into cmd. prev is needed for delta
+    // records and may be the same object as cmd. Returns the record
+    // length or 0 if the record is truncated or needs a missing
+    // prev. cmd.index is not set
+    static uint8_t decode(const uint8_t *buf, uint8_t len,
+                          const AP_Mission::Mission_Command *prev,
+                          AP_Mission::Mission_Command &cmd);
+
+private:
+    // header byte
+    static const uint8_t HDR_EXT      = 0x80;
+    static const uint8_t HDR_ID       = 0x40;
+    static const uint8_t HDR_ALT      = 0x20;
+    static const uint8_t HDR_P1       = 0x10;
+    static const uint8_t HDR_LAT_SHIFT = 2;
+    static const uint8_t HDR_WIDTH_MASK = 0x03;
+
+    // extension byte
+    static const uint8_t EXT_FULL     = 0x01;
+    static const uint8_t EXT_ID16     = 0x02;
+    static const uint8_t EXT_RAW      = 0x04;
+    static const uint8_t EXT_OPT      = 0x08;
+};
@@ -0,0 +1,255 @@
+#include <AP_gbenchmark.h>
+
+#include <AP_Mission/AP_Mission.h>
+#include <AP_Mission/AP_Mission_Codec.h>
+
+const AP_HAL::HAL &hal = AP_HAL::get_HAL();
+
+/*
+  The mission is read through AP_Mission and the HAL storage, against
+  the fixed 15 byte records used before, read the same way as the old
+  read_cmd_from_storage(). The mission is small enough to fit in
+  the SITL mission storage in both formats.
+ */
+#define NUM_COMMANDS 600
+#define OLD_COMMAND_SIZE 15
+
+typedef AP_Mission::Mission_Command Mission_Command;
+
+static Mission_Command commands[NUM_COMMANDS];
+
+/*
+  a survey grid: long legs with a camera trigger distance change
+  every few lines
+ */
+static void make_survey(void)
+{
+    const int32_t lat0 = -353632610;
+    const int32_t lng0 = 1491652300;
+    for (uint16_t i = 0; i < NUM_COMMANDS; i++) {
+        Mission_Command &cmd = commands[i];
+        memset(&cmd, 0, sizeof(cmd));
+        cmd.index = i;
+        if (i % 50 == 25) {
+            cmd.id = MAV_CMD_DO_SET_CAM_TRIGG_DIST;
+            cmd.content.cam_trigg_dist.meters = 20;
+            continue;
+        }
+        const uint16_t line = i / 2;
+        cmd.id = MAV_CMD_NAV_WAYPOINT;
+        cmd.content.location.flags.relative_alt = 1;
+        cmd.content.location.alt = 5000;
+        cmd.content.location.lat = lat0 + line * 180;
+        cmd.content.location.lng = lng0 + ((line + i) % 2) * 40000;
+    }
+}
+
+class MissionBenchmark {
+public:
+    MissionBenchmark() :
+        ahrs(AP_AHRS_DCM::create(ins, baro, gps)),
+        mission(AP_Mission::create(ahrs,
+                FUNCTOR_BIND_MEMBER(&MissionBenchmark::start_cmd, bool, const Mission_Command &),
+                FUNCTOR_BIND_MEMBER(&MissionBenchmark::verify_cmd, bool, const Mission_Command &),
+                FUNCTOR_BIND_MEMBER(&MissionBenchmark::mission_complete, void))),
+        storage(StorageManager::StorageMission)
+    {}
+
+    // store the survey with AP_Mission
+    void load_mission() {
+        make_survey();
+        mission.clear();
+        for (uint16_t i = 0; i < NUM_COMMANDS; i++) {
+            Mission_Command cmd = commands[i];
+            mission.add_cmd(cmd);
+        }
+    }
+
+    // store the survey in the old format
+    void load_old() {
+        make_survey();
+        for (uint16_t i = 0; i < NUM_COMMANDS; i++) {
+            write_old(i, commands[i]);
+        }
+    }
+
+    void write_old(uint16_t index, const Mission_Command &cmd) {
+        const uint16_t pos_in_storage = 4 + index * OLD_COMMAND_SIZE;
+        if (cmd.id < 256) {
+            storage.write_byte(pos_in_storage, cmd.id);
+            storage.write_uint16(pos_in_storage+1, cmd.p1);
+            storage.write_block(pos_in_storage+3, cmd.content.bytes, 12);
+        } else {
+            storage.write_byte(pos_in_storage, 0);
+            storage.write_uint16(pos_in_storage+1, cmd.id);
+            storage.write_uint16(pos_in_storage+3, cmd.p1);
+            storage.write_block(pos_in_storage+5, cmd.content.bytes, 10);
+        }
+    }
+
+    void read_old(uint16_t index, Mission_Command &cmd) const {
+        const uint16_t pos_in_storage = 4 + index * OLD_COMMAND_SIZE;
+        const uint8_t b1 = storage.read_byte(pos_in_storage);
+        if (b1 == 0) {
+            cmd.id = storage.read_uint16(pos_in_storage+1);
+            cmd.p1 = storage.read_uint16(pos_in_storage+3);
+            storage.read_block(cmd.content.bytes, pos_in_storage+5, 10);
+        } else {
+            cmd.id = b1;
+            cmd.p1 = storage.read_uint16(pos_in_storage+1);
+            storage.read_block(cmd.content.bytes, pos_in_storage+3, 12);
+        }
+        cmd.index = index;
+    }
+
+    AP_InertialSensor ins = AP_InertialSensor::create();
+    AP_Baro baro = AP_Baro::create();
+    AP_GPS gps = AP_GPS::create();
+    AP_AHRS_DCM ahrs;
+    AP_Mission mission;
+    StorageAccess storage;
+
+private:
+    bool start_cmd(const Mission_Command &) { return true; }
+    bool verify_cmd(const Mission_Command &) { return true; }
+    void mission_complete(void) {}
+};
+
+// the sensor libraries only allow one instance
+static MissionBenchmark bench;
+
+static void BM_MissionEncode(benchmark::State& state)
+{
+    make_survey();
+    uint8_t encoded[NUM_COMMANDS * AP_Mission_Codec::max_record_size];
+    uint32_t encoded_len = 0;
+    while (state.KeepRunning()) {
+        encoded_len = 0;
+        for (uint16_t i = 0; i < NUM_COMMANDS; i++) {
+            const bool keyframe = i <= AP_MISSION_FIRST_REAL_COMMAND || i % AP_MISSION_EEPROM_BLOCK_SIZE == 0;
+            encoded_len += AP_Mission_Codec::encode(commands[i], keyframe ? nullptr : &commands[i-1],
+                                                    &encoded[encoded_len]);
+        }
+        gbenchmark_escape(encoded);
+    }
+    state.SetItemsProcessed(state.iterations() * NUM_COMMANDS);
+    char label[48];
+    snprintf(label, sizeof(label), "%.2f bytes/cmd (was %u)",
+             encoded_len / (double)NUM_COMMANDS, (unsigned)OLD_COMMAND_SIZE);
+    state.SetLabel(label);
+}
+
+BENCHMARK(BM_MissionEncode);
+
+// walk through the mission in order, as the mission runs
+static void BM_MissionReadSequential(benchmark::State& state)
+{
+    bench.load_mission();
+    while (state.KeepRunning()) {
+        Mission_Command cmd;
+        for (uint16_t i = 1; i < NUM_COMMANDS; i++) {
+            bench.mission.read_cmd_from_storage(i, cmd);
+        }
+        gbenchmark_escape(&cmd);
+    }
+    state.SetItemsProcessed(state.iterations() * (NUM_COMMANDS - 1));
+}
+
+static void BM_MissionReadSequentialOld(benchmark::State& state)
+{
+    bench.load_old();
+    while (state.KeepRunning()) {
+        Mission_Command cmd;
+        for (uint16_t i = 1; i < NUM_COMMANDS; i++) {
+            bench.read_old(i, cmd);
+        }
+        gbenchmark_escape(&cmd);
+    }
+    state.SetItemsProcessed(state.iterations() * (NUM_COMMANDS - 1));
+}
+
+BENCHMARK(BM_MissionReadSequential);
+BENCHMARK(BM_MissionReadSequentialOld);
+
+// jumping around the mission, as a GCS download or DO_JUMP does
+static void BM_MissionReadRandom(benchmark::State& state)
+{
+    bench.load_mission();
+    uint32_t seed = 1;
+    while (state.KeepRunning()) {
+        seed = seed * 1103515245 + 12345;
+        Mission_Command cmd;
+        bench.mission.read_cmd_from_storage(1 + (seed >> 8) % (NUM_COMMANDS - 1), cmd);
+        gbenchmark_escape(&cmd);
+    }
+}
+
+static void BM_MissionReadRandomOld(benchmark::State& state)
+{
+    bench.load_old();
+    uint32_t seed = 1;
+    while (state.KeepRunning()) {
+        seed = seed * 1103515245 + 12345;
+        Mission_Command cmd;
+        bench.read_old(1 + (seed >> 8) % (NUM_COMMANDS - 1), cmd);
+        gbenchmark_escape(&cmd);
+    }
+}
+
+BENCHMARK(BM_MissionReadRandom);
+BENCHMARK(BM_MissionReadRandomOld);
+
+// find each nav command in turn, as advance_current_nav_cmd() does
+static void BM_MissionNextNavCmd(benchmark::State& state)
+{
+    bench.load_mission();
+    uint64_t items = 0;
+    while (state.KeepRunning()) {
+        Mission_Command cmd;
+        uint16_t index = 1;
+        while (bench.mission.get_next_nav_cmd(index, cmd)) {
+            index = cmd.index + 1;
+            items++;
+        }
+        gbenchmark_escape(&cmd);
+    }
+    state.SetItemsProcessed(items);
+}
+
+BENCHMARK(BM_MissionNextNavCmd);
+
+// a GCS uploading a changed mission over the stored one
+static void BM_MissionReupload(benchmark::State& state)
+{
+    bench.load_mission();
+    int32_t alt = 0;
+    while (state.KeepRunning()) {
+        alt += 100;
+        for (uint16_t i = 1; i < NUM_COMMANDS; i++) {
+            Mission_Command cmd = commands[i];
+            cmd.content.location.alt += alt;
+            bench.mission.replace_cmd(i, cmd);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * (NUM_COMMANDS - 1));
+}
+
+static void BM_MissionReuploadOld(benchmark::State& state)
+{
+    bench.load_old();
+    int32_t alt = 0;
+    while (state.KeepRunning()) {
+        alt += 100;
+        for (uint16_t i = 1; i < NUM_COMMANDS; i++) {
+            Mission_Command cmd = commands[i];
+            cmd.content.location.alt += alt;
+            bench.write_old(i, cmd);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * (NUM_COMMANDS - 1));
+}
+
+BENCHMARK(BM_MissionReupload);
+BENCHMARK(BM_MissionReuploadOld);
+
+BENCHMARK_MAIN()
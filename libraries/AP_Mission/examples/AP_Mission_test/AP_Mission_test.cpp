@@ -1194,7 +1194,7 @@ void MissionTest::setup(void)
 
     // display basic info about command sizes
     hal.console->printf("Max Num Commands: %d\n",(int)mission.num_commands_max());
-    hal.console->printf("Command size: %d bytes\n",(int)AP_MISSION_EEPROM_COMMAND_SIZE);
+    hal.console->printf("Typical command size: %d bytes\n",(int)AP_MISSION_EEPROM_COMMAND_SIZE);
 }
 
 // loop
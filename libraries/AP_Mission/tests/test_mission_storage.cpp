@@ -0,0 +1,344 @@
+#include <AP_gtest.h>
+
+#include <AP_Mission/AP_Mission.h>
+#include <AP_Mission/AP_Mission_Codec.h>
+
+const AP_HAL::HAL &hal = AP_HAL::get_HAL();
+
+typedef AP_Mission::Mission_Command Mission_Command;
+
+static const uint16_t command_ids[] = {
+    MAV_CMD_NAV_WAYPOINT,
+    MAV_CMD_NAV_LOITER_UNLIM,
+    MAV_CMD_NAV_LOITER_TURNS,
+    MAV_CMD_NAV_LOITER_TIME,
+    MAV_CMD_NAV_RETURN_TO_LAUNCH,
+    MAV_CMD_NAV_LAND,
+    MAV_CMD_NAV_TAKEOFF,
+    MAV_CMD_NAV_CONTINUE_AND_CHANGE_ALT,
+    MAV_CMD_NAV_LOITER_TO_ALT,
+    MAV_CMD_NAV_SPLINE_WAYPOINT,
+    MAV_CMD_NAV_GUIDED_ENABLE,
+    MAV_CMD_NAV_DELAY,
+    MAV_CMD_NAV_ALTITUDE_WAIT,
+    MAV_CMD_NAV_VTOL_TAKEOFF,
+    MAV_CMD_NAV_VTOL_LAND,
+    MAV_CMD_NAV_PAYLOAD_PLACE,
+    MAV_CMD_NAV_SET_YAW_SPEED,
+    MAV_CMD_CONDITION_DELAY,
+    MAV_CMD_CONDITION_DISTANCE,
+    MAV_CMD_CONDITION_YAW,
+    MAV_CMD_DO_SET_MODE,
+    MAV_CMD_DO_JUMP,
+    MAV_CMD_DO_CHANGE_SPEED,
+    MAV_CMD_DO_SET_HOME,
+    MAV_CMD_DO_SET_RELAY,
+    MAV_CMD_DO_REPEAT_RELAY,
+    MAV_CMD_DO_SET_SERVO,
+    MAV_CMD_DO_REPEAT_SERVO,
+    MAV_CMD_DO_LAND_START,
+    MAV_CMD_DO_SET_ROI,
+    MAV_CMD_DO_DIGICAM_CONFIGURE,
+    MAV_CMD_DO_DIGICAM_CONTROL,
+    MAV_CMD_DO_MOUNT_CONTROL,
+    MAV_CMD_DO_SET_CAM_TRIGG_DIST,
+    MAV_CMD_DO_FENCE_ENABLE,
+    MAV_CMD_DO_PARACHUTE,
+    MAV_CMD_DO_INVERTED_FLIGHT,
+    MAV_CMD_DO_AUTOTUNE_ENABLE,
+    MAV_CMD_DO_GRIPPER,
+    MAV_CMD_DO_GUIDED_LIMITS,
+    MAV_CMD_DO_ENGINE_CONTROL,
+    MAV_CMD_DO_VTOL_TRANSITION,
+    MAV_CMD_DO_SET_REVERSE,
+};
+
+#define NUM_COMMAND_IDS (sizeof(command_ids) / sizeof(command_ids[0]))
+
+/*
+  convert a mission item the way a GCS upload does, so the content of
+  each command type is laid out as AP_Mission stores it
+ */
+static Mission_Command make_cmd(uint16_t id, uint32_t seed)
+{
+    mavlink_mission_item_int_t packet {};
+    packet.command = id;
+    packet.frame = MAV_FRAME_GLOBAL_RELATIVE_ALT;
+    packet.param1 = 1 + seed % 7;
+    packet.param2 = 2 + seed % 5;
+    packet.param3 = 3 + seed % 3;
+    packet.param4 = 4 + seed % 2;
+    packet.x = -353632610 + (int32_t)(seed * 7919 % 100000);
+    packet.y = 1491652300 - (int32_t)(seed * 104729 % 100000);
+    packet.z = 10 + seed % 90;
+
+    Mission_Command cmd {};
+    EXPECT_EQ(MAV_MISSION_ACCEPTED, AP_Mission::mavlink_int_to_mission_cmd(packet, cmd));
+    return cmd;
+}
+
+static bool same_cmd(const Mission_Command &a, const Mission_Command &b)
+{
+    return a.id == b.id && a.p1 == b.p1 &&
+        memcmp(&a.content, &b.content, sizeof(a.content)) == 0;
+}
+
+// encode cmd against prev and check that it decodes to the same command
+static void check_round_trip(const Mission_Command &cmd, const Mission_Command *prev)
+{
+    uint8_t buf[AP_Mission_Codec::max_record_size];
+    const uint8_t len = AP_Mission_Codec::encode(cmd, prev, buf);
+    const uint8_t max_len = AP_Mission_Codec::max_record_size;
+    ASSERT_GT(len, 0);
+    ASSERT_LE(len, max_len);
+    EXPECT_EQ(len, AP_Mission_Codec::record_length(buf));
+
+    Mission_Command out {};
+    EXPECT_EQ(len, AP_Mission_Codec::decode(buf, len, prev, out));
+    EXPECT_TRUE(same_cmd(cmd, out)) << "id " << cmd.id;
+
+    // a truncated record must not decode
+    EXPECT_EQ(0, AP_Mission_Codec::decode(buf, len-1, prev, out));
+}
+
+TEST(AP_Mission_Codec, RoundTripEveryCommandType)
+{
+    for (uint8_t i = 0; i < NUM_COMMAND_IDS; i++) {
+        const Mission_Command cmd = make_cmd(command_ids[i], i);
+        const Mission_Command same_type = make_cmd(command_ids[i], i + 1);
+        const Mission_Command other_type = make_cmd(command_ids[(i + 1) % NUM_COMMAND_IDS], i);
+        check_round_trip(cmd, nullptr);
+        check_round_trip(cmd, &same_type);
+        check_round_trip(cmd, &other_type);
+        check_round_trip(cmd, &cmd);
+    }
+}
+
+TEST(AP_Mission_Codec, RoundTripRawContent)
+{
+    // ids above 255 and content which is not a location
+    Mission_Command prev {};
+    for (uint32_t seed = 1; seed < 200; seed++) {
+        Mission_Command cmd {};
+        cmd.id = seed % 3 ? 3000 + seed : seed;
+        cmd.p1 = seed * 40503;
+        for (uint8_t j = 0; j < sizeof(cmd.content.bytes); j++) {
+            cmd.content.bytes[j] = seed * 31 + j * j;
+        }
+        check_round_trip(cmd, nullptr);
+        check_round_trip(cmd, &prev);
+        prev = cmd;
+    }
+}
+
+/*
+  an AP_Mission on the HAL storage, with helpers to reach its storage
+  layout
+ */
+class AP_Mission_Test {
+public:
+    AP_Mission_Test() :
+        ahrs(AP_AHRS_DCM::create(ins, baro, gps)),
+        mission(AP_Mission::create(ahrs,
+                FUNCTOR_BIND_MEMBER(&AP_Mission_Test::start_cmd, bool, const Mission_Command &),
+                FUNCTOR_BIND_MEMBER(&AP_Mission_Test::verify_cmd, bool, const Mission_Command &),
+                FUNCTOR_BIND_MEMBER(&AP_Mission_Test::mission_complete, void)))
+    {}
+
+    // as if MIS_TOTAL had been set with PARAM_SET
+    void set_total(uint16_t total) { mission._cmd_total.set(total); }
+
+    uint16_t block_offset(uint16_t block) const { return mission.block_offset(block); }
+
+    // offset of the first byte after the last command
+    uint16_t data_end() const {
+        uint16_t offset = 0;
+        mission.cmd_offset(mission.num_commands(), offset);
+        return offset;
+    }
+
+    // start again with an empty mission holding home
+    void reset() {
+        mission.clear();
+        Mission_Command home {};
+        home.id = MAV_CMD_NAV_WAYPOINT;
+        ASSERT_TRUE(mission.add_cmd(home));
+        ref[0] = home;
+    }
+
+    // append n survey waypoints
+    void add_survey(uint16_t n) {
+        for (uint16_t i = 0; i < n; i++) {
+            const uint16_t index = mission.num_commands();
+            Mission_Command cmd {};
+            cmd.id = MAV_CMD_NAV_WAYPOINT;
+            cmd.content.location.flags.relative_alt = 1;
+            cmd.content.location.alt = 5000;
+            cmd.content.location.lat = -353632610 + (index / 2) * 180;
+            cmd.content.location.lng = 1491652300 + ((index / 2 + index) % 2) * 40000;
+            ASSERT_TRUE(mission.add_cmd(cmd));
+            ASSERT_EQ(index, cmd.index);
+            ref[index] = cmd;
+        }
+    }
+
+    bool replace(uint16_t index, const Mission_Command &cmd) {
+        Mission_Command c = cmd;
+        if (!mission.replace_cmd(index, c)) {
+            return false;
+        }
+        ref[index] = cmd;
+        return true;
+    }
+
+    // check commands in [start, end) read back as expected
+    void check(uint16_t start, uint16_t end) {
+        for (uint16_t i = start; i < end; i++) {
+            Mission_Command cmd;
+            ASSERT_TRUE(mission.read_cmd_from_storage(i, cmd)) << "index " << i;
+            EXPECT_EQ(i, cmd.index);
+            EXPECT_TRUE(same_cmd(ref[i], cmd)) << "index " << i;
+        }
+    }
+
+    void check_all() { check(1, mission.num_commands()); }
+
+    AP_InertialSensor ins = AP_InertialSensor::create();
+    AP_Baro baro = AP_Baro::create();
+    AP_GPS gps = AP_GPS::create();
+    AP_AHRS_DCM ahrs;
+    AP_Mission mission;
+    Mission_Command ref[400];
+
+private:
+    bool start_cmd(const Mission_Command &) { return true; }
+    bool verify_cmd(const Mission_Command &) { return true; }
+    void mission_complete(void) {}
+};
+
+// the sensor libraries only allow one instance
+static AP_Mission_Test test;
+
+TEST(AP_Mission, AppendAndRead)
+{
+    test.reset();
+    test.add_survey(100);
+    EXPECT_EQ(101, test.mission.num_commands());
+    test.check_all();
+
+    // survey waypoints are stored as small deltas
+    EXPECT_LT(test.data_end() - 4, 101 * 8);
+}
+
+TEST(AP_Mission, BlockDirectory)
+{
+    test.reset();
+    test.add_survey(5 * AP_MISSION_EEPROM_BLOCK_SIZE + 3);
+
+    // every block starts after the one before it
+    EXPECT_EQ(4, test.block_offset(0));
+    for (uint16_t b = 1; b < 6; b++) {
+        EXPECT_GT(test.block_offset(b), test.block_offset(b - 1));
+    }
+
+    // reading backwards starts every read from the directory
+    for (uint16_t i = test.mission.num_commands() - 1; i > 0; i--) {
+        test.check(i, i + 1);
+    }
+    // and the first command of each block on its own
+    for (uint16_t b = 1; b < 6; b++) {
+        test.check(b * AP_MISSION_EEPROM_BLOCK_SIZE, b * AP_MISSION_EEPROM_BLOCK_SIZE + 1);
+    }
+}
+
+TEST(AP_Mission, ReplaceDifferentLength)
+{
+    test.reset();
+    test.add_survey(4 * AP_MISSION_EEPROM_BLOCK_SIZE);
+    const uint16_t total = test.mission.num_commands();
+    const uint16_t end = test.data_end();
+
+    // far away commands need longer records; try the middle, the
+    // first and last command of a block and the last command
+    const uint16_t indexes[] = { 20, 16, 31, 32, 1, (uint16_t)(total - 1) };
+    for (uint8_t i = 0; i < sizeof(indexes) / sizeof(indexes[0]); i++) {
+        const uint16_t index = indexes[i];
+        Mission_Command far = make_cmd(MAV_CMD_NAV_LOITER_TIME, 1000 + index);
+        far.content.location.lat += 10000000;
+        ASSERT_TRUE(test.replace(index, far));
+        test.check_all();
+    }
+    EXPECT_GT(test.data_end(), end);
+
+    // and back to short records
+    for (uint8_t i = 0; i < sizeof(indexes) / sizeof(indexes[0]); i++) {
+        const uint16_t index = indexes[i];
+        Mission_Command cmd = test.ref[index - 1];
+        cmd.content.location.lat += 100;
+        ASSERT_TRUE(test.replace(index, cmd));
+        test.check_all();
+    }
+
+    // appending after the replacements packs the mission again
+    test.add_survey(20);
+    test.check_all();
+    EXPECT_EQ(total + 20, test.mission.num_commands());
+}
+
+TEST(AP_Mission, SequentialReupload)
+{
+    test.reset();
+    test.add_survey(300);
+    const uint16_t total = test.mission.num_commands();
+
+    // a GCS uploading a changed mission replaces every command in
+    // order; the first few grow, the rest shrink
+    for (uint16_t i = 1; i < total; i++) {
+        Mission_Command cmd = test.ref[i];
+        if (i < 100) {
+            cmd.content.location.alt += i * 1000;
+            cmd.p1 = i;
+        } else {
+            cmd.content.location = test.ref[i - 1].content.location;
+        }
+        ASSERT_TRUE(test.replace(i, cmd)) << "index " << i;
+    }
+    test.check_all();
+}
+
+TEST(AP_Mission, CacheInvalidation)
+{
+    test.reset();
+    test.add_survey(40);
+    test.check_all();
+
+    // a replaced command is not served from the decoded window
+    Mission_Command cmd = test.ref[5];
+    cmd.content.location.alt = 12345;
+    ASSERT_TRUE(test.replace(5, cmd));
+    test.check(4, 7);
+
+    // MIS_TOTAL set from the GCS shortens the mission without going
+    // through truncate()
+    Mission_Command out;
+    test.check(20, 30);
+    test.set_total(25);
+    EXPECT_FALSE(test.mission.read_cmd_from_storage(26, out));
+    test.check(1, 25);
+    test.set_total(41);
+    test.check_all();
+
+    // commands added after a shortening replace the old ones
+    test.set_total(25);
+    test.add_survey(10);
+    EXPECT_EQ(35, test.mission.num_commands());
+    test.check_all();
+
+    // and the window follows truncate()
+    test.check(30, 35);
+    test.mission.truncate(32);
+    EXPECT_FALSE(test.mission.read_cmd_from_storage(33, out));
+    test.check_all();
+}
+
+AP_GTEST_MAIN()
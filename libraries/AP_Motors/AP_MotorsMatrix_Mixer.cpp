@@ -0,0 +1,144 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "AP_MotorsMatrix_Mixer.h"
+
+// pack - rebuild the rows from per-motor factors
+void AP_MotorsMatrix_Mixer::pack(const bool enabled[AP_MOTORS_MAX_NUM_MOTORS],
+                                 const float roll_factor[AP_MOTORS_MAX_NUM_MOTORS],
+                                 const float pitch_factor[AP_MOTORS_MAX_NUM_MOTORS],
+                                 const float yaw_factor[AP_MOTORS_MAX_NUM_MOTORS])
+{
+    _num_motors = 0;
+    for (uint8_t i=0; i<AP_MOTORS_MAX_NUM_MOTORS; i++) {
+        if (!enabled[i]) {
+            continue;
+        }
+        const uint8_t row = _num_motors++;
+        _motor_num[row] = i;
+        _roll[row] = roll_factor[i];
+        _pitch[row] = pitch_factor[i];
+        _yaw[row] = yaw_factor[i];
+        // a zero yaw factor is divided by one and its headroom ignored so the loop needs no branch
+        _yaw_used[row] = !is_zero(yaw_factor[i]);
+        _yaw_div[row] = _yaw_used[row] ? yaw_factor[i] : 1.0f;
+    }
+}
+
+// mix - combine roll, pitch, yaw and throttle into motor thrusts
+void AP_MotorsMatrix_Mixer::mix(float roll_thrust, float pitch_thrust, float yaw_thrust, float throttle_thrust,
+                                float throttle_avg_max, float yaw_headroom,
+                                float thrust_out[AP_MOTORS_MAX_NUM_MOTORS], Limits &limit) const
+{
+    switch (_num_motors) {
+    case 4:
+        mix_rows<4>(roll_thrust, pitch_thrust, yaw_thrust, throttle_thrust, throttle_avg_max, yaw_headroom, thrust_out, limit);
+        break;
+    case 6:
+        mix_rows<6>(roll_thrust, pitch_thrust, yaw_thrust, throttle_thrust, throttle_avg_max, yaw_headroom, thrust_out, limit);
+        break;
+    case 8:
+        mix_rows<8>(roll_thrust, pitch_thrust, yaw_thrust, throttle_thrust, throttle_avg_max, yaw_headroom, thrust_out, limit);
+        break;
+    case 12:
+        mix_rows<12>(roll_thrust, pitch_thrust, yaw_thrust, throttle_thrust, throttle_avg_max, yaw_headroom, thrust_out, limit);
+        break;
+    default:
+        mix_rows<0>(roll_thrust, pitch_thrust, yaw_thrust, throttle_thrust, throttle_avg_max, yaw_headroom, thrust_out, limit);
+        break;
+    }
+}
+
+// mix the rows, N is the number of motors or 0 to use _num_motors
+template <uint8_t N>
+void AP_MotorsMatrix_Mixer::mix_rows(float roll_thrust, float pitch_thrust, float yaw_thrust, float throttle_thrust,
+                                     float throttle_avg_max, float yaw_headroom,
+                                     float thrust_out[AP_MOTORS_MAX_NUM_MOTORS], Limits &limit) const
+{
+    const uint8_t num = (N != 0) ? N : _num_motors;
+    float rpyt[AP_MOTORS_MAX_NUM_MOTORS];   // combined roll, pitch and yaw of each row
+
+    // throttle giving the most room for roll, pitch and yaw before yaw is added
+    float throttle_thrust_best_rpy = MIN(0.5f, throttle_avg_max);
+
+    // calculate roll and pitch for each motor
+    // calculate the amount of yaw input that each motor can accept
+    float yaw_allowed = 1.0f;
+    for (uint8_t i=0; i<num; i++) {
+        rpyt[i] = roll_thrust * _roll[i] + pitch_thrust * _pitch[i];
+        const float thrust = throttle_thrust_best_rpy + rpyt[i];
+        const float room = (yaw_thrust * _yaw[i] > 0.0f) ? (1.0f - thrust) : thrust;
+        const float unused_range = _yaw_used[i] ? fabsf(room / _yaw_div[i]) : 1.0f;
+        yaw_allowed = MIN(yaw_allowed, unused_range);
+    }
+
+    // todo: make _yaw_headroom 0 to 1
+    yaw_allowed = MAX(yaw_allowed, yaw_headroom);
+
+    if (fabsf(yaw_thrust) > yaw_allowed) {
+        yaw_thrust = constrain_float(yaw_thrust, -yaw_allowed, yaw_allowed);
+        limit.yaw = true;
+    }
+
+    // add yaw to intermediate numbers for each motor
+    float rpy_low = 0.0f;
+    float rpy_high = 0.0f;
+    for (uint8_t i=0; i<num; i++) {
+        rpyt[i] = rpyt[i] + yaw_thrust * _yaw[i];
+        rpy_low = MIN(rpy_low, rpyt[i]);
+        rpy_high = MAX(rpy_high, rpyt[i]);
+    }
+
+    // check everything fits
+    throttle_thrust_best_rpy = MIN(0.5f - (rpy_low+rpy_high)/2.0, throttle_avg_max);
+    float rpy_scale;
+    if (is_zero(rpy_low)) {
+        rpy_scale = 1.0f;
+    } else {
+        rpy_scale = constrain_float(-throttle_thrust_best_rpy/rpy_low, 0.0f, 1.0f);
+    }
+
+    // calculate how close the motors can come to the desired throttle
+    float thr_adj = throttle_thrust - throttle_thrust_best_rpy;
+    if (rpy_scale < 1.0f) {
+        // Full range is being used by roll, pitch, and yaw.
+        limit.roll_pitch = true;
+        limit.yaw = true;
+        if (thr_adj > 0.0f) {
+            limit.throttle_upper = true;
+        }
+        thr_adj = 0.0f;
+    } else {
+        if (thr_adj < -(throttle_thrust_best_rpy+rpy_low)) {
+            // Throttle can't be reduced to desired value
+            thr_adj = -(throttle_thrust_best_rpy+rpy_low);
+        } else if (thr_adj > 1.0f - (throttle_thrust_best_rpy+rpy_high)) {
+            // Throttle can't be increased to desired value
+            thr_adj = 1.0f - (throttle_thrust_best_rpy+rpy_high);
+            limit.throttle_upper = true;
+        }
+    }
+
+    // add scaled roll, pitch, constrained yaw and throttle for each motor, constrained to 0.0f to 1.0f
+    const float thrust_base = throttle_thrust_best_rpy + thr_adj;
+    for (uint8_t i=0; i<num; i++) {
+        rpyt[i] = constrain_float(thrust_base + rpy_scale*rpyt[i], 0.0f, 1.0f);
+    }
+
+    // scatter the rows back to their motors
+    for (uint8_t i=0; i<num; i++) {
+        thrust_out[_motor_num[i]] = rpyt[i];
+    }
+}
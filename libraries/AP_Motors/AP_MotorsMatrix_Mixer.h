@@ -0,0 +1,60 @@
+/// @file	AP_MotorsMatrix_Mixer.h
+/// @brief	Packed roll, pitch and yaw mixer for matrix frames
+#pragma once
+
+#include <AP_Common/AP_Common.h>
+#include <AP_Math/AP_Math.h>
+#include "AP_Motors_Class.h"
+
+/*
+  The mixer holds the factors of the enabled motors packed into
+  contiguous rows so each pass of the mix is a fixed length loop over
+  plain arrays with no per-motor enabled checks or branches. Frames with
+  4, 6, 8 and 12 motors use a copy of the mix with the motor count fixed
+  at compile time so the compiler can unroll and vectorise it, any other
+  count uses the generic copy.
+ */
+class AP_MotorsMatrix_Mixer {
+public:
+
+    // limits reached while mixing
+    struct Limits {
+        bool roll_pitch;
+        bool yaw;
+        bool throttle_upper;
+    };
+
+    // pack - rebuild the rows from per-motor factors, indexed by motor number
+    void                pack(const bool enabled[AP_MOTORS_MAX_NUM_MOTORS],
+                             const float roll_factor[AP_MOTORS_MAX_NUM_MOTORS],
+                             const float pitch_factor[AP_MOTORS_MAX_NUM_MOTORS],
+                             const float yaw_factor[AP_MOTORS_MAX_NUM_MOTORS]);
+
+    // num_motors - number of motors being mixed
+    uint8_t             num_motors() const { return _num_motors; }
+
+    // mix - combine roll, pitch and yaw thrusts (+/- 1.0) and throttle thrust (0.0 - 1.0) into motor thrusts
+    //  throttle_avg_max is the highest throttle allowed to improve attitude control
+    //  yaw_headroom is the yaw always allowed (0.0 - 1.0)
+    //  thrust_out is indexed by motor number, only the entries of enabled motors are written
+    //  limits reached are set in limit, it is never cleared
+    void                mix(float roll_thrust, float pitch_thrust, float yaw_thrust, float throttle_thrust,
+                            float throttle_avg_max, float yaw_headroom,
+                            float thrust_out[AP_MOTORS_MAX_NUM_MOTORS], Limits &limit) const;
+
+private:
+
+    // mix the rows, N is the number of motors or 0 to use _num_motors
+    template <uint8_t N>
+    void                mix_rows(float roll_thrust, float pitch_thrust, float yaw_thrust, float throttle_thrust,
+                                 float throttle_avg_max, float yaw_headroom,
+                                 float thrust_out[AP_MOTORS_MAX_NUM_MOTORS], Limits &limit) const;
+
+    uint8_t             _num_motors = 0;                            // number of packed rows
+    uint8_t             _motor_num[AP_MOTORS_MAX_NUM_MOTORS];       // motor number of each row
+    float               _roll[AP_MOTORS_MAX_NUM_MOTORS];            // roll factor of each row
+    float               _pitch[AP_MOTORS_MAX_NUM_MOTORS];           // pitch factor of each row
+    float               _yaw[AP_MOTORS_MAX_NUM_MOTORS];             // yaw factor of each row
+    float               _yaw_div[AP_MOTORS_MAX_NUM_MOTORS];         // yaw factor used to find yaw headroom, 1 where the factor is zero
+    bool                _yaw_used[AP_MOTORS_MAX_NUM_MOTORS];        // true if the row's yaw factor is non-zero
+};
@@ -0,0 +1,161 @@
+#include <AP_gbenchmark.h>
+
+#include <AP_Motors/AP_MotorsMatrix_Mixer.h>
+
+/*
+  compare the packed mixer with the per-motor loop AP_MotorsMatrix used
+  before it, for frames of 4, 6, 8 and 12 motors and an odd count using
+  the generic copy
+ */
+
+struct frame_factors {
+    bool enabled[AP_MOTORS_MAX_NUM_MOTORS];
+    float roll[AP_MOTORS_MAX_NUM_MOTORS];
+    float pitch[AP_MOTORS_MAX_NUM_MOTORS];
+    float yaw[AP_MOTORS_MAX_NUM_MOTORS];
+};
+
+// motors evenly spaced around the frame with alternating prop direction, normalised to 0.5
+static void make_frame(uint8_t num_motors, frame_factors &f)
+{
+    for (uint8_t i=0; i<AP_MOTORS_MAX_NUM_MOTORS; i++) {
+        f.enabled[i] = i < num_motors;
+        const float angle = radians(180.0f + 360.0f * i / num_motors);
+        f.roll[i] = f.enabled[i] ? 0.5f * cosf(angle + radians(90)) : 0.0f;
+        f.pitch[i] = f.enabled[i] ? 0.5f * cosf(angle) : 0.0f;
+        f.yaw[i] = f.enabled[i] ? ((i % 2) ? -0.5f : 0.5f) : 0.0f;
+    }
+}
+
+// the per-motor mixing loop from AP_MotorsMatrix::output_armed_stabilizing before the packed mixer
+static void mix_scalar(const frame_factors &f, float roll_thrust, float pitch_thrust, float yaw_thrust,
+                       float throttle_thrust, float throttle_avg_max, float yaw_headroom,
+                       float out[AP_MOTORS_MAX_NUM_MOTORS], AP_MotorsMatrix_Mixer::Limits &limit)
+{
+    float throttle_thrust_best_rpy = MIN(0.5f, throttle_avg_max);
+    float yaw_allowed = 1.0f;
+    for (uint8_t i=0; i<AP_MOTORS_MAX_NUM_MOTORS; i++) {
+        if (f.enabled[i]) {
+            out[i] = roll_thrust * f.roll[i] + pitch_thrust * f.pitch[i];
+            if (!is_zero(f.yaw[i])) {
+                float unused_range;
+                if (yaw_thrust * f.yaw[i] > 0.0f) {
+                    unused_range = fabsf((1.0f - (throttle_thrust_best_rpy + out[i]))/f.yaw[i]);
+                } else {
+                    unused_range = fabsf((throttle_thrust_best_rpy + out[i])/f.yaw[i]);
+                }
+                if (yaw_allowed > unused_range) {
+                    yaw_allowed = unused_range;
+                }
+            }
+        }
+    }
+    yaw_allowed = MAX(yaw_allowed, yaw_headroom);
+    if (fabsf(yaw_thrust) > yaw_allowed) {
+        yaw_thrust = constrain_float(yaw_thrust, -yaw_allowed, yaw_allowed);
+        limit.yaw = true;
+    }
+    float rpy_low = 0.0f;
+    float rpy_high = 0.0f;
+    for (uint8_t i=0; i<AP_MOTORS_MAX_NUM_MOTORS; i++) {
+        if (f.enabled[i]) {
+            out[i] = out[i] + yaw_thrust * f.yaw[i];
+            if (out[i] < rpy_low) {
+                rpy_low = out[i];
+            }
+            if (out[i] > rpy_high) {
+                rpy_high = out[i];
+            }
+        }
+    }
+    throttle_thrust_best_rpy = MIN(0.5f - (rpy_low+rpy_high)/2.0, throttle_avg_max);
+    float rpy_scale = 1.0f;
+    if (!is_zero(rpy_low)) {
+        rpy_scale = constrain_float(-throttle_thrust_best_rpy/rpy_low, 0.0f, 1.0f);
+    }
+    float thr_adj = throttle_thrust - throttle_thrust_best_rpy;
+    if (rpy_scale < 1.0f) {
+        limit.roll_pitch = true;
+        limit.yaw = true;
+        if (thr_adj > 0.0f) {
+            limit.throttle_upper = true;
+        }
+        thr_adj = 0.0f;
+    } else if (thr_adj < -(throttle_thrust_best_rpy+rpy_low)) {
+        thr_adj = -(throttle_thrust_best_rpy+rpy_low);
+    } else if (thr_adj > 1.0f - (throttle_thrust_best_rpy+rpy_high)) {
+        thr_adj = 1.0f - (throttle_thrust_best_rpy+rpy_high);
+        limit.throttle_upper = true;
+    }
+    for (uint8_t i=0; i<AP_MOTORS_MAX_NUM_MOTORS; i++) {
+        if (f.enabled[i]) {
+            out[i] = throttle_thrust_best_rpy + thr_adj + rpy_scale*out[i];
+        }
+    }
+    for (uint8_t i=0; i<AP_MOTORS_MAX_NUM_MOTORS; i++) {
+        if (f.enabled[i]) {
+            out[i] = constrain_float(out[i], 0.0f, 1.0f);
+        }
+    }
+}
+
+// demands swept through a range of attitude corrections, some saturating the motors
+static const uint8_t NUM_DEMANDS = 64;
+
+struct demands {
+    float roll[NUM_DEMANDS];
+    float pitch[NUM_DEMANDS];
+    float yaw[NUM_DEMANDS];
+};
+
+static void make_demands(demands &d)
+{
+    for (uint8_t i=0; i<NUM_DEMANDS; i++) {
+        d.roll[i] = 0.3f * sinf(i * 0.37f);
+        d.pitch[i] = 0.3f * sinf((i+7) * 0.37f);
+        d.yaw[i] = 0.4f * sinf((i+19) * 0.37f);
+    }
+}
+
+static void BM_MixScalar(benchmark::State& state)
+{
+    frame_factors f;
+    make_frame(state.range_x(), f);
+    demands d;
+    make_demands(d);
+    float out[AP_MOTORS_MAX_NUM_MOTORS] {};
+
+    while (state.KeepRunning()) {
+        for (uint8_t i=0; i<NUM_DEMANDS; i++) {
+            AP_MotorsMatrix_Mixer::Limits limit {};
+            mix_scalar(f, d.roll[i], d.pitch[i], d.yaw[i], 0.4f, 0.6f, 0.2f, out, limit);
+            gbenchmark_escape(out);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * NUM_DEMANDS);
+}
+
+static void BM_MixPacked(benchmark::State& state)
+{
+    frame_factors f;
+    make_frame(state.range_x(), f);
+    AP_MotorsMatrix_Mixer mixer;
+    mixer.pack(f.enabled, f.roll, f.pitch, f.yaw);
+    demands d;
+    make_demands(d);
+    float out[AP_MOTORS_MAX_NUM_MOTORS] {};
+
+    while (state.KeepRunning()) {
+        for (uint8_t i=0; i<NUM_DEMANDS; i++) {
+            AP_MotorsMatrix_Mixer::Limits limit {};
+            mixer.mix(d.roll[i], d.pitch[i], d.yaw[i], 0.4f, 0.6f, 0.2f, out, limit);
+            gbenchmark_escape(out);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * NUM_DEMANDS);
+}
+
+BENCHMARK(BM_MixScalar)->Arg(4)->Arg(6)->Arg(8)->Arg(10)->Arg(12);
+BENCHMARK(BM_MixPacked)->Arg(4)->Arg(6)->Arg(8)->Arg(10)->Arg(12);
+
+BENCHMARK_MAIN()
@@ -0,0 +1,183 @@
+#include <AP_gtest.h>
+
+#include <AP_Motors/AP_Motors.h>
+
+const AP_HAL::HAL &hal = AP_HAL::get_HAL();
+
+/*
+  the packed mixer must give bit identical motor outputs and limits to
+  the per-motor loop AP_MotorsMatrix used before it, for every frame
+  AP_MotorsMatrix sets up
+ */
+class AP_MotorsMatrix_Test : public AP_MotorsMatrix
+{
+public:
+    AP_MotorsMatrix_Test() : AP_MotorsMatrix(400) {}
+
+    void setup(motor_frame_class frame_class, motor_frame_type frame_type) {
+        setup_motors(frame_class, frame_type);
+    }
+
+    bool initialised() const { return _flags.initialised_ok; }
+
+    uint8_t num_enabled() const {
+        uint8_t n = 0;
+        for (uint8_t i=0; i<AP_MOTORS_MAX_NUM_MOTORS; i++) {
+            n += motor_enabled[i];
+        }
+        return n;
+    }
+
+    const AP_MotorsMatrix_Mixer &mixer() const { return _mixer; }
+
+    // the per-motor mixing loop from output_armed_stabilizing before the packed mixer
+    void mix_scalar(float roll_thrust, float pitch_thrust, float yaw_thrust,
+                    float throttle_thrust, float throttle_avg_max, float yaw_headroom,
+                    float out[AP_MOTORS_MAX_NUM_MOTORS], AP_MotorsMatrix_Mixer::Limits &lim) const
+    {
+        float throttle_thrust_best_rpy = MIN(0.5f, throttle_avg_max);
+        float yaw_allowed = 1.0f;
+        for (uint8_t i=0; i<AP_MOTORS_MAX_NUM_MOTORS; i++) {
+            if (motor_enabled[i]) {
+                out[i] = roll_thrust * _roll_factor[i] + pitch_thrust * _pitch_factor[i];
+                if (!is_zero(_yaw_factor[i])) {
+                    float unused_range;
+                    if (yaw_thrust * _yaw_factor[i] > 0.0f) {
+                        unused_range = fabsf((1.0f - (throttle_thrust_best_rpy + out[i]))/_yaw_factor[i]);
+                    } else {
+                        unused_range = fabsf((throttle_thrust_best_rpy + out[i])/_yaw_factor[i]);
+                    }
+                    if (yaw_allowed > unused_range) {
+                        yaw_allowed = unused_range;
+                    }
+                }
+            }
+        }
+        yaw_allowed = MAX(yaw_allowed, yaw_headroom);
+        if (fabsf(yaw_thrust) > yaw_allowed) {
+            yaw_thrust = constrain_float(yaw_thrust, -yaw_allowed, yaw_allowed);
+            lim.yaw = true;
+        }
+        float rpy_low = 0.0f;
+        float rpy_high = 0.0f;
+        for (uint8_t i=0; i<AP_MOTORS_MAX_NUM_MOTORS; i++) {
+            if (motor_enabled[i]) {
+                out[i] = out[i] + yaw_thrust * _yaw_factor[i];
+                if (out[i] < rpy_low) {
+                    rpy_low = out[i];
+                }
+                if (out[i] > rpy_high) {
+                    rpy_high = out[i];
+                }
+            }
+        }
+        throttle_thrust_best_rpy = MIN(0.5f - (rpy_low+rpy_high)/2.0, throttle_avg_max);
+        float rpy_scale = 1.0f;
+        if (!is_zero(rpy_low)) {
+            rpy_scale = constrain_float(-throttle_thrust_best_rpy/rpy_low, 0.0f, 1.0f);
+        }
+        float thr_adj = throttle_thrust - throttle_thrust_best_rpy;
+        if (rpy_scale < 1.0f) {
+            lim.roll_pitch = true;
+            lim.yaw = true;
+            if (thr_adj > 0.0f) {
+                lim.throttle_upper = true;
+            }
+            thr_adj = 0.0f;
+        } else if (thr_adj < -(throttle_thrust_best_rpy+rpy_low)) {
+            thr_adj = -(throttle_thrust_best_rpy+rpy_low);
+        } else if (thr_adj > 1.0f - (throttle_thrust_best_rpy+rpy_high)) {
+            thr_adj = 1.0f - (throttle_thrust_best_rpy+rpy_high);
+            lim.throttle_upper = true;
+        }
+        for (uint8_t i=0; i<AP_MOTORS_MAX_NUM_MOTORS; i++) {
+            if (motor_enabled[i]) {
+                out[i] = constrain_float(throttle_thrust_best_rpy + thr_adj + rpy_scale*out[i], 0.0f, 1.0f);
+            }
+        }
+    }
+};
+
+// the motors library only allows one instance
+static AP_MotorsMatrix_Test motors;
+
+struct frame {
+    AP_Motors::motor_frame_class frame_class;
+    AP_Motors::motor_frame_type frame_type;
+    uint8_t num_motors;
+};
+
+static const struct frame frames[] = {
+    { AP_Motors::MOTOR_FRAME_QUAD, AP_Motors::MOTOR_FRAME_TYPE_PLUS, 4 },
+    { AP_Motors::MOTOR_FRAME_QUAD, AP_Motors::MOTOR_FRAME_TYPE_X, 4 },
+    { AP_Motors::MOTOR_FRAME_QUAD, AP_Motors::MOTOR_FRAME_TYPE_V, 4 },
+    { AP_Motors::MOTOR_FRAME_QUAD, AP_Motors::MOTOR_FRAME_TYPE_H, 4 },
+    { AP_Motors::MOTOR_FRAME_QUAD, AP_Motors::MOTOR_FRAME_TYPE_VTAIL, 4 },
+    { AP_Motors::MOTOR_FRAME_QUAD, AP_Motors::MOTOR_FRAME_TYPE_ATAIL, 4 },
+    { AP_Motors::MOTOR_FRAME_HEXA, AP_Motors::MOTOR_FRAME_TYPE_PLUS, 6 },
+    { AP_Motors::MOTOR_FRAME_HEXA, AP_Motors::MOTOR_FRAME_TYPE_X, 6 },
+    { AP_Motors::MOTOR_FRAME_OCTA, AP_Motors::MOTOR_FRAME_TYPE_PLUS, 8 },
+    { AP_Motors::MOTOR_FRAME_OCTA, AP_Motors::MOTOR_FRAME_TYPE_X, 8 },
+    { AP_Motors::MOTOR_FRAME_OCTA, AP_Motors::MOTOR_FRAME_TYPE_V, 8 },
+    { AP_Motors::MOTOR_FRAME_OCTA, AP_Motors::MOTOR_FRAME_TYPE_H, 8 },
+    { AP_Motors::MOTOR_FRAME_OCTAQUAD, AP_Motors::MOTOR_FRAME_TYPE_PLUS, 8 },
+    { AP_Motors::MOTOR_FRAME_OCTAQUAD, AP_Motors::MOTOR_FRAME_TYPE_X, 8 },
+    { AP_Motors::MOTOR_FRAME_OCTAQUAD, AP_Motors::MOTOR_FRAME_TYPE_V, 8 },
+    { AP_Motors::MOTOR_FRAME_OCTAQUAD, AP_Motors::MOTOR_FRAME_TYPE_H, 8 },
+    { AP_Motors::MOTOR_FRAME_DODECAHEXA, AP_Motors::MOTOR_FRAME_TYPE_PLUS, 12 },
+    { AP_Motors::MOTOR_FRAME_DODECAHEXA, AP_Motors::MOTOR_FRAME_TYPE_X, 12 },
+    { AP_Motors::MOTOR_FRAME_Y6, AP_Motors::MOTOR_FRAME_TYPE_Y6B, 6 },
+    { AP_Motors::MOTOR_FRAME_Y6, AP_Motors::MOTOR_FRAME_TYPE_Y6F, 6 },
+    { AP_Motors::MOTOR_FRAME_Y6, AP_Motors::MOTOR_FRAME_TYPE_PLUS, 6 },
+};
+
+// uniform random value between low and high
+static float rand_range(uint32_t &seed, float low, float high)
+{
+    seed = seed * 1103515245 + 12345;
+    return low + (high - low) * ((seed >> 8) & 0xFFFF) / 65535.0f;
+}
+
+TEST(AP_MotorsMatrix_Mixer, MatchesPerMotorLoop)
+{
+    for (const struct frame &f : frames) {
+        motors.setup(f.frame_class, f.frame_type);
+        SCOPED_TRACE(testing::Message() << "frame class " << (int)f.frame_class << " type " << (int)f.frame_type);
+        ASSERT_TRUE(motors.initialised());
+        ASSERT_EQ(f.num_motors, motors.num_enabled());
+        ASSERT_EQ(f.num_motors, motors.mixer().num_motors());
+
+        uint32_t seed = f.frame_class * 100 + f.frame_type;
+        uint32_t mismatches = 0;
+        uint32_t saturated = 0;
+        for (uint32_t i = 0; i < 20000; i++) {
+            // mostly normal flight, with demands large enough to saturate the motors some of the time
+            const float scale = (i % 4 == 0) ? 1.0f : 0.3f;
+            const float roll = rand_range(seed, -scale, scale);
+            const float pitch = rand_range(seed, -scale, scale);
+            const float yaw = rand_range(seed, -scale, scale);
+            const float throttle = rand_range(seed, 0.0f, 1.0f);
+            const float throttle_avg_max = rand_range(seed, throttle, 1.0f);
+            const float yaw_headroom = rand_range(seed, 0.0f, 0.5f);
+
+            float out_scalar[AP_MOTORS_MAX_NUM_MOTORS] {};
+            float out_packed[AP_MOTORS_MAX_NUM_MOTORS] {};
+            AP_MotorsMatrix_Mixer::Limits lim_scalar {};
+            AP_MotorsMatrix_Mixer::Limits lim_packed {};
+            motors.mix_scalar(roll, pitch, yaw, throttle, throttle_avg_max, yaw_headroom, out_scalar, lim_scalar);
+            motors.mixer().mix(roll, pitch, yaw, throttle, throttle_avg_max, yaw_headroom, out_packed, lim_packed);
+
+            // compare the bits, not within a tolerance
+            mismatches += memcmp(out_scalar, out_packed, sizeof(out_scalar)) != 0;
+            mismatches += lim_scalar.roll_pitch != lim_packed.roll_pitch;
+            mismatches += lim_scalar.yaw != lim_packed.yaw;
+            mismatches += lim_scalar.throttle_upper != lim_packed.throttle_upper;
+            saturated += lim_scalar.roll_pitch;
+        }
+        EXPECT_EQ(0U, mismatches);
+        // the demands exercised the limiting as well
+        EXPECT_GT(saturated, 0U);
+    }
+}
+
+AP_GTEST_MAIN()
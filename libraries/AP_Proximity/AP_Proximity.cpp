@@ -171,6 +171,16 @@ const AP_Param::GroupInfo AP_Proximity::var_info[] = {
     AP_GROUPINFO("2_YAW_CORR", 18, AP_Proximity, _yaw_correction[1], PROXIMITY_YAW_CORRECTION_DEFAULT),
 #endif
 
+    // @Param: _BIN_RES
+    // @DisplayName: Proximity scan bin resolution
+    // @Description: Resolution that points from scanning sensors such as the RPLidarA2 are kept at after compensating for the vehicle's movement while they were captured. Each sector then uses the closest of its bins. Zero disables binning and points are used as they arrive
+    // @Units: deg
+    // @Range: 0 45
+    // @Increment: 0.5
+    // @RebootRequired: True
+    // @User: Advanced
+    AP_GROUPINFO("_BIN_RES", 19, AP_Proximity, _bin_resolution_deg, 0),
+
     AP_GROUPEND
 };
 
@@ -271,6 +281,35 @@ void AP_Proximity::handle_msg(mavlink_message_t *msg)
     }
 }
 
+// record the vehicle's yaw and horizontal velocity for motion compensating points
+void AP_Proximity::update_motion(float yaw, const Vector2f &velocity)
+{
+    _motion.update(AP_HAL::micros(), yaw, velocity);
+}
+
+// add a batch of points from a scanning sensor
+bool AP_Proximity::handle_points(uint8_t instance, const AP_Proximity_Scan::Point *points, uint16_t count, uint32_t ref_time_us)
+{
+    if (instance >= num_instances || (drivers[instance] == nullptr) || (_type[instance] == Proximity_Type_None)) {
+        return false;
+    }
+    return drivers[instance]->handle_points(points, count, ref_time_us);
+}
+
+// closest distances in narrow bins around the vehicle
+const AP_Proximity_Scan *AP_Proximity::get_scan(uint8_t instance) const
+{
+    if ((drivers[instance] == nullptr) || (_type[instance] == Proximity_Type_None)) {
+        return nullptr;
+    }
+    return drivers[instance]->get_scan();
+}
+
+const AP_Proximity_Scan *AP_Proximity::get_scan() const
+{
+    return get_scan(primary_instance);
+}
+
 //  detect if an instance of a proximity sensor is connected.
 void AP_Proximity::detect_instance(uint8_t instance)
 {
@@ -20,6 +20,7 @@
 #include <AP_Math/AP_Math.h>
 #include <AP_SerialManager/AP_SerialManager.h>
 #include <AP_RangeFinder/AP_RangeFinder.h>
+#include "AP_Proximity_Scan.h"
 
 #define PROXIMITY_MAX_INSTANCES             1   // Maximum number of proximity sensor instances available on this platform
 #define PROXIMITY_YAW_CORRECTION_DEFAULT    22  // default correction for sensor error in yaw
@@ -110,6 +111,25 @@ public:
     // handle mavlink DISTANCE_SENSOR messages
     void handle_msg(mavlink_message_t *msg);
 
+    //
+    // support for scanning sensors producing many points per revolution
+    //
+
+    // record the vehicle's yaw (radians) and horizontal velocity
+    // (North/East m/s), used to compensate points for the vehicle's
+    // motion while they were captured. Should be called at the same
+    // rate as update()
+    void update_motion(float yaw, const Vector2f &velocity);
+
+    // add a batch of points from a scanning sensor, captured at or
+    // before ref_time_us. Returns false if the instance does not accept points
+    bool handle_points(uint8_t instance, const AP_Proximity_Scan::Point *points, uint16_t count, uint32_t ref_time_us);
+
+    // closest distances in narrow bins around the vehicle, nullptr if
+    // binning is disabled or the sensor does not produce points
+    const AP_Proximity_Scan *get_scan(uint8_t instance) const;
+    const AP_Proximity_Scan *get_scan() const;
+
     // The Proximity_State structure is filled in by the backend driver
     struct Proximity_State {
         uint8_t                 instance;   // the instance number of this proximity sensor
@@ -141,6 +161,10 @@ private:
     AP_Int16 _yaw_correction[PROXIMITY_MAX_INSTANCES];
     AP_Int16 _ignore_angle_deg[PROXIMITY_MAX_IGNORE];   // angle (in degrees) of area that should be ignored by sensor (i.e. leg shows up)
     AP_Int8 _ignore_width_deg[PROXIMITY_MAX_IGNORE];    // width of beam (in degrees) that should be ignored
+    AP_Float _bin_resolution_deg;                       // resolution (in degrees) points from scanning sensors are kept at, zero to disable
+
+    // recent vehicle yaw and velocity for motion compensating points
+    AP_Proximity_Motion _motion;
 
     void detect_instance(uint8_t instance);
     void update_instance(uint8_t instance);  
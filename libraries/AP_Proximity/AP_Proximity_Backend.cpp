@@ -24,7 +24,10 @@
 */
 AP_Proximity_Backend::AP_Proximity_Backend(AP_Proximity &_frontend, AP_Proximity::Proximity_State &_state) :
         frontend(_frontend),
-        state(_state)
+        state(_state),
+        _scan(nullptr),
+        _scan_failed(false),
+        _scan_sector_update_ms(0)
 {
     // initialise sector edge vector used for building the boundary fence
     init_boundary();
@@ -276,6 +279,62 @@ bool AP_Proximity_Backend::convert_angle_to_sector(float angle_degrees, uint8_t
     return false;
 }
 
+// true if points should be added with handle_points() rather than directly to sectors
+bool AP_Proximity_Backend::scan_enabled() const
+{
+    return frontend._bin_resolution_deg > 0 && !_scan_failed;
+}
+
+// add a batch of points, motion compensated into the scan bins
+bool AP_Proximity_Backend::handle_points(const AP_Proximity_Scan::Point *points, uint16_t count, uint32_t ref_time_us)
+{
+    if (!scan_enabled()) {
+        return false;
+    }
+    if (_scan == nullptr) {
+        _scan = new AP_Proximity_Scan();
+        if (_scan == nullptr || !_scan->init(frontend._bin_resolution_deg)) {
+            delete _scan;
+            _scan = nullptr;
+            _scan_failed = true;
+            return false;
+        }
+    }
+
+    const uint32_t now_ms = AP_HAL::millis();
+    _scan->add_points(points, count, frontend._motion, ref_time_us, distance_min(), distance_max(), now_ms);
+
+    // a batch only covers a few degrees, so update sectors once many have been added
+    if (now_ms - _scan_sector_update_ms >= PROXIMITY_SCAN_SECTOR_UPDATE_MS) {
+        _scan_sector_update_ms = now_ms;
+        update_sectors_from_scan();
+    }
+    return true;
+}
+
+// set each sector to the closest of its scan bins. Bins within ignore
+// areas are never looked at because sectors are placed around them
+void AP_Proximity_Backend::update_sectors_from_scan()
+{
+    if (_scan == nullptr) {
+        return;
+    }
+    const uint32_t now_ms = AP_HAL::millis();
+    for (uint8_t sector=0; sector<_num_sectors; sector++) {
+        const float start_deg = _sector_middle_deg[sector] - _sector_width_deg[sector] * 0.5f;
+        float angle_deg, distance;
+        const bool valid = _scan->get_closest(start_deg, _sector_width_deg[sector], now_ms, angle_deg, distance);
+        if (valid) {
+            _angle[sector] = angle_deg;
+            _distance[sector] = distance;
+        }
+        if (valid || _distance_valid[sector]) {
+            _distance_valid[sector] = valid;
+            update_boundary_for_sector(sector);
+        }
+    }
+}
+
 // get ignore area info
 uint8_t AP_Proximity_Backend::get_ignore_area_count() const
 {
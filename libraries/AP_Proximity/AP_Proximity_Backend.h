@@ -21,6 +21,7 @@
 #define PROXIMITY_SECTORS_MAX   12  // maximum number of sectors
 #define PROXIMITY_BOUNDARY_DIST_MIN 0.6f    // minimum distance for a boundary point.  This ensures the object avoidance code doesn't think we are outside the boundary.
 #define PROXIMITY_BOUNDARY_DIST_DEFAULT 100 // if we have no data for a sector, boundary is placed 100m out
+#define PROXIMITY_SCAN_SECTOR_UPDATE_MS 50  // sectors are updated from scan bins at most this often
 
 class AP_Proximity_Backend
 {
@@ -30,7 +31,7 @@ public:
 
     // we declare a virtual destructor so that Proximity drivers can
     // override with a custom destructor if need be
-    virtual ~AP_Proximity_Backend(void) {}
+    virtual ~AP_Proximity_Backend(void) { delete _scan; }
 
     // update the state structure
     virtual void update() = 0;
@@ -45,6 +46,14 @@ public:
     // handle mavlink DISTANCE_SENSOR messages
     virtual void handle_msg(mavlink_message_t *msg) {}
 
+    // add a batch of points captured at or before ref_time_us, motion
+    // compensated into the scan bins which the sectors are then updated
+    // from. Returns false if binning is disabled
+    bool handle_points(const AP_Proximity_Scan::Point *points, uint16_t count, uint32_t ref_time_us);
+
+    // scan bins, nullptr if binning is disabled or no points have been added
+    const AP_Proximity_Scan *get_scan() const { return _scan; }
+
     // get distance in meters in a particular direction in degrees (0 is forward, clockwise)
     // returns true on successful read and places distance in distance
     bool get_horizontal_distance(float angle_deg, float &distance) const;
@@ -81,6 +90,12 @@ protected:
     //   the boundary point is set to the shortest distance found in the two adjacent sectors, this is a conservative boundary around the vehicle
     void update_boundary_for_sector(uint8_t sector);
 
+    // true if points should be added with handle_points() rather than directly to sectors
+    bool scan_enabled() const;
+
+    // set each sector to the closest of its scan bins
+    void update_sectors_from_scan();
+
     // get ignore area info
     uint8_t get_ignore_area_count() const;
     bool get_ignore_area(uint8_t index, uint16_t &angle_deg, uint8_t &width_deg) const;
@@ -102,4 +117,9 @@ protected:
     // fence boundary
     Vector2f _sector_edge_vector[PROXIMITY_SECTORS_MAX];    // vector for right-edge of each sector, used to speed up calculation of boundary
     Vector2f _boundary_point[PROXIMITY_SECTORS_MAX];        // bounding polygon around the vehicle calculated conservatively for object avoidance
+
+    // motion compensated points from scanning sensors
+    AP_Proximity_Scan *_scan;
+    bool _scan_failed;                      // true if the bins could not be allocated
+    uint32_t _scan_sector_update_ms;        // system time sectors were last updated from the bins
 };
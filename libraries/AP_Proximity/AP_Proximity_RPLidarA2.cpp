@@ -81,6 +81,8 @@ AP_Proximity_RPLidarA2::AP_Proximity_RPLidarA2(AP_Proximity &_frontend,
     _cnt = 0 ;
     _sync_error = 0 ;
     _byte_count = 0;
+    _num_points = 0;
+    _points_start_us = 0;
 }
 
 // detect if a RPLidarA2 proximity sensor is connected by looking for a configured serial port
@@ -357,6 +359,25 @@ void AP_Proximity_RPLidarA2::get_readings()
                 break;
         }
     }
+
+    flush_points(AP_HAL::micros());
+}
+
+// pass decoded points on for binning. The sensor doesn't timestamp
+// its points, but they were all captured since the last bytes were
+// read and it turns at a steady rate, so their capture times are
+// spread evenly over that time
+void AP_Proximity_RPLidarA2::flush_points(uint32_t now_us)
+{
+    if (_num_points > 0) {
+        const uint32_t span_us = now_us - _points_start_us;
+        for (uint8_t i=0; i<_num_points; i++) {
+            _points[i].time_us = _points_start_us + (uint32_t)((uint64_t)span_us * (i+1) / _num_points);
+        }
+        handle_points(_points, _num_points, now_us);
+        _num_points = 0;
+    }
+    _points_start_us = now_us;
 }
 
 void AP_Proximity_RPLidarA2::parse_response_descriptor()
@@ -401,6 +422,16 @@ void AP_Proximity_RPLidarA2::parse_response_data()
                 Debug(2, "                                       D%02.2f A%03.1f Q%02d", distance_m, angle_deg, quality);
 #endif
                 _last_distance_received_ms = AP_HAL::millis();
+                if (scan_enabled()) {
+                    // points are motion compensated and binned a batch at a time
+                    if (_num_points >= RPLIDAR_POINTS_MAX) {
+                        flush_points(AP_HAL::micros());
+                    }
+                    AP_Proximity_Scan::Point &point = _points[_num_points++];
+                    point.angle_deg = angle_deg;
+                    point.distance_m = distance_m;
+                    break;
+                }
                 uint8_t sector;
                 if (convert_angle_to_sector(angle_deg, sector)) {
                     if (distance_m > distance_min()) {
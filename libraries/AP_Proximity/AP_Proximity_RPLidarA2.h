@@ -33,6 +33,8 @@
 #include "AP_Proximity_Backend.h"
 #include <AP_HAL/AP_HAL.h>                   ///< for UARTDriver
 
+#define RPLIDAR_POINTS_MAX  64              ///< points decoded before being passed on for binning
+
 
 class AP_Proximity_RPLidarA2 : public AP_Proximity_Backend
 {
@@ -79,6 +81,9 @@ private:
     void get_readings();
     void reset_rplidar();
 
+    // pass decoded points on for binning, their capture times spread evenly up to now_us
+    void flush_points(uint32_t now_us);
+
     // reply related variables
     AP_HAL::UARTDriver *_uart;
     uint8_t _descriptor[7];
@@ -111,6 +116,11 @@ private:
     float _angle_deg_last;
     float _distance_m_last;
 
+    // points waiting to be binned when the scan is enabled
+    AP_Proximity_Scan::Point _points[RPLIDAR_POINTS_MAX];
+    uint8_t   _num_points;
+    uint32_t  _points_start_us;               ///< system time the oldest waiting point may have been captured
+
     struct PACKED _sensor_scan {
         uint8_t startbit      : 1;            ///< on the first revolution 1 else 0
         uint8_t not_startbit  : 1;            ///< complementary to startbit
@@ -0,0 +1,260 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "AP_Proximity_Scan.h"
+
+// movement below this many meters is ignored, saving the square root and arctangent
+#define PROXIMITY_SCAN_MOVED_MIN    0.01f
+
+// record yaw (radians, clockwise from North) and velocity (North/East m/s) at time_us
+void AP_Proximity_Motion::update(uint32_t time_us, float yaw, const Vector2f &velocity)
+{
+    if (_count > 0 && (int32_t)(time_us - _samples[_newest].time_us) <= 0) {
+        // same or older time, replace the newest sample
+        _samples[_newest].yaw = yaw;
+        _samples[_newest].velocity = velocity;
+        return;
+    }
+    if (_count > 0) {
+        _newest = (_newest + 1) % PROXIMITY_MOTION_HISTORY;
+    }
+    if (_count < PROXIMITY_MOTION_HISTORY) {
+        _count++;
+    }
+    Sample &s = _samples[_newest];
+    s.time_us = time_us;
+    s.yaw = yaw;
+    s.velocity = velocity;
+}
+
+// index of the newest sample at or before time_us, or the oldest sample if all are after
+uint8_t AP_Proximity_Motion::find(uint32_t time_us) const
+{
+    // points are almost always recent, so search back from the newest
+    uint8_t idx = _newest;
+    for (uint8_t i=1; i<_count; i++) {
+        if ((int32_t)(time_us - _samples[idx].time_us) >= 0) {
+            return idx;
+        }
+        idx = (idx + PROXIMITY_MOTION_HISTORY - 1) % PROXIMITY_MOTION_HISTORY;
+    }
+    return idx;
+}
+
+// yaw at time_us
+float AP_Proximity_Motion::yaw_at(uint32_t time_us) const
+{
+    if (_count == 0) {
+        return 0.0f;
+    }
+    const uint8_t idx = find(time_us);
+    const Sample &s0 = _samples[idx];
+    if (idx == _newest || (int32_t)(time_us - s0.time_us) <= 0) {
+        return s0.yaw;
+    }
+    const Sample &s1 = _samples[(idx + 1) % PROXIMITY_MOTION_HISTORY];
+    const float frac = (time_us - s0.time_us) / (float)(s1.time_us - s0.time_us);
+    return s0.yaw + wrap_PI(s1.yaw - s0.yaw) * frac;
+}
+
+// yaw at time_us and the vehicle's movement from time_us to
+// ref_time_us. The velocity is taken as constant over that time, which
+// over the fraction of a second a batch of points covers is accurate
+// to well within a sensor's resolution
+void AP_Proximity_Motion::get(uint32_t time_us, uint32_t ref_time_us, float &yaw, Vector2f &moved) const
+{
+    if (_count == 0) {
+        yaw = 0.0f;
+        moved.zero();
+        return;
+    }
+    const uint8_t idx = find(time_us);
+    const Sample &s0 = _samples[idx];
+    const float dt = (int32_t)(ref_time_us - time_us) * 1.0e-6f;
+    if (idx == _newest || (int32_t)(time_us - s0.time_us) <= 0) {
+        yaw = s0.yaw;
+        moved = s0.velocity * dt;
+        return;
+    }
+    const Sample &s1 = _samples[(idx + 1) % PROXIMITY_MOTION_HISTORY];
+    const float frac = (time_us - s0.time_us) / (float)(s1.time_us - s0.time_us);
+    yaw = s0.yaw + wrap_PI(s1.yaw - s0.yaw) * frac;
+    moved = (s0.velocity + (s1.velocity - s0.velocity) * frac) * dt;
+}
+
+AP_Proximity_Scan::~AP_Proximity_Scan()
+{
+    delete[] _distance;
+    delete[] _updated_ms;
+}
+
+// allocate bins of resolution_deg degrees, limited to PROXIMITY_SCAN_RES_MIN.
+// Returns false if the bins could not be allocated
+bool AP_Proximity_Scan::init(float resolution_deg)
+{
+    resolution_deg = constrain_float(resolution_deg, PROXIMITY_SCAN_RES_MIN, 45.0f);
+    // whole number of bins around the circle
+    const uint16_t num_bins = (uint16_t)ceilf(360.0f / resolution_deg);
+
+    if (num_bins != _num_bins) {
+        delete[] _distance;
+        delete[] _updated_ms;
+        _num_bins = 0;
+        _distance = new float[num_bins];
+        _updated_ms = new uint32_t[num_bins];
+        if (_distance == nullptr || _updated_ms == nullptr) {
+            delete[] _distance;
+            delete[] _updated_ms;
+            _distance = nullptr;
+            _updated_ms = nullptr;
+            return false;
+        }
+        _num_bins = num_bins;
+    }
+    _resolution_deg = 360.0f / _num_bins;
+    _bins_per_deg = _num_bins / 360.0f;
+    _points_added = 0;
+    clear();
+    return true;
+}
+
+// forget all points
+void AP_Proximity_Scan::clear()
+{
+    for (uint16_t i=0; i<_num_bins; i++) {
+        _distance[i] = 0.0f;
+        _updated_ms[i] = 0;
+    }
+}
+
+// bin holding a body frame angle in degrees
+uint16_t AP_Proximity_Scan::angle_to_bin(float angle_deg) const
+{
+    if (angle_deg < 0.0f || angle_deg >= 360.0f) {
+        angle_deg = wrap_360(angle_deg);
+    }
+    const uint16_t bin = (uint16_t)(angle_deg * _bins_per_deg);
+    // rounding can put angles just below 360 past the last bin
+    return bin < _num_bins ? bin : _num_bins - 1;
+}
+
+// add a single compensated point. Points landing in a bin soon after
+// another are from the same sweep and the closest is kept, otherwise
+// the bin is looking at something new and takes the latest point
+void AP_Proximity_Scan::add_to_bin(float angle_deg, float distance, uint32_t now_ms)
+{
+    const uint16_t bin = angle_to_bin(angle_deg);
+    if (_updated_ms[bin] == 0 || now_ms - _updated_ms[bin] > PROXIMITY_SCAN_MERGE_MS || distance < _distance[bin]) {
+        _distance[bin] = distance;
+    }
+    _updated_ms[bin] = now_ms;
+}
+
+// add count points, compensated for motion to ref_time_us. Points
+// outside dist_min to dist_max are dropped
+void AP_Proximity_Scan::add_points(const Point *points, uint16_t count, const AP_Proximity_Motion &motion,
+                                   uint32_t ref_time_us, float dist_min, float dist_max, uint32_t now_ms)
+{
+    if (_num_bins == 0) {
+        return;
+    }
+    // a zero time can't be told from a bin that was never updated
+    if (now_ms == 0) {
+        now_ms = 1;
+    }
+
+    if (!motion.have_motion()) {
+        for (uint16_t i=0; i<count; i++) {
+            const Point &p = points[i];
+            if (p.distance_m > dist_min && p.distance_m < dist_max) {
+                add_to_bin(p.angle_deg, p.distance_m, now_ms);
+                _points_added++;
+            }
+        }
+        return;
+    }
+
+    const float yaw_ref = motion.yaw_at(ref_time_us);
+    const float cos_ref = cosf(yaw_ref);
+    const float sin_ref = sinf(yaw_ref);
+
+    for (uint16_t i=0; i<count; i++) {
+        const Point &p = points[i];
+        if (p.distance_m <= dist_min || p.distance_m >= dist_max) {
+            continue;
+        }
+        float yaw;
+        Vector2f moved;
+        motion.get(p.time_us, ref_time_us, yaw, moved);
+
+        // the vehicle turning only changes the angle
+        const float angle_deg = p.angle_deg + degrees(wrap_PI(yaw - yaw_ref));
+
+        // movement in the body frame at the reference time
+        const Vector2f moved_body(moved.x * cos_ref + moved.y * sin_ref,
+                                  -moved.x * sin_ref + moved.y * cos_ref);
+        if (fabsf(moved_body.x) < PROXIMITY_SCAN_MOVED_MIN && fabsf(moved_body.y) < PROXIMITY_SCAN_MOVED_MIN) {
+            add_to_bin(angle_deg, p.distance_m, now_ms);
+            _points_added++;
+            continue;
+        }
+
+        // the point as seen from where the vehicle is at the reference time
+        const float angle_rad = radians(angle_deg);
+        const Vector2f pos(p.distance_m * cosf(angle_rad) - moved_body.x,
+                           p.distance_m * sinf(angle_rad) - moved_body.y);
+        const float distance = pos.length();
+        if (distance <= dist_min) {
+            continue;
+        }
+        add_to_bin(degrees(atan2f(pos.y, pos.x)), distance, now_ms);
+        _points_added++;
+    }
+}
+
+// distance in meters of a bin updated within PROXIMITY_SCAN_TIMEOUT_MS
+// of now_ms, returns false if there is none
+bool AP_Proximity_Scan::get_distance(uint16_t bin, uint32_t now_ms, float &distance) const
+{
+    if (bin >= _num_bins || _updated_ms[bin] == 0 || now_ms - _updated_ms[bin] > PROXIMITY_SCAN_TIMEOUT_MS) {
+        return false;
+    }
+    distance = _distance[bin];
+    return true;
+}
+
+// closest valid distance over the bins from angle start_deg for
+// width_deg degrees. Returns false if there are none
+bool AP_Proximity_Scan::get_closest(float start_deg, float width_deg, uint32_t now_ms, float &angle_deg, float &distance) const
+{
+    if (_num_bins == 0) {
+        return false;
+    }
+    uint16_t bin = angle_to_bin(start_deg);
+    const uint16_t count = MIN((uint16_t)ceilf(width_deg * _bins_per_deg), _num_bins);
+    bool found = false;
+    for (uint16_t i=0; i<count; i++) {
+        float d;
+        if (get_distance(bin, now_ms, d) && (!found || d < distance)) {
+            distance = d;
+            angle_deg = bin_angle(bin);
+            found = true;
+        }
+        if (++bin == _num_bins) {
+            bin = 0;
+        }
+    }
+    return found;
+}
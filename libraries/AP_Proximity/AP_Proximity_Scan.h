@@ -0,0 +1,136 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <AP_Common/AP_Common.h>
+#include <AP_Math/AP_Math.h>
+
+#define PROXIMITY_MOTION_HISTORY        32      // vehicle yaw and velocity samples kept, 0.32s at 100hz
+#define PROXIMITY_SCAN_RES_MIN          0.5f    // finest bin resolution in degrees
+#define PROXIMITY_SCAN_MERGE_MS         20      // points landing in a bin within this time of the last keep the closest
+#define PROXIMITY_SCAN_TIMEOUT_MS       500     // bins not updated for this long are no longer valid
+
+/*
+  Recent vehicle yaw and horizontal velocity, so points captured by a
+  scanning sensor while the vehicle turns and moves can be moved to
+  where they would have been seen from a single time.
+ */
+class AP_Proximity_Motion {
+public:
+    // record yaw (radians, clockwise from North) and velocity (North/East m/s) at time_us
+    void update(uint32_t time_us, float yaw, const Vector2f &velocity);
+
+    // true once at least one sample has been recorded
+    bool have_motion() const { return _count > 0; }
+
+    // latest sample time
+    uint32_t last_time_us() const { return _samples[_newest].time_us; }
+
+    // yaw at time_us and the vehicle's movement from time_us to
+    // ref_time_us, both interpolated between samples and held at
+    // the ends of the history
+    void get(uint32_t time_us, uint32_t ref_time_us, float &yaw, Vector2f &moved) const;
+
+    // yaw at time_us
+    float yaw_at(uint32_t time_us) const;
+
+private:
+    struct Sample {
+        uint32_t time_us;
+        float yaw;
+        Vector2f velocity;
+    };
+
+    // index of the newest sample at or before time_us, or the oldest sample if all are after
+    uint8_t find(uint32_t time_us) const;
+
+    Sample _samples[PROXIMITY_MOTION_HISTORY];
+    uint8_t _newest = 0;
+    uint8_t _count = 0;
+};
+
+/*
+  Closest distance seen in each of many narrow bins around the vehicle,
+  built from batches of points from a scanning sensor.
+
+  Each point is motion compensated: it is placed in the earth frame
+  using the vehicle's yaw when it was captured, then moved by how far
+  the vehicle travelled since, giving the angle and distance it would
+  have had if every point of the batch had been captured at the
+  reference time.
+ */
+class AP_Proximity_Scan {
+public:
+    // a single return from a scanning sensor
+    struct Point {
+        uint32_t time_us;   // system time the point was captured
+        float angle_deg;    // body frame, 0 is forward, clockwise
+        float distance_m;
+    };
+
+    AP_Proximity_Scan() {}
+    ~AP_Proximity_Scan();
+
+    /* Do not allow copies */
+    AP_Proximity_Scan(const AP_Proximity_Scan &other) = delete;
+    AP_Proximity_Scan &operator=(const AP_Proximity_Scan&) = delete;
+
+    // allocate bins of resolution_deg degrees, limited to PROXIMITY_SCAN_RES_MIN.
+    // Returns false if the bins could not be allocated
+    bool init(float resolution_deg);
+
+    // add count points, compensated for motion to ref_time_us. Points
+    // outside dist_min to dist_max are dropped. now_ms is the system time.
+    // Without motion history points are binned as captured
+    void add_points(const Point *points, uint16_t count, const AP_Proximity_Motion &motion,
+                    uint32_t ref_time_us, float dist_min, float dist_max, uint32_t now_ms);
+
+    // forget all points
+    void clear();
+
+    uint16_t num_bins() const { return _num_bins; }
+    float resolution_deg() const { return _resolution_deg; }
+
+    // middle angle of a bin in degrees
+    float bin_angle(uint16_t bin) const { return (bin + 0.5f) * _resolution_deg; }
+
+    // bin holding a body frame angle in degrees
+    uint16_t angle_to_bin(float angle_deg) const;
+
+    // distance in meters of a bin updated within PROXIMITY_SCAN_TIMEOUT_MS
+    // of now_ms, returns false if there is none
+    bool get_distance(uint16_t bin, uint32_t now_ms, float &distance) const;
+
+    // system time a bin was last updated, zero if never
+    uint32_t last_update_ms(uint16_t bin) const { return _updated_ms[bin]; }
+
+    // closest valid distance over the bins from angle start_deg for
+    // width_deg degrees. Returns false if there are none
+    bool get_closest(float start_deg, float width_deg, uint32_t now_ms, float &angle_deg, float &distance) const;
+
+    // points added since the last init
+    uint32_t points_added() const { return _points_added; }
+
+private:
+    // add a single compensated point
+    void add_to_bin(float angle_deg, float distance, uint32_t now_ms);
+
+    float *_distance = nullptr;         // closest distance in each bin, meters
+    uint32_t *_updated_ms = nullptr;    // system time each bin was last updated
+    uint16_t _num_bins = 0;
+    float _resolution_deg = 0;
+    float _bins_per_deg = 0;
+    uint32_t _points_added = 0;
+};
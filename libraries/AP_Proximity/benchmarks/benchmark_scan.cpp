@@ -0,0 +1,88 @@
+#include <AP_gbenchmark.h>
+
+#include <AP_Proximity/AP_Proximity_Scan.h>
+
+/*
+  Points from a 360 degree lidar turning at 10hz and producing 8000
+  points a second, arriving in batches as they would from a serial
+  port read at 100hz. The vehicle turns and flies North, or hovers when
+  the argument is zero
+ */
+
+#define POINTS_PER_SEC  8000
+#define BATCH_SIZE      (POINTS_PER_SEC / 100)
+#define NUM_BATCHES     100
+#define RESOLUTION_DEG  0.5f
+
+static AP_Proximity_Scan::Point batches[NUM_BATCHES][BATCH_SIZE];
+
+static void setup_batches()
+{
+    static bool done;
+    if (done) {
+        return;
+    }
+    srand(1);
+    uint32_t t_us = 0;
+    float angle = 0;
+    for (uint16_t b=0; b<NUM_BATCHES; b++) {
+        for (uint16_t i=0; i<BATCH_SIZE; i++) {
+            t_us += 1000000 / POINTS_PER_SEC;
+            angle = wrap_360(angle + 360.0f * 10 / POINTS_PER_SEC);
+            AP_Proximity_Scan::Point &p = batches[b][i];
+            p.time_us = t_us;
+            p.angle_deg = angle;
+            p.distance_m = 1.0f + 14.0f * (rand() / (float)RAND_MAX);
+        }
+    }
+    done = true;
+}
+
+static void BM_ScanAddPoints(benchmark::State& state)
+{
+    setup_batches();
+    const bool moving = state.range_x() != 0;
+
+    AP_Proximity_Motion motion;
+    for (uint32_t t=0; t<=NUM_BATCHES * 10000; t+=10000) {
+        motion.update(t, moving ? t * 1.0e-6f : 0.0f, moving ? Vector2f(5, 0) : Vector2f());
+    }
+
+    AP_Proximity_Scan scan;
+    scan.init(RESOLUTION_DEG);
+    uint16_t b = 0;
+    uint32_t now_ms = 1;
+    while (state.KeepRunning()) {
+        const AP_Proximity_Scan::Point *batch = batches[b];
+        scan.add_points(batch, BATCH_SIZE, motion, batch[BATCH_SIZE-1].time_us, 0.2f, 16.0f, now_ms);
+        gbenchmark_escape(&scan);
+        b = (b + 1) % NUM_BATCHES;
+        now_ms += 10;
+    }
+    state.SetItemsProcessed(state.iterations() * BATCH_SIZE);
+}
+
+// closest distance in each of 8 sectors, as done after every few batches
+static void BM_ScanSectors(benchmark::State& state)
+{
+    setup_batches();
+    AP_Proximity_Motion motion;
+    AP_Proximity_Scan scan;
+    scan.init(RESOLUTION_DEG);
+    for (uint16_t b=0; b<NUM_BATCHES; b++) {
+        scan.add_points(batches[b], BATCH_SIZE, motion, 0, 0.2f, 16.0f, 1);
+    }
+    while (state.KeepRunning()) {
+        for (uint8_t sector=0; sector<8; sector++) {
+            float angle, distance;
+            scan.get_closest(sector * 45 - 22.5f, 45, 1, angle, distance);
+            gbenchmark_escape(&distance);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * scan.num_bins());
+}
+
+BENCHMARK(BM_ScanAddPoints)->Arg(0)->Arg(1);
+BENCHMARK(BM_ScanSectors);
+
+BENCHMARK_MAIN()
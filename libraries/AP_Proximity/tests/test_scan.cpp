@@ -0,0 +1,168 @@
+#include <AP_gtest.h>
+
+#include <AP_Proximity/AP_Proximity_Scan.h>
+
+/*
+  A vehicle turning at 1 rad/s while flying North at 5m/s sees a few
+  posts over 200ms. Once compensated every post should be in the bin and
+  at the distance it has from where the vehicle is at the end
+ */
+
+#define START_US    1000000
+#define SWEEP_US    200000
+#define YAW_RATE    1.0f
+#define SPEED       5.0f
+
+static const Vector2f posts[] = {
+    Vector2f(10, 0),
+    Vector2f(0, 6),
+    Vector2f(-4, -3),
+    Vector2f(3, -8),
+};
+
+static float yaw_at(uint32_t t_us)
+{
+    return (t_us - START_US) * 1.0e-6f * YAW_RATE;
+}
+
+static Vector2f pos_at(uint32_t t_us)
+{
+    return Vector2f(SPEED * (t_us - START_US) * 1.0e-6f, 0);
+}
+
+// a post as seen from the vehicle at t_us
+static AP_Proximity_Scan::Point see(const Vector2f &post, uint32_t t_us)
+{
+    const Vector2f rel = post - pos_at(t_us);
+    AP_Proximity_Scan::Point p;
+    p.time_us = t_us;
+    p.angle_deg = wrap_360(degrees(atan2f(rel.y, rel.x) - yaw_at(t_us)));
+    p.distance_m = rel.length();
+    return p;
+}
+
+static void record_motion(AP_Proximity_Motion &motion)
+{
+    for (uint32_t t=START_US; t<=START_US+SWEEP_US; t+=10000) {
+        motion.update(t, yaw_at(t), Vector2f(SPEED, 0));
+    }
+}
+
+TEST(ProximityScanTest, Bins)
+{
+    AP_Proximity_Scan scan;
+    EXPECT_TRUE(scan.init(1.0f));
+    EXPECT_EQ(360, scan.num_bins());
+    EXPECT_EQ(0, scan.angle_to_bin(0.2f));
+    EXPECT_EQ(359, scan.angle_to_bin(-0.2f));
+    EXPECT_EQ(90, scan.angle_to_bin(90.5f));
+
+    // resolution is limited and kept to a whole number of bins
+    EXPECT_TRUE(scan.init(0.1f));
+    EXPECT_EQ(720, scan.num_bins());
+    EXPECT_TRUE(scan.init(7.0f));
+    EXPECT_EQ(52, scan.num_bins());
+    EXPECT_NEAR(360.0f / 52, scan.resolution_deg(), 1e-5f);
+}
+
+TEST(ProximityScanTest, Static)
+{
+    AP_Proximity_Scan scan;
+    AP_Proximity_Motion motion;
+    scan.init(1.0f);
+
+    const AP_Proximity_Scan::Point points[] = {
+        { START_US, 10.3f, 5.0f },
+        { START_US, 10.7f, 4.0f },      // same bin, closer
+        { START_US, 200.0f, 0.1f },     // too close
+        { START_US, 300.0f, 30.0f },    // too far
+    };
+    scan.add_points(points, ARRAY_SIZE(points), motion, START_US, 0.2f, 16.0f, 1000);
+    EXPECT_EQ(2U, scan.points_added());
+
+    float distance;
+    EXPECT_TRUE(scan.get_distance(10, 1000, distance));
+    EXPECT_FLOAT_EQ(4.0f, distance);
+    EXPECT_FALSE(scan.get_distance(200, 1000, distance));
+    EXPECT_FALSE(scan.get_distance(300, 1000, distance));
+
+    // bins time out
+    EXPECT_FALSE(scan.get_distance(10, 1000 + PROXIMITY_SCAN_TIMEOUT_MS + 1, distance));
+
+    // a later sweep replaces the distance even if further away
+    const AP_Proximity_Scan::Point later = { START_US, 10.5f, 6.0f };
+    scan.add_points(&later, 1, motion, START_US, 0.2f, 16.0f, 1100);
+    EXPECT_TRUE(scan.get_distance(10, 1100, distance));
+    EXPECT_FLOAT_EQ(6.0f, distance);
+
+    float angle;
+    EXPECT_TRUE(scan.get_closest(0, 45, 1100, angle, distance));
+    EXPECT_FLOAT_EQ(10.5f, angle);
+    EXPECT_FALSE(scan.get_closest(20, 45, 1100, angle, distance));
+}
+
+TEST(ProximityScanTest, MotionInterpolation)
+{
+    AP_Proximity_Motion motion;
+    EXPECT_FALSE(motion.have_motion());
+    motion.update(1000, radians(170), Vector2f(1, 0));
+    motion.update(2000, radians(-170), Vector2f(3, 0));
+
+    // yaw is interpolated the short way round
+    EXPECT_NEAR(M_PI, fabsf(wrap_PI(motion.yaw_at(1500))), 1e-4f);
+    // and held beyond the ends
+    EXPECT_NEAR(radians(170), motion.yaw_at(500), 1e-5f);
+    EXPECT_NEAR(radians(-170), motion.yaw_at(3000), 1e-5f);
+
+    float yaw;
+    Vector2f moved;
+    motion.get(1500, 1001500, yaw, moved);
+    EXPECT_NEAR(2.0f, moved.x, 1e-4f);
+    EXPECT_NEAR(0.0f, moved.y, 1e-4f);
+}
+
+TEST(ProximityScanTest, MotionCompensation)
+{
+    AP_Proximity_Scan scan;
+    AP_Proximity_Motion motion;
+    scan.init(1.0f);
+    record_motion(motion);
+
+    // each post seen once at a different time in the sweep
+    AP_Proximity_Scan::Point points[ARRAY_SIZE(posts)];
+    for (uint8_t i=0; i<ARRAY_SIZE(posts); i++) {
+        points[i] = see(posts[i], START_US + i * (SWEEP_US / ARRAY_SIZE(posts)));
+    }
+    const uint32_t ref_us = START_US + SWEEP_US;
+    scan.add_points(points, ARRAY_SIZE(points), motion, ref_us, 0.2f, 16.0f, 1000);
+
+    for (uint8_t i=0; i<ARRAY_SIZE(posts); i++) {
+        const AP_Proximity_Scan::Point expected = see(posts[i], ref_us);
+        float distance;
+        EXPECT_TRUE(scan.get_distance(scan.angle_to_bin(expected.angle_deg), 1000, distance));
+        EXPECT_NEAR(expected.distance_m, distance, 0.01f);
+
+        // without compensation the first posts would be many degrees out
+        if (i == 0) {
+            EXPECT_GT(fabsf(wrap_180(points[i].angle_deg - expected.angle_deg)), 10.0f);
+        }
+    }
+}
+
+TEST(ProximityScanTest, MotionWrap)
+{
+    // the microsecond clock wraps during the sweep
+    AP_Proximity_Motion motion;
+    const uint32_t start = 0xFFFFFFFF - 50000;
+    for (uint8_t i=0; i<10; i++) {
+        motion.update(start + i * 10000, i * 0.01f, Vector2f(0, 1));
+    }
+    EXPECT_NEAR(0.055f, motion.yaw_at(start + 55000), 1e-5f);
+    float yaw;
+    Vector2f moved;
+    motion.get(start + 40000, start + 90000, yaw, moved);
+    EXPECT_NEAR(0.04f, yaw, 1e-5f);
+    EXPECT_NEAR(0.05f, moved.y, 1e-5f);
+}
+
+AP_GTEST_MAIN()
@@ -20,7 +20,7 @@ const AP_Param::GroupInfo DataFlash_Class::var_info[] = {
 
     // @Param: _FILE_BUFSIZE
     // @DisplayName: Maximum DataFlash File Backend buffer size (in kilobytes)
-    // @Description: The DataFlash_File backend uses a buffer to store data before writing to the block device.  Raising this value may reduce "gaps" in your SD card logging.  This buffer size may be reduced depending on available memory.  PixHawk requires at least 4 kilobytes.  Maximum value available here is 64 kilobytes.
+    // @Description: The DataFlash_File backend uses a buffer to store data before writing to the block device.  Raising this value may reduce "gaps" in your SD card logging.  The size is rounded down to a power of two, and may be reduced further depending on available memory.  PixHawk requires at least 4 kilobytes.  Maximum value available here is 64 kilobytes.
     // @User: Standard
     AP_GROUPINFO("_FILE_BUFSIZE",  1, DataFlash_Class, _params.file_bufsize,       16),
 
@@ -45,6 +45,14 @@ const AP_Param::GroupInfo DataFlash_Class::var_info[] = {
     // @User: Standard
     AP_GROUPINFO("_FILE_DSRMROT",  4, DataFlash_Class, _params.file_disarm_rot,       0),
 
+    // @Param: _FILE_COMP
+    // @DisplayName: Compress DataFlash log files
+    // @Description: When set, the DataFlash_File backend compresses log data in self-contained blocks before writing it to the card, reducing the write bandwidth needed for high rate logging. A crash loses at most one block. Compressed logs can be read by Replay and the LogAnalyzer, but not by ground stations expecting plain logs. Takes effect after reboot.
+    // @Values: 0:Disabled,1:Enabled
+    // @User: Advanced
+    // @RebootRequired: True
+    AP_GROUPINFO("_FILE_COMP",  5, DataFlash_Class, _params.file_compress,       0),
+
     AP_GROUPEND
 };
 
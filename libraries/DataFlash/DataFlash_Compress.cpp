@@ -0,0 +1,293 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  LZ4 block compression for DataFlash_File logs
+
+  The encoder is a greedy single-probe hash matcher producing standard
+  LZ4 block format, so any LZ4 block decoder can read the payload.
+ */
+
+#include "DataFlash_Compress.h"
+
+#include <string.h>
+
+// LZ4 block format constants
+#define LZ4_MINMATCH     4
+#define LZ4_LASTLITERALS 5  // the last 5 bytes are always literals
+#define LZ4_MFLIMIT      12 // a match can't start within 12 bytes of the end
+#define LZ4_RUN_MASK     15
+#define LZ4_ML_MASK      15
+
+DataFlash_Compressor::~DataFlash_Compressor()
+{
+    delete[] _hash_table;
+    delete[] _block;
+}
+
+bool DataFlash_Compressor::init(uint16_t max_block_size)
+{
+    if (max_block_size == 0 || max_block_size > 32768) {
+        return false;
+    }
+    _hash_table = new uint16_t[1U<<hash_bits];
+    _block = new uint8_t[max_compressed_size(max_block_size)];
+    if (_hash_table == nullptr || _block == nullptr) {
+        delete[] _hash_table;
+        delete[] _block;
+        _hash_table = nullptr;
+        _block = nullptr;
+        return false;
+    }
+    _max_block_size = max_block_size;
+    reset();
+    return true;
+}
+
+void DataFlash_Compressor::advance(uint16_t n)
+{
+    if (n > pending()) {
+        n = pending();
+    }
+    _block_ofs += n;
+    if (_block_ofs == _block_len) {
+        reset();
+    }
+}
+
+uint16_t DataFlash_Compressor::checksum(const uint8_t *p, uint32_t len)
+{
+    // fletcher16
+    uint32_t sum1 = 0xff, sum2 = 0xff;
+    while (len) {
+        uint32_t tlen = len > 20 ? 20 : len;
+        len -= tlen;
+        do {
+            sum2 += sum1 += *p++;
+        } while (--tlen);
+        sum1 = (sum1 & 0xff) + (sum1 >> 8);
+        sum2 = (sum2 & 0xff) + (sum2 >> 8);
+    }
+    sum1 %= 255;
+    sum2 %= 255;
+    return (sum2 << 8) | sum1;
+}
+
+static inline uint32_t read32(const uint8_t *p)
+{
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint8_t *write_length(uint8_t *op, uint32_t len)
+{
+    while (len >= 255) {
+        *op++ = 255;
+        len -= 255;
+    }
+    *op++ = len;
+    return op;
+}
+
+/*
+  compress src into dst in LZ4 block format. dst must have room for
+  max_compressed_size(len) bytes
+ */
+uint16_t DataFlash_Compressor::compress_lz4(const uint8_t *src, uint16_t len, uint8_t *dst)
+{
+    uint8_t *op = dst;
+    uint32_t ip = 0;
+    uint32_t anchor = 0;
+
+    if (len > LZ4_MFLIMIT) {
+        const uint32_t mflimit = len - LZ4_MFLIMIT;
+        const uint32_t matchlimit = len - LZ4_LASTLITERALS;
+        memset(_hash_table, 0, sizeof(_hash_table[0]) << hash_bits);
+
+        while (ip < mflimit) {
+            const uint32_t seq = read32(&src[ip]);
+            const uint32_t h = (seq * 2654435761U) >> (32 - hash_bits);
+            const uint32_t ref = _hash_table[h];
+            _hash_table[h] = ip;
+
+            if (ref >= ip || read32(&src[ref]) != seq) {
+                // skip faster through incompressible data
+                ip += 1 + ((ip - anchor) >> 6);
+                continue;
+            }
+
+            uint32_t mlen = LZ4_MINMATCH;
+            while (ip + mlen < matchlimit && src[ref + mlen] == src[ip + mlen]) {
+                mlen++;
+            }
+
+            // sequence: token, literal length, literals, offset, match length
+            const uint32_t litlen = ip - anchor;
+            uint8_t *token = op++;
+            if (litlen >= LZ4_RUN_MASK) {
+                *token = LZ4_RUN_MASK << 4;
+                op = write_length(op, litlen - LZ4_RUN_MASK);
+            } else {
+                *token = litlen << 4;
+            }
+            memcpy(op, &src[anchor], litlen);
+            op += litlen;
+
+            const uint16_t offset = ip - ref;
+            *op++ = offset & 0xFF;
+            *op++ = offset >> 8;
+
+            const uint32_t ml = mlen - LZ4_MINMATCH;
+            if (ml >= LZ4_ML_MASK) {
+                *token |= LZ4_ML_MASK;
+                op = write_length(op, ml - LZ4_ML_MASK);
+            } else {
+                *token |= ml;
+            }
+
+            ip += mlen;
+            anchor = ip;
+        }
+    }
+
+    // last literals
+    const uint32_t litlen = len - anchor;
+    if (litlen >= LZ4_RUN_MASK) {
+        *op++ = LZ4_RUN_MASK << 4;
+        op = write_length(op, litlen - LZ4_RUN_MASK);
+    } else {
+        *op++ = litlen << 4;
+    }
+    memcpy(op, &src[anchor], litlen);
+    op += litlen;
+
+    return op - dst;
+}
+
+uint16_t DataFlash_Compressor::compress_block(const uint8_t *src, uint16_t len)
+{
+    if (_block == nullptr || pending() != 0) {
+        return 0;
+    }
+    if (len > _max_block_size) {
+        len = _max_block_size;
+    }
+
+    struct df_compress_header hdr;
+    uint8_t *payload = &_block[sizeof(hdr)];
+    uint16_t clen = compress_lz4(src, len, payload);
+    if (clen >= len) {
+        // store incompressible data verbatim
+        memcpy(payload, src, len);
+        clen = len;
+    }
+
+    hdr.magic1 = DF_COMPRESS_MAGIC1;
+    hdr.magic2 = DF_COMPRESS_MAGIC2;
+    hdr.raw_length = len;
+    hdr.compressed_length = clen;
+    hdr.checksum = checksum(payload, clen);
+    memcpy(_block, &hdr, sizeof(hdr));
+
+    _block_ofs = 0;
+    _block_len = sizeof(hdr) + clen;
+    return _block_len;
+}
+
+bool DataFlash_Compressor::check_header(const struct df_compress_header &hdr)
+{
+    return hdr.magic1 == DF_COMPRESS_MAGIC1 &&
+        hdr.magic2 == DF_COMPRESS_MAGIC2 &&
+        hdr.compressed_length <= hdr.raw_length;
+}
+
+int32_t DataFlash_Compressor::decompress_block(const struct df_compress_header &hdr,
+                                               const uint8_t *payload,
+                                               uint8_t *dst, uint32_t dst_len)
+{
+    if (!check_header(hdr) || hdr.raw_length > dst_len ||
+        checksum(payload, hdr.compressed_length) != hdr.checksum) {
+        return -1;
+    }
+    if (hdr.compressed_length == hdr.raw_length) {
+        memcpy(dst, payload, hdr.raw_length);
+        return hdr.raw_length;
+    }
+
+    const uint8_t *ip = payload;
+    const uint8_t *iend = payload + hdr.compressed_length;
+    uint8_t *op = dst;
+    uint8_t *oend = dst + hdr.raw_length;
+
+    while (ip < iend) {
+        const uint8_t token = *ip++;
+
+        uint32_t litlen = token >> 4;
+        if (litlen == LZ4_RUN_MASK) {
+            uint8_t b;
+            do {
+                if (ip >= iend) {
+                    return -1;
+                }
+                b = *ip++;
+                litlen += b;
+            } while (b == 255);
+        }
+        if (litlen > (uint32_t)(iend - ip) || litlen > (uint32_t)(oend - op)) {
+            return -1;
+        }
+        memcpy(op, ip, litlen);
+        op += litlen;
+        ip += litlen;
+
+        if (ip >= iend) {
+            // last sequence has no match
+            break;
+        }
+
+        if (iend - ip < 2) {
+            return -1;
+        }
+        const uint16_t offset = ip[0] | (ip[1] << 8);
+        ip += 2;
+        if (offset == 0 || offset > op - dst) {
+            return -1;
+        }
+
+        uint32_t mlen = token & LZ4_ML_MASK;
+        if (mlen == LZ4_ML_MASK) {
+            uint8_t b;
+            do {
+                if (ip >= iend) {
+                    return -1;
+                }
+                b = *ip++;
+                mlen += b;
+            } while (b == 255);
+        }
+        mlen += LZ4_MINMATCH;
+        if (mlen > (uint32_t)(oend - op)) {
+            return -1;
+        }
+
+        // matches may overlap their own output, so copy bytewise
+        const uint8_t *match = op - offset;
+        while (mlen--) {
+            *op++ = *match++;
+        }
+    }
+
+    return op - dst;
+}
@@ -0,0 +1,101 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+/*
+  block compression for DataFlash_File logs
+
+  A compressed log is a sequence of self-contained blocks, each a
+  df_compress_header followed by compressed_length bytes of payload.
+  The payload is an LZ4 block (no frame) which decompresses to
+  raw_length bytes of ordinary log data.  If compression did not help
+  the payload is stored verbatim and compressed_length equals
+  raw_length.  Blocks never reference each other, so readers skip a
+  truncated or corrupt block and resume at the next header that
+  checks out.  Blocks are cut at arbitrary byte offsets rather than
+  at message boundaries, so the messages split across the edges of a
+  lost block are lost with it and the message parser has to resync on
+  the next message header.
+ */
+
+#include <AP_Common/AP_Common.h>
+#include <stdint.h>
+
+#define DF_COMPRESS_MAGIC1 0xA3 // same as HEAD_BYTE1
+#define DF_COMPRESS_MAGIC2 0x5A // distinguishes from HEAD_BYTE2
+
+struct PACKED df_compress_header {
+    uint8_t magic1;
+    uint8_t magic2;
+    uint16_t raw_length;
+    uint16_t compressed_length;
+    uint16_t checksum;  // fletcher16 of payload
+};
+
+class DataFlash_Compressor {
+public:
+    DataFlash_Compressor() {}
+    ~DataFlash_Compressor();
+
+    /* Do not allow copies */
+    DataFlash_Compressor(const DataFlash_Compressor &other) = delete;
+    DataFlash_Compressor &operator=(const DataFlash_Compressor&) = delete;
+
+    // allocate working memory for blocks of up to max_block_size raw bytes
+    bool init(uint16_t max_block_size);
+
+    uint16_t max_block_size(void) const { return _max_block_size; }
+
+    // compress len bytes into a new block. Only valid when no
+    // block output is pending. Returns the size of the block,
+    // including header.
+    uint16_t compress_block(const uint8_t *src, uint16_t len);
+
+    // block output not yet consumed with advance()
+    uint16_t pending(void) const { return _block_len - _block_ofs; }
+    const uint8_t *readptr(void) const { return &_block[_block_ofs]; }
+    void advance(uint16_t n);
+
+    // discard any pending output
+    void reset(void) { _block_len = _block_ofs = 0; }
+
+    // parse and check a block header; returns false if the header is
+    // not a compressed block
+    static bool check_header(const struct df_compress_header &hdr);
+
+    // decode one block payload into dst. Returns the number of bytes
+    // written to dst or -1 if the payload is corrupt
+    static int32_t decompress_block(const struct df_compress_header &hdr,
+                                    const uint8_t *payload,
+                                    uint8_t *dst, uint32_t dst_len);
+
+    static uint16_t checksum(const uint8_t *p, uint32_t len);
+
+    // worst-case block size for a given raw length
+    static uint32_t max_compressed_size(uint32_t len) {
+        return sizeof(struct df_compress_header) + len + len/255 + 16;
+    }
+
+private:
+    static const uint8_t hash_bits = 12;
+
+    uint16_t compress_lz4(const uint8_t *src, uint16_t len, uint8_t *dst);
+
+    uint16_t *_hash_table = nullptr;
+    uint8_t *_block = nullptr;
+    uint16_t _max_block_size = 0;
+    uint16_t _block_len = 0;
+    uint16_t _block_ofs = 0;
+};
@@ -76,12 +76,16 @@ DataFlash_File::DataFlash_File(DataFlash_Class &front,
     _writebuf_chunk(4096),
 #endif
     _last_write_time(0),
+    _compressor(nullptr),
+    _new_log_pending(false),
     _perf_write(hal.util->perf_alloc(AP_HAL::Util::PC_ELAPSED, "DF_write")),
     _perf_fsync(hal.util->perf_alloc(AP_HAL::Util::PC_ELAPSED, "DF_fsync")),
     _perf_errors(hal.util->perf_alloc(AP_HAL::Util::PC_COUNT, "DF_errors")),
-    _perf_overruns(hal.util->perf_alloc(AP_HAL::Util::PC_COUNT, "DF_overruns"))
+    _perf_overruns(hal.util->perf_alloc(AP_HAL::Util::PC_COUNT, "DF_overruns")),
+    _perf_compress(hal.util->perf_alloc(AP_HAL::Util::PC_ELAPSED, "DF_compress"))
 {
     df_stats_clear();
+    memset(&compress_stats, 0, sizeof(compress_stats));
 }
 
 
@@ -92,11 +96,6 @@ void DataFlash_File::Init()
     int ret;
     struct stat st;
 
-    semaphore = hal.util->new_semaphore();
-    if (semaphore == nullptr) {
-        AP_HAL::panic("Failed to create DataFlash_File semaphore");
-        return;
-    }
     write_fd_semaphore = hal.util->new_semaphore();
     if (write_fd_semaphore == nullptr) {
         AP_HAL::panic("Failed to create DataFlash_File write_fd_semaphore");
@@ -141,7 +140,8 @@ void DataFlash_File::Init()
     }
     bufsize *= 1024;
 
-    // If we can't allocate the full size, try to reduce it until we can allocate it
+    // the size is rounded down to a power of two. If we can't allocate
+    // it, try to reduce it until we can
     while (!_writebuf.set_size(bufsize) && bufsize >= _writebuf_chunk) {
         hal.console->printf("DataFlash_File: Couldn't set buffer size to=%u\n", (unsigned)bufsize);
         bufsize >>= 1;
@@ -152,7 +152,21 @@ void DataFlash_File::Init()
         return;
     }
 
-    hal.console->printf("DataFlash_File: buffer size=%u\n", (unsigned)bufsize);
+    hal.console->printf("DataFlash_File: buffer size=%u\n", (unsigned)_writebuf.get_size());
+
+    if (_front._params.file_compress) {
+        // blocks must be well under the buffer size so the io thread
+        // can compress a full block while the buffer keeps filling
+        const uint16_t block_size = MIN(bufsize / 2, 8192U);
+        _compressor = new DataFlash_Compressor();
+        if (_compressor == nullptr || !_compressor->init(block_size)) {
+            hal.console->printf("DataFlash_File: compression disabled, out of memory\n");
+            delete _compressor;
+            _compressor = nullptr;
+        } else {
+            hal.console->printf("DataFlash_File: compression block size=%u\n", (unsigned)block_size);
+        }
+    }
 
     _initialised = true;
     hal.scheduler->register_io_process(FUNCTOR_BIND_MEMBER(&DataFlash_File::_io_timer, void));
@@ -207,6 +221,9 @@ void DataFlash_File::periodic_1Hz(const uint32_t now)
         _initialised = false;
     }
     df_stats_log();
+    if (_compressor != nullptr) {
+        Log_Write_DataFlash_Compress_Stats();
+    }
 }
 
 void DataFlash_File::periodic_fullrate(const uint32_t now)
@@ -549,10 +566,6 @@ bool DataFlash_File::_WritePrioritisedBlock(const void *pBuffer, uint16_t size,
         return false;
     }
 
-    if (!semaphore->take(1)) {
-        return false;
-    }
-        
     uint32_t space = _writebuf.space();
 
     if (_writing_startup_messages &&
@@ -563,29 +576,25 @@ bool DataFlash_File::_WritePrioritisedBlock(const void *pBuffer, uint16_t size,
         // things:
         if (space < non_messagewriter_message_reserved_space()) {
             // this message isn't dropped, it will be sent again...
-            semaphore->give();
             return false;
         }
     } else {
         // we reserve some amount of space for critical messages:
         if (!is_critical && space < critical_message_reserved_space()) {
             _dropped++;
-            semaphore->give();
             return false;
         }
     }
 
-    // if no room for entire message - drop it:
-    if (space < size) {
+    // if no room for entire message - drop it. The buffer may also
+    // have been filled by another thread since the space check:
+    if (space < size || !_writebuf.write((const uint8_t*)pBuffer, size)) {
         hal.util->perf_count(_perf_overruns);
         _dropped++;
-        semaphore->give();
         return false;
     }
 
-    _writebuf.write((uint8_t*)pBuffer, size);
     df_stats_gather(size);
-    semaphore->give();
     return true;
 }
 
@@ -921,6 +930,9 @@ uint16_t DataFlash_File::start_new_log(void)
     free(fname);
     _write_offset = 0;
     _writebuf.clear();
+    // the compressor belongs to the io thread, which may be part way
+    // through a block; it resets it before its next write
+    _new_log_pending = true;
     write_fd_semaphore->give();
 
     // now update lastlog.txt with the new log number
@@ -1102,7 +1114,8 @@ void DataFlash_File::flush(void)
 {
     uint32_t tnow = AP_HAL::millis();
     hal.scheduler->suspend_timer_procs();
-    while (_write_fd != -1 && _initialised && !_open_error && _writebuf.available()) {
+    while (_write_fd != -1 && _initialised && !_open_error &&
+           (_writebuf.available() || (_compressor != nullptr && _compressor->pending()))) {
         // convince the IO timer that it really is OK to write out
         // less than _writebuf_chunk bytes:
         if (tnow > 2001) { // avoid resetting _last_write_time to 0
@@ -1122,6 +1135,29 @@ void DataFlash_File::flush(void)
 }
 #endif
 
+/*
+  move the next block of data from _writebuf into the compressor
+ */
+void DataFlash_File::compress_next_block(void)
+{
+    uint32_t size;
+    const uint8_t *raw = _writebuf.readptr(size);
+    size = MIN(size, _compressor->max_block_size());
+    if (size == 0) {
+        return;
+    }
+
+    hal.util->perf_begin(_perf_compress);
+    const uint32_t tstart = AP_HAL::micros();
+    const uint16_t block_size = _compressor->compress_block(raw, size);
+    compress_stats.compress_us += AP_HAL::micros() - tstart;
+    hal.util->perf_end(_perf_compress);
+
+    compress_stats.raw_bytes += size;
+    compress_stats.compressed_bytes += block_size;
+    _writebuf.advance(size);
+}
+
 void DataFlash_File::_io_timer(void)
 {
     uint32_t tnow = AP_HAL::millis();
@@ -1131,10 +1167,13 @@ void DataFlash_File::_io_timer(void)
     }
 
     uint32_t nbytes = _writebuf.available();
-    if (nbytes == 0) {
+    const uint32_t pending = (_compressor != nullptr) ? _compressor->pending() : 0;
+    if (nbytes == 0 && pending == 0) {
         return;
     }
-    if (nbytes < _writebuf_chunk && 
+    // when compressing, gather a full block to get a useful ratio
+    const uint32_t min_bytes = (_compressor != nullptr) ? _compressor->max_block_size() : _writebuf_chunk;
+    if (pending == 0 && nbytes < min_bytes &&
         tnow - _last_write_time < 2000UL) {
         // write in _writebuf_chunk-sized chunks, but always write at
         // least once per 2 seconds if data is available
@@ -1156,14 +1195,41 @@ void DataFlash_File::_io_timer(void)
     hal.util->perf_begin(_perf_write);
 
     _last_write_time = tnow;
-    if (nbytes > _writebuf_chunk) {
-        // be kind to the FAT PX4 filesystem
-        nbytes = _writebuf_chunk;
+
+    if (!write_fd_semaphore->take(1)) {
+        hal.util->perf_end(_perf_write);
+        return;
+    }
+    if (_write_fd == -1) {
+        write_fd_semaphore->give();
+        hal.util->perf_end(_perf_write);
+        return;
+    }
+    if (_new_log_pending) {
+        // whatever the compressor holds is for the log that was just
+        // closed. _writebuf was cleared under the semaphore, so what
+        // is read from it below belongs to the new log
+        _new_log_pending = false;
+        if (_compressor != nullptr) {
+            _compressor->reset();
+        }
+        memset(&compress_stats, 0, sizeof(compress_stats));
     }
 
     uint32_t size;
-    const uint8_t *head = _writebuf.readptr(size);
-    nbytes = MIN(nbytes, size);
+    const uint8_t *head;
+    if (_compressor != nullptr) {
+        if (_compressor->pending() == 0) {
+            last_io_operation = "compress";
+            compress_next_block();
+        }
+        head = _compressor->readptr();
+        size = _compressor->pending();
+    } else {
+        head = _writebuf.readptr(size);
+    }
+    // be kind to the FAT PX4 filesystem
+    nbytes = MIN(size, _writebuf_chunk);
 
     // try to align writes on a 512 byte boundary to avoid filesystem reads
     if ((nbytes + _write_offset) % 512 != 0) {
@@ -1172,15 +1238,15 @@ void DataFlash_File::_io_timer(void)
             nbytes -= ofs;
         }
     }
-
-    last_io_operation = "write";
-    if (!write_fd_semaphore->take(1)) {
-        return;
-    }
-    if (_write_fd == -1) {
+    if (nbytes == 0) {
+        // the new log has nothing to write yet
+        last_io_operation = "";
         write_fd_semaphore->give();
+        hal.util->perf_end(_perf_write);
         return;
     }
+
+    last_io_operation = "write";
     ssize_t nwritten = ::write(_write_fd, head, nbytes);
     last_io_operation = "";
     if (nwritten <= 0) {
@@ -1192,7 +1258,11 @@ void DataFlash_File::_io_timer(void)
         _initialised = false;
     } else {
         _write_offset += nwritten;
-        _writebuf.advance(nwritten);
+        if (_compressor != nullptr) {
+            _compressor->advance(nwritten);
+        } else {
+            _writebuf.advance(nwritten);
+        }
         /*
           the best strategy for minimizing corruption on microSD cards
           seems to be to write in 4k chunks and fsync the file on each
@@ -1271,6 +1341,21 @@ void DataFlash_File::Log_Write_DataFlash_Stats_File(const struct df_stats &_stat
     WriteBlock(&pkt, sizeof(pkt));
 }
 
+void DataFlash_File::Log_Write_DataFlash_Compress_Stats()
+{
+    const struct df_compress_stats &_stats = compress_stats;
+    struct log_DFZ pkt = {
+        LOG_PACKET_HEADER_INIT(LOG_DF_COMPRESS_STATS),
+        time_us          : AP_HAL::micros64(),
+        raw_bytes        : _stats.raw_bytes,
+        compressed_bytes : _stats.compressed_bytes,
+        ratio            : _stats.compressed_bytes ? (float)_stats.raw_bytes / _stats.compressed_bytes : 0.0f,
+        compress_us      : _stats.compress_us,
+        us_per_mb        : _stats.raw_bytes ? _stats.compress_us * (1048576.0f / _stats.raw_bytes) : 0.0f,
+    };
+    WriteBlock(&pkt, sizeof(pkt));
+}
+
 void DataFlash_File::df_stats_gather(const uint16_t bytes_written) {
     const uint32_t space_remaining = _writebuf.space();
     if (space_remaining < stats.buf_space_min) {
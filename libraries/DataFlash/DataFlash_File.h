@@ -10,6 +10,7 @@
 
 #include <AP_HAL/utility/RingBuffer.h>
 #include "DataFlash_Backend.h"
+#include "DataFlash_Compress.h"
 
 #if CONFIG_HAL_BOARD == HAL_BOARD_QURT
 /*
@@ -25,6 +26,8 @@
 
 class DataFlash_File : public DataFlash_Backend
 {
+    friend class DataFlash_File_Test;
+
 public:
     // constructor
     DataFlash_File(DataFlash_Class &front,
@@ -120,11 +123,21 @@ private:
 #else
     const float min_avail_space_percent = 10.0f;
 #endif
-    // write buffer
-    ByteBuffer _writebuf;
+    // write buffer, written without locking from any thread and read
+    // from the io thread
+    MPSCByteBuffer _writebuf;
     const uint16_t _writebuf_chunk;
     uint32_t _last_write_time;
 
+    // optional compression of data between _writebuf and the file,
+    // run on the io thread
+    DataFlash_Compressor *_compressor;
+    void compress_next_block(void);
+
+    // set by start_new_log() under write_fd_semaphore; the io thread
+    // then drops whatever it had prepared for the previous file
+    volatile bool _new_log_pending;
+
     /* construct a file name given a log number. Caller must free. */
     char *_log_file_name(const uint16_t log_num) const;
     char *_log_file_name_long(const uint16_t log_num) const;
@@ -165,8 +178,6 @@ private:
     const uint32_t _free_space_check_interval = 1000UL; // milliseconds
     const uint32_t _free_space_min_avail = 8388608; // bytes
 
-    // semaphore mediates access to the ringbuffer
-    AP_HAL::Semaphore *semaphore;
     // write_fd_semaphore mediates access to write_fd so the frontend
     // can open/close files without causing the backend to write to a
     // bad fd
@@ -177,6 +188,7 @@ private:
     AP_HAL::Util::perf_counter_t  _perf_fsync;
     AP_HAL::Util::perf_counter_t  _perf_errors;
     AP_HAL::Util::perf_counter_t  _perf_overruns;
+    AP_HAL::Util::perf_counter_t  _perf_compress;
 
     const char *last_io_operation = "";
 
@@ -194,6 +206,16 @@ private:
     void df_stats_log();
     void df_stats_clear();
 
+    // totals for the current log; only the io thread updates these
+    struct df_compress_stats {
+        uint32_t raw_bytes;
+        uint32_t compressed_bytes;
+        uint32_t compress_us;
+    };
+    struct df_compress_stats compress_stats;
+
+    void Log_Write_DataFlash_Compress_Stats();
+
 };
 
 #endif // HAL_OS_POSIX_IO
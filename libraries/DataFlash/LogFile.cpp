@@ -1984,3 +1984,26 @@ void DataFlash_Class::Log_Write_SRTL(bool active, uint16_t num_points, uint16_t
     };
     WriteBlock(&pkt_srtl, sizeof(pkt_srtl));
 }
+
+// Write the callback timing of each device bus thread
+void DataFlash_Class::Log_Write_Bus_Threads()
+{
+    const uint64_t now = AP_HAL::micros64();
+    AP_HAL::Util::BusThreadStats stats;
+    static_assert(sizeof(log_BusThread::jitter) == sizeof(stats.histogram), "jitter bins must match");
+
+    for (uint8_t i = 0; hal.util->get_bus_thread_stats(i, stats); i++) {
+        struct log_BusThread pkt = {
+            LOG_PACKET_HEADER_INIT(LOG_BUS_THREAD_MSG),
+            time_us         : now,
+            name            : {},
+            callbacks       : stats.callbacks,
+            overruns        : stats.overruns,
+            max_jitter_us   : stats.max_jitter_us,
+            jitter          : {}
+        };
+        memcpy(pkt.name, stats.name, sizeof(pkt.name));
+        memcpy(pkt.jitter, stats.histogram, sizeof(pkt.jitter));
+        WriteBlock(&pkt, sizeof(pkt));
+    }
+}
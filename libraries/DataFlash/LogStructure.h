@@ -53,6 +53,16 @@ struct PACKED log_DSF {
     uint32_t buf_space_avg;
 };
 
+struct PACKED log_DFZ {
+    LOG_PACKET_HEADER;
+    uint64_t time_us;
+    uint32_t raw_bytes;
+    uint32_t compressed_bytes;
+    float    ratio;
+    uint32_t compress_us;
+    float    us_per_mb;
+};
+
 struct PACKED log_GPS {
     LOG_PACKET_HEADER;
     uint64_t time_us;
@@ -898,6 +908,16 @@ struct PACKED log_SRTL {
     float D;
 };
 
+struct PACKED log_BusThread {
+    LOG_PACKET_HEADER;
+    uint64_t time_us;
+    char name[16];
+    uint32_t callbacks;
+    uint32_t overruns;
+    uint32_t max_jitter_us;
+    uint32_t jitter[8];
+};
+
 // #endif // SBP_HW_LOGGING
 
 #define ACC_LABELS "TimeUS,SampleUS,AccX,AccY,AccZ"
@@ -1029,7 +1049,9 @@ Format characters in the format string for binary log messages
     { LOG_PROXIMITY_MSG, sizeof(log_Proximity), \
       "PRX", "QBfffffffffff", "TimeUS,Health,D0,D45,D90,D135,D180,D225,D270,D315,DUp,CAn,CDis" }, \
     { LOG_SRTL_MSG, sizeof(log_SRTL), \
-      "SRTL", "QBHHBfff", "TimeUS,Active,NumPts,MaxPts,Action,N,E,D" }
+      "SRTL", "QBHHBfff", "TimeUS,Active,NumPts,MaxPts,Action,N,E,D" }, \
+    { LOG_BUS_THREAD_MSG, sizeof(log_BusThread), \
+      "BUSJ", "QNIIIIIIIIIII", "TimeUS,Name,Cnt,Ovr,Max,J10,J20,J50,J100,J200,J500,J1k,JInf" }
 
 // messages for more advanced boards
 #define LOG_EXTRA_STRUCTURES \
@@ -1171,6 +1193,8 @@ Format characters in the format string for binary log messages
       "ORGN","QBLLe","TimeUS,Type,Lat,Lng,Alt" }, \
     { LOG_DF_FILE_STATS, sizeof(log_DSF), \
       "DSF", "QIBHIIII", "TimeUS,Dp,IErr,Blk,Bytes,FMn,FMx,FAv" }, \
+    { LOG_DF_COMPRESS_STATS, sizeof(log_DFZ), \
+      "DFZ", "QIIfIf", "TimeUS,Raw,Comp,Ratio,CUs,UsPerMB" }, \
     { LOG_RPM_MSG, sizeof(log_RPM), \
       "RPM",  "Qff", "TimeUS,rpm1,rpm2" }, \
     { LOG_GIMBAL1_MSG, sizeof(log_Gimbal1), \
@@ -1326,6 +1350,8 @@ enum LogMessages {
     LOG_PROXIMITY_MSG,
     LOG_DF_FILE_STATS,
     LOG_SRTL_MSG,
+    LOG_DF_COMPRESS_STATS,
+    LOG_BUS_THREAD_MSG,
 };
 
 enum LogOriginType {
@@ -0,0 +1,116 @@
+#include <AP_gbenchmark.h>
+
+#include <AP_Math/AP_Math.h>
+#include <DataFlash/DataFlash.h>
+#include <DataFlash/DataFlash_Compress.h>
+
+/*
+  fill buf with IMU and ATT messages resembling a 400Hz copter log
+ */
+static uint32_t fill_log(uint8_t *buf, uint32_t len)
+{
+    uint32_t ofs = 0;
+    uint64_t time_us = 0;
+    uint32_t seed = 1;
+    while (ofs + sizeof(log_IMU) + sizeof(log_Attitude) <= len) {
+        time_us += 2500;
+        seed = seed * 1103515245 + 12345;
+        const float noise = ((seed >> 16) & 0xFF) * 1.0e-4f;
+        const float t = time_us * 1.0e-6f;
+        struct log_IMU imu = {
+            LOG_PACKET_HEADER_INIT(LOG_IMU_MSG),
+            time_us      : time_us,
+            gyro_x       : sinf(t) * 0.1f + noise,
+            gyro_y       : cosf(t) * 0.1f - noise,
+            gyro_z       : noise,
+            accel_x      : 0.2f + noise,
+            accel_y      : -0.1f - noise,
+            accel_z      : -GRAVITY_MSS + noise,
+            gyro_error   : 0,
+            accel_error  : 0,
+            temperature  : 45.0f,
+            gyro_health  : 1,
+            accel_health : 1,
+            gyro_rate    : 400,
+            accel_rate   : 400,
+        };
+        memcpy(&buf[ofs], &imu, sizeof(imu));
+        ofs += sizeof(imu);
+        if ((time_us / 2500) % 4 == 0) {
+            struct log_Attitude att = {
+                LOG_PACKET_HEADER_INIT(LOG_ATTITUDE_MSG),
+                time_us         : time_us,
+                control_roll    : (int16_t)(sinf(t) * 1000),
+                roll            : (int16_t)(sinf(t) * 1000 + (seed & 7)),
+                control_pitch   : 0,
+                pitch           : (int16_t)(seed & 15),
+                control_yaw     : 9000,
+                yaw             : (uint16_t)(9000 + (seed & 31)),
+                error_rp        : 10,
+                error_yaw       : 20,
+            };
+            memcpy(&buf[ofs], &att, sizeof(att));
+            ofs += sizeof(att);
+        }
+    }
+    return ofs;
+}
+
+static void BM_DataFlashCompressBlock(benchmark::State& state)
+{
+    const uint16_t block_size = state.range_x();
+    static uint8_t log[1024*1024];
+    const uint32_t log_len = fill_log(log, sizeof(log));
+
+    DataFlash_Compressor compressor;
+    compressor.init(block_size);
+
+    uint64_t raw_bytes = 0;
+    uint64_t compressed_bytes = 0;
+    uint32_t ofs = 0;
+    while (state.KeepRunning()) {
+        if (ofs + block_size > log_len) {
+            ofs = 0;
+        }
+        const uint16_t n = compressor.compress_block(&log[ofs], block_size);
+        compressor.advance(n);
+        raw_bytes += block_size;
+        compressed_bytes += n;
+        ofs += block_size;
+    }
+
+    state.SetBytesProcessed(raw_bytes);
+    char label[32];
+    snprintf(label, sizeof(label), "ratio %.2f", raw_bytes / (double)compressed_bytes);
+    state.SetLabel(label);
+}
+
+BENCHMARK(BM_DataFlashCompressBlock)->Arg(512)->Arg(4096)->Arg(8192);
+
+static void BM_DataFlashDecompressBlock(benchmark::State& state)
+{
+    const uint16_t block_size = state.range_x();
+    static uint8_t log[1024*1024];
+    static uint8_t out[8192];
+    fill_log(log, sizeof(log));
+
+    DataFlash_Compressor compressor;
+    compressor.init(block_size);
+    compressor.compress_block(log, block_size);
+
+    struct df_compress_header hdr;
+    memcpy(&hdr, compressor.readptr(), sizeof(hdr));
+    const uint8_t *payload = compressor.readptr() + sizeof(hdr);
+
+    uint64_t raw_bytes = 0;
+    while (state.KeepRunning()) {
+        int32_t n = DataFlash_Compressor::decompress_block(hdr, payload, out, sizeof(out));
+        gbenchmark_escape(out);
+        raw_bytes += n;
+    }
+    state.SetBytesProcessed(raw_bytes);
+}
+
+BENCHMARK(BM_DataFlashDecompressBlock)->Arg(4096)->Arg(8192);
+
+BENCHMARK_MAIN()
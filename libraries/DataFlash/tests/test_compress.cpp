@@ -0,0 +1,99 @@
+#include <AP_gtest.h>
+
+#include <AP_HAL/AP_HAL.h>
+#include <DataFlash/DataFlash_Compress.h>
+
+const AP_HAL::HAL &hal = AP_HAL::get_HAL();
+
+static uint8_t raw[8192];
+static uint8_t out[8192];
+
+/*
+  compress len bytes of raw into one block and decode it into out,
+  returning the decoded length
+ */
+static int32_t roundtrip(DataFlash_Compressor &compressor, uint16_t len)
+{
+    const uint16_t n = compressor.compress_block(raw, len);
+    EXPECT_EQ(n, compressor.pending());
+
+    struct df_compress_header hdr;
+    memcpy(&hdr, compressor.readptr(), sizeof(hdr));
+    EXPECT_TRUE(DataFlash_Compressor::check_header(hdr));
+    EXPECT_EQ(n, sizeof(hdr) + hdr.compressed_length);
+
+    memset(out, 0, sizeof(out));
+    int32_t ret = DataFlash_Compressor::decompress_block(hdr, compressor.readptr() + sizeof(hdr),
+                                                         out, sizeof(out));
+    compressor.advance(n);
+    EXPECT_EQ(0, compressor.pending());
+    return ret;
+}
+
+TEST(DataFlashCompress, Random)
+{
+    DataFlash_Compressor compressor;
+    ASSERT_TRUE(compressor.init(sizeof(raw)));
+    uint32_t seed = 42;
+    for (uint16_t i = 0; i < sizeof(raw); i++) {
+        seed = seed * 1103515245 + 12345;
+        raw[i] = seed >> 16;
+    }
+    EXPECT_EQ((int32_t)sizeof(raw), roundtrip(compressor, sizeof(raw)));
+    EXPECT_EQ(0, memcmp(raw, out, sizeof(raw)));
+}
+
+TEST(DataFlashCompress, Structured)
+{
+    DataFlash_Compressor compressor;
+    ASSERT_TRUE(compressor.init(sizeof(raw)));
+    for (uint16_t i = 0; i < sizeof(raw); i++) {
+        raw[i] = (i % 37) < 3 ? 0xA3 : (i / 37) & 0x0F;
+    }
+    const uint16_t n = compressor.compress_block(raw, sizeof(raw));
+    EXPECT_LT(n, sizeof(raw) / 2);
+    compressor.reset();
+    EXPECT_EQ((int32_t)sizeof(raw), roundtrip(compressor, sizeof(raw)));
+    EXPECT_EQ(0, memcmp(raw, out, sizeof(raw)));
+}
+
+TEST(DataFlashCompress, ShortBlocks)
+{
+    DataFlash_Compressor compressor;
+    ASSERT_TRUE(compressor.init(sizeof(raw)));
+    memset(raw, 0x55, sizeof(raw));
+    const uint16_t lengths[] = { 0, 1, 5, 12, 13, 17, 255, 270 };
+    for (uint8_t i = 0; i < ARRAY_SIZE(lengths); i++) {
+        EXPECT_EQ(lengths[i], roundtrip(compressor, lengths[i]));
+        EXPECT_EQ(0, memcmp(raw, out, lengths[i]));
+    }
+}
+
+TEST(DataFlashCompress, Corrupt)
+{
+    DataFlash_Compressor compressor;
+    ASSERT_TRUE(compressor.init(sizeof(raw)));
+    for (uint16_t i = 0; i < sizeof(raw); i++) {
+        raw[i] = i / 64;
+    }
+    compressor.compress_block(raw, sizeof(raw));
+
+    struct df_compress_header hdr;
+    memcpy(&hdr, compressor.readptr(), sizeof(hdr));
+    uint8_t payload[sizeof(raw)];
+    memcpy(payload, compressor.readptr() + sizeof(hdr), hdr.compressed_length);
+
+    // flipped payload bit fails the checksum
+    payload[hdr.compressed_length/2] ^= 0x10;
+    EXPECT_EQ(-1, DataFlash_Compressor::decompress_block(hdr, payload, out, sizeof(out)));
+    payload[hdr.compressed_length/2] ^= 0x10;
+
+    // output buffer too small
+    EXPECT_EQ(-1, DataFlash_Compressor::decompress_block(hdr, payload, out, 100));
+
+    // not a compressed block
+    hdr.magic2 = 0x95;
+    EXPECT_FALSE(DataFlash_Compressor::check_header(hdr));
+}
+
+AP_GTEST_MAIN()
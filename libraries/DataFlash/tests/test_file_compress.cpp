@@ -0,0 +1,183 @@
+#include <AP_gtest.h>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <DataFlash/DataFlash.h>
+#include <DataFlash/DataFlash_File.h>
+#include <GCS_MAVLink/GCS_Dummy.h>
+
+const AP_HAL::HAL &hal = AP_HAL::get_HAL();
+
+const struct AP_Param::GroupInfo GCS_MAVLINK::var_info[] = {
+    AP_GROUPEND
+};
+static GCS_Dummy _gcs;
+
+static AP_Int32 log_bitmask;
+static DataFlash_Class front = DataFlash_Class::create("DF Compress Test", log_bitmask);
+
+static const struct LogStructure fmt_structure = {
+    LOG_FORMAT_MSG, sizeof(log_Format),
+    "FMT", "BBnNZ", "Type,Length,Name,Format,Columns"
+};
+
+/*
+  a compressed file backend logging into a scratch directory, with the
+  io thread run by hand
+ */
+class DataFlash_File_Test
+{
+public:
+    DataFlash_File_Test() {
+        strcpy(dir, "/tmp/dataflash_testXXXXXX");
+        EXPECT_NE(nullptr, mkdtemp(dir));
+        front._params.file_bufsize.set(16);
+        front._params.file_compress.set(1);
+        df = new DataFlash_File(front, new DFMessageWriter_DFLogStart("DF Compress Test"), dir);
+        df->Init();
+    }
+
+    ~DataFlash_File_Test() {
+        df->stop_logging();
+        DIR *d = opendir(dir);
+        if (d != nullptr) {
+            for (struct dirent *de = readdir(d); de; de = readdir(d)) {
+                char path[64];
+                snprintf(path, sizeof(path), "%s/%s", dir, de->d_name);
+                unlink(path);
+            }
+            closedir(d);
+        }
+        rmdir(dir);
+    }
+
+    DataFlash_Compressor *compressor() { return df->_compressor; }
+    uint16_t start_new_log() { return df->start_new_log(); }
+    uint32_t available() { return df->_writebuf.available(); }
+    bool write(const void *data, uint32_t len) {
+        return df->_writebuf.write((const uint8_t *)data, len);
+    }
+
+    // as though the last write was long enough ago that whatever is
+    // buffered goes out
+    void io_timer() {
+        df->_last_write_time = AP_HAL::millis() - 2001;
+        df->_io_timer();
+    }
+
+    void drain() {
+        for (uint8_t i = 0; i < 20 && (available() || compressor()->pending()); i++) {
+            io_timer();
+        }
+    }
+
+    void write_fmt(struct log_Format &pkt) {
+        df->Log_Fill_Format(&fmt_structure, pkt);
+        EXPECT_TRUE(write(&pkt, sizeof(pkt)));
+    }
+
+    // decode the first block of a log
+    int32_t first_block(uint16_t log_num, uint8_t *out, uint32_t out_len) {
+        char *fname = df->_log_file_name(log_num);
+        const int fd = open(fname, O_RDONLY);
+        free(fname);
+        if (fd == -1) {
+            return -1;
+        }
+        static uint8_t file[16384];
+        const ssize_t len = read(fd, file, sizeof(file));
+        close(fd);
+        struct df_compress_header hdr;
+        if (len < (ssize_t)sizeof(hdr)) {
+            return -1;
+        }
+        memcpy(&hdr, file, sizeof(hdr));
+        if (!DataFlash_Compressor::check_header(hdr) ||
+            len < (ssize_t)(sizeof(hdr) + hdr.compressed_length)) {
+            return -1;
+        }
+        return DataFlash_Compressor::decompress_block(hdr, &file[sizeof(hdr)], out, out_len);
+    }
+
+private:
+    char dir[32];
+    DataFlash_File *df;
+};
+
+static uint8_t old_data[12000];
+static uint8_t out[16384];
+
+static void check_starts_with_fmt(DataFlash_File_Test &test, uint16_t log_num, const struct log_Format &pkt)
+{
+    const int32_t n = test.first_block(log_num, out, sizeof(out));
+    ASSERT_GE(n, (int32_t)sizeof(pkt));
+    EXPECT_EQ(HEAD_BYTE1, out[0]);
+    EXPECT_EQ(HEAD_BYTE2, out[1]);
+    EXPECT_EQ(LOG_FORMAT_MSG, out[2]);
+    EXPECT_EQ(0, memcmp(&pkt, out, sizeof(pkt)));
+}
+
+/*
+  the compressor has written out everything it had for the old log,
+  which still has bytes in the buffer when the new log starts. The
+  first block of the new log has to hold its FMT messages
+ */
+TEST(DataFlashFileCompress, NewLogWithDrainedCompressor)
+{
+    DataFlash_File_Test test;
+    ASSERT_NE(nullptr, test.compressor());
+    const uint16_t old_log = test.start_new_log();
+    ASSERT_NE(0xFFFF, old_log);
+
+    memset(old_data, 0x55, sizeof(old_data));
+    ASSERT_TRUE(test.write(old_data, sizeof(old_data)));
+    test.io_timer();
+    for (uint8_t i = 0; i < 20 && test.compressor()->pending(); i++) {
+        test.io_timer();
+    }
+    ASSERT_EQ(0, test.compressor()->pending());
+    ASSERT_GT(test.available(), 0U);
+
+    const uint16_t new_log = test.start_new_log();
+    ASSERT_NE(old_log, new_log);
+    struct log_Format pkt;
+    test.write_fmt(pkt);
+    test.drain();
+
+    check_starts_with_fmt(test, new_log, pkt);
+}
+
+/*
+  a compressed block of the old log is part way out when the new log
+  starts, it must not end up in the new log
+ */
+TEST(DataFlashFileCompress, NewLogDropsPendingBlock)
+{
+    DataFlash_File_Test test;
+    ASSERT_NE(nullptr, test.compressor());
+    const uint16_t old_log = test.start_new_log();
+    ASSERT_NE(0xFFFF, old_log);
+
+    // random data doesn't compress, so the block takes more than one write
+    uint32_t seed = 42;
+    for (uint16_t i = 0; i < sizeof(old_data); i++) {
+        seed = seed * 1103515245 + 12345;
+        old_data[i] = seed >> 16;
+    }
+    ASSERT_TRUE(test.write(old_data, sizeof(old_data)));
+    test.io_timer();
+    ASSERT_GT(test.compressor()->pending(), 0);
+
+    const uint16_t new_log = test.start_new_log();
+    ASSERT_NE(old_log, new_log);
+    struct log_Format pkt;
+    test.write_fmt(pkt);
+    test.drain();
+
+    check_starts_with_fmt(test, new_log, pkt);
+}
+
+AP_GTEST_MAIN()
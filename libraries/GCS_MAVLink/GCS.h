@@ -360,6 +360,24 @@ private:
     uint32_t        waypoint_timelast_request; // milliseconds
     const uint16_t  waypoint_receive_timeout = 8000; // milliseconds
 
+    // pipelined mission upload. Requests for up to
+    // mission_window_size items after waypoint_request_i are
+    // outstanding at once; items arriving out of order wait in the
+    // window until the items before them have been stored
+    static const uint8_t mission_window_size = 8;
+    struct mission_window_slot {
+        AP_Mission::Mission_Command cmd;
+        uint32_t request_ms;    // time of last request, 0 if not requested yet
+        bool received;
+    };
+    mission_window_slot *mission_window = nullptr;
+    void mission_upload_start(const AP_Mission &mission, const mavlink_message_t *msg, uint16_t start, uint16_t end);
+    void mission_upload_stop(void);
+    MAV_MISSION_RESULT mission_item_store(AP_Mission &mission, uint16_t seq, AP_Mission::Mission_Command &cmd);
+
+    // time before re-requesting a mission item
+    uint32_t waypoint_retry_ms(void) const { return 1000U + (stream_slowdown*20); }
+
     // number of 50Hz ticks until we next send this stream
     uint8_t         stream_ticks[NUM_STREAMS];
 
@@ -153,16 +153,110 @@ GCS_MAVLINK::setup_uart(const AP_SerialManager& serial_manager, AP_SerialManager
 void
 GCS_MAVLINK::queued_waypoint_send()
 {
-    if (initialised &&
-        waypoint_receiving &&
-        waypoint_request_i <= waypoint_request_last) {
+    if (!initialised || !waypoint_receiving) {
+        return;
+    }
+
+    if (mission_window == nullptr) {
+        // one item at a time
+        if (waypoint_request_i <= waypoint_request_last) {
+            mavlink_msg_mission_request_send(
+                chan,
+                waypoint_dest_sysid,
+                waypoint_dest_compid,
+                waypoint_request_i,
+                MAV_MISSION_TYPE_MISSION);
+        }
+        return;
+    }
+
+    // request every item in the window which has not arrived, unless
+    // it was requested recently
+    const uint32_t tnow = MAX(AP_HAL::millis(), 1U);
+    const uint16_t end = MIN(waypoint_request_i + mission_window_size, waypoint_request_last);
+    for (uint16_t seq = waypoint_request_i; seq < end; seq++) {
+        mission_window_slot &slot = mission_window[seq % mission_window_size];
+        if (slot.received ||
+            (slot.request_ms != 0 && tnow - slot.request_ms < waypoint_retry_ms())) {
+            continue;
+        }
+        if (!HAVE_PAYLOAD_SPACE(chan, MISSION_REQUEST)) {
+            break;
+        }
         mavlink_msg_mission_request_send(
             chan,
             waypoint_dest_sysid,
             waypoint_dest_compid,
-            waypoint_request_i,
+            seq,
             MAV_MISSION_TYPE_MISSION);
+        slot.request_ms = tnow;
+    }
+}
+
+/*
+  start receiving mission items [start, end) from the sender of msg
+ */
+void GCS_MAVLINK::mission_upload_start(const AP_Mission &mission, const mavlink_message_t *msg, uint16_t start, uint16_t end)
+{
+    waypoint_dest_sysid = msg->sysid;
+    waypoint_dest_compid = msg->compid;
+    waypoint_timelast_receive = AP_HAL::millis();    // set time we last received commands to now
+    waypoint_timelast_request = 0;          // set time we last requested commands to zero
+    waypoint_receiving = true;              // record that we expect to receive commands
+    waypoint_request_i = start;             // reset the next expected command number
+    waypoint_request_last = end;            // record how many commands we expect to receive
+
+    // the window is only needed while receiving. Without it items are
+    // requested one at a time, which a GCS can ask for through
+    // MIS_OPTIONS if it can't answer several requests at once
+    if (!mission.upload_pipelined()) {
+        delete[] mission_window;
+        mission_window = nullptr;
+    } else if (mission_window == nullptr) {
+        mission_window = new mission_window_slot[mission_window_size];
+    }
+    if (mission_window != nullptr) {
+        memset(mission_window, 0, sizeof(mission_window[0]) * mission_window_size);
+    }
+}
+
+void GCS_MAVLINK::mission_upload_stop(void)
+{
+    waypoint_receiving = false;
+    delete[] mission_window;
+    mission_window = nullptr;
+}
+
+/*
+  store a received mission item at seq.  Items are written one at a
+  time as they come into sequence rather than batched; AP_Mission only
+  moves the records of the block being written, so each write stays
+  cheap
+ */
+MAV_MISSION_RESULT GCS_MAVLINK::mission_item_store(AP_Mission &mission, uint16_t seq, AP_Mission::Mission_Command &cmd)
+{
+    // sanity check for DO_JUMP command
+    if (cmd.id == MAV_CMD_DO_JUMP) {
+        if ((cmd.content.jump.target >= mission.num_commands() && cmd.content.jump.target >= waypoint_request_last) || cmd.content.jump.target == 0) {
+            return MAV_MISSION_ERROR;
+        }
+    }
+
+    // if command index is within the existing list, replace the command
+    if (seq < mission.num_commands()) {
+        if (mission.replace_cmd(seq,cmd)) {
+            return MAV_MISSION_ACCEPTED;
+        }
+        return MAV_MISSION_ERROR;
     }
+
+    // if command is at the end of command list, add the command
+    if (seq == mission.num_commands() && mission.add_cmd(cmd)) {
+        return MAV_MISSION_ACCEPTED;
+    }
+
+    // if beyond the end of the command list, return an error
+    return MAV_MISSION_ERROR;
 }
 
 void GCS_MAVLINK::send_meminfo(void)
@@ -355,7 +449,7 @@ void GCS_MAVLINK::handle_mission_request_list(AP_Mission &mission, mavlink_messa
                                    MAV_MISSION_TYPE_MISSION);
 
     // set variables to help handle the expected sending of commands to the GCS
-    waypoint_receiving = false;             // record that we are sending commands (i.e. not receiving)
+    mission_upload_stop();                  // record that we are sending commands (i.e. not receiving)
     waypoint_dest_sysid = msg->sysid;       // record system id of GCS who has requested the commands
     waypoint_dest_compid = msg->compid;     // record component id of GCS who has requested the commands
 }
@@ -505,11 +599,7 @@ void GCS_MAVLINK::handle_mission_count(AP_Mission &mission, mavlink_message_t *m
     mission.truncate(packet.count);
 
     // set variables to help handle the expected receiving of commands from the GCS
-    waypoint_timelast_receive = AP_HAL::millis();    // set time we last received commands to now
-    waypoint_receiving = true;              // record that we expect to receive commands
-    waypoint_request_i = 0;                 // reset the next expected command number to zero
-    waypoint_request_last = packet.count;   // record how many commands we expect to receive
-    waypoint_timelast_request = 0;          // set time we last requested commands to zero
+    mission_upload_start(mission, msg, 0, packet.count);
 }
 
 /*
@@ -550,11 +640,7 @@ void GCS_MAVLINK::handle_mission_write_partial_list(AP_Mission &mission, mavlink
         return;
     }
 
-    waypoint_timelast_receive = AP_HAL::millis();
-    waypoint_timelast_request = 0;
-    waypoint_receiving   = true;
-    waypoint_request_i   = packet.start_index;
-    waypoint_request_last= packet.end_index;
+    mission_upload_start(mission, msg, packet.start_index, packet.end_index);
 }
 
 
@@ -675,46 +761,49 @@ bool GCS_MAVLINK::handle_mission_item(mavlink_message_t *msg, AP_Mission &missio
         goto mission_ack;
     }
 
-    // check if this is the requested waypoint
-    if (seq != waypoint_request_i) {
-        result = MAV_MISSION_INVALID_SEQUENCE;
-        goto mission_ack;
-    }
-
-    // sanity check for DO_JUMP command
-    if (cmd.id == MAV_CMD_DO_JUMP) {
-        if ((cmd.content.jump.target >= mission.num_commands() && cmd.content.jump.target >= waypoint_request_last) || cmd.content.jump.target == 0) {
-            result = MAV_MISSION_ERROR;
+    if (mission_window == nullptr) {
+        // check if this is the requested waypoint
+        if (seq != waypoint_request_i) {
+            result = MAV_MISSION_INVALID_SEQUENCE;
             goto mission_ack;
         }
-    }
-    
-    // if command index is within the existing list, replace the command
-    if (seq < mission.num_commands()) {
-        if (mission.replace_cmd(seq,cmd)) {
-            result = MAV_MISSION_ACCEPTED;
-        }else{
-            result = MAV_MISSION_ERROR;
+        result = mission_item_store(mission, seq, cmd);
+        if (result != MAV_MISSION_ACCEPTED) {
             goto mission_ack;
         }
-        // if command is at the end of command list, add the command
-    } else if (seq == mission.num_commands()) {
-        if (mission.add_cmd(cmd)) {
-            result = MAV_MISSION_ACCEPTED;
-        }else{
-            result = MAV_MISSION_ERROR;
+        waypoint_request_i++;
+    } else {
+        if (seq < waypoint_request_i) {
+            // a duplicate answer to a re-sent request, already stored
+            return false;
+        }
+        if (seq >= waypoint_request_i + mission_window_size || seq >= waypoint_request_last) {
+            result = MAV_MISSION_INVALID_SEQUENCE;
             goto mission_ack;
         }
-        // if beyond the end of the command list, return an error
-    } else {
-        result = MAV_MISSION_ERROR;
-        goto mission_ack;
+        mission_window_slot &slot = mission_window[seq % mission_window_size];
+        slot.cmd = cmd;
+        slot.received = true;
+
+        // store the run of items which are now in sequence
+        while (waypoint_request_i < waypoint_request_last) {
+            mission_window_slot &next = mission_window[waypoint_request_i % mission_window_size];
+            if (!next.received) {
+                break;
+            }
+            next.received = false;
+            next.request_ms = 0;
+            result = mission_item_store(mission, waypoint_request_i, next.cmd);
+            if (result != MAV_MISSION_ACCEPTED) {
+                goto mission_ack;
+            }
+            waypoint_request_i++;
+        }
     }
-    
+
     // update waypoint receiving state machine
     waypoint_timelast_receive = AP_HAL::millis();
-    waypoint_request_i++;
-    
+
     if (waypoint_request_i >= waypoint_request_last) {
         mavlink_msg_mission_ack_send_buf(
             msg,
@@ -725,7 +814,7 @@ bool GCS_MAVLINK::handle_mission_item(mavlink_message_t *msg, AP_Mission &missio
             MAV_MISSION_TYPE_MISSION);
         
         send_text(MAV_SEVERITY_INFO,"Flight plan received");
-        waypoint_receiving = false;
+        mission_upload_stop();
         mission_is_complete = true;
         // XXX ignores waypoint radius for individual waypoints, can
         // only set WP_RADIUS parameter
@@ -888,11 +977,11 @@ GCS_MAVLINK::update(uint32_t max_time_us)
     }
 
     uint32_t tnow = AP_HAL::millis();
-    uint32_t wp_recv_time = 1000U + (stream_slowdown*20);
+    uint32_t wp_recv_time = waypoint_retry_ms();
 
     // stop waypoint receiving if timeout
     if (waypoint_receiving && (tnow - waypoint_timelast_receive) > wp_recv_time+waypoint_receive_timeout) {
-        waypoint_receiving = false;
+        mission_upload_stop();
     } else if (waypoint_receiving &&
                (tnow - waypoint_timelast_request) > wp_recv_time) {
         waypoint_timelast_request = tnow;
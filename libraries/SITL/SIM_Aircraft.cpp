@@ -126,7 +126,7 @@ bool Aircraft::parse_home(const char *home_str, Location &loc, float &yaw_degree
 float Aircraft::ground_height_difference() const
 {
     float h1, h2;
-    if (sitl->terrain_enable && terrain &&
+    if (sitl && sitl->terrain_enable && terrain &&
         terrain->height_amsl(home, h1, false) &&
         terrain->height_amsl(location, h2, false)) {
         return h2 - h1;
@@ -294,8 +294,9 @@ void Aircraft::add_noise(float throttle)
 */
 double Aircraft::rand_normal(double mean, double stddev)
 {
-    static double n2 = 0.0;
-    static int n2_cached = 0;
+    // per thread so models can be stepped in parallel
+    static thread_local double n2 = 0.0;
+    static thread_local int n2_cached = 0;
     if (!n2_cached) {
         double x, y, r;
         do
@@ -383,6 +384,18 @@ void Aircraft::fill_fdm(struct sitl_fdm &fdm)
         set_speedup(sitl->speedup);
         last_speedup = sitl->speedup;
     }
+
+    // SIM_RATE_HZ overrides the model's frame rate, setting it back to zero
+    // returns to the model's own rate
+    if (last_rate_hz != sitl->rate_hz && (sitl->rate_hz > 0 || last_rate_hz > 0)) {
+        if (last_rate_hz <= 0) {
+            default_rate_hz = rate_hz;
+        }
+        setup_frame_time(sitl->rate_hz > 0 ? sitl->rate_hz : default_rate_hz, target_speedup);
+        last_rate_hz = sitl->rate_hz;
+    }
+
+    set_integrator(sitl->integrator, sitl->integrator_substeps);
 }
 
 uint64_t Aircraft::get_wall_time_us() const
@@ -414,48 +427,174 @@ void Aircraft::set_speedup(float speedup)
 }
 
 /*
-  update the simulation attitude and relative position
+  set the integrator and number of integrator sub-steps per frame
  */
-void Aircraft::update_dynamics(const Vector3f &rot_accel)
+void Aircraft::set_integrator(uint8_t type, uint8_t substeps)
 {
-    const float delta_time = frame_time_us * 1.0e-6f;
+    integrator = (type == INTEGRATOR_RK4) ? INTEGRATOR_RK4 : INTEGRATOR_EULER;
+    integrator_substeps = constrain_int16(substeps, 1, 50);
+}
+
+/*
+  set the state and return the rotational and earth frame accelerations
+  at it. Forces are only recalculated if input is given
+ */
+void Aircraft::dynamics_accel(const struct sitl_input *input,
+                              const Vector3f &pos, const Vector3f &vel, const Vector3f &rates, const Matrix3f &rotation,
+                              Vector3f &rot_accel, Vector3f &body_accel, Vector3f &accel_earth)
+{
+    position = pos;
+    velocity_ef = vel;
+    gyro = rates;
+    dcm = rotation;
+
+    if (input != nullptr) {
+        velocity_air_ef = velocity_ef + wind_ef;
+        calculate_forces(*input, rot_accel, body_accel);
+    }
+
+    accel_earth = dcm * body_accel;
+    accel_earth += Vector3f(0.0f, 0.0f, GRAVITY_MSS);
+
+    // if we're on the ground, then our vertical acceleration is limited
+    // to zero. This effectively adds the force of the ground on the aircraft
+    if (on_ground() && accel_earth.z > 0) {
+        accel_earth.z = 0;
+    }
+}
 
+/*
+  advance the state by one semi-implicit Euler step
+ */
+void Aircraft::integrate_euler(const Vector3f &origin, Vector3f &displacement,
+                               Vector3f &rot_accel, Vector3f &body_accel,
+                               float delta_time, Vector3f &accel_earth)
+{
     // update rotational rates in body frame
-    gyro += rot_accel * delta_time;
+    Vector3f rates = gyro + rot_accel * delta_time;
+    rates.x = constrain_float(rates.x, -radians(2000.0f), radians(2000.0f));
+    rates.y = constrain_float(rates.y, -radians(2000.0f), radians(2000.0f));
+    rates.z = constrain_float(rates.z, -radians(2000.0f), radians(2000.0f));
 
+    // update attitude
+    Matrix3f rotation = dcm;
+    rotation.rotate(rates * delta_time);
+    rotation.normalize();
+
+    // forces were calculated at the start of the step
+    dynamics_accel(nullptr, position, velocity_ef, rates, rotation, rot_accel, body_accel, accel_earth);
+
+    // new velocity and position
+    velocity_ef += accel_earth * delta_time;
+    displacement += velocity_ef * delta_time;
+    position = origin + displacement;
+}
+
+/*
+  advance the state by one fourth order Runge-Kutta step. The attitude
+  is advanced by the weighted mean of the stage rates
+ */
+void Aircraft::integrate_rk4(const struct sitl_input *input, const Vector3f &origin, Vector3f &displacement,
+                             Vector3f &rot_accel, Vector3f &body_accel,
+                             float delta_time, Vector3f &accel_earth)
+{
+    const float half_time = 0.5f * delta_time;
+    const Vector3f disp0 = displacement;
+    const Vector3f vel0 = velocity_ef;
+    const Vector3f rates0 = gyro;
+    const Matrix3f rotation0 = dcm;
+
+    // stage 1 at the start of the step, using the forces already calculated
+    Vector3f accel1, accel2, accel3, accel4;
+    dynamics_accel(nullptr, position, vel0, rates0, rotation0, rot_accel, body_accel, accel1);
+    const Vector3f rot_accel1 = rot_accel;
+
+    // stage 2 at the middle of the step using stage 1 derivatives
+    const Vector3f vel2 = vel0 + accel1 * half_time;
+    const Vector3f rates2 = rates0 + rot_accel1 * half_time;
+    Matrix3f rotation = rotation0;
+    rotation.rotate(rates0 * half_time);
+    rotation.normalize();
+    dynamics_accel(input, origin + (disp0 + vel0 * half_time), vel2, rates2, rotation, rot_accel, body_accel, accel2);
+    const Vector3f rot_accel2 = rot_accel;
+
+    // stage 3 at the middle of the step using stage 2 derivatives
+    const Vector3f vel3 = vel0 + accel2 * half_time;
+    const Vector3f rates3 = rates0 + rot_accel2 * half_time;
+    rotation = rotation0;
+    rotation.rotate(rates2 * half_time);
+    rotation.normalize();
+    dynamics_accel(input, origin + (disp0 + vel2 * half_time), vel3, rates3, rotation, rot_accel, body_accel, accel3);
+    const Vector3f rot_accel3 = rot_accel;
+
+    // stage 4 at the end of the step using stage 3 derivatives
+    const Vector3f vel4 = vel0 + accel3 * delta_time;
+    const Vector3f rates4 = rates0 + rot_accel3 * delta_time;
+    rotation = rotation0;
+    rotation.rotate(rates3 * delta_time);
+    rotation.normalize();
+    dynamics_accel(input, origin + (disp0 + vel3 * delta_time), vel4, rates4, rotation, rot_accel, body_accel, accel4);
+    const Vector3f rot_accel4 = rot_accel;
+
+    // combine the stages
+    accel_earth = (accel1 + (accel2 + accel3) * 2.0f + accel4) / 6.0f;
+    displacement = disp0 + (vel0 + (vel2 + vel3) * 2.0f + vel4) * (delta_time / 6.0f);
+    position = origin + displacement;
+    velocity_ef = vel0 + accel_earth * delta_time;
+
+    gyro = rates0 + (rot_accel1 + (rot_accel2 + rot_accel3) * 2.0f + rot_accel4) * (delta_time / 6.0f);
     gyro.x = constrain_float(gyro.x, -radians(2000.0f), radians(2000.0f));
     gyro.y = constrain_float(gyro.y, -radians(2000.0f), radians(2000.0f));
     gyro.z = constrain_float(gyro.z, -radians(2000.0f), radians(2000.0f));
 
-    // estimate angular acceleration using a first order difference calculation
-    // TODO the simulator interface should provide the angular acceleration
-    ang_accel = (gyro - gyro_prev) / delta_time;
-    gyro_prev = gyro;
-
-    // update attitude
-    dcm.rotate(gyro * delta_time);
+    dcm = rotation0;
+    dcm.rotate((rates0 + (rates2 + rates3) * 2.0f + rates4) * (delta_time / 6.0f));
     dcm.normalize();
+}
 
-    Vector3f accel_earth = dcm * accel_body;
-    accel_earth += Vector3f(0.0f, 0.0f, GRAVITY_MSS);
+/*
+  update the simulation attitude and relative position
+ */
+void Aircraft::update_dynamics(const Vector3f &rot_accel, const struct sitl_input *input)
+{
+    const float delta_time = frame_time_us * 1.0e-6f;
+    const float step_time = delta_time / integrator_substeps;
 
-    // if we're on the ground, then our vertical acceleration is limited
-    // to zero. This effectively adds the force of the ground on the aircraft
-    if (on_ground() && accel_earth.z > 0) {
-        accel_earth.z = 0;
+    const bool was_on_ground = on_ground();
+
+    // integrate over the frame, recalculating forces at the start of
+    // each sub-step after the first. Movement is summed relative to the
+    // starting position so small sub-steps don't lose float precision
+    const Vector3f origin = position;
+    Vector3f displacement;
+    Vector3f step_rot_accel = rot_accel;
+    Vector3f step_body_accel = accel_body;
+    Vector3f accel_earth;
+    for (uint8_t i=0; i<integrator_substeps; i++) {
+        if (i > 0 && input != nullptr) {
+            velocity_air_ef = velocity_ef + wind_ef;
+            calculate_forces(*input, step_rot_accel, step_body_accel);
+        }
+        Vector3f step_accel_earth;
+        if (integrator == INTEGRATOR_RK4) {
+            integrate_rk4(input, origin, displacement, step_rot_accel, step_body_accel, step_time, step_accel_earth);
+        } else {
+            integrate_euler(origin, displacement, step_rot_accel, step_body_accel, step_time, step_accel_earth);
+        }
+        accel_earth += step_accel_earth;
     }
+    // mean acceleration over the frame
+    accel_earth /= integrator_substeps;
+
+    // estimate angular acceleration using a first order difference calculation
+    // TODO the simulator interface should provide the angular acceleration
+    ang_accel = (gyro - gyro_prev) / delta_time;
+    gyro_prev = gyro;
 
     // work out acceleration as seen by the accelerometers. It sees the kinematic
     // acceleration (ie. real movement), plus gravity
     accel_body = dcm.transposed() * (accel_earth + Vector3f(0.0f, 0.0f, -GRAVITY_MSS));
 
-    // new velocity vector
-    velocity_ef += accel_earth * delta_time;
-
-    const bool was_on_ground = on_ground();
-    // new position vector
-    position += velocity_ef * delta_time;
-
     // velocity relative to air mass, in earth frame
     velocity_air_ef = velocity_ef + wind_ef;
 
@@ -34,6 +34,7 @@ class Aircraft {
 
 public:
     Aircraft(const char *home_str, const char *frame_str);
+    virtual ~Aircraft() {}
 
     /*
       structure passed in giving servo positions as PWM values in
@@ -53,6 +54,18 @@ public:
      */
     void set_speedup(float speedup);
 
+    /*
+      set the integrator and number of integrator sub-steps per frame
+     */
+    void set_integrator(uint8_t type, uint8_t substeps);
+
+    /*
+      enable or disable sleeping to keep simulation time in step with the wall clock
+     */
+    void set_time_sync(bool enable) {
+        use_time_sync = enable;
+    }
+
     /*
       set instance number
      */
@@ -163,6 +176,8 @@ protected:
     const char *frame;
     bool use_time_sync = true;
     float last_speedup = -1.0f;
+    int16_t last_rate_hz = -1;
+    float default_rate_hz = 0.0f;  // model's own frame rate while SIM_RATE_HZ overrides it
 
     enum {
         GROUND_BEHAVIOR_NONE = 0,
@@ -209,8 +224,21 @@ protected:
     /* return wall clock time in microseconds since 1970 */
     uint64_t get_wall_time_us(void) const;
 
-    // update attitude and relative position
-    void update_dynamics(const Vector3f &rot_accel);
+    // integrators used by update_dynamics
+    enum {
+        INTEGRATOR_EULER = 0,   // semi-implicit Euler, rates before attitude and velocity before position
+        INTEGRATOR_RK4 = 1,     // fourth order Runge-Kutta
+    };
+
+    // calculate rotational and body frame linear accelerations at the
+    // current state. Models which implement this can have their forces
+    // recalculated at each integrator sub-step
+    virtual void calculate_forces(const struct sitl_input &input, Vector3f &rot_accel, Vector3f &body_accel) {}
+
+    // update attitude and relative position. If input is given the forces
+    // are recalculated with calculate_forces() at each sub-step and RK4
+    // stage, otherwise rot_accel and accel_body are held over the frame
+    void update_dynamics(const Vector3f &rot_accel, const struct sitl_input *input = nullptr);
 
     // update wind vector
     void update_wind(const struct sitl_input &input);
@@ -231,6 +259,23 @@ protected:
     float filtered_servo_range(const struct sitl_input &input, uint8_t idx);
 
 private:
+    uint8_t integrator = INTEGRATOR_EULER;
+    uint8_t integrator_substeps = 1;
+
+    // set the state and return the rotational and earth frame accelerations at it
+    void dynamics_accel(const struct sitl_input *input,
+                        const Vector3f &pos, const Vector3f &vel, const Vector3f &rates, const Matrix3f &rotation,
+                        Vector3f &rot_accel, Vector3f &body_accel, Vector3f &accel_earth);
+
+    // advance the state by delta_time, returning the mean earth frame acceleration.
+    // displacement is the movement since origin, the position at the start of the frame
+    void integrate_euler(const Vector3f &origin, Vector3f &displacement,
+                         Vector3f &rot_accel, Vector3f &body_accel,
+                         float delta_time, Vector3f &accel_earth);
+    void integrate_rk4(const struct sitl_input *input, const Vector3f &origin, Vector3f &displacement,
+                       Vector3f &rot_accel, Vector3f &body_accel,
+                       float delta_time, Vector3f &accel_earth);
+
     uint64_t last_time_us = 0;
     uint32_t frame_counter = 0;
     uint32_t last_ground_contact_ms;
@@ -184,6 +184,20 @@ void Frame::init(float _mass, float hover_throttle, float _terminal_velocity, fl
 
     terminal_velocity = _terminal_velocity;
     terminal_rotation_rate = _terminal_rotation_rate;
+
+    // cache the motor terms used by calculate_motor_forces()
+    const float arm_scale = radians(5000);
+    num_tilting = 0;
+    for (uint8_t i=0; i<num_motors; i++) {
+        const Motor &m = motors[i];
+        arm_x[i] = arm_scale * cosf(radians(m.angle));
+        arm_y[i] = arm_scale * sinf(radians(m.angle));
+        yaw_factor[i] = m.yaw_factor;
+        servo[i] = m.servo;
+        if (m.roll_servo >= 0 || m.pitch_servo >= 0) {
+            tilting[num_tilting++] = i;
+        }
+    }
 }
 
 /*
@@ -200,6 +214,93 @@ Frame *Frame::find_frame(const char *name)
     return nullptr;
 }
 
+/*
+  copy a frame by name. The frames in supported_frames are shared by
+  every model, and the motors keep servo state between steps
+ */
+Frame *Frame::create_frame(const char *name)
+{
+    const Frame *frame = find_frame(name);
+    if (frame == nullptr) {
+        return nullptr;
+    }
+    Motor *motors = new Motor[frame->num_motors];
+    for (uint8_t i=0; i<frame->num_motors; i++) {
+        motors[i] = frame->motors[i];
+    }
+    Frame *copy = new Frame(*frame);
+    copy->motors = motors;
+    copy->owns_motors = true;
+    return copy;
+}
+
+Frame::~Frame()
+{
+    if (owns_motors) {
+        delete[] motors;
+    }
+}
+
+/*
+  calculate rotational acceleration and thrust summed over all motors,
+  adding to rot_accel and thrust. Gives the same result as summing
+  Motor::calculate_forces() for each motor
+ */
+void Frame::calculate_motor_forces(const Aircraft::sitl_input &input,
+                                   Vector3f &rot_accel,
+                                   Vector3f &thrust)
+{
+    // fudge factor
+    const float yaw_scale = radians(400);
+
+    float motor_speed[SITL_FRAME_MAX_MOTORS];
+    float rot_x[SITL_FRAME_MAX_MOTORS];
+    float rot_y[SITL_FRAME_MAX_MOTORS];
+    float rot_z[SITL_FRAME_MAX_MOTORS];
+    float thrust_x[SITL_FRAME_MAX_MOTORS];
+    float thrust_y[SITL_FRAME_MAX_MOTORS];
+    float thrust_z[SITL_FRAME_MAX_MOTORS];
+
+    // get motor speeds from 0 to 1
+    for (uint8_t i=0; i<num_motors; i++) {
+        motor_speed[i] = constrain_float((input.servos[motor_offset+servo[i]]-1100)/900.0, 0, 1);
+    }
+
+    // untilted motors thrust straight down the body Z axis, so the arm
+    // cross product reduces to the thrust scaled by the arm position
+    for (uint8_t i=0; i<num_motors; i++) {
+        rot_x[i] = -(arm_y[i] * motor_speed[i]);
+        rot_y[i] = arm_x[i] * motor_speed[i];
+        rot_z[i] = yaw_factor[i] * motor_speed[i] * yaw_scale;
+        thrust_x[i] = 0;
+        thrust_y[i] = 0;
+        thrust_z[i] = -motor_speed[i] * thrust_scale;
+    }
+
+    // tilting motors need their servo position and full rotation
+    for (uint8_t t=0; t<num_tilting; t++) {
+        const uint8_t i = tilting[t];
+        Vector3f mraccel, mthrust;
+        motors[i].calculate_forces(input, thrust_scale, motor_offset, mraccel, mthrust);
+        rot_x[i] = mraccel.x;
+        rot_y[i] = mraccel.y;
+        rot_z[i] = mraccel.z;
+        thrust_x[i] = mthrust.x;
+        thrust_y[i] = mthrust.y;
+        thrust_z[i] = mthrust.z;
+    }
+
+    // sum in motor order
+    for (uint8_t i=0; i<num_motors; i++) {
+        rot_accel.x += rot_x[i];
+        rot_accel.y += rot_y[i];
+        rot_accel.z += rot_z[i];
+        thrust.x += thrust_x[i];
+        thrust.y += thrust_y[i];
+        thrust.z += thrust_z[i];
+    }
+}
+
 // calculate rotational and linear accelerations
 void Frame::calculate_forces(const Aircraft &aircraft,
                              const Aircraft::sitl_input &input,
@@ -208,12 +309,7 @@ void Frame::calculate_forces(const Aircraft &aircraft,
 {
     Vector3f thrust; // newtons
 
-    for (uint8_t i=0; i<num_motors; i++) {
-        Vector3f mraccel, mthrust;
-        motors[i].calculate_forces(input, thrust_scale, motor_offset, mraccel, mthrust);
-        rot_accel += mraccel;
-        thrust += mthrust;
-    }
+    calculate_motor_forces(input, rot_accel, thrust);
 
     body_accel = thrust/aircraft.gross_mass();
 
@@ -21,6 +21,9 @@
 #include "SIM_Aircraft.h"
 #include "SIM_Motor.h"
 
+// largest number of motors on a frame
+#define SITL_FRAME_MAX_MOTORS 12
+
 namespace SITL {
 
 /*
@@ -39,10 +42,16 @@ public:
         num_motors(_num_motors),
         motors(_motors) {}
 
+    ~Frame();
 
     // find a frame by name
     static Frame *find_frame(const char *name);
-    
+
+    // copy a frame by name, with its own motors so models updated
+    // on different threads don't share motor state. The copy owns
+    // its motors and is freed by the caller
+    static Frame *create_frame(const char *name);
+
     // initialise frame
     void init(float mass, float hover_throttle, float terminal_velocity, float terminal_rotation_rate);
 
@@ -50,10 +59,30 @@ public:
     void calculate_forces(const Aircraft &aircraft,
                           const Aircraft::sitl_input &input,
                           Vector3f &rot_accel, Vector3f &body_accel);
+
+    // calculate rotational acceleration and thrust summed over all motors
+    void calculate_motor_forces(const Aircraft::sitl_input &input,
+                                Vector3f &rot_accel, Vector3f &thrust);
     
     float terminal_velocity;
     float terminal_rotation_rate;
     float thrust_scale;
     uint8_t motor_offset;
+
+private:
+    // motors allocated by create_frame()
+    bool owns_motors = false;
+
+    /*
+      terms which don't change between steps, cached by init() one
+      array per term so all motors are updated in a single pass. Tilting
+      motors are updated by their Motor object after the pass.
+     */
+    float arm_x[SITL_FRAME_MAX_MOTORS];         // arm position relative to centre of mass
+    float arm_y[SITL_FRAME_MAX_MOTORS];
+    float yaw_factor[SITL_FRAME_MAX_MOTORS];    // positive is clockwise
+    uint8_t servo[SITL_FRAME_MAX_MOTORS];       // servo output driving each motor
+    uint8_t num_tilting;
+    uint8_t tilting[SITL_FRAME_MAX_MOTORS];     // motors with roll or pitch servos
 };
 }
@@ -31,7 +31,7 @@ MultiCopter::MultiCopter(const char *home_str, const char *frame_str) :
 
     gripper.set_aircraft(this);
 
-    frame = Frame::find_frame(frame_str);
+    frame = Frame::create_frame(frame_str);
     if (frame == nullptr) {
         printf("Frame '%s' not found", frame_str);
         exit(1);
@@ -65,7 +65,7 @@ void MultiCopter::update(const struct sitl_input &input)
 
     calculate_forces(input, rot_accel, accel_body);
 
-    update_dynamics(rot_accel);
+    update_dynamics(rot_accel, &input);
 
     // update lat/lon/altitude
     update_position();
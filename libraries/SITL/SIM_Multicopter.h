@@ -34,6 +34,7 @@ namespace SITL {
 class MultiCopter : public Aircraft {
 public:
     MultiCopter(const char *home_str, const char *frame_str);
+    ~MultiCopter() { delete frame; }
 
     /* update model by one time step */
     void update(const struct sitl_input &input);
@@ -45,7 +46,7 @@ public:
 
 protected:
     // calculate rotational and linear accelerations
-    void calculate_forces(const struct sitl_input &input, Vector3f &rot_accel, Vector3f &body_accel);
+    void calculate_forces(const struct sitl_input &input, Vector3f &rot_accel, Vector3f &body_accel) override;
     Frame *frame;
 
     // The numbers below are the pwm output channels with "0" meaning the first output (aka RC1)
@@ -68,7 +68,7 @@ QuadPlane::QuadPlane(const char *home_str, const char *frame_str) :
         // fwd motor gives zero thrust
         thrust_scale = 0;
     }
-    frame = Frame::find_frame(frame_type);
+    frame = Frame::create_frame(frame_type);
     if (frame == nullptr) {
         printf("Failed to find frame '%s'\n", frame_type);
         exit(1);
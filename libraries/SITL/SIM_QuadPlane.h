@@ -30,6 +30,7 @@ namespace SITL {
 class QuadPlane : public Plane {
 public:
     QuadPlane(const char *home_str, const char *frame_str);
+    ~QuadPlane() { delete frame; }
 
     /* update model by one time step */
     void update(const struct sitl_input &input) override;
@@ -103,7 +103,7 @@ void Submarine::update(const struct sitl_input &input)
 
     calculate_forces(input, rot_accel, accel_body);
 
-    update_dynamics(rot_accel);
+    update_dynamics(rot_accel, &input);
 
     // update lat/lon/altitude
     update_position();
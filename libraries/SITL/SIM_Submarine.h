@@ -47,7 +47,7 @@ protected:
     bool on_ground() const override;
 
     // calculate rotational and linear accelerations
-    void calculate_forces(const struct sitl_input &input, Vector3f &rot_accel, Vector3f &body_accel);
+    void calculate_forces(const struct sitl_input &input, Vector3f &rot_accel, Vector3f &body_accel) override;
     Frame *frame;
 };
 
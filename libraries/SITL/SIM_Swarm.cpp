@@ -0,0 +1,183 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  host for stepping many vehicle models in one process
+*/
+
+#include "SIM_Swarm.h"
+
+#include <stdio.h>
+#include <time.h>
+
+using namespace SITL;
+
+Swarm::Swarm(uint8_t num_threads) :
+    _num_vehicles(0),
+    _num_threads(0),
+    _frame(0),
+    _exit(false),
+    _next_vehicle(0),
+    _done_vehicles(0),
+    _sim_time_s(0),
+    _wall_time_us(0)
+{
+    pthread_mutex_init(&_lock, nullptr);
+    pthread_cond_init(&_frame_start, nullptr);
+    pthread_cond_init(&_frame_done, nullptr);
+
+    // the thread calling step() also steps vehicles
+    if (num_threads > SWARM_MAX_THREADS) {
+        num_threads = SWARM_MAX_THREADS;
+    }
+    for (uint8_t i=1; i<num_threads; i++) {
+        if (pthread_create(&_threads[_num_threads], nullptr, worker_trampoline, this) != 0) {
+            ::printf("Swarm: failed to start worker thread\n");
+            break;
+        }
+        _num_threads++;
+    }
+}
+
+Swarm::~Swarm()
+{
+    pthread_mutex_lock(&_lock);
+    _exit = true;
+    pthread_cond_broadcast(&_frame_start);
+    pthread_mutex_unlock(&_lock);
+
+    for (uint8_t i=0; i<_num_threads; i++) {
+        pthread_join(_threads[i], nullptr);
+    }
+
+    pthread_cond_destroy(&_frame_done);
+    pthread_cond_destroy(&_frame_start);
+    pthread_mutex_destroy(&_lock);
+}
+
+/*
+  add a vehicle model, returning its index or -1 if the swarm is full
+ */
+int16_t Swarm::add_vehicle(Aircraft *model)
+{
+    if (model == nullptr || _num_vehicles >= SWARM_MAX_VEHICLES) {
+        return -1;
+    }
+    struct vehicle &v = _vehicles[_num_vehicles];
+    v.model = model;
+    memset(&v.input, 0, sizeof(v.input));
+
+    // the swarm sets the pace, not the wall clock
+    model->set_time_sync(false);
+    model->set_instance(_num_vehicles);
+
+    return _num_vehicles++;
+}
+
+uint64_t Swarm::wall_time_us()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+}
+
+/*
+  step vehicles until none are left unclaimed in this frame
+ */
+void Swarm::run_vehicles()
+{
+    while (true) {
+        const uint16_t i = _next_vehicle.fetch_add(1);
+        if (i >= _num_vehicles) {
+            return;
+        }
+        _vehicles[i].model->update(_vehicles[i].input);
+        if (_done_vehicles.fetch_add(1) + 1 == _num_vehicles) {
+            // last vehicle of the frame
+            pthread_mutex_lock(&_lock);
+            pthread_cond_signal(&_frame_done);
+            pthread_mutex_unlock(&_lock);
+        }
+    }
+}
+
+void *Swarm::worker_trampoline(void *arg)
+{
+    static_cast<Swarm *>(arg)->worker();
+    return nullptr;
+}
+
+void Swarm::worker()
+{
+    uint32_t last_frame = 0;
+
+    pthread_mutex_lock(&_lock);
+    while (true) {
+        while (_frame == last_frame && !_exit) {
+            pthread_cond_wait(&_frame_start, &_lock);
+        }
+        if (_exit) {
+            break;
+        }
+        last_frame = _frame;
+        pthread_mutex_unlock(&_lock);
+
+        run_vehicles();
+
+        pthread_mutex_lock(&_lock);
+    }
+    pthread_mutex_unlock(&_lock);
+}
+
+/*
+  step every vehicle by one frame
+ */
+void Swarm::step()
+{
+    if (_num_vehicles == 0) {
+        return;
+    }
+    const uint64_t start_us = wall_time_us();
+
+    pthread_mutex_lock(&_lock);
+    _done_vehicles = 0;
+    _next_vehicle = 0;
+    _frame++;
+    pthread_cond_broadcast(&_frame_start);
+    pthread_mutex_unlock(&_lock);
+
+    run_vehicles();
+
+    pthread_mutex_lock(&_lock);
+    while (_done_vehicles < _num_vehicles) {
+        pthread_cond_wait(&_frame_done, &_lock);
+    }
+    pthread_mutex_unlock(&_lock);
+
+    for (uint16_t i=0; i<_num_vehicles; i++) {
+        _sim_time_s += 1.0 / _vehicles[i].model->get_rate_hz();
+    }
+    _wall_time_us += wall_time_us() - start_us;
+}
+
+/*
+  simulated seconds per wall clock second, summed over all vehicles
+ */
+float Swarm::sim_rate() const
+{
+    if (_wall_time_us == 0) {
+        return 0;
+    }
+    return _sim_time_s * 1.0e6 / _wall_time_us;
+}
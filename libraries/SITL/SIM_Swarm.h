@@ -0,0 +1,98 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  host for stepping many vehicle models in one process
+*/
+
+#pragma once
+
+#include <atomic>
+#include <pthread.h>
+
+#include "SIM_Aircraft.h"
+
+// most vehicles and worker threads in one swarm
+#define SWARM_MAX_VEHICLES  256
+#define SWARM_MAX_THREADS   32
+
+namespace SITL {
+
+/*
+  Steps many vehicle models in lockstep, one frame per call to step().
+  Vehicles are claimed one at a time from a shared cursor by the worker
+  threads and the calling thread, so a slow model doesn't hold up the
+  others. Hosted models don't sleep to keep pace with the wall clock,
+  the caller decides how fast to step.
+
+  Only the models are hosted, driven by servo inputs set by the
+  caller. A SITL vehicle still runs one firmware and one model per
+  process, connected through SITL_State, and a multi-vehicle SITL
+  test still starts one process per vehicle.
+ */
+class Swarm {
+public:
+    Swarm(uint8_t num_threads);
+    ~Swarm();
+
+    /* add a vehicle model, returning its index or -1 if the swarm is full */
+    int16_t add_vehicle(Aircraft *model);
+
+    uint16_t num_vehicles() const { return _num_vehicles; }
+
+    Aircraft *vehicle(uint16_t i) { return _vehicles[i].model; }
+
+    /* servo input used for vehicle i on the next step */
+    Aircraft::sitl_input &input(uint16_t i) { return _vehicles[i].input; }
+
+    /* step every vehicle by one frame, returning once all have been stepped */
+    void step();
+
+    /* simulated seconds per wall clock second, summed over all vehicles */
+    float sim_rate() const;
+
+private:
+    // step vehicles until none are left unclaimed in this frame
+    void run_vehicles();
+
+    static void *worker_trampoline(void *arg);
+    void worker();
+
+    static uint64_t wall_time_us();
+
+    struct vehicle {
+        Aircraft *model;
+        Aircraft::sitl_input input;
+    } _vehicles[SWARM_MAX_VEHICLES];
+    uint16_t _num_vehicles;
+
+    pthread_t _threads[SWARM_MAX_THREADS];
+    uint8_t _num_threads;
+
+    // frame hand off to the workers
+    pthread_mutex_t _lock;
+    pthread_cond_t _frame_start;
+    pthread_cond_t _frame_done;
+    uint32_t _frame;
+    bool _exit;
+
+    std::atomic<uint16_t> _next_vehicle;    // next vehicle to be claimed this frame
+    std::atomic<uint16_t> _done_vehicles;   // vehicles stepped this frame
+
+    // throughput
+    double _sim_time_s;
+    uint64_t _wall_time_us;
+};
+
+}
@@ -108,6 +108,9 @@ const AP_Param::GroupInfo SITL::var_info2[] = {
     AP_GROUPINFO("ARSPD_PITOT",  7, SITL,  arspd_fail_pitot_pressure, 0),
     AP_GROUPINFO("GPS_ALT_OFS",  8, SITL,  gps_alt_offset, 0),
     AP_GROUPINFO("ARSPD_SIGN",   9, SITL,  arspd_signflip, 0),
+    AP_GROUPINFO("RATE_HZ",     10, SITL,  rate_hz, 0),
+    AP_GROUPINFO("INTEGRATOR",  11, SITL,  integrator, 0),
+    AP_GROUPINFO("SUBSTEPS",    12, SITL,  integrator_substeps, 1),
     AP_GROUPEND
 };
     
@@ -162,6 +162,12 @@ public:
     // differential pressure sensor tube order
     AP_Int8 arspd_signflip;
 
+    // physics frame rate of the built-in models (0 for the model's own), integrator
+    // (0 semi-implicit Euler, 1 RK4) and integrator sub-steps per frame
+    AP_Int16 rate_hz;
+    AP_Int8 integrator;
+    AP_Int8 integrator_substeps;
+
     uint16_t irlock_port;
 
     void simstate_send(mavlink_channel_t chan);
@@ -0,0 +1,63 @@
+#include <AP_gbenchmark.h>
+
+#include <SITL/SIM_Frame.h>
+
+using namespace SITL;
+
+/*
+  compare summing Motor::calculate_forces() for each motor with the
+  cached single pass in Frame::calculate_motor_forces(). Each iteration
+  is one simulation step of the motor model
+ */
+
+static const char *frame_names[] = { "x", "hexa", "octa", "dodeca-hexa", "tilttri" };
+
+static Frame *setup_frame(benchmark::State& state, Aircraft::sitl_input &input)
+{
+    Frame *frame = Frame::find_frame(frame_names[state.range_x()]);
+    frame->motor_offset = 0;
+    frame->init(1.5, 0.51, 15, 4*radians(360));
+    state.SetLabel(frame->name);
+
+    memset(&input, 0, sizeof(input));
+    for (uint8_t i=0; i<ARRAY_SIZE(input.servos); i++) {
+        input.servos[i] = 1400 + 20*i;
+    }
+    return frame;
+}
+
+static void BM_MotorForcesPerMotor(benchmark::State& state)
+{
+    Aircraft::sitl_input input;
+    Frame *frame = setup_frame(state, input);
+
+    while (state.KeepRunning()) {
+        Vector3f rot_accel, thrust;
+        for (uint8_t i=0; i<frame->num_motors; i++) {
+            Vector3f mraccel, mthrust;
+            frame->motors[i].calculate_forces(input, frame->thrust_scale, frame->motor_offset, mraccel, mthrust);
+            rot_accel += mraccel;
+            thrust += mthrust;
+        }
+        gbenchmark_escape(&rot_accel);
+        gbenchmark_escape(&thrust);
+    }
+}
+
+static void BM_MotorForcesFrame(benchmark::State& state)
+{
+    Aircraft::sitl_input input;
+    Frame *frame = setup_frame(state, input);
+
+    while (state.KeepRunning()) {
+        Vector3f rot_accel, thrust;
+        frame->calculate_motor_forces(input, rot_accel, thrust);
+        gbenchmark_escape(&rot_accel);
+        gbenchmark_escape(&thrust);
+    }
+}
+
+BENCHMARK(BM_MotorForcesPerMotor)->DenseRange(0, ARRAY_SIZE(frame_names)-1);
+BENCHMARK(BM_MotorForcesFrame)->DenseRange(0, ARRAY_SIZE(frame_names)-1);
+
+BENCHMARK_MAIN()
@@ -0,0 +1,164 @@
+#include <AP_gbenchmark.h>
+
+#include <SITL/SIM_Multicopter.h>
+
+using namespace SITL;
+
+/*
+  accuracy and speed of the SITL integrators. Each iteration flies a
+  quad X through an open loop scenario, and the label gives the final
+  position and attitude error against semi-implicit Euler at 20kHz.
+  Demands are smooth so that holding them over a frame adds little error
+ */
+
+// integrator settings, the first is the SITL default
+static const struct {
+    uint16_t rate_hz;
+    uint8_t integrator;
+    uint8_t substeps;
+    const char *name;
+} configs[] = {
+    { 1000, 0, 1, "euler 1000Hz" },
+    {  250, 0, 1, "euler 250Hz" },
+    {  250, 0, 4, "euler 250Hz x4" },
+    {  250, 1, 1, "rk4 250Hz" },
+    {  100, 0, 1, "euler 100Hz" },
+    {  100, 1, 1, "rk4 100Hz" },
+    {  100, 1, 2, "rk4 100Hz x2" },
+};
+
+// quad X without sensor noise, started level 100m above home
+class BenchCopter : public MultiCopter {
+public:
+    BenchCopter(uint16_t rate_hz, uint8_t type, uint8_t substeps) :
+        MultiCopter("-35.363261,149.165230,584,0", "x")
+    {
+        setup_frame_time(rate_hz, 1);
+        set_integrator(type, substeps);
+        position.z = -100;
+    }
+
+    void step(const struct sitl_input &input) {
+        Vector3f rot_accel;
+        calculate_forces(input, rot_accel, accel_body);
+        update_dynamics(rot_accel, &input);
+        time_now_us += frame_time_us;
+    }
+
+    float time_s() const { return time_now_us * 1.0e-6f; }
+    const Vector3f &get_position() const { return position; }
+
+protected:
+    // the forces of Frame::calculate_forces() without the noise
+    void calculate_forces(const struct sitl_input &input, Vector3f &rot_accel, Vector3f &body_accel) override {
+        Vector3f thrust;
+        rot_accel.zero();
+        frame->calculate_motor_forces(input, rot_accel, thrust);
+        body_accel = thrust / gross_mass();
+        rot_accel -= gyro * (radians(400.0f) / frame->terminal_rotation_rate);
+        const Vector3f air_resistance = -velocity_air_ef * (GRAVITY_MSS / frame->terminal_velocity);
+        body_accel += dcm.transposed() * air_resistance;
+    }
+};
+
+// servo output for a 0 to 1 motor demand
+static uint16_t motor_pwm(float demand)
+{
+    return 1100 + 900 * constrain_float(demand, 0, 1);
+}
+
+// quad X outputs for throttle, roll, pitch and yaw demands
+static void quad_x(Aircraft::sitl_input &input, float throttle, float roll, float pitch, float yaw)
+{
+    input.servos[0] = motor_pwm(throttle - roll + pitch + yaw);     // front right
+    input.servos[1] = motor_pwm(throttle + roll - pitch + yaw);     // back left
+    input.servos[2] = motor_pwm(throttle + roll + pitch - yaw);     // front left
+    input.servos[3] = motor_pwm(throttle - roll - pitch - yaw);     // back right
+}
+
+static const float hover = 0.51f;
+
+// hover with gentle throttle changes for 10 seconds
+static bool scenario_hover(float t, Aircraft::sitl_input &input)
+{
+    quad_x(input, hover + 0.05f * sinf(t * M_PI), 0, 0, 0);
+    return t < 10;
+}
+
+// roll flip, accelerating then braking the roll over 0.6 seconds, then level out over 3 seconds
+static bool scenario_flip(float t, Aircraft::sitl_input &input)
+{
+    const float roll = (t < 0.6f) ? 0.4f * sinf(t * (2 * M_PI / 0.6f)) : 0;
+    quad_x(input, 0.65f, roll, 0, 0);
+    return t < 3;
+}
+
+// fast roll, pitch, yaw and throttle oscillations for 4 seconds
+static bool scenario_aggressive(float t, Aircraft::sitl_input &input)
+{
+    const float roll = 0.2f * sinf(t * (2 * M_PI * 2.0f));
+    const float pitch = 0.15f * sinf(t * (2 * M_PI * 1.4f) + 0.5f);
+    const float yaw = 0.1f * sinf(t * (2 * M_PI * 0.5f));
+    const float throttle = hover + 0.1f * sinf(t * (2 * M_PI * 0.33f));
+    quad_x(input, throttle, roll, pitch, yaw);
+    return t < 4;
+}
+
+typedef bool (*scenario_fn)(float t, Aircraft::sitl_input &input);
+
+static void fly(BenchCopter &copter, scenario_fn scenario)
+{
+    Aircraft::sitl_input input {};
+    while (scenario(copter.time_s(), input)) {
+        copter.step(input);
+    }
+}
+
+static void run_scenario(benchmark::State& state, scenario_fn scenario)
+{
+    // reference flight with the default integrator at a high rate
+    BenchCopter reference(1000, 0, 20);
+    fly(reference, scenario);
+
+    const uint8_t c = state.range_x();
+    float pos_error = 0;
+    float att_error = 0;
+    while (state.KeepRunning()) {
+        state.PauseTiming();
+        BenchCopter copter(configs[c].rate_hz, configs[c].integrator, configs[c].substeps);
+        state.ResumeTiming();
+
+        fly(copter, scenario);
+
+        pos_error = (copter.get_position() - reference.get_position()).length();
+        Quaternion q;
+        q.from_rotation_matrix(reference.get_dcm().transposed() * copter.get_dcm());
+        att_error = degrees(2 * acosf(constrain_float(fabsf(q.q1), 0, 1)));
+    }
+
+    char label[64];
+    snprintf(label, sizeof(label), "%s pos err %.3fm att err %.2fdeg",
+             configs[c].name, (double)pos_error, (double)att_error);
+    state.SetLabel(label);
+}
+
+static void BM_IntegratorHover(benchmark::State& state)
+{
+    run_scenario(state, scenario_hover);
+}
+
+static void BM_IntegratorFlip(benchmark::State& state)
+{
+    run_scenario(state, scenario_flip);
+}
+
+static void BM_IntegratorAggressive(benchmark::State& state)
+{
+    run_scenario(state, scenario_aggressive);
+}
+
+BENCHMARK(BM_IntegratorHover)->DenseRange(0, ARRAY_SIZE(configs)-1);
+BENCHMARK(BM_IntegratorFlip)->DenseRange(0, ARRAY_SIZE(configs)-1);
+BENCHMARK(BM_IntegratorAggressive)->DenseRange(0, ARRAY_SIZE(configs)-1);
+
+BENCHMARK_MAIN()
@@ -0,0 +1,58 @@
+#include <AP_gbenchmark.h>
+
+#include <SITL/SITL.h>
+#include <SITL/SIM_Multicopter.h>
+#include <SITL/SIM_Swarm.h>
+
+using namespace SITL;
+
+const AP_HAL::HAL &hal = AP_HAL::get_HAL();
+
+/*
+  lockstep stepping of a swarm of quadcopters in one process. Each
+  iteration is one frame of every vehicle through the full
+  MultiCopter::update(), the label gives the simulated seconds per
+  wall clock second summed over the swarm
+ */
+
+// the models look up the SIM_ parameters, as in a SITL vehicle
+static SITL::SITL sitl;
+
+static const AP_Param::Info var_info[] = {
+    { AP_PARAM_GROUP, "SIM_", 0, &sitl, {group_info : SITL::SITL::var_info} },
+    AP_VAREND
+};
+
+static AP_Param param_loader(var_info);
+
+static void BM_SwarmStep(benchmark::State& state)
+{
+    const uint16_t num_vehicles = state.range_x();
+    const uint8_t num_threads = state.range_y();
+
+    Swarm swarm(num_threads);
+    for (uint16_t i=0; i<num_vehicles; i++) {
+        swarm.add_vehicle(MultiCopter::create("-35.363261,149.165230,584,0", "x"));
+        // about hover throttle
+        for (uint8_t m=0; m<4; m++) {
+            swarm.input(i).servos[m] = 1559;
+        }
+    }
+
+    while (state.KeepRunning()) {
+        swarm.step();
+    }
+    state.SetItemsProcessed(state.iterations() * num_vehicles);
+
+    char label[32];
+    snprintf(label, sizeof(label), "%.0f sim s/s", (double)swarm.sim_rate());
+    state.SetLabel(label);
+
+    for (uint16_t i=0; i<num_vehicles; i++) {
+        delete swarm.vehicle(i);
+    }
+}
+
+BENCHMARK(BM_SwarmStep)->ArgPair(50, 1)->ArgPair(50, 2)->ArgPair(50, 4)->ArgPair(200, 1)->ArgPair(200, 4)->ArgPair(200, 8)->UseRealTime();
+
+BENCHMARK_MAIN()
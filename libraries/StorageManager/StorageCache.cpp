@@ -0,0 +1,212 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  write-back cache in front of hal.storage
+ */
+#include "StorageCache.h"
+
+#include <AP_Math/AP_Math.h>
+
+#include <string.h>
+
+extern const AP_HAL::HAL& hal;
+
+/*
+  setup on first write. Without a semaphore the cache is bypassed and
+  writes go straight to hal.storage
+ */
+void StorageCache::init(void)
+{
+    _initialised = true;
+    _sem = hal.util->new_semaphore();
+    if (_sem != nullptr) {
+        hal.scheduler->register_io_process(FUNCTOR_BIND_MEMBER(&StorageCache::io_timer, void));
+        hal.scheduler->register_shutdown_process(FUNCTOR_BIND_MEMBER(&StorageCache::flush, void));
+    }
+}
+
+/*
+  find the line holding base, allocating a free line if needed. Called
+  with the semaphore held
+ */
+struct StorageCache::cache_line *StorageCache::get_line(uint16_t base)
+{
+    struct cache_line *free_line = nullptr;
+    for (uint8_t i=0; i<STORAGE_CACHE_LINES; i++) {
+        struct cache_line &line = _lines[i];
+        if (line.dirty == 0) {
+            if (free_line == nullptr) {
+                free_line = &line;
+            }
+        } else if (line.base == base) {
+            return &line;
+        }
+    }
+    if (free_line == nullptr) {
+        // cache is full, make room
+        flush_locked();
+        free_line = &_lines[0];
+    }
+    free_line->base = base;
+    _lines_used++;
+    return free_line;
+}
+
+void StorageCache::write_block(uint16_t loc, const uint8_t *src, uint16_t n)
+{
+    _bytes_requested += n;
+
+    if (!_initialised) {
+        init();
+    }
+    if (_sem == nullptr || !_sem->take(HAL_SEMAPHORE_BLOCK_FOREVER)) {
+        hal.storage->write_block(loc, src, n);
+        _bytes_written += n;
+        return;
+    }
+
+    while (n > 0) {
+        const uint16_t base = loc & ~(line_size-1);
+        const uint8_t ofs = loc - base;
+        const uint8_t count = MIN(n, (uint16_t)(line_size - ofs));
+        struct cache_line *line = get_line(base);
+        memcpy(&line->data[ofs], src, count);
+        const uint32_t mask = count==line_size?0xFFFFFFFFU:((1U<<count)-1);
+        line->dirty |= mask << ofs;
+        loc += count;
+        src += count;
+        n -= count;
+    }
+
+    _last_write_ms = AP_HAL::millis();
+    if (_first_dirty_ms == 0) {
+        _first_dirty_ms = MAX(_last_write_ms, 1U);
+    }
+
+    _sem->give();
+}
+
+/*
+  read from hal.storage, then overlay any dirty bytes still in the cache
+ */
+void StorageCache::read_block(uint8_t *dst, uint16_t loc, uint16_t n)
+{
+    if (_sem == nullptr || !_sem->take(HAL_SEMAPHORE_BLOCK_FOREVER)) {
+        hal.storage->read_block(dst, loc, n);
+        return;
+    }
+
+    // read under the semaphore so a concurrent flush can't leave us
+    // with neither the old nor the new data
+    hal.storage->read_block(dst, loc, n);
+
+    const uint32_t end = loc + n;
+    for (uint8_t i=0; i<STORAGE_CACHE_LINES && _lines_used != 0; i++) {
+        const struct cache_line &line = _lines[i];
+        if (line.dirty == 0 || line.base + line_size <= loc || line.base >= end) {
+            continue;
+        }
+        for (uint8_t b=0; b<line_size; b++) {
+            const uint32_t ofs = line.base + b;
+            if ((line.dirty & (1U<<b)) && ofs >= loc && ofs < end) {
+                dst[ofs - loc] = line.data[b];
+            }
+        }
+    }
+
+    _sem->give();
+}
+
+/*
+  write one contiguous dirty run, skipping leading and trailing bytes
+  which storage already holds
+ */
+void StorageCache::write_run(uint16_t loc, const uint8_t *src, uint8_t n)
+{
+    uint8_t current[line_size];
+    hal.storage->read_block(current, loc, n);
+    uint8_t first = 0;
+    while (first < n && current[first] == src[first]) {
+        first++;
+    }
+    if (first == n) {
+        return;
+    }
+    uint8_t last = n - 1;
+    while (current[last] == src[last]) {
+        last--;
+    }
+    const uint8_t len = 1 + last - first;
+    hal.storage->write_block(loc + first, &src[first], len);
+    _bytes_written += len;
+}
+
+void StorageCache::flush_locked(void)
+{
+    for (uint8_t i=0; i<STORAGE_CACHE_LINES && _lines_used != 0; i++) {
+        struct cache_line &line = _lines[i];
+        uint32_t dirty = line.dirty;
+        if (dirty == 0) {
+            continue;
+        }
+        uint8_t b = 0;
+        while (dirty != 0) {
+            while ((dirty & 1) == 0) {
+                dirty >>= 1;
+                b++;
+            }
+            const uint8_t start = b;
+            while (dirty & 1) {
+                dirty >>= 1;
+                b++;
+            }
+            write_run(line.base + start, &line.data[start], b - start);
+        }
+        line.dirty = 0;
+        _lines_used--;
+    }
+    _first_dirty_ms = 0;
+}
+
+void StorageCache::flush(void)
+{
+    if (_sem == nullptr || !_sem->take(HAL_SEMAPHORE_BLOCK_FOREVER)) {
+        return;
+    }
+    flush_locked();
+    _sem->give();
+}
+
+/*
+  flush from the IO thread once writes have paused, the data is old or
+  the cache is nearly full
+ */
+void StorageCache::io_timer(void)
+{
+    if (_lines_used == 0) {
+        return;
+    }
+    const uint32_t now = AP_HAL::millis();
+    if (now - _last_write_ms < STORAGE_CACHE_IDLE_MS &&
+        now - _first_dirty_ms < STORAGE_CACHE_MAX_AGE_MS &&
+        _lines_used < (STORAGE_CACHE_LINES*3)/4) {
+        return;
+    }
+    if (!_sem->take_nonblocking()) {
+        return;
+    }
+    flush_locked();
+    _sem->give();
+}
@@ -0,0 +1,89 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  write-back cache in front of hal.storage
+
+  Writes are merged into a small set of dirty lines and passed to
+  hal.storage from the IO thread once writing has paused, so bursts of
+  small writes (parameter saves, mission and rally uploads) reach the
+  HAL as a few contiguous blocks. Only bytes which differ from the
+  current storage contents are written.
+ */
+#pragma once
+
+#include <AP_HAL/AP_HAL.h>
+
+#ifndef STORAGE_CACHE_LINES
+#if HAL_STORAGE_SIZE >= 8192
+#define STORAGE_CACHE_LINES 16
+#else
+#define STORAGE_CACHE_LINES 8
+#endif
+#endif
+
+// flush once no writes have arrived for this long
+#define STORAGE_CACHE_IDLE_MS    100
+// never hold dirty data for longer than this
+#define STORAGE_CACHE_MAX_AGE_MS 1000
+
+class StorageCache {
+public:
+    StorageCache() {}
+
+    /* Do not allow copies */
+    StorageCache(const StorageCache &other) = delete;
+    StorageCache &operator=(const StorageCache&) = delete;
+
+    // offsets are hal.storage offsets
+    void read_block(uint8_t *dst, uint16_t loc, uint16_t n);
+    void write_block(uint16_t loc, const uint8_t *src, uint16_t n);
+
+    // write all dirty data to hal.storage
+    void flush(void);
+
+    // bytes passed to write_block()
+    uint32_t bytes_requested(void) const { return _bytes_requested; }
+
+    // bytes passed on to hal.storage
+    uint32_t bytes_written(void) const { return _bytes_written; }
+
+private:
+    static const uint8_t line_shift = 5;
+    static const uint8_t line_size = 1U<<line_shift;
+
+    struct cache_line {
+        uint16_t base;      // storage offset of data[0]
+        uint32_t dirty;     // one bit per byte of data, 0 if line is free
+        uint8_t data[line_size];
+    };
+
+    void init(void);
+    void io_timer(void);
+    void flush_locked(void);
+    void write_run(uint16_t loc, const uint8_t *src, uint8_t n);
+    struct cache_line *get_line(uint16_t base);
+
+    struct cache_line _lines[STORAGE_CACHE_LINES] {};
+    uint8_t _lines_used = 0;
+
+    AP_HAL::Semaphore *_sem = nullptr;
+    bool _initialised = false;
+
+    uint32_t _first_dirty_ms = 0;
+    uint32_t _last_write_ms = 0;
+
+    uint32_t _bytes_requested = 0;
+    uint32_t _bytes_written = 0;
+};
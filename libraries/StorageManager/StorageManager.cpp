@@ -83,6 +83,8 @@ const StorageManager::StorageArea StorageManager::layout_copter[STORAGE_NUM_AREA
 // setup default layout
 const StorageManager::StorageArea *StorageManager::layout = layout_default;
 
+StorageCache StorageManager::cache;
+
 /*
   erase all storage
  */
@@ -90,6 +92,7 @@ void StorageManager::erase(void)
 {
     uint8_t blk[16];
     memset(blk, 0, sizeof(blk));
+    flush();
     for (uint8_t i=0; i<STORAGE_NUM_AREAS; i++) {
         const StorageManager::StorageArea &area = StorageManager::layout[i];
         uint16_t length = area.length;
@@ -145,7 +148,7 @@ bool StorageAccess::read_block(void *data, uint16_t addr, size_t n) const
             // the data crosses a boundary between two areas
             count = length - addr;
         }
-        hal.storage->read_block(b, addr+offset, count);
+        StorageManager::cache.read_block(b, addr+offset, count);
         n -= count;
 
         if (n == 0) {
@@ -185,7 +188,7 @@ bool StorageAccess::write_block(uint16_t addr, const void *data, size_t n) const
             // the data crosses a boundary between two areas
             count = length - addr;
         }
-        hal.storage->write_block(addr+offset, b, count);
+        StorageManager::cache.write_block(addr+offset, b, count);
         n -= count;
 
         if (n == 0) {
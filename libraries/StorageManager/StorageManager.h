@@ -22,6 +22,8 @@
 
 #include <AP_HAL/AP_HAL.h>
 
+#include "StorageCache.h"
+
 /*
   use just one area per storage type for boards with 4k of
   storage. Use larger areas for other boards
@@ -56,6 +58,15 @@ public:
     // setup for copter layout of storage
     static void set_layout_copter(void) { layout = layout_copter; }
 
+    // write any cached data to storage. Call before arming, the HAL
+    // calls it before a reboot or shutdown
+    static void flush(void) { cache.flush(); }
+
+    // bytes written by StorageAccess users and bytes passed on to
+    // hal.storage after coalescing
+    static uint32_t bytes_requested(void) { return cache.bytes_requested(); }
+    static uint32_t bytes_written(void) { return cache.bytes_written(); }
+
 private:
     struct StorageArea {
         StorageType type;
@@ -67,6 +78,8 @@ private:
     static const StorageArea layout_copter[STORAGE_NUM_AREAS];
     static const StorageArea layout_default[STORAGE_NUM_AREAS];
     static const StorageArea *layout;
+
+    static StorageCache cache;
 };
 
 /*
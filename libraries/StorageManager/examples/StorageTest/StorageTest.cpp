@@ -93,7 +93,10 @@ void loop(void)
 
     count++;
     if (count % 10000 == 0) {
-        hal.console->printf("%u ops\n", count);
+        hal.console->printf("%u ops, %u bytes requested, %u bytes written\n",
+                            (unsigned)count,
+                            (unsigned)StorageManager::bytes_requested(),
+                            (unsigned)StorageManager::bytes_written());
     }
 }
 
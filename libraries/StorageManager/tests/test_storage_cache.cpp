@@ -0,0 +1,127 @@
+#include <AP_gtest.h>
+
+#include <StorageManager/StorageCache.h>
+
+const AP_HAL::HAL &hal = AP_HAL::get_HAL();
+
+/*
+  the cache is tested against hal.storage directly. The test data is
+  derived from what storage already holds, so every byte written is a
+  change. There is one cache for all the tests, as it registers itself
+  with the scheduler on the first write
+ */
+#define TEST_OFFSET 1024
+#define LINE_SIZE   32
+
+static StorageCache cache;
+
+static void changed_data(uint8_t *data, uint16_t loc, uint16_t n)
+{
+    hal.storage->read_block(data, loc, n);
+    for (uint16_t i = 0; i < n; i++) {
+        data[i] = ~data[i];
+    }
+}
+
+TEST(StorageCacheTest, ReadSeesUnflushedWrites)
+{
+    uint8_t old[LINE_SIZE], data[LINE_SIZE], buf[LINE_SIZE];
+    hal.storage->read_block(old, TEST_OFFSET, sizeof(old));
+    changed_data(data, TEST_OFFSET, sizeof(data));
+
+    const uint32_t requested = cache.bytes_requested();
+    const uint32_t written = cache.bytes_written();
+    cache.write_block(TEST_OFFSET + 4, &data[4], 20);
+
+    // reads through the cache see the new data, storage still has the old
+    cache.read_block(buf, TEST_OFFSET, sizeof(buf));
+    EXPECT_EQ(0, memcmp(buf, old, 4));
+    EXPECT_EQ(0, memcmp(&buf[4], &data[4], 20));
+    EXPECT_EQ(0, memcmp(&buf[24], &old[24], 8));
+    hal.storage->read_block(buf, TEST_OFFSET, sizeof(buf));
+    EXPECT_EQ(0, memcmp(buf, old, sizeof(buf)));
+
+    cache.flush();
+    hal.storage->read_block(buf, TEST_OFFSET, sizeof(buf));
+    EXPECT_EQ(0, memcmp(buf, old, 4));
+    EXPECT_EQ(0, memcmp(&buf[4], &data[4], 20));
+    EXPECT_EQ(0, memcmp(&buf[24], &old[24], 8));
+    EXPECT_EQ(20U, cache.bytes_requested() - requested);
+    EXPECT_EQ(20U, cache.bytes_written() - written);
+}
+
+TEST(StorageCacheTest, RepeatedWritesCoalesce)
+{
+    uint8_t data[2*LINE_SIZE], buf[2*LINE_SIZE];
+    changed_data(data, TEST_OFFSET, sizeof(data));
+
+    const uint32_t requested = cache.bytes_requested();
+    const uint32_t written = cache.bytes_written();
+    // each byte written on its own three times, as a parameter
+    // save of a few fields does, finishing with the new data
+    for (uint8_t pass = 0; pass < 3; pass++) {
+        for (uint16_t i = 0; i < sizeof(data); i++) {
+            const uint8_t b = data[i] + 2 - pass;
+            cache.write_block(TEST_OFFSET + i, &b, 1);
+        }
+    }
+    cache.flush();
+
+    hal.storage->read_block(buf, TEST_OFFSET, sizeof(buf));
+    EXPECT_EQ(0, memcmp(buf, data, sizeof(buf)));
+    EXPECT_EQ(3*sizeof(data), cache.bytes_requested() - requested);
+    EXPECT_EQ(sizeof(data), cache.bytes_written() - written);
+}
+
+TEST(StorageCacheTest, UnchangedBytesSkipped)
+{
+    uint8_t data[LINE_SIZE], buf[LINE_SIZE];
+    hal.storage->read_block(data, TEST_OFFSET, sizeof(data));
+
+    // writing back what storage holds costs nothing
+    uint32_t written = cache.bytes_written();
+    cache.write_block(TEST_OFFSET, data, sizeof(data));
+    cache.flush();
+    EXPECT_EQ(0U, cache.bytes_written() - written);
+
+    // only the span from the first to the last changed byte is written
+    data[10] = ~data[10];
+    data[20] = ~data[20];
+    written = cache.bytes_written();
+    cache.write_block(TEST_OFFSET, data, sizeof(data));
+    cache.flush();
+    EXPECT_EQ(11U, cache.bytes_written() - written);
+    hal.storage->read_block(buf, TEST_OFFSET, sizeof(buf));
+    EXPECT_EQ(0, memcmp(buf, data, sizeof(buf)));
+}
+
+TEST(StorageCacheTest, FullCacheWritesBack)
+{
+    const uint8_t nlines = STORAGE_CACHE_LINES + 4;
+    uint8_t data[nlines];
+    for (uint8_t i = 0; i < nlines; i++) {
+        changed_data(&data[i], TEST_OFFSET + i*LINE_SIZE, 1);
+    }
+
+    const uint32_t written = cache.bytes_written();
+    for (uint8_t i = 0; i < nlines; i++) {
+        cache.write_block(TEST_OFFSET + i*LINE_SIZE, &data[i], 1);
+    }
+    // running out of lines wrote some of the data out already
+    EXPECT_LT(0U, cache.bytes_written() - written);
+    for (uint8_t i = 0; i < nlines; i++) {
+        uint8_t b;
+        cache.read_block(&b, TEST_OFFSET + i*LINE_SIZE, 1);
+        EXPECT_EQ(data[i], b);
+    }
+
+    cache.flush();
+    EXPECT_EQ(nlines, cache.bytes_written() - written);
+    for (uint8_t i = 0; i < nlines; i++) {
+        uint8_t b;
+        hal.storage->read_block(&b, TEST_OFFSET + i*LINE_SIZE, 1);
+        EXPECT_EQ(data[i], b);
+    }
+}
+
+AP_GTEST_MAIN()